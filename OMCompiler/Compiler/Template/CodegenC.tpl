@@ -198,6 +198,9 @@ end translateModel;
     extern int <%symbolName(modelNamePrefixStr,"initializeDAEmodeData")%>(DATA *data, DAEMODE_DATA*);
     extern int <%symbolName(modelNamePrefixStr,"functionLocalKnownVars")%>(DATA* data, threadData_t* threadData);
     extern int <%symbolName(modelNamePrefixStr,"symbolicInlineSystem")%>(DATA* data, threadData_t* threadData);
+    extern const EQUATION_DEPENDENCIES <%symbolName(modelNamePrefixStr,"ODE")%>Dependencies;
+    extern const EQUATION_DEPENDENCIES <%symbolName(modelNamePrefixStr,"Alg")%>Dependencies;
+    extern const EQUATION_DEPENDENCIES <%symbolName(modelNamePrefixStr,"ZeroCrossings")%>Dependencies;
 
     #include "<%fileNamePrefix%>_literals.h"
 
@@ -902,6 +905,7 @@ template simulationFile_jac(SimCode simCode)
     <%simulationFileHeader(simCode.fileNamePrefix)%>
     #include "<%fileNamePrefix%>_12jac.h"
     #include "simulation/jacobian_util.h"
+    #include "simulation/jacobian_cache.h"
     #include "util/omc_file.h"
     <%functionAnalyticJacobians(jacobianMatrices, modelNamePrefix(simCode), simCode.fileNamePrefix)%>
 
@@ -1222,6 +1226,7 @@ template simulationFile(SimCode simCode, String guid, String isModelExchangeFMU)
     /* FIXME these defines are ugly and hard to read, why not use direct function pointers instead? */
     #define prefixedName_performSimulation <%symbolName(modelNamePrefixStr,"performSimulation")%>
     #define prefixedName_updateContinuousSystem <%symbolName(modelNamePrefixStr,"updateContinuousSystem")%>
+    #define prefixedName_simulationUpdate <%symbolName(modelNamePrefixStr,"simulationUpdate")%>
     #include <simulation/solver/perform_simulation.c.inc>
 
     #define prefixedName_performQSSSimulation <%symbolName(modelNamePrefixStr,"performQSSSimulation")%>
@@ -1264,6 +1269,7 @@ template simulationFile(SimCode simCode, String guid, String isModelExchangeFMU)
        <% if isModelExchangeFMU then "NULL" else '(int (*)(DATA *, threadData_t *, void *)) <%symbolName(modelNamePrefixStr,"performSimulation")%>'%>,    /* performSimulation */
        <% if isModelExchangeFMU then "NULL" else '(int (*)(DATA *, threadData_t *, void *)) <%symbolName(modelNamePrefixStr,"performQSSSimulation")%>'%>,    /* performQSSSimulation */
        <% if isModelExchangeFMU then "NULL" else '<%symbolName(modelNamePrefixStr,"updateContinuousSystem")%>'%>,    /* updateContinuousSystem */
+       <% if isModelExchangeFMU then "NULL" else '(int (*)(DATA *, threadData_t *, void *)) <%symbolName(modelNamePrefixStr,"simulationUpdate")%>'%>,    /* simulationUpdate */
        <%symbolName(modelNamePrefixStr,"callExternalObjectDestructors")%>,    /* callExternalObjectDestructors */
        <%if intEq(varInfo.numNonLinearSystems,0) then "NULL" else symbolName(modelNamePrefixStr,"initialNonLinearSystem")%>,    /* initialNonLinearSystem */
        <%if intEq(varInfo.numLinearSystems,0) then "NULL" else symbolName(modelNamePrefixStr,"initialLinearSystem")%>,    /* initialLinearSystem */
@@ -1339,7 +1345,10 @@ template simulationFile(SimCode simCode, String guid, String isModelExchangeFMU)
        <% if isSome(modelStructure) then match modelStructure case SOME(FMIMODELSTRUCTURE(continuousPartialDerivatives=SOME(__))) then symbolName(modelNamePrefixStr,"INDEX_JAC_FMIDER") else "-1" else "-1" %>,
        <% if isSome(modelStructure) then match modelStructure case SOME(FMIMODELSTRUCTURE(initialPartialDerivatives=SOME(__))) then symbolName(modelNamePrefixStr,"initialAnalyticJacobianFMIDERINIT") else "NULL" else "NULL" %>,
        <% if isSome(modelStructure) then match modelStructure case SOME(FMIMODELSTRUCTURE(initialPartialDerivatives=SOME(__))) then symbolName(modelNamePrefixStr,"functionJacFMIDERINIT_column") else "NULL" else "NULL" %>,
-       <% if isSome(modelStructure) then match modelStructure case SOME(FMIMODELSTRUCTURE(initialPartialDerivatives=SOME(__))) then symbolName(modelNamePrefixStr,"INDEX_JAC_FMIDERINIT") else "-1" else "-1" %>
+       <% if isSome(modelStructure) then match modelStructure case SOME(FMIMODELSTRUCTURE(initialPartialDerivatives=SOME(__))) then symbolName(modelNamePrefixStr,"INDEX_JAC_FMIDERINIT") else "-1" else "-1" %>,
+       &<%symbolName(modelNamePrefixStr,"ODE")%>Dependencies,
+       &<%symbolName(modelNamePrefixStr,"Alg")%>Dependencies,
+       &<%symbolName(modelNamePrefixStr,"ZeroCrossings")%>Dependencies
     <%\n%>
     };
 
@@ -4612,6 +4621,8 @@ template functionODE(list<list<SimEqSystem>> derivativEquations, Text method, Op
   <%tmp%>
   <%systems%>
 
+  <%equationDependencies(derivativEquations, "ODE", modelNamePrefix)%>
+
   int <%symbolName(modelNamePrefix,"functionODE")%>(DATA *data, threadData_t *threadData)
   {
     TRACE_PUSH
@@ -4647,6 +4658,9 @@ template functionAlgebraic(list<list<SimEqSystem>> algebraicEquations, String mo
 
   <<
   <%systems%>
+
+  <%equationDependencies(algebraicEquations, "Alg", modelNamePrefix)%>
+
   /* for continuous time variables */
   int <%symbolName(modelNamePrefix,"functionAlgebraics")%>(DATA *data, threadData_t *threadData)
   {
@@ -4888,6 +4902,8 @@ template functionZeroCrossing(list<ZeroCrossing> zeroCrossings, list<SimEqSystem
   /* forwarded equations */
   <%forwardEqs%>
 
+  <%equationDependencies({equationsForZeroCrossings}, "ZeroCrossings", modelNamePrefix)%>
+
   int <%symbolName(modelNamePrefix,"function_ZeroCrossingsEquations")%>(DATA *data, threadData_t *threadData)
   {
     TRACE_PUSH
@@ -5577,13 +5593,21 @@ match sparsepattern
     {
       TRACE_PUSH
       size_t count;
-
-      FILE* pFile = openSparsePatternFile(data, threadData, "<%fileName%>");
+      FILE* pFile;
 
       initAnalyticJacobian(jacobian, <%sizeCols%>, <%sizeRows%>, <%tmpvarsSize%>, <%constantEqns%>, jacobian->sparsePattern);
-      jacobian->sparsePattern = allocSparsePattern(<%sizeleadindex%>, <%sp_size_index%>, <%maxColor%>);
       jacobian->availability = <%availability%>;
 
+      /* take sparsity pattern from pattern cache if an earlier run stored it */
+      jacobian->sparsePattern = lookupSparsePatternCache(data, "Jac<%matrixname%>", <%sizeleadindex%>, <%sizeRows%>);
+      if (jacobian->sparsePattern) {
+        TRACE_POP
+        return 0;
+      }
+
+      pFile = openSparsePatternFile(data, threadData, "<%fileName%>");
+      jacobian->sparsePattern = allocSparsePattern(<%sizeleadindex%>, <%sp_size_index%>, <%maxColor%>);
+
       /* read lead index of compressed sparse column */
       count = omc_fread(jacobian->sparsePattern->leadindex, sizeof(unsigned int), <%sizeleadindex%>+1, pFile, FALSE);
       if (count != <%sizeleadindex%>+1) {
@@ -5600,6 +5624,7 @@ match sparsepattern
       <%colorString%>
 
       omc_fclose(pFile);
+      storeSparsePatternCache(data, "Jac<%matrixname%>", <%sizeleadindex%>, <%sizeRows%>, jacobian->sparsePattern);
 
       TRACE_POP
       return 0;
@@ -6112,6 +6137,56 @@ template equationForward_(SimEqSystem eq, Context context, String modelNamePrefi
   >>
 end equationForward_;
 
+template equationDependencyIndex(SimEqSystem eq)
+ "Index of the eqFunction called for eq, empty if no function is generated."
+::=
+  match eq
+  case SES_ALGORITHM(statements={}) then ""
+  case SES_LINEAR(alternativeTearing = SOME(__))
+  case SES_NONLINEAR(alternativeTearing = SOME(__)) then equationIndexAlternativeTearing(eq)
+  else equationIndex(eq)
+end equationDependencyIndex;
+
+template dependencyIndexes(list<Integer> indexes)
+::=
+  '<%listLength(indexes)%><%indexes |> i => ',<%i%>'%>'
+end dependencyIndexes;
+
+template equationDependencies(list<list<SimEqSystem>> eqs, String name, String modelNamePrefix)
+ "Generates the table of realVars read and written by every equation of
+  function<name>, used by simulation/solver/masked_eval.c to re-evaluate
+  only the equations affected by changed variables."
+::=
+  let arrays = (eqs |> eqlst => (eqlst |> eq =>
+    let ix = equationDependencyIndex(eq)
+    if ix then
+    <<
+    extern void <%symbolName(modelNamePrefix,"eqFunction")%>_<%ix%>(DATA* data, threadData_t *threadData);
+    static const int <%name%>Reads<%ix%>[] = {<%dependencyIndexes(simEqSystemRealReads(eq, getSimCode()))%>};
+    static const int <%name%>Writes<%ix%>[] = {<%dependencyIndexes(simEqSystemRealWrites(eq, getSimCode()))%>};
+    >>
+    ; separator="\n") ; separator="\n")
+  let functions = (eqs |> eqlst => (eqlst |> eq => let ix = equationDependencyIndex(eq) if ix then '<%symbolName(modelNamePrefix,"eqFunction")%>_<%ix%>' ; separator=", ") ; separator=", ")
+  let indexes = (eqs |> eqlst => (eqlst |> eq => equationDependencyIndex(eq) ; separator=", ") ; separator=", ")
+  let reads = (eqs |> eqlst => (eqlst |> eq => let ix = equationDependencyIndex(eq) if ix then '<%name%>Reads<%ix%>' ; separator=", ") ; separator=", ")
+  let writes = (eqs |> eqlst => (eqlst |> eq => let ix = equationDependencyIndex(eq) if ix then '<%name%>Writes<%ix%>' ; separator=", ") ; separator=", ")
+  if functions then
+  <<
+  /* dependencies of the function<%name%> equations: {n, realVars index_1, ..., index_n},
+   * nVariablesReal stands for time and -1 for unknown dependencies */
+  <%arrays%>
+  static void (* const <%name%>Equations[])(DATA*, threadData_t*) = {<%functions%>};
+  static const int <%name%>EquationIndexes[] = {<%indexes%>};
+  static const int * const <%name%>Reads[] = {<%reads%>};
+  static const int * const <%name%>Writes[] = {<%writes%>};
+  const EQUATION_DEPENDENCIES <%symbolName(modelNamePrefix,name)%>Dependencies = {sizeof(<%name%>EquationIndexes)/sizeof(int), <%name%>Equations, <%name%>EquationIndexes, <%name%>Reads, <%name%>Writes};
+  >>
+  else
+  <<
+  const EQUATION_DEPENDENCIES <%symbolName(modelNamePrefix,name)%>Dependencies = {0, NULL, NULL, NULL, NULL};
+  >>
+end equationDependencies;
+
 template equationNames_(SimEqSystem eq, Context context, String modelNamePrefixStr)
  "Generates an equation.
   This template should not be used for a SES_RESIDUAL.
@@ -1,35 +1,35 @@
-//#include <iostream>
-//#include <omp.h>
-//
-//#ifdef WIN32
-//#include <windows.h>
-//#endif
-//
-//#define THREAD_NUM 2
-//#define REPLICATIONS 10000
-//#define WARMUP 10000
-//
-//#define PACKAGE_SIZE_BIG 128
-//#define PACKAGE_SIZE_SMALL 1
-//
-//int itemCount = 0;
-//double items[PACKAGE_SIZE_BIG];
-//unsigned long long comTimes[REPLICATIONS];
-//
-//inline volatile long long RDTSC() {
-//   register long long TSC asm("eax");
-//   asm volatile (".byte 15, 49" : : : "eax", "edx");
-//   return TSC;
-//}
 #include "expat.h"
 #include <list>
 #include <string>
+#include <vector>
 #include <sstream>
 #include <stdio.h>
+#include <math.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
 #include <fstream>
+#if defined(__MINGW32__)
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HPCOM_HAVE_TSC
+#endif
 #include "cJSON.h"
 #include "util/omc_file.h"
 
+#define HPCOM_OP_CHAIN_LENGTH 1000000
+#define HPCOM_OP_ROUNDS 5
+
+#define HPCOM_PACKAGE_SIZE_SMALL 1
+#define HPCOM_PACKAGE_SIZE_BIG 128
+#define HPCOM_COMM_REPLICATIONS 2000
+#define HPCOM_COMM_ROUNDS 5
+#define HPCOM_COMM_MAX_PAIRS 32
+
 struct Equation {
   int id;
   unsigned long calcTimeCount;
@@ -40,180 +40,588 @@ struct Equation {
   }
 };
 
+/**
+ * Measured communication costs between two cores.
+ */
+struct CorePairCosts {
+  int cores[2];
+  int packages[2];
+  double latency;   //ticks to send one double
+  double perDouble; //ticks for every further double
+};
+
+/**
+ * Cost model of the target machine. All times are given in ticks, which are
+ * TSC cycles on x86 and nanoseconds elsewhere. Without a calibration file
+ * the values the schedulers have always used are taken.
+ */
+struct MachineProfile {
+  std::string fileName;
+  bool loaded;
+  const char *unit;
+  double ticksPerSecond; //0 if the profile was not measured
+  int cores;
+  bool pinned;
+  int opM, opN;          //y=m*x+n ticks for x operations
+  int comM, comN;        //y=m*x+n ticks to send x doubles to another core
+  double add, mul, div, trig, call;
+  std::vector<CorePairCosts> pairs;
+
+  MachineProfile() {
+    setDefaults("");
+  }
+
+  void setDefaults(const std::string &_fileName) {
+    fileName = _fileName;
+    loaded = true;
+    unit = "cycles";
+    ticksPerSecond = 0.0;
+    cores = 1;
+    pinned = false;
+    opM = 1;
+    opN = 24;
+    comM = 4;
+    comN = 70;
+    add = 12.0;
+    mul = 32.0;
+    div = 37.0;
+    trig = 236.0;
+    call = 375.0;
+    pairs.clear();
+  }
+};
+
+static inline unsigned long long readTicks()
+{
+#if defined(HPCOM_HAVE_TSC)
+  return __rdtsc();
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+}
+
+static double measureTicksPerSecond()
+{
+#if defined(HPCOM_HAVE_TSC)
+  struct timespec t1, t2;
+  unsigned long long ticks1, ticks2;
+  double elapsed;
+
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  ticks1 = readTicks();
+  do {
+    clock_gettime(CLOCK_MONOTONIC, &t2);
+    elapsed = (t2.tv_sec - t1.tv_sec) + 1e-9 * (t2.tv_nsec - t1.tv_nsec);
+  } while (elapsed < 0.05);
+  ticks2 = readTicks();
+  return (ticks2 - ticks1) / elapsed;
+#else
+  return 1e9;
+#endif
+}
+
+static int numberOfCores()
+{
+#if defined(__MINGW32__)
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return info.dwNumberOfProcessors;
+#else
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  return n > 0 ? (int) n : 1;
+#endif
+}
+
+/**
+ * The physical package (socket) of the given core or -1 if it is unknown.
+ */
+static int packageOfCore(int core)
+{
+#if defined(__linux__)
+  char path[128];
+  int package = -1;
+  FILE *fp;
+
+  snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", core);
+  fp = fopen(path, "r");
+  if (fp) {
+    if (1 != fscanf(fp, "%d", &package))
+      package = -1;
+    fclose(fp);
+  }
+  return package;
+#else
+  return -1;
+#endif
+}
+
+/**
+ * Binds the calling thread to the given core. Returns false if the platform does not support it.
+ */
+static bool pinThread(int core)
+{
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(core, &set);
+  return 0 == pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#elif defined(__MINGW32__)
+  return core < 64 && 0 != SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << core);
+#else
+  return false;
+#endif
+}
+
+/* Dependent chains of one operation; fp semantics keep the compiler from shortening them. */
+static double __attribute__((noinline)) opCallee(double x, double c)
+{
+  __asm__ volatile("");
+  return x + c;
+}
+static double (*volatile opCalleePtr)(double, double) = opCallee;
+static volatile double opSink;
+
+static double __attribute__((noinline)) opChainAdd(double x, double c, long n)
+{
+  for (long i = 0; i < n; i++)
+    x = x + c;
+  return x;
+}
+
+static double __attribute__((noinline)) opChainMul(double x, double c, long n)
+{
+  for (long i = 0; i < n; i++)
+    x = x * c;
+  return x;
+}
+
+static double __attribute__((noinline)) opChainDiv(double x, double c, long n)
+{
+  for (long i = 0; i < n; i++)
+    x = c / x;
+  return x;
+}
+
+static double __attribute__((noinline)) opChainTrig(double x, double c, long n)
+{
+  for (long i = 0; i < n; i++)
+    x = sin(x) + c;
+  return x;
+}
+
+static double __attribute__((noinline)) opChainCall(double x, double c, long n)
+{
+  double (*f)(double, double) = opCalleePtr;
+  for (long i = 0; i < n; i++)
+    x = f(x, c);
+  return x;
+}
+
+/**
+ * Ticks per operation of the given chain, the best of some rounds.
+ */
+static double measureOpChain(double (*chain)(double, double, long), double x, double c)
+{
+  unsigned long long best = ~0ULL;
+
+  opSink = chain(x, c, HPCOM_OP_CHAIN_LENGTH / 10); //warmup
+  for (int round = 0; round < HPCOM_OP_ROUNDS; round++) {
+    unsigned long long t1 = readTicks();
+    opSink = chain(x, c, HPCOM_OP_CHAIN_LENGTH);
+    unsigned long long t2 = readTicks();
+    if (t2 - t1 < best)
+      best = t2 - t1;
+  }
+  return (double) best / HPCOM_OP_CHAIN_LENGTH;
+}
+
+static void measureOperations(MachineProfile &profile)
+{
+  profile.add = measureOpChain(opChainAdd, 1.0, 1e-9);
+  profile.mul = measureOpChain(opChainMul, 1.0, 1.0000001);
+  profile.div = measureOpChain(opChainDiv, 1.5, 2.0);
+  //the trigonometric and call chains contain an addition as well
+  profile.trig = fmax(1.0, measureOpChain(opChainTrig, 0.5, 1.0) - profile.add);
+  profile.call = fmax(1.0, measureOpChain(opChainCall, 1.0, 1e-9) - profile.add);
+  profile.opM = 1;
+  profile.opN = (int) fmax(1.0, floor(0.5 * (profile.add + profile.mul) + 0.5));
+}
+
+/**
+ * Ping-pong between two threads: the sender writes a package of doubles and raises ping,
+ * the receiver reads the package and answers with pong. Flags and payload are on
+ * separate cache lines, so every round trip moves the lines between the two cores.
+ */
+struct CommChannel {
+  long ping __attribute__((aligned(64)));
+  long pong __attribute__((aligned(64)));
+  double items[HPCOM_PACKAGE_SIZE_BIG] __attribute__((aligned(64)));
+  int cores[2];
+  int packageSize;
+  bool pinned;
+  unsigned long long roundTrips; //best ticks for HPCOM_COMM_REPLICATIONS round trips
+  double sink;
+};
+
+static CommChannel commChannel;
+
+static inline void spinUntil(long *flag, long value)
+{
+  unsigned long spins = 0;
+  while (__atomic_load_n(flag, __ATOMIC_ACQUIRE) != value) {
+    //don't starve the other thread if both share a core
+    if (++spins % 65536 == 0)
+      sched_yield();
+  }
+}
+
+static void* commSender(void *data)
+{
+  CommChannel *channel = (CommChannel*) data;
+  unsigned long long best = ~0ULL;
+  long seq = 0;
+
+  if (!pinThread(channel->cores[0]))
+    channel->pinned = false;
+  //the first round is a warmup
+  for (int round = 0; round <= HPCOM_COMM_ROUNDS; round++) {
+    unsigned long long t1 = readTicks();
+    for (int i = 0; i < HPCOM_COMM_REPLICATIONS; i++) {
+      seq++;
+      for (int j = 0; j < channel->packageSize; j++)
+        channel->items[j] = 672364.8897 + seq + j;
+      __atomic_store_n(&channel->ping, seq, __ATOMIC_RELEASE);
+      spinUntil(&channel->pong, seq);
+    }
+    unsigned long long t2 = readTicks();
+    if (round > 0 && t2 - t1 < best)
+      best = t2 - t1;
+  }
+  channel->roundTrips = best;
+  return NULL;
+}
+
+static void* commReceiver(void *data)
+{
+  CommChannel *channel = (CommChannel*) data;
+  long n = (long) (HPCOM_COMM_ROUNDS + 1) * HPCOM_COMM_REPLICATIONS;
+  double sum = 0.0;
+
+  if (!pinThread(channel->cores[1]))
+    channel->pinned = false;
+  for (long seq = 1; seq <= n; seq++) {
+    spinUntil(&channel->ping, seq);
+    for (int j = 0; j < channel->packageSize; j++)
+      sum += channel->items[j];
+    __atomic_store_n(&channel->pong, seq, __ATOMIC_RELEASE);
+  }
+  channel->sink = sum;
+  return NULL;
+}
+
+/**
+ * Ticks of one round trip between the two cores with the given package size, 0 on failure.
+ */
+static double measureRoundTrip(int core1, int core2, int packageSize, bool &pinned)
+{
+  pthread_t sender, receiver;
+
+  commChannel.ping = 0;
+  commChannel.pong = 0;
+  commChannel.cores[0] = core1;
+  commChannel.cores[1] = core2;
+  commChannel.packageSize = packageSize;
+  commChannel.pinned = true;
+  commChannel.roundTrips = 0;
+
+  if (pthread_create(&receiver, NULL, commReceiver, &commChannel))
+    return 0.0;
+  if (pthread_create(&sender, NULL, commSender, &commChannel)) {
+    //release the receiver
+    for (long seq = 1; seq <= (long) (HPCOM_COMM_ROUNDS + 1) * HPCOM_COMM_REPLICATIONS; seq++)
+      __atomic_store_n(&commChannel.ping, seq, __ATOMIC_RELEASE);
+    pthread_join(receiver, NULL);
+    return 0.0;
+  }
+  pthread_join(sender, NULL);
+  pthread_join(receiver, NULL);
+  pinned = pinned && commChannel.pinned;
+  return (double) commChannel.roundTrips / HPCOM_COMM_REPLICATIONS;
+}
+
+/**
+ * Measures the communication between core 0 and up to HPCOM_COMM_MAX_PAIRS other cores,
+ * spread over all cores so that cores on other sockets are included. The schedulers
+ * do not know on which cores the tasks run, so they get the mean over all pairs.
+ */
+static void measureCommunication(MachineProfile &profile)
+{
+  int partners = profile.cores - 1;
+  int step = partners > HPCOM_COMM_MAX_PAIRS ? (partners + HPCOM_COMM_MAX_PAIRS - 1) / HPCOM_COMM_MAX_PAIRS : 1;
+  double sumLatency = 0.0, sumPerDouble = 0.0;
+  bool pinned = true;
+
+  profile.pairs.clear();
+  for (int core = profile.cores - 1; core > 0; core -= step) {
+    double small = measureRoundTrip(0, core, HPCOM_PACKAGE_SIZE_SMALL, pinned);
+    double big = measureRoundTrip(0, core, HPCOM_PACKAGE_SIZE_BIG, pinned);
+    CorePairCosts pair;
+
+    if (small <= 0.0 || big <= 0.0)
+      continue;
+    pair.cores[0] = 0;
+    pair.cores[1] = core;
+    pair.packages[0] = packageOfCore(0);
+    pair.packages[1] = packageOfCore(core);
+    pair.latency = 0.5 * small;
+    pair.perDouble = fmax(0.0, (big - small) / (HPCOM_PACKAGE_SIZE_BIG - HPCOM_PACKAGE_SIZE_SMALL));
+    profile.pairs.push_back(pair);
+    sumLatency += pair.latency;
+    sumPerDouble += pair.perDouble;
+  }
+  profile.pinned = pinned;
+
+  if (profile.pairs.empty())
+    return; //keep the default communication costs on single core machines
+  profile.comN = (int) fmax(1.0, floor(sumLatency / profile.pairs.size() + 0.5));
+  profile.comM = (int) floor(sumPerDouble / profile.pairs.size() + 0.5);
+}
+
+static void calibrateMachine(MachineProfile &profile)
+{
+#if defined(HPCOM_HAVE_TSC)
+  profile.unit = "cycles";
+#else
+  profile.unit = "ns";
+#endif
+  profile.ticksPerSecond = measureTicksPerSecond();
+  profile.cores = numberOfCores();
+  measureOperations(profile);
+  measureCommunication(profile);
+}
+
+/**
+ * Reads the whole file and parses it. The caller has to free the result with cJSON_Delete.
+ */
+static cJSON* readJsonFile(const std::string &filePath)
+{
+  FILE *fp;
+  long lSize;
+  char *buffer;
+  cJSON *root;
+
+  fp = omc_fopen(filePath.c_str(), "rb");
+  if (!fp)
+    return 0;
+
+  fseek(fp, 0L, SEEK_END);
+  lSize = ftell(fp);
+  rewind(fp);
+
+  /* allocate memory for entire content */
+  buffer = (char*) calloc(1, lSize + 1);
+  if (!buffer)
+  {
+    fclose(fp), fputs("memory alloc fails\n", stderr);
+    return 0;
+  }
+
+  /* copy the file into the buffer */
+  if (1 != omc_fread(buffer, lSize, 1, fp, 0))
+  {
+    fclose(fp), free(buffer), fputs("entire read fails\n", stderr);
+    return 0;
+  }
+  fclose(fp);
+
+  root = cJSON_Parse(buffer);
+  free(buffer);
+  if (root == 0)
+    fputs("no root object defined in json-file - maybe the json file is corrupt\n", stderr);
+  return root;
+}
+
+static double jsonNumber(cJSON *object, const char *name, double defaultValue)
+{
+  cJSON *item = object ? cJSON_GetObjectItem(object, name) : 0;
+  return (item && item->type == cJSON_Number) ? item->valuedouble : defaultValue;
+}
+
+static bool readMachineProfile(const std::string &filePath, MachineProfile &profile)
+{
+  cJSON *root = readJsonFile(filePath);
+  cJSON *ops, *comm, *pairs, *unit;
+
+  if (root == 0)
+    return false;
+  ops = cJSON_GetObjectItem(root, "requiredTimeForOp");
+  comm = cJSON_GetObjectItem(root, "requiredTimeForComm");
+  if (ops == 0 || comm == 0) {
+    fprintf(stderr, "%s is no hpcom calibration file\n", filePath.c_str());
+    cJSON_Delete(root);
+    return false;
+  }
+
+  unit = cJSON_GetObjectItem(root, "unit");
+  profile.unit = (unit && unit->type == cJSON_String && 0 == strcmp(unit->valuestring, "ns")) ? "ns" : "cycles";
+  profile.ticksPerSecond = jsonNumber(root, "ticksPerSecond", 0.0);
+  profile.cores = (int) jsonNumber(root, "cores", 1);
+  profile.pinned = 0 != cJSON_GetObjectItem(root, "pinned") && cJSON_GetObjectItem(root, "pinned")->type == cJSON_True;
+  profile.opM = (int) jsonNumber(ops, "m", profile.opM);
+  profile.opN = (int) jsonNumber(ops, "n", profile.opN);
+  profile.comM = (int) jsonNumber(comm, "m", profile.comM);
+  profile.comN = (int) jsonNumber(comm, "n", profile.comN);
+
+  ops = cJSON_GetObjectItem(root, "operations");
+  profile.add = jsonNumber(ops, "add", profile.add);
+  profile.mul = jsonNumber(ops, "mul", profile.mul);
+  profile.div = jsonNumber(ops, "div", profile.div);
+  profile.trig = jsonNumber(ops, "trig", profile.trig);
+  profile.call = jsonNumber(ops, "call", profile.call);
+
+  pairs = cJSON_GetObjectItem(root, "communication");
+  for (int i = 0; pairs && i < cJSON_GetArraySize(pairs); i++) {
+    cJSON *item = cJSON_GetArrayItem(pairs, i);
+    cJSON *cores = cJSON_GetObjectItem(item, "cores");
+    cJSON *packages = cJSON_GetObjectItem(item, "packages");
+    CorePairCosts pair;
+
+    if (cores == 0 || cJSON_GetArraySize(cores) != 2)
+      continue;
+    pair.cores[0] = cJSON_GetArrayItem(cores, 0)->valueint;
+    pair.cores[1] = cJSON_GetArrayItem(cores, 1)->valueint;
+    pair.packages[0] = (packages && cJSON_GetArraySize(packages) == 2) ? cJSON_GetArrayItem(packages, 0)->valueint : -1;
+    pair.packages[1] = (packages && cJSON_GetArraySize(packages) == 2) ? cJSON_GetArrayItem(packages, 1)->valueint : -1;
+    pair.latency = jsonNumber(item, "latency", 0.0);
+    pair.perDouble = jsonNumber(item, "perDouble", 0.0);
+    profile.pairs.push_back(pair);
+  }
+
+  cJSON_Delete(root);
+  return true;
+}
+
+static bool writeMachineProfile(const std::string &filePath, const MachineProfile &profile)
+{
+  cJSON *root = cJSON_CreateObject();
+  cJSON *ops = cJSON_CreateObject();
+  cJSON *opModel = cJSON_CreateObject();
+  cJSON *commModel = cJSON_CreateObject();
+  cJSON *pairs = cJSON_CreateArray();
+  char *text;
+  FILE *fp;
+  bool success = false;
+
+  cJSON_AddStringToObject(root, "format", "OpenModelica hpcom calibration");
+  cJSON_AddNumberToObject(root, "version", 1);
+  cJSON_AddStringToObject(root, "unit", profile.unit);
+  cJSON_AddNumberToObject(root, "ticksPerSecond", profile.ticksPerSecond);
+  cJSON_AddNumberToObject(root, "cores", profile.cores);
+  cJSON_AddItemToObject(root, "pinned", profile.pinned ? cJSON_CreateTrue() : cJSON_CreateFalse());
+
+  cJSON_AddNumberToObject(ops, "add", profile.add);
+  cJSON_AddNumberToObject(ops, "mul", profile.mul);
+  cJSON_AddNumberToObject(ops, "div", profile.div);
+  cJSON_AddNumberToObject(ops, "trig", profile.trig);
+  cJSON_AddNumberToObject(ops, "call", profile.call);
+  cJSON_AddItemToObject(root, "operations", ops);
+
+  cJSON_AddNumberToObject(opModel, "m", profile.opM);
+  cJSON_AddNumberToObject(opModel, "n", profile.opN);
+  cJSON_AddItemToObject(root, "requiredTimeForOp", opModel);
+  cJSON_AddNumberToObject(commModel, "m", profile.comM);
+  cJSON_AddNumberToObject(commModel, "n", profile.comN);
+  cJSON_AddItemToObject(root, "requiredTimeForComm", commModel);
+
+  for (size_t i = 0; i < profile.pairs.size(); i++) {
+    cJSON *item = cJSON_CreateObject();
+    cJSON_AddItemToObject(item, "cores", cJSON_CreateIntArray(profile.pairs[i].cores, 2));
+    cJSON_AddItemToObject(item, "packages", cJSON_CreateIntArray(profile.pairs[i].packages, 2));
+    cJSON_AddNumberToObject(item, "latency", profile.pairs[i].latency);
+    cJSON_AddNumberToObject(item, "perDouble", profile.pairs[i].perDouble);
+    cJSON_AddItemToArray(pairs, item);
+  }
+  cJSON_AddItemToObject(root, "communication", pairs);
+
+  text = cJSON_Print(root);
+  fp = omc_fopen(filePath.c_str(), "w");
+  if (fp) {
+    success = EOF != fputs(text, fp);
+    success = (0 == fclose(fp)) && success;
+  }
+  free(text);
+  cJSON_Delete(root);
+  return success;
+}
+
+/**
+ * The machine profile for the given calibration file. An empty file name selects the
+ * built-in costs. A file that does not exist is created by measuring the machine.
+ * The profile is cached, the costs of every component are computed with it.
+ */
+static const MachineProfile& machineProfile(const char *calibrationFile)
+{
+  static MachineProfile profile;
+  std::string fileName = calibrationFile ? calibrationFile : "";
+
+  if (profile.loaded && profile.fileName == fileName)
+    return profile;
+
+  profile.setDefaults(fileName);
+  if (fileName.empty())
+    return profile;
+
+  if (std::ifstream(fileName.c_str())) {
+    if (!readMachineProfile(fileName, profile)) {
+      fprintf(stderr, "Could not read the hpcom calibration %s, using the built-in costs\n", fileName.c_str());
+      profile.setDefaults(fileName);
+    }
+  } else {
+    calibrateMachine(profile);
+    if (!writeMachineProfile(fileName, profile))
+      fprintf(stderr, "Could not write the hpcom calibration %s\n", fileName.c_str());
+  }
+  return profile;
+}
+
 /**
  * Approximate the required time for operations (mult,add).
  * result: 2-parameters (m,n) y=mx+n
  */
-void* HpcOmBenchmarkExtImpl__requiredTimeForOp() {
-//  unsigned long long calcTimesMul[REPLICATIONS];
-//  unsigned long long calcTimesAdd[REPLICATIONS];
-//  unsigned int sumCalc = 0;
-//  void *res = mmc_mk_nil();
-//
-//  //warmup
-//  for (int i = 0; i < REPLICATIONS; i++)
-//  {
-//    double last = 1234.123 + i;
-//    last = last * 3.6424;
-//  }
-//
-//  //bench mul
-//  for (int i = 0; i < REPLICATIONS; i++)
-//  {
-//    double last = 1234.123 + i;
-//    unsigned long long t1 = RDTSC();
-//    double res = last * 3.6424;
-//    unsigned long long t2 = RDTSC();
-//    calcTimesMul[i] = (t2-t1);
-//  }
-//
-//  //bench add
-//  for (int i = 0; i < REPLICATIONS; i++)
-//  {
-//    double last = 1234.123 + i;
-//    unsigned long long t1 = RDTSC();
-//    double res = last + 3.6424;
-//    unsigned long long t2 = RDTSC();
-//    calcTimesAdd[i] = (t2-t1);
-//  }
-//
-//  for (int i = 0; i < REPLICATIONS; i++)
-//  {
-//    sumCalc += calcTimesAdd[i];
-//    sumCalc += calcTimesMul[i];
-//  }
-//
-//  int m = 1;
-//  res = mmc_mk_cons(mmc_mk_icon((sumCalc/(REPLICATIONS*2))),res); //push n
-//  res = mmc_mk_cons(mmc_mk_icon(m),res); //push m
+void* HpcOmBenchmarkExtImpl__requiredTimeForOp(const char *calibrationFile) {
+  const MachineProfile &profile = machineProfile(calibrationFile);
   void *res = mmc_mk_nil();
-  res = mmc_mk_cons(mmc_mk_icon(24), res); //push n
-  res = mmc_mk_cons(mmc_mk_icon(1), res); //push m
+  res = mmc_mk_cons(mmc_mk_icon(profile.opN), res); //push n
+  res = mmc_mk_cons(mmc_mk_icon(profile.opM), res); //push m
   return res;
 }
 
-//void sendMessage (int warmUp, int replications, int packageSize)
-//{
-//  for (int i = 0; i < warmUp; i++)
-//  {
-//    for(int j=0; j < packageSize; j++)
-//    {
-//      items[j] = 672364.8897+i+j;
-//    }
-//    itemCount++;
-//    while(itemCount > 0);
-//  }
-//
-//  for (int i = 0; i < replications; i++)
-//  {
-//    for(int j=0; j < packageSize; j++)
-//    {
-//      items[j] = 672364.8897+i+j;
-//    }
-//    itemCount++;
-//    unsigned long long t1 = RDTSC();
-//    while(itemCount > 0);
-//    unsigned long long t2 = RDTSC();
-//    comTimes[i] = (t2-t1);
-//  }
-//}
-//
-//void waitForMessage(int warmUp, int replications, int packageSize)pt..str()
-//{
-//  double last[packageSize];
-//
-//  for (int i = 0; i < warmUp; i++)
-//  {
-//    while(itemCount == 0);
-//    for(int j=0; j < packageSize; j++)
-//    {
-//      last[j] = items[j];
-//    }
-//    itemCount--;
-//  }
-//
-//  for (int i = 0; i < replications; i++)
-//  {
-//    while(itemCount == 0);
-//    for(int j=0; j < packageSize; j++)
-//    {
-//      last[j] = items[j];
-//    }
-//    itemCount--;
-//  }
-//}
+/**
+ * Approximate the required time of single operations.
+ * result: ticks for (add,mul,div,trig,call)
+ */
+void* HpcOmBenchmarkExtImpl__requiredTimeForOps(const char *calibrationFile) {
+  const MachineProfile &profile = machineProfile(calibrationFile);
+  void *res = mmc_mk_nil();
+  res = mmc_mk_cons(mmc_mk_icon((int) ceil(profile.call)), res);
+  res = mmc_mk_cons(mmc_mk_icon((int) ceil(profile.trig)), res);
+  res = mmc_mk_cons(mmc_mk_icon((int) ceil(profile.div)), res);
+  res = mmc_mk_cons(mmc_mk_icon((int) ceil(profile.mul)), res);
+  res = mmc_mk_cons(mmc_mk_icon((int) ceil(profile.add)), res);
+  return res;
+}
 
 /**
  * Approximate the required time to send doubles to another cpu.
  * result: 2-parameters (m,n) y=mx+n
  */
-void* HpcOmBenchmarkExtImpl__requiredTimeForComm() {
-//  void *res = mmc_mk_nil();
-//  unsigned int sumComSmall = 0;
-//  unsigned int sumComBig = 0;
-//
-//  omp_set_num_threads(THREAD_NUM);
-//  omp_set_dynamic(0);
-//
-//  //Benchmark for small package
-//  #pragma omp parallel for shared(items) shared(itemCount)
-//  for (int i=0; i < THREAD_NUM; i++)
-//  {
-//    if((i % 2) == 0)
-//    {
-//#ifdef WIN32
-//      DWORD_PTR mask = (1 << omp_get_thread_num());
-//      SetThreadAffinityMask( GetCurrentThread(), mask );
-//      SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL);
-//#endif
-//      sendMessage(WARMUP,REPLICATIONS, PACKAGE_SIZE_SMALL);
-//    }
-//    else
-//    {
-//#ifdef WIN32
-//      DWORD_PTR mask = (1 << omp_get_thread_num());
-//      SetThreadAffinityMask( GetCurrentThread(), mask );
-//      SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL);
-//#endif
-//      waitForMessage(WARMUP,REPLICATIONS, PACKAGE_SIZE_SMALL);
-//    }
-//  }
-//
-//  for (int i = 0; i < REPLICATIONS; i++)
-//    sumComSmall += comTimes[i];
-//
-//  //Benchmark for big package
-//  #pragma omp parallel for shared(items) shared(itemCount)
-//  for (int i=0; i < THREAD_NUM; i++)
-//  {
-//    if((i % 2) == 0)
-//    {
-//#ifdef WIN32
-//      DWORD_PTR mask = (1 << omp_get_thread_num());
-//      SetThreadAffinityMask( GetCurrentThread(), mask );
-//      SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL);
-//#endif
-//      sendMessage(WARMUP,REPLICATIONS, PACKAGE_SIZE_BIG);
-//    }
-//    else
-//    {
-//#ifdef WIN32
-//      DWORD_PTR mask = (1 << omp_get_thread_num());
-//      SetThreadAffinityMask( GetCurrentThread(), mask );
-//      SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL);
-//#endif
-//      waitForMessage(WARMUP,REPLICATIONS, PACKAGE_SIZE_BIG);
-//    }
-//  }
-//
-//  for (int i = 0; i < REPLICATIONS; i++)
-//    sumComBig += comTimes[i];
-//
-//  res = mmc_mk_cons(mmc_mk_icon(sumComSmall/(REPLICATIONS*2)),res); //push n
-//  res = mmc_mk_cons(mmc_mk_icon((sumComBig-sumComSmall)/((PACKAGE_SIZE_BIG-PACKAGE_SIZE_SMALL)*(REPLICATIONS*2))),res); //push m
+void* HpcOmBenchmarkExtImpl__requiredTimeForComm(const char *calibrationFile) {
+  const MachineProfile &profile = machineProfile(calibrationFile);
   void *res = mmc_mk_nil();
-  res = mmc_mk_cons(mmc_mk_icon(70), res); //push n
-  res = mmc_mk_cons(mmc_mk_icon(4), res); //push m
+  res = mmc_mk_cons(mmc_mk_icon(profile.comN), res); //push n
+  res = mmc_mk_cons(mmc_mk_icon(profile.comM), res); //push m
   return res;
 }
 
@@ -335,54 +743,34 @@ public:
   }
 };
 
-std::list<std::list<double> > ReadJsonBenchFileEquations(std::string filePath)
+/**
+ * Reads the profile blocks of a profiling json-file. The C runtime writes the times in
+ * seconds (such files contain a totalTime), they are converted to the ticks of the machine
+ * profile if it has been measured, so that they fit to the communication costs.
+ */
+std::list<std::list<double> > ReadJsonBenchFileEquations(std::string filePath, const char *calibrationFile)
 {
     std::list<std::list<double> > resultList = std::list<std::list<double> >();
 
-    FILE *fp;
-    long lSize;
-    char *buffer;
     int arraySize, i;
+    double timeScale = 1.0;
     cJSON *root;
     cJSON *profileBlocks;
 
-    fp = omc_fopen ( filePath.c_str() , "rb" );
-    if( !fp ) perror(filePath.c_str()),exit(1);
-
-    fseek( fp , 0L , SEEK_END);
-    lSize = ftell( fp );
-    rewind( fp );
-
-    /* allocate memory for entire content */
-    buffer = (char*)calloc( 1, lSize+1 );
-    if( !buffer )
-    {
-      fclose(fp),fputs("memory alloc fails\n",stderr);
-      return resultList;
-    }
-
-    /* copy the file into the buffer */
-    if( 1!=omc_fread( buffer , lSize, 1 , fp, 0) )
-    {
-      fclose(fp),free(buffer),fputs("entire read fails\n",stderr);
-      return resultList;
-    }
-    /* do your work here, buffer is a string contains the whole text */
-    root = cJSON_Parse(buffer);
-
+    root = readJsonFile(filePath);
     if(root == 0)
-    {
-      fclose(fp),free(buffer),fputs("no root object defined in json-file - maybe the json file is corrupt\n",stderr);
       return resultList;
-    }
 
     profileBlocks = cJSON_GetObjectItem(root,"profileBlocks");
     if(profileBlocks == 0)
     {
-      fclose(fp),free(buffer),fputs("no profile blocks defined in json-file\n",stderr);
+      cJSON_Delete(root),fputs("no profile blocks defined in json-file\n",stderr);
       return resultList;
     }
 
+    if(cJSON_GetObjectItem(root,"totalTime") != 0 && machineProfile(calibrationFile).ticksPerSecond > 0.0)
+      timeScale = machineProfile(calibrationFile).ticksPerSecond;
+
     arraySize = cJSON_GetArraySize(profileBlocks);
 
     for(i = 0; i < arraySize; i++)
@@ -398,13 +786,12 @@ std::list<std::list<double> > ReadJsonBenchFileEquations(std::string filePath)
       else
         tmpLst.push_back(idItem->valuedouble);
 
-      tmpLst.push_back(timeItem->valuedouble);
+      tmpLst.push_back(timeScale * timeItem->valuedouble);
       tmpLst.push_back(ncallItem->valuedouble);
       resultList.push_back(tmpLst);
     }
 
-    fclose(fp);
-    free(buffer);
+    cJSON_Delete(root);
 
     return resultList;
 }
@@ -442,7 +829,7 @@ void* HpcOmBenchmarkExtImpl__readCalcTimesFromXml(const char *filename)
   return res;
 }
 
-void* HpcOmBenchmarkExtImpl__readCalcTimesFromJson(const char *filename)
+void* HpcOmBenchmarkExtImpl__readCalcTimesFromJson(const char *filename, const char *calibrationFile)
 {
   void *res = mmc_mk_nil();
   std::string errorMsg = std::string("");
@@ -457,7 +844,7 @@ void* HpcOmBenchmarkExtImpl__readCalcTimesFromJson(const char *filename)
     return res;
   }
 
-  std::list<std::list<double> > retLst = ReadJsonBenchFileEquations(filename);
+  std::list<std::list<double> > retLst = ReadJsonBenchFileEquations(filename, calibrationFile);
 
   for (std::list<std::list<double> >::iterator it = retLst.begin();
       it != retLst.end(); it++) {
@@ -17,21 +17,30 @@
 #endif
 
 extern "C" {
-extern void* HpcOmBenchmarkExt_requiredTimeForOp()
+extern void* HpcOmBenchmarkExt_requiredTimeForOp(const char *calibrationFile)
 {
 #if defined(_MSC_VER)
   HPC_OM_VS();
 #else
-  return HpcOmBenchmarkExtImpl__requiredTimeForOp();
+  return HpcOmBenchmarkExtImpl__requiredTimeForOp(calibrationFile);
 #endif
 }
 
-extern void* HpcOmBenchmarkExt_requiredTimeForComm()
+extern void* HpcOmBenchmarkExt_requiredTimeForOps(const char *calibrationFile)
 {
 #if defined(_MSC_VER)
   HPC_OM_VS();
 #else
-  return HpcOmBenchmarkExtImpl__requiredTimeForComm();
+  return HpcOmBenchmarkExtImpl__requiredTimeForOps(calibrationFile);
+#endif
+}
+
+extern void* HpcOmBenchmarkExt_requiredTimeForComm(const char *calibrationFile)
+{
+#if defined(_MSC_VER)
+  HPC_OM_VS();
+#else
+  return HpcOmBenchmarkExtImpl__requiredTimeForComm(calibrationFile);
 #endif
 }
 
@@ -44,12 +53,12 @@ extern void* HpcOmBenchmarkExt_readCalcTimesFromXml(const char *filename)
 #endif
 }
 
-extern void* HpcOmBenchmarkExt_readCalcTimesFromJson(const char *filename)
+extern void* HpcOmBenchmarkExt_readCalcTimesFromJson(const char *filename, const char *calibrationFile)
 {
 #if defined(_MSC_VER)
   HPC_OM_VS();
 #else
-  return HpcOmBenchmarkExtImpl__readCalcTimesFromJson(filename);
+  return HpcOmBenchmarkExtImpl__readCalcTimesFromJson(filename, calibrationFile);
 #endif
 }
 }
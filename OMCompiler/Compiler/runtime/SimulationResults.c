@@ -34,7 +34,7 @@ typedef struct {
   time_t mtime;
   ModelicaMatReader matReader;
   FILE *pltReader;
-  struct csv_data *csvReader;
+  struct csv_reader *csvReader;
 } SimulationResult_Globals;
 
 static SimulationResult_Globals simresglob = {
@@ -47,7 +47,10 @@ static void SimulationResultsImpl__close(SimulationResult_Globals* simresglob)
   switch (simresglob->curFormat) {
   case MATLAB4: omc_free_matlab4_reader(&simresglob->matReader); break;
   case PLT: fclose(simresglob->pltReader); break;
-  case CSV: omc_free_csv_reader(simresglob->csvReader); simresglob->csvReader=NULL; break;
+  case CSV:
+    read_csv_close(simresglob->csvReader);
+    simresglob->csvReader=NULL;
+    break;
   default: break;
   }
   simresglob->curFormat = UNKNOWN_PLOT;
@@ -97,7 +100,8 @@ static PlotFormat SimulationResultsImpl__openFile(const char *filename, Simulati
     }
     break;
   case CSV:
-    simresglob->csvReader = read_csv(filename);
+    /* Only the header and the row offsets are read here; readDataset reads the columns on demand */
+    simresglob->csvReader = read_csv_open(filename);
     if (simresglob->csvReader==NULL) {
       msg[1] = filename;
       c_add_message(NULL,-1, ErrorType_scripting, ErrorLevel_error, gettext("Failed to open simulation result %s: %s"), msg, 2);
@@ -212,7 +216,7 @@ static int SimulationResultsImpl__readSimulationResultSize(const char *filename,
     return size;
   }
   case CSV: {
-    size = simresglob->csvReader ? simresglob->csvReader->numsteps : -1;
+    size = simresglob->csvReader ? read_csv_numsteps(simresglob->csvReader) : -1;
     msg[0] = filename;
     if (size == -1) c_add_message(NULL,-1, ErrorType_scripting, ErrorLevel_error, gettext("Failed to read readSimulationResultSize from file: %s\n"), msg, 1);
     return size;
@@ -261,10 +265,10 @@ static void* SimulationResultsImpl__readVars(const char *filename, int readParam
     return read_ptolemy_variables(filename /* Assume it is in OMC style */);
   }
   case CSV: {
-    if (simresglob->csvReader && simresglob->csvReader->variables) {
-      char **variables = simresglob->csvReader->variables;
-      int i;
-      for (i=simresglob->csvReader->numvars-1; i>=0; i--) {
+    if (simresglob->csvReader) {
+      int i, numvars;
+      char **variables = read_csv_names(simresglob->csvReader, &numvars);
+      for (i=numvars-1; i>=0; i--) {
         if (variables[i][0] != '\0') {
           res = mmc_mk_cons(makeOMCStyle(variables[i], omcStyle),res);
         }
@@ -359,10 +363,22 @@ static void* SimulationResultsImpl__readDataset(const char *filename, void *vars
     return read_ptolemy_dataset(filename,vars,dimsize);
   }
   case CSV: {
+    /* read all requested columns in one pass over the rows */
+    void *lst;
+    const char **names;
+    int n = 0;
+    for (lst = vars; MMC_NILHDR != MMC_GETHDR(lst); lst = MMC_CDR(lst)) {
+      n++;
+    }
+    names = (const char**) omc_alloc_interface.malloc(n*sizeof(const char*));
+    for (i = 0, lst = vars; MMC_NILHDR != MMC_GETHDR(lst); lst = MMC_CDR(lst)) {
+      names[i++] = MMC_STRINGDATA(MMC_CAR(lst));
+    }
+    read_csv_load(simresglob->csvReader, n, names);
     while (MMC_NILHDR != MMC_GETHDR(vars)) {
       var = MMC_STRINGDATA(MMC_CAR(vars));
       vars = MMC_CDR(vars);
-      vals = simresglob->csvReader ? read_csv_dataset(simresglob->csvReader,var) : NULL;
+      vals = read_csv_column(simresglob->csvReader,var);
       if (vals == NULL) {
         msg[0] = runningTestsuite ? SystemImpl__basename(filename) : filename;
         msg[1] = var;
@@ -40,6 +40,12 @@
 /* Size of the buffer for warnings and other messages */
 #define WARNINGBUFFSIZE 4096
 
+/* Set by SimulationResults_setCmpOptions: the size in MB above which files
+ * are compared in windows (negative for the default) and the number of
+ * threads comparing variables (0 for all processors) */
+static double cmpMemoryLimit = -1;
+static int cmpNumThreads = 0;
+
 typedef struct {
   double *data;
   unsigned int n;
@@ -146,6 +152,102 @@ static DataField getData(const char *varname,const char *filename, unsigned int
   return res;
 }
 
+/* Same as getData, but copies the column straight from the reader instead of
+ * building a MetaModelica list of boxed reals first. */
+static DataField getDataColumn(const char *varname,const char *filename, unsigned int size, int suggestReadAll, SimulationResult_Globals* srg, int runningTestsuite)
+{
+  DataField res;
+  const char *msg[2] = {"",""};
+  double *vals = NULL;
+  unsigned int i;
+  res.n = 0;
+  res.data = NULL;
+
+  if (UNKNOWN_PLOT == SimulationResultsImpl__openFile(filename,srg)) {
+    return res;
+  }
+  switch (srg->curFormat) {
+  case MATLAB4: {
+    ModelicaMatVariable_t *mat_var;
+    if (size == 0) {
+      size = srg->matReader.nrows;
+    } else if (srg->matReader.nrows != size) {
+      fprintf(stderr, "dimsize: %d, rows %d\n", size, srg->matReader.nrows);
+      c_add_message(NULL,-1, ErrorType_scripting, ErrorLevel_error, gettext("readDataset(...): Expected and actual dimension sizes do not match."), NULL, 0);
+      return res;
+    }
+    if (suggestReadAll && !srg->matReader.readAll) {
+      omc_matlab4_read_all_vals(&srg->matReader);
+    }
+    mat_var = omc_matlab4_find_var(&srg->matReader,varname);
+    if (mat_var == NULL) {
+      break;
+    }
+    if (size == 0) {
+      return res;
+    }
+    res.data = (double*) malloc(sizeof(double)*size);
+    res.n = size;
+    if (mat_var->isParam) {
+      double param = srg->matReader.params[abs(mat_var->index)-1];
+      for (i=0;i<size;i++) {
+        res.data[i] = (mat_var->index<0) ? -param : param;
+      }
+    } else if (NULL != (vals = omc_matlab4_read_vals(&srg->matReader,mat_var->index))) {
+      memcpy(res.data, vals, sizeof(double)*size);
+    } else {
+      free(res.data);
+      res.data = NULL;
+      res.n = 0;
+    }
+    return res;
+  }
+  case CSV:
+    vals = read_csv_column(srg->csvReader,varname);
+    if (vals == NULL) {
+      break;
+    }
+    if (size > 0) {
+      res.data = (double*) malloc(sizeof(double)*size);
+      res.n = size;
+      memcpy(res.data, vals, sizeof(double)*size);
+    }
+    return res;
+  default:
+    return getData(varname,filename,size,suggestReadAll,srg,runningTestsuite);
+  }
+  msg[0] = runningTestsuite ? SystemImpl__basename(filename) : filename;
+  msg[1] = varname;
+  c_add_message(NULL,-1, ErrorType_scripting, ErrorLevel_error, gettext("Could not read variable %s in file %s."), msg, 2);
+  return res;
+}
+
+/* Reads the columns of all compared variables of a CSV file in one pass
+ * over the rows; getDataColumn then only looks them up. */
+static void loadCsvColumns(char **cmpvars, unsigned int ncmpvars, const char *filename, SimulationResult_Globals* srg)
+{
+  const char **names;
+  char *name;
+  unsigned int i, j, k, len;
+
+  if (UNKNOWN_PLOT == SimulationResultsImpl__openFile(filename,srg) || srg->curFormat != CSV) {
+    return;
+  }
+  names = (const char**) omc_alloc_interface.malloc(sizeof(const char*)*ncmpvars);
+  for (i=0;i<ncmpvars;i++) {
+    len = strlen(cmpvars[i]);
+    name = (char*) omc_alloc_interface.malloc_atomic(len+1);
+    for (j=0,k=0;j<len;j++) {
+      if (cmpvars[i][j] != '\"') {
+        name[k++] = cmpvars[i][j];
+      }
+    }
+    name[k] = 0;
+    names[i] = name;
+  }
+  read_csv_load(srg->csvReader, ncmpvars, names);
+}
+
 /* see http://randomascii.wordpress.com/2012/02/25/comparing-floating-point-numbers-2012-edition/ */
 static char almostEqualRelativeAndAbs(double a, double b, double reltol, double abstol)
 {
@@ -214,127 +316,182 @@ static double deltaData(ErrorMethod errMethod, DataField *time, DataField *refti
 }
 
 
-static unsigned int cmpData(int isResultCmp, char* varname, DataField *time, DataField *reftime, DataField *data, DataField *refdata, double reltol, double abstol, DiffDataField *ddf, char **cmpdiffvars, unsigned int vardiffindx, int keepEqualResults, void **diffLst, const char *prefix)
+/* State of the comparison of one variable between two points, so that the
+ * files can also be walked through in windows (see SimulationResultsCmpStream.c) */
+typedef struct {
+  unsigned int j;     /* Current point in the reference */
+  double tr;          /* Time of the current point in the reference */
+  double average;     /* Allowed difference */
+  char isdifferent;
+} CmpDataState;
+
+/* The allowed difference; sumAbsRef is the sum of the absolute reference values */
+static double cmpDataTolerance(double sumAbsRef, unsigned int n, double reltol, double abstol)
+{
+  double average = sumAbsRef/((double)n);
+#ifdef DEBUGOUTPUT
+   fprintf(stderr, "average: %.15g\n",average);
+#endif
+  return reltol*fabs(average)+abstol;
+}
+
+static void cmpDataInit(CmpDataState *s, DataField *reftime, double average)
 {
-  unsigned int i,j,k,j_event;
-  double t,tr,d,dr,err,d_left,d_right,dr_left,dr_right,t_event;
+  s->j = 0;
+  s->tr = reftime->data[0];
+  s->average = average;
+  s->isdifferent = 0;
+}
+
+/* Compares point i of data to the reference; returns the next point to compare */
+static unsigned int cmpDataStep(CmpDataState *s, unsigned int i, char* varname, DataField *time, DataField *reftime, DataField *data, DataField *refdata, double reltol, DiffDataField *ddf, int isResultCmp, FILE *fout)
+{
+  unsigned int j = s->j,j_event;
+  double t,tr = s->tr,d,dr,err,d_left,d_right,dr_left,dr_right,t_event;
+  double average = s->average;
   char increased = 0;
   char interpolate = 0;
-  char isdifferent = 0;
   char refevent = 0;
-  double average=0;
-  FILE *fout = NULL;
-  char *fname = NULL;
-  if (!isResultCmp) {
-    fname = (char*) malloc(25 + strlen(prefix) + strlen(varname));
-    sprintf(fname, "%s.%s.csv", prefix, varname);
-    fout = omc_fopen(fname,"w");
-    if (fout) {
-      fprintf(fout, "time,reference,actual,err,relerr,threshold\n");
+  t = time->data[i];
+  d = data->data[i];
+  increased = 0;
+#ifdef DEBUGOUTPUT
+   fprintf(stderr, "i: %d t: %.15g   d:%.15g\n",i,t,d);
+#endif
+  while(tr < t){
+    if (j +1< reftime->n) {
+      j += 1;
+      tr = reftime->data[j];
+      increased = 1;
+      if (tr == t) {
+        break;
+      }
+#ifdef DEBUGOUTPUT
+       fprintf(stderr, "j: %d tr:%.15g\n",j,tr);
+#endif
     }
+    else
+      break;
   }
-  for (i=0;i<refdata->n;i++){
-    average += fabs(refdata->data[i]);
+  if (increased==1) {
+    if ( (fabs((t-tr)/tr) > reltol) || (fabs(t-tr) > fabs(t-reftime->data[j-1]))) {
+      j = j- 1;
+      tr = reftime->data[j];
+    }
   }
-  average = average/((double)refdata->n);
 #ifdef DEBUGOUTPUT
-   fprintf(stderr, "average: %.15g\n",average);
+  fprintf(stderr, "i: %d t: %.15g   d:%.15g  j: %d tr:%.15g\n",i,t,d,j,tr);
 #endif
-  average = reltol*fabs(average)+abstol;
-  j = 0;
-  tr = reftime->data[j];
-  dr = refdata->data[j];
+  /* events, in case of an event compare only the left and right values of the absolute event time range,
+  * this means ta_left = min(t_left,tr_left) and
+  * ta_right = max(t_right,ta_right) */
+  if(i+1<time->n) {
 #ifdef DEBUGOUTPUT
-   fprintf(stderr, "compare: %s\n",varname);
+     fprintf(stderr, "check event: %.15g  - %.15g = %.15g\n",t,time->data[i+1],fabs(t-time->data[i+1]));
 #endif
-  for (i=0;i<data->n;i++){
-    t = time->data[i];
-    d = data->data[i];
-    increased = 0;
+    /* an event */
+    if (almostEqualWithDefaultTolerance(t,time->data[i+1])) {
 #ifdef DEBUGOUTPUT
-     fprintf(stderr, "i: %d t: %.15g   d:%.15g\n",i,t,d);
+       fprintf(stderr, "event: %.15g  %d  %.15g\n",t,i,d);
 #endif
-    while(tr < t){
-      if (j +1< reftime->n) {
-        j += 1;
-        tr = reftime->data[j];
-        increased = 1;
-        if (tr == t) {
-          break;
-        }
+      /* left value */
+      d_left = d;
 #ifdef DEBUGOUTPUT
-         fprintf(stderr, "j: %d tr:%.15g\n",j,tr);
+       fprintf(stderr, "left value: %.15g  %d %.15g\n",t,i,d_left);
 #endif
+      /* right value */
+      if (i+1<data->n) {
+        while (almostEqualWithDefaultTolerance(t,time->data[i+1])) {
+          i +=1;
+          if (i+1>=data->n) break;
+        }
       }
-      else
-        break;
-    }
-    if (increased==1) {
-      if ( (fabs((t-tr)/tr) > reltol) || (fabs(t-tr) > fabs(t-reftime->data[j-1]))) {
-        j = j- 1;
-        tr = reftime->data[j];
+      t = time->data[i];
+      d_right = data->data[i];
+#ifdef DEBUGOUTPUT
+      fprintf(stderr, "right value: %.15g  %d %.15g\n",t,i,d_right);
+#endif
+      /* search event in reference forwards */
+      refevent = 0;
+      t_event = t + t*reltol*0.1;
+      /* do not exceed next time step */
+      if (i+1<=data->n) {
+        t_event = (t_event > time->data[i])?time->data[i]:t_event;
+      }else{
+        t_event = (t_event > time->data[i+1])?time->data[i+1]:t_event;
       }
-    }
+      j_event = j;
+      while(tr < t_event) {
+        if (j+1<reftime->n) {
+          if (almostEqualWithDefaultTolerance(tr,reftime->data[j+1])) {
+            dr_left = refdata->data[j];
 #ifdef DEBUGOUTPUT
-    fprintf(stderr, "i: %d t: %.15g   d:%.15g  j: %d tr:%.15g\n",i,t,d,j,tr);
+            fprintf(stderr, "ref left value: %.15g  %d %.15g\n",tr,j,dr_left);
 #endif
-    /* events, in case of an event compare only the left and right values of the absolute event time range,
-    * this means ta_left = min(t_left,tr_left) and
-    * ta_right = max(t_right,ta_right) */
-    if(i<time->n) {
+            refevent = 1;
+
+            do {
+              j +=1;
+              if (j+1>=reftime->n) break;
+            } while (almostEqualWithDefaultTolerance(tr,reftime->data[j+1]));
+          }
+        }
+        if (refevent == 0) {
+          j += 1;
+          if (j >= reftime->n)
+            break;
+          tr = reftime->data[j];
+        }
+        else {
+          tr = reftime->data[j];
+          break;
+        }
+      }
+      if (refevent==1) {
+        tr = reftime->data[j];
+        dr_right = refdata->data[j];
 #ifdef DEBUGOUTPUT
-       fprintf(stderr, "check event: %.15g  - %.15g = %.15g\n",t,time->data[i+1],fabs(t-time->data[i+1]));
+         fprintf(stderr, "ref right value: %.15g  %d %.15g\n",tr,j,dr_right);
 #endif
-      /* an event */
-      if (almostEqualWithDefaultTolerance(t,time->data[i+1])) {
+
+        err = fabs(d_left-dr_left);
 #ifdef DEBUGOUTPUT
-         fprintf(stderr, "event: %.15g  %d  %.15g\n",t,i,d);
+         fprintf(stderr, "delta:%.15g  reltol:%.15g\n",err,average);
 #endif
-        /* left value */
-        d_left = d;
+        if ( err < average){
+          err = fabs(d_right-dr_right);
 #ifdef DEBUGOUTPUT
-         fprintf(stderr, "left value: %.15g  %d %.15g\n",t,i,d_left);
+           fprintf(stderr, "delta:%.15g  reltol:%.15g\n",err,average);
 #endif
-        /* right value */
-        if (i+1<data->n) {
-          while (almostEqualWithDefaultTolerance(t,time->data[i+1])) {
-            i +=1;
-            if (i+1>=data->n) break;
+          if ( err < average ) {
+            goto next;
           }
         }
-        t = time->data[i];
-        d_right = data->data[i];
-#ifdef DEBUGOUTPUT
-        fprintf(stderr, "right value: %.15g  %d %.15g\n",t,i,d_right);
-#endif
-        /* search event in reference forwards */
+      }
+      else {
+        /* search event in reference backwards */
+        j = j_event;
+        tr = reftime->data[j];
         refevent = 0;
-        t_event = t + t*reltol*0.1;
-        /* do not exceed next time step */
-        if (i+1<=data->n) {
-          t_event = (t_event > time->data[i])?time->data[i]:t_event;
-        }else{
-          t_event = (t_event > time->data[i+1])?time->data[i+1]:t_event;
-        }
-        j_event = j;
-        while(tr < t_event) {
-          if (j+1<reftime->n) {
-            if (almostEqualWithDefaultTolerance(tr,reftime->data[j+1])) {
-              dr_left = refdata->data[j];
+        t_event = t - t*reltol*0.1;
+        while(tr > t_event) {
+          if (j-1>0) {
+            if (almostEqualWithDefaultTolerance(tr,reftime->data[j-1])) {
+              dr_right = refdata->data[j];
 #ifdef DEBUGOUTPUT
-              fprintf(stderr, "ref left value: %.15g  %d %.15g\n",tr,j,dr_left);
+              fprintf(stderr, "ref right value: %.15g  %d %.15g\n",tr,j,dr_right);
 #endif
               refevent = 1;
 
               do {
-                j +=1;
-                if (j+1>=reftime->n) break;
-              } while (almostEqualWithDefaultTolerance(tr,reftime->data[j+1]));
+                j -=1;
+                if (j-1<=0) break;
+              } while (almostEqualWithDefaultTolerance(tr,reftime->data[j-1]));
             }
           }
           if (refevent == 0) {
-            j += 1;
-            if (j >= reftime->n)
+            j -= 1;
+            if (j == 0)
               break;
             tr = reftime->data[j];
           }
@@ -345,223 +502,204 @@ static unsigned int cmpData(int isResultCmp, char* varname, DataField *time, Dat
         }
         if (refevent==1) {
           tr = reftime->data[j];
-          dr_right = refdata->data[j];
+          dr_left = refdata->data[j];
 #ifdef DEBUGOUTPUT
-           fprintf(stderr, "ref right value: %.15g  %d %.15g\n",tr,j,dr_right);
+          fprintf(stderr, "ref left value: %.15g  %d %.15g\n",tr,j,dr_left);
 #endif
-
           err = fabs(d_left-dr_left);
 #ifdef DEBUGOUTPUT
-           fprintf(stderr, "delta:%.15g  reltol:%.15g\n",err,average);
+          fprintf(stderr, "delta:%.15g  reltol:%.15g\n",err,average);
 #endif
           if ( err < average){
             err = fabs(d_right-dr_right);
-#ifdef DEBUGOUTPUT
-             fprintf(stderr, "delta:%.15g  reltol:%.15g\n",err,average);
-#endif
-            if ( err < average ) {
-              continue;
-            }
-          }
-        }
-        else {
-          /* search event in reference backwards */
-          j = j_event;
-          tr = reftime->data[j];
-          refevent = 0;
-          t_event = t - t*reltol*0.1;
-          while(tr > t_event) {
-            if (j-1>0) {
-              if (almostEqualWithDefaultTolerance(tr,reftime->data[j-1])) {
-                dr_right = refdata->data[j];
-#ifdef DEBUGOUTPUT
-                fprintf(stderr, "ref right value: %.15g  %d %.15g\n",tr,j,dr_right);
-#endif
-                refevent = 1;
-
-                do {
-                  j -=1;
-                  if (j-1<=0) break;
-                } while (almostEqualWithDefaultTolerance(tr,reftime->data[j-1]));
-              }
-            }
-            if (refevent == 0) {
-              j -= 1;
-              if (j == 0)
-                break;
-              tr = reftime->data[j];
-            }
-            else {
-              tr = reftime->data[j];
-              break;
-            }
-          }
-          if (refevent==1) {
-            tr = reftime->data[j];
-            dr_left = refdata->data[j];
-#ifdef DEBUGOUTPUT
-            fprintf(stderr, "ref left value: %.15g  %d %.15g\n",tr,j,dr_left);
-#endif
-            err = fabs(d_left-dr_left);
 #ifdef DEBUGOUTPUT
             fprintf(stderr, "delta:%.15g  reltol:%.15g\n",err,average);
 #endif
             if ( err < average){
-              err = fabs(d_right-dr_right);
-#ifdef DEBUGOUTPUT
-              fprintf(stderr, "delta:%.15g  reltol:%.15g\n",err,average);
-#endif
-              if ( err < average){
-                j = j_event;
-                tr = reftime->data[j];
-                continue;
-              }
+              j = j_event;
+              tr = reftime->data[j];
+              goto next;
             }
           }
-          j = j_event;
-          tr = reftime->data[j];
         }
+        j = j_event;
+        tr = reftime->data[j];
       }
     }
+  }
 
-    interpolate = 0;
+  interpolate = 0;
 #ifdef DEBUGOUTPUT
-     fprintf(stderr, "interpolate? %d %.15g:%.15g  %.15g:%.15g\n",i,t,tr,fabs((t-tr)/tr),abstol);
+   fprintf(stderr, "interpolate? %d %.15g:%.15g  %.15g:%.15g\n",i,t,tr,fabs((t-tr)/tr),average);
 #endif
-    if (fabs(t-tr) > 0.00001) {
-      interpolate = 1;
-    }
+  if (fabs(t-tr) > 0.00001) {
+    interpolate = 1;
+  }
 
-    dr = refdata->data[j];
-    if (interpolate==1){
-#ifdef DEBUGOUTPUT
-      fprintf(stderr, "interpolate %.15g:%.15g  %.15g:%.15g %d",t,d,tr,dr,j);
-#endif
-      unsigned int jj = j;
-      /* look for interpolation partner */
-      if (tr > t) {
-        if (j-1 > 0) {
-          jj = j-1;
-          increased = 0;
-          if (reftime->data[jj] == tr){
-            increased = 1;
-            do {
-              jj -= 1;
-              if (jj<=0) break;
-            } while (reftime->data[jj] == tr);
-          }
-        }
+  dr = refdata->data[j];
+  if (interpolate==1){
 #ifdef DEBUGOUTPUT
-        fprintf(stderr, "-> %d %.15g %.15g\n",jj,reftime->data[jj],refdata->data[jj]);
+    fprintf(stderr, "interpolate %.15g:%.15g  %.15g:%.15g %d",t,d,tr,dr,j);
 #endif
-        if (reftime->data[jj] != tr){
-          dr = refdata->data[jj] + ((dr-refdata->data[jj])/(tr-reftime->data[jj]))*(t-reftime->data[jj]);
+    unsigned int jj = j;
+    /* look for interpolation partner */
+    if (tr > t) {
+      if (j-1 > 0) {
+        jj = j-1;
+        increased = 0;
+        if (reftime->data[jj] == tr){
+          increased = 1;
+          do {
+            jj -= 1;
+            if (jj<=0) break;
+          } while (reftime->data[jj] == tr);
         }
+      }
 #ifdef DEBUGOUTPUT
-        fprintf(stderr, "-> dr:%.15g\n",dr);
+      fprintf(stderr, "-> %d %.15g %.15g\n",jj,reftime->data[jj],refdata->data[jj]);
 #endif
+      if (reftime->data[jj] != tr){
+        dr = refdata->data[jj] + ((dr-refdata->data[jj])/(tr-reftime->data[jj]))*(t-reftime->data[jj]);
       }
-      else {
-        if (j+1<reftime->n) {
-          jj = j+1;
-          increased = 0;
-          if (reftime->data[jj] == tr){
-            increased = 1;
-            do {
-              jj += 1;
-              if (jj>=reftime->n) break;
-            } while (reftime->data[jj] == tr);
-          }
-        }
 #ifdef DEBUGOUTPUT
-        fprintf(stderr, "-> %d %.15g %.15g\n",jj,reftime->data[jj],tr);
+      fprintf(stderr, "-> dr:%.15g\n",dr);
 #endif
-        if (reftime->data[jj] != tr){
-          dr = dr + ((refdata->data[jj] - dr)/(reftime->data[jj] - tr))*(t-tr);
+    }
+    else {
+      if (j+1<reftime->n) {
+        jj = j+1;
+        increased = 0;
+        if (reftime->data[jj] == tr){
+          increased = 1;
+          do {
+            jj += 1;
+            if (jj>=reftime->n) break;
+          } while (reftime->data[jj] == tr);
         }
+      }
 #ifdef DEBUGOUTPUT
-        fprintf(stderr, "-> dr:%.15g\n",dr);
+      fprintf(stderr, "-> %d %.15g %.15g\n",jj,reftime->data[jj],tr);
 #endif
+      if (reftime->data[jj] != tr){
+        dr = dr + ((refdata->data[jj] - dr)/(reftime->data[jj] - tr))*(t-tr);
       }
+#ifdef DEBUGOUTPUT
+      fprintf(stderr, "-> dr:%.15g\n",dr);
+#endif
     }
+  }
 #ifdef DEBUGOUTPUT
-    fprintf(stderr, "j: %d tr: %.15g  dr:%.15g  t:%.15g  d:%.15g\n",j,tr,dr,t,d);
+  fprintf(stderr, "j: %d tr: %.15g  dr:%.15g  t:%.15g  d:%.15g\n",j,tr,dr,t,d);
 #endif
-    err = fabs(d-dr);
+  err = fabs(d-dr);
 #ifdef DEBUGOUTPUT
-    fprintf(stderr, "delta:%.15g  reltol:%.15g\n",err,average);
+  fprintf(stderr, "delta:%.15g  reltol:%.15g\n",err,average);
 #endif
-    if (fout) {
-      fprintf(fout, "%.15g,%.15g,%.15g,%.15g,%.15g,%.15g\n",tr,dr,d,err,almostEqualWithDefaultTolerance(d,0) ? err/average : fabs(err/d),average);
-    }
-    if ( err > average){
-      if (j+1<reftime->n) {
-        if (reftime->data[j+1] == tr) {
-          dr = refdata->data[j+1];
-          err = fabs(d-dr);
-        }
+  if (fout) {
+    fprintf(fout, "%.15g,%.15g,%.15g,%.15g,%.15g,%.15g\n",tr,dr,d,err,almostEqualWithDefaultTolerance(d,0) ? err/average : fabs(err/d),average);
+  }
+  if ( err > average){
+    if (j+1<reftime->n) {
+      if (reftime->data[j+1] == tr) {
+        dr = refdata->data[j+1];
+        err = fabs(d-dr);
       }
+    }
 
-      if (err < average){
-        continue;
-      }
+    if (err < average){
+      goto next;
+    }
 
-      isdifferent = 1;
-      if (isResultCmp) { /* If we produce the full diff, this data has already been output */
-        if (ddf->n >= ddf->n_max) {
-          DiffData *newData;
-          ddf->n_max = ddf->n_max ? ddf->n_max*2 : 1024;
-          newData = (DiffData*) realloc(ddf->data, sizeof(DiffData)*(ddf->n_max));
-          if (!newData) continue; /* realloc failed... pretty bad, but let's continue */
-          ddf->data = newData;
-        }
-        ddf->data[ddf->n].name = varname;
-        ddf->data[ddf->n].data = d;
-        ddf->data[ddf->n].dataref = dr;
-        ddf->data[ddf->n].time = t;
-        ddf->data[ddf->n].timeref = tr;
-        ddf->data[ddf->n].interpolate = interpolate?'1':'0';
-        ddf->n +=1;
+    s->isdifferent = 1;
+    if (isResultCmp) { /* If we produce the full diff, this data has already been output */
+      if (ddf->n >= ddf->n_max) {
+        DiffData *newData;
+        ddf->n_max = ddf->n_max ? ddf->n_max*2 : 1024;
+        newData = (DiffData*) realloc(ddf->data, sizeof(DiffData)*(ddf->n_max));
+        if (!newData) goto next; /* realloc failed... pretty bad, but let's continue */
+        ddf->data = newData;
       }
+      ddf->data[ddf->n].name = varname;
+      ddf->data[ddf->n].data = d;
+      ddf->data[ddf->n].dataref = dr;
+      ddf->data[ddf->n].time = t;
+      ddf->data[ddf->n].timeref = tr;
+      ddf->data[ddf->n].interpolate = interpolate?'1':'0';
+      ddf->n +=1;
     }
   }
-  if (isdifferent) {
-    cmpdiffvars[vardiffindx] = varname;
-    vardiffindx++;
-    if (!isResultCmp) {
-      *diffLst = mmc_mk_cons(mmc_mk_scon(varname),*diffLst);
+next:
+  s->j = j;
+  s->tr = tr;
+  return i+1;
+}
+
+/* Returns 1 if the variable is different; the differing points are appended to ddf */
+static int cmpData(int isResultCmp, char* varname, DataField *time, DataField *reftime, DataField *data, DataField *refdata, double reltol, double abstol, DiffDataField *ddf, int keepEqualResults, const char *prefix)
+{
+  unsigned int i;
+  double sumAbsRef=0;
+  CmpDataState state;
+  FILE *fout = NULL;
+  char *fname = NULL;
+  if (!isResultCmp) {
+    fname = (char*) malloc(25 + strlen(prefix) + strlen(varname));
+    sprintf(fname, "%s.%s.csv", prefix, varname);
+    fout = omc_fopen(fname,"w");
+    if (fout) {
+      fprintf(fout, "time,reference,actual,err,relerr,threshold\n");
     }
   }
+  for (i=0;i<refdata->n;i++){
+    sumAbsRef += fabs(refdata->data[i]);
+  }
+  cmpDataInit(&state, reftime, cmpDataTolerance(sumAbsRef, refdata->n, reltol, abstol));
+#ifdef DEBUGOUTPUT
+   fprintf(stderr, "compare: %s\n",varname);
+#endif
+  for (i=0;i<data->n;) {
+    i = cmpDataStep(&state, i, varname, time, reftime, data, refdata, reltol, ddf, isResultCmp, fout);
+  }
   if (fout) {
     fclose(fout);
   }
-  if (!isdifferent && 0==keepEqualResults && 0==isResultCmp) {
+  if (!state.isdifferent && 0==keepEqualResults && 0==isResultCmp) {
     SystemImpl__removeFile(fname);
   }
   if (fname) {
     free(fname);
   }
-  return vardiffindx;
+  return state.isdifferent;
 }
 
-static int writeLogFile(const char *filename,DiffDataField *ddf,const char *f,const char *reff,double reltol,double abstol)
+static void writeLogFileHeader(FILE *fout,const char *f,const char *reff,double reltol,double abstol)
 {
-  FILE* fout;
-  unsigned int i;
-  /* fprintf(stderr, "writeLogFile: %s\n",filename); */
-  fout = omc_fopen(filename, "w");
-  if (!fout)
-    return -1;
-
   fprintf(fout, "\"Generated by OpenModelica\";;;;;\n");
   fprintf(fout, "\"Compared Files\";;;\"absolute tolerance\";%.15g;relative tolerance;%.15g\n",abstol,reltol);
   fprintf(fout, "\"%s\";;;;;;\n",f);
   fprintf(fout, "\"%s\";;;;;;\n",reff);
   fprintf(fout, "\"Name\";\"Time\";\"DataPoint\";\"RefTime\";\"RefDataPoint\";\"absolute error\";\"relative error\";interpolate;\n");
+}
+
+static void writeLogFileData(FILE *fout,DiffDataField *ddf)
+{
+  unsigned int i;
   for (i=0;i<ddf->n;i++){
     fprintf(fout, "%s;%.15g;%.15g;%.15g;%.15g;%.15g;%.15g;%c;\n",ddf->data[i].name,ddf->data[i].time,ddf->data[i].data,ddf->data[i].timeref,ddf->data[i].dataref,
       fabs(ddf->data[i].data-ddf->data[i].dataref),fabs((ddf->data[i].data-ddf->data[i].dataref)/ddf->data[i].dataref),ddf->data[i].interpolate);
   }
+}
+
+static int writeLogFile(const char *filename,DiffDataField *ddf,const char *f,const char *reff,double reltol,double abstol)
+{
+  FILE* fout;
+  /* fprintf(stderr, "writeLogFile: %s\n",filename); */
+  fout = omc_fopen(filename, "w");
+  if (!fout)
+    return -1;
+
+  writeLogFileHeader(fout,f,reff,reltol,abstol);
+  writeLogFileData(fout,ddf);
   fclose(fout);
   /* fprintf(stderr, "writeLogFile: %s finished\n",filename); */
   return 0;
@@ -583,6 +721,104 @@ static const char* getTimeVarName(void *vars) {
 
 #include "SimulationResultsCmpTubes.c"
 
+extern int System_numProcessors(void);
+
+static inline unsigned int intMin(unsigned int a, unsigned int b)
+{
+  return a<b ? a : b;
+}
+
+/* One variable to compare. Loaded by the calling thread, compared by one of
+ * the workers and merged by the calling thread again. */
+typedef struct {
+  char *var;
+  DataField data, dataref;
+  DiffDataField ddf;  /* The differences of this variable only */
+  int isdifferent;
+  char *html;
+} CmpJob;
+
+typedef struct {
+  pthread_mutex_t mutex;
+  unsigned int current;
+  unsigned int size;
+  CmpJob *jobs;
+  DataField *time, *timeref;
+  CalibrationMap *actualMap;
+  int isResultCmp, isHtml, keepEqualResults;
+  double reltol, abstol, rangeDelta, reltolDiffMaxMin;
+  const char *prefix;
+} CmpWorkerArgs;
+
+static void freeCmpJob(CmpJob *job)
+{
+  if (job->data.data) free(job->data.data);
+  if (job->dataref.data) free(job->dataref.data);
+  if (job->ddf.data) free(job->ddf.data);
+  job->data.data = NULL;
+  job->dataref.data = NULL;
+  job->ddf.data = NULL;
+}
+
+static void appendDiffDataField(DiffDataField *ddf, DiffDataField *other)
+{
+  if (other->n == 0) {
+    return;
+  }
+  if (ddf->n + other->n > ddf->n_max) {
+    DiffData *newData;
+    unsigned int n_max = ddf->n_max ? ddf->n_max : 1024;
+    while (n_max < ddf->n + other->n) {
+      n_max *= 2;
+    }
+    newData = (DiffData*) realloc(ddf->data, sizeof(DiffData)*n_max);
+    if (!newData) return; /* realloc failed... pretty bad, but let's continue */
+    ddf->data = newData;
+    ddf->n_max = n_max;
+  }
+  memcpy(ddf->data + ddf->n, other->data, sizeof(DiffData)*other->n);
+  ddf->n += other->n;
+}
+
+static void* cmpWorkerThread(void *argVoid)
+{
+  CmpWorkerArgs *arg = (CmpWorkerArgs*) argVoid;
+  /* The tube calculation moves event times of the reference time line, so
+   * every worker compares against its own copy of it */
+  int copyRefTime = (arg->isHtml || !arg->isResultCmp) && 0 != arg->rangeDelta;
+  DataField timeref = *arg->timeref;
+  if (copyRefTime) {
+    timeref.data = (double*) malloc(sizeof(double)*timeref.n);
+  }
+  while (1) {
+    unsigned int i;
+    CmpJob *job;
+    pthread_mutex_lock(&arg->mutex);
+    i = arg->current;
+    arg->current+=1;
+    pthread_mutex_unlock(&arg->mutex);
+    if (i >= arg->size) break;
+    job = &arg->jobs[i];
+    if (!job->data.data) continue; /* Failed to load */
+    if (copyRefTime) {
+      memcpy(timeref.data, arg->timeref->data, sizeof(double)*timeref.n);
+    }
+    if (arg->isHtml) {
+      job->isdifferent = cmpDataTubes(arg->isResultCmp,job->var,arg->time,&timeref,&job->data,&job->dataref,arg->reltol,arg->rangeDelta,arg->reltolDiffMaxMin,arg->actualMap,arg->keepEqualResults,arg->prefix,1,&job->html);
+    } else if (arg->isResultCmp) {
+      job->isdifferent = cmpData(arg->isResultCmp,job->var,arg->time,&timeref,&job->data,&job->dataref,arg->reltol,arg->abstol,&job->ddf,arg->keepEqualResults,arg->prefix);
+    } else {
+      job->isdifferent = cmpDataTubes(arg->isResultCmp,job->var,arg->time,&timeref,&job->data,&job->dataref,arg->reltol,arg->rangeDelta,arg->reltolDiffMaxMin,arg->actualMap,arg->keepEqualResults,arg->prefix,0,0);
+    }
+  }
+  if (copyRefTime) {
+    free(timeref.data);
+  }
+  return NULL;
+}
+
+#include "SimulationResultsCmpStream.c"
+
 /* Common, huge function, for both result comparison and result diff */
 void* SimulationResultsCmp_compareResults(int isResultCmp, int runningTestsuite, const char *filename, const char *reffilename, const char *resultfilename, double reltol, double abstol, double reltolDiffMaxMin, double rangeDelta, void *vars, int keepEqualResults, int *success, int isHtml, char **htmlOut)
 {
@@ -593,18 +829,28 @@ void* SimulationResultsCmp_compareResults(int isResultCmp, int runningTestsuite,
   unsigned int ngetfailedvars = 0;
   void *allvars,*allvarsref,*res;
   unsigned int i,size,size_ref,len,j,k;
-  char *var,*var1,*var2;
-  DataField time,timeref,data,dataref;
+  char *var,*var1;
+  DataField time,timeref;
   DiffDataField ddf;
   const char *msg[2] = {"",""};
   const char *timeVarName, *timeVarNameRef;
   int suggestReadAll=0;
+  CalibrationMap *actualMap = NULL;
+  CmpWorkerArgs args;
+  CmpJob *jobs;
+  pthread_t *th;
+  unsigned int batchStart, batchSize, numThreads, nthreads;
   ddf.data=NULL;
   ddf.n=0;
   ddf.n_max=0;
   len = 1;
   int offset, offsetRef;
 
+  /* Huge files are walked through in windows instead of being read into memory */
+  if (!isHtml && (isResultCmp || 0 != rangeDelta) && cmpStreamWanted(filename, reffilename)) {
+    return SimulationResultsCmp_compareResultsStreaming(isResultCmp, runningTestsuite, filename, reffilename, resultfilename, reltol, abstol, reltolDiffMaxMin, rangeDelta, vars, keepEqualResults, success);
+  }
+
   /* open files */
   /*  fprintf(stderr, "Open File %s\n", filename); */
   if (UNKNOWN_PLOT == SimulationResultsImpl__openFile(filename,&simresglob_c)) {
@@ -646,6 +892,9 @@ void* SimulationResultsCmp_compareResults(int isResultCmp, int runningTestsuite,
       }
       MMC_THROW();
     }
+  } else if (ncmpvars > 16) {
+    /* Reading all columns in one pass is cheaper than seeking through the file for every variable */
+    suggestReadAll = 1;
   }
 #ifdef DEBUGOUTPUT
   fprintf(stderr, "Compare Vars:\n");
@@ -656,7 +905,9 @@ void* SimulationResultsCmp_compareResults(int isResultCmp, int runningTestsuite,
   /* fprintf(stderr, "get time\n"); */
   timeVarName = getTimeVarName(allvars);
   timeVarNameRef = getTimeVarName(allvarsref);
-  time = getData(timeVarName,filename,size,suggestReadAll,&simresglob_c,runningTestsuite);
+  loadCsvColumns(cmpvars,ncmpvars,filename,&simresglob_c);
+  loadCsvColumns(cmpvars,ncmpvars,reffilename,&simresglob_ref);
+  time = getDataColumn(timeVarName,filename,size,suggestReadAll,&simresglob_c,runningTestsuite);
   if (time.n==0) {
     c_add_message(NULL,-1,ErrorType_scripting,ErrorLevel_error,gettext("Error getting time"),NULL,0);
     if (success) {
@@ -666,7 +917,7 @@ void* SimulationResultsCmp_compareResults(int isResultCmp, int runningTestsuite,
     MMC_THROW();
   }
   /* fprintf(stderr, "get reftime\n"); */
-  timeref = getData(timeVarNameRef,reffilename,size_ref,suggestReadAll,&simresglob_ref,runningTestsuite);
+  timeref = getDataColumn(timeVarNameRef,reffilename,size_ref,suggestReadAll,&simresglob_ref,runningTestsuite);
   if (timeref.n==0) {
     c_add_message(NULL,-1,ErrorType_scripting,ErrorLevel_error,gettext("Error getting time from reference file"),NULL,0);
     if (success) {
@@ -691,84 +942,110 @@ void* SimulationResultsCmp_compareResults(int isResultCmp, int runningTestsuite,
   /* calculate offsets */
   for(offset=0; offset<time.n-1 && time.data[offset] == time.data[offset+1]; ++offset);
   for(offsetRef=0; offsetRef<timeref.n-1 && timeref.data[offsetRef] == timeref.data[offsetRef+1]; ++offsetRef);
-  var1=NULL;
-  var2=NULL;
+  /* Calibrating the actual time line onto the reference only depends on the
+   * two time lines; do it once for all variables */
+  if (isHtml || !isResultCmp) {
+    actualMap = calibrationMap(timeref.data,time.data,timeref.n,time.n,tubesTimeTolerance(&time,&timeref,rangeDelta));
+  }
+  /* The variables are loaded by this thread, compared in parallel and then
+   * merged in their original order, batch by batch to bound the memory use */
+  numThreads = isHtml ? 1 : intMin(cmpNumThreads > 0 ? cmpNumThreads : System_numProcessors(), ncmpvars);
+  batchSize = numThreads > 1 ? 4*numThreads : 1;
+  jobs = (CmpJob*) omc_alloc_interface.malloc(sizeof(CmpJob)*batchSize);
+  th = (pthread_t*) omc_alloc_interface.malloc(sizeof(pthread_t)*numThreads);
+  args.time = &time;
+  args.timeref = &timeref;
+  args.actualMap = actualMap;
+  args.isResultCmp = isResultCmp;
+  args.isHtml = isHtml;
+  args.reltol = reltol;
+  args.abstol = abstol;
+  args.rangeDelta = rangeDelta;
+  args.reltolDiffMaxMin = reltolDiffMaxMin;
+  args.keepEqualResults = keepEqualResults;
+  args.prefix = resultfilename;
+  args.jobs = jobs;
+  pthread_mutex_init(&args.mutex,NULL);
   /* compare vars */
   /* fprintf(stderr, "compare vars\n"); */
-  for (i=0;i<ncmpvars;i++) {
-    var = cmpvars[i];
-    len = strlen(var);
-    if (var1) {
-      free(var1);
-      var1 = NULL;
-    }
-    var1 = (char*) omc_alloc_interface.malloc(len+10);
-    k = 0;
-    for (j=0;j<len;j++) {
-      if (var[j] !='\"' ) {
-        var1[k] = var[j];
-        k +=1;
-      }
-    }
-    var1[k] = 0;
-    /* fprintf(stderr, "compare var: %s\n",var); */
-    /* check if in ref_file */
-    dataref = getData(var1,reffilename,size_ref,suggestReadAll,&simresglob_ref,runningTestsuite);
-    if (dataref.n==0) {
-      if (dataref.data) {
-        free(dataref.data);
+  for (batchStart=0;batchStart<ncmpvars;batchStart+=batchSize) {
+    unsigned int nbatch = intMin(batchSize, ncmpvars-batchStart);
+    for (i=0;i<nbatch;i++) {
+      CmpJob *job = &jobs[i];
+      memset(job, 0, sizeof(CmpJob));
+      var = cmpvars[batchStart+i];
+      job->var = var;
+      len = strlen(var);
+      var1 = (char*) omc_alloc_interface.malloc_atomic(len+10);
+      k = 0;
+      for (j=0;j<len;j++) {
+        if (var[j] !='\"' ) {
+          var1[k] = var[j];
+          k +=1;
+        }
       }
-      if (var1) {
+      var1[k] = 0;
+      /* fprintf(stderr, "compare var: %s\n",var); */
+      /* check if in ref_file */
+      job->dataref = getDataColumn(var1,reffilename,size_ref,suggestReadAll,&simresglob_ref,runningTestsuite);
+      if (job->dataref.n==0) {
+        freeCmpJob(job);
         GC_free(var1);
-        var1 = NULL;
-      }
-      msg[0] = runningTestsuite ? SystemImpl__basename(reffilename) : reffilename;
-      msg[1] = var;
-      c_add_message(NULL,-1, ErrorType_scripting, ErrorLevel_warning, gettext("Get data of variable %s from file %s failed!\n"), msg, 2);
-      ngetfailedvars++;
-      continue;
-    }
-    /*  check if in file */
-    data = getData(var1,filename,size,suggestReadAll,&simresglob_c,runningTestsuite);
-    if (data.n==0)  {
-      if (data.data) {
-        free(data.data);
+        msg[0] = runningTestsuite ? SystemImpl__basename(reffilename) : reffilename;
+        msg[1] = var;
+        c_add_message(NULL,-1, ErrorType_scripting, ErrorLevel_warning, gettext("Get data of variable %s from file %s failed!\n"), msg, 2);
+        ngetfailedvars++;
+        continue;
       }
-      if (var1) {
-        GC_free(var1);
-        var1 = NULL;
+      /*  check if in file */
+      job->data = getDataColumn(var1,filename,size,suggestReadAll,&simresglob_c,runningTestsuite);
+      GC_free(var1);
+      if (job->data.n==0)  {
+        freeCmpJob(job);
+        msg[0] = runningTestsuite ? SystemImpl__basename(filename) : filename;
+        msg[1] = var;
+        c_add_message(NULL,-1, ErrorType_scripting, ErrorLevel_warning, gettext("Get data of variable %s from file %s failed!\n"), msg, 2);
+        ngetfailedvars++;
+        continue;
       }
-      msg[0] = runningTestsuite ? SystemImpl__basename(filename) : filename;
-      msg[1] = var;
-      c_add_message(NULL,-1, ErrorType_scripting, ErrorLevel_warning, gettext("Get data of variable %s from file %s failed!\n"), msg, 2);
-      ngetfailedvars++;
-      continue;
+      /* adjust initial data points */
+      for(j=offset; j>0; j--)
+        job->data.data[j-1] = job->data.data[j];
+      for(j=offsetRef; j>0; j--)
+        job->dataref.data[j-1] = job->dataref.data[j];
     }
-    /* adjust initial data points */
-    for(j=offset; j>0; j--)
-      data.data[j-1] = data.data[j];
-    for(j=offsetRef; j>0; j--)
-      dataref.data[j-1] = dataref.data[j];
     /* compare */
-    if (isHtml) {
-      vardiffindx = cmpDataTubes(isResultCmp,var,&time,&timeref,&data,&dataref,reltol,rangeDelta,reltolDiffMaxMin,&ddf,cmpdiffvars,vardiffindx,keepEqualResults,&res,resultfilename,1,htmlOut);
-    } else if (isResultCmp) {
-      vardiffindx = cmpData(isResultCmp,var,&time,&timeref,&data,&dataref,reltol,abstol,&ddf,cmpdiffvars,vardiffindx,keepEqualResults,&res,resultfilename);
-    } else {
-      vardiffindx = cmpDataTubes(isResultCmp,var,&time,&timeref,&data,&dataref,reltol,rangeDelta,reltolDiffMaxMin,&ddf,cmpdiffvars,vardiffindx,keepEqualResults,&res,resultfilename,0,0);
-    }
-    /* free */
-    if (dataref.data) {
-      free(dataref.data);
+    args.current = 0;
+    args.size = nbatch;
+    nthreads = intMin(numThreads, nbatch);
+    for (i=1; i<nthreads; i++) {
+      GC_pthread_create(&th[i],NULL,cmpWorkerThread,&args);
     }
-    if (data.data) {
-      free(data.data);
+    cmpWorkerThread(&args);
+    for (i=1; i<nthreads; i++) {
+      GC_pthread_join(th[i], NULL);
     }
-    if (var1) {
-      GC_free(var1);
-      var1 = NULL;
+    /* merge in the order of the variables */
+    for (i=0;i<nbatch;i++) {
+      CmpJob *job = &jobs[i];
+      appendDiffDataField(&ddf, &job->ddf);
+      if (job->isdifferent) {
+        cmpdiffvars[vardiffindx] = job->var;
+        vardiffindx++;
+        if (!isResultCmp) {
+          res = mmc_mk_cons(mmc_mk_scon(job->var),res);
+        }
+      }
+      if (job->html) {
+        *htmlOut = job->html;
+      }
+      freeCmpJob(job);
     }
   }
+  pthread_mutex_destroy(&args.mutex);
+  GC_free(th);
+  GC_free(jobs);
+  freeCalibrationMap(actualMap);
 
   if (isResultCmp) {
     if (writeLogFile(resultfilename,&ddf,filename,reffilename,reltol,abstol)) {
@@ -887,13 +1164,15 @@ double SimulationResultsCmp_deltaResults(const char *filename, const char *reffi
  /*fprintf(stderr, "get time\n");*/
   timeVarName = getTimeVarName(allvars);
   timeVarNameRef = getTimeVarName(allvarsref);
-  time = getData(timeVarName,filename,size,suggestReadAll,&simresglob_c,0);
+  loadCsvColumns(cmpvars,ncmpvars,filename,&simresglob_c);
+  loadCsvColumns(cmpvars,ncmpvars,reffilename,&simresglob_ref);
+  time = getDataColumn(timeVarName,filename,size,suggestReadAll,&simresglob_c,0);
   if (time.n==0) {
     c_add_message(NULL,-1, ErrorType_scripting, ErrorLevel_error, gettext("Error get time!"), msg, 0);
     return -1;
   }
    /*fprintf(stderr, "get reftime\n");*/
-  timeref = getData(timeVarNameRef,reffilename,size_ref,suggestReadAll,&simresglob_ref,0);
+  timeref = getDataColumn(timeVarNameRef,reffilename,size_ref,suggestReadAll,&simresglob_ref,0);
   if (timeref.n==0) {
     c_add_message(NULL,-1, ErrorType_scripting, ErrorLevel_error, gettext("Error get reference time!"), msg, 0);
     return -1;
@@ -933,7 +1212,7 @@ double SimulationResultsCmp_deltaResults(const char *filename, const char *reffi
     var1[k] = 0;
     /* fprintf(stderr, "compare var: %s\n",var); */
     /* check if in ref_file */
-    dataref = getData(var1,reffilename,size_ref,suggestReadAll,&simresglob_ref,0);
+    dataref = getDataColumn(var1,reffilename,size_ref,suggestReadAll,&simresglob_ref,0);
     if (dataref.n==0) {
       if (dataref.data) {
         free(dataref.data);
@@ -945,7 +1224,7 @@ double SimulationResultsCmp_deltaResults(const char *filename, const char *reffi
       continue;
     }
     /*  check if in file */
-    data = getData(var1,filename,size,suggestReadAll,&simresglob_c,0);
+    data = getDataColumn(var1,filename,size,suggestReadAll,&simresglob_c,0);
     if (data.n==0)  {
       if (data.data) {
         free(data.data);
@@ -0,0 +1,1034 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-CurrentYear, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF GPL VERSION 3 LICENSE OR
+ * THIS OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the Open Source Modelica
+ * Consortium (OSMC) Public License (OSMC-PL) are obtained
+ * from OSMC, either from the above address,
+ * from the URLs: http://www.ida.liu.se/projects/OpenModelica or
+ * http://www.openmodelica.org, and in the OpenModelica distribution.
+ * GNU version 3 is obtained from: http://www.gnu.org/copyleft/gpl.html.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without
+ * even the implied warranty of  MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE, EXCEPT AS EXPRESSLY SET FORTH
+ * IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE CONDITIONS OF OSMC-PL.
+ *
+ * See the full OSMC Public License conditions for more details.
+ *
+ */
+
+/*
+ * Comparison of result files that do not fit into memory.
+ *
+ * Both files are walked through in windows of rows that move forward in
+ * time together. Every variable keeps its own position in the windows and
+ * the state of its comparison (cmpDataStep, or the tubes and calibration
+ * cursors), so only the rows between the slowest and the fastest variable
+ * are kept. If the windows of all variables do not fit into the memory
+ * limit, the variables are compared in groups with one pass per group.
+ */
+
+/* Files larger than this many MB are compared in windows; overridden by
+ * --cmpMemoryLimit or the environment variable OPENMODELICA_CMP_MEMORY_LIMIT
+ * (0 always streams) */
+#define CMP_STREAM_DEFAULT_LIMIT 2048
+/* Memory for the windows if the limit is 0 */
+#define CMP_STREAM_DEFAULT_WINDOW (256<<20)
+/* Rows kept before and after the current point of every variable for the
+ * searches for events and interpolation partners of cmpDataStep */
+#define CMP_STREAM_MARGIN 256
+/* Size of the block of rows read from the file at once */
+#define CMP_STREAM_CHUNK (16<<20)
+
+static double cmpStreamLimit(void)
+{
+  const char *limit = getenv("OPENMODELICA_CMP_MEMORY_LIMIT");
+  if (cmpMemoryLimit >= 0) {
+    return cmpMemoryLimit;
+  }
+  return (limit && *limit) ? atof(limit) : CMP_STREAM_DEFAULT_LIMIT;
+}
+
+static int cmpStreamFormat(const char *filename)
+{
+  int len = strlen(filename);
+  if (len < 5) return UNKNOWN_PLOT;
+  if (0 == strcmp(filename+len-4, ".mat")) return MATLAB4;
+  if (0 == strcmp(filename+len-4, ".csv")) return CSV;
+  return UNKNOWN_PLOT;
+}
+
+/* Returns 1 if one of the files is too large to be compared in memory */
+static int cmpStreamWanted(const char *filename, const char *reffilename)
+{
+  double limit = cmpStreamLimit() * 1024.0 * 1024.0;
+  omc_stat_t buf = {0}, bufref = {0};
+  if (UNKNOWN_PLOT == cmpStreamFormat(filename) || UNKNOWN_PLOT == cmpStreamFormat(reffilename)) {
+    return 0;
+  }
+  if (omc_stat(filename, &buf) || omc_stat(reffilename, &bufref)) {
+    return 0;
+  }
+  return limit <= 0 || (double)buf.st_size > limit || (double)bufref.st_size > limit;
+}
+
+/* Reads the rows of a result file, column by column */
+typedef struct {
+  PlotFormat format;
+  const char *filename;
+  SimulationResult_Globals *srg;   /* MATLAB4: holds the reader */
+  struct csv_column_reader *csv;
+  int ncols;
+  int *index;                      /* MATLAB4: signed column in data_2; 0 for parameters */
+  double *param;                   /* MATLAB4: value of the parameters */
+  double *rowbuf;
+  unsigned int rowbufRows;
+  unsigned int row;                /* Next row to read */
+  int eof;
+} ResultStream;
+
+/* Returns 0 on success */
+static int resultStreamOpen(ResultStream *rs, const char *filename, SimulationResult_Globals *srg)
+{
+  memset(rs, 0, sizeof(ResultStream));
+  rs->filename = filename;
+  rs->srg = srg;
+  rs->format = cmpStreamFormat(filename);
+  if (rs->format == MATLAB4) {
+    /* Only reads the header */
+    return MATLAB4 != SimulationResultsImpl__openFile(filename,srg);
+  }
+  /* Do not use SimulationResultsImpl__openFile, it reads the whole file */
+  rs->csv = read_csv_columns_open(filename, 0, NULL);
+  if (rs->csv == NULL) {
+    const char *msg[1] = {filename};
+    c_add_message(NULL,-1, ErrorType_scripting, ErrorLevel_error, gettext("Failed to open simulation result %s"), msg, 1);
+    return 1;
+  }
+  return 0;
+}
+
+/* The variables of the file, like SimulationResultsImpl__readVarsFilterAliases */
+static void* resultStreamVars(ResultStream *rs)
+{
+  void *res = mmc_mk_nil();
+  char **variables;
+  int i, n;
+  if (rs->format == MATLAB4) {
+    return SimulationResultsImpl__readVarsFilterAliases(rs->filename,rs->srg);
+  }
+  variables = read_csv_columns_names(rs->csv, &n);
+  for (i=n-1; i>=0; i--) {
+    if (variables[i][0] != '\0') {
+      res = mmc_mk_cons(mmc_mk_scon(variables[i]),res);
+    }
+  }
+  return res;
+}
+
+static void resultStreamStop(ResultStream *rs)
+{
+  if (rs->csv) {
+    read_csv_columns_close(rs->csv);
+    rs->csv = NULL;
+  }
+  if (rs->index) free(rs->index);
+  if (rs->param) free(rs->param);
+  if (rs->rowbuf) free(rs->rowbuf);
+  rs->index = NULL;
+  rs->param = NULL;
+  rs->rowbuf = NULL;
+}
+
+/* Starts reading the columns names from the first row; found[i] (may be NULL)
+ * tells if names[i] is in the file. Missing columns read as 0. Returns 0 on success */
+static int resultStreamStart(ResultStream *rs, int ncols, const char **names, char *found)
+{
+  int i;
+  size_t width;
+  resultStreamStop(rs);
+  rs->ncols = ncols;
+  rs->row = 0;
+  rs->eof = 0;
+  if (rs->format == MATLAB4) {
+    ModelicaMatReader *reader = &rs->srg->matReader;
+    rs->index = (int*) malloc(sizeof(int)*ncols);
+    rs->param = (double*) malloc(sizeof(double)*ncols);
+    for (i=0; i<ncols; i++) {
+      ModelicaMatVariable_t *var = omc_matlab4_find_var(reader, names[i]);
+      rs->index[i] = 0;
+      rs->param[i] = 0;
+      if (var && var->isParam) {
+        double param = reader->params[abs(var->index)-1];
+        rs->param[i] = var->index < 0 ? -param : param;
+      } else if (var) {
+        rs->index[i] = var->index;
+      }
+      if (found) found[i] = var != NULL;
+    }
+    width = reader->nvar ? reader->nvar : 1;
+  } else {
+    rs->csv = read_csv_columns_open(rs->filename, ncols, names);
+    if (rs->csv == NULL) {
+      return 1;
+    }
+    for (i=0; i<ncols && found; i++) {
+      found[i] = read_csv_columns_found(rs->csv, i);
+    }
+    width = ncols ? ncols : 1;
+  }
+  rs->rowbufRows = CMP_STREAM_CHUNK / (sizeof(double)*width);
+  if (rs->rowbufRows == 0) {
+    rs->rowbufRows = 1;
+  }
+  /* The csv reader converts straight into the columns of the window */
+  if (rs->format == MATLAB4) {
+    rs->rowbuf = (double*) malloc(sizeof(double)*width*rs->rowbufRows);
+  }
+  return 0;
+}
+
+/* Reads up to maxRows rows; column c of row k goes to cols[c*stride+k].
+ * Returns the number of rows read or -1 on error */
+static int resultStreamRead(ResultStream *rs, double *cols, unsigned int stride, unsigned int maxRows)
+{
+  unsigned int k, nrows = intMin(maxRows, rs->rowbufRows);
+  int c, n;
+  if (rs->eof || nrows == 0) {
+    return 0;
+  }
+  if (rs->format == MATLAB4) {
+    ModelicaMatReader *reader = &rs->srg->matReader;
+    nrows = intMin(nrows, reader->nrows - rs->row);
+    if (omc_matlab4_read_rows(reader, rs->row, nrows, rs->rowbuf)) {
+      return -1;
+    }
+    for (c=0; c<rs->ncols; c++) {
+      int index = rs->index[c];
+      double *col = cols + (size_t)c*stride;
+      if (index == 0) {
+        for (k=0; k<nrows; k++) col[k] = rs->param[c];
+      } else if (index > 0) {
+        for (k=0; k<nrows; k++) col[k] = rs->rowbuf[(size_t)k*reader->nvar + index-1];
+      } else {
+        for (k=0; k<nrows; k++) col[k] = -rs->rowbuf[(size_t)k*reader->nvar - index-1];
+      }
+    }
+    n = nrows;
+    rs->eof = rs->row + nrows >= reader->nrows;
+  } else {
+    n = read_csv_columns_next(rs->csv, cols, stride, nrows);
+    if (n < 0) {
+      return -1;
+    }
+    rs->eof = n == 0;
+  }
+  rs->row += n;
+  return n;
+}
+
+static void resultStreamClose(ResultStream *rs)
+{
+  resultStreamStop(rs);
+  if (rs->format == MATLAB4) {
+    SimulationResultsImpl__close(rs->srg);
+  }
+}
+
+/* The rows first..first+count-1 of a file; column 0 is the time. Row r of
+ * column c is at cols[c*capacity + r - first]. The nextra columns after the
+ * ones of the file are filled by the user of the window. */
+typedef struct {
+  ResultStream *stream;
+  int ncols, nextra;
+  double *cols;
+  unsigned int capacity, maxCapacity, first, count;
+  int eof;
+} RowWindow;
+
+static unsigned int cmpStreamRows(size_t bytes, size_t ncols)
+{
+  size_t rows = bytes / (sizeof(double)*ncols);
+  return rows < 2 ? 2 : rows > 0x10000000 ? 0x10000000 : (unsigned int) rows;
+}
+
+/* The window may grow to maxBytes, or stays at capacity if that is larger */
+static void windowInit(RowWindow *w, ResultStream *stream, int ncols, int nextra, unsigned int capacity, size_t maxBytes)
+{
+  w->stream = stream;
+  w->ncols = ncols;
+  w->nextra = nextra;
+  w->capacity = capacity;
+  w->maxCapacity = cmpStreamRows(maxBytes, ncols+nextra);
+  if (w->maxCapacity < capacity) {
+    w->maxCapacity = capacity;
+  }
+  w->first = 0;
+  w->count = 0;
+  w->eof = 0;
+  w->cols = (double*) malloc(sizeof(double)*(ncols+nextra)*(size_t)capacity);
+}
+
+static void windowFree(RowWindow *w)
+{
+  free(w->cols);
+  w->cols = NULL;
+}
+
+static inline double* windowColumn(RowWindow *w, int c)
+{
+  return w->cols + (size_t)c*w->capacity;
+}
+
+/* The column, indexed relative to the first row of the window */
+static inline DataField windowField(RowWindow *w, int c)
+{
+  DataField res;
+  res.data = windowColumn(w, c);
+  res.n = w->count;
+  return res;
+}
+
+/* Doubles the rows of the window, up to maxCapacity. Returns 0 on success */
+static int windowGrow(RowWindow *w)
+{
+  unsigned int capacity;
+  double *cols;
+  int c;
+  if (w->capacity >= w->maxCapacity) {
+    char buf[32];
+    const char *msg[2] = {w->stream->filename, buf};
+    snprintf(buf, 32, "%.0f", sizeof(double)*(w->ncols+w->nextra)*(double)w->capacity/(1024*1024));
+    c_add_message(NULL,-1, ErrorType_scripting, ErrorLevel_error, gettext("Comparing %s in windows needs more than %s MB for the rows between the slowest and the fastest variable. Increase --cmpMemoryLimit."), msg, 2);
+    return 1;
+  }
+  capacity = w->capacity > w->maxCapacity/2 ? w->maxCapacity : 2*w->capacity;
+  cols = (double*) malloc(sizeof(double)*(w->ncols+w->nextra)*(size_t)capacity);
+  for (c=0; c<w->ncols+w->nextra; c++) {
+    memcpy(cols + (size_t)c*capacity, windowColumn(w, c), sizeof(double)*w->count);
+  }
+  free(w->cols);
+  w->cols = cols;
+  w->capacity = capacity;
+  return 0;
+}
+
+/* Forgets the first n rows */
+static void windowDrop(RowWindow *w, unsigned int n)
+{
+  int c;
+  if (n == 0) {
+    return;
+  }
+  for (c=0; c<w->ncols+w->nextra; c++) {
+    double *col = windowColumn(w, c);
+    memmove(col, col+n, sizeof(double)*(w->count-n));
+  }
+  w->first += n;
+  w->count -= n;
+}
+
+/* Reads rows until the window is full. The initial points with the same
+ * time get the value of the last of them, like in the comparison in memory.
+ * Returns 0 on success */
+static int windowFill(RowWindow *w)
+{
+  int n;
+  int adjust = w->first == 0 && w->count == 0;
+  while (!w->eof) {
+    while (w->count < w->capacity && !w->eof) {
+      n = resultStreamRead(w->stream, w->cols + w->count, w->capacity, w->capacity - w->count);
+      if (n < 0) {
+        const char *msg[1] = {w->stream->filename};
+        c_add_message(NULL,-1, ErrorType_scripting, ErrorLevel_error, gettext("Failed to read simulation result %s"), msg, 1);
+        return 1;
+      }
+      w->count += n;
+      w->eof = w->stream->eof;
+    }
+    /* The first rows may all have the same time; make sure the end of them is in the window */
+    if (!adjust || w->eof || w->count == 0 || w->cols[0] != w->cols[w->count-1]) {
+      break;
+    }
+    if (windowGrow(w)) {
+      return 1;
+    }
+  }
+  if (adjust && w->count > 0) {
+    unsigned int offset, j;
+    int c;
+    for(offset=0; offset<w->count-1 && w->cols[offset] == w->cols[offset+1]; ++offset);
+    for (c=1; c<w->ncols; c++) {
+      double *col = windowColumn(w, c);
+      for(j=offset; j>0; j--)
+        col[j-1] = col[j];
+    }
+  }
+  return 0;
+}
+
+/* One variable compared in windows */
+typedef struct {
+  char *name;
+  char *lookup;       /* The name without quotes, as stored in the files */
+  double sumAbsRef, min, max;
+  int isdifferent;
+  /* cmpDataStep */
+  unsigned int i;     /* Next point of the actual file, relative to its window */
+  CmpDataState state; /* state.j is relative to the window of the reference */
+  /* Tubes */
+  privates *priv;
+  double abstol;
+  unsigned int added;     /* Points of the reference added to the tubes */
+  unsigned int evaluated; /* Points of the reference checked against the tubes */
+  unsigned int n;         /* Points of the reference that can be calibrated without extrapolating */
+  int ja, jh, jl;         /* Calibration cursors in the actual window and the high and low tubes */
+  unsigned int jo;        /* Next actual point written to the output, relative to its window */
+  int lastStepError, finished, warned;
+  int writeHeader;
+} CmpStreamVar;
+
+typedef struct {
+  ResultStream act, ref;
+  const char *timeVarName, *timeVarNameRef;
+  const char *prefix;
+  unsigned int nact, nref;
+  double tStopAct, tStart, tStop;
+  double reltol, abstol, rangeDelta, reltolDiffMaxMin, xabstol;
+  int runningTestsuite, keepEqualResults;
+  size_t windowBytes;
+} CmpStream;
+
+static const char** cmpStreamNames(CmpStream *cs, CmpStreamVar *vars, int nvars, int ref)
+{
+  const char **names = (const char**) omc_alloc_interface.malloc(sizeof(char*)*(nvars+1));
+  int v;
+  names[0] = ref ? cs->timeVarNameRef : cs->timeVarName;
+  for (v=0; v<nvars; v++) {
+    names[v+1] = vars[v].lookup;
+  }
+  return names;
+}
+
+/* Counts the rows, the time range and the magnitude of the reference
+ * values. Returns 0 on success */
+static int cmpStreamStatistics(CmpStream *cs, CmpStreamVar *vars, int nvars)
+{
+  RowWindow w;
+  const char **names = cmpStreamNames(cs, vars, nvars, 1);
+  unsigned int k, capacity = cmpStreamRows(cs->windowBytes, nvars+1);
+  int v, err = 0;
+
+  /* The reference */
+  if (resultStreamStart(&cs->ref, nvars+1, names, NULL)) {
+    GC_free(names);
+    return 1;
+  }
+  GC_free(names);
+  windowInit(&w, &cs->ref, nvars+1, 0, capacity, 2*cs->windowBytes);
+  while (!w.eof) {
+    double *time;
+    if ((err = windowFill(&w))) break;
+    if (w.count == 0) break;
+    time = windowColumn(&w, 0);
+    if (w.first == 0) {
+      cs->tStart = time[0];
+      for (v=0; v<nvars; v++) {
+        vars[v].min = vars[v].max = windowColumn(&w, v+1)[0];
+        vars[v].sumAbsRef = 0;
+      }
+    }
+    for (v=0; v<nvars; v++) {
+      double *col = windowColumn(&w, v+1);
+      for (k=0; k<w.count; k++) {
+        vars[v].sumAbsRef += fabs(col[k]);
+        vars[v].max = fmax(col[k],vars[v].max);
+        vars[v].min = fmin(col[k],vars[v].min);
+      }
+    }
+    cs->tStop = time[w.count-1];
+    windowDrop(&w, w.count);
+  }
+  cs->nref = w.first;
+  windowFree(&w);
+  if (err) return err;
+  /* Only the time of the actual file */
+  if (resultStreamStart(&cs->act, 1, &cs->timeVarName, NULL)) {
+    return 1;
+  }
+  windowInit(&w, &cs->act, 1, 0, cmpStreamRows(cs->windowBytes, 1), 2*cs->windowBytes);
+  while (!w.eof) {
+    if ((err = windowFill(&w))) break;
+    if (w.count == 0) break;
+    cs->tStopAct = windowColumn(&w, 0)[w.count-1];
+    windowDrop(&w, w.count);
+  }
+  cs->nact = w.first;
+  windowFree(&w);
+  return err;
+}
+
+/* The number of variables compared in one pass over the files and the rows
+ * in each window, so that the windows stay within cs->windowBytes. Every
+ * window needs at least minRows rows. */
+static int cmpStreamGroupSize(CmpStream *cs, int nvars, int colsPerVar, size_t minRows, unsigned int *capacity)
+{
+  size_t group = cs->windowBytes / (sizeof(double)*minRows*colsPerVar);
+  if (group < 1) group = 1;
+  if (group > (size_t)nvars) group = nvars;
+  *capacity = cmpStreamRows(cs->windowBytes, colsPerVar*group + 2);
+  if (*capacity < minRows) *capacity = cmpStreamRows(sizeof(double)*minRows, 1);
+  return (int) group;
+}
+
+/* The classic comparison (cmpData) of one group of variables; the differing
+ * points are appended to flog as they are found. Returns 0 on success */
+/* Reports a file without rows to compare. Returns 1 */
+static int windowEmpty(RowWindow *a, RowWindow *r)
+{
+  const char *msg[1] = {a->count == 0 ? a->stream->filename : r->stream->filename};
+  c_add_message(NULL,-1, ErrorType_scripting, ErrorLevel_error, gettext("The result file %s has no rows to compare."), msg, 1);
+  return 1;
+}
+
+static int cmpStreamData(CmpStream *cs, CmpStreamVar *vars, int nvars, unsigned int capacity, FILE *flog, unsigned int *ndiff)
+{
+  RowWindow a, r;
+  DiffDataField ddf = {NULL,0,0};
+  const char **names;
+  int v, done, err = 0;
+  const unsigned int M = CMP_STREAM_MARGIN;
+
+  names = cmpStreamNames(cs, vars, nvars, 0);
+  err = resultStreamStart(&cs->act, nvars+1, names, NULL);
+  GC_free(names);
+  names = cmpStreamNames(cs, vars, nvars, 1);
+  err = err || resultStreamStart(&cs->ref, nvars+1, names, NULL);
+  GC_free(names);
+  if (err) {
+    return err;
+  }
+  windowInit(&a, &cs->act, nvars+1, 0, capacity, 2*cs->windowBytes);
+  windowInit(&r, &cs->ref, nvars+1, 0, capacity, 2*cs->windowBytes);
+  err = windowFill(&a) || windowFill(&r);
+  if (!err && (a.count == 0 || r.count == 0)) {
+    err = windowEmpty(&a, &r);
+  }
+  if (err) {
+    windowFree(&a);
+    windowFree(&r);
+    return err;
+  }
+  for (v=0; v<nvars; v++) {
+    DataField reftime = windowField(&r, 0);
+    vars[v].i = 0;
+    cmpDataInit(&vars[v].state, &reftime, cmpDataTolerance(vars[v].sumAbsRef, cs->nref, cs->reltol, cs->abstol));
+  }
+  do {
+    DataField time = windowField(&a, 0), reftime = windowField(&r, 0);
+    unsigned int minI = a.count, minJ = r.count;
+    done = 1;
+    for (v=0; v<nvars; v++) {
+      CmpStreamVar *var = &vars[v];
+      DataField data = windowField(&a, v+1), refdata = windowField(&r, v+1);
+      while (var->i < a.count) {
+        double t = time.data[var->i];
+        /* The searches of cmpDataStep must not run into the end of a window */
+        if (!a.eof && var->i + M >= a.count) break;
+        if (!r.eof && (r.count <= M || reftime.data[r.count-1-M] <= t)) break;
+        var->i = cmpDataStep(&var->state, var->i, var->name, &time, &reftime, &data, &refdata, cs->reltol, &ddf, 1, NULL);
+      }
+      var->isdifferent = var->state.isdifferent;
+      if (var->i < a.count || !a.eof) {
+        done = 0;
+      }
+      minI = intMin(minI, var->i);
+      minJ = intMin(minJ, var->state.j);
+    }
+    if (flog) {
+      writeLogFileData(flog, &ddf);
+    }
+    *ndiff += ddf.n;
+    ddf.n = 0;
+    if (done) {
+      break;
+    }
+    /* Move the windows forward */
+    minI = minI > M ? minI - M : 0;
+    minJ = minJ > M ? minJ - M : 0;
+    windowDrop(&a, minI);
+    windowDrop(&r, minJ);
+    for (v=0; v<nvars; v++) {
+      vars[v].i -= minI;
+      vars[v].state.j -= minJ;
+    }
+    err = (a.count == a.capacity && !a.eof && windowGrow(&a)) || (r.count == r.capacity && !r.eof && windowGrow(&r));
+    err = err || windowFill(&a) || windowFill(&r);
+  } while (!err);
+  if (ddf.data) free(ddf.data);
+  windowFree(&a);
+  windowFree(&r);
+  return err;
+}
+
+static void cmpStreamTubesInit(CmpStream *cs, CmpStreamVar *var)
+{
+  privates *priv = tubesInit(cs->tStart, cs->tStop, var->min, var->max, cs->rangeDelta, 1024);
+  var->priv = priv;
+  var->abstol = (priv->max-priv->min == 0 && priv->max < cs->reltolDiffMaxMin*cs->reltolDiffMaxMin) ? cs->reltolDiffMaxMin*cs->reltolDiffMaxMin : fabs((priv->max-priv->min)*cs->reltolDiffMaxMin);
+  var->added = 0;
+  var->evaluated = 0;
+  var->n = cs->nref;
+  var->ja = var->jh = var->jl = 1;
+  var->jo = 0;
+  var->lastStepError = 1;
+  var->finished = 0;
+  var->writeHeader = 1;
+}
+
+/* Adds the new points of the reference to the tubes. Tube vertices far
+ * enough behind the last point no longer change and can be used. */
+static void cmpStreamTubesAdd(CmpStream *cs, CmpStreamVar *var, RowWindow *r, double *refdata, double *reftime)
+{
+  privates *priv = var->priv;
+  double *time = windowColumn(r, 0);
+  unsigned int k;
+  for (k=var->added-r->first; k<r->count; k++) {
+    reftime[k] = tubesAddPoint(priv, time[k], refdata[k], var->added++);
+  }
+  if (r->eof && !var->finished) {
+    tubesFinish(priv);
+    priv->fixedHigh = priv->countHigh;
+    priv->fixedLow = priv->countLow;
+    var->finished = 1;
+  } else if (!var->finished && priv->countHigh > 0) {
+    double frontier = priv->x1 - 4*priv->delta;
+    while (priv->fixedHigh+1 < (int)priv->countHigh && priv->xHigh[priv->fixedHigh] < frontier) priv->fixedHigh++;
+    while (priv->fixedLow+1 < (int)priv->countLow && priv->xLow[priv->fixedLow] < frontier) priv->fixedLow++;
+  }
+  if (priv->revised && !var->warned) {
+    const char *msg[1] = {var->name};
+    c_add_message(NULL,-1, ErrorType_scripting, ErrorLevel_warning, gettext("The tubes of variable %s changed behind the comparison window; the result may differ slightly from a comparison in memory.\n"), msg, 1);
+    var->warned = 1;
+  }
+}
+
+/* Checks the points of the reference against the tubes as far as the
+ * windows allow, like validate() of cmpDataTubes. With fout, the points are
+ * written like cmpDataTubes writes them. */
+static void cmpStreamTubesEvaluate(CmpStream *cs, CmpStreamVar *var, RowWindow *a, RowWindow *r, double *data, double *refdata, double *reftime, FILE *fout)
+{
+  privates *priv = var->priv;
+  double *time = windowColumn(a, 0);
+  double xabstol = cs->xabstol, reltol = cs->reltol, abstol = var->abstol;
+
+  while (var->evaluated < cs->nref) {
+    unsigned int i = var->evaluated, e = i - r->first;
+    double x = reftime[e], y = refdata[e];
+    /* The next point of the reference is needed for the events */
+    if (!var->finished && i+1 >= var->added) break;
+    /* The actual points around x */
+    if (!a->eof && (a->count == 0 || time[a->count-1] <= x)) break;
+    if (!var->finished && i < var->n &&
+        (priv->fixedHigh == 0 || priv->xHigh[priv->fixedHigh-1] <= x || priv->fixedLow == 0 || priv->xLow[priv->fixedLow-1] <= x)) {
+      break;
+    }
+    if (fout) {
+      fprintf(fout, "%.15g,%.15g,", x, y);
+    }
+    if (i < var->n) {
+      char rightLimit;
+      double xPrev = i ? reftime[e-1] : 0, xLast = cs->tStop, val, high, low, error;
+      int isEvent, thisStepError = 0;
+      /* After a cut, the tubes are calibrated up to this point only */
+      if (!calibrationStep(&var->ja, i, x, xPrev, xLast, time, a->count, xabstol, &rightLimit)) {
+        var->n = i+1;
+        xLast = x;
+      }
+      val = calibratedValue(var->ja, rightLimit, x, time, data, xabstol);
+      if (!calibrationStep(&var->jh, i, x, xPrev, xLast, priv->xHigh, priv->countHigh, xabstol, &rightLimit)) {
+        var->n = i+1;
+        xLast = x;
+      }
+      high = calibratedValue(var->jh, rightLimit, x, priv->xHigh, priv->yHigh, xabstol);
+      if (!calibrationStep(&var->jl, i, x, xPrev, xLast, priv->xLow, priv->countLow, xabstol, &rightLimit)) {
+        var->n = i+1;
+      }
+      low = calibratedValue(var->jl, rightLimit, x, priv->xLow, priv->yLow, xabstol);
+      high = fmax(y + fmax(fabs(y*reltol),abstol), high);
+      low = fmin(y - fmax(fabs(y*reltol),abstol), low);
+      isEvent = (i && almostEqualRelativeAndAbs(x,xPrev,0,xabstol)) || (i+1<var->n && almostEqualRelativeAndAbs(x,reftime[e+1],0,xabstol));
+      if (isEvent) {
+        double tol = fmax(abstol*10,fmax(fabs(y),fabs(val))*reltol*10);
+        high = (var->lastStepError ? y : fmax(y,val)) + tol;
+        low = (var->lastStepError ? y : fmin(y,val)) - tol;
+        error = NAN;
+      } else {
+        error = 0;
+        thisStepError = var->lastStepError;
+        if (val < low) {
+          error = low-val;
+          var->isdifferent = 1;
+          thisStepError = 1;
+        } else if (val > high) {
+          error = val-high;
+          var->isdifferent = 1;
+          thisStepError = 1;
+        }
+      }
+      var->lastStepError = thisStepError;
+      if (fout) {
+        /* Only a variable with errors gets the error column */
+        if (!var->isdifferent || isnan(error)) {
+          fprintf(fout, "%.15g,%.15g,%.15g,",val,high,low);
+        } else {
+          fprintf(fout, "%.15g,%.15g,%.15g,%.15g",val,high,low,error);
+        }
+        if (var->jo < a->count && x == time[var->jo]) {
+          fprintf(fout, ",%.15g\n",data[var->jo++]);
+        } else {
+          fputs(",\n", fout);
+        }
+      }
+    } else if (fout) {
+      fputs(",,,,\n", fout);
+    }
+    if (fout) {
+      while (var->jo < a->count && x > time[var->jo]) {
+        fprintf(fout, "%.15g,,,,,,%.15g\n",time[var->jo],data[var->jo]);
+        var->jo++;
+      }
+    }
+    var->evaluated++;
+  }
+}
+
+/* Drops the parts of the tubes no point will be calibrated against any more */
+static void cmpStreamTubesCompact(CmpStreamVar *var)
+{
+  privates *priv = var->priv;
+  int nHigh = intmax(0, (var->jh < priv->fixedHigh ? var->jh : priv->fixedHigh) - 2);
+  int nLow = intmax(0, (var->jl < priv->fixedLow ? var->jl : priv->fixedLow) - 2);
+  if (nHigh < 1024 || 2*nHigh < (int)priv->countHigh) nHigh = 0;
+  if (nLow < 1024 || 2*nLow < (int)priv->countLow) nLow = 0;
+  tubesDiscard(priv, nHigh, nLow);
+  var->jh -= nHigh;
+  var->jl -= nLow;
+}
+
+static FILE* cmpStreamOutput(CmpStream *cs, CmpStreamVar *var)
+{
+  char *fname = (char*) omc_alloc_interface.malloc_atomic(25 + strlen(cs->prefix) + strlen(var->name));
+  FILE *fout;
+  sprintf(fname, "%s.%s.csv", cs->prefix, var->name);
+  fout = omc_fopen(fname, var->writeHeader ? "w" : "a");
+  if (!fout) {
+    perror("Error opening file");
+    fprintf(stderr, "File: %s\n", fname);
+    fflush(stderr);
+  } else if (var->writeHeader) {
+    fputs("time,reference,actual,high,low,error,actual (raw)\n", fout);
+    var->writeHeader = 0;
+  }
+  GC_free(fname);
+  return fout;
+}
+
+/* The comparison with tubes (cmpDataTubes) of one group of variables.
+ * If output is set, the variables are known to differ (or the equal ones are
+ * kept) and their csv files are written. Returns 0 on success */
+static int cmpStreamTubes(CmpStream *cs, CmpStreamVar *vars, int nvars, unsigned int capacity, int output)
+{
+  RowWindow a, r;
+  const char **names;
+  int v, done, err;
+
+  names = cmpStreamNames(cs, vars, nvars, 0);
+  err = resultStreamStart(&cs->act, nvars+1, names, NULL);
+  GC_free(names);
+  names = cmpStreamNames(cs, vars, nvars, 1);
+  err = err || resultStreamStart(&cs->ref, nvars+1, names, NULL);
+  GC_free(names);
+  if (err) {
+    return err;
+  }
+  windowInit(&a, &cs->act, nvars+1, 0, capacity, 2*cs->windowBytes);
+  /* The extra columns hold the reference time of every variable; the tubes may move events */
+  windowInit(&r, &cs->ref, nvars+1, nvars, capacity, 2*cs->windowBytes);
+  for (v=0; v<nvars; v++) {
+    cmpStreamTubesInit(cs, &vars[v]);
+  }
+  err = windowFill(&a) || windowFill(&r);
+  if (!err && (a.count == 0 || r.count == 0)) {
+    err = windowEmpty(&a, &r);
+  }
+  while (!err) {
+    unsigned int dropA = a.count, dropR = r.count;
+    done = 1;
+    for (v=0; v<nvars; v++) {
+      CmpStreamVar *var = &vars[v];
+      double *reftime = windowColumn(&r, nvars+1+v);
+      FILE *fout = NULL;
+      cmpStreamTubesAdd(cs, var, &r, windowColumn(&r, v+1), reftime);
+      if (output) {
+        fout = cmpStreamOutput(cs, var);
+      }
+      cmpStreamTubesEvaluate(cs, var, &a, &r, windowColumn(&a, v+1), windowColumn(&r, v+1), reftime, fout);
+      if (fout) {
+        if (var->evaluated == cs->nref) {
+          fputs("\n", fout);
+        }
+        fclose(fout);
+      }
+      if (var->evaluated < cs->nref) {
+        done = 0;
+      }
+      /* Keep what the next points need: the interpolation partners and
+       * unwritten points of the actual file, the previous reference point */
+      if (var->evaluated < cs->nref) {
+        if (output) dropA = intMin(dropA, var->jo);
+        if (var->evaluated < var->n) dropA = intMin(dropA, var->ja-1);
+        dropR = intMin(dropR, var->evaluated > r.first ? var->evaluated-1-r.first : 0);
+      }
+      cmpStreamTubesCompact(var);
+    }
+    if (done) {
+      break;
+    }
+    windowDrop(&a, dropA);
+    windowDrop(&r, dropR);
+    for (v=0; v<nvars; v++) {
+      vars[v].ja -= dropA;
+      vars[v].jo -= dropA;
+    }
+    err = (a.count == a.capacity && !a.eof && windowGrow(&a)) || (r.count == r.capacity && !r.eof && windowGrow(&r));
+    err = err || windowFill(&a) || windowFill(&r);
+  }
+  for (v=0; v<nvars; v++) {
+    freeTubes(vars[v].priv);
+    GC_free(vars[v].priv);
+    vars[v].priv = NULL;
+  }
+  windowFree(&a);
+  windowFree(&r);
+  return err;
+}
+
+/* SimulationResultsCmp_compareResults for files that are too large for the memory */
+static void* SimulationResultsCmp_compareResultsStreaming(int isResultCmp, int runningTestsuite, const char *filename, const char *reffilename, const char *resultfilename, double reltol, double abstol, double reltolDiffMaxMin, double rangeDelta, void *vars, int keepEqualResults, int *success)
+{
+  CmpStream cs;
+  CmpStreamVar *cmpvars;
+  char **names;
+  char *found, *foundref;
+  const char **lookups;
+  const char *msg[2] = {"",""};
+  void *allvars, *allvarsref, *res;
+  unsigned int ncmpvars = 0, ngetfailedvars = 0, ndiff = 0, vardiffindx = 0, capacity;
+  int i, nvars = 0, group, err = 0;
+  double limit = cmpStreamLimit();
+  size_t lagRows;
+
+  memset(&cs, 0, sizeof(CmpStream));
+  cs.prefix = resultfilename;
+  cs.reltol = reltol;
+  cs.abstol = abstol;
+  cs.rangeDelta = rangeDelta;
+  cs.reltolDiffMaxMin = reltolDiffMaxMin;
+  cs.runningTestsuite = runningTestsuite;
+  cs.keepEqualResults = keepEqualResults;
+  /* Two windows of each file may be alive at the same time while they grow */
+  cs.windowBytes = limit > 0 ? (size_t)(limit*1024*1024/4) : CMP_STREAM_DEFAULT_WINDOW;
+
+  if (resultStreamOpen(&cs.act, filename, &simresglob_c)) {
+    c_add_message(NULL,-1,ErrorType_scripting,ErrorLevel_error,gettext("Error opening file: %s"),&filename,1);
+    if (success) {
+      *success = 0;
+      return mmc_mk_nil();
+    }
+    MMC_THROW();
+  }
+  if (resultStreamOpen(&cs.ref, reffilename, &simresglob_ref)) {
+    resultStreamClose(&cs.act);
+    c_add_message(NULL,-1,ErrorType_scripting,ErrorLevel_error,gettext("Error opening reference file: %s"),&reffilename,1);
+    if (success) {
+      *success = 0;
+      return mmc_mk_nil();
+    }
+    MMC_THROW();
+  }
+
+  /* get vars to compare */
+  names = getVars(vars,&ncmpvars);
+  allvars = resultStreamVars(&cs.act);
+  allvarsref = resultStreamVars(&cs.ref);
+  if (ncmpvars==0) {
+    names = getVars(allvarsref,&ncmpvars);
+  }
+  cs.timeVarName = getTimeVarName(allvars);
+  cs.timeVarNameRef = getTimeVarName(allvarsref);
+  if (ncmpvars==0) {
+    c_add_message(NULL,-1,ErrorType_scripting,ErrorLevel_error,gettext("Error getting variables"),NULL,0);
+    err = 1;
+  }
+  /* Which variables are in both files */
+  cmpvars = (CmpStreamVar*) omc_alloc_interface.malloc(sizeof(CmpStreamVar)*(ncmpvars+1));
+  memset(cmpvars, 0, sizeof(CmpStreamVar)*(ncmpvars+1));
+  lookups = (const char**) omc_alloc_interface.malloc(sizeof(char*)*(ncmpvars+1));
+  found = (char*) omc_alloc_interface.malloc_atomic(ncmpvars+1);
+  foundref = (char*) omc_alloc_interface.malloc_atomic(ncmpvars+1);
+  for (i=0; !err && i<ncmpvars; i++) {
+    char *var = names[i], *var1;
+    int j, k = 0, len = strlen(var);
+    var1 = (char*) omc_alloc_interface.malloc_atomic(len+10);
+    for (j=0;j<len;j++) {
+      if (var[j] !='\"' ) {
+        var1[k] = var[j];
+        k +=1;
+      }
+    }
+    var1[k] = 0;
+    cmpvars[i].name = var;
+    cmpvars[i].lookup = var1;
+    lookups[i+1] = var1;
+  }
+  if (!err) {
+    lookups[0] = cs.timeVarName;
+    err = resultStreamStart(&cs.act, ncmpvars+1, lookups, found);
+    lookups[0] = cs.timeVarNameRef;
+    err = err || resultStreamStart(&cs.ref, ncmpvars+1, lookups, foundref);
+  }
+  if (!err && !found[0]) {
+    c_add_message(NULL,-1,ErrorType_scripting,ErrorLevel_error,gettext("Error getting time"),NULL,0);
+    err = 1;
+  } else if (!err && !foundref[0]) {
+    c_add_message(NULL,-1,ErrorType_scripting,ErrorLevel_error,gettext("Error getting time from reference file"),NULL,0);
+    err = 1;
+  }
+  if (!err) {
+    for (i=0; i<ncmpvars; i++) {
+      if (foundref[i+1] && found[i+1]) {
+        cmpvars[nvars++] = cmpvars[i];
+      }
+    }
+    err = cmpStreamStatistics(&cs, cmpvars, nvars);
+  }
+  if (!err && cs.nact == 0) {
+    c_add_message(NULL,-1,ErrorType_scripting,ErrorLevel_error,gettext("Error getting time"),NULL,0);
+    err = 1;
+  } else if (!err && cs.nref == 0) {
+    c_add_message(NULL,-1,ErrorType_scripting,ErrorLevel_error,gettext("Error getting time from reference file"),NULL,0);
+    err = 1;
+  }
+  if (err) {
+    resultStreamClose(&cs.act);
+    resultStreamClose(&cs.ref);
+    if (success) {
+      *success = 0;
+      return mmc_mk_nil();
+    }
+    MMC_THROW();
+  }
+  /* check if time is larger or less reftime */
+  res = mmc_mk_nil();
+  if (fabs(cs.tStopAct-cs.tStop) > reltol*fabs(cs.tStop)) {
+    char buf[WARNINGBUFFSIZE];
+    snprintf(buf,WARNINGBUFFSIZE,"Resultfile and Reference have different end time points!\n"
+    "Reffile[%d]=%f\n"
+    "File[%d]=%f\n",cs.nref,cs.tStop,cs.nact,cs.tStopAct);
+    c_add_message(NULL,-1, ErrorType_scripting, ErrorLevel_warning, buf, NULL, 0);
+  }
+  for (i=0; i<ncmpvars; i++) {
+    const char *file = !foundref[i+1] ? reffilename : filename;
+    if (foundref[i+1] && found[i+1]) continue;
+    msg[0] = runningTestsuite ? SystemImpl__basename(file) : file;
+    msg[1] = names[i];
+    c_add_message(NULL,-1, ErrorType_scripting, ErrorLevel_error, gettext("Could not read variable %s in file %s."), msg, 2);
+    c_add_message(NULL,-1, ErrorType_scripting, ErrorLevel_warning, gettext("Get data of variable %s from file %s failed!\n"), msg, 2);
+    ngetfailedvars++;
+  }
+
+  if (isResultCmp) {
+    FILE *flog = omc_fopen(resultfilename, "w");
+    if (flog) {
+      writeLogFileHeader(flog,filename,reffilename,reltol,abstol);
+    } else {
+      c_add_message(NULL,-1, ErrorType_scripting, ErrorLevel_warning, gettext("Cannot write to the difference (.csv) file!\n"), msg, 0);
+    }
+    group = cmpStreamGroupSize(&cs, nvars, 2, 4*CMP_STREAM_MARGIN, &capacity);
+    for (i=0; !err && i<nvars; i+=group) {
+      err = cmpStreamData(&cs, cmpvars+i, intMin(group, nvars-i), capacity, flog, &ndiff);
+    }
+    if (flog) {
+      fclose(flog);
+    }
+  } else {
+    CmpStreamVar *outvars = (CmpStreamVar*) omc_alloc_interface.malloc(sizeof(CmpStreamVar)*(nvars+1));
+    int noutvars = 0;
+    /* Like tubesTimeTolerance */
+    cs.xabstol = (cs.tStop-cs.tStart)*1e-3 / fmax(cs.nact,cs.nref);
+    /* The tube vertices are final about 4 tube widths behind the last point */
+    lagRows = (size_t) (fmax(cs.nact,cs.nref) * 8 * rangeDelta) + 4*CMP_STREAM_MARGIN;
+    group = cmpStreamGroupSize(&cs, nvars, 3, lagRows, &capacity);
+    for (i=0; !err && i<nvars; i+=group) {
+      err = cmpStreamTubes(&cs, cmpvars+i, intMin(group, nvars-i), capacity, 0);
+    }
+    /* Second pass for the csv files of the differing variables */
+    for (i=0; !err && i<nvars; i++) {
+      if (cmpvars[i].isdifferent || keepEqualResults) {
+        outvars[noutvars++] = cmpvars[i];
+      }
+    }
+    for (i=0; !err && i<noutvars; i+=group) {
+      err = cmpStreamTubes(&cs, outvars+i, intMin(group, noutvars-i), capacity, 1);
+    }
+    GC_free(outvars);
+  }
+  if (err) {
+    c_add_message(NULL,-1, ErrorType_scripting, ErrorLevel_error, gettext("Failed to compare the result files in windows"), NULL, 0);
+  }
+  for (i=0; i<nvars; i++) {
+    if (cmpvars[i].isdifferent) {
+      vardiffindx++;
+      if (!isResultCmp) {
+        res = mmc_mk_cons(mmc_mk_scon(cmpvars[i].name),res);
+      }
+    }
+  }
+  if (isResultCmp) {
+    if (ndiff > 0 || ngetfailedvars > 0 || vardiffindx > 0 || err) {
+      for (i=0; i<nvars; i++) {
+        if (cmpvars[i].isdifferent) {
+          res = (void*)mmc_mk_cons(mmc_mk_scon(cmpvars[i].name),res);
+        }
+      }
+      res = mmc_mk_cons(mmc_mk_scon("Files not Equal!"),res);
+      c_add_message(NULL,-1, ErrorType_scripting, ErrorLevel_warning, gettext("Files not Equal\n"), msg, 0);
+    } else {
+      res = mmc_mk_cons(mmc_mk_scon("Files Equal!"),res);
+    }
+  } else if (success) {
+    *success = vardiffindx == 0 && !err;
+  }
+
+  GC_free(cmpvars);
+  GC_free(lookups);
+  GC_free(found);
+  GC_free(foundref);
+  GC_free(names);
+  resultStreamClose(&cs.act);
+  resultStreamClose(&cs.ref);
+  return res;
+}
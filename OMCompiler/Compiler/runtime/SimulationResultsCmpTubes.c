@@ -71,15 +71,22 @@
 typedef struct {
   double *mh,*ml,*xHigh,*xLow,*yHigh,*yLow;
   int *i0h,*i1h,*i0l,*i1l;
+  /* The curve points at i0h,i1h,i0l,i1l; kept by value so the curve itself does not need to stay in memory */
+  double *x0h,*y0h,*x1h,*y1h,*x0l,*y0l,*x1l,*y1l;
   double tStart,tStop,x1,y1,x2,y2,currentSlope,slopeDif,delta,S,xRelEps,xMinStep,min,max;
   size_t countLow,countHigh,length;
+  size_t capacity;   /* Size of the lists */
+  int timeChanged; /* calculateTubes moved event times of x to make it strictly increasing */
+  /* Streaming: lists entries below these were already used and must not change any more */
+  int fixedHigh,fixedLow;
+  int revised;       /* An entry below fixedHigh/fixedLow was changed anyway */
 } privates;
 
 static inline int intmax(int a, int b) {
   return a>b ? a : b;
 }
 
-static void generateHighTube(privates *priv, double *x, double *y)
+static void generateHighTube(privates *priv)
 {
   int index = priv->countHigh - 1;
   double m1 = priv->mh[index];
@@ -93,14 +100,16 @@ static void generateHighTube(privates *priv, double *x, double *y)
     double x3,y3,x4,y4;
 
     priv->i0h[index-1] = priv->i0h[index]; /* Remove the second to last element */
+    priv->x0h[index-1] = priv->x0h[index];
+    priv->y0h[index-1] = priv->y0h[index];
     priv->countHigh--; /* Remove the last element for priv->i1h and priv->mh, priv->xHigh and priv->yHigh */
 
 
     /* calculation of the new slope (3.2.6.3.3) */
-    x3 = x[priv->i0h[index - 1]];  /* = _dX1 */
-    y3 = y[priv->i0h[index - 1]];  /* = _dY1 */
-    x4 = x[priv->i1h[index - 1]];  /* < X3 */
-    y4 = y[priv->i1h[index - 1]];
+    x3 = priv->x0h[index - 1];  /* = _dX1 */
+    y3 = priv->y0h[index - 1];  /* = _dY1 */
+    x4 = priv->x1h[index - 1];  /* < X3 */
+    y4 = priv->y1h[index - 1];
 
     /* write slope to the list of slopes */
     priv->mh[index - 1] = (y3 - y4) / (x3 - x4);
@@ -124,13 +133,20 @@ static void generateHighTube(privates *priv, double *x, double *y)
       /* consolidating the current and the previous interval (3.2.6.7.3) */
       priv->i0h[index-1] = priv->i0h[index]; /* Remove the second to last element */
       priv->i1h[index-1] = priv->i1h[index];
+      priv->x0h[index-1] = priv->x0h[index];
+      priv->y0h[index-1] = priv->y0h[index];
+      priv->x1h[index-1] = priv->x1h[index];
+      priv->y1h[index-1] = priv->y1h[index];
       priv->mh[index-1] = priv->mh[index];
       index--;
       priv->countHigh--; /* remove also from xHigh,yHigh */
+      if (index < priv->fixedHigh) {
+        priv->revised = 1;
+      }
 
       /* if the saved interval is the 1st interval (3.2.6.7.3.5.1) */
       if (index == 0) {
-        double x3 = x[0];
+        double x3 = priv->tStart;
         priv->xHigh[index] = x3 - priv->delta;
         priv->yHigh[index] = priv->y2 + m1 * (priv->xHigh[index] - priv->x2) + priv->delta * sqrt((m1 * m1) + (priv->S * priv->S));
       } else { /* if it is not the first:  (3.2.6.7.3.5.2.) */
@@ -145,7 +161,7 @@ static void generateHighTube(privates *priv, double *x, double *y)
   }
 }
 
-static void generateLowTube(privates *priv, double *x, double *y)
+static void generateLowTube(privates *priv)
 {
   int index = priv->countLow - 1; /* = _li0l.Count - 1 = _li1l.Count - 1 = xLow.Count - 1 = yLow.Count - 1 > 0 */
   double m1 = priv->ml[index];
@@ -155,12 +171,14 @@ static void generateLowTube(privates *priv, double *x, double *y)
   if ((priv->slopeDif == 0) || ((priv->slopeDif < 2e-15 * fmax(fabs(m1), fabs(m2))) && (priv->i0l[priv->countLow - 1] - priv->i1l[priv->countLow - 2] < 100))) {
     double x3,y3,x4,y4;
     priv->i0l[index-1] = priv->i0l[index];
+    priv->x0l[index-1] = priv->x0l[index];
+    priv->y0l[index-1] = priv->y0l[index];
     priv->countLow--;
 
-    x3 = x[priv->i0l[index - 1]];  /* = _dX1 */
-    y3 = y[priv->i0l[index - 1]];  /* = _dY1 */
-    x4 = x[priv->i1l[index - 1]];  /* < X3 */
-    y4 = y[priv->i1l[index - 1]];
+    x3 = priv->x0l[index - 1];  /* = _dX1 */
+    y3 = priv->y0l[index - 1];  /* = _dY1 */
+    x4 = priv->x1l[index - 1];  /* < X3 */
+    y4 = priv->y1l[index - 1];
 
     priv->ml[index - 1] = (y3 - y4) / (x3 - x4);
   } else {
@@ -180,12 +198,19 @@ static void generateLowTube(privates *priv, double *x, double *y)
     while (index>1 /* Avoid underflow. Should this generate an error instead? */ && priv->xLow[index] <= priv->xLow[index - 1]) {
       priv->i0l[index-1] = priv->i0l[index];
       priv->i1l[index-1] = priv->i1l[index];
+      priv->x0l[index-1] = priv->x0l[index];
+      priv->y0l[index-1] = priv->y0l[index];
+      priv->x1l[index-1] = priv->x1l[index];
+      priv->y1l[index-1] = priv->y1l[index];
       priv->ml[index-1] = priv->ml[index];
       index--;
       priv->countLow--;
+      if (index < priv->fixedLow) {
+        priv->revised = 1;
+      }
 
       if (index == 0) {
-        double x3 = x[0];
+        double x3 = priv->tStart;
         priv->xLow[index] = x3 - priv->delta;
         priv->yLow[index] = priv->y2 + m1 * (priv->xLow[index] - priv->x2) - priv->delta * sqrt((m1 * m1) + (priv->S * priv->S));
       } else {
@@ -202,6 +227,7 @@ static void generateLowTube(privates *priv, double *x, double *y)
 static privates* skipCalculateTubes(double *x, double *y, size_t length)
 {
   privates *priv = (privates*) omc_alloc_interface.malloc(sizeof(privates));
+  int i;
 
   /* set tStart and tStop */
   priv->length = length;
@@ -211,125 +237,236 @@ static privates* skipCalculateTubes(double *x, double *y, size_t length)
   priv->xMinStep = ((priv->tStop - priv->tStart) + fabs(priv->tStart)) * priv->xRelEps;
   priv->countLow = length;
   priv->countHigh = length;
+  priv->timeChanged = 0;
   priv->yHigh = (double*)omc_alloc_interface.malloc_atomic(sizeof(double)*length);
   priv->yLow  = (double*)omc_alloc_interface.malloc_atomic(sizeof(double)*length);
   memcpy(priv->yHigh, y, length * sizeof(double));
   memcpy(priv->yLow, y, length * sizeof(double));
+  /* The tubes collapse onto the curve itself */
+  priv->xHigh = x;
+  priv->xLow = x;
+  priv->max = y[0];
+  priv->min = y[0];
+  for (i = 1; i < length; i++) {
+    priv->max = fmax(y[i],priv->max);
+    priv->min = fmin(y[i],priv->min);
+  }
   return priv;
 }
 
-/* This method generates tubes around a given curve */
-static privates* calculateTubes(double *x, double *y, size_t length, double r)
+static void* reallocAtomic(void *data, size_t oldSize, size_t newSize)
+{
+  void *res = omc_alloc_interface.malloc_atomic(newSize);
+  if (data) {
+    memcpy(res, data, oldSize);
+    GC_free(data);
+  }
+  return res;
+}
+
+/* Makes room for n more entries in the lists */
+static void tubesReserve(privates *priv, size_t n)
+{
+  size_t capacity = priv->capacity, c = priv->capacity;
+  if (priv->countHigh + n <= capacity && priv->countLow + n <= capacity) {
+    return;
+  }
+  while (priv->countHigh + n > capacity || priv->countLow + n > capacity) {
+    capacity = capacity ? 2*capacity : 1024;
+  }
+  priv->mh  = (double*) reallocAtomic(priv->mh,  sizeof(double)*c, sizeof(double)*capacity);
+  priv->ml  = (double*) reallocAtomic(priv->ml,  sizeof(double)*c, sizeof(double)*capacity);
+  priv->i0h = (int*) reallocAtomic(priv->i0h, sizeof(int)*c, sizeof(int)*capacity);
+  priv->i1h = (int*) reallocAtomic(priv->i1h, sizeof(int)*c, sizeof(int)*capacity);
+  priv->i0l = (int*) reallocAtomic(priv->i0l, sizeof(int)*c, sizeof(int)*capacity);
+  priv->i1l = (int*) reallocAtomic(priv->i1l, sizeof(int)*c, sizeof(int)*capacity);
+  priv->x0h = (double*) reallocAtomic(priv->x0h, sizeof(double)*c, sizeof(double)*capacity);
+  priv->y0h = (double*) reallocAtomic(priv->y0h, sizeof(double)*c, sizeof(double)*capacity);
+  priv->x1h = (double*) reallocAtomic(priv->x1h, sizeof(double)*c, sizeof(double)*capacity);
+  priv->y1h = (double*) reallocAtomic(priv->y1h, sizeof(double)*c, sizeof(double)*capacity);
+  priv->x0l = (double*) reallocAtomic(priv->x0l, sizeof(double)*c, sizeof(double)*capacity);
+  priv->y0l = (double*) reallocAtomic(priv->y0l, sizeof(double)*c, sizeof(double)*capacity);
+  priv->x1l = (double*) reallocAtomic(priv->x1l, sizeof(double)*c, sizeof(double)*capacity);
+  priv->y1l = (double*) reallocAtomic(priv->y1l, sizeof(double)*c, sizeof(double)*capacity);
+  priv->xHigh = (double*) reallocAtomic(priv->xHigh, sizeof(double)*c, sizeof(double)*capacity);
+  priv->xLow  = (double*) reallocAtomic(priv->xLow,  sizeof(double)*c, sizeof(double)*capacity);
+  priv->yHigh = (double*) reallocAtomic(priv->yHigh, sizeof(double)*c, sizeof(double)*capacity);
+  priv->yLow  = (double*) reallocAtomic(priv->yLow,  sizeof(double)*c, sizeof(double)*capacity);
+  priv->capacity = capacity;
+}
+
+static void freeTubes(privates *priv)
+{
+  GC_free(priv->mh);
+  GC_free(priv->ml);
+  GC_free(priv->i0h);
+  GC_free(priv->i1h);
+  GC_free(priv->i0l);
+  GC_free(priv->i1l);
+  GC_free(priv->x0h);
+  GC_free(priv->y0h);
+  GC_free(priv->x1h);
+  GC_free(priv->y1h);
+  GC_free(priv->x0l);
+  GC_free(priv->y0l);
+  GC_free(priv->x1l);
+  GC_free(priv->y1l);
+  GC_free(priv->xHigh);
+  GC_free(priv->xLow);
+  GC_free(priv->yHigh);
+  GC_free(priv->yLow);
+}
+
+/* Removes the first nHigh entries of the upper and nLow entries of the lower
+ * lists once they are no longer needed; keeps the lists of a long curve short */
+static void tubesDiscard(privates *priv, size_t nHigh, size_t nLow)
+{
+#define TUBES_DISCARD(l, n, count) memmove(priv->l, priv->l + n, sizeof(*priv->l)*(priv->count - n))
+  if (nHigh > 0) {
+    TUBES_DISCARD(mh, nHigh, countHigh);
+    TUBES_DISCARD(i0h, nHigh, countHigh);
+    TUBES_DISCARD(i1h, nHigh, countHigh);
+    TUBES_DISCARD(x0h, nHigh, countHigh);
+    TUBES_DISCARD(y0h, nHigh, countHigh);
+    TUBES_DISCARD(x1h, nHigh, countHigh);
+    TUBES_DISCARD(y1h, nHigh, countHigh);
+    TUBES_DISCARD(xHigh, nHigh, countHigh);
+    TUBES_DISCARD(yHigh, nHigh, countHigh);
+    priv->countHigh -= nHigh;
+    priv->fixedHigh -= nHigh;
+  }
+  if (nLow > 0) {
+    TUBES_DISCARD(ml, nLow, countLow);
+    TUBES_DISCARD(i0l, nLow, countLow);
+    TUBES_DISCARD(i1l, nLow, countLow);
+    TUBES_DISCARD(x0l, nLow, countLow);
+    TUBES_DISCARD(y0l, nLow, countLow);
+    TUBES_DISCARD(x1l, nLow, countLow);
+    TUBES_DISCARD(y1l, nLow, countLow);
+    TUBES_DISCARD(xLow, nLow, countLow);
+    TUBES_DISCARD(yLow, nLow, countLow);
+    priv->countLow -= nLow;
+    priv->fixedLow -= nLow;
+  }
+#undef TUBES_DISCARD
+}
+
+/* Starts the tubes around a curve on [tStart,tStop] with values in [min,max].
+ * The points are then added one by one with tubesAddPoint. */
+static privates* tubesInit(double tStart, double tStop, double min, double max, double r, size_t capacity)
 {
   privates *priv = (privates*) omc_alloc_interface.malloc(sizeof(privates));
-  int i;
+  memset(priv, 0, sizeof(privates));
   /* set tStart and tStop */
-  priv->length = length;
-  priv->tStart = x[0];
-  priv->tStop = x[length - 1];
+  priv->tStart = tStart;
+  priv->tStop = tStop;
   priv->xRelEps = 1e-15;
   priv->xMinStep = ((priv->tStop - priv->tStart) + fabs(priv->tStart)) * priv->xRelEps;
   priv->countLow = 0;
   priv->countHigh = 0;
-
-  /* Initialize lists (upper tube) */
-  priv->mh  = (double*)omc_alloc_interface.malloc_atomic(sizeof(double)*length);
-  priv->i0h = (int*)omc_alloc_interface.malloc_atomic(sizeof(int)*length);
-  priv->i1h = (int*)omc_alloc_interface.malloc_atomic(sizeof(int)*length);
-  /* Initialize lists (lower tube) */
-  priv->ml  = (double*)omc_alloc_interface.malloc_atomic(sizeof(double)*length);
-  priv->i0l = (int*)omc_alloc_interface.malloc_atomic(sizeof(int)*length);
-  priv->i1l = (int*)omc_alloc_interface.malloc_atomic(sizeof(int)*length);
-
-  priv->xHigh = (double*)omc_alloc_interface.malloc_atomic(sizeof(double)*length);
-  priv->xLow  = (double*)omc_alloc_interface.malloc_atomic(sizeof(double)*length);
-  priv->yHigh = (double*)omc_alloc_interface.malloc_atomic(sizeof(double)*length);
-  priv->yLow  = (double*)omc_alloc_interface.malloc_atomic(sizeof(double)*length);
+  priv->timeChanged = 0;
+  tubesReserve(priv, capacity);
 
   /* calculate the tubes delta */
   priv->delta = r * (priv->tStop - priv->tStart);
 
   /* calculate S */
-  priv->max = y[0];
-  priv->min = y[0];
-
-  for (i = 1; i < length; i++) {
-    priv->max = fmax(y[i],priv->max);
-    priv->min = fmin(y[i],priv->min);
-  }
+  priv->max = max;
+  priv->min = min;
   priv->S = fabs(4 * (priv->max - priv->min) / (fabs(priv->tStop - priv->tStart)));
 
   if (priv->S < 0.0004 / fabs(priv->tStop - priv->tStart)) {
     priv->S = 0.0004 / fabs(priv->tStop - priv->tStart);
   }
+  return priv;
+}
 
-  /* Begin calculation for the tubes */
-  for (i = 1; i < length; i++) {
-    /* get current value */
-    priv->x1 = x[i];
-    priv->y1 = y[i];
-    /* get previous value */
-    priv->x2 = x[i - 1];
-    priv->y2 = y[i - 1];
-    /* catch jumps */
-    if ((priv->x1 <= priv->x2) && (priv->y1 == priv->y2) && (priv->countHigh == 0)) {
-      continue;
-    }
-    if ((priv->x1 <= priv->x2) && (priv->y1 == priv->y2)) {
-      priv->x1 = fmax(priv->x1, x[priv->i1l[priv->countLow - 1]] + priv->xMinStep);
-      priv->x1 = fmax(priv->x1, x[priv->i1h[priv->countHigh - 1]] + priv->xMinStep);
-      x[i] = priv->x1;
-      priv->currentSlope = priv->mh[priv->countHigh - 1];
-    } else {
-      if (priv->x1 <= priv->x2) {
-        priv->x1 = priv->x2 + priv->xMinStep;
-        x[i] = priv->x1;
-      }
-      priv->currentSlope = (priv->y1 - priv->y2) / (priv->x1 - priv->x2); /* calculate current slope ( 3.2.6.1) */
-    }
-
-    /* fill lists with new values: values upper tube */
-    priv->i0h[priv->countHigh] = i;
-    priv->i1h[priv->countHigh] = i-1;
-    priv->mh[priv->countHigh] = priv->currentSlope;
-
-    /* fill lists with new values: values lower tube */
-    priv->i0l[priv->countLow] = i;
-    priv->i1l[priv->countLow] = i-1;
-    if ((priv->x1 <= priv->x2) && (priv->y1 == priv->y2)) {
-      priv->currentSlope = priv->ml[priv->countLow - 1];
-    }
-    priv->ml[priv->countLow] = priv->currentSlope;
-
-    if (priv->countHigh == 0) { /* 1st interval (3.2.5) */
-      /* initial values upper tube */
-      priv->xHigh[priv->countHigh] = priv->x2 - priv->delta;
-      priv->yHigh[priv->countHigh] = priv->y2 - priv->currentSlope * priv->delta + priv->delta * sqrt((priv->currentSlope * priv->currentSlope) + (priv->S * priv->S));
-
-      /* initial values lower tube */
-      priv->xLow[priv->countLow] = priv->x2 - priv->delta;
-      priv->yLow[priv->countLow] = priv->y2 - priv->currentSlope * priv->delta - priv->delta * sqrt((priv->currentSlope * priv->currentSlope) + (priv->S * priv->S));
-
-      priv->countHigh++;
-      priv->countLow++;
-    } else {  // if not 1st interval (3.2.6)
-      /* fill lists with new values, set X and Y to arbitrary value (3.2.6.1) */
-      priv->xHigh[priv->countHigh] = 1;
-      priv->yHigh[priv->countHigh] = 1;
-      priv->xLow[priv->countLow] = 1;
-      priv->yLow[priv->countLow] = 1;
-
-      priv->countHigh++;
-      priv->countLow++;
-
-      /* begin procedure for upper tube */
-      generateHighTube(priv, x, y);
-      /* begin procedure for lower tube */
-      generateLowTube(priv, x, y);
+/* Adds point i of the curve; returns x, moved forward if it was not after the previous point */
+static double tubesAddPoint(privates *priv, double x, double y, int i)
+{
+  double xPrev = priv->x1, yPrev = priv->y1;
+  priv->length = i+1;
+  /* get current value */
+  priv->x1 = x;
+  priv->y1 = y;
+  if (i == 0) {
+    return x;
+  }
+  /* get previous value */
+  priv->x2 = xPrev;
+  priv->y2 = yPrev;
+  /* catch jumps */
+  if ((priv->x1 <= priv->x2) && (priv->y1 == priv->y2) && (priv->countHigh == 0)) {
+    return x;
+  }
+  tubesReserve(priv, 2);
+  if ((priv->x1 <= priv->x2) && (priv->y1 == priv->y2)) {
+    priv->x1 = fmax(priv->x1, priv->x1l[priv->countLow - 1] + priv->xMinStep);
+    priv->x1 = fmax(priv->x1, priv->x1h[priv->countHigh - 1] + priv->xMinStep);
+    priv->timeChanged |= x != priv->x1;
+    priv->currentSlope = priv->mh[priv->countHigh - 1];
+  } else {
+    if (priv->x1 <= priv->x2) {
+      priv->x1 = priv->x2 + priv->xMinStep;
+      priv->timeChanged |= x != priv->x1;
     }
+    priv->currentSlope = (priv->y1 - priv->y2) / (priv->x1 - priv->x2); /* calculate current slope ( 3.2.6.1) */
+  }
 
+  /* fill lists with new values: values upper tube */
+  priv->i0h[priv->countHigh] = i;
+  priv->i1h[priv->countHigh] = i-1;
+  priv->x0h[priv->countHigh] = priv->x1;
+  priv->y0h[priv->countHigh] = priv->y1;
+  priv->x1h[priv->countHigh] = priv->x2;
+  priv->y1h[priv->countHigh] = priv->y2;
+  priv->mh[priv->countHigh] = priv->currentSlope;
+
+  /* fill lists with new values: values lower tube */
+  priv->i0l[priv->countLow] = i;
+  priv->i1l[priv->countLow] = i-1;
+  priv->x0l[priv->countLow] = priv->x1;
+  priv->y0l[priv->countLow] = priv->y1;
+  priv->x1l[priv->countLow] = priv->x2;
+  priv->y1l[priv->countLow] = priv->y2;
+  if ((priv->x1 <= priv->x2) && (priv->y1 == priv->y2)) {
+    priv->currentSlope = priv->ml[priv->countLow - 1];
+  }
+  priv->ml[priv->countLow] = priv->currentSlope;
+
+  if (priv->countHigh == 0) { /* 1st interval (3.2.5) */
+    /* initial values upper tube */
+    priv->xHigh[priv->countHigh] = priv->x2 - priv->delta;
+    priv->yHigh[priv->countHigh] = priv->y2 - priv->currentSlope * priv->delta + priv->delta * sqrt((priv->currentSlope * priv->currentSlope) + (priv->S * priv->S));
+
+    /* initial values lower tube */
+    priv->xLow[priv->countLow] = priv->x2 - priv->delta;
+    priv->yLow[priv->countLow] = priv->y2 - priv->currentSlope * priv->delta - priv->delta * sqrt((priv->currentSlope * priv->currentSlope) + (priv->S * priv->S));
+
+    priv->countHigh++;
+    priv->countLow++;
+  } else {  // if not 1st interval (3.2.6)
+    /* fill lists with new values, set X and Y to arbitrary value (3.2.6.1) */
+    priv->xHigh[priv->countHigh] = 1;
+    priv->yHigh[priv->countHigh] = 1;
+    priv->xLow[priv->countLow] = 1;
+    priv->yLow[priv->countLow] = 1;
+
+    priv->countHigh++;
+    priv->countLow++;
+
+    /* begin procedure for upper tube */
+    generateHighTube(priv);
+    /* begin procedure for lower tube */
+    generateLowTube(priv);
   }
+  return priv->x1;
+}
 
+/* Adds the terminal values after the last point */
+static void tubesFinish(privates *priv)
+{
+  tubesReserve(priv, 1);
   // calculate terminal value
   // upper tube
   priv->x1 = priv->xHigh[priv->countHigh - 1];
@@ -352,6 +489,26 @@ static privates* calculateTubes(double *x, double *y, size_t length, double r)
   priv->xLow[priv->countLow] = priv->x2 + priv->delta;
   priv->yLow[priv->countLow] = priv->y1 + priv->currentSlope * (priv->x2 + priv->delta - priv->x1);
   priv->countLow++;
+}
+
+/* This method generates tubes around a given curve */
+static privates* calculateTubes(double *x, double *y, size_t length, double r)
+{
+  privates *priv;
+  double min = y[0], max = y[0];
+  int i;
+
+  for (i = 1; i < length; i++) {
+    max = fmax(y[i],max);
+    min = fmin(y[i],min);
+  }
+  priv = tubesInit(x[0], x[length - 1], min, max, r, length+1);
+
+  /* Begin calculation for the tubes */
+  for (i = 0; i < length; i++) {
+    x[i] = tubesAddPoint(priv, x[i], y[i], i);
+  }
+  tubesFinish(priv);
   return priv;
 }
 
@@ -368,52 +525,111 @@ static inline double linearInterpolation(double x, double x0, double x1, double
   }
 }
 
-/* Calibrate the target time+value pair onto the source timeline */
-static double* calibrateValues(double* sourceTimeLine, double* targetTimeLine, double* targetValues, size_t *nsource, size_t ntarget, double xabstol)
+/* Where each point of the source time line finds its value in the target
+ * time line. Only depends on the two time lines, so one map can be shared by
+ * all variables that are stored on the same time lines. */
+typedef struct {
+  size_t n;          /* Number of source points that are calibrated; the rest would be extrapolated */
+  int *j;            /* Right interpolation partner in the target time line */
+  char *rightLimit;  /* Use the right limit of an event instead of interpolating */
+} CalibrationMap;
+
+/* Finds the right interpolation partner *j in the target time line for point
+ * i of the source time line at x (xPrev is point i-1, xLast the last point).
+ * Returns 0 if the source time line is cut here to avoid extrapolation. */
+static int calibrationStep(int *j, int i, double x, double xPrev, double xLast, double* targetTimeLine, size_t ntarget, double xabstol, char *rightLimit)
 {
-  double* interpolatedValues;
+  double x0, x1;
+
+  if (targetTimeLine[*j] > xLast && targetTimeLine[*j-1] > xLast) { // Avoid extrapolation by cutting the sequence
+    *rightLimit = 0;
+    return 0;
+  }
+
+  x1 = targetTimeLine[*j];
+
+  while ((x1 <= x) && ((*j + 1) < ntarget)) { // step source timline to the current moment
+    (*j)++;
+    x1 = targetTimeLine[*j];
+    if (almostEqualRelativeAndAbs(x1,x,0,xabstol)) {
+      break;
+    }
+  }
+  x0 = targetTimeLine[*j - 1];
+  /* Previous value was the left limit of the event; use the right limit! */
+  *rightLimit = i && almostEqualRelativeAndAbs(xPrev,x0,0,xabstol) && almostEqualRelativeAndAbs(x0,x1,0,xabstol);
+  return 1;
+}
+
+static double calibratedValue(int j, char rightLimit, double x, double* targetTimeLine, double* targetValues, double xabstol)
+{
+  if (rightLimit) {
+    return targetValues[j];
+  }
+  return linearInterpolation(x,targetTimeLine[j-1],targetTimeLine[j],targetValues[j-1],targetValues[j],xabstol);
+}
+
+static CalibrationMap* calibrationMap(double* sourceTimeLine, double* targetTimeLine, size_t nsource, size_t ntarget, double xabstol)
+{
+  CalibrationMap *map;
   int j, i;
-  double x0, x1, y0, y1;
-  size_t n;
 
   if (0 == nsource) {
     return NULL;
   }
 
-  n = *nsource;
-  interpolatedValues = (double*) omc_alloc_interface.malloc_atomic(sizeof(double)*n);
+  map = (CalibrationMap*) omc_alloc_interface.malloc(sizeof(CalibrationMap));
+  map->n = nsource;
+  map->j = (int*) omc_alloc_interface.malloc_atomic(sizeof(int)*nsource);
+  map->rightLimit = (char*) omc_alloc_interface.malloc_atomic(sizeof(char)*nsource);
 
   j = 1;
-  for (i = 0; i < n; i++) {
-    double x = sourceTimeLine[i];
-
-    if (targetTimeLine[j] > sourceTimeLine[n - 1] && targetTimeLine[j-1] > sourceTimeLine[n - 1]) { // Avoid extrapolation by cutting the sequence
-      interpolatedValues[i] = linearInterpolation(x,x0,x1,y0,y1,xabstol);
-      *nsource = i+1;
+  for (i = 0; i < nsource; i++) {
+    int notCut = calibrationStep(&j, i, sourceTimeLine[i], i ? sourceTimeLine[i-1] : 0, sourceTimeLine[nsource - 1], targetTimeLine, ntarget, xabstol, &map->rightLimit[i]);
+    map->j[i] = j;
+    if (!notCut) {
+      map->n = i+1;
       break;
     }
+  }
 
-    x1 = targetTimeLine[j];
-    y1 = targetValues[j];
+  return map;
+}
 
-    while ((x1 <= x) && ((j + 1) < ntarget)) { // step source timline to the current moment
-      j++;
-      x1 = targetTimeLine[j];
-      y1 = targetValues[j];
-      if (almostEqualRelativeAndAbs(x1,x,0,xabstol)) {
-        break;
-      }
-    }
-    x0 = targetTimeLine[j - 1];
-    y0 = targetValues[j - 1];
-    if (i && almostEqualRelativeAndAbs(sourceTimeLine[i-1],x0,0,xabstol) && almostEqualRelativeAndAbs(x0,x1,0,xabstol)) {
-      /* Previous value was the left limit of the event; use the right limit! */
-      interpolatedValues[i] = y1;
-    } else {
-      interpolatedValues[i] = linearInterpolation(x,x0,x1,y0,y1,xabstol);
-    }
+static void freeCalibrationMap(CalibrationMap *map)
+{
+  if (map) {
+    GC_free(map->j);
+    GC_free(map->rightLimit);
+    GC_free(map);
+  }
+}
+
+static double* applyCalibrationMap(CalibrationMap *map, double* sourceTimeLine, double* targetTimeLine, double* targetValues, double xabstol)
+{
+  double* interpolatedValues = (double*) omc_alloc_interface.malloc_atomic(sizeof(double)*map->n);
+  int i;
+
+  for (i = 0; i < map->n; i++) {
+    interpolatedValues[i] = calibratedValue(map->j[i], map->rightLimit[i], sourceTimeLine[i], targetTimeLine, targetValues, xabstol);
+  }
+
+  return interpolatedValues;
+}
+
+/* Calibrate the target time+value pair onto the source timeline */
+static double* calibrateValues(double* sourceTimeLine, double* targetTimeLine, double* targetValues, size_t *nsource, size_t ntarget, double xabstol)
+{
+  double* interpolatedValues;
+  CalibrationMap *map = calibrationMap(sourceTimeLine, targetTimeLine, *nsource, ntarget, xabstol);
+
+  if (NULL == map) {
+    return NULL;
   }
 
+  interpolatedValues = applyCalibrationMap(map, sourceTimeLine, targetTimeLine, targetValues, xabstol);
+  *nsource = map->n;
+  freeCalibrationMap(map);
   return interpolatedValues;
 }
 
@@ -638,14 +854,24 @@ static double* validate(int n, addTargetEventTimesRes ref, double *low, double *
   return NULL;
 }
 
-static unsigned int cmpDataTubes(int isResultCmp, char* varname, DataField *time, DataField *reftime, DataField *data, DataField *refdata, double reltol, double rangeDelta, double reltolDiffMaxMin, DiffDataField *ddf, char **cmpdiffvars, unsigned int vardiffindx, int keepEqualResults, void **diffLst, const char *prefix, int isHtml, char **htmlOut)
+/* The tolerance for detecting events is proportional to the number of output points in the file */
+static double tubesTimeTolerance(DataField *time, DataField *reftime, double rangeDelta)
+{
+  int withTubes = 0 == rangeDelta;
+  return (reftime->data[reftime->n-1]-reftime->data[0])*(withTubes ? rangeDelta : 1e-3) / fmax(time->n,reftime->n);
+}
+
+/* Returns 1 if the variable is different. actualMap is the calibration of time
+ * onto reftime, shared by all variables; it may be NULL. reftime->data may be
+ * changed by the tube calculation. */
+static int cmpDataTubes(int isResultCmp, char* varname, DataField *time, DataField *reftime, DataField *data, DataField *refdata, double reltol, double rangeDelta, double reltolDiffMaxMin, CalibrationMap *actualMap, int keepEqualResults, const char *prefix, int isHtml, char **htmlOut)
 {
   int withTubes = 0 == rangeDelta;
+  int isdifferent;
   FILE *fout = NULL;
   char *fname = NULL;
   char *html;
-  /* The tolerance for detecting events is proportional to the number of output points in the file */
-  double xabstol = (reftime->data[reftime->n-1]-reftime->data[0])*(withTubes ? rangeDelta : 1e-3) / fmax(time->n,reftime->n);
+  double xabstol = tubesTimeTolerance(time, reftime, rangeDelta);
   /* Calculate the tubes without additional events added */
   addTargetEventTimesRes ref,actual,actualoriginal;
   privates *priv=NULL;
@@ -669,7 +895,12 @@ static unsigned int cmpDataTubes(int isResultCmp, char* varname, DataField *time
   /* ref = mergeTimelines(ref,actual,xabstol); */
   /* assertMonotonic(ref); */
   n = ref.size;
-  calibrated_values = calibrateValues(ref.time,actual.time,actual.values,&n,actual.size,xabstol);
+  if (actualMap && !priv->timeChanged) {
+    n = actualMap->n;
+    calibrated_values = applyCalibrationMap(actualMap,ref.time,actual.time,actual.values,xabstol);
+  } else {
+    calibrated_values = calibrateValues(ref.time,actual.time,actual.values,&n,actual.size,xabstol);
+  }
   maxPlusTol = priv->max + fabs(priv->max) * reltol;
   minMinusTol = priv->min - fabs(priv->min) * reltol;
   high = calibrateValues(ref.time,priv->xHigh,priv->yHigh,&n,priv->countHigh,xabstol);
@@ -786,13 +1017,7 @@ static unsigned int cmpDataTubes(int isResultCmp, char* varname, DataField *time
     }
     fputs(isHtml ? "],\n" : "\n", fout);
   }
-  if (error) {
-    cmpdiffvars[vardiffindx] = varname;
-    vardiffindx++;
-    if (!isResultCmp) {
-      *diffLst = mmc_mk_cons(mmc_mk_scon(varname),*diffLst);
-    }
-  }
+  isdifferent = error != NULL;
   if (fout) {
     if (isHtml) {
 fprintf(fout, "{title: '%s',\n"
@@ -846,19 +1071,13 @@ fprintf(fout, "{title: '%s',\n"
   if (fname) GC_free(fname);
   GC_free(low);
   GC_free(high);
-  if (withTubes) {
-    GC_free(priv->mh);
-    GC_free(priv->i0h);
-    GC_free(priv->i1h);
-    GC_free(priv->ml);
-    GC_free(priv->i0l);
-    GC_free(priv->i1l);
-    GC_free(priv->xHigh);
-    GC_free(priv->xLow);
+  if (!withTubes) {
+    freeTubes(priv);
+  } else {
+    GC_free(priv->yHigh);
+    GC_free(priv->yLow);
   }
-  GC_free(priv->yHigh);
-  GC_free(priv->yLow);
   GC_free(priv);
   GC_free(calibrated_values);
-  return vardiffindx;
+  return isdifferent;
 }
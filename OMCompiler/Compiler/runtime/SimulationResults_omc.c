@@ -71,6 +71,12 @@ double SimulationResults_val(const char *filename, const char *varname, double t
   return SimulationResultsImpl__val(filename,varname,timeStamp,&simresglob);
 }
 
+void SimulationResults_setCmpOptions(int memoryLimit, int numThreads)
+{
+  cmpMemoryLimit = memoryLimit;
+  cmpNumThreads = numThreads;
+}
+
 void* SimulationResults_cmpSimulationResults(int runningTestsuite, const char *filename,const char *reffilename,const char *logfilename, double refTol, double absTol, void *vars)
 {
   return SimulationResultsCmp_compareResults(1,runningTestsuite,filename,reffilename,logfilename,refTol,absTol,0,0,vars,0,NULL,0,NULL);
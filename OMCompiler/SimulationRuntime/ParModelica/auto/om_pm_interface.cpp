@@ -47,7 +47,11 @@ PMTimer seq_ode_timer;
 
 void* PM_Model_create(const char* model_name, DATA* data, threadData_t* threadData, size_t in_max_num_threads) {
 
+#ifdef USE_STEALING_SCHEDULER
+    size_t max_num_threads = in_max_num_threads ? in_max_num_threads : std::thread::hardware_concurrency();
+#else
     size_t max_num_threads = in_max_num_threads ? in_max_num_threads : tbb::this_task_arena::max_concurrency();
+#endif
 
     OMModel* pm_om_model = new OMModel(model_name, max_num_threads);
     pm_om_model->data = data;
@@ -97,7 +101,9 @@ double seq_ode_timer_get_elapsed_time() {
 void dump_times(void* v_model) {
     OMModel& model = *(static_cast<OMModel*>(v_model));
 
-#ifdef USE_LEVEL_SCHEDULER
+#ifdef USE_STEALING_SCHEDULER
+    utility::log("") << "Using work-stealing scheduler" << std::endl;
+#elif defined(USE_LEVEL_SCHEDULER)
     utility::log("") << "Using level scheduler" << std::endl;
 #else
 #ifdef USE_FLOW_SCHEDULER
@@ -119,6 +125,9 @@ void dump_times(void* v_model) {
     utility::log("") << "Total ODE loading time: " << model.load_system_timer.get_elapsed_time() << std::endl;
     utility::log("") << "Total ODE Clustering time: " << model.ODE_scheduler.clustering_timer.get_elapsed_time()
                      << std::endl;
+#ifdef USE_STEALING_SCHEDULER
+    utility::log("") << "Nr.of ODE re-clusterings: " << model.ODE_scheduler.nr_of_reschedules << std::endl;
+#endif
 }
 
 } // extern "C"
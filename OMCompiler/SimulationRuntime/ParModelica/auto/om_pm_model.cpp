@@ -83,7 +83,9 @@ void Equation::execute() {
 OMModel::OMModel(const std::string& in_name, size_t mnt)
     : name(in_name)
     , max_num_threads(mnt)
+#ifndef USE_STEALING_SCHEDULER
     , tbb_system(mnt)
+#endif
     , INI_system(name, mnt)
     , INI_scheduler(INI_system, mnt)
     , DAE_system(name, mnt)
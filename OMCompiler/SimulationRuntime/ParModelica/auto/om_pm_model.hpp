@@ -38,11 +38,15 @@
  Mahder.Gebremedhin@liu.se  2020-10-12
 */
 
-#include <tbb/task_scheduler_init.h>
 #include <simulation_data.h>
 
+#ifdef USE_STEALING_SCHEDULER
+#include "pm_cluster_stealing_scheduler.hpp"
+#else
+#include <tbb/task_scheduler_init.h>
 #include "pm_cluster_level_scheduler.hpp"
 #include "pm_cluster_dynamic_scheduler.hpp"
+#endif
 
 #include "pm_timer.hpp"
 
@@ -89,7 +93,9 @@ class OMModel
     // typedef LevelSchedulerThreadOblivious<Equation> SchedulerT;
     // typedef DynamicScheduler<Equation> SchedulerT;
     // typedef TaskSystem<Equation> TaskSystemT;
-#ifdef USE_LEVEL_SCHEDULER
+#ifdef USE_STEALING_SCHEDULER
+    typedef ClusterStealingScheduler<Equation> SchedulerT;
+#elif defined(USE_LEVEL_SCHEDULER)
     typedef StepLevels<Equation> SchedulerT;
 #else
   #ifdef USE_FLOW_SCHEDULER
@@ -105,7 +111,9 @@ class OMModel
 public:
     std::string name;
     size_t max_num_threads;
+#ifndef USE_STEALING_SCHEDULER
     tbb::task_scheduler_init tbb_system;
+#endif
 
     bool intialized;
     DATA* data;
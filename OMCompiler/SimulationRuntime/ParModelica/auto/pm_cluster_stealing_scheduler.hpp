@@ -0,0 +1,467 @@
+#pragma once
+#ifndef id4B7E2D19_6A3C_4F0E_B5D27C81E9A4F362
+#define id4B7E2D19_6A3C_4F0E_B5D27C81E9A4F362
+
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-CurrentYear, Linköping University,
+ * Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF GPL VERSION 3
+ * AND THIS OSMC PUBLIC LICENSE (OSMC-PL).
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES RECIPIENT'S
+ * ACCEPTANCE OF THE OSMC PUBLIC LICENSE.
+ *
+ * The OpenModelica software and the Open Source Modelica
+ * Consortium (OSMC) Public License (OSMC-PL) are obtained
+ * from Linköping University, either from the above address,
+ * from the URLs: http://www.ida.liu.se/projects/OpenModelica or
+ * http://www.openmodelica.org, and in the OpenModelica distribution.
+ * GNU version 3 is obtained from: http://www.gnu.org/copyleft/gpl.html.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without
+ * even the implied warranty of  MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE, EXCEPT AS EXPRESSLY SET FORTH
+ * IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE CONDITIONS
+ * OF OSMC-PL.
+ *
+ * See the full OSMC Public License conditions for more details.
+ *
+ */
+
+/*
+ Work-stealing executor for the clustered task system. Uses only the
+ standard library threads, i.e., it does not need TBB.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "pm_clustering.hpp"
+
+namespace openmodelica { namespace parmodelica {
+
+/*! The ready clusters of one worker. The owner pushes and pops at the back
+  (the newest cluster, whose inputs are most likely still in cache). Idle
+  workers steal from the front. */
+struct StealingQueue {
+    std::mutex       lock;
+    std::deque<long> ready;
+
+    void push(long clust) {
+        std::lock_guard<std::mutex> guard(lock);
+        ready.push_back(clust);
+    }
+
+    bool pop(long& clust) {
+        std::lock_guard<std::mutex> guard(lock);
+        if (ready.empty())
+            return false;
+        clust = ready.back();
+        ready.pop_back();
+        return true;
+    }
+
+    bool steal(long& clust) {
+        std::lock_guard<std::mutex> guard(lock);
+        if (ready.empty())
+            return false;
+        clust = ready.front();
+        ready.pop_front();
+        return true;
+    }
+};
+
+template <typename TaskType,
+          typename clustetring1 = cluster_merge_common,        /* same defaults as StepLevels */
+          typename clustetring2 = cluster_merge_level_for_bins>
+class ClusterStealingScheduler : boost::noncopyable {
+  public:
+    typedef TaskSystem_v2<TaskType>                TaskSystemType;
+    typedef typename TaskSystemType::GraphType     GraphType;
+    typedef typename TaskSystemType::ClusterType   ClusterType;
+    typedef typename TaskSystemType::ClusterIdType ClusterIdType;
+
+    typedef typename TaskType::FunctionType FunctionType;
+
+  private:
+    /*! The clustered graph flattened to plain indices. Rebuilt on every
+      (re)schedule so that an evaluation never walks the boost graph. */
+    std::vector<ClusterType*>            clusters;
+    std::vector<std::vector<long>>       children;
+    std::vector<long>                    nr_of_parents;
+    std::vector<long>                    root_clusters;
+    std::unique_ptr<std::atomic<long>[]> pending_parents;
+
+    /*! Cost of each cluster when the current schedule was made. */
+    std::vector<double> scheduled_costs;
+    /*! Measured cost of each task (smoothed), indexed by task_id. */
+    std::vector<double> task_costs;
+
+    std::vector<std::unique_ptr<StealingQueue>> queues;
+    std::vector<std::thread>                    workers;
+
+    std::mutex              pool_lock;
+    std::condition_variable pool_wake;
+    std::atomic<unsigned>   generation;
+    std::atomic<bool>       stop;
+    std::atomic<long>       remaining_clusters;
+    std::atomic<long>       busy_workers;
+    bool                    profile_step;
+
+  public:
+    size_t max_num_threads;
+
+    const TaskSystemType& task_system_org;
+    TaskSystemType        task_system;
+
+    bool schedule_available;
+
+    /*! Every profile_interval-th parallel evaluation measures the cost of each
+      task. If the measured costs moved more than reschedule_threshold
+      (relative) away from the costs the clustering was based on, the original
+      task system is clustered again with the measured costs. */
+    int    profile_interval;
+    double reschedule_threshold;
+    /*! How often an idle worker yields before it goes to sleep. */
+    int spin_count;
+
+    int total_evaluations;
+    int parallel_evaluations;
+    int sequential_evaluations;
+    int profiled_evaluations;
+    int nr_of_reschedules;
+
+    PMTimer execution_timer;
+    PMTimer clustering_timer;
+
+    ClusterStealingScheduler(TaskSystemType& ts, size_t mnt)
+        : generation(0)
+        , stop(false)
+        , remaining_clusters(0)
+        , busy_workers(0)
+        , profile_step(false)
+        , max_num_threads(mnt ? mnt : 1)
+        , task_system_org(ts)
+        , task_system("invalid", mnt) // implement a constrctor with no parameters and remove this
+    {
+        schedule_available = false;
+
+        profile_interval = 1000;
+        reschedule_threshold = 0.5;
+        spin_count = 10000;
+
+        total_evaluations = 0;
+        parallel_evaluations = 0;
+        sequential_evaluations = 0;
+        profiled_evaluations = 0;
+        nr_of_reschedules = 0;
+    }
+
+    ~ClusterStealingScheduler() {
+        {
+            std::lock_guard<std::mutex> guard(pool_lock);
+            stop.store(true);
+        }
+        pool_wake.notify_all();
+        for (size_t i = 0; i < workers.size(); ++i)
+            workers[i].join();
+    }
+
+    void execute() {
+        if (!this->schedule_available)
+            return execute_and_schedule();
+
+        bool profile = profile_interval > 0 && parallel_evaluations > 0 && parallel_evaluations % profile_interval == 0;
+
+        execution_timer.start_timer();
+        run_parallel(profile);
+        execution_timer.stop_timer();
+
+        ++this->total_evaluations;
+        ++this->parallel_evaluations;
+
+        if (profile) {
+            ++this->profiled_evaluations;
+            if (costs_drifted())
+                reschedule();
+        }
+    }
+
+    /*! First evaluation. Runs the unclustered system sequentially, measuring
+      every task, and clusters it with the measured costs. */
+    void execute_and_schedule() {
+        task_system = task_system_org;
+
+        GraphType& sys_graph = task_system.sys_graph;
+
+        typename GraphType::vertex_iterator vert_iter, vert_end;
+        boost::tie(vert_iter, vert_end) = vertices(sys_graph);
+
+        execution_timer.start_timer();
+        /*! skip the root node. */
+        ++vert_iter;
+        for (; vert_iter != vert_end; ++vert_iter) {
+            sys_graph[*vert_iter].profile_execute();
+        }
+        execution_timer.stop_timer();
+
+        ++this->total_evaluations;
+        ++this->sequential_evaluations;
+
+        collect_task_costs(1.0);
+        schedule();
+    }
+
+    void schedule() {
+        clustering_timer.start_timer();
+
+        if (task_system.levels_valid == false)
+            task_system.update_node_levels();
+
+        clustetring1::apply(task_system);
+        clustetring2::apply(task_system);
+
+        task_system.levels_valid = false;
+        task_system.update_node_levels();
+
+        flatten_graph();
+        start_workers();
+
+        schedule_available = true;
+        clustering_timer.stop_timer();
+    }
+
+  private:
+    /*! Re-clusters the original task system with the measured task costs. */
+    void reschedule() {
+        task_system = task_system_org;
+
+        GraphType& sys_graph = task_system.sys_graph;
+
+        typename GraphType::vertex_iterator vert_iter, vert_end;
+        boost::tie(vert_iter, vert_end) = vertices(sys_graph);
+        /*! skip the root node. */
+        ++vert_iter;
+        for (; vert_iter != vert_end; ++vert_iter) {
+            ClusterType& curr_clust = sys_graph[*vert_iter];
+            curr_clust.cost = 0;
+            typename ClusterType::iterator task_iter;
+            for (task_iter = curr_clust.begin(); task_iter != curr_clust.end(); ++task_iter) {
+                task_iter->cost = task_costs[task_iter->task_id];
+                curr_clust.cost += task_iter->cost;
+            }
+        }
+
+        schedule();
+        ++this->nr_of_reschedules;
+    }
+
+    /*! Copies the task costs measured by the last profiled evaluation into
+      task_costs. weight is the weight of the new measurement relative to the
+      previous ones. */
+    void collect_task_costs(double weight) {
+        GraphType& sys_graph = task_system.sys_graph;
+
+        typename GraphType::vertex_iterator vert_iter, vert_end;
+        boost::tie(vert_iter, vert_end) = vertices(sys_graph);
+        /*! skip the root node. */
+        ++vert_iter;
+        for (; vert_iter != vert_end; ++vert_iter) {
+            ClusterType& curr_clust = sys_graph[*vert_iter];
+            typename ClusterType::iterator task_iter;
+            for (task_iter = curr_clust.begin(); task_iter != curr_clust.end(); ++task_iter) {
+                size_t id = task_iter->task_id;
+                if (id >= task_costs.size())
+                    task_costs.resize(id + 1, 0);
+                task_costs[id] = weight * task_iter->cost + (1 - weight) * task_costs[id];
+            }
+        }
+    }
+
+    bool costs_drifted() {
+        collect_task_costs(0.5);
+
+        double total_scheduled = 0;
+        double total_change = 0;
+        for (size_t i = 0; i < clusters.size(); ++i) {
+            double measured = 0;
+            typename ClusterType::iterator task_iter;
+            for (task_iter = clusters[i]->begin(); task_iter != clusters[i]->end(); ++task_iter) {
+                measured += task_costs[task_iter->task_id];
+            }
+            total_scheduled += scheduled_costs[i];
+            total_change += std::abs(measured - scheduled_costs[i]);
+        }
+
+        if (total_scheduled <= 0)
+            return total_change > 0;
+        return total_change / total_scheduled > reschedule_threshold;
+    }
+
+    void flatten_graph() {
+        GraphType&     sys_graph = task_system.sys_graph;
+
+        /*! listS has no vertex index. Number the clusters here. */
+        std::map<ClusterIdType, long> cluster_index;
+
+        clusters.clear();
+        typename GraphType::vertex_iterator vert_iter, vert_end;
+        boost::tie(vert_iter, vert_end) = vertices(sys_graph);
+        /*! skip the root node. */
+        ++vert_iter;
+        for (; vert_iter != vert_end; ++vert_iter) {
+            cluster_index.insert(std::make_pair(*vert_iter, (long)clusters.size()));
+            clusters.push_back(&sys_graph[*vert_iter]);
+        }
+
+        size_t nr_of_clusters = clusters.size();
+        children.assign(nr_of_clusters, std::vector<long>());
+        nr_of_parents.assign(nr_of_clusters, 0);
+        scheduled_costs.resize(nr_of_clusters);
+        root_clusters.clear();
+        pending_parents.reset(new std::atomic<long>[nr_of_clusters]);
+
+        boost::tie(vert_iter, vert_end) = vertices(sys_graph);
+        ++vert_iter;
+        for (; vert_iter != vert_end; ++vert_iter) {
+            long curr_index = cluster_index[*vert_iter];
+            scheduled_costs[curr_index] = clusters[curr_index]->cost;
+
+            typename GraphType::adjacency_iterator child_iter, child_end;
+            boost::tie(child_iter, child_end) = adjacent_vertices(*vert_iter, sys_graph);
+            for (; child_iter != child_end; ++child_iter) {
+                long child_index = cluster_index[*child_iter];
+                children[curr_index].push_back(child_index);
+                ++nr_of_parents[child_index];
+            }
+        }
+
+        /*! Clusters without a parent, i.e., the children of the root node. */
+        for (size_t i = 0; i < nr_of_clusters; ++i) {
+            if (nr_of_parents[i] == 0)
+                root_clusters.push_back(i);
+        }
+
+        /*! Start the most expensive clusters first. */
+        std::sort(root_clusters.begin(), root_clusters.end(),
+                  [this](long lhs, long rhs) { return clusters[lhs]->cost > clusters[rhs]->cost; });
+    }
+
+    void start_workers() {
+        if (!queues.empty())
+            return;
+
+        for (size_t i = 0; i < max_num_threads; ++i)
+            queues.push_back(std::unique_ptr<StealingQueue>(new StealingQueue()));
+
+        /*! The calling thread is worker 0. */
+        for (size_t i = 1; i < max_num_threads; ++i)
+            workers.push_back(std::thread(&ClusterStealingScheduler::worker_loop, this, (long)i));
+    }
+
+    void run_parallel(bool profile) {
+        profile_step = profile;
+
+        for (size_t i = 0; i < clusters.size(); ++i)
+            pending_parents[i].store(nr_of_parents[i], std::memory_order_relaxed);
+
+        for (size_t i = 0; i < root_clusters.size(); ++i)
+            queues[i % queues.size()]->push(root_clusters[i]);
+
+        remaining_clusters.store(clusters.size(), std::memory_order_relaxed);
+        busy_workers.store(workers.size(), std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> guard(pool_lock);
+            generation.fetch_add(1, std::memory_order_release);
+        }
+        pool_wake.notify_all();
+
+        work(0);
+
+        /*! The workers may still be looking for work. Wait until they are out
+          before the counters are touched again. */
+        while (busy_workers.load(std::memory_order_acquire) != 0)
+            std::this_thread::yield();
+    }
+
+    void worker_loop(long worker_id) {
+        unsigned seen = 0;
+        while (true) {
+            /*! Evaluations usually follow each other quickly. Spin for a while
+              before going to sleep. */
+            for (int i = 0; i < spin_count; ++i) {
+                if (generation.load(std::memory_order_acquire) != seen || stop.load(std::memory_order_acquire))
+                    break;
+                std::this_thread::yield();
+            }
+
+            {
+                std::unique_lock<std::mutex> guard(pool_lock);
+                pool_wake.wait(guard, [this, seen] {
+                    return generation.load(std::memory_order_acquire) != seen || stop.load(std::memory_order_acquire);
+                });
+            }
+
+            if (stop.load(std::memory_order_acquire))
+                return;
+
+            seen = generation.load(std::memory_order_acquire);
+            work(worker_id);
+            busy_workers.fetch_sub(1, std::memory_order_release);
+        }
+    }
+
+    void work(long worker_id) {
+        long clust;
+        while (remaining_clusters.load(std::memory_order_acquire) > 0) {
+            if (queues[worker_id]->pop(clust) || steal(worker_id, clust))
+                run_cluster(clust, worker_id);
+            else
+                std::this_thread::yield();
+        }
+    }
+
+    bool steal(long worker_id, long& clust) {
+        size_t nr_of_queues = queues.size();
+        for (size_t i = 1; i < nr_of_queues; ++i) {
+            if (queues[(worker_id + i) % nr_of_queues]->steal(clust))
+                return true;
+        }
+        return false;
+    }
+
+    void run_cluster(long clust, long worker_id) {
+        if (profile_step)
+            clusters[clust]->profile_execute();
+        else
+            clusters[clust]->execute();
+
+        /*! Push the children that became ready before this cluster is counted
+          as done. Otherwise the others could see no remaining work while a
+          ready child is still on its way to the queue. */
+        const std::vector<long>& clust_children = children[clust];
+        for (size_t i = 0; i < clust_children.size(); ++i) {
+            if (pending_parents[clust_children[i]].fetch_sub(1, std::memory_order_acq_rel) == 1)
+                queues[worker_id]->push(clust_children[i]);
+        }
+
+        remaining_clusters.fetch_sub(1, std::memory_order_acq_rel);
+    }
+};
+
+}} // namespace openmodelica::parmodelica
+
+#endif // header
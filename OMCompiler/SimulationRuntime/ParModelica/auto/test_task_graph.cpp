@@ -30,64 +30,173 @@
  */
 
 /*
- Mahder.Gebremedhin@liu.se  2020-10-12
+ Benchmark of the schedulers on a synthetic task graph.
+
+   gen_graph [nr_of_tasks] [nr_of_threads] [nr_of_evaluations]
+
+ Every scheduler evaluates the same graph. Each task checks that all the
+ tasks it depends on have already run in the current evaluation. Halfway
+ through, the cost of some tasks is changed so that the clustering made
+ from the first measurements is no longer good.
 */
 
-// #include <pm_task_system.hpp>
-// #include <pm_level_scheduler.hpp>
-#include "om_pm_model.hpp"
-// #include <pm_graph_dump.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
 
+#include <tbb/task_arena.h>
+
+#include "pm_cluster_dynamic_scheduler.hpp"
 #include "pm_cluster_level_scheduler.hpp"
-#include "pm_cluster_system.hpp"
+#include "pm_cluster_stealing_scheduler.hpp"
 
 using namespace openmodelica::parmodelica;
 
-int main(int argc, char** argv) {
+/*! Indexed by task index. Kept outside of the tasks since the task systems
+  store copies of them. */
+std::vector<long> task_work;
+std::vector<long> task_stamp;
+long              current_evaluation = 0;
+std::atomic<long> order_errors(0);
+long              total_order_errors = 0;
 
-    // typedef LevelSchedulerThreadAware<Equation> LevelScheduler;
-
-    std::string xml_file = argv[1];
-    std::cout << "Reading file: " << xml_file << std::endl;
-
-    std::string eq_to_read;
-    if (argc == 3) {
-        eq_to_read = argv[2];
-        std::cout << "Reading eqs: " << eq_to_read << std::endl;
-    }
-    else
-        eq_to_read = "ode-equations";
+struct BenchTask : public TaskNode {
+    typedef void (*FunctionType)(void*);
 
-    TaskSystem_v2<Equation> task_system;
-    task_system.load_from_xml(xml_file, eq_to_read);
+    long              index;
+    std::vector<long> inputs;
 
-    // task_system.cluster_merge_level_parents();
-    // task_system.cluster_merge_single_parent();
-    // task_system.cluster_merge_level_for_cost();
-    // task_system.cluster_merge_level_parents();
+    BenchTask() : TaskNode(), index(-1) {}
 
-    StepLevels<Equation> level_scheduler(task_system);
-    level_scheduler.schedule();
-    // level_scheduler.execute(NULL, NULL);
+    bool depends_on(const TaskNode& other_b) const {
+        const BenchTask& other = static_cast<const BenchTask&>(other_b);
+        return std::binary_search(inputs.begin(), inputs.end(), other.index);
+    }
 
-    task_system.dump_graphml(xml_file + "_" + eq_to_read);
+    void execute() {
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            if (task_stamp[inputs[i]] != current_evaluation)
+                ++order_errors;
+        }
 
-    // TaskSystem<Equation> task_system;
-    // task_system.load_from_xml(xml_file, eq_to_read);
-    // task_system.construct_graph();
+        volatile double x = 1.0;
+        for (long i = 0; i < task_work[index]; ++i)
+            x = x * 1.0000001 + 1e-9;
 
-    // dump_graphml(task_system, xml_file + "_" + eq_to_read);
+        task_stamp[index] = current_evaluation;
+    }
+};
+
+typedef TaskSystem_v2<BenchTask> BenchTaskSystem;
+
+void build_graph(BenchTaskSystem& task_system, long nr_of_tasks) {
+    std::srand(42);
+    task_work.resize(nr_of_tasks);
+    task_stamp.assign(nr_of_tasks, -1);
+
+    const long window = 64;
+    for (long i = 0; i < nr_of_tasks; ++i) {
+        BenchTask task;
+        task.index = i;
+        task_work[i] = 200 + std::rand() % 5000;
+
+        if (i > 0 && std::rand() % 10 != 0) {
+            int nr_of_inputs = 1 + std::rand() % 3;
+            for (int k = 0; k < nr_of_inputs; ++k)
+                task.inputs.push_back(std::max(0L, i - 1 - std::rand() % window));
+            std::sort(task.inputs.begin(), task.inputs.end());
+            task.inputs.erase(std::unique(task.inputs.begin(), task.inputs.end()), task.inputs.end());
+        }
+
+        task_system.add_node(task);
+    }
+}
+
+void change_costs(long nr_of_tasks) {
+    for (long i = 0; i < nr_of_tasks; i += 10)
+        task_work[i] *= 10;
+}
+
+void restore_costs(long nr_of_tasks) {
+    for (long i = 0; i < nr_of_tasks; i += 10)
+        task_work[i] /= 10;
+}
+
+template <typename SchedulerType>
+double run(SchedulerType& scheduler, long nr_of_tasks, int nr_of_evaluations) {
+    PMTimer timer;
+    order_errors = 0;
+    timer.start_timer();
+    for (int i = 0; i < nr_of_evaluations; ++i) {
+        if (i == nr_of_evaluations / 2)
+            change_costs(nr_of_tasks);
+        ++current_evaluation;
+        scheduler.execute();
+    }
+    timer.stop_timer();
+    restore_costs(nr_of_tasks);
+    return timer.get_elapsed_time();
+}
+
+struct SequentialExecutor {
+    BenchTaskSystem& task_system;
+    SequentialExecutor(BenchTaskSystem& ts) : task_system(ts) {}
+
+    void execute() {
+        BenchTaskSystem::vertex_iterator vert_iter, vert_end;
+        boost::tie(vert_iter, vert_end) = vertices(task_system.sys_graph);
+        /*! skip the root node. */
+        ++vert_iter;
+        for (; vert_iter != vert_end; ++vert_iter)
+            task_system.sys_graph[*vert_iter].execute();
+    }
+};
 
-    // LevelScheduler level_scheduler(task_system);
-    // level_scheduler.schedule(4);
-    // level_scheduler.print_schedule(std::cout);
+void report(const std::string& name, double elapsed, int nr_of_evaluations, double sequential) {
+    std::cout << name << " : total " << elapsed << " ms : per evaluation " << elapsed / nr_of_evaluations
+              << " ms : speedup " << sequential / elapsed << " : order errors " << order_errors << std::endl;
+    total_order_errors += order_errors;
+}
 
-    std::cout << utility::log_stream.str();
-    // std::cout << "system cost = " << task_system.total_cost << std::endl;
-    // std::cout << "scheduler cost = " << level_scheduler.total_parallel_cost << std::endl;
-    // std::cout << "Peak speedup = " << task_system.total_cost/level_scheduler.total_parallel_cost << std::endl;
+int main(int argc, char** argv) {
 
-    // DynamicScheduler<Equation> dyn_scheduler(task_system);
-    // dyn_scheduler.schedule(4);
-    // dyn_scheduler.execute();
-}
\ No newline at end of file
+    long nr_of_tasks = argc > 1 ? std::atol(argv[1]) : 2000;
+    int  nr_of_threads = argc > 2 ? std::atoi(argv[2]) : 4;
+    int  nr_of_evaluations = argc > 3 ? std::atoi(argv[3]) : 2000;
+
+    BenchTaskSystem task_system("bench", nr_of_threads);
+    build_graph(task_system, nr_of_tasks);
+    std::cout << "Tasks: " << nr_of_tasks << " Threads: " << nr_of_threads << " Evaluations: " << nr_of_evaluations
+              << std::endl;
+
+    SequentialExecutor sequential(task_system);
+    double             seq_time = run(sequential, nr_of_tasks, nr_of_evaluations);
+    report("sequential", seq_time, nr_of_evaluations, seq_time);
+
+    tbb::task_arena arena(nr_of_threads);
+
+    double level_time = 0;
+    arena.execute([&] {
+        StepLevels<BenchTask> level_scheduler(task_system, nr_of_threads);
+        level_time = run(level_scheduler, nr_of_tasks, nr_of_evaluations);
+    });
+    report("level", level_time, nr_of_evaluations, seq_time);
+
+    double dynamic_time = 0;
+    arena.execute([&] {
+        ClusterDynamicScheduler<BenchTask> dynamic_scheduler(task_system, nr_of_threads);
+        dynamic_time = run(dynamic_scheduler, nr_of_tasks, nr_of_evaluations);
+    });
+    report("dynamic", dynamic_time, nr_of_evaluations, seq_time);
+
+    ClusterStealingScheduler<BenchTask> stealing_scheduler(task_system, nr_of_threads);
+    /*! Measure often enough to notice the cost change within the run. */
+    stealing_scheduler.profile_interval = std::max(1, nr_of_evaluations / 20);
+    double stealing_time = run(stealing_scheduler, nr_of_tasks, nr_of_evaluations);
+    report("stealing", stealing_time, nr_of_evaluations, seq_time);
+    std::cout << "stealing : re-clusterings " << stealing_scheduler.nr_of_reschedules << std::endl;
+
+    return total_order_errors != 0;
+}
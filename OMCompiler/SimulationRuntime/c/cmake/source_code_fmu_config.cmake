@@ -21,6 +21,7 @@ set(SOURCE_FMU_COMMON_FILES_LIST ./gc/memory_pool.c
                                  ./util/division.c
                                  ./util/doubleEndedList.c
                                  ./util/generic_array.c
+                                 ./util/index_set.c
                                  ./util/index_spec.c
                                  ./util/integer_array.c
                                  ./util/list.c
@@ -42,6 +43,7 @@ set(SOURCE_FMU_COMMON_FILES_LIST ./gc/memory_pool.c
                                  ./util/utility.c
                                  ./util/varinfo.c
                                  ./math-support/pivot.c
+                                 ./simulation/jacobian_cache.c
                                  ./simulation/jacobian_util.c
                                  ./simulation/omc_simulation_util.c
                                  ./simulation/options.c
@@ -49,6 +51,7 @@ set(SOURCE_FMU_COMMON_FILES_LIST ./gc/memory_pool.c
                                  ./simulation/simulation_omc_assert.c
                                  ./simulation/solver/delay.c
                                  ./simulation/solver/fmi_events.c
+                                 ./simulation/solver/masked_eval.c
                                  ./simulation/solver/model_help.c
                                  ./simulation/solver/omc_math.c
                                  ./simulation/solver/spatialDistribution.c
@@ -79,6 +82,7 @@ set(SOURCE_FMU_COMMON_HEADERS \"./omc_inline.h\",
                               \"./optimization/OptimizerData.h\",
                               \"./optimization/OptimizerLocalFunction.h\",
                               \"./optimization/OptimizerInterface.h\",
+                              \"./simulation/jacobian_cache.h\",
                               \"./simulation/jacobian_util.h\",
                               \"./simulation/modelinfo.h\",
                               \"./simulation/options.h\",
@@ -97,17 +101,21 @@ set(SOURCE_FMU_COMMON_HEADERS \"./omc_inline.h\",
                               \"./simulation/solver/events.h\",
                               \"./simulation/solver/external_input.h\",
                               \"./simulation/solver/fmi_events.h\",
+                              \"./simulation/solver/ida_precond.h\",
                               \"./simulation/solver/ida_solver.h\",
                               \"./simulation/solver/linearSolverLapack.h\",
                               \"./simulation/solver/linearSolverTotalPivot.h\",
                               \"./simulation/solver/linearSystem.h\",
+                              \"./simulation/solver/masked_eval.h\",
                               \"./simulation/solver/mixedSearchSolver.h\",
                               \"./simulation/solver/mixedSystem.h\",
                               \"./simulation/solver/model_help.h\",
                               \"./simulation/solver/nonlinearSolverHomotopy.h\",
+                              \"./simulation/solver/nonlinearSolverHomotopySparse.h\",
                               \"./simulation/solver/nonlinearSolverHybrd.h\",
                               \"./simulation/solver/nonlinearSystem.h\",
                               \"./simulation/solver/nonlinearValuesList.h\",
+                              \"./simulation/solver/nonlinearWorkspace.h\",
                               \"./simulation/solver/omc_math.h\",
                               \"./simulation/solver/perform_qss_simulation.c.inc\",
                               \"./simulation/solver/perform_simulation.c.inc\",
@@ -133,6 +141,7 @@ set(SOURCE_FMU_COMMON_HEADERS \"./omc_inline.h\",
                               \"./util/context.h\",
                               \"./util/division.h\",
                               \"./util/generic_array.h\",
+                              \"./util/index_set.h\",
                               \"./util/index_spec.h\",
                               \"./util/integer_array.h\",
                               \"./util/java_interface.h\",
@@ -191,7 +200,7 @@ string(REPLACE ";" "," SOURCE_FMU_DGESV_FILES "${SOURCE_FMU_DGESV_FILES_LIST_QUO
 ######################################################################################################################
 ## Non-linear system files
 
-set(SOURCE_FMU_NLS_FILES_LIST simulation/solver/nonlinearSolverHomotopy.c simulation/solver/nonlinearSolverHybrd.c simulation/solver/nonlinearValuesList.c simulation/solver/nonlinearSystem.c)
+set(SOURCE_FMU_NLS_FILES_LIST simulation/solver/nonlinearSolverHomotopy.c simulation/solver/nonlinearSolverHomotopySparse.c simulation/solver/nonlinearSolverHybrd.c simulation/solver/nonlinearValuesList.c simulation/solver/nonlinearSystem.c simulation/solver/nonlinearWorkspace.c)
 
 foreach(source_file ${SOURCE_FMU_NLS_FILES_LIST})
   list(APPEND SOURCE_FMU_NLS_FILES_LIST_QUOTED \"${source_file}\")
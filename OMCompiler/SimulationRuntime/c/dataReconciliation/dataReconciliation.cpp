@@ -39,6 +39,7 @@
 #include <string>
 #include <fstream>
 #include <vector>
+#include <map>
 #include <algorithm>
 #include <iomanip>
 #include <stdlib.h>
@@ -47,8 +48,17 @@
 #include <regex>
 #include "omc_config.h"
 #include "../util/omc_file.h"
+#include "../util/read_csv.h"
 #include <cmath>
 #include "dataReconciliation.h"
+
+#ifdef WITH_SUITESPARSE
+extern "C"
+{
+#include <klu.h>
+}
+#endif
+
 using namespace std;
 
 extern "C"
@@ -133,6 +143,56 @@ struct boundaryConditionData
   double *reconSt_diag;
 };
 
+/*
+ * Sparse matrix in compressed sparse column format,
+ * leadindex has column+1 entries and index holds the
+ * row numbers of the nonzero elements in data
+ */
+struct sparseMatrixData
+{
+  int rows;
+  int column;
+  int nnz;
+  int * leadindex;
+  int * index;
+  double * data;
+};
+
+#ifdef WITH_SUITESPARSE
+/*
+ * Workspace of the sparse formulation which holds the Jacobian F
+ * linearized at the operating point xF, the products G = Sx*Ft and
+ * M = F*Sx*Ft in compressed sparse column format and the KLU
+ * factorization of M, it is reused as long as the operating point
+ * changes little, the patterns of G and M are fixed by F and Sx
+ */
+struct sparseReconciliationData
+{
+  ANALYTIC_JACOBIAN * jacobian;
+  sparseMatrixData F;
+  sparseMatrixData Sx;    // covariance matrix of the variables of interest
+  sparseMatrixData G;     // Sx*Ft (nx x nc)
+  sparseMatrixData M;     // F*Sx*Ft (nc x nc)
+  int * Frows;            // row pointers of F (nc+1), the rows are needed to assemble G
+  int * Fcols;            // column numbers of the nonzero elements of F stored row by row
+  int * Fpos;             // position of these elements in F.data
+  int nx;                 // number of variables of interest
+  int nc;                 // number of setc equations
+  bool sxDiagonal;        // Sx has no correlation coefficients
+  double * sxDiag;        // diagonal elements of Sx
+  double * xF;            // operating point of F and the factorization
+  double * reconSxDiag;   // diagonal elements of Sx - (Sx*Ft*F*)
+  bool reconSxDiagValid;  // reconSxDiag belongs to the current factorization
+  double * work;          // dense work vector of size max(nx, nc)
+  klu_common common;
+  klu_symbolic * symbolicM;
+  klu_numeric * numericM;
+  klu_symbolic * symbolicSx;  // factorization of Sx, only if Sx is not diagonal
+  klu_numeric * numericSx;
+  int factorizations;
+};
+#endif
+
 void copyReferenceFile(DATA * data, const std::string & filename)
 {
   std::string outputPath = std::string(omc_flagValue[FLAG_OUTPUT_PATH]) + "/" + std::string(data->modelData->modelFilePrefix) + filename;
@@ -2417,6 +2477,131 @@ void checkInExpensiveMatrixInverse(ofstream & logfile, DATA * data)
   //printMatrix(checksx,3,1,"InExpensive_Matrix_Inverse");
 }
 
+/*
+ * Function which prints the final results, computes the
+ * half width confidence intervals and the individual tests
+ * and creates the html report, used by the dense and the
+ * sparse formulation of the Data Reconciliation, the sparse
+ * formulation passes reconciled_Sx without data and only
+ * the diagonal elements in reconSx_diag
+ */
+void finishReconciliation(DATA *data, matrixData reconciled_X, matrixData reconciled_Sx, double * reconSx_diag, double value, double J, double eps, int iterationcount, csvData csvinputs, matrixData xdiag, matrixData sxdiag, ofstream &logfile, correlationDataWarning & warningCorrelationData, dataReconciliationData& datareconciliationdata)
+{
+  logfile << "Final Results:\n";
+  logfile << "=============\n";
+  logfile << "Total Iteration to Converge               : " << iterationcount << "\n";
+  logfile << "Final Converged Value(J*/r)               : " << value << "\n";
+  logfile << "Final value of the objective function (J) : " << J << "\n";
+  logfile << "Epsilon                                   : " << eps << "\n";
+  printMatrixWithHeaders(reconciled_X.data, reconciled_X.rows, reconciled_X.column, csvinputs.headers, "reconciled_X ===> (x - (Sx*Ft*fstar))", logfile);
+
+  matrixData copyReconciledSx = {reconciled_Sx.rows, reconciled_Sx.column, NULL};
+  if (reconciled_Sx.data != NULL)
+  {
+    printMatrixWithHeaders(reconciled_Sx.data, reconciled_Sx.rows, reconciled_Sx.column, csvinputs.headers, "reconciled_Sx ===> (Sx - (Sx*Ft*Fstar))", logfile);
+    dumpReconciledSxToCSV(reconciled_Sx.data, reconciled_Sx.rows, reconciled_Sx.column, csvinputs.headers, data);
+
+    // copy the reconciledSx matrix for state Estimation
+    copyReconciledSx = copyMatrix(reconciled_Sx);
+
+    /*
+     * Calculate half width Confidence interval
+     * W=lambda*sqrt(Sx)
+     * where lamba = 1.96 and
+     * Sx - diagonal elements of reconciled_Sx
+     */
+    reconSx_diag = (double*) calloc (reconciled_Sx.rows * 1, sizeof(double));
+    getDiagonalElements(reconciled_Sx.data, reconciled_Sx.rows, reconciled_Sx.column, reconSx_diag);
+  }
+  else
+  {
+    printMatrixWithHeaders(reconSx_diag, reconciled_Sx.rows, 1, csvinputs.headers, "reconciled_Sx_Diagonal ===> diag(Sx - (Sx*Ft*Fstar))", logfile);
+    logfile << "|  info    |   " << "The sparse formulation computes the diagonal elements of reconciled_Sx only, " << data->modelData->modelName << "_Reconciled_Sx.csv is not written\n";
+  }
+
+  matrixData copyreconSx_diag = {reconciled_Sx.rows, 1, reconSx_diag};
+  matrixData tmpcopyreconSx_diag = copyMatrix(copyreconSx_diag);
+
+  if (ACTIVE_STREAM(LOG_JAC))
+  {
+    logfile << "Calculations of HalfWidth Confidence Interval " << "\n";
+    logfile << "===============================================\n";
+    printMatrix(copyreconSx_diag.data, reconciled_Sx.rows, 1, "reconciled-Sx_Diagonal", logfile);
+  }
+
+  calculateSquareRoot(copyreconSx_diag.data, reconciled_Sx.rows);
+
+  if (ACTIVE_STREAM(LOG_JAC))
+  {
+    printMatrix(copyreconSx_diag.data, reconciled_Sx.rows, 1, "reconciled-Sx_SquareRoot", logfile);
+    logfile << "*****Completed***********\n";
+  }
+
+  scaleVector(reconciled_Sx.rows, 1, 1.96, copyreconSx_diag.data);
+  printMatrixWithHeaders(copyreconSx_diag.data, reconciled_Sx.rows, 1, csvinputs.headers, "Wx-HalfWidth-Interval-(1.96)*sqrt(Sx_diagonal)", logfile);
+
+  /*
+   * Calculate individual tests
+   * (recon_x - x)/sqrt(Sx-recon_Sx)
+   */
+  double *newSx_diag = (double*) calloc (reconciled_Sx.rows * 1, sizeof(double));
+  solveMatrixSubtraction(sxdiag, tmpcopyreconSx_diag, newSx_diag, logfile, data);
+
+  if (ACTIVE_STREAM(LOG_JAC))
+  {
+    logfile << "Calculations of Individual Tests " << "\n";
+    logfile << "===============================================\n";
+    printMatrix(newSx_diag, sxdiag.rows, sxdiag.column, "Sx-recon_Sx", logfile);
+  }
+
+  calculateSquareRoot(newSx_diag, reconciled_Sx.rows);
+
+  if (ACTIVE_STREAM(LOG_JAC))
+  {
+    printMatrix (newSx_diag, sxdiag.rows, sxdiag.column, "squareroot-newSx", logfile);
+  }
+
+  double *newX = (double*) calloc (xdiag.rows * 1, sizeof(double));
+  solveMatrixSubtraction(reconciled_X, xdiag, newX, logfile, data);
+
+  // calculate absolute value for this numeric analysis
+  for (int a = 0; a < xdiag.rows; a++)
+  {
+    newX[a] = fabs (newX[a]);
+  }
+
+  if (ACTIVE_STREAM(LOG_JAC))
+  {
+    printMatrix(newX, xdiag.rows, xdiag.column, "recon_X - X", logfile);
+    logfile << "*********Completed***********\n";
+  }
+
+  for (int val = 0; val < xdiag.rows; val++)
+  {
+    newX[val] = newX[val] / max(newSx_diag[val], sqrt(sxdiag.data[val] / 10));
+  }
+
+  printMatrixWithHeaders(newX, xdiag.rows, xdiag.column, csvinputs.headers, "IndividualTests_Value- (recon_x-x)/sqrt(Sx_diag)", logfile);
+
+  // copy the outputs for state Estimation
+  if (omc_flag[FLAG_DATA_RECONCILE_STATE])
+    datareconciliationdata = {csvinputs, xdiag, reconciled_X, copyReconciledSx, copyreconSx_diag, newX, eps, iterationcount, value, J, warningCorrelationData};
+
+  boundaryConditionData boundaryconditiondata;
+  // create HTML Report for D.1
+  if (omc_flag[FLAG_DATA_RECONCILE])
+  {
+    createHtmlReportFordataReconciliation(data, csvinputs, xdiag, reconciled_X, copyreconSx_diag, newX, eps, iterationcount, value, J, warningCorrelationData, boundaryconditiondata);
+    // free the memory for data Reconciliation
+    free(reconciled_Sx.data);
+    free(reconciled_X.data);
+    free(copyreconSx_diag.data);
+    free(tmpcopyreconSx_diag.data);
+    free(newSx_diag);
+    free(newX);
+  }
+}
+
 int RunReconciliation(DATA *data, threadData_t *threadData, inputData x, matrixData Sx, matrixData tmpjacF, matrixData tmpjacFt, double eps, int iterationcount, csvData csvinputs, matrixData xdiag, matrixData sxdiag, ofstream &logfile, correlationDataWarning & warningCorrelationData, dataReconciliationData& datareconciliationdata)
 {
   // set the inputs from csv file to simulationInfo datainputVars
@@ -2578,151 +2763,962 @@ int RunReconciliation(DATA *data, threadData_t *threadData, inputData x, matrixD
 
   double J = calculateQualityValue(reconciled_X, Sx, csvinputs, logfile, data);
 
-  logfile << "Final Results:\n";
-  logfile << "=============\n";
-  logfile << "Total Iteration to Converge               : " << iterationcount << "\n";
-  logfile << "Final Converged Value(J*/r)               : " << value << "\n";
-  logfile << "Final value of the objective function (J) : " << J << "\n";
-  logfile << "Epsilon                                   : " << eps << "\n";
-  printMatrixWithHeaders(reconciled_X.data, reconciled_X.rows, reconciled_X.column, csvinputs.headers, "reconciled_X ===> (x - (Sx*Ft*fstar))", logfile);
-  printMatrixWithHeaders(reconciled_Sx.data, reconciled_Sx.rows, reconciled_Sx.column, csvinputs.headers, "reconciled_Sx ===> (Sx - (Sx*Ft*Fstar))", logfile);
-
-  dumpReconciledSxToCSV(reconciled_Sx.data, reconciled_Sx.rows, reconciled_Sx.column, csvinputs.headers, data);
-
-  // copy the reconciledSx matrix for state Estimation
-  matrixData copyReconciledSx = copyMatrix(reconciled_Sx);
+  finishReconciliation(data, reconciled_X, reconciled_Sx, NULL, value, J, eps, iterationcount, csvinputs, xdiag, sxdiag, logfile, warningCorrelationData, datareconciliationdata);
 
-  /*
-   * Calculate half width Confidence interval
-   * W=lambda*sqrt(Sx)
-   * where lamba = 1.96 and
-   * Sx - diagonal elements of reconciled_Sx
-   */
-  double *reconSx_diag = (double*) calloc (reconciled_Sx.rows * 1, sizeof(double));
-  getDiagonalElements(reconciled_Sx.data, reconciled_Sx.rows, reconciled_Sx.column, reconSx_diag);
+  // free the memory for data Reconciliation
+  free(tmpFstar.data);
+  free(tmpfstar.data);
+  return 0;
+}
 
-  matrixData copyreconSx_diag = {reconciled_Sx.rows, 1, reconSx_diag};
-  matrixData tmpcopyreconSx_diag = copyMatrix(copyreconSx_diag);
+/*
+ * Function which reports a failure of the sparse formulation
+ * to the log file and the html report, the caller returns
+ * a non-zero status
+ */
+void sparseReconciliationError(DATA * data, ofstream & logfile, const string & message)
+{
+  errorStreamPrint(LOG_STDOUT, 0, "%s", message.c_str());
+  logfile << "|  error   |   " << message << "\n";
+  logfile.flush();
+  createErrorHtmlReport(data);
+}
 
-  if (ACTIVE_STREAM(LOG_JAC))
+/*
+ * Function which converts the columns of a matrix, given as sorted
+ * (row, value) pairs, to compressed sparse column format
+ */
+sparseMatrixData toSparseMatrix(int rows, const vector< map<int, double> > & columns)
+{
+  sparseMatrixData A;
+  A.rows = rows;
+  A.column = columns.size();
+  A.nnz = 0;
+  for (unsigned int j = 0; j < columns.size(); j++)
   {
-    logfile << "Calculations of HalfWidth Confidence Interval " << "\n";
-    logfile << "===============================================\n";
-    printMatrix(copyreconSx_diag.data, reconciled_Sx.rows, 1, "reconciled-Sx_Diagonal", logfile);
+    A.nnz += columns[j].size();
   }
-
-  calculateSquareRoot(copyreconSx_diag.data, reconciled_Sx.rows);
-
-  if (ACTIVE_STREAM(LOG_JAC))
+  A.leadindex = (int*) calloc(A.column + 1, sizeof(int));
+  A.index = (int*) calloc(max(A.nnz, 1), sizeof(int));
+  A.data = (double*) calloc(max(A.nnz, 1), sizeof(double));
+  int k = 0;
+  for (unsigned int j = 0; j < columns.size(); j++)
   {
-    printMatrix(copyreconSx_diag.data, reconciled_Sx.rows, 1, "reconciled-Sx_SquareRoot", logfile);
-    logfile << "*****Completed***********\n";
+    A.leadindex[j] = k;
+    for (auto it : columns[j])
+    {
+      A.index[k] = it.first;
+      A.data[k] = it.second;
+      k++;
+    }
   }
+  A.leadindex[A.column] = k;
+  return A;
+}
 
-  scaleVector(reconciled_Sx.rows, 1, 1.96, copyreconSx_diag.data);
-  printMatrixWithHeaders(copyreconSx_diag.data, reconciled_Sx.rows, 1, csvinputs.headers, "Wx-HalfWidth-Interval-(1.96)*sqrt(Sx_diagonal)", logfile);
-
-  /*
-   * Calculate individual tests
-   * (recon_x - x)/sqrt(Sx-recon_Sx)
-   */
-  double *newSx_diag = (double*) calloc (reconciled_Sx.rows * 1, sizeof(double));
-  solveMatrixSubtraction(sxdiag, tmpcopyreconSx_diag, newSx_diag, logfile, data);
+void freeSparseMatrix(sparseMatrixData & A)
+{
+  free(A.leadindex);
+  free(A.index);
+  free(A.data);
+  A.leadindex = NULL;
+  A.index = NULL;
+  A.data = NULL;
+}
 
-  if (ACTIVE_STREAM(LOG_JAC))
+/*
+ * Function which computes the covariance matrix Sx of the sparse formulation
+ * in compressed sparse column format, only the diagonal and the entries of
+ * the correlation coefficients are stored, see computeCovarianceMatrixSx
+ */
+sparseMatrixData computeSparseCovarianceMatrixSx(csvData Sx_result, correlationData Cx_data, ofstream &logfile, DATA * data)
+{
+  const int n = Sx_result.rowcount;
+  vector< map<int, double> > columns(n);
+  for (int i = 0; i < n; i++)
   {
-    logfile << "Calculations of Individual Tests " << "\n";
-    logfile << "===============================================\n";
-    printMatrix(newSx_diag, sxdiag.rows, sxdiag.column, "Sx-recon_Sx", logfile);
+    columns[i][i] = pow(Sx_result.sxdata[i] / 1.96, 2);
   }
 
-  calculateSquareRoot(newSx_diag, reconciled_Sx.rows);
-
-  if (ACTIVE_STREAM(LOG_JAC))
+  // consider the correlation coefficients which are strictly below the diagonal entry
+  for (int i = 0; i < Cx_data.rowHeaders.size(); i++)
   {
-    printMatrix (newSx_diag, sxdiag.rows, sxdiag.column, "squareroot-newSx", logfile);
+    for (int j = 0; j < Cx_data.columnHeaders.size() && j < i; j++)
+    {
+      const double rx = Cx_data.data[Cx_data.columnHeaders.size() * i + j];
+      if (rx != 0)
+      {
+        int rowpos = getVariableIndex(Sx_result.headers, Cx_data.rowHeaders[i], logfile, data);
+        int colpos = getVariableIndex(Sx_result.headers, Cx_data.columnHeaders[j], logfile, data);
+        double tmprx = rx * sqrt(columns[rowpos][rowpos]) * sqrt(columns[colpos][colpos]);
+        columns[colpos][rowpos] = tmprx;
+        columns[rowpos][colpos] = tmprx;
+      }
+    }
   }
+  return toSparseMatrix(n, columns);
+}
 
-  double *newX = (double*) calloc (xdiag.rows * 1, sizeof(double));
-  solveMatrixSubtraction(reconciled_X, xdiag, newX, logfile, data);
-
-  // calculate absolute value for this numeric analysis
-  for (int a = 0; a < xdiag.rows; a++)
+/*
+ * Function to Print the nonzero elements of a sparse matrix with headers
+ */
+void printSparseMatrixWithHeaders(sparseMatrixData & A, vector<string> headers, string name, ofstream & logfile)
+{
+  logfile << "\n" << "************ " << name << " **********" << "\n";
+  for (int j = 0; j < A.column; j++)
   {
-    newX[a] = fabs (newX[a]);
+    for (int k = A.leadindex[j]; k < A.leadindex[j + 1]; k++)
+    {
+      logfile << std::right << setw(10) << headers[A.index[k]] << std::right << setw(10) << headers[j] << std::right << setw(15) << A.data[k] << "\n";
+    }
   }
+  logfile << "\n";
+}
 
-  if (ACTIVE_STREAM(LOG_JAC))
+#ifdef WITH_SUITESPARSE
+
+void freeSparseReconciliation(sparseReconciliationData & rd)
+{
+  freeSparseMatrix(rd.F);
+  freeSparseMatrix(rd.G);
+  freeSparseMatrix(rd.M);
+  free(rd.Frows);
+  free(rd.Fcols);
+  free(rd.Fpos);
+  free(rd.sxDiag);
+  free(rd.xF);
+  free(rd.reconSxDiag);
+  free(rd.work);
+  if (rd.numericM)
   {
-    printMatrix(newX, xdiag.rows, xdiag.column, "recon_X - X", logfile);
-    logfile << "*********Completed***********\n";
+    klu_free_numeric(&rd.numericM, &rd.common);
   }
-
-  for (int val = 0; val < xdiag.rows; val++)
+  if (rd.symbolicM)
   {
-    newX[val] = newX[val] / max(newSx_diag[val], sqrt(sxdiag.data[val] / 10));
+    klu_free_symbolic(&rd.symbolicM, &rd.common);
   }
-
-  printMatrixWithHeaders(newX, xdiag.rows, xdiag.column, csvinputs.headers, "IndividualTests_Value- (recon_x-x)/sqrt(Sx_diag)", logfile);
-
-  // copy the outputs for state Estimation
-  if (omc_flag[FLAG_DATA_RECONCILE_STATE])
-    datareconciliationdata = {csvinputs, xdiag, reconciled_X, copyReconciledSx, copyreconSx_diag, newX, eps, iterationcount, value, J, warningCorrelationData};
-
-  boundaryConditionData boundaryconditiondata;
-  // create HTML Report for D.1
-  if (omc_flag[FLAG_DATA_RECONCILE])
+  if (rd.numericSx)
   {
-    createHtmlReportFordataReconciliation(data, csvinputs, xdiag, reconciled_X, copyreconSx_diag, newX, eps, iterationcount, value, J, warningCorrelationData, boundaryconditiondata);
-    // free the memory for data Reconciliation
-    free(tmpFstar.data);
-    free(tmpfstar.data);
-    // free(tmpmatrixC);
-    // free(tmpmatrixD);
-    // free(setc);
-    free(reconciled_Sx.data);
-    free(reconciled_X.data);
-    free(copyreconSx_diag.data);
-    free(tmpcopyreconSx_diag.data);
-    free(newSx_diag);
-    free(newX);
-    // free(jacF.data);
-    // free(jacFt.data);
-    // free(x.data);
-    // free(Sx.data);
+    klu_free_numeric(&rd.numericSx, &rd.common);
   }
-  else
+  if (rd.symbolicSx)
   {
-    // stateEstimation
-    free(tmpFstar.data);
-    free(tmpfstar.data);
+    klu_free_symbolic(&rd.symbolicSx, &rd.common);
   }
-  return 0;
 }
 
 /*
- * Runs the numerical procedure to compute Boundary conditions (D.2)
-*/
-int reconcileBoundaryConditions(DATA * data, threadData_t * threadData, inputData reconciled_x, matrixData reconciled_Sx, boundaryConditionData& boundaryconditiondata, ofstream& logfile)
+ * Function which allocates the workspace of the sparse formulation,
+ * the compressed Jacobian F is set up from the sparsity pattern of
+ * the generated Jacobian, F is treated as dense if no coloring is available,
+ * the patterns of G = Sx*Ft and M = F*Sx*Ft are computed once and M is analyzed with KLU
+ */
+int allocSparseReconciliation(DATA * data, threadData_t * threadData, sparseMatrixData & Sx, sparseReconciliationData & rd, ofstream & logfile)
 {
-  TRACE_PUSH
-
-  // set the inputs from csv file to simulationInfo datainputVars
-  for (int i = 0; i < reconciled_x.rows * reconciled_x.column; i++)
+  const int index = data->callback->INDEX_JAC_F;
+  ANALYTIC_JACOBIAN *jacobian = &(data->simulationInfo->analyticJacobians[index]);
+  data->callback->initialAnalyticJacobianF(data, threadData, jacobian);
+  int cols = jacobian->sizeCols;
+  int rows = jacobian->sizeRows;
+  if (cols == 0)
   {
-    data->simulationInfo->datainputVars[i] = reconciled_x.data[i];
+    sparseReconciliationError(data, logfile, "Cannot Compute Jacobian Matrix F");
+    return 1;
+  }
+  if (cols != Sx.rows || rows != data->modelData->nSetcVars)
+  {
+    std::stringstream message;
+    message << "Dimension of Jacobian Matrix F (" << rows << "x" << cols << ") does not match " << data->modelData->nSetcVars << " setc equations and " << Sx.rows << " variables of interest";
+    sparseReconciliationError(data, logfile, message.str());
+    return 1;
   }
 
-  /* set the inputs via this special function generated for dataReconciliation
-   * which also sets inputs for models not involving top level inputs
-   */
-  data->callback->data_function(data, threadData);
-  // solve the system with reconciled input values got from D.1
-  data->callback->functionDAE(data, threadData);
-  // call the setc function which stores the results of boundary conditions variable
-  if (omc_flag[FLAG_DATA_RECONCILE_BOUNDARY])
-    data->callback->setc_function(data, threadData);
-  // call the setb function for state estimation
+  SPARSE_PATTERN *sp = jacobian->sparsePattern;
+  sparseMatrixData F;
+  F.rows = rows;
+  F.column = cols;
+  F.leadindex = (int*) calloc(cols + 1, sizeof(int));
+  if (sp != NULL && sp->maxColors > 0)
+  {
+    F.nnz = sp->numberOfNonZeros;
+    F.index = (int*) calloc(max(F.nnz, 1), sizeof(int));
+    for (int j = 0; j <= cols; j++)
+    {
+      F.leadindex[j] = sp->leadindex[j];
+    }
+    for (int k = 0; k < F.nnz; k++)
+    {
+      F.index[k] = sp->index[k];
+    }
+  }
+  else
+  {
+    F.nnz = rows * cols;
+    F.index = (int*) calloc(max(F.nnz, 1), sizeof(int));
+    for (int j = 0; j <= cols; j++)
+    {
+      F.leadindex[j] = j * rows;
+    }
+    for (int k = 0; k < F.nnz; k++)
+    {
+      F.index[k] = k % rows;
+    }
+  }
+  F.data = (double*) calloc(max(F.nnz, 1), sizeof(double));
+
+  rd.jacobian = jacobian;
+  rd.F = F;
+  rd.Sx = Sx;
+  rd.nx = cols;
+  rd.nc = rows;
+  rd.factorizations = 0;
+  rd.xF = (double*) calloc(rd.nx, sizeof(double));
+  rd.reconSxDiag = (double*) calloc(rd.nx, sizeof(double));
+  rd.reconSxDiagValid = false;
+  rd.work = (double*) calloc(max(rd.nx, rd.nc), sizeof(double));
+  rd.symbolicM = NULL;
+  rd.numericM = NULL;
+  rd.symbolicSx = NULL;
+  rd.numericSx = NULL;
+  klu_defaults(&rd.common);
+
+  // Sx without correlation coefficients is diagonal and needs no factorization
+  rd.sxDiagonal = (Sx.nnz == Sx.column);
+  rd.sxDiag = (double*) calloc(rd.nx, sizeof(double));
+  for (int j = 0; j < Sx.column; j++)
+  {
+    for (int k = Sx.leadindex[j]; k < Sx.leadindex[j + 1]; k++)
+    {
+      if (Sx.index[k] == j)
+      {
+        rd.sxDiag[j] = Sx.data[k];
+      }
+    }
+  }
+
+  // rows of F, G(:,i) = Sx*F(i,:)t is assembled from row i of F
+  rd.Frows = (int*) calloc(rd.nc + 1, sizeof(int));
+  rd.Fcols = (int*) calloc(max(F.nnz, 1), sizeof(int));
+  rd.Fpos = (int*) calloc(max(F.nnz, 1), sizeof(int));
+  for (int k = 0; k < F.nnz; k++)
+  {
+    rd.Frows[F.index[k] + 1]++;
+  }
+  for (int i = 0; i < rd.nc; i++)
+  {
+    rd.Frows[i + 1] += rd.Frows[i];
+  }
+  vector<int> next(rd.Frows, rd.Frows + rd.nc);
+  for (int j = 0; j < F.column; j++)
+  {
+    for (int k = F.leadindex[j]; k < F.leadindex[j + 1]; k++)
+    {
+      const int pos = next[F.index[k]]++;
+      rd.Fcols[pos] = j;
+      rd.Fpos[pos] = k;
+    }
+  }
+
+  // pattern of G = Sx*Ft and M = F*G
+  vector< map<int, double> > columnsG(rd.nc), columnsM(rd.nc);
+  for (int i = 0; i < rd.nc; i++)
+  {
+    for (int p = rd.Frows[i]; p < rd.Frows[i + 1]; p++)
+    {
+      const int k = rd.Fcols[p];
+      for (int q = Sx.leadindex[k]; q < Sx.leadindex[k + 1]; q++)
+      {
+        columnsG[i][Sx.index[q]] = 0.0;
+      }
+    }
+    for (auto it : columnsG[i])
+    {
+      for (int q = F.leadindex[it.first]; q < F.leadindex[it.first + 1]; q++)
+      {
+        columnsM[i][F.index[q]] = 0.0;
+      }
+    }
+  }
+  rd.G = toSparseMatrix(rd.nx, columnsG);
+  rd.M = toSparseMatrix(rd.nc, columnsM);
+
+  rd.symbolicM = klu_analyze(rd.nc, rd.M.leadindex, rd.M.index, &rd.common);
+  if (rd.symbolicM == NULL)
+  {
+    std::stringstream message;
+    message << "allocSparseReconciliation() Failed !, KLU cannot analyze the Matrix (F*Sx*Ft), The klu status is " << rd.common.status;
+    sparseReconciliationError(data, logfile, message.str());
+    freeSparseReconciliation(rd);
+    return 1;
+  }
+
+  if (!rd.sxDiagonal)
+  {
+    rd.symbolicSx = klu_analyze(rd.nx, Sx.leadindex, Sx.index, &rd.common);
+    if (rd.symbolicSx != NULL)
+    {
+      rd.numericSx = klu_factor(Sx.leadindex, Sx.index, Sx.data, rd.symbolicSx, &rd.common);
+    }
+    if (rd.numericSx == NULL || rd.common.status != KLU_OK)
+    {
+      std::stringstream message;
+      message << "allocSparseReconciliation() Failed !, Covariance Matrix Sx is singular, The klu status is " << rd.common.status;
+      sparseReconciliationError(data, logfile, message.str());
+      freeSparseReconciliation(rd);
+      return 1;
+    }
+  }
+
+  logfile << "Sparse formulation: Jacobian Matrix F (" << rows << "x" << cols << ") with " << F.nnz << " nonzero elements";
+  if (sp != NULL && sp->maxColors > 0)
+  {
+    logfile << " evaluated with " << sp->maxColors << " colors\n";
+  }
+  else
+  {
+    logfile << ", no sparsity pattern available\n";
+  }
+  logfile << "Sparse formulation: Covariance Matrix Sx with " << Sx.nnz << " nonzero elements is " << (rd.sxDiagonal ? "diagonal" : "factorized with KLU") << "\n";
+  logfile << "Sparse formulation: Matrix (F*Sx*Ft) (" << rd.nc << "x" << rd.nc << ") with " << rd.M.nnz << " nonzero elements is factorized with KLU\n\n";
+  return 0;
+}
+
+/*
+ * Function which evaluates the nonzero elements of the Jacobian F
+ * at the current operating point, all columns of one color are
+ * computed with a single directional derivative
+ */
+void evalSparseJacobianMatrixF(DATA * data, threadData_t * threadData, sparseReconciliationData & rd)
+{
+  ANALYTIC_JACOBIAN *jacobian = rd.jacobian;
+  SPARSE_PATTERN *sp = jacobian->sparsePattern;
+  sparseMatrixData & F = rd.F;
+
+  if (sp != NULL && sp->maxColors > 0)
+  {
+    for (int color = 1; color <= (int) sp->maxColors; color++)
+    {
+      for (int j = 0; j < F.column; j++)
+      {
+        if (sp->colorCols[j] == color)
+        {
+          jacobian->seedVars[j] = 1.0;
+        }
+      }
+      data->callback->functionJacF_column(data, threadData, jacobian, NULL);
+      for (int j = 0; j < F.column; j++)
+      {
+        if (sp->colorCols[j] == color)
+        {
+          for (int k = F.leadindex[j]; k < F.leadindex[j + 1]; k++)
+          {
+            F.data[k] = jacobian->resultVars[F.index[k]];
+          }
+          jacobian->seedVars[j] = 0.0;
+        }
+      }
+    }
+  }
+  else
+  {
+    for (int j = 0; j < F.column; j++)
+    {
+      jacobian->seedVars[j] = 1.0;
+      data->callback->functionJacF_column(data, threadData, jacobian, NULL);
+      for (int k = F.leadindex[j]; k < F.leadindex[j + 1]; k++)
+      {
+        F.data[k] = jacobian->resultVars[F.index[k]];
+      }
+      jacobian->seedVars[j] = 0.0;
+    }
+  }
+}
+
+/*
+ * Function which linearizes the constraints at x, assembles the nonzero
+ * elements of G = Sx*Ft and M = F*G in their fixed patterns and
+ * factorizes M with KLU, the previous factorization is refactorized
+ * with the same pivots as long as the pivot growth stays acceptable
+ */
+int factorizeSparseReconciliation(DATA * data, threadData_t * threadData, double * x, sparseReconciliationData & rd, ofstream & logfile)
+{
+  sparseMatrixData & F = rd.F;
+  sparseMatrixData & Sx = rd.Sx;
+  sparseMatrixData & G = rd.G;
+  sparseMatrixData & M = rd.M;
+  double *work = rd.work;
+
+  evalSparseJacobianMatrixF(data, threadData, rd);
+  memcpy(rd.xF, x, rd.nx * sizeof(double));
+
+  // G(:,i) = sum over row i of F of Sx(:,k)*F(i,k)
+  for (int i = 0; i < rd.nc; i++)
+  {
+    for (int p = rd.Frows[i]; p < rd.Frows[i + 1]; p++)
+    {
+      const int k = rd.Fcols[p];
+      const double v = F.data[rd.Fpos[p]];
+      for (int q = Sx.leadindex[k]; q < Sx.leadindex[k + 1]; q++)
+      {
+        work[Sx.index[q]] += Sx.data[q] * v;
+      }
+    }
+    for (int q = G.leadindex[i]; q < G.leadindex[i + 1]; q++)
+    {
+      G.data[q] = work[G.index[q]];
+      work[G.index[q]] = 0.0;
+    }
+  }
+
+  // M(:,i) = F*G(:,i)
+  for (int i = 0; i < rd.nc; i++)
+  {
+    for (int p = G.leadindex[i]; p < G.leadindex[i + 1]; p++)
+    {
+      const int m = G.index[p];
+      const double v = G.data[p];
+      for (int q = F.leadindex[m]; q < F.leadindex[m + 1]; q++)
+      {
+        work[F.index[q]] += F.data[q] * v;
+      }
+    }
+    for (int q = M.leadindex[i]; q < M.leadindex[i + 1]; q++)
+    {
+      M.data[q] = work[M.index[q]];
+      work[M.index[q]] = 0.0;
+    }
+  }
+
+  if (rd.numericM)
+  {
+    klu_refactor(M.leadindex, M.index, M.data, rd.symbolicM, rd.numericM, &rd.common);
+    klu_rgrowth(M.leadindex, M.index, M.data, rd.symbolicM, rd.numericM, &rd.common);
+    if (rd.common.status != KLU_OK || rd.common.rgrowth < 1e-3)
+    {
+      klu_free_numeric(&rd.numericM, &rd.common);
+      rd.numericM = klu_factor(M.leadindex, M.index, M.data, rd.symbolicM, &rd.common);
+    }
+  }
+  else
+  {
+    rd.numericM = klu_factor(M.leadindex, M.index, M.data, rd.symbolicM, &rd.common);
+  }
+  if (rd.numericM == NULL || rd.common.status != KLU_OK)
+  {
+    std::stringstream message;
+    message << "factorizeSparseReconciliation() Failed !, The Matrix (F*Sx*Ft) is singular, The klu status is " << rd.common.status;
+    sparseReconciliationError(data, logfile, message.str());
+    return 1;
+  }
+
+  rd.reconSxDiagValid = false;
+  rd.factorizations++;
+  return 0;
+}
+
+/*
+ * Function which computes the diagonal elements of the reconciled
+ * covariance matrix recon_Sx = Sx - G*(F*Sx*Ft)^-1*Gt of the current
+ * factorization, row k of G is solved for all variables of interest
+ * which are connected to a constraint, in blocks of right hand sides
+ */
+void updateSparseReconciledSxDiagonal(sparseReconciliationData & rd)
+{
+  if (rd.reconSxDiagValid)
+  {
+    return;
+  }
+  const int blockSize = 64;
+  const int nc = rd.nc;
+  sparseMatrixData & F = rd.F;
+  sparseMatrixData & Sx = rd.Sx;
+
+  vector<int> block;
+  double *B = (double*) calloc(nc * blockSize, sizeof(double));
+  double *Y = (double*) calloc(nc * blockSize, sizeof(double));
+  for (int k = 0; k < rd.nx; k++)
+  {
+    rd.reconSxDiag[k] = rd.sxDiag[k];
+    // Gt(:,k) = F*Sx(:,k), as Sx is symmetric
+    bool connected = false;
+    for (int q = Sx.leadindex[k]; q < Sx.leadindex[k + 1] && !connected; q++)
+    {
+      connected = F.leadindex[Sx.index[q] + 1] > F.leadindex[Sx.index[q]];
+    }
+    if (connected)
+    {
+      block.push_back(k);
+    }
+    if ((int) block.size() == blockSize || (k == rd.nx - 1 && !block.empty()))
+    {
+      const int nb = block.size();
+      memset(B, 0, nc * nb * sizeof(double));
+      for (int b = 0; b < nb; b++)
+      {
+        const int col = block[b];
+        for (int q = Sx.leadindex[col]; q < Sx.leadindex[col + 1]; q++)
+        {
+          const int m = Sx.index[q];
+          for (int p = F.leadindex[m]; p < F.leadindex[m + 1]; p++)
+          {
+            B[F.index[p] + b * nc] += F.data[p] * Sx.data[q];
+          }
+        }
+      }
+      memcpy(Y, B, nc * nb * sizeof(double));
+      klu_solve(rd.symbolicM, rd.numericM, nc, nb, Y, &rd.common);
+      for (int b = 0; b < nb; b++)
+      {
+        double sum = 0.0;
+        for (int i = 0; i < nc; i++)
+        {
+          sum += B[i + b * nc] * Y[i + b * nc];
+        }
+        rd.reconSxDiag[block[b]] -= sum;
+      }
+      block.clear();
+    }
+  }
+  free(B);
+  free(Y);
+  rd.reconSxDiagValid = true;
+}
+
+/*
+ * Function which checks if the operating point x is close enough to
+ * the operating point of the current factorization to reuse it, the
+ * change of each variable is scaled with its value and standard deviation
+ */
+bool reuseSparseReconciliation(double * x, sparseReconciliationData & rd, double reuseTol)
+{
+  if (rd.factorizations == 0 || reuseTol <= 0)
+  {
+    return false;
+  }
+  for (int k = 0; k < rd.nx; k++)
+  {
+    if (fabs(x[k] - rd.xF[k]) > reuseTol * (fabs(rd.xF[k]) + sqrt(rd.sxDiag[k])))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*
+ * Function which sets the inputs x and evaluates the
+ * constraints c(x,y), stored in reverse order as in RunReconciliation
+ */
+void evalSparseReconciliationConstraints(DATA * data, threadData_t * threadData, double * x, int nx, double * c)
+{
+  for (int i = 0; i < nx; i++)
+  {
+    data->simulationInfo->datainputVars[i] = x[i];
+  }
+  data->callback->data_function(data, threadData);
+  data->callback->functionDAE(data, threadData);
+  data->callback->setc_function(data, threadData);
+
+  int t = 0;
+  for (int i = data->modelData->nSetcVars; i > 0; i--)
+  {
+    c[t++] = data->simulationInfo->setcVars[i-1];
+  }
+}
+
+/*
+ * Function which solves one step of the sparse formulation
+ * (F*Sx*Ft).f* = c(x,y) and recon_x = x - (Sx*Ft*f*)
+ * and returns the convergence value J* divided by r, as d = recon_x - x
+ * gives (d)T*(Sx^-1)*(d) = -(F*d)T*f* no solve with Sx is required
+ * J* = [2.c + F*d]T*f*
+ */
+double solveSparseReconciliationStep(double * x, double * c, double * reconciledX, double * fstar, sparseReconciliationData & rd)
+{
+  sparseMatrixData & F = rd.F;
+  sparseMatrixData & G = rd.G;
+  const int nx = rd.nx;
+  const int nc = rd.nc;
+
+  memcpy(fstar, c, nc * sizeof(double));
+  klu_solve(rd.symbolicM, rd.numericM, nc, 1, fstar, &rd.common);
+
+  memcpy(reconciledX, x, nx * sizeof(double));
+  for (int i = 0; i < nc; i++)
+  {
+    for (int p = G.leadindex[i]; p < G.leadindex[i + 1]; p++)
+    {
+      reconciledX[G.index[p]] -= G.data[p] * fstar[i];
+    }
+  }
+
+  double value = 0.0;
+  double *Fd = rd.work;
+  for (int k = 0; k < F.column; k++)
+  {
+    const double d = reconciledX[k] - x[k];
+    for (int nz = F.leadindex[k]; nz < F.leadindex[k + 1]; nz++)
+    {
+      Fd[F.index[nz]] += F.data[nz] * d;
+    }
+  }
+  for (int i = 0; i < nc; i++)
+  {
+    value += (2.0 * c[i] + Fd[i]) * fstar[i];
+    Fd[i] = 0.0;
+  }
+  return value / nc;
+}
+
+/*
+ * Function which calculates qualityValue J = transpose (x_reconciled – x_measured)*Sx^-1*(x_reconciled – x_measured)
+ * using the diagonal or the KLU factorization of Sx of the sparse formulation
+ */
+double calculateSparseQualityValue(double * reconciledX, double * measuredX, sparseReconciliationData & rd)
+{
+  const int nx = rd.nx;
+  double J = 0.0;
+  if (rd.sxDiagonal)
+  {
+    for (int k = 0; k < nx; k++)
+    {
+      const double d = reconciledX[k] - measuredX[k];
+      J += d * d / rd.sxDiag[k];
+    }
+    return J;
+  }
+
+  double *y = (double*) calloc(nx, sizeof(double));
+  for (int k = 0; k < nx; k++)
+  {
+    y[k] = reconciledX[k] - measuredX[k];
+  }
+  klu_solve(rd.symbolicSx, rd.numericSx, nx, 1, y, &rd.common);
+  for (int k = 0; k < nx; k++)
+  {
+    J += (reconciledX[k] - measuredX[k]) * y[k];
+  }
+  free(y);
+  return J;
+}
+
+/*
+ * Runs the Data Reconciliation (D.1) with the sparse formulation,
+ * the results and the html report are the same as of RunReconciliation,
+ * only the diagonal elements of the reconciled covariance matrix are computed
+ */
+int RunReconciliationSparse(DATA *data, threadData_t *threadData, inputData x, sparseMatrixData Sx, double eps, csvData csvinputs, matrixData xdiag, matrixData sxdiag, ofstream &logfile, correlationDataWarning & warningCorrelationData, dataReconciliationData& datareconciliationdata)
+{
+  const int maxIterations = 100;
+  sparseReconciliationData rd;
+  if (allocSparseReconciliation(data, threadData, Sx, rd, logfile))
+  {
+    return 1;
+  }
+  const int nx = rd.nx;
+  const int nc = rd.nc;
+
+  double *currentX = (double*) calloc(nx, sizeof(double));
+  double *c = (double*) calloc(nc, sizeof(double));
+  double *fstar = (double*) calloc(nc, sizeof(double));
+  double *reconciledX = (double*) calloc(nx, sizeof(double));
+  memcpy(currentX, x.data, nx * sizeof(double));
+
+  int status = 0;
+  double value = 0.0;
+  int iterationcount = 1;
+  for (;; iterationcount++)
+  {
+    evalSparseReconciliationConstraints(data, threadData, currentX, nx, c);
+    status = factorizeSparseReconciliation(data, threadData, currentX, rd, logfile);
+    if (status)
+    {
+      break;
+    }
+    value = solveSparseReconciliationStep(currentX, c, reconciledX, fstar, rd);
+
+    if (ACTIVE_STREAM(LOG_JAC))
+    {
+      printMatrix(c, nc, 1, "c(x,y)", logfile);
+      printMatrix(fstar, nc, 1, "f*", logfile);
+    }
+
+    if (!(value > eps) || iterationcount >= maxIterations)
+    {
+      break;
+    }
+    logfile << "J*/r" << "(" << value << ")" << " > " << eps << ", Value not Converged \n";
+    logfile << "==========================================\n\n";
+    logfile << "Running Convergence iteration: " << iterationcount << " with the following reconciled values:" << "\n";
+    logfile << "========================================================================" << "\n";
+    printMatrixWithHeaders(reconciledX, nx, 1, csvinputs.headers, "reconciled_X ===> (x - (Sx*Ft*fstar))", logfile);
+    memcpy(currentX, reconciledX, nx * sizeof(double));
+  }
+
+  if (status == 0)
+  {
+    if (value > eps)
+    {
+      warningStreamPrint(LOG_STDOUT, 0, "DataReconciliation not converged after %i iterations, J*/r = %g > %g.", maxIterations, value, eps);
+      logfile << "|  warning |   " << "DataReconciliation not converged after " << maxIterations << " iterations" << "\n";
+    }
+    else if (iterationcount == 1)
+    {
+      logfile << "J*/r" << "(" << value << ")" << " > " << eps << ", Convergence iteration not required \n\n";
+    }
+    else
+    {
+      logfile << "***** Value Converged, Convergence Completed******* \n\n";
+    }
+
+    double J = calculateSparseQualityValue(reconciledX, xdiag.data, rd);
+
+    updateSparseReconciledSxDiagonal(rd);
+    double *reconSx_diag = (double*) calloc(nx, sizeof(double));
+    memcpy(reconSx_diag, rd.reconSxDiag, nx * sizeof(double));
+
+    matrixData reconciled_X = {nx, 1, reconciledX};
+    matrixData reconciled_Sx = {nx, nx, NULL};
+    finishReconciliation(data, reconciled_X, reconciled_Sx, reconSx_diag, value, J, eps, iterationcount, csvinputs, xdiag, sxdiag, logfile, warningCorrelationData, datareconciliationdata);
+  }
+  else
+  {
+    free(reconciledX);
+  }
+
+  free(currentX);
+  free(c);
+  free(fstar);
+  freeSparseReconciliation(rd);
+  return status;
+}
+
+/*
+ * Runs the batch mode of the Data Reconciliation, each row of the
+ * time-stamped measurement file given by -reconcileBatch is reconciled
+ * with the sparse formulation and the half-width confidence intervals
+ * of -sx, the factorization is reused as long as the operating point
+ * changes less than -reconcileReuseTol and the results are streamed
+ * to <modelName>_BatchReconciliation.csv
+ */
+int RunBatchReconciliation(DATA *data, threadData_t *threadData, sparseMatrixData Sx, double eps, csvData csvinputs, ofstream &logfile)
+{
+  const int maxIterations = 100;
+  const int maxChordIterations = 10;
+  const char *filename = omc_flagValue[FLAG_DATA_RECONCILE_BATCH];
+  double reuseTol = 1e-3;
+  if (omc_flag[FLAG_DATA_RECONCILE_REUSE_TOL])
+  {
+    reuseTol = atof(omc_flagValue[FLAG_DATA_RECONCILE_REUSE_TOL]);
+  }
+
+  // only the time stamps and the variables of interest are read from the batch file
+  vector<const char*> names;
+  names.push_back("time");
+  for (unsigned int i = 0; i < csvinputs.headers.size(); i++)
+  {
+    names.push_back(csvinputs.headers[i].c_str());
+  }
+  struct csv_data *batch = read_csv_columns(filename, names.size(), names.data(), 0);
+  if (batch == NULL || batch->numsteps < 1)
+  {
+    std::stringstream message;
+    message << "Batch measurement input file " << filename << " could not be read or has no measurement rows";
+    sparseReconciliationError(data, logfile, message.str());
+    if (batch)
+    {
+      omc_free_csv_reader(batch);
+    }
+    return 1;
+  }
+
+  // map the variables of interest to the columns of the batch file
+  int timeColumn = -1;
+  vector<int> columns(csvinputs.headers.size(), -1);
+  for (int j = 0; j < batch->numvars; j++)
+  {
+    if (0 == strcmp(batch->variables[j], "time"))
+    {
+      timeColumn = j;
+    }
+    for (int i = 0; i < csvinputs.headers.size(); i++)
+    {
+      if (csvinputs.headers[i] == batch->variables[j])
+      {
+        columns[i] = j;
+      }
+    }
+  }
+  for (int i = 0; i < csvinputs.headers.size(); i++)
+  {
+    if (columns[i] < 0)
+    {
+      std::stringstream message;
+      message << "variable of interest " << csvinputs.headers[i] << " has no column in batch measurement input file " << filename;
+      omc_free_csv_reader(batch);
+      sparseReconciliationError(data, logfile, message.str());
+      return 1;
+    }
+  }
+
+  sparseReconciliationData rd;
+  if (allocSparseReconciliation(data, threadData, Sx, rd, logfile))
+  {
+    omc_free_csv_reader(batch);
+    return 1;
+  }
+  const int nx = rd.nx;
+  const int nc = rd.nc;
+
+  std::stringstream csv_file;
+  if (omc_flag[FLAG_OUTPUT_PATH])
+  {
+    csv_file << string(omc_flagValue[FLAG_OUTPUT_PATH]) << "/" << data->modelData->modelName << "_BatchReconciliation.csv";
+  }
+  else
+  {
+    csv_file << data->modelData->modelName << "_BatchReconciliation.csv";
+  }
+  string tmpcsv = csv_file.str();
+  ofstream csvfile(tmpcsv.c_str());
+  csvfile << setprecision(17);
+  csvfile << "time,converged,iterations,factorized,J*/r,J";
+  for (auto it : csvinputs.headers)
+  {
+    csvfile << "," << it;
+  }
+  for (auto it : csvinputs.headers)
+  {
+    csvfile << ",W(" << it << ")";
+  }
+  csvfile << "\n";
+
+  double *measuredX = (double*) calloc(nx, sizeof(double));
+  double *currentX = (double*) calloc(nx, sizeof(double));
+  double *c = (double*) calloc(nc, sizeof(double));
+  double *fstar = (double*) calloc(nc, sizeof(double));
+  double *reconciledX = (double*) calloc(nx, sizeof(double));
+  int notConverged = 0;
+  int status = 0;
+
+  logfile << "|  info    |   " << "Batch DataReconciliation of " << batch->numsteps << " measurement rows from " << filename << "\n";
+  for (int row = 0; row < batch->numsteps && status == 0; row++)
+  {
+    for (int i = 0; i < nx; i++)
+    {
+      measuredX[i] = batch->data[columns[i] * batch->numsteps + row];
+    }
+    memcpy(currentX, measuredX, nx * sizeof(double));
+
+    double value = 0.0;
+    int iterationcount = 1;
+    int chordIterations = 0;
+    bool factorized = false;
+    for (;; iterationcount++)
+    {
+      evalSparseReconciliationConstraints(data, threadData, currentX, nx, c);
+      if (!reuseSparseReconciliation(currentX, rd, reuseTol) || chordIterations >= maxChordIterations)
+      {
+        status = factorizeSparseReconciliation(data, threadData, currentX, rd, logfile);
+        if (status)
+        {
+          break;
+        }
+        factorized = true;
+        chordIterations = 0;
+      }
+      value = solveSparseReconciliationStep(currentX, c, reconciledX, fstar, rd);
+      chordIterations++;
+      if (!(value > eps) || iterationcount >= maxIterations)
+      {
+        break;
+      }
+      memcpy(currentX, reconciledX, nx * sizeof(double));
+    }
+    if (status)
+    {
+      break;
+    }
+
+    bool converged = !(value > eps);
+    if (!converged)
+    {
+      notConverged++;
+      logfile << "|  warning |   " << "measurement row " << row + 1 << " not converged after " << maxIterations << " iterations, J*/r = " << value << "\n";
+    }
+    double J = calculateSparseQualityValue(reconciledX, measuredX, rd);
+    updateSparseReconciledSxDiagonal(rd);
+
+    csvfile << (timeColumn >= 0 ? batch->data[timeColumn * batch->numsteps + row] : (double) row) << "," << converged << "," << iterationcount << "," << factorized << "," << value << "," << J;
+    for (int i = 0; i < nx; i++)
+    {
+      csvfile << "," << reconciledX[i];
+    }
+    for (int i = 0; i < nx; i++)
+    {
+      csvfile << "," << 1.96 * sqrt(fmax(rd.reconSxDiag[i], 0.0));
+    }
+    csvfile << "\n";
+  }
+  csvfile.flush();
+  csvfile.close();
+
+  if (status == 0)
+  {
+    infoStreamPrint(LOG_STDOUT, 0, "Batch DataReconciliation of %i measurement rows with %i factorizations, %i rows not converged, results written to %s", batch->numsteps, rd.factorizations, notConverged, tmpcsv.c_str());
+    logfile << "|  info    |   " << "Batch DataReconciliation used " << rd.factorizations << " factorizations, " << notConverged << " rows not converged\n";
+    logfile << "|  info    |   " << "Results written to " << tmpcsv << "\n";
+  }
+
+  free(measuredX);
+  free(currentX);
+  free(c);
+  free(fstar);
+  free(reconciledX);
+  freeSparseReconciliation(rd);
+  omc_free_csv_reader(batch);
+  return status;
+}
+
+#else
+
+int RunReconciliationSparse(DATA *data, threadData_t *threadData, inputData x, sparseMatrixData Sx, double eps, csvData csvinputs, matrixData xdiag, matrixData sxdiag, ofstream &logfile, correlationDataWarning & warningCorrelationData, dataReconciliationData& datareconciliationdata)
+{
+  sparseReconciliationError(data, logfile, "The sparse formulation of the Data Reconciliation (-reconcileSparse) requires OpenModelica compiled with SuiteSparse (KLU)");
+  return 1;
+}
+
+int RunBatchReconciliation(DATA *data, threadData_t *threadData, sparseMatrixData Sx, double eps, csvData csvinputs, ofstream &logfile)
+{
+  sparseReconciliationError(data, logfile, "The batch mode of the Data Reconciliation (-reconcileBatch) requires OpenModelica compiled with SuiteSparse (KLU)");
+  return 1;
+}
+
+#endif /* WITH_SUITESPARSE */
+
+/*
+ * Runs the numerical procedure to compute Boundary conditions (D.2)
+*/
+int reconcileBoundaryConditions(DATA * data, threadData_t * threadData, inputData reconciled_x, matrixData reconciled_Sx, boundaryConditionData& boundaryconditiondata, ofstream& logfile)
+{
+  TRACE_PUSH
+
+  // set the inputs from csv file to simulationInfo datainputVars
+  for (int i = 0; i < reconciled_x.rows * reconciled_x.column; i++)
+  {
+    data->simulationInfo->datainputVars[i] = reconciled_x.data[i];
+  }
+
+  /* set the inputs via this special function generated for dataReconciliation
+   * which also sets inputs for models not involving top level inputs
+   */
+  data->callback->data_function(data, threadData);
+  // solve the system with reconciled input values got from D.1
+  data->callback->functionDAE(data, threadData);
+  // call the setc function which stores the results of boundary conditions variable
+  if (omc_flag[FLAG_DATA_RECONCILE_BOUNDARY])
+    data->callback->setc_function(data, threadData);
+  // call the setb function for state estimation
   if (omc_flag[FLAG_DATA_RECONCILE_STATE])
     data->callback->setb_function(data, threadData);
 
@@ -2991,18 +3987,37 @@ int dataReconciliation(DATA * data, threadData_t * threadData, int status)
   // read the correlation coefficient input data provide by user
   correlationData Cx_data = readCorrelationCoefficientFile(Sx_data, logfile, data);
 
-  // Compute the covariance matrix (Sx) from csvData
-  matrixData Sx = computeCovarianceMatrixSx(Sx_data, Cx_data, logfile, data);
+  // the sparse formulation and the batch mode keep Sx and the Jacobian F in compressed sparse column format
+  bool sparseFormulation = omc_flag[FLAG_DATA_RECONCILE] && (omc_flag[FLAG_DATA_RECONCILE_SPARSE] || omc_flag[FLAG_DATA_RECONCILE_BATCH]);
+  bool denseFormulation = !sparseFormulation || omc_flag[FLAG_DATA_RECONCILE_STATE];
 
-  // Compute the Jacobian Matrix F
-  matrixData jacF = getJacobianMatrixF(data, threadData, logfile);
+  // Compute the covariance matrix (Sx) from csvData
+  matrixData Sx = {0, 0, NULL};
+  sparseMatrixData sparseSx = {0, 0, 0, NULL, NULL, NULL};
+  if (denseFormulation)
+  {
+    Sx = computeCovarianceMatrixSx(Sx_data, Cx_data, logfile, data);
+  }
+  if (sparseFormulation)
+  {
+    sparseSx = computeSparseCovarianceMatrixSx(Sx_data, Cx_data, logfile, data);
+  }
 
-  // Compute the Transpose of jacobian Matrix F
-  matrixData jacFt = getTransposeMatrix(jacF);
+  // Compute the dense Jacobian Matrix F and its Transpose, the sparse formulation evaluates its own compressed F
+  matrixData jacF = {0, 0, NULL};
+  matrixData jacFt = {0, 0, NULL};
+  if (denseFormulation)
+  {
+    jacF = getJacobianMatrixF(data, threadData, logfile);
+    jacFt = getTransposeMatrix(jacF);
+  }
 
-  double * Sx_diag = (double*) calloc(Sx.rows * 1, sizeof(double));
-  getDiagonalElements(Sx.data, Sx.rows, Sx.column, Sx_diag);
-  matrixData tmpSx_diag = {Sx.rows, 1, Sx_diag};
+  double * Sx_diag = (double*) calloc(x.rows * 1, sizeof(double));
+  for (int i = 0; i < x.rows; i++)
+  {
+    Sx_diag[i] = pow(Sx_data.sxdata[i] / 1.96, 2);
+  }
+  matrixData tmpSx_diag = {x.rows, 1, Sx_diag};
 
   matrixData tmp_x = {x.rows, x.column, x.data};
   matrixData x_diag = copyMatrix(tmp_x);
@@ -3013,16 +4028,37 @@ int dataReconciliation(DATA * data, threadData_t * threadData, int status)
   printMatrixWithHeaders(x.data, x.rows, x.column, Sx_data.headers, "X", logfile);
   printVectorMatrixWithHeaders(Sx_data.sxdata, Sx_data.rowcount, 1, Sx_data.headers, "Half-WidthConfidenceInterval", logfile);
   printCorelationMatrix(Cx_data.data, Cx_data.rowHeaders, Cx_data.columnHeaders, "Co-Relation_Coefficient", logfile, warningCorrelationData);
-  printMatrixWithHeaders(Sx.data, Sx.rows, Sx.column, Sx_data.headers, "Sx", logfile);
+  if (denseFormulation)
+  {
+    printMatrixWithHeaders(Sx.data, Sx.rows, Sx.column, Sx_data.headers, "Sx", logfile);
+  }
+  else
+  {
+    printSparseMatrixWithHeaders(sparseSx, Sx_data.headers, "Sx", logfile);
+  }
 
-  // Start the Algorithm
+  // Start the Algorithm, status is 0 here
   if (omc_flag[FLAG_DATA_RECONCILE])
   {
     dataReconciliationData datareconciliationdata;
-    RunReconciliation(data, threadData, x, Sx, jacF, jacFt, atof(epselon), 1, Sx_data, x_diag, tmpSx_diag, logfile, warningCorrelationData, datareconciliationdata);
-    logfile << "|  info    |   " << "DataReconciliation Completed! \n";
+    if (omc_flag[FLAG_DATA_RECONCILE_BATCH])
+    {
+      status = RunBatchReconciliation(data, threadData, sparseSx, atof(epselon), Sx_data, logfile);
+    }
+    else if (omc_flag[FLAG_DATA_RECONCILE_SPARSE])
+    {
+      status = RunReconciliationSparse(data, threadData, x, sparseSx, atof(epselon), Sx_data, x_diag, tmpSx_diag, logfile, warningCorrelationData, datareconciliationdata);
+    }
+    else
+    {
+      RunReconciliation(data, threadData, x, Sx, jacF, jacFt, atof(epselon), 1, Sx_data, x_diag, tmpSx_diag, logfile, warningCorrelationData, datareconciliationdata);
+    }
+    if (status == 0)
+    {
+      logfile << "|  info    |   " << "DataReconciliation Completed! \n";
+    }
   }
-  if (omc_flag[FLAG_DATA_RECONCILE_STATE])
+  if (omc_flag[FLAG_DATA_RECONCILE_STATE] && status == 0)
   {
     stateEstimation(data, threadData, x, Sx, jacF, jacFt, atof(epselon), 1, Sx_data, x_diag, tmpSx_diag, logfile, warningCorrelationData);
     logfile << "|  info    |   " << "state estimation Completed! \n";
@@ -3030,13 +4066,14 @@ int dataReconciliation(DATA * data, threadData_t * threadData, int status)
   logfile.flush();
   logfile.close();
   free(Sx.data);
+  freeSparseMatrix(sparseSx);
   free(x.data);
   free(jacF.data);
   free(jacFt.data);
   free(tmpSx_diag.data);
   free(x_diag.data);
   TRACE_POP
-  return 0;
+  return status;
 }
 
 int boundaryConditions(DATA * data, threadData_t * threadData, int status)
@@ -35,6 +35,7 @@
 #include "simulation/solver/external_input.h"
 #include "simulation/options.h"
 #include "simulation/solver/model_help.h"
+#include "simulation/solver/masked_eval.h"
 #include "linearize.h"
 #include <iostream>
 #include <sstream>
@@ -106,7 +107,8 @@ static string array2PythonString(double* array, int row, int col)
 
 extern "C" {
 
-int functionODE_residual(DATA* data, threadData_t *threadData, double *dx, double *dy, double *dz)
+/* odeMask and algMask re-evaluate only the equations affected by the perturbed state or input */
+int functionODE_residual(DATA* data, threadData_t *threadData, double *dx, double *dy, double *dz, EVAL_MASK *odeMask, EVAL_MASK *algMask)
 {
     TRACE_PUSH
 
@@ -120,10 +122,10 @@ int functionODE_residual(DATA* data, threadData_t *threadData, double *dx, doubl
     data->callback->input_function(data, threadData);
 
     /* eval input vars */
-    data->callback->functionODE(data, threadData);
+    maskedEval_functionODE(odeMask, data, threadData);
 
     /* eval algebraic vars */
-    data->callback->functionAlgebraics(data, threadData);
+    maskedEval_functionAlgebraics(algMask, data, threadData);
 
     /* eval output vars */
     data->callback->output_function(data, threadData);
@@ -172,6 +174,7 @@ int functionJacAC_num(DATA* data, threadData_t *threadData, double *matrixA, dou
     double* y1 = (double*)calloc(size_C,sizeof(double));
     double* z0 = 0;
     double* z1 = 0;
+    EVAL_MASK odeMask, algMask;
     double *xScaling = (double*)calloc(size_A,sizeof(double));
 
     assertStreamPrint(threadData,0!=x0,"calloc failed");
@@ -190,7 +193,9 @@ int functionJacAC_num(DATA* data, threadData_t *threadData, double *matrixA, dou
         assertStreamPrint(threadData,0!=z1,"calloc failed");
     }
 
-    functionODE_residual(data, threadData, x0, y0, z0);
+    maskedEval_init(&odeMask, data, data->callback->odeDependencies);
+    maskedEval_init(&algMask, data, data->callback->algebraicDependencies);
+    functionODE_residual(data, threadData, x0, y0, z0, &odeMask, &algMask);
 
     x = data->localData[0]->realVars;
 
@@ -209,7 +214,7 @@ int functionJacAC_num(DATA* data, threadData_t *threadData, double *matrixA, dou
         /* Calculate scaled difference quotient */
         delta_hh = 1. / delta_hh * xScaling[i];
 
-        functionODE_residual(data, threadData, x1, y1, z1);
+        functionODE_residual(data, threadData, x1, y1, z1, &odeMask, &algMask);
 
         for(j = 0; j < size_A; j++) {
             k = i * size_A + j;
@@ -229,6 +234,8 @@ int functionJacAC_num(DATA* data, threadData_t *threadData, double *matrixA, dou
     }
 
     free(xScaling);
+    maskedEval_free(&odeMask);
+    maskedEval_free(&algMask);
     free(x0);
     free(y0);
     free(x1);
@@ -265,6 +272,7 @@ int functionJacBD_num(DATA* data, threadData_t *threadData, double *matrixB, dou
     double* y1 = (double*)calloc(size_y,sizeof(double));
     double* z0 = 0;
     double* z1 = 0;
+    EVAL_MASK odeMask, algMask;
 
     assertStreamPrint(threadData,0!=x0,"calloc failed");
     assertStreamPrint(threadData,0!=y0,"calloc failed");
@@ -278,7 +286,9 @@ int functionJacBD_num(DATA* data, threadData_t *threadData, double *matrixB, dou
         assertStreamPrint(threadData,0!=z1,"calloc failed");
     }
 
-    functionODE_residual(data, threadData, x0, y0, z0);
+    maskedEval_init(&odeMask, data, data->callback->odeDependencies);
+    maskedEval_init(&algMask, data, data->callback->algebraicDependencies);
+    functionODE_residual(data, threadData, x0, y0, z0, &odeMask, &algMask);
 
     u = data->simulationInfo->inputVars;
 
@@ -289,7 +299,7 @@ int functionJacBD_num(DATA* data, threadData_t *threadData, double *matrixB, dou
         u[i] += delta_hh;
         delta_hh = 1. / delta_hh;
 
-        functionODE_residual(data, threadData, x1, y1, z1);
+        functionODE_residual(data, threadData, x1, y1, z1, &odeMask, &algMask);
 
         for(j = 0; j < size_x; j++) {
             k = i * size_x + j;
@@ -308,6 +318,8 @@ int functionJacBD_num(DATA* data, threadData_t *threadData, double *matrixB, dou
         u[i] = usave;
     }
 
+    maskedEval_free(&odeMask);
+    maskedEval_free(&algMask);
     free(x0);
     free(y0);
     free(x1);
@@ -546,6 +558,9 @@ int linearize(DATA* data, threadData_t *threadData)
 
     /* Can currently only extract data recovery matrices Cz and Dz numerically, so we do this first if necessary */
     if(do_data_recovery > 0 || data->simulationInfo->analyticJacobians[data->callback->INDEX_JAC_A].sizeTmpVars == 0){
+        CALL_STATISTICS *stats = &data->simulationInfo->callStatistics;
+        long evaluated = stats->maskedEquationsEvaluated, skipped = stats->maskedEquationsSkipped;
+
         /* Calculate numeric Jacobian */
         if(functionJacAC_num(data, threadData, matrixA, matrixC, matrixCz))
         {
@@ -559,6 +574,8 @@ int linearize(DATA* data, threadData_t *threadData)
             TRACE_POP
             return 1;
         }
+        infoStreamPrint(LOG_STATS, 0, "numerical linearization: %ld equations evaluated, %ld skipped",
+                        stats->maskedEquationsEvaluated - evaluated, stats->maskedEquationsSkipped - skipped);
     }
 
     /* Check if symbolic Jacobian available, if it is then use it (overwriting A,B,C,D if also doing data recovery) */
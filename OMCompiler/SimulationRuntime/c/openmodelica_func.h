@@ -53,11 +53,28 @@ extern "C" {
 #include "util/division.h"
 #include "util/utility.h"
 
+/*
+ * Equations of functionODE, functionAlgebraics or function_ZeroCrossingsEquations
+ * in evaluation order, with the realVars each of them reads and writes.
+ * reads[i] and writes[i] are {n, index_1, ..., index_n}; index nVariablesReal
+ * stands for time and -1 for dependencies that are not known at compile time.
+ * Used by simulation/solver/masked_eval.c.
+ */
+typedef struct EQUATION_DEPENDENCIES {
+  int nEquations;
+  void (* const *equations)(DATA*, threadData_t*);
+  const int *equationIndexes;
+  const int * const *reads;
+  const int * const *writes;
+} EQUATION_DEPENDENCIES;
+
 struct OpenModelicaGeneratedFunctionCallbacks {
   /* Defined in perform_simulation.c and omp_perform_simulation.c */
   int (*performSimulation)(DATA* data, threadData_t*, void* solverInfo);
   int (*performQSSSimulation)(DATA* data, threadData_t*, void* solverInfo);
   void (*updateContinuousSystem)(DATA *data, threadData_t*);
+  /* Event handling after a step, returns a fire_timer_t */
+  int (*simulationUpdate)(DATA* data, threadData_t*, void* solverInfo);
   /* Function for calling external object deconstructors */
   void (*callExternalObjectDestructors)(DATA *_data, threadData_t*);
 
@@ -374,6 +391,13 @@ struct OpenModelicaGeneratedFunctionCallbacks {
   int (*initialPartialFMIDERINIT)(void* data, threadData_t *threadData, ANALYTIC_JACOBIAN* thisJacobian);
   analyticalJacobianColumn_func_ptr functionJacFMIDERINIT_column;
   const int INDEX_JAC_FMIDERINIT;
+
+  /*
+  * Dependency tables for evaluating only the equations affected by changed variables
+  */
+  const EQUATION_DEPENDENCIES *odeDependencies;
+  const EQUATION_DEPENDENCIES *algebraicDependencies;
+  const EQUATION_DEPENDENCIES *zeroCrossingDependencies;
 };
 
 
@@ -152,7 +152,7 @@ static short initial_guess_ipopt_sim(OptData *optData, SOLVER_INFO* solverInfo,
        externalInputUpdate(data);
        smallIntSolverStep(data, threadData, solverInfo, fmin(t += optData->time.dt[0], optData->time.t0));
        printf("\ndone: time[%i] = %g",0,(double)data->localData[0]->timeValue);
-       sim_result.emit(&sim_result,data,threadData);
+       data->simResult->emit(data->simResult, data, threadData);
        fprintf(pFile, "%lf ",(double)data->localData[0]->timeValue);
        for(i = 0; i < nu; ++i){
          fprintf(pFile, "%lf ", (float)data->simulationInfo->inputVars[i]);
@@ -31,6 +31,11 @@
 /*! MoveData.c
  */
 
+#ifdef USE_PARJAC
+  #define GC_THREADS
+  #include <gc/omc_gc.h>
+#endif
+
 #include "../../meta/meta_modelica.h"
 #include "../../openmodelica_types.h"
 #include "../../openmodelica.h"
@@ -39,6 +44,7 @@
 #include "../../simulation/solver/model_help.h"
 #include "../../util/context.h"
 #include "../../util/omc_file.h"
+#include "../../util/omc_init.h"
 #include "../OptimizerData.h"
 #include "../OptimizerLocalFunction.h"
 
@@ -52,8 +58,10 @@ static inline void calculatedScalingHelper(OptDataBounds * bounds, OptDataTime *
 static inline void setRKCoeff(OptDataRK *rk, const int np);
 static inline void printSomeModelInfos(OptDataBounds * bounds, OptDataDim * dim, DATA* data);
 static inline void pickUpStates(OptData* optdata);
-static inline void updateDOSystem(OptData * optData, DATA * data, threadData_t *threadData,
+static inline modelica_boolean updateDOSystem(OptData * optData, DATA * data, threadData_t *threadData,
                                    const int i, const int j, const int index, const int m);
+static void optData2ModelDataThreads(OptData *optData, double *vopt, const int index);
+static void evalWorkerPoints(OptData *optData, OptDataWorker *worker, double *vopt, const int index);
 
 void setLocalVars(OptData * optData, DATA * data, const double * const vopt, const int i, const int j, const int shift);
 
@@ -92,6 +100,9 @@ int pickUpModelData(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInf
   }
   optData->data = data;
   optData->threadData = threadData;
+  optData->threads.n = 1;
+  optData->threads.worker = NULL;
+  optData->threads.values = NULL;
 
   optData->v0 = (modelica_real*)malloc(nReal*sizeof(modelica_real));
   memcpy(optData->v0, data->localData[0]->realVars, nReal*sizeof(modelica_real));
@@ -599,7 +610,7 @@ void res2file(OptData *optData, SOLVER_INFO* solverInfo, double *vopt){
   modelica_real *** v = optData->v;
   float tmp_u;
 
-  int i,j,k, ii, jj;
+  int i,j,k, ii, jj, nThreads;
   char buffer[4096];
   DATA * data = optData->data;
   threadData_t *threadData = optData->threadData;
@@ -622,7 +633,11 @@ void res2file(OptData *optData, SOLVER_INFO* solverInfo, double *vopt){
     assert(0);
   }
 
+  /* sequential, the result file is written from the master data */
+  nThreads = optData->threads.n;
+  optData->threads.n = 1;
   optData2ModelData(optData, vopt, 0);
+  optData->threads.n = nThreads;
 
   /******************/
   fprintf(pFile, "%lf ",(double)t0);
@@ -647,7 +662,7 @@ void res2file(OptData *optData, SOLVER_INFO* solverInfo, double *vopt){
   /*data->callback->functionDAE(data);*/
   updateDiscreteSystem(data, threadData);
 
-  sim_result.emit(&sim_result, data, threadData);
+  data->simResult->emit(data->simResult, data, threadData);
   /******************/
 
   for(ii = 0; ii < nsi; ++ii){
@@ -664,7 +679,7 @@ void res2file(OptData *optData, SOLVER_INFO* solverInfo, double *vopt){
       /******************/
       solverInfo->currentTime = (double)t[ii][jj];
       sData->timeValue = solverInfo->currentTime;
-      sim_result.emit(&sim_result, data, threadData);
+      data->simResult->emit(data->simResult, data, threadData);
     }
   }
   fclose(pFile);
@@ -706,6 +721,11 @@ void optData2ModelData(OptData *optData, double *vopt, const int index){
   const int * indexBC = optData->s.indexABCD + 3;
   threadData_t *threadData = optData->threadData;
 
+  if(optData->threads.n > 1){
+    optData2ModelDataThreads(optData, vopt, index);
+    return;
+  }
+
   for(l = 0; l < 3; ++l)
     realVars[l] = data->localData[l]->realVars;
 
@@ -715,24 +735,25 @@ void optData2ModelData(OptData *optData, double *vopt, const int index){
   }
   copy_initial_values(optData, data);
 
+  optData->scc = 1;
   for(i = 0, shift = 0; i < nsi-1; ++i){
     for(j = 0; j < np; ++j, shift += nv){
       setLocalVars(optData, data, vopt, i, j, shift);
-      updateDOSystem(optData, data, threadData, i, j, index, 2);
+      optData->scc &= updateDOSystem(optData, data, threadData, i, j, index, 2);
     }
   }
 
   for(j = 0; j < np-1; ++j, shift += nv){
     setLocalVars(optData, data, vopt, i, j, shift);
-    updateDOSystem(optData, data, threadData, i, j, index, 2);
+    optData->scc &= updateDOSystem(optData, data, threadData, i, j, index, 2);
   }
   setLocalVars(optData, data, vopt, i, j, shift);
-  updateDOSystem(optData, data, threadData, i, j, index, 3);
+  optData->scc &= updateDOSystem(optData, data, threadData, i, j, index, 3);
 
   /*terminal constraint(s)*/
   if(index){
     if(optData->s.matrix[3])
-      diffSynColoredOptimizerSystemF(optData, optData->Jf);
+      diffSynColoredOptimizerSystemF(optData, data, threadData, optData->Jf);
   }
 
   for(l = 0; l < 3; ++l)
@@ -745,28 +766,121 @@ void optData2ModelData(OptData *optData, double *vopt, const int index){
 }
 
 
+/*!
+ *  transfer optimizer data to the model data copies of the threads,
+ *  every thread evaluates a contiguous part of the time grid
+ **/
+static void optData2ModelDataThreads(OptData *optData, double *vopt, const int index){
+  OptDataThreads *threads = &optData->threads;
+  int t;
+
+#ifdef USE_PARJAC
+  GC_allow_register_threads();
+#endif
+
+#pragma omp parallel num_threads(threads->n) default(none) firstprivate(index) shared(optData, vopt, threads)
+{
+#ifdef USE_PARJAC
+  /* Register omp-thread in GC */
+  if(!GC_thread_is_registered()) {
+     struct GC_stack_base sb;
+     memset (&sb, 0, sizeof(sb));
+     GC_get_stack_base(&sb);
+     GC_register_my_thread (&sb);
+  }
+#endif
+
+#pragma omp for schedule(static, 1)
+  for(t = 0; t < threads->n; ++t){
+    evalWorkerPoints(optData, &threads->worker[t], vopt, index);
+  }
+} // omp parallel
+
+  optData->scc = 1;
+  for(t = 0; t < threads->n; ++t)
+    optData->scc &= threads->worker[t].scc;
+}
+
+/*!
+ *  helper optData2ModelDataThreads
+ *  evaluate the collocation points of one partition on the model data copy
+ *  of the worker, each partition starts from the initial discrete state
+ **/
+static void evalWorkerPoints(OptData *optData, OptDataWorker *worker, double *vopt, const int index){
+  const int nv = optData->dim.nv;
+  const int np = optData->dim.np;
+  const int nt = optData->dim.nt;
+  const int * indexBC = optData->s.indexABCD + 3;
+  double * values = optData->threads.values;
+
+  DATA * data = worker->data;
+  threadData_t *threadData = worker->threadData;
+  void *parentThreadData = pthread_getspecific(mmc_thread_data_key);
+  modelica_real * realVars[3];
+  modelica_real * tmpVars[2] = {NULL, NULL};
+  int i, j, k, l;
+
+  pthread_setspecific(mmc_thread_data_key, threadData);
+
+  for(l = 0; l < 3; ++l)
+    realVars[l] = data->localData[l]->realVars;
+
+  for(l = 0; l< 2; ++l){
+    if(optData->s.matrix[l])
+      tmpVars[l] = data->simulationInfo->analyticJacobians[indexBC[l]].tmpVars;
+  }
+  copy_initial_values(optData, data);
+
+  worker->scc = 1;
+  for(k = worker->first; k < worker->last; ++k){
+    i = k / np;
+    j = k % np;
+    setLocalVars(optData, data, vopt, i, j, k*nv);
+    worker->scc &= updateDOSystem(optData, data, threadData, i, j, index, (k == nt-1) ? 3 : 2);
+
+    if(index && values)
+      evalfDiffGPoint(optData, i, j, values);
+  }
+
+  /*terminal constraint(s)*/
+  if(index && worker->last == nt){
+    if(optData->s.matrix[3])
+      diffSynColoredOptimizerSystemF(optData, data, threadData, optData->Jf);
+  }
+
+  for(l = 0; l < 3; ++l)
+    data->localData[l]->realVars = realVars[l];
+
+  for(l = 0; l< 2; ++l)
+    if(optData->s.matrix[l])
+      data->simulationInfo->analyticJacobians[indexBC[l]].tmpVars = tmpVars[l];
+
+  pthread_setspecific(mmc_thread_data_key, parentThreadData);
+}
+
 /*!
  *  helper optData2ModelData
  *  author: Vitalij Ruge
  **/
-static inline void updateDOSystem(OptData * optData, DATA * data, threadData_t *threadData,
+static inline modelica_boolean updateDOSystem(OptData * optData, DATA * data, threadData_t *threadData,
                                    const int i, const int j, const int index, const int m){
 
+  volatile modelica_boolean scc = 0;
     /* try */
-  optData->scc = 0;
 #if !defined(OMC_EMCC)
     MMC_TRY_INTERNAL(simulationJumpBuffer)
 #endif
-    data->callback->input_function(data, optData->threadData);
-    updateDiscreteSystem(data, optData->threadData);
+    data->callback->input_function(data, threadData);
+    updateDiscreteSystem(data, threadData);
 
     if(index){
-      diffSynColoredOptimizerSystem(optData, optData->J[i][j], i, j, m);
+      diffSynColoredOptimizerSystem(optData, data, threadData, optData->J[i][j], i, j, m);
     }
-    optData->scc = 1;
+    scc = 1;
 #if !defined(OMC_EMCC)
     MMC_CATCH_INTERNAL(simulationJumpBuffer)
 #endif
+  return scc;
 }
 
 /*!
@@ -809,9 +923,8 @@ void setLocalVars(OptData * optData, DATA * data, const double * const vopt,
  *  function calculates a symbolic colored jacobian matrix of the optimization system
  *  authors: Willi Braun, Vitalij Ruge
  */
-void diffSynColoredOptimizerSystem(OptData *optData, modelica_real **J, const int m, const int n, const int index){
-  DATA * data = optData->data;
-  threadData_t *threadData = optData->threadData;
+void diffSynColoredOptimizerSystem(OptData *optData, DATA *data, threadData_t *threadData, modelica_real **J,
+                                   const int m, const int n, const int index){
   int i,j,l,ii, ll;
 
   const int h_index = optData->s.indexABCD[index];
@@ -874,10 +987,8 @@ void diffSynColoredOptimizerSystem(OptData *optData, modelica_real **J, const in
   unsetContext(data);
 }
 
-void diffSynColoredOptimizerSystemF(OptData *optData, modelica_real **J){
+void diffSynColoredOptimizerSystemF(OptData *optData, DATA *data, threadData_t *threadData, modelica_real **J){
   if(optData->dim.ncf > 0){
-    DATA * data = optData->data;
-    threadData_t *threadData = optData->threadData;
     int i,j,l,ii, ll;
     const int index = 4;
     const int h_index = optData->s.indexABCD[index];
@@ -0,0 +1,315 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-2014, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+
+/*! WorkerData.c
+ *  copies of the model data for the threaded evaluation of the collocation points
+ */
+
+#include "../OptimizerData.h"
+#include "../OptimizerLocalFunction.h"
+#include "../../simulation/options.h"
+#include "../../simulation/solver/model_help.h"
+#include "../../simulation/solver/linearSystem.h"
+#include "../../simulation/solver/nonlinearSystem.h"
+#include "../../simulation/solver/mixedSystem.h"
+#include "../../util/omc_init.h"
+
+static inline int workerThreads(OptData *optData);
+static DATA* cloneModelData(OptData *optData, threadData_t *threadData);
+static void freeModelData(OptData *optData, DATA *data, threadData_t *threadData);
+
+/*!
+ *  allocate one copy of the model data for every thread and split
+ *  the collocation points in contiguous partitions
+ **/
+void allocate_worker_data(OptData *optData){
+  OptDataThreads *threads = &optData->threads;
+  const int nt = optData->dim.nt;
+  int t;
+
+  threads->n = workerThreads(optData);
+  threads->worker = NULL;
+  threads->values = NULL;
+  if(threads->n < 2)
+    return;
+
+  threads->worker = (OptDataWorker*) calloc(threads->n, sizeof(OptDataWorker));
+  for(t = 0; t < threads->n; ++t){
+    OptDataWorker *worker = &threads->worker[t];
+    worker->threadData = (threadData_t*) omc_alloc_interface.malloc_uncollectable(sizeof(threadData_t));
+    memset(worker->threadData, 0, sizeof(threadData_t));
+#if !defined(OMC_NO_THREADS)
+    pthread_mutex_init(&worker->threadData->parentMutex, NULL);
+#endif
+    worker->data = cloneModelData(optData, worker->threadData);
+    worker->first = (int)(((long)t*nt)/threads->n);
+    worker->last = (int)(((long)(t+1)*nt)/threads->n);
+    worker->scc = 1;
+  }
+  infoStreamPrint(LOG_IPOPT, 0, "evaluate %i collocation points with %i threads", nt, threads->n);
+}
+
+/*!
+ *  free the data allocated by allocate_worker_data
+ **/
+void free_worker_data(OptData *optData){
+  OptDataThreads *threads = &optData->threads;
+  int t;
+
+  for(t = 0; t < threads->n && threads->worker; ++t){
+    freeModelData(optData, threads->worker[t].data, threads->worker[t].threadData);
+    omc_alloc_interface.free_uncollectable(threads->worker[t].threadData);
+  }
+  free(threads->worker);
+  threads->worker = NULL;
+  threads->n = 1;
+}
+
+/*!
+ *  number of threads from -optimizerThreads, 1 if the model data can't
+ *  be evaluated on independent copies
+ **/
+static inline int workerThreads(OptData *optData){
+  DATA *data = optData->data;
+  char *cflags = (char*)omc_flagValue[FLAG_OPTIMIZER_THREADS];
+  int n = 1;
+
+  if(!cflags)
+    return 1;
+
+  n = atoi(cflags);
+#ifndef USE_PARJAC
+  if(n > 1){
+    warningStreamPrint(LOG_STDOUT, 0, "Simulation flag optimizerThreads not available. Make sure you have configured omc with \"--enable-parjac\" and build with a compiler supporting OpenMP.");
+  }
+  return 1;
+#else
+  if(n < 1){
+    warningStreamPrint(LOG_STDOUT, 0, "not support %i threads for the optimizer, use 1.", n);
+    return 1;
+  }
+  /* delay buffers, state sets, spatial distributions and external objects
+   * are shared between the copies and updated during the evaluation */
+  if(n > 1 && (data->modelData->nDelayExpressions > 0 || data->modelData->nStateSets > 0 ||
+               data->modelData->nSpatialDistributions > 0 || data->modelData->nExtObjs > 0)){
+    warningStreamPrint(LOG_STDOUT, 0, "optimizerThreads=%i is not supported for models with delay expressions, "
+                       "dynamic state selection, spatialDistribution or external objects, use 1 thread.", n);
+    return 1;
+  }
+  /* every partition starts from the initial discrete state, so events,
+   * relations and discrete variables would differ from the sequential run */
+  if(n > 1 && (data->modelData->nZeroCrossings > 0 || data->modelData->nRelations > 0 ||
+               data->modelData->nMathEvents > 0 || data->modelData->nSamples > 0 ||
+               data->modelData->nDiscreteReal > 0 || data->modelData->nVariablesInteger > 0 ||
+               data->modelData->nVariablesBoolean > 0)){
+    warningStreamPrint(LOG_STDOUT, 0, "optimizerThreads=%i is not supported for models with events, relations "
+                       "or discrete variables, use 1 thread.", n);
+    return 1;
+  }
+  return (n > optData->dim.nt) ? optData->dim.nt : n;
+#endif
+}
+
+/*!
+ *  copy of the model data sharing the static model data, parameters and
+ *  the jacobian structures with the master, but with its own variables,
+ *  pre values, relations, algebraic loop solvers and jacobian buffers
+ **/
+static DATA* cloneModelData(OptData *optData, threadData_t *threadData){
+  DATA *master = optData->data;
+  MODEL_DATA *mData = master->modelData;
+  DATA *data = (DATA*) malloc(sizeof(DATA));
+  SIMULATION_INFO *sInfo = (SIMULATION_INFO*) malloc(sizeof(SIMULATION_INFO));
+  SIMULATION_DATA tmpSimData = {0};
+  int i, k;
+
+  *data = *master;
+  *sInfo = *master->simulationInfo;
+  data->simulationInfo = sInfo;
+
+  /* ring buffer with the current values of the master */
+  data->simulationData = allocRingBuffer(SIZERINGBUFFER, sizeof(SIMULATION_DATA));
+  for(i = 0; i < SIZERINGBUFFER; ++i){
+    tmpSimData.timeValue = master->localData[i]->timeValue;
+    tmpSimData.realVars = (modelica_real*) malloc(mData->nVariablesReal*sizeof(modelica_real));
+    memcpy(tmpSimData.realVars, master->localData[i]->realVars, mData->nVariablesReal*sizeof(modelica_real));
+    tmpSimData.integerVars = (modelica_integer*) malloc(mData->nVariablesInteger*sizeof(modelica_integer));
+    memcpy(tmpSimData.integerVars, master->localData[i]->integerVars, mData->nVariablesInteger*sizeof(modelica_integer));
+    tmpSimData.booleanVars = (modelica_boolean*) malloc(mData->nVariablesBoolean*sizeof(modelica_boolean));
+    memcpy(tmpSimData.booleanVars, master->localData[i]->booleanVars, mData->nVariablesBoolean*sizeof(modelica_boolean));
+#if !defined(OMC_NVAR_STRING) || OMC_NVAR_STRING>0
+    tmpSimData.stringVars = (modelica_string*) omc_alloc_interface.malloc_uncollectable(mData->nVariablesString*sizeof(modelica_string));
+    memcpy(tmpSimData.stringVars, master->localData[i]->stringVars, mData->nVariablesString*sizeof(modelica_string));
+#endif
+    appendRingData(data->simulationData, &tmpSimData);
+  }
+  data->localData = (SIMULATION_DATA**) omc_alloc_interface.malloc_uncollectable(SIZERINGBUFFER*sizeof(SIMULATION_DATA));
+  memset(data->localData, 0, SIZERINGBUFFER*sizeof(SIMULATION_DATA));
+  lookupRingBuffer(data->simulationData, (void**) data->localData);
+
+  /* values changed by the model equations */
+  sInfo->zeroCrossings = (modelica_real*) calloc(mData->nZeroCrossings, sizeof(modelica_real));
+  sInfo->zeroCrossingsPre = (modelica_real*) calloc(mData->nZeroCrossings, sizeof(modelica_real));
+  sInfo->relations = (modelica_boolean*) malloc(mData->nRelations*sizeof(modelica_boolean));
+  memcpy(sInfo->relations, master->simulationInfo->relations, mData->nRelations*sizeof(modelica_boolean));
+  sInfo->relationsPre = (modelica_boolean*) malloc(mData->nRelations*sizeof(modelica_boolean));
+  memcpy(sInfo->relationsPre, master->simulationInfo->relationsPre, mData->nRelations*sizeof(modelica_boolean));
+  sInfo->storedRelations = (modelica_boolean*) malloc(mData->nRelations*sizeof(modelica_boolean));
+  memcpy(sInfo->storedRelations, master->simulationInfo->storedRelations, mData->nRelations*sizeof(modelica_boolean));
+  sInfo->mathEventsValuePre = (modelica_real*) malloc(mData->nMathEvents*sizeof(modelica_real));
+  memcpy(sInfo->mathEventsValuePre, master->simulationInfo->mathEventsValuePre, mData->nMathEvents*sizeof(modelica_real));
+
+  sInfo->realVarsPre = (modelica_real*) malloc(mData->nVariablesReal*sizeof(modelica_real));
+  memcpy(sInfo->realVarsPre, master->simulationInfo->realVarsPre, mData->nVariablesReal*sizeof(modelica_real));
+  sInfo->integerVarsPre = (modelica_integer*) malloc(mData->nVariablesInteger*sizeof(modelica_integer));
+  memcpy(sInfo->integerVarsPre, master->simulationInfo->integerVarsPre, mData->nVariablesInteger*sizeof(modelica_integer));
+  sInfo->booleanVarsPre = (modelica_boolean*) malloc(mData->nVariablesBoolean*sizeof(modelica_boolean));
+  memcpy(sInfo->booleanVarsPre, master->simulationInfo->booleanVarsPre, mData->nVariablesBoolean*sizeof(modelica_boolean));
+#if !defined(OMC_NVAR_STRING) || OMC_NVAR_STRING>0
+  sInfo->stringVarsPre = (modelica_string*) omc_alloc_interface.malloc_uncollectable(mData->nVariablesString*sizeof(modelica_string));
+  memcpy(sInfo->stringVarsPre, master->simulationInfo->stringVarsPre, mData->nVariablesString*sizeof(modelica_string));
+#endif
+
+  sInfo->inputVars = (modelica_real*) malloc(mData->nInputVars*sizeof(modelica_real));
+  memcpy(sInfo->inputVars, master->simulationInfo->inputVars, mData->nInputVars*sizeof(modelica_real));
+  sInfo->outputVars = (modelica_real*) calloc(mData->nOutputVars, sizeof(modelica_real));
+  sInfo->setcVars = (modelica_real*) calloc(mData->nSetcVars, sizeof(modelica_real));
+  sInfo->datainputVars = (modelica_real*) calloc(mData->ndataReconVars, sizeof(modelica_real));
+  sInfo->setbVars = (modelica_real*) calloc(mData->nSetbVars, sizeof(modelica_real));
+
+  /* jacobians of the optimizer: own buffers, shared sparse pattern;
+   * the jacobians of the algebraic loops are set up with the loop solvers */
+  sInfo->analyticJacobians = (ANALYTIC_JACOBIAN*) omc_alloc_interface.malloc_uncollectable(mData->nJacobians*sizeof(ANALYTIC_JACOBIAN));
+  memset(sInfo->analyticJacobians, 0, mData->nJacobians*sizeof(ANALYTIC_JACOBIAN));
+  for(k = 2; k < 5; ++k){
+    if(optData->s.matrix[k]){
+      ANALYTIC_JACOBIAN *jac = &sInfo->analyticJacobians[optData->s.indexABCD[k]];
+      *jac = master->simulationInfo->analyticJacobians[optData->s.indexABCD[k]];
+      jac->seedVars = NULL;
+      jac->tmpVars = (modelica_real*) calloc(jac->sizeTmpVars, sizeof(modelica_real));
+      jac->resultVars = (modelica_real*) calloc(jac->sizeRows, sizeof(modelica_real));
+    }
+  }
+
+  /* algebraic loops */
+  sInfo->nlsCsvInfomation = 0;
+#if !defined(OMC_NUM_MIXED_SYSTEMS) || OMC_NUM_MIXED_SYSTEMS>0
+  if(mData->nMixedSystems){
+    sInfo->mixedSystemData = (MIXED_SYSTEM_DATA*) omc_alloc_interface.malloc_uncollectable(mData->nMixedSystems*sizeof(MIXED_SYSTEM_DATA));
+    data->callback->initialMixedSystem(mData->nMixedSystems, sInfo->mixedSystemData);
+  }
+#endif
+#if !defined(OMC_NUM_LINEAR_SYSTEMS) || OMC_NUM_LINEAR_SYSTEMS>0
+  if(mData->nLinearSystems){
+    sInfo->linearSystemData = (LINEAR_SYSTEM_DATA*) omc_alloc_interface.malloc_uncollectable(mData->nLinearSystems*sizeof(LINEAR_SYSTEM_DATA));
+    data->callback->initialLinearSystem(mData->nLinearSystems, sInfo->linearSystemData);
+  }
+#endif
+#if !defined(OMC_NUM_NONLINEAR_SYSTEMS) || OMC_NUM_NONLINEAR_SYSTEMS>0
+  if(mData->nNonLinearSystems){
+    sInfo->nonlinearSystemData = (NONLINEAR_SYSTEM_DATA*) omc_alloc_interface.malloc_uncollectable(mData->nNonLinearSystems*sizeof(NONLINEAR_SYSTEM_DATA));
+    data->callback->initialNonLinearSystem(mData->nNonLinearSystems, sInfo->nonlinearSystemData);
+  }
+#endif
+  initializeMixedSystems(data, threadData);
+  initializeLinearSystems(data, threadData);
+  initializeNonlinearSystems(data, threadData);
+
+  return data;
+}
+
+/*!
+ *  free a copy from cloneModelData
+ **/
+static void freeModelData(OptData *optData, DATA *data, threadData_t *threadData){
+  MODEL_DATA *mData = data->modelData;
+  SIMULATION_INFO *sInfo = data->simulationInfo;
+  SIMULATION_DATA *tmpSimData;
+  int i, k;
+
+  freeMixedSystems(data, threadData);
+  freeLinearSystems(data, threadData);
+  freeNonlinearSystems(data, threadData);
+#if !defined(OMC_NUM_MIXED_SYSTEMS) || OMC_NUM_MIXED_SYSTEMS>0
+  if(mData->nMixedSystems)
+    omc_alloc_interface.free_uncollectable(sInfo->mixedSystemData);
+#endif
+#if !defined(OMC_NUM_LINEAR_SYSTEMS) || OMC_NUM_LINEAR_SYSTEMS>0
+  if(mData->nLinearSystems)
+    omc_alloc_interface.free_uncollectable(sInfo->linearSystemData);
+#endif
+#if !defined(OMC_NUM_NONLINEAR_SYSTEMS) || OMC_NUM_NONLINEAR_SYSTEMS>0
+  if(mData->nNonLinearSystems)
+    omc_alloc_interface.free_uncollectable(sInfo->nonlinearSystemData);
+#endif
+
+  for(k = 2; k < 5; ++k){
+    if(optData->s.matrix[k]){
+      ANALYTIC_JACOBIAN *jac = &sInfo->analyticJacobians[optData->s.indexABCD[k]];
+      free(jac->tmpVars);
+      free(jac->resultVars);
+    }
+  }
+  omc_alloc_interface.free_uncollectable(sInfo->analyticJacobians);
+
+  free(sInfo->zeroCrossings);
+  free(sInfo->zeroCrossingsPre);
+  free(sInfo->relations);
+  free(sInfo->relationsPre);
+  free(sInfo->storedRelations);
+  free(sInfo->mathEventsValuePre);
+  free(sInfo->realVarsPre);
+  free(sInfo->integerVarsPre);
+  free(sInfo->booleanVarsPre);
+#if !defined(OMC_NVAR_STRING) || OMC_NVAR_STRING>0
+  omc_alloc_interface.free_uncollectable(sInfo->stringVarsPre);
+#endif
+  free(sInfo->inputVars);
+  free(sInfo->outputVars);
+  free(sInfo->setcVars);
+  free(sInfo->datainputVars);
+  free(sInfo->setbVars);
+
+  for(i = 0; i < SIZERINGBUFFER; ++i){
+    tmpSimData = (SIMULATION_DATA*) getRingData(data->simulationData, i);
+    free(tmpSimData->realVars);
+    free(tmpSimData->integerVars);
+    free(tmpSimData->booleanVars);
+#if !defined(OMC_NVAR_STRING) || OMC_NVAR_STRING>0
+    omc_alloc_interface.free_uncollectable(tmpSimData->stringVars);
+#endif
+  }
+  omc_alloc_interface.free_uncollectable(data->localData);
+  freeRingBuffer(data->simulationData);
+
+  free(sInfo);
+  free(data);
+}
@@ -154,6 +154,22 @@ typedef struct OptDataStructure{
   int indexABCD[5];
 }OptDataStructure;
 
+/* copy of the model data used by one thread to evaluate
+ * the collocation points first, ..., last-1 (index i*np + j)
+ */
+typedef struct OptDataWorker{
+  DATA *data;
+  threadData_t *threadData;
+  int first;
+  int last;
+  modelica_boolean scc;
+}OptDataWorker;
+
+typedef struct OptDataThreads{
+  int n;
+  OptDataWorker *worker;
+  double *values;
+}OptDataThreads;
 
 typedef struct OptData{
   OptDataDim dim;
@@ -162,6 +178,7 @@ typedef struct OptData{
   OptDataRK rk;
   OptDataStructure s;
   OptDataIpopt ipop;
+  OptDataThreads threads;
 
   modelica_real ***v;
   modelica_real *v0;
@@ -44,12 +44,17 @@ void initial_guess_optimizer(OptData *optData, SOLVER_INFO* solverInfo);
 void res2file(OptData *optData, SOLVER_INFO* solverInfo,double * v);
 void optData2ModelData(OptData *optData, double *vopt, const int index);
 
-void diffSynColoredOptimizerSystem(OptData *optData, modelica_real **J, const int i, const int j, const int index);
-void diffSynColoredOptimizerSystemF(OptData *optData, modelica_real **J);
+void diffSynColoredOptimizerSystem(OptData *optData, DATA *data, threadData_t *threadData, modelica_real **J,
+                                   const int i, const int j, const int index);
+void diffSynColoredOptimizerSystemF(OptData *optData, DATA *data, threadData_t *threadData, modelica_real **J);
 void debugeJac(OptData * optData,Number* vopt);
 void debugeSteps(OptData * optData, modelica_real*vopt, modelica_real * lambda);
 void copy_initial_values(OptData * optData, DATA* data);
 void setLocalVars(OptData * optData, DATA * data, const double * const vopt, const int i, const int j, const int shift);
+void evalfDiffGPoint(OptData *optData, const int i, const int j, double *values);
+
+void allocate_worker_data(OptData *optData);
+void free_worker_data(OptData *optData);
 
 /*ipopt*/
 
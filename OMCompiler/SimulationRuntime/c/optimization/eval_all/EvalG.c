@@ -201,111 +201,31 @@ Bool evalfDiffG(Index n, double * vopt, Bool new_x, Index m, Index njac, Index *
     const int np = optData->dim.np;
     const int nx = optData->dim.nx;
     const int nv = optData->dim.nv;
-    const int nJ = optData->dim.nJ;
+    const int nt = optData->dim.nt;
     const int ncf = optData->dim.ncf;
-    modelica_boolean ** J = optData->s.JderCon;
+    const int NJ = optData->dim.nJderx;
     modelica_boolean ** Jf = optData->s.J[2];
-    int i, j, k, l, ii, cindex;
+    int l, ii, k;
     ++optData->iter_;
-    if(new_x){
+    if(new_x && optData->threads.n > 1){
+      /* the threads write the blocks of their collocation points directly */
+      optData->threads.values = values;
       optData2ModelData(optData, vopt, 1);
-    }
-    if(np == 3){
-      /*****************************/
-      for(j = 0, k = 0; j < np; ++j){
-        for(l = 0; l < nx; ++l){
-          switch(j){
-            case 0:
-              structJac01(optData->rk.a[j], optData->J[0][j][l],
-                  values, nv, &k, l, J[l]);
-              break;
-            case 1:
-              structJac02(optData->rk.a[j], optData->J[0][j][l],
-                  values, nv, &k, l, J[l]);
-              break;
-            case 2:
-              structJac03(optData->rk.a[j], optData->J[0][j][l],
-                  values, nv, &k, l, J[l]);
-              break;
-          }
-        }
-        for(; l< nJ; ++l){
-          structJacC(optData->J[0][j][l], values, nv, &k, J[l]);
-        }
-      }
-
-      /*****************************/
-      for(i = 1; i < nsi; ++i){
-        for(j = 0; j < np; ++j){
-          for(l = 0; l < nx; ++l){
-            switch(j){
-              case 0:
-                structJac1(optData->rk.a[j], optData->J[i][j][l],
-                    values, nv, &k, l, J[l]);
-                break;
-              case 1:
-                structJac2(optData->rk.a[j], optData->J[i][j][l],
-                    values, nv, &k, l, J[l]);
-                break;
-              case 2:
-                structJac3(optData->rk.a[j], optData->J[i][j][l],
-                    values, nv, &k, l, J[l]);
-                break;
-            }
-          }
-          for(; l< nJ; ++l){
-            structJacC(optData->J[i][j][l], values, nv, &k, J[l]);
-          }
-        }
-      }
-      /*terminal constraint(s)*/
-      for(l = 0; l< ncf; ++l){
-        structJacC(optData->Jf[l], values, nv, &k, Jf[l]);
-      }
-
-    }else if(np == 1){
-      /*****************************/
-      for(j = 0, k = 0; j < np; ++j){
-        for(l = 0; l < nx; ++l){
-          for(ii = 0; ii < nv; ++ii)
-            if(J[l][ii]){
-              values[k++] = (modelica_real)((ii == l) ? optData->J[0][j][l][ii] - 1.0 : optData->J[0][j][l][ii]);
-            }
-          }
-        for(; l < nJ; ++l){
-          for(ii = 0; ii < nv; ++ii)
-            if(J[l][ii]){
-              values[k++] = (modelica_real)(optData->J[0][j][l][ii]);
-            }
-          }
-
-        }
-      /*****************************/
-      for(i = 1; i < nsi; ++i){
-        for(j = 0; j < np; ++j){
-          for(l = 0; l < nx; ++l){
-            if(l < nx)
-              values[k++] = 1.0;
-            for(ii = 0; ii < nv; ++ii){
-              if(J[l][ii]){
-                values[k++] = (modelica_real)((ii == l) ? optData->J[i][j][l][ii] - 1.0 : optData->J[i][j][l][ii]);
-              }
-            }
-          }
-          for(; l < nJ; ++l){
-            for(ii = 0; ii < nv; ++ii){
-              if(J[l][ii]){
-                values[k++] = (modelica_real)(optData->J[i][j][l][ii]);
-              }
-            }
-          }
-        }
+      optData->threads.values = NULL;
+    }else{
+      if(new_x){
+        optData2ModelData(optData, vopt, 1);
       }
-      /*terminal constraint(s)*/
-      for(l=0; l< ncf; ++l){
-        structJacC(optData->Jf[l], values, nv, &k, Jf[l]);
+#pragma omp parallel for num_threads(optData->threads.n) if(optData->threads.n > 1)
+      for(ii = 0; ii < nt; ++ii){
+        evalfDiffGPoint(optData, ii/np, ii%np, values);
       }
     }
+    /*terminal constraint(s)*/
+    k = np*(NJ*nsi + nx*(np*nsi - 1));
+    for(l = 0; l< ncf; ++l){
+      structJacC(optData->Jf[l], values, nv, &k, Jf[l]);
+    }
     /*****************************/
     /*
     {
@@ -331,6 +251,69 @@ Bool evalfDiffG(Index n, double * vopt, Bool new_x, Index m, Index njac, Index *
   return TRUE;
 }
 
+/*!
+ *  write the block of the collocation point (i,j) into the values of the
+ *  global jacobian, the offset follows from the structure of the previous
+ *  blocks (see generated_jac_struc)
+ **/
+void evalfDiffGPoint(OptData *optData, const int i, const int j, double *values){
+  const int np = optData->dim.np;
+  const int nx = optData->dim.nx;
+  const int nv = optData->dim.nv;
+  const int nJ = optData->dim.nJ;
+  const int NJ = optData->dim.nJderx;
+  modelica_boolean ** J = optData->s.JderCon;
+  modelica_real ** Jij = optData->J[i][j];
+  const long double * const a = optData->rk.a[j];
+  int k, l, ii;
+
+  if(i == 0)
+    k = j*(NJ + nx*(np - 1));
+  else
+    k = np*(NJ + nx*(np - 1)) + ((i - 1)*np + j)*(NJ + nx*np);
+
+  if(np == 3){
+    for(l = 0; l < nx; ++l){
+      switch(j){
+        case 0:
+          if(i == 0)
+            structJac01(a, Jij[l], values, nv, &k, l, J[l]);
+          else
+            structJac1(a, Jij[l], values, nv, &k, l, J[l]);
+          break;
+        case 1:
+          if(i == 0)
+            structJac02(a, Jij[l], values, nv, &k, l, J[l]);
+          else
+            structJac2(a, Jij[l], values, nv, &k, l, J[l]);
+          break;
+        case 2:
+          if(i == 0)
+            structJac03(a, Jij[l], values, nv, &k, l, J[l]);
+          else
+            structJac3(a, Jij[l], values, nv, &k, l, J[l]);
+          break;
+      }
+    }
+    for(; l < nJ; ++l){
+      structJacC(Jij[l], values, nv, &k, J[l]);
+    }
+  }else if(np == 1){
+    for(l = 0; l < nx; ++l){
+      if(i > 0)
+        values[k++] = 1.0;
+      for(ii = 0; ii < nv; ++ii){
+        if(J[l][ii]){
+          values[k++] = (modelica_real)((ii == l) ? Jij[l][ii] - 1.0 : Jij[l][ii]);
+        }
+      }
+    }
+    for(; l < nJ; ++l){
+      structJacC(Jij[l], values, nv, &k, J[l]);
+    }
+  }
+}
+
 /*!
  *  helper evalfDiffG
  *  author: Vitalij Ruge
@@ -202,7 +202,7 @@ static inline void num_hessian0(double * v, const double * const lambda,
     /*data->callback->functionDAE(data);*/
     updateDiscreteSystem(data, threadData);
     /********************/
-    diffSynColoredOptimizerSystem(optData, optData->tmpJ, i,j,2);
+    diffSynColoredOptimizerSystem(optData, optData->data, optData->threadData, optData->tmpJ, i,j,2);
     /********************/
     v[ii] = (double)v_save;
     /********************/
@@ -292,7 +292,7 @@ static inline void num_hessian1(double * v, const double * const lambda,
     /*data->callback->functionDAE(data);*/
     updateDiscreteSystem(data, threadData);
     /********************/
-    diffSynColoredOptimizerSystem(optData, optData->tmpJ, i,j,indexJ);
+    diffSynColoredOptimizerSystem(optData, optData->data, optData->threadData, optData->tmpJ, i,j,indexJ);
     /********************/
     v[ii] = (double)v_save;
     /********************/
@@ -326,7 +326,7 @@ static inline void num_hessian1(double * v, const double * const lambda,
     }
     /********************/
     if(upFinalCon && ncf > 0){
-      diffSynColoredOptimizerSystemF(optData, optData->tmpJf);
+      diffSynColoredOptimizerSystemF(optData, optData->data, optData->threadData, optData->tmpJf);
       for(jj = 0; jj <ii+1; ++jj){
         if(optData->s.H0[ii][jj]){
           for(l = 0; l < ncf; ++l){
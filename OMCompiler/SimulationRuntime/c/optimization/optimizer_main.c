@@ -51,6 +51,7 @@ int runOptimizer(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInfo){
 
   initial_guess_optimizer(optData, solverInfo);
   allocate_der_struct(&optData->s, &optData->dim ,data, optData);
+  allocate_worker_data(optData);
 
   optimizationWithIpopt(optData);
   res2file(optData, solverInfo, optData->ipop.vopt);
@@ -229,6 +230,8 @@ static inline void freeOptimizerData(OptData*optData){
 
   int i,j,k;
 
+  free_worker_data(optData);
+
   /*************************/
   for(i=0; i < nsi; ++i)
     free(optData->time.t[i]);
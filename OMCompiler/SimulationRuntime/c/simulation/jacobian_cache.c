@@ -0,0 +1,530 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-2019, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/*! \file jacobian_cache.c
+ */
+
+#include "jacobian_cache.h"
+
+#if !defined(OMC_MINIMAL_RUNTIME)
+
+#include "options.h"
+#include "../util/omc_error.h"
+#include "../util/omc_file.h"
+#include "../util/omc_mmap.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__MINGW32__) || defined(_MSC_VER)
+#include <process.h>
+#define getpid _getpid
+#endif
+
+#define PATTERN_CACHE_MAGIC "OMSPCACH"
+#define PATTERN_CACHE_VERSION 2
+#define PATTERN_CACHE_NAME_LENGTH 48
+
+/* Layout of the cache file: header, nEntries entries, then for every entry
+ * leadindex[n_leadIndex+1], index[numberOfNonZeros] and colorCols[n_leadIndex]
+ * as unsigned int at offset. All sizes are multiples of 8 bytes, the arrays
+ * are aligned in the mapped file. */
+typedef struct PATTERN_CACHE_HEADER
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t nEntries;
+  uint64_t key;                       /* hash of the model GUID */
+  uint64_t size;                      /* size of the file in bytes */
+} PATTERN_CACHE_HEADER;
+
+typedef struct PATTERN_CACHE_ENTRY
+{
+  char name[PATTERN_CACHE_NAME_LENGTH];
+  uint32_t n_leadIndex;
+  uint32_t numberOfNonZeros;
+  uint32_t maxColors;
+  uint32_t nRows;
+  uint64_t offset;
+} PATTERN_CACHE_ENTRY;
+
+typedef struct CACHED_PATTERN
+{
+  char name[PATTERN_CACHE_NAME_LENGTH];
+  unsigned int n_leadIndex;
+  unsigned int numberOfNonZeros;
+  unsigned int maxColors;
+  unsigned int nRows;
+  unsigned int* leadindex;            /* points into the mapped file or to a block owned by the cache */
+  unsigned int* index;
+  unsigned int* colorCols;
+} CACHED_PATTERN;
+
+enum PATTERN_CACHE_STATE
+{
+  PATTERN_CACHE_CLOSED = 0,
+  PATTERN_CACHE_OPEN,
+  PATTERN_CACHE_DISABLED
+};
+
+/* One cache per process, shared by all instances of the model. Mapped file
+ * and stored patterns are kept until the process exits, the patterns handed
+ * out by lookupSparsePatternCache point into them. */
+static struct
+{
+  enum PATTERN_CACHE_STATE state;
+  char* fileName;
+  uint64_t key;
+  CACHED_PATTERN* entries;
+  unsigned int nEntries;
+  unsigned int capacity;
+  unsigned int nUnsaved;              /* entries stored since the file was written */
+} patternCache;
+
+static pthread_mutex_t patternCacheMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief FNV-1a hash of the model GUID.
+ *
+ * Size of unsigned int and file version are part of the key, a cache file
+ * written by a different build of the runtime is not used.
+ */
+static uint64_t patternCacheKey(const char* guid)
+{
+  uint64_t hash = 14695981039346656037ULL;
+  const unsigned char* c;
+
+  for (c = (const unsigned char*) guid; *c; c++) {
+    hash = (hash ^ *c) * 1099511628211ULL;
+  }
+  hash = (hash ^ sizeof(unsigned int)) * 1099511628211ULL;
+  hash = (hash ^ PATTERN_CACHE_VERSION) * 1099511628211ULL;
+  return hash;
+}
+
+static size_t patternCacheDataSize(unsigned int n_leadIndex, unsigned int numberOfNonZeros)
+{
+  size_t size = (2*(size_t)n_leadIndex + 1 + numberOfNonZeros)*sizeof(unsigned int);
+  return (size + 7) & ~(size_t)7;
+}
+
+static CACHED_PATTERN* findCachedPattern(const char* name)
+{
+  unsigned int i;
+  for (i = 0; i < patternCache.nEntries; i++) {
+    if (!strcmp(patternCache.entries[i].name, name)) {
+      return &patternCache.entries[i];
+    }
+  }
+  return NULL;
+}
+
+static CACHED_PATTERN* appendCachedPattern(void)
+{
+  if (patternCache.nEntries == patternCache.capacity) {
+    patternCache.capacity = patternCache.capacity ? 2*patternCache.capacity : 16;
+    patternCache.entries = (CACHED_PATTERN*) realloc(patternCache.entries, patternCache.capacity*sizeof(CACHED_PATTERN));
+  }
+  return &patternCache.entries[patternCache.nEntries++];
+}
+
+/**
+ * @brief Map cache file read-only.
+ *
+ * Without mmap the file is read into memory.
+ *
+ * @param fileName      Name of cache file.
+ * @param size          On return size of file in bytes.
+ * @return const char*  Start of file contents, NULL if the file can't be read.
+ */
+static const char* mapPatternCacheFile(const char* fileName, size_t* size)
+{
+#if HAVE_MMAP
+  struct stat s;
+  void* map;
+  int fd = open(fileName, O_RDONLY);
+
+  if (fd < 0) {
+    return NULL;
+  }
+  if (fstat(fd, &s) < 0 || s.st_size < (off_t) sizeof(PATTERN_CACHE_HEADER)) {
+    close(fd);
+    return NULL;
+  }
+  map = mmap(0, s.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    return NULL;
+  }
+  *size = s.st_size;
+  return (const char*) map;
+#else
+  char* buffer;
+  long fileSize;
+  FILE* pFile = omc_fopen(fileName, "rb");
+
+  if (pFile == NULL) {
+    return NULL;
+  }
+  fseek(pFile, 0, SEEK_END);
+  fileSize = ftell(pFile);
+  rewind(pFile);
+  if (fileSize < (long) sizeof(PATTERN_CACHE_HEADER)) {
+    omc_fclose(pFile);
+    return NULL;
+  }
+  buffer = (char*) malloc(fileSize);
+  if (omc_fread(buffer, 1, fileSize, pFile, FALSE) != (size_t) fileSize) {
+    free(buffer);
+    buffer = NULL;
+  }
+  omc_fclose(pFile);
+  *size = fileSize;
+  return buffer;
+#endif
+}
+
+static void unmapPatternCacheFile(const char* map, size_t size)
+{
+#if HAVE_MMAP
+  munmap((void*) map, size);
+#else
+  free((void*) map);
+#endif
+}
+
+/**
+ * @brief Read entries of mapped cache file.
+ *
+ * The file is ignored if it was written for another model or another
+ * version of the model, or if it is truncated.
+ */
+/**
+ * @brief Check a pattern of the cache file before it is used.
+ *
+ * Row indices have to be less than nRows, the lead index monotonic up to
+ * numberOfNonZeros and the colors within 1, ..., maxColors.
+ *
+ * @return int    1 if the pattern is valid.
+ */
+static int validCachedPattern(const CACHED_PATTERN* pattern)
+{
+  unsigned int i;
+
+  if (pattern->leadindex[pattern->n_leadIndex] != pattern->numberOfNonZeros) {
+    return 0;
+  }
+  for (i = 0; i < pattern->n_leadIndex; i++) {
+    if (pattern->leadindex[i] > pattern->leadindex[i+1] ||
+        pattern->colorCols[i] < 1 || pattern->colorCols[i] > pattern->maxColors) {
+      return 0;
+    }
+  }
+  for (i = 0; i < pattern->numberOfNonZeros; i++) {
+    if (pattern->index[i] >= pattern->nRows) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+static void readPatternCacheFile(void)
+{
+  const PATTERN_CACHE_HEADER* header;
+  const PATTERN_CACHE_ENTRY* entry;
+  CACHED_PATTERN* pattern;
+  size_t size = 0;
+  unsigned int i;
+  const char* map = mapPatternCacheFile(patternCache.fileName, &size);
+
+  if (map == NULL) {
+    return;
+  }
+  header = (const PATTERN_CACHE_HEADER*) map;
+  if (memcmp(header->magic, PATTERN_CACHE_MAGIC, 8) || header->version != PATTERN_CACHE_VERSION ||
+      header->key != patternCache.key || header->size != size ||
+      sizeof(PATTERN_CACHE_HEADER) + (uint64_t) header->nEntries*sizeof(PATTERN_CACHE_ENTRY) > size) {
+    infoStreamPrint(LOG_JAC, 0, "Ignoring pattern cache %s, it was written for another build of the model or is damaged.", patternCache.fileName);
+    unmapPatternCacheFile(map, size);
+    return;
+  }
+
+  entry = (const PATTERN_CACHE_ENTRY*) (map + sizeof(PATTERN_CACHE_HEADER));
+  for (i = 0; i < header->nEntries; i++, entry++) {
+    if (entry->name[PATTERN_CACHE_NAME_LENGTH-1] != '\0' || entry->offset % 8 ||
+        entry->offset + patternCacheDataSize(entry->n_leadIndex, entry->numberOfNonZeros) > size) {
+      continue;
+    }
+    pattern = appendCachedPattern();
+    memcpy(pattern->name, entry->name, PATTERN_CACHE_NAME_LENGTH);
+    pattern->n_leadIndex = entry->n_leadIndex;
+    pattern->numberOfNonZeros = entry->numberOfNonZeros;
+    pattern->maxColors = entry->maxColors;
+    pattern->nRows = entry->nRows;
+    pattern->leadindex = (unsigned int*) (map + entry->offset);
+    pattern->index = pattern->leadindex + entry->n_leadIndex + 1;
+    pattern->colorCols = pattern->index + entry->numberOfNonZeros;
+    if (!validCachedPattern(pattern)) {
+      infoStreamPrint(LOG_JAC, 0, "Ignoring damaged sparsity pattern %s in pattern cache.", pattern->name);
+      patternCache.nEntries--;
+    }
+  }
+  infoStreamPrint(LOG_JAC, 0, "Mapped pattern cache %s with %u sparsity patterns.", patternCache.fileName, patternCache.nEntries);
+}
+
+/**
+ * @brief Open pattern cache on first use.
+ *
+ * Has to be called with patternCacheMutex locked.
+ */
+static void openPatternCache(DATA* data)
+{
+  const char* prefix = data->modelData->modelFilePrefix;
+  size_t length;
+
+  if (omc_flag[FLAG_NO_PATTERN_CACHE] || data->modelData->modelGUID == NULL || prefix == NULL) {
+    patternCache.state = PATTERN_CACHE_DISABLED;
+    return;
+  }
+
+  length = strlen(prefix) + 32;
+  if (omc_flag[FLAG_OUTPUT_PATH]) {
+    length += strlen(omc_flagValue[FLAG_OUTPUT_PATH]);
+    patternCache.fileName = (char*) malloc(length);
+    snprintf(patternCache.fileName, length, "%s/%s_patterns.cache", omc_flagValue[FLAG_OUTPUT_PATH], prefix);
+  } else {
+    patternCache.fileName = (char*) malloc(length);
+    snprintf(patternCache.fileName, length, "%s_patterns.cache", prefix);
+  }
+  patternCache.key = patternCacheKey(data->modelData->modelGUID);
+  patternCache.state = PATTERN_CACHE_OPEN;
+
+  readPatternCacheFile();
+}
+
+/**
+ * @brief Write all cached patterns to a new cache file.
+ *
+ * The file is written under a temporary name and renamed, processes that
+ * have mapped the old file keep using it.
+ *
+ * @return int    0 on success.
+ */
+static int writePatternCacheFile(void)
+{
+  PATTERN_CACHE_HEADER header;
+  PATTERN_CACHE_ENTRY entry;
+  const CACHED_PATTERN* pattern;
+  static const char padding[8] = {0};
+  size_t length = strlen(patternCache.fileName) + 32;
+  char* tmpName = (char*) malloc(length);
+  uint64_t offset;
+  unsigned int i;
+  size_t size, ok = 1;
+  FILE* pFile;
+
+  snprintf(tmpName, length, "%s.%d.tmp", patternCache.fileName, (int) getpid());
+  pFile = omc_fopen(tmpName, "wb");
+  if (pFile == NULL) {
+    free(tmpName);
+    return 1;
+  }
+
+  offset = sizeof(PATTERN_CACHE_HEADER) + (uint64_t) patternCache.nEntries*sizeof(PATTERN_CACHE_ENTRY);
+  memcpy(header.magic, PATTERN_CACHE_MAGIC, 8);
+  header.version = PATTERN_CACHE_VERSION;
+  header.nEntries = patternCache.nEntries;
+  header.key = patternCache.key;
+  header.size = offset;
+  for (i = 0; i < patternCache.nEntries; i++) {
+    header.size += patternCacheDataSize(patternCache.entries[i].n_leadIndex, patternCache.entries[i].numberOfNonZeros);
+  }
+  ok &= omc_fwrite(&header, sizeof(header), 1, pFile);
+
+  for (i = 0; i < patternCache.nEntries; i++) {
+    pattern = &patternCache.entries[i];
+    memset(&entry, 0, sizeof(entry));
+    memcpy(entry.name, pattern->name, PATTERN_CACHE_NAME_LENGTH);
+    entry.n_leadIndex = pattern->n_leadIndex;
+    entry.numberOfNonZeros = pattern->numberOfNonZeros;
+    entry.maxColors = pattern->maxColors;
+    entry.nRows = pattern->nRows;
+    entry.offset = offset;
+    ok &= omc_fwrite(&entry, sizeof(entry), 1, pFile);
+    offset += patternCacheDataSize(pattern->n_leadIndex, pattern->numberOfNonZeros);
+  }
+
+  for (i = 0; i < patternCache.nEntries && ok; i++) {
+    pattern = &patternCache.entries[i];
+    size = (2*(size_t)pattern->n_leadIndex + 1 + pattern->numberOfNonZeros)*sizeof(unsigned int);
+    ok &= omc_fwrite(pattern->leadindex, sizeof(unsigned int), pattern->n_leadIndex+1, pFile) == pattern->n_leadIndex+1;
+    ok &= omc_fwrite(pattern->index, sizeof(unsigned int), pattern->numberOfNonZeros, pFile) == pattern->numberOfNonZeros;
+    ok &= omc_fwrite(pattern->colorCols, sizeof(unsigned int), pattern->n_leadIndex, pFile) == pattern->n_leadIndex;
+    if (patternCacheDataSize(pattern->n_leadIndex, pattern->numberOfNonZeros) > size) {
+      ok &= omc_fwrite((void*) padding, 1, patternCacheDataSize(pattern->n_leadIndex, pattern->numberOfNonZeros) - size, pFile) > 0;
+    }
+  }
+  ok &= omc_fclose(pFile) == 0;
+
+#if defined(__MINGW32__) || defined(_MSC_VER)
+  if (ok) {
+    remove(patternCache.fileName);
+  }
+#endif
+  if (!ok || rename(tmpName, patternCache.fileName)) {
+    remove(tmpName);
+    free(tmpName);
+    return 1;
+  }
+  free(tmpName);
+  return 0;
+}
+
+/**
+ * @brief Look up sparsity pattern in pattern cache.
+ *
+ * The arrays of the returned pattern are read-only and owned by the cache,
+ * freeSparsePattern only frees the pattern struct itself.
+ *
+ * @param data                Runtime data struct.
+ * @param name                Name of pattern, e.g. JacA or NLS42.
+ * @param n_leadIndex         Expected number of columns of pattern.
+ * @param nRows               Expected number of rows of pattern.
+ * @return SPARSE_PATTERN*    Pattern or NULL if not in cache.
+ */
+SPARSE_PATTERN* lookupSparsePatternCache(DATA* data, const char* name, unsigned int n_leadIndex, unsigned int nRows)
+{
+  SPARSE_PATTERN* sparsePattern = NULL;
+  CACHED_PATTERN* pattern;
+
+  pthread_mutex_lock(&patternCacheMutex);
+  if (patternCache.state == PATTERN_CACHE_CLOSED) {
+    openPatternCache(data);
+  }
+  pattern = patternCache.state == PATTERN_CACHE_OPEN ? findCachedPattern(name) : NULL;
+  if (pattern != NULL && pattern->n_leadIndex == n_leadIndex && pattern->nRows == nRows) {
+    sparsePattern = (SPARSE_PATTERN*) malloc(sizeof(SPARSE_PATTERN));
+    sparsePattern->leadindex = pattern->leadindex;
+    sparsePattern->index = pattern->index;
+    sparsePattern->sizeofIndex = pattern->numberOfNonZeros;
+    sparsePattern->numberOfNonZeros = pattern->numberOfNonZeros;
+    sparsePattern->colorCols = pattern->colorCols;
+    sparsePattern->maxColors = pattern->maxColors;
+    sparsePattern->isCached = TRUE;
+  }
+  pthread_mutex_unlock(&patternCacheMutex);
+
+  if (sparsePattern != NULL) {
+    infoStreamPrint(LOG_JAC, 0, "Sparsity pattern %s taken from pattern cache.", name);
+  }
+  return sparsePattern;
+}
+
+/**
+ * @brief Store computed sparsity pattern in pattern cache.
+ *
+ * The arrays are copied, the caller keeps ownership of sparsePattern.
+ * The cache file is only written by flushSparsePatternCache.
+ *
+ * @param data            Runtime data struct.
+ * @param name            Name of pattern.
+ * @param n_leadIndex     Number of columns of pattern.
+ * @param nRows           Number of rows of pattern.
+ * @param sparsePattern   Pattern to store.
+ */
+void storeSparsePatternCache(DATA* data, const char* name, unsigned int n_leadIndex, unsigned int nRows, SPARSE_PATTERN* sparsePattern)
+{
+  CACHED_PATTERN* pattern;
+  unsigned int nnz;
+
+  if (sparsePattern == NULL || sparsePattern->isCached || strlen(name) >= PATTERN_CACHE_NAME_LENGTH) {
+    return;
+  }
+  nnz = sparsePattern->numberOfNonZeros;
+
+  pthread_mutex_lock(&patternCacheMutex);
+  if (patternCache.state == PATTERN_CACHE_CLOSED) {
+    openPatternCache(data);
+  }
+  if (patternCache.state == PATTERN_CACHE_OPEN && findCachedPattern(name) == NULL) {
+    pattern = appendCachedPattern();
+    memset(pattern->name, 0, PATTERN_CACHE_NAME_LENGTH);
+    strcpy(pattern->name, name);
+    pattern->n_leadIndex = n_leadIndex;
+    pattern->numberOfNonZeros = nnz;
+    pattern->maxColors = sparsePattern->maxColors;
+    pattern->nRows = nRows;
+    pattern->leadindex = (unsigned int*) malloc((2*(size_t)n_leadIndex + 1 + nnz)*sizeof(unsigned int));
+    pattern->index = pattern->leadindex + n_leadIndex + 1;
+    pattern->colorCols = pattern->index + nnz;
+    memcpy(pattern->leadindex, sparsePattern->leadindex, (n_leadIndex+1)*sizeof(unsigned int));
+    memcpy(pattern->index, sparsePattern->index, nnz*sizeof(unsigned int));
+    memcpy(pattern->colorCols, sparsePattern->colorCols, n_leadIndex*sizeof(unsigned int));
+    patternCache.nUnsaved++;
+  }
+  pthread_mutex_unlock(&patternCacheMutex);
+}
+
+/**
+ * @brief Write pattern cache file if patterns were stored since it was read.
+ *
+ * @param data    Runtime data struct.
+ */
+void flushSparsePatternCache(DATA* data)
+{
+  pthread_mutex_lock(&patternCacheMutex);
+  if (patternCache.state == PATTERN_CACHE_OPEN && patternCache.nUnsaved > 0) {
+    if (writePatternCacheFile()) {
+      warningStreamPrint(LOG_STDOUT, 0, "Could not write pattern cache %s.", patternCache.fileName);
+    } else {
+      infoStreamPrint(LOG_JAC, 0, "Wrote %u sparsity patterns to pattern cache %s.", patternCache.nEntries, patternCache.fileName);
+    }
+    patternCache.nUnsaved = 0;
+  }
+  pthread_mutex_unlock(&patternCacheMutex);
+}
+
+#else /* OMC_MINIMAL_RUNTIME */
+
+SPARSE_PATTERN* lookupSparsePatternCache(DATA* data, const char* name, unsigned int n_leadIndex, unsigned int nRows)
+{
+  return NULL;
+}
+
+void storeSparsePatternCache(DATA* data, const char* name, unsigned int n_leadIndex, unsigned int nRows, SPARSE_PATTERN* sparsePattern)
+{
+}
+
+void flushSparsePatternCache(DATA* data)
+{
+}
+
+#endif /* OMC_MINIMAL_RUNTIME */
@@ -0,0 +1,63 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-2019, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/*! \file jacobian_cache.h
+ *
+ * Cache of sparsity patterns and colorings in the binary file
+ * <outputPath>/<modelFilePrefix>_patterns.cache.
+ *
+ * The file is keyed by a hash of the model GUID and holds one entry per
+ * pattern: the compressed sparse column lead index and row indices and the
+ * column coloring. It is mapped read-only into the process the first time a
+ * pattern is looked up. All instances of the model in the process and all
+ * other processes mapping the same file share the pages. Patterns that are
+ * not in the file are computed as before, stored with
+ * storeSparsePatternCache and the file is rewritten by
+ * flushSparsePatternCache. Disabled with -noPatternCache and for FMUs.
+ */
+
+#ifndef OMC_JACOBIAN_CACHE_H
+#define OMC_JACOBIAN_CACHE_H
+
+#include "../simulation_data.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+SPARSE_PATTERN* lookupSparsePatternCache(DATA* data, const char* name, unsigned int n_leadIndex, unsigned int nRows);
+void storeSparsePatternCache(DATA* data, const char* name, unsigned int n_leadIndex, unsigned int nRows, SPARSE_PATTERN* sparsePattern);
+void flushSparsePatternCache(DATA* data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -116,6 +116,7 @@ SPARSE_PATTERN* allocSparsePattern(unsigned int n_leadIndex, unsigned int number
   sparsePattern->numberOfNonZeros = numberOfNonZeros;
   sparsePattern->colorCols = (unsigned int*) malloc(n_leadIndex*sizeof(unsigned int));
   sparsePattern->maxColors = maxColors;
+  sparsePattern->isCached = FALSE;
 
   return sparsePattern;
 }
@@ -123,13 +124,20 @@ SPARSE_PATTERN* allocSparsePattern(unsigned int n_leadIndex, unsigned int number
 /**
  * @brief Free sparsity pattern
  *
+ * Arrays of a pattern taken from the pattern cache are not freed.
+ *
  * @param spp   Pointer to sparsity pattern
  */
 void freeSparsePattern(SPARSE_PATTERN *spp) {
   if (spp != NULL) {
-    free(spp->index); spp->index = NULL;
-    free(spp->colorCols); spp->colorCols = NULL;
-    free(spp->leadindex); spp->leadindex = NULL;
+    if (!spp->isCached) {
+      free(spp->index);
+      free(spp->colorCols);
+      free(spp->leadindex);
+    }
+    spp->index = NULL;
+    spp->colorCols = NULL;
+    spp->leadindex = NULL;
   }
 }
 
@@ -48,4 +48,17 @@ simulation_result sim_result = {
   sim_result_doNothing, /* free */
 };
 
+/* Resets a result object to the defaults of sim_result, which emit nothing */
+void sim_result_reset(simulation_result *self)
+{
+  self->filename = NULL;
+  self->numpoints = 0;
+  self->cpuTime = 0;
+  self->storage = NULL;
+  self->init = sim_result_doNothing;
+  self->emit = sim_result_doNothing;
+  self->writeParameterData = sim_result_doNothing;
+  self->free = sim_result_doNothing;
+}
+
 }
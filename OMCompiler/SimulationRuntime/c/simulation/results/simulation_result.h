@@ -49,8 +49,12 @@ typedef struct simulation_result {
   void (*free)(struct simulation_result*,DATA*,threadData_t *threadData);
 } simulation_result;
 
+/* The result object of the model started from the command line. Every
+ * DATA points to its own result object by DATA.simResult. */
 extern simulation_result sim_result;
 
+void sim_result_reset(simulation_result *self);
+
 #ifdef __cplusplus
 }
 #endif /* cplusplus */
@@ -44,15 +44,15 @@
 #include "util/rtclock.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <errno.h>
 #include <string.h>
 #include <time.h>
 
 extern "C" {
 
-void omc_csv_emit(simulation_result *self, DATA *data, threadData_t *threadData)
+static void omc_csv_write_row(simulation_result *self, FILE *fout, DATA *data)
 {
-  FILE *fout = (FILE*) self->storage;
   const char* format = ",%.16g";
   const char* formatint = ",%i";
   const char* formatbool = ",%i";
@@ -112,15 +112,12 @@ void omc_csv_emit(simulation_result *self, DATA *data, threadData_t *threadData)
   rt_accumulate(SIM_TIMER_OUTPUT);
 }
 
-void omc_csv_init(simulation_result *self, DATA *data, threadData_t *threadData)
+static void omc_csv_write_header(simulation_result *self, FILE *fout, DATA *data)
 {
   int i;
   const MODEL_DATA *mData = data->modelData;
 
   const char* format = ",\"%s\"";
-  FILE *fout = omc_fopen(self->filename, "w");
-
-  assertStreamPrint(threadData, 0!=fout, "Error, couldn't create output file: [%s] because of %s", self->filename, strerror(errno));
 
   fprintf(fout, "\"time\"");
   if(self->cpuTime)
@@ -143,6 +140,20 @@ void omc_csv_init(simulation_result *self, DATA *data, threadData_t *threadData)
   //for(i = 0; i < mData->nAliasString; i++) if(!mData->stringAlias[i].filterOutput && data->modelData->stringAlias[i].aliasType != 1)
   //  fprintf(fout, format, mData->stringAlias[i].info.name);
   fprintf(fout, "\n");
+}
+
+void omc_csv_emit(simulation_result *self, DATA *data, threadData_t *threadData)
+{
+  omc_csv_write_row(self, (FILE*) self->storage, data);
+}
+
+void omc_csv_init(simulation_result *self, DATA *data, threadData_t *threadData)
+{
+  FILE *fout = omc_fopen(self->filename, "w");
+
+  assertStreamPrint(threadData, 0!=fout, "Error, couldn't create output file: [%s] because of %s", self->filename, strerror(errno));
+
+  omc_csv_write_header(self, fout, data);
   self->storage = fout;
 }
 
@@ -154,4 +165,63 @@ void omc_csv_free(simulation_result *self, DATA *data, threadData_t *threadData)
   rt_accumulate(SIM_TIMER_OUTPUT);
 }
 
+/*
+ * Combined result of a parameter sweep: a single csv-file with an additional
+ * leading column "run". The file is opened once by omc_csv_sweep_open and
+ * stays open over all runs; init and free of the single runs leave it open.
+ */
+typedef struct csv_sweep_storage
+{
+  FILE *fout;
+  int run;
+} csv_sweep_storage;
+
+void* omc_csv_sweep_open(simulation_result *self, DATA *data, threadData_t *threadData)
+{
+  csv_sweep_storage *storage;
+  FILE *fout = omc_fopen(self->filename, "w");
+
+  assertStreamPrint(threadData, 0!=fout, "Error, couldn't create output file: [%s] because of %s", self->filename, strerror(errno));
+
+  storage = (csv_sweep_storage*) malloc(sizeof(csv_sweep_storage));
+  assertStreamPrint(threadData, 0!=storage, "out of memory");
+  storage->fout = fout;
+  storage->run = 0;
+
+  fprintf(fout, "\"run\",");
+  omc_csv_write_header(self, fout, data);
+  return storage;
+}
+
+void omc_csv_sweep_set_run(void *storage, int run)
+{
+  ((csv_sweep_storage*) storage)->run = run;
+}
+
+void omc_csv_sweep_close(void *storage)
+{
+  fclose(((csv_sweep_storage*) storage)->fout);
+  free(storage);
+}
+
+void omc_csv_sweep_init(simulation_result *self, DATA *data, threadData_t *threadData)
+{
+  assertStreamPrint(threadData, 0!=self->storage, "csv sweep result used without omc_csv_sweep_open");
+}
+
+void omc_csv_sweep_emit(simulation_result *self, DATA *data, threadData_t *threadData)
+{
+  csv_sweep_storage *storage = (csv_sweep_storage*) self->storage;
+  fprintf(storage->fout, "%d,", storage->run);
+  omc_csv_write_row(self, storage->fout, data);
+}
+
+void omc_csv_sweep_free(simulation_result *self, DATA *data, threadData_t *threadData)
+{
+  csv_sweep_storage *storage = (csv_sweep_storage*) self->storage;
+  rt_tick(SIM_TIMER_OUTPUT);
+  fflush(storage->fout);
+  rt_accumulate(SIM_TIMER_OUTPUT);
+}
+
 }
@@ -42,6 +42,14 @@ void omc_csv_init(simulation_result *self,DATA *data, threadData_t *threadData);
 void omc_csv_emit(simulation_result *self,DATA *data, threadData_t *threadData);
 void omc_csv_free(simulation_result *self,DATA *data, threadData_t *threadData);
 
+/* combined csv result of a parameter sweep, see simulation_sweep.h */
+void* omc_csv_sweep_open(simulation_result *self,DATA *data, threadData_t *threadData);
+void omc_csv_sweep_set_run(void *storage, int run);
+void omc_csv_sweep_close(void *storage);
+void omc_csv_sweep_init(simulation_result *self,DATA *data, threadData_t *threadData);
+void omc_csv_sweep_emit(simulation_result *self,DATA *data, threadData_t *threadData);
+void omc_csv_sweep_free(simulation_result *self,DATA *data, threadData_t *threadData);
+
 #ifdef __cplusplus
 }
 #endif /* cplusplus */
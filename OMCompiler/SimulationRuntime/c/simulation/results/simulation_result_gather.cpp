@@ -0,0 +1,171 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-CurrentYear, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+#include "simulation_result_gather.h"
+
+#include <cstdlib>
+#include <cstring>
+
+void gatherPlan_init(OUTPUT_GATHER_PLAN *plan)
+{
+  plan->runs = NULL;
+  plan->nRuns = 0;
+  plan->capacity = 0;
+  plan->nValues = 0;
+}
+
+void gatherPlan_free(OUTPUT_GATHER_PLAN *plan)
+{
+  free(plan->runs);
+  gatherPlan_init(plan);
+}
+
+void gatherPlan_add(OUTPUT_GATHER_PLAN *plan, GATHER_SOURCE source, int index, int negate)
+{
+  GATHER_RUN *last = plan->nRuns ? &plan->runs[plan->nRuns-1] : NULL;
+
+  negate = negate ? 1 : 0;
+  plan->nValues++;
+  if (last && last->source == source && last->negate == negate &&
+      (source == GATHER_TIME || last->start + last->length == index)) {
+    last->length++;
+    return;
+  }
+
+  if (plan->nRuns == plan->capacity) {
+    plan->capacity = plan->capacity ? 2*plan->capacity : 16;
+    plan->runs = (GATHER_RUN*) realloc(plan->runs, plan->capacity * sizeof(GATHER_RUN));
+  }
+  last = &plan->runs[plan->nRuns++];
+  last->source = source;
+  last->negate = negate;
+  last->start = source == GATHER_TIME ? 0 : index;
+  last->length = 1;
+}
+
+void gatherPlan_addAlias(OUTPUT_GATHER_PLAN *plan, GATHER_SOURCE varSource, const DATA_ALIAS *alias)
+{
+  switch (alias->aliasType) {
+  case 1:
+    /* the parameter sources follow the variable sources in the same order */
+    gatherPlan_add(plan, (GATHER_SOURCE) (varSource + GATHER_REAL_PARAMETERS - GATHER_REAL_VARS), alias->nameID, alias->negate);
+    break;
+  case 2:
+    gatherPlan_add(plan, GATHER_TIME, 0, alias->negate);
+    break;
+  default:
+    gatherPlan_add(plan, varSource, alias->nameID, alias->negate);
+  }
+}
+
+/* Copies a run of values to the output, converting and negating them.
+ * The loops have no branches, so the compiler vectorizes them.
+ */
+template<typename T, typename S>
+static inline void gatherRun(T *out, const S *in, int n, int negate)
+{
+  int i;
+  if (!negate) {
+    for (i = 0; i < n; i++)
+      out[i] = (T) in[i];
+  } else {
+    for (i = 0; i < n; i++)
+      out[i] = (T) -in[i];
+  }
+}
+
+template<typename T>
+static inline void gatherBooleanRun(T *out, const modelica_boolean *in, int n, int negate)
+{
+  int i;
+  if (!negate) {
+    for (i = 0; i < n; i++)
+      out[i] = (T) in[i];
+  } else {
+    for (i = 0; i < n; i++)
+      out[i] = (T) (in[i]==1 ? 0 : 1);
+  }
+}
+
+template<typename T>
+static void gatherPlan_emit(const OUTPUT_GATHER_PLAN *plan, const DATA *data, T *out)
+{
+  const SIMULATION_DATA *sData = data->localData[0];
+  const SIMULATION_INFO *sInfo = data->simulationInfo;
+  T value;
+
+  for (int r = 0; r < plan->nRuns; r++) {
+    const GATHER_RUN *run = &plan->runs[r];
+    switch (run->source) {
+    case GATHER_REAL_VARS:
+      if (sizeof(T) == sizeof(modelica_real) && !run->negate)
+        memcpy(out, sData->realVars + run->start, run->length * sizeof(modelica_real));
+      else
+        gatherRun(out, sData->realVars + run->start, run->length, run->negate);
+      break;
+    case GATHER_INTEGER_VARS:
+      gatherRun(out, sData->integerVars + run->start, run->length, run->negate);
+      break;
+    case GATHER_BOOLEAN_VARS:
+      gatherBooleanRun(out, sData->booleanVars + run->start, run->length, run->negate);
+      break;
+    case GATHER_REAL_PARAMETERS:
+      gatherRun(out, sInfo->realParameter + run->start, run->length, run->negate);
+      break;
+    case GATHER_INTEGER_PARAMETERS:
+      gatherRun(out, sInfo->integerParameter + run->start, run->length, run->negate);
+      break;
+    case GATHER_BOOLEAN_PARAMETERS:
+      gatherBooleanRun(out, sInfo->booleanParameter + run->start, run->length, run->negate);
+      break;
+    case GATHER_SENSITIVITIES:
+      gatherRun(out, sInfo->sensitivityMatrix + run->start, run->length, run->negate);
+      break;
+    case GATHER_TIME:
+      value = (T) (run->negate ? -sData->timeValue : sData->timeValue);
+      for (int i = 0; i < run->length; i++)
+        out[i] = value;
+      break;
+    default:
+      break;
+    }
+    out += run->length;
+  }
+}
+
+void gatherPlan_emitDouble(const OUTPUT_GATHER_PLAN *plan, const DATA *data, double *out)
+{
+  gatherPlan_emit(plan, data, out);
+}
+
+void gatherPlan_emitFloat(const OUTPUT_GATHER_PLAN *plan, const DATA *data, float *out)
+{
+  gatherPlan_emit(plan, data, out);
+}
@@ -0,0 +1,90 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-CurrentYear, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/*
+ * Gather plan for the values a result writer emits at each output point.
+ *
+ * A writer compiles its selection of variables (filterOutput,
+ * time_unvarying, alias handling, ...) into a plan once at init. The plan
+ * consists of runs of consecutive indices from the same source with the
+ * same conversion, so emitting a row is one memcpy or tight loop per run
+ * instead of a test per variable.
+ */
+
+#ifndef _SIMULATION_RESULT_GATHER_H_
+#define _SIMULATION_RESULT_GATHER_H_
+
+#include "simulation_data.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+  GATHER_REAL_VARS,
+  GATHER_INTEGER_VARS,
+  GATHER_BOOLEAN_VARS,
+  GATHER_REAL_PARAMETERS,
+  GATHER_INTEGER_PARAMETERS,
+  GATHER_BOOLEAN_PARAMETERS,
+  GATHER_SENSITIVITIES,
+  GATHER_TIME,
+  GATHER_NUM_SOURCES
+} GATHER_SOURCE;
+
+typedef struct GATHER_RUN {
+  GATHER_SOURCE source;
+  int negate;  /* -x for reals and integers, !x for booleans */
+  int start;   /* first index in the source */
+  int length;
+} GATHER_RUN;
+
+typedef struct OUTPUT_GATHER_PLAN {
+  GATHER_RUN *runs;
+  int nRuns;
+  int capacity;
+  int nValues;
+} OUTPUT_GATHER_PLAN;
+
+void gatherPlan_init(OUTPUT_GATHER_PLAN *plan);
+void gatherPlan_free(OUTPUT_GATHER_PLAN *plan);
+/* append one value, merged into the last run if it continues it */
+void gatherPlan_add(OUTPUT_GATHER_PLAN *plan, GATHER_SOURCE source, int index, int negate);
+/* append the value an alias refers to (aliasType 0: variable, 1: parameter, 2: time) */
+void gatherPlan_addAlias(OUTPUT_GATHER_PLAN *plan, GATHER_SOURCE varSource, const DATA_ALIAS *alias);
+
+void gatherPlan_emitDouble(const OUTPUT_GATHER_PLAN *plan, const DATA *data, double *out);
+void gatherPlan_emitFloat(const OUTPUT_GATHER_PLAN *plan, const DATA *data, float *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
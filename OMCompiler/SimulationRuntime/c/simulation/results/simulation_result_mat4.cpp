@@ -34,6 +34,7 @@
 #include "util/rtclock.h"
 #include "simulation/options.h"
 #include "simulation_result_mat4.h"
+#include "simulation_result_gather.h"
 
 #include <fstream>
 #include <iostream>
@@ -58,6 +59,8 @@ typedef struct mat_data {
   size_t sync;
   void* data_2;
   MatVer4Type_t type;
+  size_t nLeading; /* time, $cpuTime and $solverSteps */
+  OUTPUT_GATHER_PLAN plan; /* all other values of data_2 */
 } mat_data;
 
 static const char timeName[] = "time";
@@ -707,6 +710,33 @@ void mat4_writeParameterData4(simulation_result *self, DATA *data, threadData_t
   //  Data Type: IEEE 754 double-precision
   matData->data2HdrPos = ftell(matData->pFile);
   matData->data_2 = malloc(size * matData->nData2);
+
+  /* compile the selection of data_2 into a gather plan, in the order of the name matrix */
+  matData->nLeading = 1 + (self->cpuTime ? 1 : 0) + (omc_flag[FLAG_SOLVER_STEPS] ? 1 : 0);
+  gatherPlan_free(&matData->plan);
+
+  for (int i=0; i < mData->nVariablesReal; i++)
+    if (!mData->realVarsData[i].filterOutput && !mData->realVarsData[i].time_unvarying)
+      gatherPlan_add(&matData->plan, GATHER_REAL_VARS, i, 0);
+
+  if (omc_flag[FLAG_IDAS])
+    for (int i=mData->nSensitivityParamVars; i < mData->nSensitivityVars; i++)
+      gatherPlan_add(&matData->plan, GATHER_SENSITIVITIES, i, 0);
+
+  for (int i=0; i < mData->nVariablesInteger; i++)
+    if (!mData->integerVarsData[i].filterOutput && !mData->integerVarsData[i].time_unvarying)
+      gatherPlan_add(&matData->plan, GATHER_INTEGER_VARS, i, 0);
+
+  for (int i=0; i < mData->nVariablesBoolean; i++)
+    if (!mData->booleanVarsData[i].filterOutput && !mData->booleanVarsData[i].time_unvarying)
+      gatherPlan_add(&matData->plan, GATHER_BOOLEAN_VARS, i, 0);
+
+  for (int i=0; i < mData->nAliasBoolean; i++)
+    if (!mData->booleanAlias[i].filterOutput && mData->booleanAlias[i].aliasType == 0 && mData->booleanAlias[i].negate)
+      gatherPlan_add(&matData->plan, GATHER_BOOLEAN_VARS, mData->booleanAlias[i].nameID, 1);
+
+  assert(matData->nLeading + matData->plan.nValues == matData->nData2);
+
   writeMatrix_matVer4(matData->pFile, "data_2", matData->nData2, 0, NULL, matData->type);
   rt_accumulate(SIM_TIMER_OUTPUT);
 }
@@ -714,8 +744,6 @@ void mat4_writeParameterData4(simulation_result *self, DATA *data, threadData_t
 void mat4_emit4(simulation_result *self, DATA *data, threadData_t *threadData)
 {
   mat_data *matData = (mat_data*) self->storage;
-  const SIMULATION_INFO *sInfo = data->simulationInfo;
-  const MODEL_DATA      *mData = data->modelData;
 
   if (!matData->pFile)
     return;
@@ -735,27 +763,10 @@ void mat4_emit4(simulation_result *self, DATA *data, threadData_t *threadData)
   if (omc_flag[FLAG_SOLVER_STEPS])
     WRITE_REAL_VALUE(matData->data_2, cur++, data->simulationInfo->solverSteps);
 
-  for (int i=0; i < mData->nVariablesReal; i++)
-    if (!mData->realVarsData[i].filterOutput && !mData->realVarsData[i].time_unvarying)
-      WRITE_REAL_VALUE(matData->data_2, cur++, data->localData[0]->realVars[i]);
-
-  if (omc_flag[FLAG_IDAS])
-    for (int i=mData->nSensitivityParamVars; i < mData->nSensitivityVars; i++)
-      WRITE_REAL_VALUE(matData->data_2, cur++, data->simulationInfo->sensitivityMatrix[i]);
-
-  for (int i=0; i < mData->nVariablesInteger; i++)
-    if (!mData->integerVarsData[i].filterOutput && !mData->integerVarsData[i].time_unvarying)
-      WRITE_REAL_VALUE(matData->data_2, cur++, data->localData[0]->integerVars[i]);
-
-  for (int i=0; i < mData->nVariablesBoolean; i++)
-    if (!mData->booleanVarsData[i].filterOutput && !mData->booleanVarsData[i].time_unvarying)
-      WRITE_REAL_VALUE(matData->data_2, cur++, data->localData[0]->booleanVars[i]);
-
-  for (int i=0; i < mData->nAliasBoolean; i++)
-    if (!mData->booleanAlias[i].filterOutput)
-      if (mData->booleanAlias[i].aliasType == 0)
-        if (mData->booleanAlias[i].negate)
-          WRITE_REAL_VALUE(matData->data_2, cur++, (1-data->localData[0]->booleanVars[mData->booleanAlias[i].nameID]));
+  if (matData->type == MatVer4Type_SINGLE)
+    gatherPlan_emitFloat(&matData->plan, data, (float*) matData->data_2 + cur);
+  else
+    gatherPlan_emitDouble(&matData->plan, data, (double*) matData->data_2 + cur);
 
   fwrite(matData->data_2, sizeofMatVer4Type(matData->type), matData->nData2, matData->pFile);
   matData->nEmits++;
@@ -789,6 +800,7 @@ void mat4_free4(simulation_result *self, DATA *data, threadData_t *threadData)
     free(matData->data_2);
     matData->data_2 = NULL;
   }
+  gatherPlan_free(&matData->plan);
 
   fclose(matData->pFile);
   matData->pFile = NULL;
@@ -41,6 +41,7 @@
 #include "util/omc_error.h"
 #include "util/omc_file.h"
 #include "simulation_result_plt.h"
+#include "simulation_result_gather.h"
 #include "util/rtclock.h"
 
 #include <stdio.h>
@@ -57,6 +58,7 @@ typedef struct plt_data {
   long maxPoints;
   long dataSize;
   int num_vars;
+  OUTPUT_GATHER_PLAN plan; /* everything after time and $cpuTime */
 } plt_data;
 
 static void add_result(simulation_result *self,DATA *data,double *data_, long *actualPoints);
@@ -81,6 +83,20 @@ static int calcDataSize(simulation_result *self,const MODEL_DATA *modelData)
   return sz;
 }
 
+/* the values after time and $cpuTime, in the order of calcDataSize */
+static void buildGatherPlan(OUTPUT_GATHER_PLAN *plan, const MODEL_DATA *modelData)
+{
+  int i;
+  gatherPlan_init(plan);
+  for(i = 0; i < modelData->nVariablesReal; i++) if(!modelData->realVarsData[i].filterOutput) gatherPlan_add(plan, GATHER_REAL_VARS, i, 0);
+  for(i = 0; i < modelData->nVariablesInteger; i++) if(!modelData->integerVarsData[i].filterOutput) gatherPlan_add(plan, GATHER_INTEGER_VARS, i, 0);
+  for(i = 0; i < modelData->nVariablesBoolean; i++) if(!modelData->booleanVarsData[i].filterOutput) gatherPlan_add(plan, GATHER_BOOLEAN_VARS, i, 0);
+
+  for(i = 0; i < modelData->nAliasReal; i++) if(!modelData->realAlias[i].filterOutput) gatherPlan_addAlias(plan, GATHER_REAL_VARS, &modelData->realAlias[i]);
+  for(i = 0; i < modelData->nAliasInteger; i++) if(!modelData->integerAlias[i].filterOutput) gatherPlan_addAlias(plan, GATHER_INTEGER_VARS, &modelData->integerAlias[i]);
+  for(i = 0; i < modelData->nAliasBoolean; i++) if(!modelData->booleanAlias[i].filterOutput) gatherPlan_addAlias(plan, GATHER_BOOLEAN_VARS, &modelData->booleanAlias[i]);
+}
+
 void plt_emit(simulation_result *self,DATA *data, threadData_t *threadData)
 {
   plt_data *pltData = (plt_data*) self->storage;
@@ -107,7 +123,6 @@ static void add_result(simulation_result *self,DATA *data,double *data_, long *a
 {
   plt_data *pltData = (plt_data*) self->storage;
   const DATA *simData = data;
-  int i;
   double cpuTimeValue = 0;
 
   rt_accumulate(SIM_TIMER_TOTAL);
@@ -120,68 +135,8 @@ static void add_result(simulation_result *self,DATA *data,double *data_, long *a
     if(self->cpuTime)
       data_[pltData->currentPos++] = cpuTimeValue;
 
-    /* .. reals .. */
-    for(i = 0; i < simData->modelData->nVariablesReal; i++) {
-      if(!simData->modelData->realVarsData[i].filterOutput) {
-        data_[pltData->currentPos++] = simData->localData[0]->realVars[i];
-      }
-    }
-    /* .. integers .. */
-    for(i = 0; i < simData->modelData->nVariablesInteger; i++) {
-      if(!simData->modelData->integerVarsData[i].filterOutput) {
-        data_[pltData->currentPos++] = simData->localData[0]->integerVars[i];
-      }
-    }
-    /* .. booleans .. */
-    for(i = 0; i < simData->modelData->nVariablesBoolean; i++) {
-      if(!simData->modelData->booleanVarsData[i].filterOutput) {
-        data_[pltData->currentPos++] = simData->localData[0]->booleanVars[i];
-      }
-    }
-    /* .. alias reals .. */
-    for(i = 0; i < simData->modelData->nAliasReal; i++) {
-      if(!simData->modelData->realAlias[i].filterOutput) {
-        double value;
-        if(simData->modelData->realAlias[i].aliasType == 2)
-          value = (simData->localData[0])->timeValue;
-        else if(simData->modelData->realAlias[i].aliasType == 1)
-          value = simData->simulationInfo->realParameter[simData->modelData->realAlias[i].nameID];
-        else
-          value = (simData->localData[0])->realVars[simData->modelData->realAlias[i].nameID];
-        if(simData->modelData->realAlias[i].negate)
-          data_[pltData->currentPos++] = -value;
-        else
-          data_[pltData->currentPos++] = value;
-      }
-    }
-    /* .. alias integers .. */
-    for(i = 0; i < simData->modelData->nAliasInteger; i++) {
-      if(!simData->modelData->integerAlias[i].filterOutput) {
-        modelica_integer value;
-        if(simData->modelData->integerAlias[i].aliasType == 1)
-          value = simData->simulationInfo->integerParameter[simData->modelData->realAlias[i].nameID];
-        else
-          value = (simData->localData[0])->integerVars[simData->modelData->realAlias[i].nameID];
-        if(simData->modelData->integerAlias[i].negate)
-          data_[pltData->currentPos++] = -value;
-        else
-          data_[pltData->currentPos++] = value;
-      }
-    }
-    /* .. alias booleans .. */
-    for(i = 0; i < simData->modelData->nAliasBoolean; i++) {
-      if(!simData->modelData->booleanAlias[i].filterOutput) {
-        modelica_boolean value;
-        if(simData->modelData->integerAlias[i].aliasType == 1)
-          value = simData->simulationInfo->booleanParameter[simData->modelData->realAlias[i].nameID];
-        else
-          value = (simData->localData[0])->booleanVars[simData->modelData->realAlias[i].nameID];
-        if(simData->modelData->booleanAlias[i].negate)
-          data_[pltData->currentPos++] = value==1?0:1;
-        else
-          data_[pltData->currentPos++] = value;
-      }
-    }
+    gatherPlan_emitDouble(&pltData->plan, simData, data_ + pltData->currentPos);
+    pltData->currentPos += pltData->plan.nValues;
   }
 
   /*cerr << "  ... done" << endl; */
@@ -205,6 +160,7 @@ void plt_init(simulation_result *self,DATA *data, threadData_t *threadData)
 
   pltData->num_vars = calcDataSize(self,data->modelData);
   pltData->dataSize = calcDataSize(self,data->modelData);
+  buildGatherPlan(&pltData->plan, data->modelData);
   pltData->simulationResultData = (double*)malloc(self->numpoints * pltData->dataSize * sizeof(double));
   if(!pltData->simulationResultData) {
     throwStreamPrint(threadData, "Error allocating simulation result data of size %ld failed",self->numpoints * pltData->dataSize);
@@ -227,6 +183,7 @@ static void deallocResult(plt_data *pltData)
     free(pltData->simulationResultData);
     pltData->simulationResultData = 0;
   }
+  gatherPlan_free(&pltData->plan);
 }
 
 static void printPltLine(FILE* f, double time, double val)
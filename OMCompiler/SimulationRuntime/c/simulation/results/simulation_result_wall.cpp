@@ -64,7 +64,7 @@ typedef struct wall_storage {
 } wall_storage;
 
 static void msgpack_obj_header(std::ofstream &fp, int n) {
-  static char buffer[1];
+  static OMC_THREAD_LOCAL char buffer[1];
   static int32_t ibuffer;
   buffer[0] = 0xDF;
   ibuffer = htonl(n);
@@ -73,7 +73,7 @@ static void msgpack_obj_header(std::ofstream &fp, int n) {
 }
 
 static void msgpack_array_header(std::ofstream &fp, int n) {
-  static char buffer[1];
+  static OMC_THREAD_LOCAL char buffer[1];
   static int32_t ibuffer;
   buffer[0] = 0xDD;
   ibuffer = htonl(n);
@@ -82,7 +82,7 @@ static void msgpack_array_header(std::ofstream &fp, int n) {
 }
 
 static void msgpack_int32(std::ofstream &fp, int32_t n) {
-  static char buffer[1];
+  static OMC_THREAD_LOCAL char buffer[1];
   static int32_t ibuffer;
   buffer[0] = 0xd2;
   ibuffer = htonl(n);
@@ -91,7 +91,7 @@ static void msgpack_int32(std::ofstream &fp, int32_t n) {
 }
 
 static void msgpack_boolean(std::ofstream &fp, bool b) {
-  static char buffer[1];
+  static OMC_THREAD_LOCAL char buffer[1];
   if (b) buffer[0] = 0xc3;
   else buffer[0] = 0xc2;
   fp.write(buffer, 1);
@@ -107,7 +107,7 @@ static void msgpack_str(std::ofstream &fp, const char *s)
 __attribute__((nonnull));
 
 static void msgpack_str(std::ofstream &fp, const char *s) {
-  static char buffer[1];
+  static OMC_THREAD_LOCAL char buffer[1];
   int strl = htonl(strlen(s));
   buffer[0] = 0xDB;
   fp.write(buffer, 1);
@@ -122,8 +122,8 @@ static void marshall_double(double d, char *buffer) {
 }
 
 static void msgpack_double(std::ofstream &fp, double d) {
-  static char buffer[1];
-  static char dbuffer[8];
+  static OMC_THREAD_LOCAL char buffer[1];
+  static OMC_THREAD_LOCAL char dbuffer[8];
 
   buffer[0] = 0xcb;
   marshall_double(d, dbuffer);
@@ -281,7 +281,7 @@ static void write_cont_table(std::ofstream &fp, MODEL_DATA *modelData) {
 }
 
 static void write_header(std::ofstream &fp, MODEL_DATA *modelData) {
-  static char buffer[80];
+  static OMC_THREAD_LOCAL char buffer[80];
 
   msgpack_obj_header(fp, 3); // header
 
@@ -0,0 +1,337 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-CurrentYear, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/*! \file simulation_instances.c
+ */
+
+#if !defined(OMC_NO_THREADS)
+  #define GC_THREADS
+  #include <gc/omc_gc.h>
+#endif
+
+#include "simulation_instances.h"
+#include "options.h"
+#include "solver/model_help.h"
+#include "solver/mixedSystem.h"
+#include "solver/linearSystem.h"
+#include "solver/nonlinearSystem.h"
+#include "../util/omc_error.h"
+#include "../util/omc_init.h"
+#include "../util/rtclock.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(OMC_MINIMAL_RUNTIME)
+
+/**
+ * @brief Number of instances of the model that may run concurrently.
+ *
+ * External objects wrap foreign code that is not known to be reentrant,
+ * models with external objects are simulated by a single instance.
+ *
+ * @param data      Runtime data struct.
+ * @param nThreads  Requested number of threads.
+ * @return int      Number of threads to use, at least 1.
+ */
+int simInstancesMaxThreads(DATA *data, int nThreads)
+{
+  if (nThreads < 1) {
+    return 1;
+  }
+#if defined(OMC_NO_THREADS)
+  if (nThreads > 1) {
+    warningStreamPrint(LOG_STDOUT, 0, "The runtime is built without threads, model instances are simulated one after the other.");
+  }
+  return 1;
+#else
+  if (nThreads > 1 && data->modelData->nExtObjs > 0) {
+    warningStreamPrint(LOG_STDOUT, 0, "The model has %ld external objects, which may not be reentrant. Model instances are simulated one after the other.", data->modelData->nExtObjs);
+    return 1;
+  }
+  return nThreads;
+#endif
+}
+
+/**
+ * @brief Makes `instance` a new instance of the model of `master`.
+ *
+ * The instance gets its own buffers from initializeDataStruc. Only the
+ * contents of the static model data (start attributes, variable infos) and
+ * the settings read from the init xml file and the flags are copied from the
+ * master. The variable infos themselves are shared and owned by the master.
+ */
+static void simInstanceInit(SIM_INSTANCE *instance, DATA *master, threadData_t *threadData)
+{
+  MODEL_DATA *mData = &instance->modelData;
+  SIMULATION_INFO *sInfo = &instance->simulationInfo;
+  DATA *data = &instance->data;
+
+  instance->threadData = (threadData_t*) omc_alloc_interface.malloc_uncollectable(sizeof(threadData_t));
+  assertStreamPrint(threadData, NULL != instance->threadData, "out of memory");
+  memset(instance->threadData, 0, sizeof(threadData_t));
+#if !defined(OMC_NO_THREADS)
+  pthread_mutex_init(&instance->threadData->parentMutex, NULL);
+#endif
+
+  /* memcpy: the callbacks have const members */
+  memcpy(&instance->callback, master->callback, sizeof(instance->callback));
+  *mData = *master->modelData;
+  *sInfo = *master->simulationInfo;
+  /* -lv_time switches the process wide log streams on and off */
+  sInfo->useLoggingTime = 0;
+
+  *data = *master;
+  data->modelData = mData;
+  data->simulationInfo = sInfo;
+  data->callback = &instance->callback;
+  data->simResult = &instance->simResult;
+  data->embeddedServerState = NULL;
+  sim_result_reset(&instance->simResult);
+  instance->nJobs = 0;
+
+  initializeDataStruc(data, threadData);
+  mData->sharedVarInfo = 1;
+
+#define COPY_MODEL_DATA(n, vars) memcpy(mData->vars, master->modelData->vars, mData->n*sizeof(*mData->vars));
+  COPY_MODEL_DATA(nVariablesReal, realVarsData)
+  COPY_MODEL_DATA(nVariablesInteger, integerVarsData)
+  COPY_MODEL_DATA(nVariablesBoolean, booleanVarsData)
+#if !defined(OMC_NVAR_STRING) || OMC_NVAR_STRING>0
+  COPY_MODEL_DATA(nVariablesString, stringVarsData)
+#endif
+  COPY_MODEL_DATA(nParametersReal, realParameterData)
+  COPY_MODEL_DATA(nParametersInteger, integerParameterData)
+  COPY_MODEL_DATA(nParametersBoolean, booleanParameterData)
+  COPY_MODEL_DATA(nParametersString, stringParameterData)
+  COPY_MODEL_DATA(nAliasReal, realAlias)
+  COPY_MODEL_DATA(nAliasInteger, integerAlias)
+  COPY_MODEL_DATA(nAliasBoolean, booleanAlias)
+  COPY_MODEL_DATA(nAliasString, stringAlias)
+  COPY_MODEL_DATA(nSamples, samplesInfo)
+  if (omc_flag[FLAG_IDAS]) {
+    COPY_MODEL_DATA(nSensitivityVars, realSensitivityData)
+  }
+#undef COPY_MODEL_DATA
+
+  /* solver settings reset by initializeDataStruc */
+  sInfo->nlsMethod = master->simulationInfo->nlsMethod;
+  sInfo->nlsLinearSolver = master->simulationInfo->nlsLinearSolver;
+  sInfo->lsMethod = master->simulationInfo->lsMethod;
+  sInfo->lssMethod = master->simulationInfo->lssMethod;
+  sInfo->mixedMethod = master->simulationInfo->mixedMethod;
+  sInfo->newtonStrategy = master->simulationInfo->newtonStrategy;
+  sInfo->nlsCsvInfomation = master->simulationInfo->nlsCsvInfomation;
+
+  initializeMixedSystems(data, threadData);
+  initializeLinearSystems(data, threadData);
+  initializeNonlinearSystems(data, threadData);
+}
+
+/**
+ * @brief Creates instances of the model of `data`.
+ *
+ * Call after initRuntimeAndSimulation has read the init xml file into `data`.
+ *
+ * @param data          Runtime data struct of the model started from the command line.
+ * @param threadData    Thread data for error handling.
+ * @param nInstances    Number of instances.
+ * @return SIM_INSTANCE* Array of nInstances instances, free with simInstancesFree.
+ */
+SIM_INSTANCE* simInstancesCreate(DATA *data, threadData_t *threadData, int nInstances)
+{
+  SIM_INSTANCE *instances;
+  int k;
+
+  assertStreamPrint(threadData, nInstances < 2 || 0 == data->modelData->nExtObjs, "Models with external objects can only be instantiated once.");
+  instances = (SIM_INSTANCE*) calloc(nInstances, sizeof(SIM_INSTANCE));
+  assertStreamPrint(threadData, NULL != instances, "out of memory");
+  for (k=0; k<nInstances; k++) {
+    simInstanceInit(&instances[k], data, threadData);
+  }
+  infoStreamPrint(LOG_SOLVER, 0, "created %d instances of model %s", nInstances, data->modelData->modelName);
+  return instances;
+}
+
+typedef struct SIM_INSTANCE_WORKER
+{
+  SIM_INSTANCE *instance;
+  SIM_INSTANCE_JOB job;
+  void *userData;
+  int nJobs;
+  int *nextJob;               /* shared by all workers */
+  int nFailed;
+#if !defined(OMC_NO_THREADS)
+  pthread_mutex_t *mutex;     /* guards nextJob */
+#endif
+} SIM_INSTANCE_WORKER;
+
+static int simInstanceNextJob(SIM_INSTANCE_WORKER *worker)
+{
+  int job;
+#if !defined(OMC_NO_THREADS)
+  pthread_mutex_lock(worker->mutex);
+#endif
+  job = (*worker->nextJob)++;
+#if !defined(OMC_NO_THREADS)
+  pthread_mutex_unlock(worker->mutex);
+#endif
+  return job;
+}
+
+/**
+ * @brief Does jobs with one instance until all jobs are taken.
+ */
+static void* simInstanceWork(void *arg)
+{
+  SIM_INSTANCE_WORKER *worker = (SIM_INSTANCE_WORKER*) arg;
+  SIM_INSTANCE *instance = worker->instance;
+  threadData_t *threadData = instance->threadData;
+  int job, retVal;
+#if !defined(OMC_NO_THREADS)
+  struct GC_stack_base sb;
+
+  /* the jobs allocate with the GC, which has to know the stack of the thread */
+  memset(&sb, 0, sizeof(sb));
+  GC_get_stack_base(&sb);
+  GC_register_my_thread(&sb);
+  pthread_setspecific(mmc_thread_data_key, threadData);
+#endif
+  rt_init_thread();
+
+  while ((job = simInstanceNextJob(worker)) < worker->nJobs) {
+    retVal = -1;
+    MMC_TRY_INTERNAL(mmc_jumper)
+    MMC_TRY_INTERNAL(globalJumpBuffer)
+    retVal = worker->job(instance, job, worker->userData);
+    MMC_CATCH_INTERNAL(globalJumpBuffer)
+    MMC_CATCH_INTERNAL(mmc_jumper)
+    if (retVal) {
+      worker->nFailed++;
+    }
+    instance->nJobs++;
+  }
+#if !defined(OMC_NO_THREADS)
+  rt_free_thread();
+  GC_unregister_my_thread();
+#endif
+  return NULL;
+}
+
+/**
+ * @brief Does jobs 0, ..., nJobs-1 with nInstances instances concurrently.
+ *
+ * Every instance runs in its own thread and takes the next job when it is
+ * done with the last one. Which instance does which job is not fixed, so a
+ * job has to set up everything it depends on, e.g. reset the instance with
+ * resetDataStruc if instance->nJobs > 0.
+ *
+ * @param instances     Instances from simInstancesCreate.
+ * @param nInstances    Number of instances.
+ * @param nJobs         Number of jobs.
+ * @param job           Called for every job in the thread of the instance doing it.
+ * @param userData      Passed to job.
+ * @return int          Number of failed jobs.
+ */
+int simInstancesRun(SIM_INSTANCE *instances, int nInstances, int nJobs, SIM_INSTANCE_JOB job, void *userData)
+{
+  SIM_INSTANCE_WORKER *workers;
+  int k, nextJob = 0, nFailed = 0;
+  int nThreads = nInstances < nJobs ? nInstances : nJobs;
+#if !defined(OMC_NO_THREADS)
+  pthread_mutex_t mutex;
+  pthread_t *threads;
+#endif
+
+  if (nThreads < 1) {
+    return 0;
+  }
+  workers = (SIM_INSTANCE_WORKER*) calloc(nThreads, sizeof(SIM_INSTANCE_WORKER));
+  assertStreamPrint(NULL, NULL != workers, "out of memory");
+  for (k=0; k<nThreads; k++) {
+    workers[k].instance = &instances[k];
+    workers[k].job = job;
+    workers[k].userData = userData;
+    workers[k].nJobs = nJobs;
+    workers[k].nextJob = &nextJob;
+  }
+
+#if defined(OMC_NO_THREADS)
+  simInstanceWork(&workers[0]);
+#else
+  GC_allow_register_threads();
+  pthread_mutex_init(&mutex, NULL);
+  threads = (pthread_t*) malloc(nThreads*sizeof(pthread_t));
+  assertStreamPrint(NULL, NULL != threads, "out of memory");
+  for (k=0; k<nThreads; k++) {
+    workers[k].mutex = &mutex;
+    if (pthread_create(&threads[k], NULL, simInstanceWork, &workers[k])) {
+      throwStreamPrint(NULL, "Could not create thread %d of %d for the model instances.", k+1, nThreads);
+    }
+  }
+  for (k=0; k<nThreads; k++) {
+    pthread_join(threads[k], NULL);
+  }
+  free(threads);
+  pthread_mutex_destroy(&mutex);
+#endif
+
+  for (k=0; k<nThreads; k++) {
+    nFailed += workers[k].nFailed;
+  }
+  free(workers);
+  return nFailed;
+}
+
+/**
+ * @brief Frees instances from simInstancesCreate.
+ */
+void simInstancesFree(SIM_INSTANCE *instances, int nInstances)
+{
+  int k;
+
+  if (!instances) {
+    return;
+  }
+  for (k=0; k<nInstances; k++) {
+    SIM_INSTANCE *instance = &instances[k];
+    freeMixedSystems(&instance->data, instance->threadData);
+    freeLinearSystems(&instance->data, instance->threadData);
+    freeNonlinearSystems(&instance->data, instance->threadData);
+    deInitializeDataStruc(&instance->data);
+#if !defined(OMC_NO_THREADS)
+    pthread_mutex_destroy(&instance->threadData->parentMutex);
+#endif
+    omc_alloc_interface.free_uncollectable(instance->threadData);
+  }
+  free(instances);
+}
+
+#endif /* !OMC_MINIMAL_RUNTIME */
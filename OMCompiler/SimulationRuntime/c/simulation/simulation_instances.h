@@ -0,0 +1,76 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-CurrentYear, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+
+/*! \file simulation_instances.h
+ *
+ * Several instances of one compiled model simulated concurrently within a
+ * single process. Every instance is a copy of the DATA of the model started
+ * from the command line, with its own buffers, solver data, result file and
+ * threadData, sharing only the read-only model description (variable
+ * names, init xml data) with it. simInstancesRun runs every instance in
+ * its own thread, ensemble_main (solver/ensemble.h) steps the instances in
+ * lockstep within one thread.
+ */
+
+#ifndef OMC_SIMULATION_INSTANCES_H
+#define OMC_SIMULATION_INSTANCES_H
+
+#include "../simulation_data.h"
+#include "results/simulation_result.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct SIM_INSTANCE
+{
+  DATA data;
+  MODEL_DATA modelData;
+  SIMULATION_INFO simulationInfo;
+  struct OpenModelicaGeneratedFunctionCallbacks callback; /* copy, the solvers exchange some callbacks */
+  simulation_result simResult;
+  threadData_t *threadData;
+  int nJobs;                /* number of jobs this instance has done so far */
+} SIM_INSTANCE;
+
+/* One job of simInstancesRun; returns 0 on success */
+typedef int (*SIM_INSTANCE_JOB)(SIM_INSTANCE *instance, int job, void *userData);
+
+int simInstancesMaxThreads(DATA *data, int nThreads);
+SIM_INSTANCE* simInstancesCreate(DATA *data, threadData_t *threadData, int nInstances);
+int simInstancesRun(SIM_INSTANCE *instances, int nInstances, int nJobs, SIM_INSTANCE_JOB job, void *userData);
+void simInstancesFree(SIM_INSTANCE *instances, int nInstances);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
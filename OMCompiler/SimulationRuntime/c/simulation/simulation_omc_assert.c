@@ -41,9 +41,10 @@ void (*omc_assert_withEquationIndexes)(threadData_t*, FILE_INFO info, const int
 void (*omc_assert_warning_withEquationIndexes)(FILE_INFO info, const int *indexes, const char *msg, ...) = omc_assert_warning_simulation_withEquationIndexes;
 
 
-int terminationTerminate = 0; /* Becomes non-zero when user terminates simulation. */
-FILE_INFO TermInfo;           /* message for termination. */
-char* TermMsg;                /* message for termination. */
+/* per thread, terminate() ends only the calling model instance */
+OMC_THREAD_LOCAL int terminationTerminate = 0; /* Becomes non-zero when user terminates simulation. */
+OMC_THREAD_LOCAL FILE_INFO TermInfo;           /* message for termination. */
+OMC_THREAD_LOCAL char* TermMsg;                /* message for termination. */
 
 /*! \fn void setTermMsg(const char* msg)
  *
@@ -53,7 +54,7 @@ char* TermMsg;                /* message for termination. */
 static void setTermMsg(const char *msg, va_list ap)
 {
   size_t i;
-  static size_t termMsgSize = 0;
+  static OMC_THREAD_LOCAL size_t termMsgSize = 0;
   if(NULL == TermMsg)
   {
     termMsgSize = modelica_integer_max(strlen(msg)*2+1,(size_t)2048);
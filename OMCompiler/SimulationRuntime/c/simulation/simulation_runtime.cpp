@@ -36,6 +36,7 @@
 #include <sstream>
 #include <limits>
 #include <list>
+#include <vector>
 #include <cmath>
 #include <iomanip>
 #include <ctime>
@@ -82,7 +83,10 @@
 #include "simulation/results/simulation_result_ia.h"
 #include "simulation/solver/solver_main.h"
 #include "simulation_info_json.h"
+#include "simulation_sweep.h"
+#include "simulation_instances.h"
 #include "modelinfo.h"
+#include "jacobian_cache.h"
 #include "simulation/solver/events.h"
 #include "simulation/solver/model_help.h"
 #include "simulation/solver/mixedSystem.h"
@@ -92,6 +96,7 @@
 #include "omc_config.h"
 #include "simulation/solver/initialization/initialization.h"
 #include "simulation/solver/dae_mode.h"
+#include "simulation/solver/ensemble.h"
 #include "dataReconciliation/dataReconciliation.h"
 #include "util/parallel_helper.h"
 
@@ -115,6 +120,10 @@ const std::string *init_method = NULL; /* method for  initialization. */
 
 static int callSolver(DATA* simData, threadData_t *threadData, string init_initMethod, string init_file,
       double init_time, string outputVariablesAtEnd, int cpuTime, const char *argv_0);
+#if !defined(OMC_MINIMAL_RUNTIME)
+static int callSweep(DATA* simData, threadData_t *threadData, string init_initMethod, string init_file,
+      double init_time, string outputVariablesAtEnd, int cpuTime, const char *argv_0);
+#endif
 
 /*! \fn void setGlobalVerboseLevel(int argc, char**argv)
  *
@@ -618,6 +627,11 @@ int startNonInteractiveSimulation(int argc, char**argv, DATA* data, threadData_t
     reactivateLogging();
   }
 
+#if !defined(OMC_MINIMAL_RUNTIME)
+  if (omc_flag[FLAG_SWEEP]) {
+    retVal = callSweep(data, threadData, init_initMethod, init_file, init_time, outputVariablesAtEnd, cpuTime, argv[0]);
+  } else
+#endif
   retVal = callSolver(data, threadData, init_initMethod, init_file, init_time, outputVariablesAtEnd, cpuTime, argv[0]);
 
   /* Check if logging should be disabled */
@@ -695,75 +709,70 @@ int initializeResultData(DATA* simData, threadData_t *threadData, int cpuTime)
   int resultFormatHasCheapAliasesAndParameters = 0;
   int retVal = 0;
   mmc_sint_t maxSteps = 4 * simData->simulationInfo->numSteps;
-  sim_result.filename = strdup(simData->modelData->resultFileName);
-  sim_result.numpoints = maxSteps;
-  sim_result.cpuTime = cpuTime;
+  simulation_result *simResult = simData->simResult;
+  sim_result_reset(simResult);
+  simResult->filename = strdup(simData->modelData->resultFileName);
+  simResult->numpoints = maxSteps;
+  simResult->cpuTime = cpuTime;
   if (sim_noemit || 0 == strcmp("empty", simData->simulationInfo->outputFormat)) {
     /* Default is set to noemit */
   } else if(0 == strcmp("csv", simData->simulationInfo->outputFormat)) {
-    sim_result.init = omc_csv_init;
-    sim_result.emit = omc_csv_emit;
-    /* sim_result.writeParameterData = omc_csv_writeParameterData; */
-    sim_result.free = omc_csv_free;
+    simResult->init = omc_csv_init;
+    simResult->emit = omc_csv_emit;
+    /* simResult->writeParameterData = omc_csv_writeParameterData; */
+    simResult->free = omc_csv_free;
   } else if(0 == strcmp("mat", simData->simulationInfo->outputFormat)) {
-    sim_result.init = mat4_init4;
-    sim_result.emit = mat4_emit4;
-    sim_result.writeParameterData = mat4_writeParameterData4;
-    sim_result.free = mat4_free4;
+    simResult->init = mat4_init4;
+    simResult->emit = mat4_emit4;
+    simResult->writeParameterData = mat4_writeParameterData4;
+    simResult->free = mat4_free4;
     resultFormatHasCheapAliasesAndParameters = 1;
 #if !defined(OMC_MINIMAL_RUNTIME)
   } else if(0 == strcmp("wall", simData->simulationInfo->outputFormat)) {
-    sim_result.init = recon_wall_init;
-    sim_result.emit = recon_wall_emit;
-    sim_result.writeParameterData = recon_wall_writeParameterData;
-    sim_result.free = recon_wall_free;
+    simResult->init = recon_wall_init;
+    simResult->emit = recon_wall_emit;
+    simResult->writeParameterData = recon_wall_writeParameterData;
+    simResult->free = recon_wall_free;
     resultFormatHasCheapAliasesAndParameters = 1;
   } else if(0 == strcmp("plt", simData->simulationInfo->outputFormat)) {
-    sim_result.init = plt_init;
-    sim_result.emit = plt_emit;
-    /* sim_result.writeParameterData = plt_writeParameterData; */
-    sim_result.free = plt_free;
+    simResult->init = plt_init;
+    simResult->emit = plt_emit;
+    /* simResult->writeParameterData = plt_writeParameterData; */
+    simResult->free = plt_free;
   }
   //NEW interactive
   else if(0 == strcmp("ia", simData->simulationInfo->outputFormat)) {
-    sim_result.init = ia_init;
-    sim_result.emit = ia_emit;
-    //sim_result.writeParameterData = ia_writeParameterData;
-    sim_result.free = ia_free;
+    simResult->init = ia_init;
+    simResult->emit = ia_emit;
+    //simResult->writeParameterData = ia_writeParameterData;
+    simResult->free = ia_free;
 #endif
   } else {
     cerr << "Unknown output format: " << simData->simulationInfo->outputFormat << endl;
     return 1;
   }
   initializeOutputFilter(simData->modelData, simData->simulationInfo->variableFilter, resultFormatHasCheapAliasesAndParameters);
-  sim_result.init(&sim_result, simData, threadData);
-  infoStreamPrint(LOG_SOLVER, 0, "Allocated simulation result data storage for method '%s' and file='%s'", (char*) simData->simulationInfo->outputFormat, sim_result.filename);
+  simResult->init(simResult, simData, threadData);
+  infoStreamPrint(LOG_SOLVER, 0, "Allocated simulation result data storage for method '%s' and file='%s'", (char*) simData->simulationInfo->outputFormat, simResult->filename);
   return 0;
 }
 
 /**
- * Calls the solver which is selected in the parameter string "method"
- * This function is used for interactive and non-interactive simulation
+ * Selects the solver given by the parameter string "method" and runs it.
+ * The result object simData->simResult has to be initialized by the caller.
  * Parameter method:
  * "" & "dassl" calls a DASSL Solver
  * "euler" calls an Euler solver
  * "rungekutta" calls a fourth-order Runge-Kutta Solver
  */
-static int callSolver(DATA* simData, threadData_t *threadData, string init_initMethod, string init_file,
-      double init_time, string outputVariablesAtEnd, int cpuTime, const char *argv_0)
+static int runSolver(DATA* simData, threadData_t *threadData, const string &init_initMethod, const string &init_file,
+      double init_time, const char *outVars, const char *argv_0)
 {
   TRACE_PUSH
   int retVal = -1;
   mmc_sint_t i;
   mmc_sint_t solverID = S_UNKNOWN;
-  const char* outVars = (outputVariablesAtEnd.size() == 0) ? NULL : outputVariablesAtEnd.c_str();
-  MMC_TRY_INTERNAL(mmc_jumper)
-  MMC_TRY_INTERNAL(globalJumpBuffer)
 
-  if (initializeResultData(simData, threadData, cpuTime)) {
-    TRACE_POP
-    return -1;
-  }
   simData->real_time_sync.scaling = getFlagReal(FLAG_RT, 0.0);
 
   if(std::string("") == simData->simulationInfo->solverMethod) {
@@ -820,15 +829,279 @@ static int callSolver(DATA* simData, threadData_t *threadData, string init_initM
       retVal = solver_main(simData, threadData, init_initMethod.c_str(), init_file.c_str(), init_time, solverID, outVars, argv_0);
   }
 
+  TRACE_POP
+  return retVal;
+}
+
+/**
+ * Calls the solver which is selected in the parameter string "method"
+ * This function is used for interactive and non-interactive simulation
+ */
+static int callSolver(DATA* simData, threadData_t *threadData, string init_initMethod, string init_file,
+      double init_time, string outputVariablesAtEnd, int cpuTime, const char *argv_0)
+{
+  TRACE_PUSH
+  int retVal = -1;
+  const char* outVars = (outputVariablesAtEnd.size() == 0) ? NULL : outputVariablesAtEnd.c_str();
+  MMC_TRY_INTERNAL(mmc_jumper)
+  MMC_TRY_INTERNAL(globalJumpBuffer)
+
+  if (initializeResultData(simData, threadData, cpuTime)) {
+    TRACE_POP
+    return -1;
+  }
+
+  retVal = runSolver(simData, threadData, init_initMethod, init_file, init_time, outVars, argv_0);
+
   MMC_CATCH_INTERNAL(mmc_jumper)
   MMC_CATCH_INTERNAL(globalJumpBuffer)
 
-  sim_result.free(&sim_result, simData, threadData);
+  simData->simResult->free(simData->simResult, simData, threadData);
 
   TRACE_POP
   return retVal;
 }
 
+#if !defined(OMC_MINIMAL_RUNTIME)
+/* Shared read-only by the instances simulating the runs of a sweep */
+struct SweepContext
+{
+  SWEEP_TABLE *table;
+  string base;
+  string format;
+  string init_initMethod;
+  string init_file;
+  double init_time;
+  string outputVariablesAtEnd;
+  int cpuTime;
+  const char *argv_0;
+};
+
+/* The result file name is allocated by initializeResultData for every run */
+static void sweepFreeResultFileName(simulation_result *simResult)
+{
+  free((char*) simResult->filename);
+  simResult->filename = NULL;
+}
+
+/**
+ * Simulates run `run` of the sweep with a model instance, called in the
+ * thread of the instance by simInstancesRun.
+ */
+static int sweepRunInstance(SIM_INSTANCE *instance, int run, void *userData)
+{
+  const SweepContext *ctx = (const SweepContext*) userData;
+  DATA *data = &instance->data;
+  threadData_t *threadData = instance->threadData;
+  std::stringstream runFile;
+  int retVal;
+
+  infoStreamPrint(LOG_STDOUT, 0, "Parameter sweep: run %d of %d", run+1, ctx->table->nRuns);
+  sweepApplyRun(data, threadData, ctx->table, run);
+  if (instance->nJobs > 0) {
+    resetDataStruc(data, threadData);
+  }
+
+  runFile << ctx->base << "_" << run+1 << ctx->format;
+  data->modelData->resultFileName = GC_strdup(runFile.str().c_str());
+  retVal = callSolver(data, threadData, ctx->init_initMethod, ctx->init_file, ctx->init_time, ctx->outputVariablesAtEnd, ctx->cpuTime, ctx->argv_0);
+  sweepFreeResultFileName(data->simResult);
+
+  if (retVal) {
+    warningStreamPrint(LOG_STDOUT, 0, "Parameter sweep: run %d failed.", run+1);
+  }
+  return retVal;
+}
+
+/**
+ * Simulates the model once for every row of the sweep table given by -sweep.
+ * The model data is read only once; between the runs the start values and
+ * settings of the table are applied and the run dependent data is reset.
+ * Depending on -sweepOutput every run gets its own result file or all runs
+ * are written to one combined csv-file.
+ * With -sweepThreads=<n> and separate result files the runs are simulated by
+ * n instances of the model concurrently, see simulation_instances.h.
+ * With -sweepEnsemble=<k> groups of k runs are integrated in lockstep by one
+ * thread, see ensemble.h.
+ */
+static int callSweep(DATA* simData, threadData_t *threadData, string init_initMethod, string init_file,
+      double init_time, string outputVariablesAtEnd, int cpuTime, const char *argv_0)
+{
+  TRACE_PUSH
+  int retVal = 0, runRetVal, run, nFailed = 0;
+  int sweepOutput = SWEEP_OUTPUT_SEPARATE;
+  int nThreads = 1, nLanes = 1;
+  ENSEMBLE_STATS ensembleStats = {0, 0, 0};
+  const char* outVars = (outputVariablesAtEnd.size() == 0) ? NULL : outputVariablesAtEnd.c_str();
+  const string format = string(".") + simData->simulationInfo->outputFormat;
+  string base = simData->modelData->resultFileName;
+  void *combined = NULL;
+  SWEEP_TABLE *table;
+  rtclock_t sweepClock;
+  double sweepTime;
+
+  readFlag(&sweepOutput, SWEEP_OUTPUT_MAX, omc_flagValue[FLAG_SWEEP_OUTPUT], "-sweepOutput", SWEEP_OUTPUT_NAME, SWEEP_OUTPUT_DESC);
+  table = sweepTableRead(simData, threadData, omc_flagValue[FLAG_SWEEP]);
+
+  if (omc_flag[FLAG_SWEEP_THREADS]) {
+    nThreads = atoi(omc_flagValue[FLAG_SWEEP_THREADS]);
+    if (nThreads > 1 && SWEEP_OUTPUT_COMBINED == sweepOutput) {
+      warningStreamPrint(LOG_STDOUT, 0, "-sweepOutput=%s writes all runs to one file, ignoring -sweepThreads=%d.", SWEEP_OUTPUT_NAME[sweepOutput], nThreads);
+      nThreads = 1;
+    }
+    if (nThreads > 1 && simData->modelData->create_linearmodel) {
+      warningStreamPrint(LOG_STDOUT, 0, "Linearization (-l) after a parameter sweep needs the last run in the main instance, ignoring -sweepThreads=%d.", nThreads);
+      nThreads = 1;
+    }
+    nThreads = simInstancesMaxThreads(simData, nThreads < table->nRuns ? nThreads : table->nRuns);
+  }
+
+  if (omc_flag[FLAG_SWEEP_ENSEMBLE]) {
+    nLanes = atoi(omc_flagValue[FLAG_SWEEP_ENSEMBLE]);
+    if (nLanes > 1 && SWEEP_OUTPUT_COMBINED == sweepOutput) {
+      warningStreamPrint(LOG_STDOUT, 0, "-sweepOutput=%s writes all runs to one file, ignoring -sweepEnsemble=%d.", SWEEP_OUTPUT_NAME[sweepOutput], nLanes);
+      nLanes = 1;
+    }
+    if (nLanes > 1 && !ensemble_supported(simData, 1)) {
+      nLanes = 1;
+    }
+    if (nLanes > 1 && nThreads > 1) {
+      warningStreamPrint(LOG_STDOUT, 0, "The runs of an ensemble are integrated by one thread, ignoring -sweepThreads=%d.", nThreads);
+      nThreads = 1;
+    }
+    nLanes = nLanes < table->nRuns ? nLanes : table->nRuns;
+  }
+
+  /* <prefix>_res.<format> -> <prefix>_res */
+  if (base.size() > format.size() && 0 == base.compare(base.size()-format.size(), format.size(), format)) {
+    base.erase(base.size()-format.size());
+  }
+
+  if (SWEEP_OUTPUT_COMBINED == sweepOutput) {
+    if (base.size() > 4 && 0 == base.compare(base.size()-4, 4, "_res")) {
+      base.erase(base.size()-4);
+    }
+    if (0 != strcmp("csv", simData->simulationInfo->outputFormat)) {
+      warningStreamPrint(LOG_STDOUT, 0, "-sweepOutput=%s always writes a csv-file, ignoring output format %s.", SWEEP_OUTPUT_NAME[sweepOutput], simData->simulationInfo->outputFormat);
+    }
+    simData->modelData->resultFileName = GC_strdup((base + "_sweep.csv").c_str());
+    sim_result_reset(simData->simResult);
+    simData->simResult->filename = strdup(simData->modelData->resultFileName);
+    simData->simResult->numpoints = 4 * simData->simulationInfo->numSteps;
+    simData->simResult->cpuTime = cpuTime;
+    simData->simResult->init = omc_csv_sweep_init;
+    simData->simResult->emit = omc_csv_sweep_emit;
+    simData->simResult->free = omc_csv_sweep_free;
+    initializeOutputFilter(simData->modelData, simData->simulationInfo->variableFilter, 0);
+    combined = omc_csv_sweep_open(simData->simResult, simData, threadData);
+    simData->simResult->storage = combined;
+  }
+
+  rt_ext_tp_tick_realtime(&sweepClock);
+  if (nThreads > 1) {
+    SweepContext ctx = {table, base, format, init_initMethod, init_file, init_time, outputVariablesAtEnd, cpuTime, argv_0};
+    SIM_INSTANCE *instances = simInstancesCreate(simData, threadData, nThreads);
+    infoStreamPrint(LOG_STDOUT, 0, "Parameter sweep: %d runs on %d model instances", table->nRuns, nThreads);
+    nFailed = simInstancesRun(instances, nThreads, table->nRuns, sweepRunInstance, &ctx);
+    simInstancesFree(instances, nThreads);
+    if (nFailed) {
+      retVal = -1;
+    }
+  } else if (nLanes > 1) {
+    SIM_INSTANCE *instances = simInstancesCreate(simData, threadData, nLanes);
+    std::vector<int> laneRetVal(nLanes);
+    int first, lane, n, setupFailed = 0;
+    infoStreamPrint(LOG_STDOUT, 0, "Parameter sweep: %d runs in ensembles of %d", table->nRuns, nLanes);
+    for (first=0; first<table->nRuns && !setupFailed; first+=nLanes) {
+      ENSEMBLE_STATS stats = {0, 0, 0};
+      n = table->nRuns - first < nLanes ? table->nRuns - first : nLanes;
+      for (lane=0; lane<n; lane++) {
+        SIM_INSTANCE *instance = instances + lane;
+        std::stringstream runFile;
+        infoStreamPrint(LOG_STDOUT, 0, "Parameter sweep: run %d of %d", first+lane+1, table->nRuns);
+        sweepApplyRun(&instance->data, instance->threadData, table, first+lane);
+        if (instance->nJobs > 0) {
+          resetDataStruc(&instance->data, instance->threadData);
+        }
+        instance->nJobs++;
+        runFile << base << "_" << first+lane+1 << format;
+        instance->data.modelData->resultFileName = GC_strdup(runFile.str().c_str());
+        if (initializeResultData(&instance->data, instance->threadData, cpuTime)) {
+          setupFailed = 1;
+          n = lane;
+          break;
+        }
+      }
+      if (!setupFailed && ensemble_main(instances, n, init_initMethod.c_str(), init_file.c_str(), init_time, outVars, &laneRetVal[0], &stats)) {
+        setupFailed = 1;
+      }
+      for (lane=0; lane<n; lane++) {
+        instances[lane].simResult.free(&instances[lane].simResult, &instances[lane].data, instances[lane].threadData);
+        sweepFreeResultFileName(&instances[lane].simResult);
+        if (setupFailed || laneRetVal[lane]) {
+          warningStreamPrint(LOG_STDOUT, 0, "Parameter sweep: run %d failed.", first+lane+1);
+          nFailed++;
+          retVal = setupFailed ? -1 : laneRetVal[lane];
+        }
+      }
+      if (setupFailed) {
+        retVal = -1;
+      }
+      ensembleStats.nRounds += stats.nRounds;
+      ensembleStats.nLaneSteps += stats.nLaneSteps;
+      ensembleStats.nLockstepLaneSteps += stats.nLockstepLaneSteps;
+    }
+    simInstancesFree(instances, nLanes);
+  } else {
+    for (run=0; run<table->nRuns; run++) {
+      infoStreamPrint(LOG_STDOUT, 0, "Parameter sweep: run %d of %d", run+1, table->nRuns);
+      sweepApplyRun(simData, threadData, table, run);
+      if (run > 0) {
+        resetDataStruc(simData, threadData);
+      }
+
+      if (combined) {
+        omc_csv_sweep_set_run(combined, run+1);
+        runRetVal = -1;
+        MMC_TRY_INTERNAL(mmc_jumper)
+        MMC_TRY_INTERNAL(globalJumpBuffer)
+        runRetVal = runSolver(simData, threadData, init_initMethod, init_file, init_time, outVars, argv_0);
+        MMC_CATCH_INTERNAL(mmc_jumper)
+        MMC_CATCH_INTERNAL(globalJumpBuffer)
+        simData->simResult->free(simData->simResult, simData, threadData);
+      } else {
+        std::stringstream runFile;
+        runFile << base << "_" << run+1 << format;
+        simData->modelData->resultFileName = GC_strdup(runFile.str().c_str());
+        runRetVal = callSolver(simData, threadData, init_initMethod, init_file, init_time, outputVariablesAtEnd, cpuTime, argv_0);
+        sweepFreeResultFileName(simData->simResult);
+      }
+
+      if (runRetVal) {
+        warningStreamPrint(LOG_STDOUT, 0, "Parameter sweep: run %d failed.", run+1);
+        nFailed++;
+        retVal = runRetVal;
+      }
+    }
+  }
+  sweepTime = rt_ext_tp_tock(&sweepClock);
+
+  infoStreamPrint(LOG_STDOUT, 0, "Parameter sweep: %d runs (%d failed) in %g s, %g runs/s", table->nRuns, nFailed, sweepTime, sweepTime > 0 ? table->nRuns/sweepTime : 0.0);
+  if (nLanes > 1) {
+    infoStreamPrint(LOG_STDOUT, 0, "Parameter sweep: %lu run steps in %lu ensemble steps, %lu in lockstep, %g run steps/s", ensembleStats.nLaneSteps, ensembleStats.nRounds, ensembleStats.nLockstepLaneSteps, sweepTime > 0 ? ensembleStats.nLaneSteps/sweepTime : 0.0);
+  }
+
+  if (combined) {
+    omc_csv_sweep_close(combined);
+    simData->simResult->storage = NULL;
+    sweepFreeResultFileName(simData->simResult);
+  }
+  sweepTableFree(simData, table);
+
+  TRACE_POP
+  return retVal;
+}
+#endif
 
 /**
  * Initialization is the same for interactive or non-interactive simulation
@@ -898,12 +1171,24 @@ int initRuntimeAndSimulation(int argc, char**argv, DATA *data, threadData_t *thr
         /* detailed information for some flags */
         switch(i)
         {
+          case FLAG_CVODE_LS:
+            for(j=1; j<CVODE_LS_MAX; ++j) {
+              infoStreamPrint(LOG_STDOUT, 0, "%-18s [%s]", CVODE_LS_METHOD[j], CVODE_LS_METHOD_DESC[j]);
+            }
+            break;
+
           case FLAG_IDA_LS:
             for(j=1; j<IDA_LS_MAX; ++j) {
               infoStreamPrint(LOG_STDOUT, 0, "%-18s [%s]", IDA_LS_METHOD[j], IDA_LS_METHOD_DESC[j]);
             }
             break;
 
+          case FLAG_IDA_PREC:
+            for(j=1; j<IDA_PREC_MAX; ++j) {
+              infoStreamPrint(LOG_STDOUT, 0, "%-18s [%s]", IDA_PREC_METHOD[j], IDA_PREC_METHOD_DESC[j]);
+            }
+            break;
+
           case FLAG_IIM:
             for(j=1; j<IIM_MAX; ++j) {
               infoStreamPrint(LOG_STDOUT, 0, "%-18s [%s]", INIT_METHOD_NAME[j], INIT_METHOD_DESC[j]);
@@ -978,6 +1263,9 @@ int initRuntimeAndSimulation(int argc, char**argv, DATA *data, threadData_t *thr
     data->simulationInfo->maxWarnDisplays = DEFAULT_FLAG_LV_MAX_WARN;
   }
 
+#if !defined(OMC_MINIMAL_RUNTIME)
+  data->simResult = &sim_result;
+#endif
   initializeDataStruc(data, threadData);
   if(!data)
   {
@@ -1224,6 +1512,7 @@ int _main_SimulationRuntime(int argc, char**argv, DATA *data, threadData_t *thre
 #endif
 
   retVal = startNonInteractiveSimulation(argc, argv, data, threadData);
+  flushSparsePatternCache(data);
 
   freeMixedSystems(data, threadData);        /* free mixed system data */
   freeLinearSystems(data, threadData);       /* free linear system data */
@@ -57,12 +57,12 @@ extern "C" {
 extern int initializeResultData(DATA* simData, threadData_t *threadData, int cpuTime);
 
 extern int modelTermination;     /* Becomes non-zero when simulation terminates. */
-extern int terminationTerminate; /* Becomes non-zero when user terminates simulation. */
+extern OMC_THREAD_LOCAL int terminationTerminate; /* Becomes non-zero when user terminates simulation. */
 extern int terminationAssert;    /* Becomes non-zero when model call assert simulation. */
 extern int warningLevelAssert;   /* Becomes non-zero when model call assert with warning level. */
-extern FILE_INFO TermInfo;       /* message for termination. */
+extern OMC_THREAD_LOCAL FILE_INFO TermInfo;       /* message for termination. */
 
-extern char* TermMsg; /* message for termination. */
+extern OMC_THREAD_LOCAL char* TermMsg; /* message for termination. */
 
 /* defined in model code. Used to get name of variable by investigating its pointer in the state or alg vectors. */
 extern const char* getNameReal(double* ptr);
@@ -0,0 +1,255 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-CurrentYear, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/*! \file simulation_sweep.c
+ */
+
+#include "simulation_sweep.h"
+#include "options.h"
+#include "../util/omc_error.h"
+#include "../util/read_csv.h"
+
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+const char *SWEEP_OUTPUT_NAME[SWEEP_OUTPUT_MAX] = {
+  "unknown",
+  /* SWEEP_OUTPUT_SEPARATE */ "separate",
+  /* SWEEP_OUTPUT_COMBINED */ "combined"
+};
+
+const char *SWEEP_OUTPUT_DESC[SWEEP_OUTPUT_MAX] = {
+  "unknown",
+  /* SWEEP_OUTPUT_SEPARATE */ "one result file <prefix>_res_<run>.<format> per run",
+  /* SWEEP_OUTPUT_COMBINED */ "all runs in a single csv-file <prefix>_sweep.csv with a leading column run"
+};
+
+#if !defined(OMC_MINIMAL_RUNTIME)
+
+/**
+ * @brief Find the parameter, variable or simulation setting a sweep column refers to.
+ *
+ * Parameters take precedence over variables; for variables the start attribute is overridden.
+ *
+ * @param data      Runtime data struct.
+ * @param column    Column with name set. On output target and index are set.
+ * @return int      1 if the name could be resolved, 0 otherwise.
+ */
+static int sweepResolveColumn(DATA *data, SWEEP_COLUMN *column)
+{
+  MODEL_DATA *mData = data->modelData;
+  long i;
+
+  if (0 == strcmp(column->name, "startTime")) { column->target = SWEEP_START_TIME; return 1; }
+  if (0 == strcmp(column->name, "stopTime"))  { column->target = SWEEP_STOP_TIME;  return 1; }
+  if (0 == strcmp(column->name, "stepSize"))  { column->target = SWEEP_STEP_SIZE;  return 1; }
+  if (0 == strcmp(column->name, "tolerance")) { column->target = SWEEP_TOLERANCE;  return 1; }
+
+#define SWEEP_FIND(n, vars, kind) \
+  for (i=0; i<mData->n; i++) { \
+    if (0 == strcmp(column->name, mData->vars[i].info.name)) { \
+      column->target = kind; \
+      column->index = i; \
+      return 1; \
+    } \
+  }
+
+  SWEEP_FIND(nParametersReal, realParameterData, SWEEP_REAL_PARAMETER)
+  SWEEP_FIND(nParametersInteger, integerParameterData, SWEEP_INTEGER_PARAMETER)
+  SWEEP_FIND(nParametersBoolean, booleanParameterData, SWEEP_BOOLEAN_PARAMETER)
+  SWEEP_FIND(nVariablesReal, realVarsData, SWEEP_REAL_START)
+  SWEEP_FIND(nVariablesInteger, integerVarsData, SWEEP_INTEGER_START)
+  SWEEP_FIND(nVariablesBoolean, booleanVarsData, SWEEP_BOOLEAN_START)
+
+#undef SWEEP_FIND
+
+  return 0;
+}
+
+/**
+ * @brief Read the sweep table and bind its columns to the model.
+ *
+ * Also takes a snapshot of all start attributes and simulation settings,
+ * which is restored before each run and by sweepTableFree.
+ *
+ * @param data          Runtime data struct, already initialized by read_input_xml.
+ * @param threadData    Thread data for error handling.
+ * @param filename      csv-file given by -sweep.
+ * @return SWEEP_TABLE* Sweep table, free with sweepTableFree.
+ */
+SWEEP_TABLE* sweepTableRead(DATA *data, threadData_t *threadData, const char *filename)
+{
+  MODEL_DATA *mData = data->modelData;
+  SIMULATION_INFO *sInfo = data->simulationInfo;
+  struct csv_data *csv;
+  SWEEP_TABLE *table;
+  long i;
+
+  csv = read_csv(filename);
+  if (!csv) {
+    throwStreamPrint(threadData, "Could not read sweep table \"%s\" given by -%s.", filename, FLAG_NAME[FLAG_SWEEP]);
+  }
+  if (csv->numvars < 1 || csv->numsteps < 1) {
+    omc_free_csv_reader(csv);
+    throwStreamPrint(threadData, "Sweep table \"%s\" has no columns or no runs.", filename);
+  }
+
+  table = (SWEEP_TABLE*) calloc(1, sizeof(SWEEP_TABLE));
+  assertStreamPrint(threadData, NULL != table, "out of memory");
+  table->csv = csv;
+  table->nColumns = csv->numvars;
+  table->nRuns = csv->numsteps;
+  table->columns = (SWEEP_COLUMN*) calloc(table->nColumns, sizeof(SWEEP_COLUMN));
+  assertStreamPrint(threadData, NULL != table->columns, "out of memory");
+
+  for (i=0; i<table->nColumns; i++) {
+    SWEEP_COLUMN *column = &table->columns[i];
+    column->name = csv->variables[i];
+    column->values = csv->data + i*csv->numsteps;
+    if (!sweepResolveColumn(data, column)) {
+      sweepTableFree(data, table);
+      throwStreamPrint(threadData, "Sweep table \"%s\": unknown parameter, variable or setting \"%s\".", filename, csv->variables[i]);
+    }
+    infoStreamPrint(LOG_SOLVER, 0, "sweep column %ld: %s", i+1, column->name);
+  }
+
+  /* snapshot of the start attributes */
+  table->realParameterStart = (modelica_real*) malloc(mData->nParametersReal*sizeof(modelica_real));
+  table->integerParameterStart = (modelica_integer*) malloc(mData->nParametersInteger*sizeof(modelica_integer));
+  table->booleanParameterStart = (modelica_boolean*) malloc(mData->nParametersBoolean*sizeof(modelica_boolean));
+  table->realVarsStart = (modelica_real*) malloc(mData->nVariablesReal*sizeof(modelica_real));
+  table->integerVarsStart = (modelica_integer*) malloc(mData->nVariablesInteger*sizeof(modelica_integer));
+  table->booleanVarsStart = (modelica_boolean*) malloc(mData->nVariablesBoolean*sizeof(modelica_boolean));
+
+  for (i=0; i<mData->nParametersReal; i++)    table->realParameterStart[i] = mData->realParameterData[i].attribute.start;
+  for (i=0; i<mData->nParametersInteger; i++) table->integerParameterStart[i] = mData->integerParameterData[i].attribute.start;
+  for (i=0; i<mData->nParametersBoolean; i++) table->booleanParameterStart[i] = mData->booleanParameterData[i].attribute.start;
+  for (i=0; i<mData->nVariablesReal; i++)     table->realVarsStart[i] = mData->realVarsData[i].attribute.start;
+  for (i=0; i<mData->nVariablesInteger; i++)  table->integerVarsStart[i] = mData->integerVarsData[i].attribute.start;
+  for (i=0; i<mData->nVariablesBoolean; i++)  table->booleanVarsStart[i] = mData->booleanVarsData[i].attribute.start;
+
+  table->startTime = sInfo->startTime;
+  table->stopTime = sInfo->stopTime;
+  table->stepSize = sInfo->stepSize;
+  table->tolerance = sInfo->tolerance;
+
+  infoStreamPrint(LOG_STDOUT, 0, "Parameter sweep with %d runs over %d columns read from %s", table->nRuns, table->nColumns, filename);
+  return table;
+}
+
+/**
+ * @brief Restore the snapshot of the start attributes and settings.
+ */
+static void sweepRestoreStart(DATA *data, SWEEP_TABLE *table)
+{
+  MODEL_DATA *mData = data->modelData;
+  SIMULATION_INFO *sInfo = data->simulationInfo;
+  long i;
+
+  for (i=0; i<mData->nParametersReal; i++)    mData->realParameterData[i].attribute.start = table->realParameterStart[i];
+  for (i=0; i<mData->nParametersInteger; i++) mData->integerParameterData[i].attribute.start = table->integerParameterStart[i];
+  for (i=0; i<mData->nParametersBoolean; i++) mData->booleanParameterData[i].attribute.start = table->booleanParameterStart[i];
+  for (i=0; i<mData->nVariablesReal; i++)     mData->realVarsData[i].attribute.start = table->realVarsStart[i];
+  for (i=0; i<mData->nVariablesInteger; i++)  mData->integerVarsData[i].attribute.start = table->integerVarsStart[i];
+  for (i=0; i<mData->nVariablesBoolean; i++)  mData->booleanVarsData[i].attribute.start = table->booleanVarsStart[i];
+
+  sInfo->startTime = table->startTime;
+  sInfo->stopTime = table->stopTime;
+  sInfo->stepSize = table->stepSize;
+  sInfo->tolerance = table->tolerance;
+}
+
+/**
+ * @brief Prepare the runtime data for the given run of the sweep.
+ *
+ * Restores the start attributes, applies the overrides of row `run` and
+ * resets the run dependent data. Nothing is re-allocated.
+ *
+ * @param data          Runtime data struct.
+ * @param threadData    Thread data for error handling.
+ * @param table         Sweep table.
+ * @param run           Run index, 0 <= run < table->nRuns.
+ */
+void sweepApplyRun(DATA *data, threadData_t *threadData, SWEEP_TABLE *table, int run)
+{
+  MODEL_DATA *mData = data->modelData;
+  SIMULATION_INFO *sInfo = data->simulationInfo;
+  int i;
+
+  assertStreamPrint(threadData, run >= 0 && run < table->nRuns, "sweep run %d out of range [0, %d)", run, table->nRuns);
+  sweepRestoreStart(data, table);
+
+  for (i=0; i<table->nColumns; i++) {
+    const SWEEP_COLUMN *column = &table->columns[i];
+    double value = column->values[run];
+    switch (column->target) {
+    case SWEEP_REAL_PARAMETER:    mData->realParameterData[column->index].attribute.start = value; break;
+    case SWEEP_INTEGER_PARAMETER: mData->integerParameterData[column->index].attribute.start = (modelica_integer) value; break;
+    case SWEEP_BOOLEAN_PARAMETER: mData->booleanParameterData[column->index].attribute.start = (modelica_boolean) (value != 0.0); break;
+    case SWEEP_REAL_START:        mData->realVarsData[column->index].attribute.start = value; break;
+    case SWEEP_INTEGER_START:     mData->integerVarsData[column->index].attribute.start = (modelica_integer) value; break;
+    case SWEEP_BOOLEAN_START:     mData->booleanVarsData[column->index].attribute.start = (modelica_boolean) (value != 0.0); break;
+    case SWEEP_START_TIME:        sInfo->startTime = value; break;
+    case SWEEP_STOP_TIME:         sInfo->stopTime = value; break;
+    case SWEEP_STEP_SIZE:         sInfo->stepSize = value; break;
+    case SWEEP_TOLERANCE:         sInfo->tolerance = value; break;
+    }
+    debugStreamPrint(LOG_SOLVER, 0, "sweep run %d: %s = %g", run+1, column->name, value);
+  }
+
+  sInfo->numSteps = (modelica_integer) round((sInfo->stopTime - sInfo->startTime)/sInfo->stepSize);
+  sInfo->minStepSize = 4.0 * DBL_EPSILON * fmax(fabs(sInfo->startTime), fabs(sInfo->stopTime));
+}
+
+/**
+ * @brief Restore the original start attributes and free the sweep table.
+ */
+void sweepTableFree(DATA *data, SWEEP_TABLE *table)
+{
+  if (!table) {
+    return;
+  }
+  if (table->realParameterStart) {
+    sweepRestoreStart(data, table);
+  }
+  free(table->realParameterStart);
+  free(table->integerParameterStart);
+  free(table->booleanParameterStart);
+  free(table->realVarsStart);
+  free(table->integerVarsStart);
+  free(table->booleanVarsStart);
+  free(table->columns);
+  omc_free_csv_reader((struct csv_data*) table->csv);
+  free(table);
+}
+
+#endif /* !OMC_MINIMAL_RUNTIME */
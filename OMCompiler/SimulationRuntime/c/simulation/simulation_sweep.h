@@ -0,0 +1,112 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-CurrentYear, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/*! \file simulation_sweep.h
+ *
+ * Parameter sweeps: simulate one compiled model several times within a single
+ * process. The runs are described by a csv-file (see simulation flag -sweep)
+ * with one column per overridden parameter, start value or simulation setting
+ * and one row per run.
+ */
+
+#ifndef OMC_SIMULATION_SWEEP_H
+#define OMC_SIMULATION_SWEEP_H
+
+#include "../simulation_data.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum SWEEP_OUTPUT
+{
+  SWEEP_OUTPUT_UNKNOWN = 0,
+
+  SWEEP_OUTPUT_SEPARATE,    /* one result file per run */
+  SWEEP_OUTPUT_COMBINED,    /* one csv-file with a leading run column */
+
+  SWEEP_OUTPUT_MAX
+} SWEEP_OUTPUT;
+
+extern const char *SWEEP_OUTPUT_NAME[SWEEP_OUTPUT_MAX];
+extern const char *SWEEP_OUTPUT_DESC[SWEEP_OUTPUT_MAX];
+
+typedef enum SWEEP_TARGET
+{
+  SWEEP_REAL_PARAMETER = 0,
+  SWEEP_INTEGER_PARAMETER,
+  SWEEP_BOOLEAN_PARAMETER,
+  SWEEP_REAL_START,
+  SWEEP_INTEGER_START,
+  SWEEP_BOOLEAN_START,
+  SWEEP_START_TIME,
+  SWEEP_STOP_TIME,
+  SWEEP_STEP_SIZE,
+  SWEEP_TOLERANCE
+} SWEEP_TARGET;
+
+typedef struct SWEEP_COLUMN
+{
+  const char *name;         /* header of the column */
+  SWEEP_TARGET target;      /* what is overridden by this column */
+  long index;               /* index into the corresponding variable/parameter array */
+  const double *values;     /* one value per run */
+} SWEEP_COLUMN;
+
+typedef struct SWEEP_TABLE
+{
+  void *csv;                /* struct csv_data* holding the table */
+  int nColumns;
+  int nRuns;
+  SWEEP_COLUMN *columns;
+
+  /* start attributes and settings as read from the init xml file;
+   * restored before every run */
+  modelica_real *realParameterStart;
+  modelica_integer *integerParameterStart;
+  modelica_boolean *booleanParameterStart;
+  modelica_real *realVarsStart;
+  modelica_integer *integerVarsStart;
+  modelica_boolean *booleanVarsStart;
+  double startTime;
+  double stopTime;
+  double stepSize;
+  double tolerance;
+} SWEEP_TABLE;
+
+SWEEP_TABLE* sweepTableRead(DATA *data, threadData_t *threadData, const char *filename);
+void sweepApplyRun(DATA *data, threadData_t *threadData, SWEEP_TABLE *table, int run);
+void sweepTableFree(DATA *data, SWEEP_TABLE *table);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -28,7 +28,14 @@
  *
  */
 
+#ifdef USE_PARJAC
+  #include <omp.h>
+  #define GC_THREADS
+  #include <gc/omc_gc.h>
+#endif
+
 /* Standard C headers */
+#include <float.h>
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -48,9 +55,17 @@
 #include "dassl.h"
 #include "epsilon.h"
 
+#ifndef OMC_FMI_RUNTIME
+#include "../jacobian_util.h"
+#include "jacobianSymbolical.h"
+#include "sundials_util.h"
+#endif
+
 
 #ifdef WITH_SUNDIALS
 
+#define UNUSED(x) (void)(x)   /* Surpress compiler warnings for unused function input */
+
 #define CVODE_LMM_MAX 2
 const char *CVODE_LMM_NAME[CVODE_LMM_MAX + 1] = {
     "undefined",
@@ -115,6 +130,12 @@ int cvodeRightHandSideODEFunction(realtype time, N_Vector y, N_Vector ydot, void
   /* Set time */
   data->localData[0]->timeValue = time;
 
+  /* Set states, CVODE also evaluates f(t,y) for its internal vectors (e.g. the predictor) */
+  if (N_VGetArrayPointer(y) != data->localData[0]->realVars)
+  {
+    memcpy(data->localData[0]->realVars, N_VGetArrayPointer(y), cvodeData->N * sizeof(double));
+  }
+
   saveJumpState = threadData->currentErrorStage;
   threadData->currentErrorStage = ERROR_INTEGRATOR;
 
@@ -277,6 +298,268 @@ static int callDenseJacobian(double t, N_Vector y, N_Vector fy,
   return retVal;
 }
 
+#ifndef OMC_FMI_RUNTIME
+/**
+ * @brief Build CSC structure of sparse Jacobian for KLU.
+ *
+ * The structure is the sparsity pattern of Jacobian A plus all diagonal
+ * elements, needed by CVODE to form I - gamma*J in place.
+ * Row indices of the sparsity pattern are expected in ascending order.
+ *
+ * @param sparseJac       Sparse Jacobian structure to fill.
+ * @param sparsePattern   Sparsity pattern of Jacobian A.
+ * @param N               Number of states.
+ */
+static void cvodeInitSparseJacobian(CVODE_SPARSE_JAC *sparseJac, SPARSE_PATTERN *sparsePattern, long int N)
+{
+  long int i, nth, nz = 0;
+  unsigned int row;
+  modelica_boolean hasDiagonal;
+
+  sparseJac->colPtrs = (sunindextype *)malloc((N + 1) * sizeof(sunindextype));
+  sparseJac->rowVals = (sunindextype *)malloc((sparsePattern->numberOfNonZeros + N) * sizeof(sunindextype));
+  sparseJac->nzPos = (long int *)malloc((sparsePattern->numberOfNonZeros + 1) * sizeof(long int));
+  sparseJac->values = NULL;
+
+  for (i = 0; i < N; ++i)
+  {
+    sparseJac->colPtrs[i] = nz;
+    hasDiagonal = FALSE;
+    for (nth = sparsePattern->leadindex[i]; nth < sparsePattern->leadindex[i + 1]; ++nth)
+    {
+      row = sparsePattern->index[nth];
+      if (!hasDiagonal && row >= i)
+      {
+        if (row > i)
+        {
+          sparseJac->rowVals[nz++] = i;
+        }
+        hasDiagonal = TRUE;
+      }
+      sparseJac->nzPos[nth] = nz;
+      sparseJac->rowVals[nz++] = row;
+    }
+    if (!hasDiagonal)
+    {
+      sparseJac->rowVals[nz++] = i;
+    }
+  }
+  sparseJac->colPtrs[N] = nz;
+  sparseJac->nnz = nz;
+}
+
+/**
+ * @brief Set element of sparse Jacobian for KLU.
+ *
+ * @param row       Row of matrix element, unused.
+ * @param column    Column of matrix element, unused.
+ * @param nth       Sparsity pattern lead index.
+ * @param value     Value to set in position (i,j).
+ * @param Jac       Pointer to CVODE_SPARSE_JAC.
+ * @param nRows     Number of rows of Jacobian matrix, unused.
+ */
+static void setJacElementCvodeSparse(int row, int column, int nth, double value, void *Jac, int nRows)
+{
+  CVODE_SPARSE_JAC *sparseJac = (CVODE_SPARSE_JAC *)Jac;
+  UNUSED(row);     /* Disables compiler warning */
+  UNUSED(column);
+  UNUSED(nRows);
+
+  sparseJac->values[sparseJac->nzPos[nth]] = value;
+}
+
+/**
+ * @brief Calculates sparse Jacobian matrix numerical with coloring
+ *
+ * Difference quotients are computed for all columns of one color at once,
+ * with the increment of CVODE's internal difference quotient Jacobian.
+ *
+ * @param currentTime   Current time.
+ * @param y             Current state vector, will be perturbed and restored.
+ * @param fy            Current value of f(t,y).
+ * @param fnew          Work vector for perturbed f(t,y).
+ * @param cvodeData     CVODE solver data struct.
+ * @return int          Return 0 on success.
+ */
+static int jacColoredNumericalSparse(double currentTime, N_Vector y, N_Vector fy, N_Vector fnew, CVODE_SOLVER *cvodeData)
+{
+  DATA *data = cvodeData->simData->data;
+  SPARSE_PATTERN *sparsePattern = data->simulationInfo->analyticJacobians[data->callback->INDEX_JAC_A].sparsePattern;
+  double *states = N_VGetArrayPointer(y);
+  double *f = N_VGetArrayPointer(fy);
+  double *fPerturbed = N_VGetArrayPointer(fnew);
+  double *errwgt = N_VGetArrayPointer(cvodeData->errwgt);
+  double *ysave = cvodeData->ysave;
+  double *delta_hh = cvodeData->delta_hh;
+  double srur = sqrt(DBL_EPSILON);
+  double currentStep, fnorm, minInc;
+  long int i, ii, nth;
+  int retVal = 0;
+
+  infoStreamPrint(LOG_SOLVER_V, 1, "### eval jacColoredNumericalSparse ###");
+
+  CVodeGetCurrentStep(cvodeData->cvode_mem, &currentStep);
+  CVodeGetErrWeights(cvodeData->cvode_mem, cvodeData->errwgt);
+  fnorm = N_VWrmsNorm(fy, cvodeData->errwgt);
+  minInc = (fnorm != 0.0) ? (1000.0 * fabs(currentStep) * DBL_EPSILON * cvodeData->N * fnorm) : 1.0;
+
+  setContext(data, currentTime, CONTEXT_JACOBIAN);
+
+  for (i = 0; i < sparsePattern->maxColors && retVal == 0; i++)
+  {
+    for (ii = 0; ii < cvodeData->N; ii++)
+    {
+      if (sparsePattern->colorCols[ii] - 1 == i)
+      {
+        ysave[ii] = states[ii];
+        delta_hh[ii] = fmax(srur * fabs(states[ii]), minInc / errwgt[ii]);
+        states[ii] += delta_hh[ii];
+        delta_hh[ii] = 1. / (states[ii] - ysave[ii]);
+      }
+    }
+
+    retVal = cvodeRightHandSideODEFunction(currentTime, y, fnew, cvodeData);
+    increaseJacContext(data);
+
+    for (ii = 0; ii < cvodeData->N; ii++)
+    {
+      if (sparsePattern->colorCols[ii] - 1 == i)
+      {
+        for (nth = sparsePattern->leadindex[ii]; nth < sparsePattern->leadindex[ii + 1]; nth++)
+        {
+          setJacElementCvodeSparse(sparsePattern->index[nth], ii, nth, (fPerturbed[sparsePattern->index[nth]] - f[sparsePattern->index[nth]]) * delta_hh[ii], &cvodeData->sparseJac, cvodeData->N);
+        }
+        states[ii] = ysave[ii];
+      }
+    }
+  }
+
+  /* Restore states of current point */
+  if (states != data->localData[0]->realVars)
+  {
+    memcpy(data->localData[0]->realVars, states, cvodeData->N * sizeof(double));
+  }
+
+  unsetContext(data);
+  messageClose(LOG_SOLVER_V);
+
+  return retVal;
+}
+
+/**
+ * @brief Calculates sparse Jacobian matrix symbolically with coloring
+ *
+ * @param currentTime   Current time.
+ * @param y             Current state vector.
+ * @param tmp           Work vector, gets f(t,y).
+ * @param cvodeData     CVODE solver data struct.
+ * @return int          Return 0 on success.
+ */
+static int jacColoredSymbolicalSparse(double currentTime, N_Vector y, N_Vector tmp, CVODE_SOLVER *cvodeData)
+{
+  DATA *data = cvodeData->simData->data;
+  threadData_t *threadData = cvodeData->simData->threadData;
+  ANALYTIC_JACOBIAN *jac = &(data->simulationInfo->analyticJacobians[data->callback->INDEX_JAC_A]);
+  int retVal;
+
+#ifdef USE_PARJAC
+  ANALYTIC_JACOBIAN *t_jac = cvodeData->jacColumns;
+#else
+  ANALYTIC_JACOBIAN *t_jac = jac;
+#endif
+
+  /* Evaluate the system at (t,y), the Jacobian uses its variables */
+  retVal = cvodeRightHandSideODEFunction(currentTime, y, tmp, cvodeData);
+  if (retVal != 0)
+  {
+    return retVal;
+  }
+
+  setContext(data, currentTime, CONTEXT_SYM_JACOBIAN);
+
+  /* Evaluate constant equations if available */
+  if (jac->constantEqns != NULL)
+  {
+    jac->constantEqns(data, threadData, jac, NULL);
+  }
+
+  genericColoredSymbolicJacobianEvaluation(jac->sizeRows, jac->sizeCols, jac->sparsePattern, &cvodeData->sparseJac, t_jac,
+                                           data, threadData, &setJacElementCvodeSparse);
+
+  unsetContext(data);
+
+  return 0;
+}
+
+/**
+ * @brief Wrapper function to call sparse Jacobian
+ *
+ * Evaluates J = df/dy for the KLU linear solver. The structure of Jac is
+ * the sparsity pattern of Jacobian A plus the diagonal.
+ *
+ * @param t           Independent variable (time).
+ * @param y           Dependent variable vector.
+ * @param fy          Current value of f(t,y).
+ * @param Jac         Output Jacobian.
+ * @param user_data   User supplied data.
+ * @param tmp1        Pointer to allocated memory to be used as temp storage or work space.
+ * @param tmp2        "
+ * @param tmp3        "
+ * @return int        Returns 0 on success, positive value for recoverable error, negative value for error.
+ */
+static int callSparseJacobian(double t, N_Vector y, N_Vector fy,
+                              SUNMatrix Jac, void *user_data,
+                              N_Vector tmp1, N_Vector tmp2, N_Vector tmp3)
+{
+  /* Variables */
+  CVODE_SOLVER *cvodeData;
+  threadData_t *threadData;
+  int retVal = -1;
+
+  /* Access userData */
+  cvodeData = (CVODE_SOLVER *)user_data;
+  threadData = cvodeData->simData->threadData;
+
+  /* profiling */
+  if (measure_time_flag)
+    rt_accumulate(SIM_TIMER_SOLVER);
+  rt_tick(SIM_TIMER_JACOBIAN);
+
+  /* Reset Jacobian matrix, structure is constant */
+  memcpy(SM_INDEXPTRS_S(Jac), cvodeData->sparseJac.colPtrs, (cvodeData->N + 1) * sizeof(sunindextype));
+  memcpy(SM_INDEXVALS_S(Jac), cvodeData->sparseJac.rowVals, cvodeData->sparseJac.nnz * sizeof(sunindextype));
+  memset(SM_DATA_S(Jac), 0, cvodeData->sparseJac.nnz * sizeof(double));
+  cvodeData->sparseJac.values = SM_DATA_S(Jac);
+
+  if (cvodeData->config.jacobianMethod == COLOREDNUMJAC)
+  {
+    retVal = jacColoredNumericalSparse(t, y, fy, tmp1, cvodeData);
+  }
+  else if (cvodeData->config.jacobianMethod == COLOREDSYMJAC)
+  {
+    retVal = jacColoredSymbolicalSparse(t, y, tmp1, cvodeData);
+  }
+  else
+  {
+    throwStreamPrint(threadData, "##CVODE## Something went wrong while obtain jacobian matrix!");
+  }
+
+  /* debug */
+  if (ACTIVE_STREAM(LOG_JAC))
+  {
+    infoStreamPrint(LOG_JAC, 0, "##CVODE## Sparse Matrix A.");
+    SUNSparseMatrix_Print(Jac, stdout);
+  }
+
+  /* profiling */
+  rt_accumulate(SIM_TIMER_JACOBIAN);
+  if (measure_time_flag)
+    rt_tick(SIM_TIMER_SOLVER);
+
+  return retVal;
+}
+#endif /* #ifndef OMC_FMI_RUNTIME */
+
 /**
  * @brief Root function for CVODE
  *
@@ -446,13 +729,58 @@ void cvodeGetConfig(CVODE_CONFIG *config, threadData_t *threadData, booleantype
   config->internalSteps = FALSE;    // TODO: Setting not used yet
   infoStreamPrint(LOG_SOLVER, 0, "CVODE use equidistant time grid %s", config->internalSteps ? "NO" : "YES");
 
+  /* Set linear solver method */
+  config->linearSolverMethod = CVODE_LS_UNKNOWN;
+  if (omc_flag[FLAG_CVODE_LS])
+  {
+    for (i = 1; i < CVODE_LS_MAX; i++)
+    {
+      if (!strcmp((const char *)omc_flagValue[FLAG_CVODE_LS], CVODE_LS_METHOD[i]))
+      {
+        config->linearSolverMethod = (enum CVODE_LS)i;
+        break;
+      }
+    }
+    if (config->linearSolverMethod == CVODE_LS_UNKNOWN)
+    {
+      if (ACTIVE_WARNING_STREAM(LOG_SOLVER))
+      {
+        warningStreamPrint(LOG_SOLVER, 1, "unrecognized cvode linear solver method %s, current options are:", (const char *)omc_flagValue[FLAG_CVODE_LS]);
+        for (i = 1; i < CVODE_LS_MAX; ++i)
+        {
+          warningStreamPrint(LOG_SOLVER, 0, "%-15s [%s]", CVODE_LS_METHOD[i], CVODE_LS_METHOD_DESC[i]);
+        }
+        messageClose(LOG_SOLVER);
+      }
+      throwStreamPrint(threadData, "unrecognized cvode linear solver method %s", (const char *)omc_flagValue[FLAG_CVODE_LS]);
+    }
+  }
+  else
+  {
+    config->linearSolverMethod = CVODE_LS_DENSE;
+  }
+#ifdef OMC_FMI_RUNTIME
+  if (config->linearSolverMethod == CVODE_LS_KLU)
+  {
+    warningStreamPrint(LOG_SOLVER, 0, "Linear solver KLU for CVODE not available in FMU, using dense linear solver.");
+    config->linearSolverMethod = CVODE_LS_DENSE;
+  }
+#endif
+
   /* Set jacobian method */
-  if (omc_flag[FLAG_JACOBIAN])
+  if (config->linearSolverMethod == CVODE_LS_KLU)
   {
-    warningStreamPrint(LOG_SOLVER, 0, "Ignoring user supplied flag \"%s\", using internal dense Jacobian of CVODE.", omc_flagValue[FLAG_JACOBIAN]);
+    /* Chosen in cvode_solver_initial when the sparsity pattern is known */
+    config->jacobianMethod = JAC_UNKNOWN;
+  }
+  else
+  {
+    if (omc_flag[FLAG_JACOBIAN])
+    {
+      warningStreamPrint(LOG_SOLVER, 0, "Ignoring user supplied flag \"%s\", using internal dense Jacobian of CVODE.", omc_flagValue[FLAG_JACOBIAN]);
+    }
+    config->jacobianMethod = INTERNALNUMJAC;
   }
-  config->jacobianMethod = INTERNALNUMJAC;
-  //config->jacobianMethod = COLOREDNUMJAC; // Not implemented yet!
 
   /* Minimum absolute step size */
   config->minStepSize = 1e-12; /* TODO: This should be depending on the system? Bigger for 32 bit? */
@@ -583,34 +911,71 @@ int cvode_solver_initial(DATA *data, threadData_t *threadData, SOLVER_INFO *solv
   flag = CVodeSetErrHandlerFn(cvodeData->cvode_mem, cvodeErrorHandlerFunction, cvodeData);
   checkReturnFlag_SUNDIALS(flag, SUNDIALS_CV_FLAG, "CVodeSetErrHandlerFn");
 
-  /* Set linear solver useb by CVODE */
+  /* Initialize Jacobian A, sparsity pattern and coloring are needed by KLU */
+  jacobian = &(data->simulationInfo->analyticJacobians[data->callback->INDEX_JAC_A]);
+  data->callback->initialAnalyticJacobianA(data, threadData, jacobian);
+#ifndef OMC_FMI_RUNTIME
+  if (cvodeData->config.linearSolverMethod == CVODE_LS_KLU)
+  {
+    if (jacobian->availability == JACOBIAN_NOT_AVAILABLE || jacobian->sparsePattern == NULL)
+    {
+      warningStreamPrint(LOG_STDOUT, 0, "##CVODE## No sparsity pattern of the Jacobian available, using dense linear solver.");
+      cvodeData->config.linearSolverMethod = CVODE_LS_DENSE;
+      cvodeData->config.jacobianMethod = INTERNALNUMJAC;
+    }
+    else
+    {
+      infoStreamPrint(LOG_SIMULATION, 1, "Initialized Jacobian:");
+      infoStreamPrint(LOG_SIMULATION, 0, "columns: %d rows: %d", jacobian->sizeCols, jacobian->sizeRows);
+      infoStreamPrint(LOG_SIMULATION, 0, "NNZ:  %d colors: %d", jacobian->sparsePattern->numberOfNonZeros, jacobian->sparsePattern->maxColors);
+      messageClose(LOG_SIMULATION);
+
+      cvodeData->config.jacobianMethod = setJacobianMethod(threadData, jacobian->availability, omc_flag[FLAG_JACOBIAN] ? omc_flagValue[FLAG_JACOBIAN] : NULL);
+      if (cvodeData->config.jacobianMethod == SYMJAC)
+      {
+        warningStreamPrint(LOG_STDOUT, 0, "Symbolic Jacobians without coloring are currently not supported by CVODE with KLU."
+                                          " Colored symbolical Jacobian will be used.");
+        cvodeData->config.jacobianMethod = COLOREDSYMJAC;
+      }
+      else if (cvodeData->config.jacobianMethod == NUMJAC || cvodeData->config.jacobianMethod == INTERNALNUMJAC)
+      {
+        warningStreamPrint(LOG_STDOUT, 0, "Numerical Jacobians without coloring are currently not supported by CVODE with KLU."
+                                          " Colored numerical Jacobian will be used.");
+        cvodeData->config.jacobianMethod = COLOREDNUMJAC;
+      }
+    }
+  }
+#endif
+
+  /* Set linear solver used by CVODE */
   cvodeData->y_linSol = N_VNew_Serial(cvodeData->N);
-  switch (cvodeData->config.jacobianMethod)
+  cvodeData->errwgt = NULL;
+  cvodeData->ysave = NULL;
+  cvodeData->delta_hh = NULL;
+  cvodeData->allocatedParMem = 0; /* FALSE */
+  switch (cvodeData->config.linearSolverMethod)
   {
-  case INTERNALNUMJAC:
-  case COLOREDNUMJAC:
+  case CVODE_LS_DENSE:
     cvodeData->J = SUNDenseMatrix(cvodeData->N, cvodeData->N);
     cvodeData->linSol = SUNLinSol_Dense(cvodeData->y_linSol, cvodeData->J);
     assertStreamPrint(threadData, NULL != cvodeData->linSol, "##CVODE## SUNLinSol_Dense failed.");
     break;
+#ifndef OMC_FMI_RUNTIME
+  case CVODE_LS_KLU:
+    cvodeInitSparseJacobian(&cvodeData->sparseJac, jacobian->sparsePattern, cvodeData->N);
+    cvodeData->J = SUNSparseMatrix(cvodeData->N, cvodeData->N, cvodeData->sparseJac.nnz, CSC_MAT);
+    cvodeData->linSol = SUNLinSol_KLU(cvodeData->y_linSol, cvodeData->J);
+    assertStreamPrint(threadData, NULL != cvodeData->linSol, "##CVODE## SUNLinSol_KLU failed.");
+    break;
+#endif
   default:
-    throwStreamPrint(threadData, "##CVODE## Unknown linear solver method %s for CVODE.", JACOBIAN_METHOD[cvodeData->config.jacobianMethod]);
+    throwStreamPrint(threadData, "##CVODE## Unknown linear solver method %s for CVODE.", CVODE_LS_METHOD[cvodeData->config.linearSolverMethod]);
   }
   flag = CVodeSetLinearSolver(cvodeData->cvode_mem, cvodeData->linSol, cvodeData->J);
   checkReturnFlag_SUNDIALS(flag, SUNDIALS_CVLS_FLAG, "CVodeSetLinearSolver");
-  infoStreamPrint(LOG_SOLVER, 0, "CVODE Using dense internal linear solver SUNLinSol_Dense.");
+  infoStreamPrint(LOG_SOLVER, 0, "CVODE linear solver method selected %s", CVODE_LS_METHOD_DESC[cvodeData->config.linearSolverMethod]);
 
   /* Set Jacobian function */
-  jacobian = &(data->simulationInfo->analyticJacobians[data->callback->INDEX_JAC_A]);
-  if (data->callback->initialAnalyticJacobianA(data, threadData, jacobian) == 0 /* Jac present */)
-  {
-    // TODO: Implement Jacobian evaluation with analytic Jacobian
-  }
-  else
-  {
-    // Do Nothing
-  }
-
   switch (cvodeData->config.jacobianMethod)
   {
   case INTERNALNUMJAC:
@@ -618,12 +983,27 @@ int cvode_solver_initial(DATA *data, threadData_t *threadData, SOLVER_INFO *solv
     checkReturnFlag_SUNDIALS(flag, SUNDIALS_CVLS_FLAG, "CVodeSetJacFn");
     infoStreamPrint(LOG_SOLVER, 0, "CVODE Use internal dense numeric jacobian method.");
     break;
+#ifndef OMC_FMI_RUNTIME
   case COLOREDNUMJAC:
-    throwStreamPrint(threadData, "##CVODE## LJacobian method %s not yet implemented.", JACOBIAN_METHOD[cvodeData->config.jacobianMethod]);
-    //flag = CVodeSetJacFn(cvodeData->cvode_mem, callDenseJacobian);
-    //checkReturnFlag_SUNDIALS(flag, SUNDIALS_CVLS_FLAG, "CVodeSetJacFn");
-    //infoStreamPrint(LOG_SOLVER, 0, "CVODE Use colored dense numeric jacobian method.");
+  case COLOREDSYMJAC:
+    flag = CVodeSetJacFn(cvodeData->cvode_mem, callSparseJacobian);
+    checkReturnFlag_SUNDIALS(flag, SUNDIALS_CVLS_FLAG, "CVodeSetJacFn");
+    if (cvodeData->config.jacobianMethod == COLOREDNUMJAC)
+    {
+      cvodeData->errwgt = N_VNew_Serial(cvodeData->N);
+      cvodeData->ysave = (double *)malloc(cvodeData->N * sizeof(double));
+      cvodeData->delta_hh = (double *)malloc(cvodeData->N * sizeof(double));
+    }
+#ifdef USE_PARJAC
+    else
+    {
+      allocateThreadLocalJacobians(data, &(cvodeData->jacColumns));
+      cvodeData->allocatedParMem = 1; /* TRUE */
+    }
+#endif
+    infoStreamPrint(LOG_SOLVER, 0, "CVODE Use sparse jacobian method %s.", JACOBIAN_METHOD[cvodeData->config.jacobianMethod]);
     break;
+#endif
   default:
     throwStreamPrint(threadData, "##CVODE## Jacobian method %s not yet implemented.", JACOBIAN_METHOD[cvodeData->config.jacobianMethod]);
   }
@@ -762,6 +1142,27 @@ int cvode_solver_deinitial(CVODE_SOLVER *cvodeData)
   N_VDestroy_Serial(cvodeData->y_linSol);
   SUNMatDestroy(cvodeData->J);
   SUNLinSolFree(cvodeData->linSol);
+#ifndef OMC_FMI_RUNTIME
+  if (cvodeData->config.linearSolverMethod == CVODE_LS_KLU)
+  {
+    free(cvodeData->sparseJac.colPtrs);
+    free(cvodeData->sparseJac.rowVals);
+    free(cvodeData->sparseJac.nzPos);
+  }
+#endif
+  if (cvodeData->errwgt != NULL)
+  {
+    N_VDestroy_Serial(cvodeData->errwgt);
+  }
+  free(cvodeData->ysave);
+  free(cvodeData->delta_hh);
+#ifdef USE_PARJAC
+  if (cvodeData->allocatedParMem)
+  {
+    freeAnalyticalJacobian(&(cvodeData->jacColumns));
+    cvodeData->allocatedParMem = 0;
+  }
+#endif
 
   /* Free non-linear solver data */
   N_VDestroy_Serial(cvodeData->y_nonLinSol);
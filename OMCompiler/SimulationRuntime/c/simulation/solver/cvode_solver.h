@@ -45,6 +45,10 @@
 #include <nvector/nvector_serial.h>  /* serial N_Vector types, fcts., macros */
 #include <sunlinsol/sunlinsol_dense.h>              /* Default dense linear solver */
 #include <sunnonlinsol/sunnonlinsol_fixedpoint.h>   /* Default dense linear solver */
+#ifndef OMC_FMI_RUNTIME
+#include <sunlinsol/sunlinsol_klu.h>                /* Sparse linear solver KLU */
+#include <sunmatrix/sunmatrix_sparse.h>             /* Sparse Jacobian matrix */
+#endif
 
 /**
  * @brief Non-linear solver method for internal use of CVODE.
@@ -67,6 +71,21 @@ typedef struct CVODE_USERDATA
   threadData_t *threadData;
 } CVODE_USERDATA;
 
+/**
+ * @brief Sparse structure of the Jacobian used with the KLU linear solver.
+ *
+ * Sparsity pattern of Jacobian A extended by all diagonal elements, so that
+ * CVODE can build I - gamma*J without changing the structure of the matrix.
+ */
+typedef struct CVODE_SPARSE_JAC
+{
+  long int nnz;               /* Number of non-zero elements incl. diagonal */
+  sunindextype *colPtrs;      /* CSC column pointers, length N+1 */
+  sunindextype *rowVals;      /* CSC row indices, length nnz */
+  long int *nzPos;            /* Position of the n-th element of the sparsity pattern in rowVals */
+  double *values;             /* Data of the matrix that is currently evaluated */
+} CVODE_SPARSE_JAC;
+
 typedef struct CVODE_CONFIG
 {
   /* Mandatory configurations */
@@ -79,6 +98,7 @@ typedef struct CVODE_CONFIG
 
   booleantype internalSteps;           /* if TRUE internal step of the integrator are used, default FALSE */
   enum JACOBIAN_METHOD jacobianMethod; /* Method for Jacobian computation */
+  enum CVODE_LS linearSolverMethod;    /* Linear solver method, dense or sparse KLU */
 
   /* Optional configurations */
   double minStepSize;          /* Lower bound on the magnitude of the step size.
@@ -114,6 +134,12 @@ typedef struct CVODE_SOLVER
   N_Vector y_linSol;          /* Template for cloning vectors needed inside linear solver */
   SUNMatrix J;                /* Sparse matrix template for cloning matrices needed within
                                linear solver */
+  CVODE_SPARSE_JAC sparseJac; /* Structure of sparse Jacobian, only used with KLU */
+  N_Vector errwgt;            /* Error weights for colored numerical Jacobian */
+  double *ysave;              /* Work arrays for colored numerical Jacobian */
+  double *delta_hh;
+  ANALYTIC_JACOBIAN* jacColumns;
+  int allocatedParMem;        /* indicated if parallel memory was allocated, 0=false, 1=true*/
 
   /* Non-linear solver data */
   SUNNonlinearSolver nonLinSol; /* Non-linear solver object */
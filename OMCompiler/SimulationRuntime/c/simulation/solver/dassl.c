@@ -69,7 +69,7 @@ extern "C" {
  *  - it's set to 1 if the continuous system is evaluated
  *    when dassl finished a step, otherwise it's 0.
  */
-int RHSFinalFlag;
+OMC_THREAD_LOCAL int RHSFinalFlag;
 
 /* provides a dummy Jacobian to be used with DASSL */
 static int dummy_Jacobian(double *t, double *y, double *yprime,double *deltaD,
@@ -540,7 +540,7 @@ int dassl_step(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInfo)
   unsigned int ui = 0;
   int retVal = 0;
   int saveJumpState;
-  static unsigned int dasslStepsOutputCounter = 1;
+  static OMC_THREAD_LOCAL unsigned int dasslStepsOutputCounter = 1;
 
   DASSL_DATA *dasslData = (DASSL_DATA*) solverInfo->solverData;
 
@@ -0,0 +1,874 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-CurrentYear, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/*! \file ensemble.c
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ensemble.h"
+#include "solver_main.h"
+#include "events.h"
+#include "model_help.h"
+#include "external_input.h"
+#include "linearSystem.h"
+#include "nonlinearSystem.h"
+#include "mixedSystem.h"
+#include "gbode_conf.h"
+#include "gbode_tableau.h"
+#include "../options.h"
+#include "../simulation_runtime.h"
+#include "../results/simulation_result.h"
+#include "../../meta/meta_modelica.h"
+#include "../../util/omc_error.h"
+#include "../../util/omc_init.h"
+
+#if !defined(OMC_MINIMAL_RUNTIME)
+
+/* What a lane does in the current round of the ensemble */
+enum ENSEMBLE_LANE_STATE
+{
+  LANE_DONE = 0,              /* reached the stop time, terminated or failed */
+  LANE_SKIP,                  /* no step in this round, see performSimulation */
+  LANE_STEP,                  /* steps alone with its solver */
+  LANE_LOCKSTEP               /* steps together with the ensemble */
+};
+
+typedef struct ENSEMBLE_LANE
+{
+  SIM_INSTANCE *instance;
+  SOLVER_INFO solverInfo;
+  enum ENSEMBLE_LANE_STATE state;
+  unsigned int stepNo;              /* output grid point of the current step */
+  int retry;                        /* the last step failed, the next one uses half the step size */
+  int retVal;
+  int retValIntegrator;
+  modelica_boolean started;         /* initialized, finishSimulation has to be called */
+  modelica_boolean initSolverInfo;
+  modelica_boolean stepFailed;      /* an assert was thrown during the step */
+  modelica_boolean restartSolver;   /* the solver data is behind the last lockstep step */
+  modelica_boolean terminate;       /* terminate() was called by this lane */
+} ENSEMBLE_LANE;
+
+typedef struct ENSEMBLE
+{
+  int nLanes;
+  int nStates;
+  int solverID;
+  ENSEMBLE_LANE *lanes;
+
+  /* explicit Runge-Kutta method, A is row major and strictly lower triangular */
+  int nStages;
+  double *A;
+  double *b;
+  double *bt;                       /* weights of the embedded method, NULL without error control */
+  double *c;
+  double fac;
+
+  /* structure of arrays, the value of state i in lane l is at [i*nLanes + l] */
+  double *xOld;
+  double *x;
+  double *xt;
+  double *k;                        /* derivatives of stage s at k + s*nStates*nLanes */
+  double *sum;
+
+  /* current lockstep step */
+  int stage;
+  double stepSize;
+
+  const char *init_initMethod;
+  const char *init_file;
+  double init_time;
+  const char *outputVariablesAtEnd;
+} ENSEMBLE;
+
+typedef void (*ENSEMBLE_LANE_FUNC)(ENSEMBLE *ens, ENSEMBLE_LANE *lane);
+
+static int ensembleSolverID(DATA *data)
+{
+  int i;
+  for (i = 1; i < S_MAX; i++) {
+    if (0 == strcmp(SOLVER_METHOD_NAME[i], data->simulationInfo->solverMethod)) {
+      return i;
+    }
+  }
+  return S_UNKNOWN;
+}
+
+static void ensembleAllocTableau(ENSEMBLE *ens, int nStages)
+{
+  ens->nStages = nStages;
+  ens->A = (double*) calloc(nStages*nStages, sizeof(double));
+  ens->b = (double*) calloc(nStages, sizeof(double));
+  ens->c = (double*) calloc(nStages, sizeof(double));
+  ens->bt = NULL;
+  ens->fac = 1.0;
+}
+
+/**
+ * @brief Butcher tableau of the solver of the sweep.
+ *
+ * euler, heun and rungekutta use the coefficients of solver_main.c, gbode
+ * the single-rate method given by -gbm if it is explicit. The embedded
+ * weights of gbode are used for the error estimate unless the step size is
+ * constant or Richardson extrapolation is used.
+ *
+ * @param ens       Ensemble, solverID and nStates are set.
+ * @return int      0 on success, -1 if the solver has no explicit tableau.
+ */
+static int ensembleInitTableau(ENSEMBLE *ens)
+{
+  BUTCHER_TABLEAU *tableau;
+  unsigned int nlSystemSize;
+  enum GM_TYPE type;
+  int s;
+
+  switch (ens->solverID)
+  {
+  case S_EULER:
+    ensembleAllocTableau(ens, 1);
+    ens->b[0] = 1.0;
+    return 0;
+  case S_HEUN:
+    ensembleAllocTableau(ens, 2);
+    ens->c[1] = 1.0;
+    ens->b[0] = ens->b[1] = 1.0 / 2.0;
+    break;
+  case S_RUNGEKUTTA:
+    ensembleAllocTableau(ens, 4);
+    ens->c[1] = ens->c[2] = 0.5;
+    ens->c[3] = 1.0;
+    ens->b[0] = ens->b[3] = 1.0 / 6.0;
+    ens->b[1] = ens->b[2] = 1.0 / 3.0;
+    break;
+  case S_GBODE:
+    if (getGBRatio() > 0 && getGBRatio() < 1) {
+      return -1;
+    }
+    tableau = initButcherTableau(getGB_method(FLAG_SR), FLAG_SR_ERR);
+    if (NULL == tableau) {
+      return -1;
+    }
+    analyseButcherTableau(tableau, ens->nStates, &nlSystemSize, &type);
+    if (GM_TYPE_EXPLICIT != type) {
+      freeButcherTableau(tableau);
+      return -1;
+    }
+    ensembleAllocTableau(ens, tableau->nStages);
+    memcpy(ens->A, tableau->A, ens->nStages*ens->nStages*sizeof(double));
+    memcpy(ens->b, tableau->b, ens->nStages*sizeof(double));
+    memcpy(ens->c, tableau->c, ens->nStages*sizeof(double));
+    if (!tableau->richardson && tableau->bt && GB_CTRL_CNST != getControllerMethod(FLAG_SR_CTRL)) {
+      ens->bt = (double*) malloc(ens->nStages*sizeof(double));
+      memcpy(ens->bt, tableau->bt, ens->nStages*sizeof(double));
+      ens->fac = tableau->fac;
+    }
+    freeButcherTableau(tableau);
+    return 0;
+  default:
+    return -1;
+  }
+
+  /* the classical methods of solver_main.c use c[s]*k[s-1] for stage s */
+  for (s = 1; s < ens->nStages; s++) {
+    ens->A[s*ens->nStages + s-1] = ens->c[s];
+  }
+  return 0;
+}
+
+static void ensembleFreeTableau(ENSEMBLE *ens)
+{
+  free(ens->A);
+  free(ens->b);
+  free(ens->bt);
+  free(ens->c);
+}
+
+/**
+ * @brief Checks if the runs of a sweep of this model can be integrated as an ensemble.
+ *
+ * @param data          Runtime data struct.
+ * @param printReason   Print a warning why not.
+ * @return int          1 if supported.
+ */
+int ensemble_supported(DATA *data, int printReason)
+{
+  const char *reason = NULL;
+  ENSEMBLE ens;
+
+  memset(&ens, 0, sizeof(ENSEMBLE));
+  ens.solverID = ensembleSolverID(data);
+  ens.nStates = data->modelData->nStates;
+
+  if (S_EULER != ens.solverID && S_HEUN != ens.solverID && S_RUNGEKUTTA != ens.solverID && S_GBODE != ens.solverID) {
+    reason = "the solver is not euler, heun, rungekutta or gbode";
+  } else if (compiledInDAEMode) {
+    reason = "the model is compiled in DAE mode";
+  } else if (data->modelData->nStates < 1) {
+    reason = "the model has no states";
+  } else if (data->modelData->nBaseClocks > 0) {
+    reason = "the model has clocked partitions";
+  } else if (data->modelData->create_linearmodel) {
+    reason = "-l linearizes the model after the last run";
+  } else if (measure_time_flag) {
+    reason = "the profiling timers are not kept per run";
+  } else if (omc_flag[FLAG_NOEQUIDISTANT_GRID] || omc_flag[FLAG_STEADY_STATE]) {
+    reason = "the runs do not step on the same time grid";
+  } else if (S_GBODE == ens.solverID && omc_flag[FLAG_NO_RESTART]) {
+    reason = "gbode does not restart after the lockstep steps with -noRestart";
+  } else if (omc_flag[FLAG_EMBEDDED_SERVER] || omc_flag[FLAG_RT]) {
+    reason = "real-time synchronization and the embedded server need a single run";
+  } else if (ensembleInitTableau(&ens)) {
+    reason = "gbode uses an implicit or a multi-rate method";
+  } else {
+    ensembleFreeTableau(&ens);
+  }
+
+  if (reason && printReason) {
+    warningStreamPrint(LOG_STDOUT, 0, "Parameter sweep: no ensemble integration, %s.", reason);
+  }
+  return NULL == reason;
+}
+
+/**
+ * @brief Makes the lane the one the runtime works on.
+ *
+ * All lanes share the thread of the ensemble and with it the thread local
+ * state, e.g. the zero-crossing tolerance.
+ */
+static void ensembleSelectLane(ENSEMBLE_LANE *lane)
+{
+  DATA *data = &lane->instance->data;
+
+#if !defined(OMC_NO_THREADS)
+  pthread_setspecific(mmc_thread_data_key, lane->instance->threadData);
+#endif
+  setZCtol(fmin(data->simulationInfo->stepSize, data->simulationInfo->tolerance));
+}
+
+/* terminate() sets a flag of the thread, which the lanes share */
+static void ensembleTakeTerminate(ENSEMBLE_LANE *lane)
+{
+  if (terminationTerminate) {
+    lane->terminate = 1;
+    terminationTerminate = 0;
+  }
+}
+
+/**
+ * @brief Calls func for one lane.
+ *
+ * Errors outside of the simulation stage end the run of the lane, like
+ * callSolver does for a single run.
+ */
+static void ensembleLaneCall(ENSEMBLE *ens, ENSEMBLE_LANE *lane, ENSEMBLE_LANE_FUNC func)
+{
+  threadData_t *threadData = lane->instance->threadData;
+  int success = 0;
+
+  ensembleSelectLane(lane);
+  MMC_TRY_INTERNAL(mmc_jumper)
+  MMC_TRY_INTERNAL(globalJumpBuffer)
+  func(ens, lane);
+  success = 1;
+  MMC_CATCH_INTERNAL(globalJumpBuffer)
+  MMC_CATCH_INTERNAL(mmc_jumper)
+  ensembleTakeTerminate(lane);
+
+  if (!success) {
+    lane->retVal = -1;
+    lane->state = LANE_DONE;
+  }
+}
+
+/**
+ * @brief Initializes the solver and the model of a lane, see solver_main.
+ */
+static void ensembleStartLane(ENSEMBLE *ens, ENSEMBLE_LANE *lane)
+{
+  DATA *data = &lane->instance->data;
+  threadData_t *threadData = lane->instance->threadData;
+  SIMULATION_INFO *simInfo = data->simulationInfo;
+  SOLVER_INFO *solverInfo = &lane->solverInfo;
+
+  lane->solverInfo.solverMethod = ens->solverID;
+  simInfo->useStopTime = 1;
+  if ((simInfo->stepSize < simInfo->minStepSize) && (simInfo->stopTime > simInfo->startTime)) {
+    warningStreamPrint(LOG_STDOUT, 0, "The step-size %g is too small. Adjust the step-size to %g.", simInfo->stepSize, simInfo->minStepSize);
+    simInfo->stepSize = simInfo->minStepSize;
+    simInfo->numSteps = round((simInfo->stopTime - simInfo->startTime)/simInfo->stepSize);
+    ensembleSelectLane(lane);
+  }
+
+  externalInputallocate(data);
+  lane->retVal = initializeSolverData(data, threadData, solverInfo);
+  lane->initSolverInfo = 1;
+  if (0 != lane->retVal) {
+    return;
+  }
+  lane->retVal = -1;
+  lane->started = 1;
+  if (initializeModel(data, threadData, ens->init_initMethod, ens->init_file, ens->init_time)) {
+    return;
+  }
+
+  if (omc_flag[FLAG_SOLVER_STEPS]) {
+    data->simulationInfo->solverSteps = 0;
+  }
+  data->simResult->emit(data->simResult, data, threadData);
+  overwriteOldSimulationData(data);
+  storeOldValues(data);
+  solverInfo->currentTime = simInfo->startTime;
+
+  ensembleTakeTerminate(lane);
+  if (lane->terminate) {
+    printInfo(stdout, TermInfo);
+    fputc('\n', stdout);
+    infoStreamPrint(LOG_STDOUT, 0, "Simulation call terminate() at initialization (time %f)\nMessage : %s", data->localData[0]->timeValue, TermMsg);
+    simInfo->stopTime = solverInfo->currentTime;
+    lane->terminate = 0;
+  }
+
+  lane->retVal = 0;
+  lane->state = LANE_SKIP;
+}
+
+/**
+ * @brief Next step of a lane on the output grid, see performSimulation.
+ */
+static void ensemblePrepareStep(ENSEMBLE *ens, ENSEMBLE_LANE *lane)
+{
+  DATA *data = &lane->instance->data;
+  threadData_t *threadData = lane->instance->threadData;
+  SIMULATION_INFO *simInfo = data->simulationInfo;
+  SOLVER_INFO *solverInfo = &lane->solverInfo;
+  modelica_boolean syncEventStep;
+
+  lane->stepFailed = 0;
+  lane->retValIntegrator = 0;
+  if (!(solverInfo->currentTime < simInfo->stopTime)) {
+    lane->state = LANE_DONE;
+    return;
+  }
+  threadData->currentErrorStage = ERROR_SIMULATION;
+
+  rotateRingBuffer(data->simulationData, 1);
+  lookupRingBuffer(data->simulationData, (void**) data->localData);
+
+  syncEventStep = solverInfo->didEventStep;
+  if (!syncEventStep) {
+    lane->stepNo++;
+  }
+
+  if (simInfo->numSteps == 0) {
+    if (fabs(simInfo->stopTime-simInfo->startTime) < 1e-16) {
+      solverInfo->currentStepSize = 0;
+    } else {
+      errorStreamPrint(LOG_STDOUT, 0, "model terminate | Integrator failed. | Simulation terminated at time %g", solverInfo->currentTime);
+      lane->retVal = -1;
+      lane->state = LANE_DONE;
+      return;
+    }
+  } else {
+    solverInfo->currentStepSize = (double)(lane->stepNo*(simInfo->stopTime-simInfo->startTime))/(simInfo->numSteps) + simInfo->startTime - solverInfo->currentTime;
+  }
+  solverInfo->lastdesiredStep = solverInfo->currentTime + solverInfo->currentStepSize;
+
+  if (0 != lane->retry) {
+    solverInfo->currentStepSize /= 2;
+  }
+
+  checkForSampleEvent(data, solverInfo);
+
+  if (solverInfo->currentStepSize < 1e-15 && syncEventStep) {
+    lane->stepNo++;
+    rotateRingBuffer(data->simulationData, 1);
+    lookupRingBuffer(data->simulationData, (void**) data->localData);
+    lane->state = LANE_SKIP;
+    return;
+  }
+  lane->state = LANE_STEP;
+}
+
+/**
+ * @brief Evaluates the derivatives of the current stage of a lockstep step for one lane.
+ */
+static void ensembleLaneODE(ENSEMBLE *ens, ENSEMBLE_LANE *lane)
+{
+  DATA *data = &lane->instance->data;
+  threadData_t *threadData = lane->instance->threadData;
+  SIMULATION_DATA *sData = (SIMULATION_DATA*)data->localData[0];
+  SIMULATION_DATA *sDataOld = (SIMULATION_DATA*)data->localData[1];
+  const int nLanes = ens->nLanes, l = lane - ens->lanes;
+  double *k = ens->k + ens->stage*ens->nStates*nLanes;
+  int i, success = 0;
+
+  for (i = 0; i < ens->nStates; i++) {
+    sData->realVars[i] = ens->x[i*nLanes + l];
+  }
+  sData->timeValue = sDataOld->timeValue + ens->c[ens->stage] * ens->stepSize;
+
+#if !defined(OMC_EMCC)
+  MMC_TRY_INTERNAL(simulationJumpBuffer)
+#endif
+  externalInputUpdate(data);
+  data->callback->input_function(data, threadData);
+  data->callback->functionODE(data, threadData);
+  success = 1;
+#if !defined(OMC_EMCC)
+  MMC_CATCH_INTERNAL(simulationJumpBuffer)
+#endif
+
+  if (!success) {
+    lane->stepFailed = 1;
+    return;
+  }
+  for (i = 0; i < ens->nStates; i++) {
+    k[i*nLanes + l] = sData->realVars[ens->nStates + i];
+  }
+}
+
+/**
+ * @brief One step of size h of all lanes in state LANE_LOCKSTEP.
+ *
+ * The stage states and the new states are computed for all lanes at once
+ * in structure-of-arrays form, the derivatives lane by lane. Lanes whose
+ * error estimate is too large step alone afterwards.
+ */
+static void ensembleLockstep(ENSEMBLE *ens, double h)
+{
+  const int nLanes = ens->nLanes, nStates = ens->nStates, n = nLanes*nStates, nStages = ens->nStages;
+  ENSEMBLE_LANE *lane;
+  DATA *data;
+  SIMULATION_DATA *sData, *sDataOld;
+  double *ks, a, err, tol;
+  int l, i, s, m, j;
+
+  /* states and derivatives at the start of the step */
+  for (l = 0; l < nLanes; l++) {
+    lane = ens->lanes + l;
+    if (LANE_LOCKSTEP != lane->state) {
+      continue;
+    }
+    sDataOld = (SIMULATION_DATA*)lane->instance->data.localData[1];
+    for (i = 0; i < nStates; i++) {
+      ens->xOld[i*nLanes + l] = sDataOld->realVars[i];
+      ens->k[i*nLanes + l] = sDataOld->realVars[nStates + i];
+    }
+  }
+
+  ens->stepSize = h;
+  for (s = 1; s < nStages; s++) {
+    memcpy(ens->x, ens->xOld, n*sizeof(double));
+    for (m = 0; m < s; m++) {
+      a = h * ens->A[s*nStages + m];
+      if (0.0 == a) {
+        continue;
+      }
+      ks = ens->k + m*n;
+      for (j = 0; j < n; j++) {
+        ens->x[j] += a * ks[j];
+      }
+    }
+    ens->stage = s;
+    for (l = 0; l < nLanes; l++) {
+      lane = ens->lanes + l;
+      if (LANE_LOCKSTEP == lane->state && !lane->stepFailed) {
+        ensembleLaneCall(ens, lane, ensembleLaneODE);
+      }
+    }
+  }
+
+  memset(ens->sum, 0, n*sizeof(double));
+  for (s = 0; s < nStages; s++) {
+    ks = ens->k + s*n;
+    for (j = 0; j < n; j++) {
+      ens->sum[j] += ens->b[s] * ks[j];
+    }
+  }
+  for (j = 0; j < n; j++) {
+    ens->x[j] = ens->xOld[j] + h * ens->sum[j];
+  }
+
+  if (ens->bt) {
+    memset(ens->sum, 0, n*sizeof(double));
+    for (s = 0; s < nStages; s++) {
+      ks = ens->k + s*n;
+      for (j = 0; j < n; j++) {
+        ens->sum[j] += ens->bt[s] * ks[j];
+      }
+    }
+    for (j = 0; j < n; j++) {
+      ens->xt[j] = ens->xOld[j] + h * ens->sum[j];
+    }
+  }
+
+  for (l = 0; l < nLanes; l++) {
+    lane = ens->lanes + l;
+    if (LANE_LOCKSTEP != lane->state || lane->stepFailed) {
+      continue;
+    }
+    data = &lane->instance->data;
+
+    /* per-lane step acceptance, see gbode_birate */
+    if (ens->bt) {
+      tol = data->simulationInfo->tolerance;
+      err = 0;
+      for (i = 0; i < nStates; i++) {
+        j = i*nLanes + l;
+        err = fmax(err, ens->fac * fabs(ens->x[j] - ens->xt[j]) / (tol * fmax(fabs(ens->x[j]), fabs(ens->xOld[j])) + tol));
+      }
+      if (err > 1) {
+        lane->state = LANE_STEP;
+        lane->restartSolver = 1;
+        continue;
+      }
+    }
+
+    sData = (SIMULATION_DATA*)data->localData[0];
+    sDataOld = (SIMULATION_DATA*)data->localData[1];
+    for (i = 0; i < nStates; i++) {
+      sData->realVars[i] = ens->x[i*nLanes + l];
+    }
+    lane->solverInfo.currentTime = sDataOld->timeValue + h;
+    sData->timeValue = lane->solverInfo.currentTime;
+    lane->solverInfo.solverStatsTmp.nStepsTaken += 1;
+    lane->solverInfo.solverStatsTmp.nCallsODE += (1 == nStages) ? 1 : nStages + 1;
+    if (S_GBODE == ens->solverID) {
+      /* gbode did not see this step, the runtime has to locate the events */
+      lane->restartSolver = 1;
+      lane->solverInfo.solverRootFinding = 0;
+    }
+  }
+}
+
+/**
+ * @brief One step of a lane with its own solver.
+ */
+static void ensembleLaneStep(ENSEMBLE *ens, ENSEMBLE_LANE *lane)
+{
+  DATA *data = &lane->instance->data;
+  threadData_t *threadData = lane->instance->threadData;
+  SOLVER_INFO *solverInfo = &lane->solverInfo;
+  int success = 0;
+
+  if (lane->restartSolver) {
+    /* continue from the states of the last lockstep step */
+    memcpy(data->localData[0]->realVars, data->localData[1]->realVars, data->modelData->nVariablesReal*sizeof(modelica_real));
+    data->localData[0]->timeValue = data->localData[1]->timeValue;
+    solverInfo->didEventStep = 1;
+    lane->restartSolver = 0;
+  }
+
+#if !defined(OMC_EMCC)
+  MMC_TRY_INTERNAL(simulationJumpBuffer)
+#endif
+  infoStreamPrint(LOG_SOLVER, 1, "call solver from %g to %g (stepSize: %.15g)", solverInfo->currentTime, solverInfo->currentTime + solverInfo->currentStepSize, solverInfo->currentStepSize);
+  lane->retValIntegrator = solver_main_step(data, threadData, solverInfo);
+  infoStreamPrint(LOG_SOLVER, 0, "finished solver step %g", solverInfo->currentTime);
+  messageClose(LOG_SOLVER);
+  success = 1;
+#if !defined(OMC_EMCC)
+  MMC_CATCH_INTERNAL(simulationJumpBuffer)
+#endif
+
+  if (!success) {
+    lane->stepFailed = 1;
+  }
+}
+
+/**
+ * @brief Event handling, output and checks after the step of a lane, see performSimulation.
+ */
+static void ensembleLaneUpdate(ENSEMBLE *ens, ENSEMBLE_LANE *lane)
+{
+  DATA *data = &lane->instance->data;
+  threadData_t *threadData = lane->instance->threadData;
+  SOLVER_INFO *solverInfo = &lane->solverInfo;
+  int success = 0;
+
+  if (!lane->stepFailed) {
+#if !defined(OMC_EMCC)
+    MMC_TRY_INTERNAL(simulationJumpBuffer)
+#endif
+    /* models with clocked partitions are not integrated as an ensemble, no timers fire */
+    data->callback->simulationUpdate(data, threadData, solverInfo);
+    lane->retry = 0;
+
+    if (!omc_flag[FLAG_NOEVENTEMIT] || !solverInfo->didEventStep) {
+      data->simResult->emit(data->simResult, data, threadData);
+    }
+    if (!(omc_flag[FLAG_NO_RESTART] && solverInfo->solverMethod == S_GBODE) && solverInfo->didEventStep) {
+      addSolverStats(&(solverInfo->solverStats), &(solverInfo->solverStatsTmp));
+    }
+
+    ensembleTakeTerminate(lane);
+    if (lane->terminate) {
+      if (TermInfo.filename != NULL && TermInfo.filename[0] != '\0') {
+        printInfo(stdout, TermInfo);
+        fputc('\n', stdout);
+      }
+      infoStreamPrint(LOG_STDOUT, 0, "Simulation call terminate() at time %f\nMessage : %s", data->localData[0]->timeValue, TermMsg);
+      data->simulationInfo->stopTime = solverInfo->currentTime;
+      lane->terminate = 0;
+    }
+
+    if (lane->retValIntegrator) {
+      lane->retVal = -1 + lane->retValIntegrator;
+      infoStreamPrint(LOG_STDOUT, 0, "model terminate | Integrator failed. | Simulation terminated at time %g", solverInfo->currentTime);
+      lane->state = LANE_DONE;
+    } else if (check_nonlinear_solutions(data, 0)) {
+      lane->retVal = -2;
+      infoStreamPrint(LOG_STDOUT, 0, "model terminate | non-linear system solver failed. | Simulation terminated at time %g", solverInfo->currentTime);
+      lane->state = LANE_DONE;
+    } else if (check_linear_solutions(data, 0)) {
+      lane->retVal = -3;
+      infoStreamPrint(LOG_STDOUT, 0, "model terminate | linear system solver failed. | Simulation terminated at time %g", solverInfo->currentTime);
+      lane->state = LANE_DONE;
+    } else if (check_mixed_solutions(data, 0)) {
+      lane->retVal = -4;
+      infoStreamPrint(LOG_STDOUT, 0, "model terminate | mixed system solver failed. | Simulation terminated at time %g", solverInfo->currentTime);
+      lane->state = LANE_DONE;
+    }
+    success = 1;
+#if !defined(OMC_EMCC)
+    MMC_CATCH_INTERNAL(simulationJumpBuffer)
+#endif
+  }
+
+  if (!success) {
+    if (0 == lane->retry) {
+      /* reduce step size by a half and try again */
+      solverInfo->laststep = solverInfo->currentTime - solverInfo->laststep;
+      restoreOldValues(data);
+      solverInfo->currentTime = data->localData[0]->timeValue;
+      overwriteOldSimulationData(data);
+      updateDiscreteSystem(data, threadData);
+      warningStreamPrint(LOG_STDOUT, 0, "Integrator attempt to handle a problem with a called assert.");
+      solverInfo->didEventStep = 1;
+      lane->restartSolver = 0;
+      lane->retry = 1;
+    } else {
+      lane->retVal = -1;
+      infoStreamPrint(LOG_STDOUT, 0, "model terminate | Simulation terminated by an assert at time: %g", data->localData[0]->timeValue);
+      lane->state = LANE_DONE;
+    }
+  }
+}
+
+/**
+ * @brief Last step with terminal()=true and clean up of a lane, see solver_main.
+ */
+static void ensembleFinishLane(ENSEMBLE *ens, ENSEMBLE_LANE *lane)
+{
+  DATA *data = &lane->instance->data;
+  threadData_t *threadData = lane->instance->threadData;
+
+  if (lane->started) {
+    lane->started = 0;
+#if !defined(OMC_EMCC)
+    MMC_TRY_INTERNAL(simulationJumpBuffer)
+#endif
+    finishSimulation(data, threadData, &lane->solverInfo, ens->outputVariablesAtEnd);
+#if !defined(OMC_EMCC)
+    MMC_CATCH_INTERNAL(simulationJumpBuffer)
+#endif
+  }
+}
+
+/**
+ * @brief Index of a lane stepping to the most common time and step size.
+ *
+ * @return int      Number of lanes sharing it.
+ */
+static int ensembleCommonStep(ENSEMBLE *ens, int *leader)
+{
+  int l, m, n, best = 0;
+  SOLVER_INFO *si, *sj;
+
+  for (l = 0; l < ens->nLanes - best; l++) {
+    if (LANE_STEP != ens->lanes[l].state) {
+      continue;
+    }
+    si = &ens->lanes[l].solverInfo;
+    for (n = 1, m = l+1; m < ens->nLanes; m++) {
+      sj = &ens->lanes[m].solverInfo;
+      if (LANE_STEP == ens->lanes[m].state && si->currentTime == sj->currentTime && si->currentStepSize == sj->currentStepSize) {
+        n++;
+      }
+    }
+    if (n > best) {
+      best = n;
+      *leader = l;
+    }
+  }
+  return best;
+}
+
+/**
+ * @brief One round of the ensemble: every lane that has not finished does at most one step.
+ *
+ * @return int      Number of lanes that have not finished before this round.
+ */
+static int ensembleRound(ENSEMBLE *ens, ENSEMBLE_STATS *stats)
+{
+  ENSEMBLE_LANE *lane;
+  SOLVER_INFO *leader;
+  int l, first = 0, nActive = 0;
+
+  for (l = 0; l < ens->nLanes; l++) {
+    lane = ens->lanes + l;
+    if (LANE_DONE != lane->state) {
+      nActive++;
+      ensembleLaneCall(ens, lane, ensemblePrepareStep);
+    }
+  }
+  if (0 == nActive) {
+    return 0;
+  }
+
+  /* lanes stepping from the same time with the same step size go in lockstep */
+  if (ensembleCommonStep(ens, &first) > 1) {
+    leader = &ens->lanes[first].solverInfo;
+    for (l = ens->nLanes - 1; l >= first; l--) {
+      lane = ens->lanes + l;
+      if (LANE_STEP == lane->state && lane->solverInfo.currentTime == leader->currentTime && lane->solverInfo.currentStepSize == leader->currentStepSize) {
+        lane->state = LANE_LOCKSTEP;
+      }
+    }
+    ensembleLockstep(ens, ens->lanes[first].solverInfo.currentStepSize);
+  }
+
+  for (l = 0; l < ens->nLanes; l++) {
+    lane = ens->lanes + l;
+    if (LANE_LOCKSTEP == lane->state) {
+      stats->nLockstepLaneSteps += !lane->stepFailed;
+    } else if (LANE_STEP == lane->state) {
+      ensembleLaneCall(ens, lane, ensembleLaneStep);
+    } else {
+      continue;
+    }
+    stats->nLaneSteps++;
+    ensembleLaneCall(ens, lane, ensembleLaneUpdate);
+  }
+  stats->nRounds++;
+
+  omc_alloc_interface.collect_a_little();
+  return nActive;
+}
+
+/**
+ * @brief Simulates the runs set up in the lanes as one ensemble.
+ *
+ * Every lane has its result file open. The solver of the model has to be
+ * supported, see ensemble_supported.
+ *
+ * @param instances               One instance per lane.
+ * @param nLanes                  Number of lanes.
+ * @param init_initMethod         See solver_main.
+ * @param init_file               See solver_main.
+ * @param init_time               See solver_main.
+ * @param outputVariablesAtEnd    See solver_main.
+ * @param laneRetVal              Return value of the simulation of every lane, like solver_main.
+ * @param stats                   Statistics of the ensemble.
+ * @return int                    0 on success, -1 if the solver is not supported.
+ */
+int ensemble_main(SIM_INSTANCE *instances, int nLanes, const char *init_initMethod, const char *init_file,
+    double init_time, const char *outputVariablesAtEnd, int *laneRetVal, ENSEMBLE_STATS *stats)
+{
+  ENSEMBLE ens;
+  ENSEMBLE_LANE *lane;
+  int l, n;
+#if !defined(OMC_NO_THREADS)
+  void *callerThreadData = pthread_getspecific(mmc_thread_data_key);
+#endif
+
+  memset(&ens, 0, sizeof(ENSEMBLE));
+  memset(stats, 0, sizeof(ENSEMBLE_STATS));
+  ens.nLanes = nLanes;
+  ens.init_initMethod = init_initMethod;
+  ens.init_file = init_file;
+  ens.init_time = init_time;
+  ens.outputVariablesAtEnd = outputVariablesAtEnd;
+  ens.nStates = instances[0].data.modelData->nStates;
+  ens.solverID = ensembleSolverID(&instances[0].data);
+  if (ensembleInitTableau(&ens)) {
+    return -1;
+  }
+
+  n = ens.nStates * nLanes;
+  ens.xOld = (double*) calloc(n, sizeof(double));
+  ens.x = (double*) calloc(n, sizeof(double));
+  ens.xt = ens.bt ? (double*) calloc(n, sizeof(double)) : NULL;
+  ens.sum = (double*) calloc(n, sizeof(double));
+  ens.k = (double*) calloc(ens.nStages * n, sizeof(double));
+  ens.lanes = (ENSEMBLE_LANE*) calloc(nLanes, sizeof(ENSEMBLE_LANE));
+
+  for (l = 0; l < nLanes; l++) {
+    lane = ens.lanes + l;
+    lane->instance = instances + l;
+    lane->retVal = -1;
+    lane->state = LANE_DONE;
+    ensembleLaneCall(&ens, lane, ensembleStartLane);
+  }
+
+  infoStreamPrint(LOG_SOLVER, 0, "Start ensemble of %d lanes, %d stages", nLanes, ens.nStages);
+  while (ensembleRound(&ens, stats));
+
+  for (l = 0; l < nLanes; l++) {
+    lane = ens.lanes + l;
+    ensembleLaneCall(&ens, lane, ensembleFinishLane);
+    externalInputFree(&lane->instance->data);
+    if (lane->initSolverInfo) {
+      freeSolverData(&lane->instance->data, &lane->solverInfo);
+    }
+    if (!lane->retVal) {
+      infoStreamPrint(LOG_SUCCESS, 0, "The simulation finished successfully.");
+    }
+    laneRetVal[l] = lane->retVal;
+  }
+
+#if !defined(OMC_NO_THREADS)
+  pthread_setspecific(mmc_thread_data_key, callerThreadData);
+#endif
+
+  free(ens.lanes);
+  free(ens.xOld);
+  free(ens.x);
+  free(ens.xt);
+  free(ens.sum);
+  free(ens.k);
+  ensembleFreeTableau(&ens);
+  return 0;
+}
+
+#endif /* !OMC_MINIMAL_RUNTIME */
@@ -0,0 +1,72 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-CurrentYear, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/*! \file ensemble.h
+ *
+ * Ensemble integration of several runs of a parameter sweep with an explicit
+ * Runge-Kutta method. The instances (lanes) of the ensemble are stepped in
+ * lockstep: the states and stage derivatives of all lanes are stored in
+ * structure-of-arrays form, x[i*nLanes + lane], so the stage updates run over
+ * all lanes in one pass. The model equations are evaluated lane by lane;
+ * the generated code has no lane loops, so only the stage updates are
+ * vectorized.
+ *
+ * A lane that does not share the time and step size of the ensemble, e.g.
+ * after an event or because of a time event in the step, and a lane whose
+ * error estimate rejects the common step does its step alone with the usual
+ * solver and joins the ensemble again at the next grid point.
+ */
+
+#ifndef _ENSEMBLE_H_
+#define _ENSEMBLE_H_
+
+#include "../../simulation_data.h"
+#include "../simulation_instances.h"
+
+#ifdef __cplusplus
+  extern "C" {
+#endif
+
+typedef struct ENSEMBLE_STATS
+{
+  unsigned long nRounds;                /* steps of the ensemble */
+  unsigned long nLaneSteps;             /* steps of all lanes */
+  unsigned long nLockstepLaneSteps;     /* lane steps done in lockstep */
+} ENSEMBLE_STATS;
+
+int ensemble_supported(DATA *data, int printReason);
+int ensemble_main(SIM_INSTANCE *lanes, int nLanes, const char *init_initMethod, const char *init_file,
+    double init_time, const char *outputVariablesAtEnd, int *laneRetVal, ENSEMBLE_STATS *stats);
+
+#ifdef __cplusplus
+  }
+#endif
+
+#endif
@@ -40,6 +40,7 @@
 #include "simulation/solver/model_help.h"
 #include "simulation/solver/external_input.h"
 #include "simulation/solver/epsilon.h"
+#include "simulation/solver/masked_eval.h"
 
 #include <math.h>
 #include <stdio.h>
@@ -51,7 +52,7 @@ extern "C" {
 #endif
 
 int maxBisectionIterations = 0;
-void bisection(DATA* data, threadData_t *threadData, double*, double*, double*, double*, LIST*, LIST*);
+void bisection(DATA* data, threadData_t *threadData, double*, double*, double*, double*, INDEX_SET*, INDEX_SET*);
 void saveZeroCrossingsAfterEvent(DATA *data, threadData_t *threadData);
 
 /*! \fn checkForSampleEvent
@@ -80,6 +81,44 @@ void checkForSampleEvent(DATA *data, SOLVER_INFO* solverInfo)
   TRACE_POP
 }
 
+/*! \fn findSignChanges
+ *
+ *  \param [in]  [zeroCrossings]
+ *  \param [in]  [zeroCrossingsPre]
+ *  \param [in]  [n]
+ *  \param [ref] [eventList]
+ *
+ *  Adds every i with sign(zeroCrossings[i]) != sign(zeroCrossingsPre[i])
+ *  to eventList. The zero crossings are compared in blocks of 64 by a
+ *  branch-free loop the compiler can vectorize; only blocks with a sign
+ *  change are packed into a bit mask and touch the set.
+ */
+void findSignChanges(const modelica_real* zeroCrossings, const modelica_real* zeroCrossingsPre, long n, INDEX_SET *eventList)
+{
+  long start, k;
+
+  for(start=0; start<n; start+=64)
+  {
+    const modelica_real *x = zeroCrossings + start, *y = zeroCrossingsPre + start;
+    long len = n - start < 64 ? n - start : 64;
+    unsigned char changed[64], any = 0;
+
+    for(k=0; k<len; k++)
+    {
+      changed[k] = ((x[k] > 0) != (y[k] > 0)) | ((x[k] < 0) != (y[k] < 0));
+      any |= changed[k];
+    }
+
+    if(any)
+    {
+      uint64_t bits = 0;
+      for(k=0; k<len; k++)
+        bits |= (uint64_t)changed[k] << k;
+      indexSetAddWord(eventList, (unsigned int)(start / 64), bits);
+    }
+  }
+}
+
 /*! \fn checkForStateEvent
  *
  *  \param [ref] [data]
@@ -89,43 +128,39 @@ void checkForSampleEvent(DATA *data, SOLVER_INFO* solverInfo)
  *  If a zero crossing function cause a sign change, root finding
  *  process will start
  */
-int checkForStateEvent(DATA* data, LIST *eventList)
+int checkForStateEvent(DATA* data, INDEX_SET *eventList)
 {
   TRACE_PUSH
   long i=0;
 
+  findSignChanges(data->simulationInfo->zeroCrossings, data->simulationInfo->zeroCrossingsPre, data->modelData->nZeroCrossings, eventList);
+
   debugStreamPrint(LOG_EVENTS, 1, "check state-event zerocrossing at time %g",  data->localData[0]->timeValue);
 
-  for(i=0; i<data->modelData->nZeroCrossings; i++)
+  if (DEBUG_STREAM(LOG_EVENTS))
   {
-    int *eq_indexes;
-    const char *exp_str = data->callback->zeroCrossingDescription(i,&eq_indexes);
-    debugStreamPrintWithEquationIndexes(LOG_EVENTS, omc_dummyFileInfo, 1, eq_indexes, "%s", exp_str);
-
-    if(sign(data->simulationInfo->zeroCrossings[i]) != sign(data->simulationInfo->zeroCrossingsPre[i]))
+    for(i=0; i<data->modelData->nZeroCrossings; i++)
     {
-      debugStreamPrint(LOG_EVENTS, 0, "changed:   %s", (data->simulationInfo->zeroCrossingsPre[i] > 0) ? "TRUE -> FALSE" : "FALSE -> TRUE");
-      listPushFront(eventList, &(data->simulationInfo->zeroCrossingIndex[i]));
-    }
-    else
-    {
-      debugStreamPrint(LOG_EVENTS, 0, "unchanged: %s", (data->simulationInfo->zeroCrossingsPre[i] > 0) ? "TRUE -- TRUE" : "FALSE -- FALSE");
-    }
+      int *eq_indexes;
+      const char *exp_str = data->callback->zeroCrossingDescription(i,&eq_indexes);
+      debugStreamPrintWithEquationIndexes(LOG_EVENTS, omc_dummyFileInfo, 1, eq_indexes, "%s", exp_str);
+
+      if(sign(data->simulationInfo->zeroCrossings[i]) != sign(data->simulationInfo->zeroCrossingsPre[i]))
+      {
+        debugStreamPrint(LOG_EVENTS, 0, "changed:   %s", (data->simulationInfo->zeroCrossingsPre[i] > 0) ? "TRUE -> FALSE" : "FALSE -> TRUE");
+      }
+      else
+      {
+        debugStreamPrint(LOG_EVENTS, 0, "unchanged: %s", (data->simulationInfo->zeroCrossingsPre[i] > 0) ? "TRUE -- TRUE" : "FALSE -- FALSE");
+      }
 
-    if (DEBUG_STREAM(LOG_EVENTS))
       messageClose(LOG_EVENTS);
-  }
-  if (DEBUG_STREAM(LOG_EVENTS))
+    }
     messageClose(LOG_EVENTS);
-
-  if(listLen(eventList) > 0)
-  {
-    TRACE_POP
-    return 1;
   }
 
   TRACE_POP
-  return 0;
+  return eventList->size > 0;
 }
 
 /*! \fn checkEvents
@@ -143,7 +178,7 @@ int checkForStateEvent(DATA* data, LIST *eventList)
  *  \param [out] [eventTime]
  *  \return 0: no event; 1: time event; 2: state event
  */
-int checkEvents(DATA* data, threadData_t *threadData, LIST* eventLst, modelica_boolean useRootFinding, double *eventTime)
+int checkEvents(DATA* data, threadData_t *threadData, INDEX_SET* eventLst, modelica_boolean useRootFinding, double *eventTime)
 {
   TRACE_PUSH
 
@@ -159,7 +194,7 @@ int checkEvents(DATA* data, threadData_t *threadData, LIST* eventLst, modelica_b
     return 1;
   }
 
-  if(listLen(eventLst) > 0)
+  if(eventLst->size > 0)
   {
     TRACE_POP
     return 2;
@@ -177,12 +212,12 @@ int checkEvents(DATA* data, threadData_t *threadData, LIST* eventLst, modelica_b
  *
  *  This handles all zero crossing events from event list at event time
  */
-void handleEvents(DATA* data, threadData_t *threadData, LIST* eventLst, double *eventTime, SOLVER_INFO* solverInfo)
+void handleEvents(DATA* data, threadData_t *threadData, INDEX_SET* eventLst, double *eventTime, SOLVER_INFO* solverInfo)
 {
   TRACE_PUSH
   double time = data->localData[0]->timeValue;
   long i;
-  LIST_NODE* it;
+  unsigned int k;
 
   /* time event */
   if(data->simulationInfo->sampleActivated)
@@ -199,16 +234,17 @@ void handleEvents(DATA* data, threadData_t *threadData, LIST* eventLst, double *
   }
   data->simulationInfo->chatteringInfo.lastStepsNumStateEvents-=data->simulationInfo->chatteringInfo.lastSteps[data->simulationInfo->chatteringInfo.currentIndex];
   /* state event */
-  if(listLen(eventLst)>0)
+  if(eventLst->size > 0)
   {
     data->localData[0]->timeValue = *eventTime;
     /* time = data->localData[0]->timeValue; */
 
     if (useStream[LOG_EVENTS])
     {
-      for(it = listFirstNode(eventLst); it; it = listNextNode(it))
+      /* report the events with the highest index first */
+      for(k = eventLst->size; k-- > 0;)
       {
-        long ix = *((long*) listNodeData(it));
+        long ix = eventLst->members[k];
         int *eq_indexes;
         const char *exp_str = data->callback->zeroCrossingDescription(ix,&eq_indexes);
         infoStreamPrintWithEquationIndexes(LOG_EVENTS, omc_dummyFileInfo, 0, eq_indexes, "[%ld] %s", ix+1, exp_str);
@@ -227,7 +263,7 @@ void handleEvents(DATA* data, threadData_t *threadData, LIST* eventLst, double *
       double t0 = data->simulationInfo->chatteringInfo.lastTimes[(currentIndex+1) % numEventLimit];
       if (time - t0 < data->simulationInfo->stepSize)
       {
-        long ix = *((long*) listNodeData(listFirstNode(eventLst)));
+        long ix = eventLst->members[eventLst->size-1];
         int *eq_indexes;
         const char *exp_str = data->callback->zeroCrossingDescription(ix,&eq_indexes);
         infoStreamPrintWithEquationIndexes(LOG_STDOUT, omc_dummyFileInfo, 0, eq_indexes, "Chattering detected around time %.12g..%.12g (%d state events in a row with a total time delta less than the step size %.12g). This can be a performance bottleneck. Use -lv LOG_EVENTS for more information. The zero-crossing was: %s", t0, time, numEventLimit, data->simulationInfo->stepSize, exp_str);
@@ -239,7 +275,7 @@ void handleEvents(DATA* data, threadData_t *threadData, LIST* eventLst, double *
       }
     }
 
-    listClear(eventLst);
+    indexSetClear(eventLst);
   } else {
     data->simulationInfo->chatteringInfo.lastSteps[data->simulationInfo->chatteringInfo.currentIndex]=0;
     /* Setting time does not matter */
@@ -289,13 +325,13 @@ void handleEvents(DATA* data, threadData_t *threadData, LIST* eventLst, double *
  *  \param [in]  [values_right]
  *  \return: first event of interval [time_left, time_right]
  */
-double findRoot(DATA* data, threadData_t* threadData, LIST* eventList, double time_left, double* values_left, double time_right, double* values_right)
+double findRoot(DATA* data, threadData_t* threadData, INDEX_SET* eventList, double time_left, double* values_left, double time_right, double* values_right)
 {
   TRACE_PUSH
 
-  LIST_NODE* it;
-  fortran_integer i=0;
-  LIST *tmpEventList = allocList(eventListAlloc, eventListFree, eventListCopy);
+  unsigned int k;
+  INDEX_SET *tmpEventList = data->simulationInfo->tmpEventList;
+  const modelica_real *zeroCrossings = data->simulationInfo->zeroCrossings;
 
   /* static work arrays */
   double *states_left = data->simulationInfo->states_left;
@@ -306,45 +342,46 @@ double findRoot(DATA* data, threadData_t* threadData, LIST* eventList, double ti
   memcpy(states_left,  values_left,  data->modelData->nStates * sizeof(double));
   memcpy(states_right, values_right, data->modelData->nStates * sizeof(double));
 
-  for(it=listFirstNode(eventList); it; it=listNextNode(it))
+  for(k=0; k<eventList->size; k++)
   {
-    infoStreamPrint(LOG_ZEROCROSSINGS, 0, "search for current event. Events in list: %ld", *((long*)listNodeData(it)));
+    infoStreamPrint(LOG_ZEROCROSSINGS, 0, "search for current event. Events in list: %ld", eventList->members[k]);
   }
 
   /* Search for event time and event_id with bisection method */
+  indexSetClear(tmpEventList);
   bisection(data, threadData, &time_left, &time_right, states_left, states_right, tmpEventList, eventList);
 
   /* what happens here? */
-  if(listLen(tmpEventList) == 0)
+  if(tmpEventList->size == 0)
   {
-    double value = fabs(data->simulationInfo->zeroCrossings[*((long*) listFirstData(eventList))]);
-    for(it = listFirstNode(eventList); it; it = listNextNode(it))
+    double value = fabs(zeroCrossings[eventList->members[0]]);
+    for(k=1; k<eventList->size; k++)
     {
-      double fvalue = fabs(data->simulationInfo->zeroCrossings[*((long*) listNodeData(it))]);
+      double fvalue = fabs(zeroCrossings[eventList->members[k]]);
       if(value > fvalue)
       {
         value = fvalue;
       }
     }
     infoStreamPrint(LOG_ZEROCROSSINGS, 0, "Minimum value: %e", value);
-    for(it = listFirstNode(eventList); it; it = listNextNode(it))
+    for(k=0; k<eventList->size; k++)
     {
-      if(value == fabs(data->simulationInfo->zeroCrossings[*((long*) listNodeData(it))]))
+      if(value == fabs(zeroCrossings[eventList->members[k]]))
       {
-        listPushBack(tmpEventList, listNodeData(it));
-        infoStreamPrint(LOG_ZEROCROSSINGS, 0, "added tmp event : %ld", *((long*) listNodeData(it)));
+        indexSetAdd(tmpEventList, eventList->members[k]);
+        infoStreamPrint(LOG_ZEROCROSSINGS, 0, "added tmp event : %ld", eventList->members[k]);
       }
     }
   }
 
-  listClear(eventList);
+  /* the events found by the bisection become the new event list */
+  indexSetSwap(eventList, tmpEventList);
+  indexSetClear(tmpEventList);
 
-  debugStreamPrint(LOG_EVENTS, 0, (listLen(tmpEventList) == 1) ? "found event: " : "found events: ");
-  while(listLen(tmpEventList) > 0)
+  debugStreamPrint(LOG_EVENTS, 0, (eventList->size == 1) ? "found event: " : "found events: ");
+  for(k=0; k<eventList->size; k++)
   {
-    long event_id = *((long*)listFirstData(tmpEventList));
-    listPushFrontNodeNoCopy(eventList, listPopFrontNode(tmpEventList));
-    infoStreamPrint(LOG_ZEROCROSSINGS, 0, "Event id: %ld", event_id);
+    infoStreamPrint(LOG_ZEROCROSSINGS, 0, "Event id: %ld", eventList->members[k]);
   }
 
   debugStreamPrint(LOG_EVENTS, 0, "time: %.10e", time_right);
@@ -360,8 +397,6 @@ double findRoot(DATA* data, threadData_t* threadData, LIST* eventList, double ti
   data->localData[0]->timeValue = time_right;
   memcpy(data->localData[0]->realVars, states_right, data->modelData->nStates * sizeof(double));
 
-  freeList(tmpEventList);
-
   TRACE_POP
   return time_right;
 }
@@ -378,7 +413,7 @@ double findRoot(DATA* data, threadData_t* threadData, LIST* eventList, double ti
  *
  *  Method to find root in interval [oldTime, timeValue]
  */
-void bisection(DATA* data, threadData_t *threadData, double* a, double* b, double* states_a, double* states_b, LIST *tmpEventList, LIST *eventList)
+void bisection(DATA* data, threadData_t *threadData, double* a, double* b, double* states_a, double* states_b, INDEX_SET *tmpEventList, INDEX_SET *eventList)
 {
   TRACE_PUSH
 
@@ -387,12 +422,16 @@ void bisection(DATA* data, threadData_t *threadData, double* a, double* b, doubl
   long i=0;
   /* n >= log(2)/log(2) + log(|b-a|/TOL)/log(2)*/
   unsigned int n = maxBisectionIterations > 0 ? maxBisectionIterations : 1 + ceil(log(fabs(*b - *a)/TTOL)/log(2));
+  EVAL_MASK mask;
 
   memcpy(data->simulationInfo->zeroCrossingsBackup, data->simulationInfo->zeroCrossings, data->modelData->nZeroCrossings * sizeof(modelica_real));
 
   infoStreamPrint(LOG_ZEROCROSSINGS, 0, "bisection method starts in interval [%e, %e]", *a, *b);
   infoStreamPrint(LOG_ZEROCROSSINGS, 0, "TTOL is set to %e and maximum number of intersections %d.", TTOL, n);
 
+  /* only the equations depending on the interpolated states and time are re-evaluated */
+  maskedEval_init(&mask, data, data->callback->zeroCrossingDependencies);
+
   while(fabs(*b - *a) > MINIMAL_STEP_SIZE && n-- > 0)
   {
     c = 0.5 * (*a + *b);
@@ -409,7 +448,7 @@ void bisection(DATA* data, threadData_t *threadData, double* a, double* b, doubl
     externalInputUpdate(data);
     data->callback->input_function(data, threadData);
     /* eval needed equations*/
-    data->callback->function_ZeroCrossingsEquations(data, threadData);
+    maskedEval_functionZeroCrossingsEquations(&mask, data, threadData);
 
     data->callback->function_ZeroCrossings(data, threadData, data->simulationInfo->zeroCrossings);
 
@@ -427,6 +466,7 @@ void bisection(DATA* data, threadData_t *threadData, double* a, double* b, doubl
       memcpy(data->simulationInfo->zeroCrossings, data->simulationInfo->zeroCrossingsBackup, data->modelData->nZeroCrossings * sizeof(modelica_real));
     }
   }
+  maskedEval_free(&mask);
 
   TRACE_POP
 }
@@ -440,31 +480,33 @@ void bisection(DATA* data, threadData_t *threadData, double* a, double* b, doubl
  *  \param [in]  [eventList]
  *  \return boolean value
  */
-int checkZeroCrossings(DATA *data, LIST *tmpEventList, LIST *eventList)
+int checkZeroCrossings(DATA *data, INDEX_SET *tmpEventList, INDEX_SET *eventList)
 {
   TRACE_PUSH
-  LIST_NODE *it;
+  const modelica_real *zeroCrossings = data->simulationInfo->zeroCrossings;
+  const modelica_real *zeroCrossingsPre = data->simulationInfo->zeroCrossingsPre;
+  unsigned int k;
 
-  listClear(tmpEventList);
+  indexSetClear(tmpEventList);
   infoStreamPrint(LOG_ZEROCROSSINGS, 0, "bisection checks for condition changes");
 
-  for(it=listFirstNode(eventList); it; it=listNextNode(it))
+  for(k=0; k<eventList->size; k++)
   {
+    long ix = eventList->members[k];
+
     /* found event in left section */
-    if((data->simulationInfo->zeroCrossings[*((long*) listNodeData(it))] == -1 &&
-        data->simulationInfo->zeroCrossingsPre[*((long*) listNodeData(it))] == 1) ||
-       (data->simulationInfo->zeroCrossings[*((long*) listNodeData(it))] == 1 &&
-        data->simulationInfo->zeroCrossingsPre[*((long*) listNodeData(it))] == -1))
+    if((zeroCrossings[ix] == -1 && zeroCrossingsPre[ix] == 1) ||
+       (zeroCrossings[ix] == 1 && zeroCrossingsPre[ix] == -1))
     {
       infoStreamPrint(LOG_ZEROCROSSINGS, 0, "%ld changed from %s to current %s",
-            *((long*) listNodeData(it)),
-            (data->simulationInfo->zeroCrossingsPre[*((long*) listNodeData(it))] > 0) ? "TRUE" : "FALSE",
-            (data->simulationInfo->zeroCrossings[*((long*) listNodeData(it))] > 0) ? "TRUE" : "FALSE");
-      listPushFront(tmpEventList, listNodeData(it));
+            ix,
+            (zeroCrossingsPre[ix] > 0) ? "TRUE" : "FALSE",
+            (zeroCrossings[ix] > 0) ? "TRUE" : "FALSE");
+      indexSetAdd(tmpEventList, ix);
     }
   }
 
-  if(listLen(tmpEventList) > 0)
+  if(tmpEventList->size > 0)
   {
     TRACE_POP
     return 1;   /* event in left section */
@@ -494,38 +536,6 @@ void saveZeroCrossingsAfterEvent(DATA *data, threadData_t *threadData)
   TRACE_POP
 }
 
-/**
- * @brief Allocate memory for eventList elements.
- *
- * @param data      Unused.
- * @return void*    Allocated memory for LIST_NODE data.
- */
-void* eventListAlloc(const void* data) {
-  void* newElem = malloc(sizeof(long));
-  assertStreamPrint(NULL, newElem != NULL, "eventListAlloc: Out of memory");
-  return newElem;
-}
-
-/**
- * @brief Free memory allocated with eventListAlloc.
- *
- * @param data      Void pointer, representing index for new list element.
- */
-void eventListFree(void* data) {
-  free(data);
-}
-
-/**
- * @brief Copy data of eventList elements.
- *
- * @param dest    Void pointer of destination data, representing long index.
- * @param src     Void pointer of source data, representing long index.
- */
-void eventListCopy(void* dest, const void* src) {
-  long* dest_event = (long*) dest;
-  *dest_event = *((long*) src);
-}
-
 #ifdef __cplusplus
 }
 #endif
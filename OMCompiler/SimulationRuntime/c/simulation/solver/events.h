@@ -36,7 +36,7 @@
 
 #include "../../simulation_data.h"
 #include "solver_main.h"
-#include "../../util/list.h"
+#include "../../util/index_set.h"
 #include "fmi_events.h"
 
 #ifdef __cplusplus
@@ -45,17 +45,14 @@ extern "C" {
 
 extern int maxBisectionIterations;
 
-int checkForStateEvent(DATA* data, LIST *eventList);
+int checkForStateEvent(DATA* data, INDEX_SET *eventList);
 void checkForSampleEvent(DATA *data, SOLVER_INFO* solverInfo);
-int checkEvents(DATA* data, threadData_t *threadData, LIST* eventLst, modelica_boolean useRootFinding, double *eventTime);
-void handleEvents(DATA* data, threadData_t *threadData, LIST* eventLst, double *eventTime, SOLVER_INFO* solverInfo);
+int checkEvents(DATA* data, threadData_t *threadData, INDEX_SET* eventLst, modelica_boolean useRootFinding, double *eventTime);
+void handleEvents(DATA* data, threadData_t *threadData, INDEX_SET* eventLst, double *eventTime, SOLVER_INFO* solverInfo);
 
-double findRoot(DATA* data, threadData_t* threadData, LIST* eventList, double time_left, double* states_left, double time_right, double* states_right);
-int checkZeroCrossings(DATA *data, LIST *tmpEventList, LIST *eventList);
-
-void* eventListAlloc(const void* data);
-void eventListFree(void* data);
-void eventListCopy(void* dest, const void* src);
+double findRoot(DATA* data, threadData_t* threadData, INDEX_SET* eventList, double time_left, double* states_left, double time_right, double* states_right);
+int checkZeroCrossings(DATA *data, INDEX_SET *tmpEventList, INDEX_SET *eventList);
+void findSignChanges(const modelica_real* zeroCrossings, const modelica_real* zeroCrossingsPre, long n, INDEX_SET *eventList);
 
 #ifdef __cplusplus
 }
@@ -92,13 +92,31 @@ int externalInputallocate(DATA* data)
 
 void externalInputallocate2(DATA* data, const char *filename){
   int i, j, k;
-  struct csv_data *res = read_csv(filename);
+  struct csv_data *res = NULL;
   char ** names;
+  char ** header;
+  const char ** columns;
+  int nheader = 0;
   int * indx;
   const int nu = data->modelData->nInputVars;
-  const int nnu = modelica_integer_min(nu, res ? res->numvars - 1 : 0);
 
-  if (NULL == res) {
+  names = (char**)malloc(nu * sizeof(char*));
+  data->callback->inputNames(data, names);
+
+  /* Only the first column (the time) and the columns of the inputs are read */
+  header = read_csv_column_names(filename, &nheader);
+  if (header && nheader > 0) {
+    columns = (const char**)malloc((nu+1) * sizeof(const char*));
+    columns[0] = header[0];
+    for(i = 0; i < nu; ++i){
+      columns[i+1] = names[i];
+    }
+    res = read_csv_columns(filename, nu+1, columns, 0);
+    free(columns);
+  }
+  omc_free_csv_column_names(header, nheader);
+
+  if (NULL == res || res->numvars == 0) {
     fprintf(stderr, "Failed to read CSV-file %s", filename);
     EXIT(1);
   }
@@ -109,20 +127,17 @@ void externalInputallocate2(DATA* data, const char *filename){
 
   data->simulationInfo->external_input.u = (modelica_real**)calloc(data->simulationInfo->external_input.n+1, sizeof(modelica_real*));
 
-  names = (char**)malloc(nu * sizeof(char*));
-
   for(i = 0; i<data->simulationInfo->external_input.n; ++i){
-    data->simulationInfo->external_input.u[i] = (modelica_real*)calloc(nnu, sizeof(modelica_real));
+    data->simulationInfo->external_input.u[i] = (modelica_real*)calloc(nu, sizeof(modelica_real));
   }
 
   data->simulationInfo->external_input.t = (modelica_real*)calloc(data->simulationInfo->external_input.n+1, sizeof(modelica_real));
 
-  data->callback->inputNames(data, names);
-
+  /* res->variables[0] is the time column, the inputs follow in the order of the file */
   indx = (int*)malloc(nu*sizeof(int));
   for(i = 0; i < nu; ++i){
     indx[i] = -1;
-    for(j = 0; j < res->numvars; ++j){
+    for(j = 1; j < res->numvars; ++j){
       if(strcmp(names[i], res->variables[j]) == 0){
         indx[i] = j;
         break;
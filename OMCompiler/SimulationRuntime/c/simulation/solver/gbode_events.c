@@ -51,7 +51,7 @@
  *
  *  Method to find root in interval [oldTime, timeValue]
  */
-void bisection_gb(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInfo, double* a, double* b, double* states_a, double* states_b, LIST *tmpEventList, LIST *eventList, modelica_boolean isInnerIntegration)
+void bisection_gb(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInfo, double* a, double* b, double* states_a, double* states_b, INDEX_SET *tmpEventList, INDEX_SET *eventList, modelica_boolean isInnerIntegration)
 {
   TRACE_PUSH
 
@@ -131,13 +131,13 @@ void bisection_gb(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInfo,
  *  \param [in]  [values_right]
  *  \return: first event of interval [time_left, time_right]
  */
-double findRoot_gb(DATA* data, threadData_t* threadData, SOLVER_INFO* solverInfo, LIST* eventList, double time_left, double* values_left, double time_right, double* values_right, modelica_boolean isInnerIntegration)
+double findRoot_gb(DATA* data, threadData_t* threadData, SOLVER_INFO* solverInfo, INDEX_SET* eventList, double time_left, double* values_left, double time_right, double* values_right, modelica_boolean isInnerIntegration)
 {
   TRACE_PUSH
 
-  LIST_NODE* it;
-  fortran_integer i=0;
-  LIST *tmpEventList = allocList(eventListAlloc, eventListFree, eventListCopy);
+  unsigned int k;
+  INDEX_SET *tmpEventList = data->simulationInfo->tmpEventList;
+  const modelica_real *zeroCrossings = data->simulationInfo->zeroCrossings;
 
   /* static work arrays */
   double *states_left = data->simulationInfo->states_left;
@@ -147,45 +147,46 @@ double findRoot_gb(DATA* data, threadData_t* threadData, SOLVER_INFO* solverInfo
   memcpy(states_left,  values_left,  data->modelData->nStates * sizeof(double));
   memcpy(states_right, values_right, data->modelData->nStates * sizeof(double));
 
-  for(it=listFirstNode(eventList); it; it=listNextNode(it))
+  for(k=0; k<eventList->size; k++)
   {
-    infoStreamPrint(LOG_ZEROCROSSINGS, 0, "search for current event. Events in list: %ld", *((long*)listNodeData(it)));
+    infoStreamPrint(LOG_ZEROCROSSINGS, 0, "search for current event. Events in list: %ld", eventList->members[k]);
   }
 
   /* Search for event time and event_id with bisection method */
+  indexSetClear(tmpEventList);
   bisection_gb(data, threadData, solverInfo, &time_left, &time_right, states_left, states_right, tmpEventList, eventList, isInnerIntegration);
 
   /* what happens here? */
-  if(listLen(tmpEventList) == 0)
+  if(tmpEventList->size == 0)
   {
-    double value = fabs(data->simulationInfo->zeroCrossings[*((long*) listFirstData(eventList))]);
-    for(it = listFirstNode(eventList); it; it = listNextNode(it))
+    double value = fabs(zeroCrossings[eventList->members[0]]);
+    for(k=1; k<eventList->size; k++)
     {
-      double fvalue = fabs(data->simulationInfo->zeroCrossings[*((long*) listNodeData(it))]);
+      double fvalue = fabs(zeroCrossings[eventList->members[k]]);
       if(value > fvalue)
       {
         value = fvalue;
       }
     }
     infoStreamPrint(LOG_ZEROCROSSINGS, 0, "Minimum value: %e", value);
-    for(it = listFirstNode(eventList); it; it = listNextNode(it))
+    for(k=0; k<eventList->size; k++)
     {
-      if(value == fabs(data->simulationInfo->zeroCrossings[*((long*) listNodeData(it))]))
+      if(value == fabs(zeroCrossings[eventList->members[k]]))
       {
-        listPushBack(tmpEventList, listNodeData(it));
-        infoStreamPrint(LOG_ZEROCROSSINGS, 0, "added tmp event : %ld", *((long*) listNodeData(it)));
+        indexSetAdd(tmpEventList, eventList->members[k]);
+        infoStreamPrint(LOG_ZEROCROSSINGS, 0, "added tmp event : %ld", eventList->members[k]);
       }
     }
   }
 
-  listClear(eventList);
+  /* the events found by the bisection become the new event list */
+  indexSetSwap(eventList, tmpEventList);
+  indexSetClear(tmpEventList);
 
-  debugStreamPrint(LOG_EVENTS, 0, (listLen(tmpEventList) == 1) ? "found event: " : "found events: ");
-  while(listLen(tmpEventList) > 0)
+  debugStreamPrint(LOG_EVENTS, 0, (eventList->size == 1) ? "found event: " : "found events: ");
+  for(k=0; k<eventList->size; k++)
   {
-    long event_id = *((long*)listFirstData(tmpEventList));
-    listPushFrontNodeNoCopy(eventList, listPopFrontNode(tmpEventList));
-    infoStreamPrint(LOG_ZEROCROSSINGS, 0, "Event id: %ld", event_id);
+    infoStreamPrint(LOG_ZEROCROSSINGS, 0, "Event id: %ld", eventList->members[k]);
   }
 
   debugStreamPrint(LOG_EVENTS, 0, "time: %.10e", time_right);
@@ -201,8 +202,6 @@ double findRoot_gb(DATA* data, threadData_t* threadData, SOLVER_INFO* solverInfo
   data->localData[0]->timeValue = time_right;
   memcpy(data->localData[0]->realVars, states_right, data->modelData->nStates * sizeof(double));
 
-  freeList(tmpEventList);
-
   TRACE_POP
   return time_right;
 }
@@ -229,8 +228,6 @@ double checkForEvents(DATA* data, threadData_t* threadData, SOLVER_INFO* solverI
 
   double eventTime = NAN;
 
-  static LIST *tmpEventList = NULL;
-
   // store the pre values of the zeroCrossings for comparison
   memcpy(data->simulationInfo->zeroCrossingsPre, data->simulationInfo->zeroCrossings, data->modelData->nZeroCrossings * sizeof(modelica_real));
 
@@ -62,6 +62,7 @@
 #include "omc_math.h"
 #include "simulation/options.h"
 #include "simulation/results/simulation_result.h"
+#include "simulation/jacobian_cache.h"
 #include "simulation/jacobian_util.h"
 #include "util/omc_error.h"
 #include "util/omc_file.h"
@@ -238,7 +239,11 @@ int gbodef_allocateData(DATA *data, threadData_t *threadData, SOLVER_INFO *solve
     {
       return -1;
     }
-    gbfData->sparsePattern_DIRK = initializeSparsePattern_SR(data, gbfData->nlsData);
+    gbfData->sparsePattern_DIRK = lookupSparsePatternCache(data, "gbodeDIRK", gbfData->nlsData->size, gbfData->nlsData->size);
+    if (gbfData->sparsePattern_DIRK == NULL) {
+      gbfData->sparsePattern_DIRK = initializeSparsePattern_SR(data, gbfData->nlsData);
+      storeSparsePatternCache(data, "gbodeDIRK", gbfData->nlsData->size, gbfData->nlsData->size, gbfData->sparsePattern_DIRK);
+    }
   }
   else
   {
@@ -1059,7 +1064,7 @@ int gbodef_main(DATA *data, threadData_t *threadData, SOLVER_INFO *solverInfo, d
        * continuous system with algebraic variables.
        */
       data->callback->updateContinuousSystem(data, threadData);
-      sim_result.emit(&sim_result, data, threadData);
+      data->simResult->emit(data->simResult, data, threadData);
       // log the emitted result
       if (ACTIVE_STREAM(LOG_GBODE)){
         infoStreamPrint(LOG_GBODE, 1, "Emit result (inner integration):");
@@ -1551,7 +1556,7 @@ int gbode_birate(DATA *data, threadData_t *threadData, SOLVER_INFO *solverInfo)
        * continuous system with algebraic variables.
        */
       data->callback->updateContinuousSystem(data, threadData);
-      sim_result.emit(&sim_result, data, threadData);
+      data->simResult->emit(data->simResult, data, threadData);
       // log the emitted result
       if (ACTIVE_STREAM(LOG_GBODE)){
         infoStreamPrint(LOG_GBODE, 1, "Emit result (birate integration):");
@@ -1920,7 +1925,7 @@ int gbode_singlerate(DATA *data, threadData_t *threadData, SOLVER_INFO *solverIn
         // done in solver_main (linearly) and therefore the states are not very well approximated.
         // Current solution: Step back to the communication interval before the event and event detection
         // needs to be repeated
-        listClear(solverInfo->eventLst);
+        indexSetClear(solverInfo->eventLst);
         gbData->lastStepSize = (eventTime - solverInfo->currentStepSize/2) - gbData->timeLeft;
         sData->timeValue = (eventTime - solverInfo->currentStepSize/2);
         gb_interpolation(gbData->interpolation,
@@ -1949,7 +1954,7 @@ int gbode_singlerate(DATA *data, threadData_t *threadData, SOLVER_INFO *solverIn
        * continuous system with algebraic variables.
        */
       data->callback->updateContinuousSystem(data, threadData);
-      sim_result.emit(&sim_result, data, threadData);
+      data->simResult->emit(data->simResult, data, threadData);
       // log the emitted result
       if (ACTIVE_STREAM(LOG_GBODE)){
         infoStreamPrint(LOG_GBODE, 1, "Emit result (single-rate integration):");
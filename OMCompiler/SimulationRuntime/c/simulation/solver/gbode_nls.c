@@ -45,6 +45,7 @@
 #include "newtonIteration.h"
 #include "nonlinearSystem.h"
 
+#include "simulation/jacobian_cache.h"
 #include "simulation/jacobian_util.h"
 #include "util/rtclock.h"
 
@@ -82,7 +83,11 @@ void initializeStaticNLSData_SR(DATA* data, threadData_t *threadData, NONLINEAR_
 
   /* Initialize sparsity pattern */
   if (initSparsePattern) {
-    nonlinsys->sparsePattern = initializeSparsePattern_SR(data, nonlinsys);
+    nonlinsys->sparsePattern = lookupSparsePatternCache(data, "gbodeDIRK", nonlinsys->size, nonlinsys->size);
+    if (nonlinsys->sparsePattern == NULL) {
+      nonlinsys->sparsePattern = initializeSparsePattern_SR(data, nonlinsys);
+      storeSparsePatternCache(data, "gbodeDIRK", nonlinsys->size, nonlinsys->size, nonlinsys->sparsePattern);
+    }
     nonlinsys->isPatternAvailable = TRUE;
   }
   return;
@@ -108,7 +113,8 @@ void initializeStaticNLSData_MR(DATA* data, threadData_t *threadData, NONLINEAR_
     nonlinsys->max[i]     = data->modelData->realVarsData[i].attribute.max;
   }
 
-  /* Initialize sparsity pattern, First guess (all states are fast states) */
+  /* Initialize sparsity pattern, First guess (all states are fast states)
+   * Not taken from the pattern cache, updateSparsePattern_MR changes it in place. */
   if (initSparsePattern) {
     nonlinsys->sparsePattern = initializeSparsePattern_SR(data, nonlinsys);
     nonlinsys->isPatternAvailable = TRUE;
@@ -135,9 +141,15 @@ void initializeStaticNLSData_IRK(DATA* data, threadData_t *threadData, NONLINEAR
     nonlinsys->max[i]     = data->modelData->realVarsData[i].attribute.max;
   }
 
-  /* Initialize sparsity pattern */
+  /* Initialize sparsity pattern, it depends on the Butcher tableau */
   if (initSparsePattern) {
-    nonlinsys->sparsePattern = initializeSparsePattern_IRK(data, nonlinsys);
+    char name[48];
+    snprintf(name, sizeof(name), "gbodeIRK_%s", GB_METHOD_NAME[((DATA_GBODE*) data->simulationInfo->backupSolverData)->GM_method]);
+    nonlinsys->sparsePattern = lookupSparsePatternCache(data, name, nonlinsys->size, nonlinsys->size);
+    if (nonlinsys->sparsePattern == NULL) {
+      nonlinsys->sparsePattern = initializeSparsePattern_IRK(data, nonlinsys);
+      storeSparsePatternCache(data, name, nonlinsys->size, nonlinsys->size, nonlinsys->sparsePattern);
+    }
     nonlinsys->isPatternAvailable = TRUE;
   }
   return;
@@ -0,0 +1,585 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-2024, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/*! \file ida_precond.c
+ *
+ * Block-Jacobi and ILU(0) preconditioners for the iterative linear solvers
+ * of IDA. Both work on the fixed sparsity pattern of the IDA Jacobian plus
+ * its diagonal:
+ *
+ *  - block-Jacobi: the blocks are the strongly connected components of the
+ *    dependency graph (the BLT blocks of the Jacobian), each factorized by a
+ *    dense LU with partial pivoting.
+ *  - ILU(0): incomplete LU factorization without fill-in.
+ *
+ * A Jacobian may be reused for several setups (lagged Jacobian). In ODE mode
+ * the matrix is df/dy - cj*I and a lagged Jacobian is only re-shifted with the
+ * new cj and re-factorized; in DAE mode the old factorization is reused.
+ */
+
+#include "ida_precond.h"
+
+#ifdef WITH_SUNDIALS
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "util/omc_error.h"
+
+static void* precMalloc(size_t n, size_t size)
+{
+  void* ptr = calloc(n > 0 ? n : 1, size);
+  assertStreamPrint(NULL, NULL != ptr, "ida_precond: out of memory");
+  return ptr;
+}
+
+/**
+ * @brief Build the fixed CSC pattern: sparsity pattern plus diagonal, rows sorted.
+ */
+static void initPattern(IDA_PRECONDITIONER* prec, SPARSE_PATTERN* sparsePattern)
+{
+  long int N = prec->N;
+  long int i, j, k, nz = 0;
+  long int row, start;
+  modelica_boolean hasDiag;
+
+  prec->colPtr = (long int*) precMalloc(N+1, sizeof(long int));
+  prec->rowIdx = (long int*) precMalloc(sparsePattern->numberOfNonZeros + N, sizeof(long int));
+
+  for (j = 0; j < N; j++) {
+    prec->colPtr[j] = nz;
+    start = nz;
+    hasDiag = FALSE;
+    for (k = sparsePattern->leadindex[j]; k < sparsePattern->leadindex[j+1]; k++) {
+      row = sparsePattern->index[k];
+      hasDiag = hasDiag || (row == j);
+      prec->rowIdx[nz++] = row;
+    }
+    if (!hasDiag) {
+      prec->rowIdx[nz++] = j;
+    }
+    /* insertion sort, columns are short */
+    for (i = start + 1; i < nz; i++) {
+      row = prec->rowIdx[i];
+      for (k = i - 1; k >= start && prec->rowIdx[k] > row; k--) {
+        prec->rowIdx[k+1] = prec->rowIdx[k];
+      }
+      prec->rowIdx[k+1] = row;
+    }
+  }
+  prec->colPtr[N] = nz;
+  prec->nnz = nz;
+  prec->jac = (double*) precMalloc(nz, sizeof(double));
+}
+
+/**
+ * @brief Emit one strongly connected component as one or more blocks.
+ */
+static void addComponent(IDA_PRECONDITIONER* prec, long int* stack, long int first, long int last, long int* nPerm)
+{
+  long int k;
+
+  for (k = first; k < last; k++) {
+    if ((*nPerm - prec->blockPtr[prec->nBlocks]) == IDA_PREC_MAX_BLOCK_SIZE) {
+      prec->nBlocks++;
+      prec->blockPtr[prec->nBlocks] = *nPerm;
+    }
+    prec->blockOf[stack[k]] = prec->nBlocks;
+    prec->localIdx[stack[k]] = *nPerm - prec->blockPtr[prec->nBlocks];
+    prec->perm[(*nPerm)++] = stack[k];
+  }
+  prec->nBlocks++;
+  prec->blockPtr[prec->nBlocks] = *nPerm;
+}
+
+/**
+ * @brief Find the strongly connected components of the pattern with an
+ * iterative Tarjan algorithm and allocate the dense blocks.
+ */
+static void initBlockJacobi(IDA_PRECONDITIONER* prec)
+{
+  long int N = prec->N;
+  long int *index = (long int*) precMalloc(N, sizeof(long int));
+  long int *low = (long int*) precMalloc(N, sizeof(long int));
+  char *onStack = (char*) precMalloc(N, sizeof(char));
+  long int *stack = (long int*) precMalloc(N, sizeof(long int));
+  long int *callNode = (long int*) precMalloc(N, sizeof(long int));
+  long int *callPos = (long int*) precMalloc(N, sizeof(long int));
+  long int counter = 0, sp = 0, cp = 0, nPerm = 0;
+  long int root, v, w, p, b, size, first;
+
+  prec->blockPtr = (long int*) precMalloc(N+1, sizeof(long int));
+  prec->perm = (long int*) precMalloc(N, sizeof(long int));
+  prec->blockOf = (long int*) precMalloc(N, sizeof(long int));
+  prec->localIdx = (long int*) precMalloc(N, sizeof(long int));
+  prec->nBlocks = 0;
+  prec->blockPtr[0] = 0;
+
+  for (v = 0; v < N; v++) {
+    index[v] = -1;
+  }
+
+  for (root = 0; root < N; root++) {
+    if (index[root] >= 0) {
+      continue;
+    }
+    index[root] = low[root] = counter++;
+    stack[sp++] = root;
+    onStack[root] = 1;
+    callNode[cp] = root;
+    callPos[cp++] = prec->colPtr[root];
+
+    while (cp > 0) {
+      v = callNode[cp-1];
+      p = callPos[cp-1];
+      if (p < prec->colPtr[v+1]) {
+        /* edge v -> w if w depends on v */
+        callPos[cp-1]++;
+        w = prec->rowIdx[p];
+        if (index[w] < 0) {
+          index[w] = low[w] = counter++;
+          stack[sp++] = w;
+          onStack[w] = 1;
+          callNode[cp] = w;
+          callPos[cp++] = prec->colPtr[w];
+        } else if (onStack[w] && index[w] < low[v]) {
+          low[v] = index[w];
+        }
+      } else {
+        cp--;
+        if (low[v] == index[v]) {
+          first = sp;
+          do {
+            w = stack[--first];
+            onStack[w] = 0;
+          } while (w != v);
+          addComponent(prec, stack, first, sp, &nPerm);
+          sp = first;
+        }
+        if (cp > 0 && low[v] < low[callNode[cp-1]]) {
+          low[callNode[cp-1]] = low[v];
+        }
+      }
+    }
+  }
+
+  prec->luPtr = (long int*) precMalloc(prec->nBlocks+1, sizeof(long int));
+  prec->luPtr[0] = 0;
+  for (b = 0; b < prec->nBlocks; b++) {
+    size = prec->blockPtr[b+1] - prec->blockPtr[b];
+    prec->luPtr[b+1] = prec->luPtr[b] + size*size;
+  }
+  prec->blockLU = (double*) precMalloc(prec->luPtr[prec->nBlocks], sizeof(double));
+  prec->pivots = (long int*) precMalloc(N, sizeof(long int));
+  prec->work = (double*) precMalloc(N, sizeof(double));
+
+  free(index);
+  free(low);
+  free(onStack);
+  free(stack);
+  free(callNode);
+  free(callPos);
+}
+
+/**
+ * @brief Build the CSR copy of the pattern used by ILU(0).
+ */
+static void initILU0(IDA_PRECONDITIONER* prec)
+{
+  long int N = prec->N;
+  long int i, j, p, pos;
+  long int *next = (long int*) precMalloc(N, sizeof(long int));
+
+  prec->rowPtr = (long int*) precMalloc(N+1, sizeof(long int));
+  prec->csrCol = (long int*) precMalloc(prec->nnz, sizeof(long int));
+  prec->csrDiag = (long int*) precMalloc(N, sizeof(long int));
+  prec->cscToCsr = (long int*) precMalloc(prec->nnz, sizeof(long int));
+  prec->iw = (long int*) precMalloc(N, sizeof(long int));
+  prec->lu = (double*) precMalloc(prec->nnz, sizeof(double));
+
+  for (p = 0; p < prec->nnz; p++) {
+    prec->rowPtr[prec->rowIdx[p]+1]++;
+  }
+  for (i = 0; i < N; i++) {
+    prec->rowPtr[i+1] += prec->rowPtr[i];
+    next[i] = prec->rowPtr[i];
+    prec->iw[i] = -1;
+  }
+  /* traversing the columns in order keeps the columns of each row sorted */
+  for (j = 0; j < N; j++) {
+    for (p = prec->colPtr[j]; p < prec->colPtr[j+1]; p++) {
+      i = prec->rowIdx[p];
+      pos = next[i]++;
+      prec->csrCol[pos] = j;
+      prec->cscToCsr[p] = pos;
+      if (i == j) {
+        prec->csrDiag[i] = pos;
+      }
+    }
+  }
+
+  free(next);
+}
+
+/**
+ * @brief Allocate a preconditioner for the given sparsity pattern.
+ *
+ * @param method          Preconditioner type, IDA_PREC_BLOCK_JACOBI or IDA_PREC_ILU0.
+ * @param lag             Number of setups that may reuse one Jacobian evaluation.
+ * @param N               Number of unknowns.
+ * @param sparsePattern   Sparsity pattern of the IDA Jacobian.
+ * @param shiftable       TRUE if the Jacobian is df/dy - cj*I (ODE mode).
+ * @return                Preconditioner data, free with idaPrecFree.
+ */
+IDA_PRECONDITIONER* idaPrecAllocate(enum IDA_PREC method, int lag, long int N, SPARSE_PATTERN* sparsePattern, modelica_boolean shiftable)
+{
+  IDA_PRECONDITIONER* prec = (IDA_PRECONDITIONER*) precMalloc(1, sizeof(IDA_PRECONDITIONER));
+
+  prec->method = method;
+  prec->lag = lag > 0 ? lag : 0;
+  prec->N = N;
+  prec->shiftable = shiftable;
+  prec->hasJac = FALSE;
+  prec->hasFactor = FALSE;
+
+  initPattern(prec, sparsePattern);
+
+  switch (method) {
+  case IDA_PREC_BLOCK_JACOBI:
+    initBlockJacobi(prec);
+    infoStreamPrint(LOG_SOLVER, 0, "IDA block-Jacobi preconditioner with %ld blocks for %ld unknowns", prec->nBlocks, N);
+    break;
+  case IDA_PREC_ILU0:
+    initILU0(prec);
+    infoStreamPrint(LOG_SOLVER, 0, "IDA ILU(0) preconditioner with %ld non-zero elements for %ld unknowns", prec->nnz, N);
+    break;
+  default:
+    throwStreamPrint(NULL, "ida_precond: unsupported preconditioner %s", IDA_PREC_METHOD[method]);
+  }
+
+  return prec;
+}
+
+/**
+ * @brief Free preconditioner data.
+ */
+void idaPrecFree(IDA_PRECONDITIONER* prec)
+{
+  if (prec == NULL) {
+    return;
+  }
+  free(prec->colPtr);
+  free(prec->rowIdx);
+  free(prec->jac);
+
+  free(prec->blockPtr);
+  free(prec->perm);
+  free(prec->blockOf);
+  free(prec->localIdx);
+  free(prec->luPtr);
+  free(prec->blockLU);
+  free(prec->pivots);
+  free(prec->work);
+
+  free(prec->rowPtr);
+  free(prec->csrCol);
+  free(prec->csrDiag);
+  free(prec->cscToCsr);
+  free(prec->iw);
+  free(prec->lu);
+
+  free(prec);
+}
+
+/**
+ * @brief Check if the next setup has to evaluate a new Jacobian.
+ *
+ * @param prec    Preconditioner data.
+ * @return        TRUE if no Jacobian is available or the lag is exhausted.
+ */
+modelica_boolean idaPrecNeedsJacobian(IDA_PRECONDITIONER* prec)
+{
+  return !prec->hasJac || prec->nSinceJac > prec->lag;
+}
+
+/**
+ * @brief Copy a freshly evaluated Jacobian into the fixed pattern.
+ *
+ * Elements of A outside of the pattern are dropped.
+ *
+ * @param prec    Preconditioner data.
+ * @param A       Sparse CSC Jacobian evaluated with cj.
+ * @param cj      Scalar cj of IDA the Jacobian was evaluated with.
+ */
+void idaPrecSetJacobian(IDA_PRECONDITIONER* prec, SUNMatrix A, double cj)
+{
+  sunindextype *colptrs = SM_INDEXPTRS_S(A);
+  sunindextype *rowvals = SM_INDEXVALS_S(A);
+  realtype *values = SM_DATA_S(A);
+  long int j, p, lo, hi, mid, row;
+
+  memset(prec->jac, 0, prec->nnz*sizeof(double));
+  for (j = 0; j < prec->N; j++) {
+    for (p = colptrs[j]; p < colptrs[j+1]; p++) {
+      row = rowvals[p];
+      lo = prec->colPtr[j];
+      hi = prec->colPtr[j+1] - 1;
+      while (lo <= hi) {
+        mid = (lo + hi) / 2;
+        if (prec->rowIdx[mid] < row) {
+          lo = mid + 1;
+        } else if (prec->rowIdx[mid] > row) {
+          hi = mid - 1;
+        } else {
+          prec->jac[mid] += values[p];
+          break;
+        }
+      }
+    }
+  }
+
+  prec->cjJac = cj;
+  prec->nSinceJac = 0;
+  prec->hasJac = TRUE;
+  prec->nJacEvals++;
+}
+
+/**
+ * @brief Diagonal correction for a lagged Jacobian.
+ */
+static double diagonalShift(IDA_PRECONDITIONER* prec, double cj)
+{
+  return prec->shiftable ? -(cj - prec->cjJac) : 0.0;
+}
+
+static int factorBlockJacobi(IDA_PRECONDITIONER* prec, double shift)
+{
+  long int b, j, p, row, lj, size, i, k, piv;
+  double *A, tmp, maxVal;
+
+  memset(prec->blockLU, 0, prec->luPtr[prec->nBlocks]*sizeof(double));
+
+  /* scatter the block diagonal part, column major */
+  for (j = 0; j < prec->N; j++) {
+    b = prec->blockOf[j];
+    size = prec->blockPtr[b+1] - prec->blockPtr[b];
+    A = prec->blockLU + prec->luPtr[b];
+    lj = prec->localIdx[j];
+    for (p = prec->colPtr[j]; p < prec->colPtr[j+1]; p++) {
+      row = prec->rowIdx[p];
+      if (prec->blockOf[row] == b) {
+        A[prec->localIdx[row] + lj*size] = prec->jac[p] + (row == j ? shift : 0.0);
+      }
+    }
+  }
+
+  /* dense LU with partial pivoting of each block */
+  for (b = 0; b < prec->nBlocks; b++) {
+    size = prec->blockPtr[b+1] - prec->blockPtr[b];
+    A = prec->blockLU + prec->luPtr[b];
+    for (k = 0; k < size; k++) {
+      piv = k;
+      maxVal = fabs(A[k + k*size]);
+      for (i = k+1; i < size; i++) {
+        if (fabs(A[i + k*size]) > maxVal) {
+          maxVal = fabs(A[i + k*size]);
+          piv = i;
+        }
+      }
+      prec->pivots[prec->blockPtr[b] + k] = piv;
+      if (maxVal == 0.0) {
+        return 1;
+      }
+      if (piv != k) {
+        for (j = 0; j < size; j++) {
+          tmp = A[k + j*size];
+          A[k + j*size] = A[piv + j*size];
+          A[piv + j*size] = tmp;
+        }
+      }
+      for (i = k+1; i < size; i++) {
+        A[i + k*size] /= A[k + k*size];
+      }
+      for (j = k+1; j < size; j++) {
+        tmp = A[k + j*size];
+        if (tmp != 0.0) {
+          for (i = k+1; i < size; i++) {
+            A[i + j*size] -= A[i + k*size] * tmp;
+          }
+        }
+      }
+    }
+  }
+  return 0;
+}
+
+static int factorILU0(IDA_PRECONDITIONER* prec, double shift)
+{
+  long int i, k, p, q, j;
+  double *lu = prec->lu;
+
+  for (j = 0; j < prec->N; j++) {
+    for (p = prec->colPtr[j]; p < prec->colPtr[j+1]; p++) {
+      lu[prec->cscToCsr[p]] = prec->jac[p] + (prec->rowIdx[p] == j ? shift : 0.0);
+    }
+  }
+
+  /* IKJ variant restricted to the pattern */
+  for (i = 0; i < prec->N; i++) {
+    for (p = prec->rowPtr[i]; p < prec->rowPtr[i+1]; p++) {
+      prec->iw[prec->csrCol[p]] = p;
+    }
+    for (p = prec->rowPtr[i]; p < prec->csrDiag[i]; p++) {
+      /* the pivots of the previous rows are non-zero */
+      k = prec->csrCol[p];
+      lu[p] /= lu[prec->csrDiag[k]];
+      for (q = prec->csrDiag[k]+1; q < prec->rowPtr[k+1]; q++) {
+        if (prec->iw[prec->csrCol[q]] >= 0) {
+          lu[prec->iw[prec->csrCol[q]]] -= lu[p] * lu[q];
+        }
+      }
+    }
+    for (p = prec->rowPtr[i]; p < prec->rowPtr[i+1]; p++) {
+      prec->iw[prec->csrCol[p]] = -1;
+    }
+    if (lu[prec->csrDiag[i]] == 0.0) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * @brief Preconditioner setup for the current cj.
+ *
+ * Re-factorizes the stored Jacobian, shifted to the current cj in ODE mode.
+ * A lagged Jacobian in DAE mode keeps its previous factorization.
+ *
+ * @param prec    Preconditioner data.
+ * @param cj      Current scalar cj of IDA.
+ * @return        0 on success, 1 (recoverable) on a zero pivot.
+ */
+int idaPrecSetup(IDA_PRECONDITIONER* prec, double cj)
+{
+  int flag;
+  modelica_boolean lagged = prec->nSinceJac > 0;
+
+  prec->nSetups++;
+  prec->nSinceJac++;
+  if (lagged) {
+    prec->nReuses++;
+    if (!prec->shiftable && prec->hasFactor) {
+      return 0;
+    }
+  }
+
+  if (prec->method == IDA_PREC_BLOCK_JACOBI) {
+    flag = factorBlockJacobi(prec, diagonalShift(prec, cj));
+  } else {
+    flag = factorILU0(prec, diagonalShift(prec, cj));
+  }
+  prec->nFactorizations++;
+  prec->hasFactor = (flag == 0);
+  if (flag) {
+    prec->nFailures++;
+    /* force a new Jacobian on the retry */
+    prec->hasJac = FALSE;
+    infoStreamPrint(LOG_SOLVER_V, 0, "##IDA## Preconditioner factorization failed with a zero pivot.");
+  }
+  return flag;
+}
+
+/**
+ * @brief Solve P*z = r with the factorized preconditioner.
+ *
+ * @param prec    Preconditioner data.
+ * @param r       Right hand side.
+ * @param z       Output solution, may not alias r.
+ */
+void idaPrecSolve(IDA_PRECONDITIONER* prec, const double* r, double* z)
+{
+  long int b, i, k, p, size, start;
+  double *A, *x, tmp;
+
+  prec->nSolves++;
+
+  if (prec->method == IDA_PREC_BLOCK_JACOBI) {
+    for (b = 0; b < prec->nBlocks; b++) {
+      start = prec->blockPtr[b];
+      size = prec->blockPtr[b+1] - start;
+      A = prec->blockLU + prec->luPtr[b];
+      x = prec->work + start;
+      for (i = 0; i < size; i++) {
+        x[i] = r[prec->perm[start + i]];
+      }
+      /* apply row interchanges and forward substitution */
+      for (k = 0; k < size; k++) {
+        p = prec->pivots[start + k];
+        if (p != k) {
+          tmp = x[k];
+          x[k] = x[p];
+          x[p] = tmp;
+        }
+        for (i = k+1; i < size; i++) {
+          x[i] -= A[i + k*size] * x[k];
+        }
+      }
+      /* backward substitution */
+      for (k = size-1; k >= 0; k--) {
+        x[k] /= A[k + k*size];
+        for (i = 0; i < k; i++) {
+          x[i] -= A[i + k*size] * x[k];
+        }
+      }
+      for (i = 0; i < size; i++) {
+        z[prec->perm[start + i]] = x[i];
+      }
+    }
+  } else {
+    /* L has unit diagonal */
+    for (i = 0; i < prec->N; i++) {
+      tmp = r[i];
+      for (p = prec->rowPtr[i]; p < prec->csrDiag[i]; p++) {
+        tmp -= prec->lu[p] * z[prec->csrCol[p]];
+      }
+      z[i] = tmp;
+    }
+    for (i = prec->N-1; i >= 0; i--) {
+      tmp = z[i];
+      for (p = prec->csrDiag[i]+1; p < prec->rowPtr[i+1]; p++) {
+        tmp -= prec->lu[p] * z[prec->csrCol[p]];
+      }
+      z[i] = tmp / prec->lu[prec->csrDiag[i]];
+    }
+  }
+}
+
+#endif /* WITH_SUNDIALS */
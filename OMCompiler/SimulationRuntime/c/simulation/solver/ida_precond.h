@@ -0,0 +1,115 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-2024, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/*! \file ida_precond.h
+ *
+ * Preconditioners for the iterative linear solvers (SPGMR, SPBCGS, SPTFQMR)
+ * of IDA, built on the sparsity pattern of the IDA Jacobian.
+ */
+
+#ifndef OMC_IDA_PRECOND_H
+#define OMC_IDA_PRECOND_H
+
+#include "simulation_data.h"
+#include "util/simulation_options.h"
+#include "omc_config.h" /* for WITH_SUNDIALS */
+
+#ifdef WITH_SUNDIALS
+
+#include <sunmatrix/sunmatrix_sparse.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Maximum size of one dense block of the block-Jacobi preconditioner.
+ * Larger strongly connected components are split into several blocks. */
+#define IDA_PREC_MAX_BLOCK_SIZE 64
+
+typedef struct IDA_PRECONDITIONER
+{
+  enum IDA_PREC method;         /* Preconditioner type */
+  int lag;                      /* Number of setups that may reuse one Jacobian evaluation */
+  long int N;                   /* Number of unknowns */
+  modelica_boolean shiftable;   /* TRUE if the Jacobian has the form df/dy - cj*I and can be re-shifted */
+
+  /* Jacobian on the fixed pattern (sparsity pattern plus diagonal), CSC with sorted rows */
+  long int nnz;
+  long int *colPtr;
+  long int *rowIdx;
+  double *jac;                  /* Last evaluated Jacobian */
+  double cjJac;                 /* cj the last Jacobian was evaluated with */
+  int nSinceJac;                /* Number of setups since the last Jacobian evaluation */
+  modelica_boolean hasJac;
+  modelica_boolean hasFactor;
+
+  /* Block-Jacobi: dense LU of the diagonal blocks */
+  long int nBlocks;
+  long int *blockPtr;           /* Start of block b in perm, size nBlocks+1 */
+  long int *perm;               /* Unknowns sorted by block */
+  long int *blockOf;            /* Block of each unknown */
+  long int *localIdx;           /* Position of each unknown inside its block */
+  long int *luPtr;              /* Start of dense block b in blockLU, size nBlocks+1 */
+  double *blockLU;
+  long int *pivots;             /* Row pivots, indexed like perm */
+  double *work;
+
+  /* ILU(0): CSR copy of the pattern */
+  long int *rowPtr;
+  long int *csrCol;
+  long int *csrDiag;            /* Position of the diagonal element in each row */
+  long int *cscToCsr;           /* Map from CSC index to CSR index */
+  long int *iw;                 /* Column marker used during the factorization */
+  double *lu;
+
+  /* Statistics */
+  long int nSetups;             /* Calls of the preconditioner setup */
+  long int nJacEvals;           /* Jacobian evaluations for the preconditioner */
+  long int nReuses;             /* Setups reusing a lagged Jacobian */
+  long int nFactorizations;     /* Numerical factorizations */
+  long int nSolves;             /* Preconditioner solves */
+  long int nFailures;           /* Setups failing with a singular pivot */
+} IDA_PRECONDITIONER;
+
+IDA_PRECONDITIONER* idaPrecAllocate(enum IDA_PREC method, int lag, long int N, SPARSE_PATTERN* sparsePattern, modelica_boolean shiftable);
+void idaPrecFree(IDA_PRECONDITIONER* prec);
+
+modelica_boolean idaPrecNeedsJacobian(IDA_PRECONDITIONER* prec);
+void idaPrecSetJacobian(IDA_PRECONDITIONER* prec, SUNMatrix A, double cj);
+int idaPrecSetup(IDA_PRECONDITIONER* prec, double cj);
+void idaPrecSolve(IDA_PRECONDITIONER* prec, const double* r, double* z);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WITH_SUNDIALS */
+
+#endif /* OMC_IDA_PRECOND_H */
@@ -87,6 +87,14 @@ static int callSparseJacobian(realtype currentTime, realtype cj,
 static int residualFunctionIDA(double time, N_Vector yy, N_Vector yp, N_Vector res, void* user_data);
 static int rootsFunctionIDA(double time, N_Vector yy, N_Vector yp, double *gout, void* userData);
 
+static int idaPrecSetupFunction(realtype tt, N_Vector yy, N_Vector yp, N_Vector rr,
+                                realtype cj, void *user_data);
+static int idaPrecSolveFunction(realtype tt, N_Vector yy, N_Vector yp, N_Vector rr,
+                                N_Vector rvec, N_Vector zvec, realtype cj,
+                                realtype delta, void *user_data);
+
+static void idaCollectLinearSolverStats(IDA_SOLVER *idaData, modelica_boolean reinit);
+
 static int getScalingFactors(DATA* data, IDA_SOLVER *idaData, SUNMatrix scaleMatrix);
 
 static void idaScaleData(IDA_SOLVER *idaData);
@@ -98,7 +106,7 @@ int ida_event_update(DATA* data, threadData_t *threadData);
 
 /* Static variables */
 /* TODO: Don't use global variables */
-static IDA_SOLVER *idaDataGlobal;
+static OMC_THREAD_LOCAL IDA_SOLVER *idaDataGlobal;
 
 
 /**
@@ -348,6 +356,34 @@ int ida_solver_initial(DATA* data, threadData_t *threadData,
     idaData->linearSolverMethod = IDA_LS_KLU;
   }
 
+  /* if FLAG_IDA_PREC is set, choose preconditioner of the iterative linear solvers */
+  idaData->precMethod = IDA_PREC_NONE;
+  if (omc_flag[FLAG_IDA_PREC]) {
+    idaData->precMethod = IDA_PREC_UNKNOWN;
+    for (i=1; i< IDA_PREC_MAX; i++) {
+      if (!strcmp((const char*)omc_flagValue[FLAG_IDA_PREC], IDA_PREC_METHOD[i])) {
+        idaData->precMethod = (enum IDA_PREC)i;
+        break;
+      }
+    }
+    if (idaData->precMethod == IDA_PREC_UNKNOWN) {
+      if (ACTIVE_WARNING_STREAM(LOG_SOLVER)) {
+        warningStreamPrint(LOG_SOLVER, 1, "unrecognized ida preconditioner %s, current options are:", (const char*)omc_flagValue[FLAG_IDA_PREC]);
+        for(i=1; i < IDA_PREC_MAX; ++i) {
+          warningStreamPrint(LOG_SOLVER, 0, "%-15s [%s]", IDA_PREC_METHOD[i], IDA_PREC_METHOD_DESC[i]);
+        }
+        messageClose(LOG_SOLVER);
+      }
+      throwStreamPrint(threadData,"unrecognized ida preconditioner %s", (const char*)omc_flagValue[FLAG_IDA_PREC]);
+    }
+    if (idaData->precMethod != IDA_PREC_NONE && idaData->linearSolverMethod != IDA_LS_SPGMR &&
+        idaData->linearSolverMethod != IDA_LS_SPBCG && idaData->linearSolverMethod != IDA_LS_SPTFQMR) {
+      warningStreamPrint(LOG_STDOUT, 0, "The ida preconditioner \"%s\" is only used by the iterative linear solvers"
+                                        " and is ignored for \"%s\".", IDA_PREC_METHOD[idaData->precMethod], IDA_LS_METHOD[idaData->linearSolverMethod]);
+      idaData->precMethod = IDA_PREC_NONE;
+    }
+  }
+
   ANALYTIC_JACOBIAN* jacobian = &(data->simulationInfo->analyticJacobians[data->callback->INDEX_JAC_A]);
   data->callback->initialAnalyticJacobianA(data, threadData, jacobian);
   if(jacobian->availability == JACOBIAN_AVAILABLE || jacobian->availability == JACOBIAN_ONLY_SPARSITY) {
@@ -366,6 +402,16 @@ int ida_solver_initial(DATA* data, threadData_t *threadData,
   }
   idaData->jacobianMethod = setJacobianMethod(threadData, jacobian->availability, flagValue);
 
+  /* the preconditioner needs the sparsity pattern of the Jacobian */
+  if (idaData->precMethod != IDA_PREC_NONE) {
+    if (idaData->daeMode ? data->simulationInfo->daeModeData->sparsePattern == NULL
+                         : (jacobian->availability != JACOBIAN_AVAILABLE && jacobian->availability != JACOBIAN_ONLY_SPARSITY)) {
+      warningStreamPrint(LOG_STDOUT, 0, "The ida preconditioner \"%s\" needs the sparsity pattern of the Jacobian,"
+                                        " which is not available. No preconditioner will be used.", IDA_PREC_METHOD[idaData->precMethod]);
+      idaData->precMethod = IDA_PREC_NONE;
+    }
+  }
+
   // change IDA specific jacobian method
   if(idaData->jacobianMethod == SYMJAC) {
     warningStreamPrint(LOG_STDOUT, 0, "Symbolic Jacobians without coloring are currently not supported by IDA."
@@ -379,6 +425,9 @@ int ida_solver_initial(DATA* data, threadData_t *threadData,
     warningStreamPrint(LOG_STDOUT, 0, "Internal Numerical Jacobians without coloring are currently not supported by IDA with KLU."
                                       " Colored numerical Jacobian will be used.");
     idaData->jacobianMethod = COLOREDNUMJAC;
+  }else if(idaData->jacobianMethod == INTERNALNUMJAC && idaData->precMethod != IDA_PREC_NONE) {
+    infoStreamPrint(LOG_SOLVER, 0, "The ida preconditioner is computed from a colored numerical Jacobian.");
+    idaData->jacobianMethod = COLOREDNUMJAC;
   }
 
   /* Set NNZ */
@@ -391,27 +440,33 @@ int ida_solver_initial(DATA* data, threadData_t *threadData,
   switch (idaData->linearSolverMethod){
   case IDA_LS_SPGMR:
     idaData->J = NULL;
-    idaData->linSol = SUNLinSol_SPGMR(idaData->y_linSol, PREC_NONE, idaData->N);
+    idaData->linSol = SUNLinSol_SPGMR(idaData->y_linSol, idaData->precMethod == IDA_PREC_NONE ? PREC_NONE : PREC_LEFT, idaData->N);
     if (idaData->linSol == NULL) {
       throwStreamPrint(threadData, "##IDA## In function SUNLinSol_SPGMR: Input incompatible.");
     }
-    idaData->jacobianMethod = INTERNALNUMJAC;
+    if (idaData->precMethod == IDA_PREC_NONE) {
+      idaData->jacobianMethod = INTERNALNUMJAC;
+    }
     break;
   case IDA_LS_SPBCG:
     idaData->J = NULL;
-    idaData->linSol = SUNLinSol_SPBCGS(idaData->y_linSol, PREC_NONE, idaData->N);
+    idaData->linSol = SUNLinSol_SPBCGS(idaData->y_linSol, idaData->precMethod == IDA_PREC_NONE ? PREC_NONE : PREC_LEFT, idaData->N);
     if (idaData->linSol == NULL) {
       throwStreamPrint(threadData, "##IDA## In function SUNLinSol_SPBCGS: Input incompatible.");
     }
-    idaData->jacobianMethod = INTERNALNUMJAC;
+    if (idaData->precMethod == IDA_PREC_NONE) {
+      idaData->jacobianMethod = INTERNALNUMJAC;
+    }
     break;
   case IDA_LS_SPTFQMR:
     idaData->J = NULL;
-    idaData->linSol = SUNLinSol_SPTFQMR(idaData->y_linSol, PREC_NONE, idaData->N);
+    idaData->linSol = SUNLinSol_SPTFQMR(idaData->y_linSol, idaData->precMethod == IDA_PREC_NONE ? PREC_NONE : PREC_LEFT, idaData->N);
     if (idaData->linSol == NULL) {
       throwStreamPrint(threadData, "##IDA## In function SUNLinSol_SPTFQMR: Input incompatible.");
     }
-    idaData->jacobianMethod = INTERNALNUMJAC;
+    if (idaData->precMethod == IDA_PREC_NONE) {
+      idaData->jacobianMethod = INTERNALNUMJAC;
+    }
     break;
   case IDA_LS_DENSE:
     idaData->J = SUNDenseMatrix(idaData->N, idaData->N);
@@ -440,6 +495,22 @@ int ida_solver_initial(DATA* data, threadData_t *threadData,
   checkReturnFlag_SUNDIALS(flag, SUNDIALS_IDALS_FLAG, "IDASetLinearSolver");
   infoStreamPrint(LOG_SOLVER, 0, "IDA linear solver method selected %s", IDA_LS_METHOD_DESC[idaData->linearSolverMethod]);
 
+  /* Set preconditioner of the iterative linear solvers */
+  idaData->prec = NULL;
+  idaData->precJ = NULL;
+  idaData->nLinIters = idaData->nLinConvFails = 0;
+  idaData->lastLinIters = idaData->lastLinConvFails = 0;
+  if (idaData->precMethod != IDA_PREC_NONE) {
+    int precLag = omc_flag[FLAG_IDA_PREC_LAG] ? atoi(omc_flagValue[FLAG_IDA_PREC_LAG]) : 0;
+    idaData->prec = idaPrecAllocate(idaData->precMethod, precLag, idaData->N,
+                                    idaData->daeMode ? data->simulationInfo->daeModeData->sparsePattern : jacobian->sparsePattern,
+                                    !idaData->daeMode);
+    idaData->precJ = SUNSparseMatrix(idaData->N, idaData->N, idaData->NNZ + idaData->N, CSC_MAT);
+    flag = IDASetPreconditioner(idaData->ida_mem, idaPrecSetupFunction, idaPrecSolveFunction);
+    checkReturnFlag_SUNDIALS(flag, SUNDIALS_IDALS_FLAG, "IDASetPreconditioner");
+    infoStreamPrint(LOG_SOLVER, 0, "IDA preconditioner selected %s, Jacobian lag %d", IDA_PREC_METHOD_DESC[idaData->precMethod], precLag);
+  }
+
   /* Set Jacobian function */
   /* Use sparse jacobian evaluation */
   if (idaData->linearSolverMethod == IDA_LS_KLU) {
@@ -468,6 +539,15 @@ int ida_solver_initial(DATA* data, threadData_t *threadData,
       throwStreamPrint(threadData,"For the klu solver jacobian calculation method has to be %s or %s", JACOBIAN_METHOD[COLOREDSYMJAC], JACOBIAN_METHOD[COLOREDNUMJAC]);
       break;
     }
+  /* Use sparse jacobian evaluation for the preconditioner only */
+  } else if (idaData->prec != NULL) {
+    idaData->allocatedParMem = 0;   /* FALSE */
+#ifdef USE_PARJAC
+    if (idaData->jacobianMethod == COLOREDSYMJAC) {
+      allocateThreadLocalJacobians(data, &(idaData->jacColumns));
+      idaData->allocatedParMem = 1;   /* TRUE */
+    }
+#endif
   /* Use dense jacobian evaluation */
   } else {
     switch (idaData->jacobianMethod){
@@ -626,6 +706,20 @@ void ida_solver_deinitial(IDA_SOLVER *idaData)
   SUNMatDestroy(idaData->J);
   SUNLinSolFree(idaData->linSol);
 
+  /* Free preconditioner data */
+  if (idaData->prec != NULL) {
+    infoStreamPrint(LOG_STATS, 1, "IDA preconditioner (%s)", IDA_PREC_METHOD[idaData->precMethod]);
+    infoStreamPrint(LOG_STATS, 0, "%5ld setups (%ld with lagged Jacobian)", idaData->prec->nSetups, idaData->prec->nReuses);
+    infoStreamPrint(LOG_STATS, 0, "%5ld Jacobian evaluations", idaData->prec->nJacEvals);
+    infoStreamPrint(LOG_STATS, 0, "%5ld factorizations (%ld failed)", idaData->prec->nFactorizations, idaData->prec->nFailures);
+    infoStreamPrint(LOG_STATS, 0, "%5ld solves", idaData->prec->nSolves);
+    infoStreamPrint(LOG_STATS, 0, "%5ld Krylov iterations", idaData->nLinIters);
+    infoStreamPrint(LOG_STATS, 0, "%5ld linear convergence failures", idaData->nLinConvFails);
+    messageClose(LOG_STATS);
+    idaPrecFree(idaData->prec);
+    SUNMatDestroy(idaData->precJ);
+  }
+
   /* Free dae-mode data */
   if (idaData->daeMode) {
     free(idaData->states);
@@ -693,6 +787,7 @@ int ida_event_update(DATA* data, threadData_t *threadData)
   memcpy(idaData->statesDer, data->localData[0]->realVars + data->modelData->nStates, sizeof(double)*data->modelData->nStates);
   memcpy(NV_DATA_S(idaData->y), idaData->states, idaData->N);
   memcpy(NV_DATA_S(idaData->yp), idaData->statesDer, idaData->N);
+  idaCollectLinearSolverStats(idaData, TRUE);
   flag = IDAReInit(idaData->ida_mem,
                     data->localData[0]->timeValue,
                     idaData->y,
@@ -767,7 +862,7 @@ int ida_solver_step(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInf
   int retVal = 0, finished = 0 /* FALSE */;
   int saveJumpState;
   long int tmp;
-  static unsigned int stepsOutputCounter = 1;
+  static OMC_THREAD_LOCAL unsigned int stepsOutputCounter = 1;
   int stepsMode;    /* Has to be IDA_NORMAL (1) or IDA_ONE_STEP (2) */
   int restartAfterLSFail = 0;
 
@@ -817,6 +912,8 @@ int ida_solver_step(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInf
       messageClose(LOG_SOLVER_V);
     }
 
+    idaCollectLinearSolverStats(idaData, TRUE);
+
     flag = IDAReInit(idaData->ida_mem,
         solverInfo->currentTime,
         idaData->y,
@@ -950,6 +1047,7 @@ int ida_solver_step(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInf
     }
     else if (flag == IDA_LSETUP_FAIL && !restartAfterLSFail)
     {
+      idaCollectLinearSolverStats(idaData, TRUE);
       flag = IDAReInit(idaData->ida_mem,
           solverInfo->currentTime,
           idaData->y,
@@ -974,6 +1072,7 @@ int ida_solver_step(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInf
       }
       else if (flag == IDA_LSETUP_FAIL && !restartAfterLSFail )
       {
+        idaCollectLinearSolverStats(idaData, TRUE);
         flag = IDAReInit(idaData->ida_mem,
             solverInfo->currentTime,
             idaData->y,
@@ -1077,6 +1176,9 @@ int ida_solver_step(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInf
   checkReturnFlag_SUNDIALS(flag, SUNDIALS_IDA_FLAG, "IDAGetNumNonlinSolvConvFails");
   solverInfo->solverStatsTmp.nConvergenveTestFailures = tmp;
 
+  /* Krylov iterations, accumulated over reinitializations */
+  idaCollectLinearSolverStats(idaData, FALSE);
+
   /* get more statistics */
   if (useStream[LOG_SOLVER_V])
   {
@@ -1097,6 +1199,17 @@ int ida_solver_step(DATA* data, threadData_t *threadData, SOLVER_INFO* solverInf
     flag = IDAGetNumLinSolvSetups(idaData->ida_mem, &tmp1);
     infoStreamPrint(LOG_SOLVER_V, 0, " ## Number of calls made to the linear solver setup function: %ld", tmp1);
 
+    /* iterative linear solver stats */
+    if (idaData->linearSolverMethod == IDA_LS_SPGMR || idaData->linearSolverMethod == IDA_LS_SPBCG || idaData->linearSolverMethod == IDA_LS_SPTFQMR) {
+      infoStreamPrint(LOG_SOLVER_V, 0, " ## Cumulative number of Krylov iterations: %ld", idaData->nLinIters);
+      infoStreamPrint(LOG_SOLVER_V, 0, " ## Cumulative number of linear convergence failures: %ld", idaData->nLinConvFails);
+    }
+    if (idaData->prec != NULL) {
+      infoStreamPrint(LOG_SOLVER_V, 0, " ## Number of preconditioner setups: %ld (%ld with lagged Jacobian)", idaData->prec->nSetups, idaData->prec->nReuses);
+      infoStreamPrint(LOG_SOLVER_V, 0, " ## Number of preconditioner Jacobian evaluations: %ld", idaData->prec->nJacEvals);
+      infoStreamPrint(LOG_SOLVER_V, 0, " ## Number of preconditioner solves: %ld", idaData->prec->nSolves);
+    }
+
     messageClose(LOG_SOLVER_V);
   }
 
@@ -1839,6 +1952,7 @@ static int callSparseJacobian(double currentTime, double cj,
   threadData_t* threadData = (threadData_t*)(((IDA_USERDATA*)((IDA_SOLVER*)user_data)->userData)->threadData);
   int i;
   int flag;
+  int retVal = 0;
 
   /* profiling */
   if (measure_time_flag) rt_accumulate(SIM_TIMER_SOLVER);
@@ -1846,11 +1960,11 @@ static int callSparseJacobian(double currentTime, double cj,
 
   if (idaData->jacobianMethod == COLOREDSYMJAC || idaData->jacobianMethod == SYMJAC)
   {
-    jacColoredSymbolicalSparse(currentTime, yy, yp, rr, Jac, cj, user_data);
+    retVal = jacColoredSymbolicalSparse(currentTime, yy, yp, rr, Jac, cj, user_data);
   }
   else if (idaData->jacobianMethod == COLOREDNUMJAC || idaData->jacobianMethod == NUMJAC)
   {
-    jacoColoredNumericalSparse(currentTime, yy, yp, rr, Jac, cj, user_data);
+    retVal = jacoColoredNumericalSparse(currentTime, yy, yp, rr, Jac, cj, user_data);
   }
 
   /* debug */
@@ -1873,9 +1987,84 @@ static int callSparseJacobian(double currentTime, double cj,
   if (measure_time_flag) rt_tick(SIM_TIMER_SOLVER);
 
   TRACE_POP
+  return retVal;
+}
+
+
+/**
+ * @brief Setup of the preconditioner for the iterative linear solvers.
+ *
+ * This function has to be of type IDALsPrecSetupFn.
+ * Evaluates a new sparse Jacobian unless a lagged one may be reused and
+ * factorizes the preconditioner.
+ *
+ * @return int        Return 0 on success, positive value on recoverable error.
+ */
+static int idaPrecSetupFunction(realtype tt, N_Vector yy, N_Vector yp, N_Vector rr,
+                                realtype cj, void *user_data)
+{
+  TRACE_PUSH
+  IDA_SOLVER* idaData = (IDA_SOLVER*)user_data;
+  int flag;
+
+  if (idaPrecNeedsJacobian(idaData->prec)) {
+    if (callSparseJacobian(tt, cj, yy, yp, rr, idaData->precJ, user_data, NULL, NULL, NULL)) {
+      TRACE_POP
+      return 1;
+    }
+    idaPrecSetJacobian(idaData->prec, idaData->precJ, cj);
+  }
+
+  if (measure_time_flag) rt_accumulate(SIM_TIMER_SOLVER);
+  rt_tick(SIM_TIMER_JACOBIAN);
+  flag = idaPrecSetup(idaData->prec, cj);
+  rt_accumulate(SIM_TIMER_JACOBIAN);
+  if (measure_time_flag) rt_tick(SIM_TIMER_SOLVER);
+
+  TRACE_POP
+  return flag;
+}
+
+/**
+ * @brief Solve P*z = r with the preconditioner of the iterative linear solvers.
+ *
+ * This function has to be of type IDALsPrecSolveFn.
+ *
+ * @return int        Return 0 on success.
+ */
+static int idaPrecSolveFunction(realtype tt, N_Vector yy, N_Vector yp, N_Vector rr,
+                                N_Vector rvec, N_Vector zvec, realtype cj,
+                                realtype delta, void *user_data)
+{
+  IDA_SOLVER* idaData = (IDA_SOLVER*)user_data;
+
+  idaPrecSolve(idaData->prec, N_VGetArrayPointer_Serial(rvec), N_VGetArrayPointer_Serial(zvec));
+
   return 0;
 }
 
+/**
+ * @brief Accumulate Krylov iterations and linear convergence failures.
+ *
+ * IDAReInit resets the counters of the linear solver interface, so they are
+ * collected before every reinitialization.
+ *
+ * @param idaData   Pointer to IDA solver data struct.
+ * @param reinit    TRUE if IDAReInit is called next.
+ */
+static void idaCollectLinearSolverStats(IDA_SOLVER *idaData, modelica_boolean reinit)
+{
+  long int linIters = 0, linConvFails = 0;
+
+  IDAGetNumLinIters(idaData->ida_mem, &linIters);
+  IDAGetNumLinConvFails(idaData->ida_mem, &linConvFails);
+
+  idaData->nLinIters += linIters - idaData->lastLinIters;
+  idaData->nLinConvFails += linConvFails - idaData->lastLinConvFails;
+  idaData->lastLinIters = reinit ? 0 : linIters;
+  idaData->lastLinConvFails = reinit ? 0 : linConvFails;
+}
+
 
 /* TODO: Unify with nlsKinsolFScaling from kinsolSolver.c? */
 static int getScalingFactors(DATA* data, IDA_SOLVER* idaData, SUNMatrix inScaleMatrix)
@@ -38,6 +38,7 @@
 #include "simulation_data.h"
 #include "util/simulation_options.h"
 #include "simulation/solver/solver_main.h"
+#include "simulation/solver/ida_precond.h"
 #include "omc_config.h" /* for WITH_SUNDIALS */
 
 #ifdef WITH_SUNDIALS
@@ -101,6 +102,15 @@ typedef struct IDA_SOLVER
   SUNMatrix J;              /* Sparse matrix template for cloning matrices needed within
                                linear solver */
 
+  /* preconditioner data of the iterative linear solvers */
+  enum IDA_PREC precMethod;     /* specifies the preconditioner of the iterative linear solvers */
+  IDA_PRECONDITIONER* prec;     /* Preconditioner, NULL if not used */
+  SUNMatrix precJ;              /* Sparse Jacobian the preconditioner is computed from */
+  long int nLinIters;           /* Cumulative number of Krylov iterations */
+  long int nLinConvFails;       /* Cumulative number of linear convergence failures */
+  long int lastLinIters;        /* Krylov iterations counted by IDA since the last IDAReInit */
+  long int lastLinConvFails;    /* Linear convergence failures counted by IDA since the last IDAReInit */
+
   /* ### daeMode ### */
   booleantype daeMode;      /* If TRUE then solve dae more with a reals residual function */
   long int N;               /* Number of unknowns */
@@ -277,8 +277,8 @@ static int symbolic_initialization(DATA *data, threadData_t *threadData)
   }
 #endif
   /* useHomotopy=1: global homotopy (equidistant lambda) */
-  if (data->callback->useHomotopy == 1 && omc_flag[FLAG_HOMOTOPY_ON_FIRST_TRY] != 1 && omc_flag[FLAG_NO_HOMOTOPY_ON_FIRST_TRY] != 1) {
-      omc_flag[FLAG_HOMOTOPY_ON_FIRST_TRY] = 1;
+  if (data->callback->useHomotopy == 1 && data->simulationInfo->homotopyOnFirstTry != 1 && omc_flag[FLAG_NO_HOMOTOPY_ON_FIRST_TRY] != 1) {
+      data->simulationInfo->homotopyOnFirstTry = 1;
       infoStreamPrint(LOG_INIT_HOMOTOPY, 0, "Model contains homotopy operator: Use adaptive homotopy method to solve initialization problem. "
                                             "To disable initialization with homotopy operator use \"-noHomotopyOnFirstTry\".");
   }
@@ -303,7 +303,7 @@ static int symbolic_initialization(DATA *data, threadData_t *threadData)
      TRY TO SOLVE WITHOUT HOMOTOPY FIRST.
      TO-DO: For the adaptive global approach, provide a separate DAE with
      the original unmanipulated systems for trying without homotopy */
-  } else if (!omc_flag[FLAG_HOMOTOPY_ON_FIRST_TRY]) {
+  } else if (!data->simulationInfo->homotopyOnFirstTry) {
     /* try */
 #ifndef OMC_EMCC
   MMC_TRY_INTERNAL(simulationJumpBuffer)
@@ -328,7 +328,7 @@ static int symbolic_initialization(DATA *data, threadData_t *threadData)
     if(solveWithGlobalHomotopy) {
       if (!kinsol)
         warningStreamPrint(LOG_ASSERT, 0, "Failed to solve the initialization problem without homotopy method. If homotopy is available the homotopy method is used now.");
-      omc_flag[FLAG_HOMOTOPY_ON_FIRST_TRY] = 1;
+      data->simulationInfo->homotopyOnFirstTry = 1;
       setAllParamsToStart(data);
       setAllVarsToStart(data);
       data->callback->updateBoundParameters(data, threadData);
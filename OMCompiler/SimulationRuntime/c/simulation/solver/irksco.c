@@ -538,7 +538,7 @@ int irksco_midpoint_rule(DATA* data, threadData_t* threadData, SOLVER_INFO* solv
        * continuous system with algebraic variables.
        */
       data->callback->updateContinuousSystem(data, threadData);
-      sim_result.emit(&sim_result, data, threadData);
+      data->simResult->emit(data->simResult, data, threadData);
     }
     messageClose(LOG_SOLVER);
   }
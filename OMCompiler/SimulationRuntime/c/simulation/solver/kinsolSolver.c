@@ -34,6 +34,7 @@
 #include "kinsolSolver.h"
 
 #include "nonlinearSystem.h"
+#include "nonlinearWorkspace.h"
 #include "omc_config.h"
 #include "omc_math.h"
 #include "simulation/options.h"
@@ -210,6 +211,41 @@ void resetKinsolMemory(NLS_KINSOL_DATA *kinsolData) {
   nlsKinsolConfigSetup(kinsolData);
 }
 
+/**
+ * @brief Workspace needed by nlsKinsolAllocate.
+ *
+ * Memory of the KINSOL object, the linear solver and the matrices is
+ * allocated by SUNDIALS.
+ *
+ * @param size      Size of non-linear problem.
+ * @return size_t   Size in bytes.
+ */
+size_t nlsKinsolWorkspaceSize(int size) {
+  return nlsWorkspaceBytes(1, sizeof(NLS_KINSOL_DATA)) + 8*nlsWorkspaceBytes(size, sizeof(double));
+}
+
+/**
+ * @brief N_Vector of length size on memory from workspace.
+ *
+ * @param workspace   Workspace, can be NULL.
+ * @param size        Length of vector.
+ * @return N_Vector   Vector, free with nlsKinsolFreeVector.
+ */
+static N_Vector nlsKinsolNewVector(NLS_WORKSPACE* workspace, int size) {
+  return N_VMake_Serial(size, (double*) nlsWorkspaceCalloc(workspace, size, sizeof(double)));
+}
+
+/**
+ * @brief Free vector created with nlsKinsolNewVector.
+ *
+ * @param workspace   Workspace used in nlsKinsolNewVector.
+ * @param v           Vector.
+ */
+static void nlsKinsolFreeVector(NLS_WORKSPACE* workspace, N_Vector v) {
+  nlsWorkspaceRelease(workspace, NV_DATA_S(v));
+  N_VDestroy_Serial(v);
+}
+
 /**
  * @brief Allocate memory for kinsol solver data and initialize KINSOL solver.
  *
@@ -220,7 +256,8 @@ void resetKinsolMemory(NLS_KINSOL_DATA *kinsolData) {
  */
 NLS_KINSOL_DATA* nlsKinsolAllocate(int size, NLS_USERDATA* userData, modelica_boolean attemptRetry) {
   /* Allocate system data */
-  NLS_KINSOL_DATA *kinsolData = (NLS_KINSOL_DATA *)calloc(1, sizeof(NLS_KINSOL_DATA));
+  NLS_WORKSPACE* workspace = getNlsWorkspace(userData);
+  NLS_KINSOL_DATA *kinsolData = (NLS_KINSOL_DATA *)nlsWorkspaceCalloc(workspace, 1, sizeof(NLS_KINSOL_DATA));
 
   kinsolData->size = size;
   kinsolData->linearSolverMethod = userData->nlsData->nlsLinearSolver;
@@ -233,19 +270,28 @@ NLS_KINSOL_DATA* nlsKinsolAllocate(int size, NLS_USERDATA* userData, modelica_bo
   kinsolData->nominalJac = 0; /* calculate for scaling the scaled matrix */
   kinsolData->attemptRetry = attemptRetry;
 
-  kinsolData->initialGuess = N_VNew_Serial(size);
-  kinsolData->xScale = N_VNew_Serial(size);
-  kinsolData->fScale = N_VNew_Serial(size);
-  kinsolData->fRes = N_VNew_Serial(size);
-  kinsolData->fTmp = N_VNew_Serial(size);
+  kinsolData->initialGuess = nlsKinsolNewVector(workspace, size);
+  kinsolData->xScale = nlsKinsolNewVector(workspace, size);
+  kinsolData->fScale = nlsKinsolNewVector(workspace, size);
+  kinsolData->fRes = nlsKinsolNewVector(workspace, size);
+  kinsolData->fTmp = nlsKinsolNewVector(workspace, size);
+  kinsolData->tmp1 = nlsKinsolNewVector(workspace, size);
+  kinsolData->tmp2 = nlsKinsolNewVector(workspace, size);
 
-  kinsolData->y = N_VNew_Serial(size);
+  kinsolData->y = nlsKinsolNewVector(workspace, size);
 
   kinsolData->kinsolMemory = NULL;
   kinsolData->userData = userData;
 
   resetKinsolMemory(kinsolData);
 
+  /* Jacobian for f scaling, see nlsKinsolFScaling */
+  if (userData->nlsData->isPatternAvailable && kinsolData->linearSolverMethod == NLS_LS_KLU) {
+    kinsolData->scalingJac = SUNSparseMatrix(size, size, kinsolData->nnz, CSC_MAT);
+  } else {
+    kinsolData->scalingJac = SUNDenseMatrix(size, size);
+  }
+
   return kinsolData;
 }
 
@@ -257,21 +303,26 @@ NLS_KINSOL_DATA* nlsKinsolAllocate(int size, NLS_USERDATA* userData, modelica_bo
  * @param kinsolData    Pointer to KINSOL data.
  */
 void nlsKinsolFree(NLS_KINSOL_DATA* kinsolData) {
+  NLS_WORKSPACE* workspace = getNlsWorkspace(kinsolData->userData);
+
   KINFree((void *)&kinsolData->kinsolMemory);
 
-  N_VDestroy_Serial(kinsolData->initialGuess);
-  N_VDestroy_Serial(kinsolData->xScale);
-  N_VDestroy_Serial(kinsolData->fScale);
-  N_VDestroy_Serial(kinsolData->fRes);
-  N_VDestroy_Serial(kinsolData->fTmp);
+  nlsKinsolFreeVector(workspace, kinsolData->initialGuess);
+  nlsKinsolFreeVector(workspace, kinsolData->xScale);
+  nlsKinsolFreeVector(workspace, kinsolData->fScale);
+  nlsKinsolFreeVector(workspace, kinsolData->fRes);
+  nlsKinsolFreeVector(workspace, kinsolData->fTmp);
+  nlsKinsolFreeVector(workspace, kinsolData->tmp1);
+  nlsKinsolFreeVector(workspace, kinsolData->tmp2);
+  SUNMatDestroy(kinsolData->scalingJac);
 
   /* Free linear solver data */
   SUNLinSolFree(kinsolData->linSol);
   SUNMatDestroy(kinsolData->J);
-  N_VDestroy_Serial(kinsolData->y);
+  nlsKinsolFreeVector(workspace, kinsolData->y);
 
   freeNlsUserData(kinsolData->userData);
-  free(kinsolData);
+  nlsWorkspaceRelease(workspace, kinsolData);
 
   return;
 }
@@ -791,7 +842,7 @@ static void nlsKinsolXScaling(DATA *data, NLS_KINSOL_DATA *kinsolData,
   int i;
 
   /* if noScaling flag is used overwrite mode */
-  if (omc_flag[FLAG_NO_SCALING]) {
+  if (data->simulationInfo->nlsNoScaling) {
     mode = SCALING_ONES;
   }
 
@@ -828,78 +879,73 @@ static void nlsKinsolFScaling(DATA *data, NLS_KINSOL_DATA *kinsolData,
                               NONLINEAR_SYSTEM_DATA *nlsData,
                               scalingMode mode) {
   double *fScaling = NV_DATA_S(kinsolData->fScale);
+  double *xScaling = NV_DATA_S(kinsolData->xScale);
   N_Vector x = kinsolData->initialGuess;
-  SUNMatrix spJac;
-  SUNMatrix denseJac;
-  N_Vector tmp1, tmp2;
+  SUNMatrix spJac = kinsolData->scalingJac;
+  SUNMatrix denseJac = kinsolData->scalingJac;
+  double absJ;
 
   int i, j;
 
   /* If noScaling flag is used overwrite mode */
-  if (omc_flag[FLAG_NO_SCALING]) {
+  if (data->simulationInfo->nlsNoScaling) {
     mode = SCALING_ONES;
   }
 
   /* Use nominal value or the actual working point for scaling */
   switch (mode) {
   case SCALING_JACOBIAN:
-    tmp1 = N_VNew_Serial(kinsolData->size);
-    tmp2 = N_VNew_Serial(kinsolData->size);
+    for (i = 0; i < nlsData->size; i++) {
+      fScaling[i] = 1e-12;
+    }
 
     /* Enable scaled jacobian evaluation */
     kinsolData->nominalJac = 1;
 
-    /* Calculate the scaled Jacobian */
+    /* Row maxima of the scaled Jacobian */
     if (nlsData->isPatternAvailable && kinsolData->linearSolverMethod == NLS_LS_KLU) {
-      spJac = SUNSparseMatrix(kinsolData->size, kinsolData->size,kinsolData->nnz, CSC_MAT);
       if (kinsolData->solved != NLS_SOLVED) {
         kinsolData->nominalJac = 0;
         if (nlsData->analyticalJacobianColumn != NULL) {
           /* Calculate the sparse Jacobian symbolically  */
-          nlsSparseSymJac(x, kinsolData->fTmp, spJac, kinsolData->userData, tmp1, tmp2);
+          nlsSparseSymJac(x, kinsolData->fTmp, spJac, kinsolData->userData, kinsolData->tmp1, kinsolData->tmp2);
         } else {
           /* Update f(x) for the numerical jacobian matrix */
           nlsKinsolResiduals(x, kinsolData->fTmp, kinsolData->userData);
-          nlsSparseJac(x, kinsolData->fTmp, spJac, kinsolData->userData, tmp1, tmp2);
+          nlsSparseJac(x, kinsolData->fTmp, spJac, kinsolData->userData, kinsolData->tmp1, kinsolData->tmp2);
         }
         /* Copy the sparse Jacobian into the kinsol data structure for later use*/
         SUNMatCopy_Sparse(spJac, kinsolData->J);
       }
-      /* Scale the current Jacobian */
-      spJac = _omc_SUNSparseMatrixVecScaling(kinsolData->J, kinsolData->xScale);
+      /* Scale the columns of the current Jacobian */
+      for (j = 0; j < SM_NP_S(kinsolData->J); j++) {
+        for (i = SM_INDEXPTRS_S(kinsolData->J)[j]; i < SM_INDEXPTRS_S(kinsolData->J)[j+1]; i++) {
+          absJ = fabs(SM_DATA_S(kinsolData->J)[i]/xScaling[j]);
+          if (fScaling[SM_INDEXVALS_S(kinsolData->J)[i]] < absJ) {
+            fScaling[SM_INDEXVALS_S(kinsolData->J)[i]] = absJ;
+          }
+        }
+      }
     } else {
       /* Update f(x) for the numerical jacobian matrix */
       nlsKinsolResiduals(x, kinsolData->fTmp, kinsolData->userData);
-      denseJac = SUNDenseMatrix(kinsolData->size, kinsolData->size);
       nlsDenseJac(nlsData->size, x, kinsolData->fTmp, denseJac,
-                  kinsolData->userData, tmp1, tmp2);
-      spJac = SUNSparseFromDenseMatrix(denseJac, DBL_MIN, CSC_MAT);
-      if (spJac == NULL) {
-        errorStreamPrint(LOG_STDOUT, 0,
-                         "KINSOL: In function SUNSparseFromDenseMatrix: Requirements are "
-                         "violated, or matrix storage request cannot be satisfied.");
+                  kinsolData->userData, kinsolData->tmp1, kinsolData->tmp2);
+      for (j = 0; j < nlsData->size; j++) {
+        for (i = 0; i < nlsData->size; i++) {
+          absJ = fabs(SM_ELEMENT_D(denseJac, i, j));
+          if (fScaling[i] < absJ) {
+            fScaling[i] = absJ;
+          }
+        }
       }
-      SUNMatDestroy(denseJac);
     }
 
     /* Disable scaled Jacobian evaluation */
     kinsolData->nominalJac = 0;
 
-    for (i = 0; i < nlsData->size; i++) {
-      fScaling[i] = 1e-12;
-    }
-    for (i = 0; i < SM_NNZ_S(spJac); ++i) {
-      if (fScaling[SM_INDEXVALS_S(spJac)[i]] < fabs(SM_DATA_S(spJac)[i])) {
-        fScaling[SM_INDEXVALS_S(spJac)[i]] = fabs(SM_DATA_S(spJac)[i]);
-      }
-    }
     /* inverse fScale */
     N_VInv(kinsolData->fScale, kinsolData->fScale);
-
-    /* Free memory */
-    SUNMatDestroy(spJac);
-    N_VDestroy_Serial(tmp1);
-    N_VDestroy_Serial(tmp2);
     break;
   case SCALING_ONES:
     for (i = 0; i < nlsData->size; i++) {
@@ -1225,6 +1271,10 @@ NLS_SOLVER_STATUS nlsKinsolSolve(DATA* data, threadData_t* threadData, NONLINEAR
 
 #else /* WITH_SUNDIALS */
 
+size_t nlsKinsolWorkspaceSize(int size) {
+  return 0;
+}
+
 void* nlsKinsolAllocate(int size, void* userData, int attemptRetry) {
 
   throwStreamPrint(NULL, "No sundials/kinsol support activated.");
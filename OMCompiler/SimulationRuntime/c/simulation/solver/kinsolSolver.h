@@ -92,6 +92,10 @@ typedef struct NLS_KINSOL_DATA {
   N_Vector fScale;
   N_Vector fRes;
   N_Vector fTmp;
+  N_Vector tmp1;                       /* work vectors for the Jacobian in f scaling */
+  N_Vector tmp2;
+  SUNMatrix scalingJac;                /* Jacobian for f scaling, sparse for KLU with
+                                          sparsity pattern, dense otherwise */
 
   int iflag;
   long countResCalls;                  /* case of sparse function not avaiable */
@@ -113,6 +117,7 @@ typedef struct NLS_KINSOL_DATA {
 
 } NLS_KINSOL_DATA;
 
+size_t nlsKinsolWorkspaceSize(int size);
 NLS_KINSOL_DATA* nlsKinsolAllocate(int size, NLS_USERDATA* userData, modelica_boolean attemptRetry);
 void nlsKinsolFree(NLS_KINSOL_DATA* kinsolData);
 NLS_SOLVER_STATUS nlsKinsolSolve(DATA* data, threadData_t* threadData, NONLINEAR_SYSTEM_DATA* nlsData);
@@ -0,0 +1,232 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-CurrentYear, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/*! \file masked_eval.c
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "masked_eval.h"
+#include "../options.h"
+#include "../../util/omc_error.h"
+
+/*! \fn maskedEval_init
+ *
+ *  \param [out] [mask]
+ *  \param [in]  [data]
+ *  \param [in]  [deps] generated dependency table, NULL evaluates everything
+ */
+void maskedEval_init(EVAL_MASK *mask, DATA *data, const EQUATION_DEPENDENCIES *deps)
+{
+  MODEL_DATA *mData = data->modelData;
+
+  memset(mask, 0, sizeof(EVAL_MASK));
+  if (NULL == deps || 0 == deps->nEquations || omc_flag[FLAG_NO_MASKED_EVAL]) {
+    return;
+  }
+  mask->deps = deps;
+  mask->dirty = (modelica_boolean*) calloc(mData->nVariablesReal+1, sizeof(modelica_boolean));
+  mask->lastRealVars = (modelica_real*) calloc(mData->nVariablesReal+1, sizeof(modelica_real));
+  mask->lastIntegerVars = (modelica_integer*) calloc(mData->nVariablesInteger+1, sizeof(modelica_integer));
+  mask->lastBooleanVars = (modelica_boolean*) calloc(mData->nVariablesBoolean+1, sizeof(modelica_boolean));
+  mask->lastRealParameter = (modelica_real*) calloc(mData->nParametersReal+1, sizeof(modelica_real));
+  mask->lastIntegerParameter = (modelica_integer*) calloc(mData->nParametersInteger+1, sizeof(modelica_integer));
+  mask->lastBooleanParameter = (modelica_boolean*) calloc(mData->nParametersBoolean+1, sizeof(modelica_boolean));
+  mask->lastRelations = (modelica_boolean*) calloc(mData->nRelations+1, sizeof(modelica_boolean));
+}
+
+void maskedEval_free(EVAL_MASK *mask)
+{
+  free(mask->dirty);
+  free(mask->lastRealVars);
+  free(mask->lastIntegerVars);
+  free(mask->lastBooleanVars);
+  free(mask->lastRealParameter);
+  free(mask->lastIntegerParameter);
+  free(mask->lastBooleanParameter);
+  free(mask->lastRelations);
+  memset(mask, 0, sizeof(EVAL_MASK));
+}
+
+/*! \fn maskedEval_invalidate
+ *
+ *  The next evaluation runs all equations, e.g. after values were changed
+ *  without a following evaluation through this mask.
+ */
+void maskedEval_invalidate(EVAL_MASK *mask)
+{
+  mask->valid = 0;
+}
+
+/* true if anything changed that is not tracked per equation */
+static modelica_boolean discreteStateChanged(EVAL_MASK *mask, DATA *data)
+{
+  MODEL_DATA *mData = data->modelData;
+  SIMULATION_DATA *sData = data->localData[0];
+  SIMULATION_INFO *sInfo = data->simulationInfo;
+
+  return memcmp(mask->lastIntegerVars, sData->integerVars, mData->nVariablesInteger*sizeof(modelica_integer))
+      || memcmp(mask->lastBooleanVars, sData->booleanVars, mData->nVariablesBoolean*sizeof(modelica_boolean))
+      || memcmp(mask->lastRealParameter, sInfo->realParameter, mData->nParametersReal*sizeof(modelica_real))
+      || memcmp(mask->lastIntegerParameter, sInfo->integerParameter, mData->nParametersInteger*sizeof(modelica_integer))
+      || memcmp(mask->lastBooleanParameter, sInfo->booleanParameter, mData->nParametersBoolean*sizeof(modelica_boolean))
+      || memcmp(mask->lastRelations, sInfo->relations, mData->nRelations*sizeof(modelica_boolean));
+}
+
+static void storeSnapshot(EVAL_MASK *mask, DATA *data)
+{
+  MODEL_DATA *mData = data->modelData;
+  SIMULATION_DATA *sData = data->localData[0];
+  SIMULATION_INFO *sInfo = data->simulationInfo;
+
+  memcpy(mask->lastRealVars, sData->realVars, mData->nVariablesReal*sizeof(modelica_real));
+  mask->lastTime = sData->timeValue;
+  memcpy(mask->lastIntegerVars, sData->integerVars, mData->nVariablesInteger*sizeof(modelica_integer));
+  memcpy(mask->lastBooleanVars, sData->booleanVars, mData->nVariablesBoolean*sizeof(modelica_boolean));
+  memcpy(mask->lastRealParameter, sInfo->realParameter, mData->nParametersReal*sizeof(modelica_real));
+  memcpy(mask->lastIntegerParameter, sInfo->integerParameter, mData->nParametersInteger*sizeof(modelica_integer));
+  memcpy(mask->lastBooleanParameter, sInfo->booleanParameter, mData->nParametersBoolean*sizeof(modelica_boolean));
+  memcpy(mask->lastRelations, sInfo->relations, mData->nRelations*sizeof(modelica_boolean));
+  mask->valid = 1;
+}
+
+/* true if one of the variables in deps = {n, index_1, ..., index_n} is dirty or unknown */
+static modelica_boolean anyDirty(const int *deps, const modelica_boolean *dirty)
+{
+  int i;
+  for (i = 1; i <= deps[0]; i++) {
+    if (deps[i] < 0 || dirty[deps[i]]) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/*! \fn maskedEval_evaluate
+ *
+ *  Runs the equations of mask->deps that read or write a realVar or time
+ *  that changed since the last evaluation, or that follow an equation
+ *  writing unknown variables. Variables written by a run equation are
+ *  marked as changed for the equations after it.
+ *
+ *  \param [ref] [mask]
+ *  \param [ref] [data]
+ *  \param [ref] [threadData]
+ */
+void maskedEval_evaluate(EVAL_MASK *mask, DATA *data, threadData_t *threadData)
+{
+  const EQUATION_DEPENDENCIES *deps = mask->deps;
+  CALL_STATISTICS *stats = &data->simulationInfo->callStatistics;
+  long nReal = data->modelData->nVariablesReal;
+  modelica_real *realVars = data->localData[0]->realVars;
+  modelica_boolean all;
+  long i;
+  int eq, k;
+
+  all = !mask->valid || data->simulationInfo->discreteCall || data->simulationInfo->initial
+        || discreteStateChanged(mask, data);
+  if (!all) {
+    for (i = 0; i < nReal; i++) {
+      /* NaN compares unequal and counts as changed */
+      mask->dirty[i] = mask->lastRealVars[i] != realVars[i];
+    }
+    mask->dirty[nReal] = mask->lastTime != data->localData[0]->timeValue;
+  }
+
+  for (eq = 0; eq < deps->nEquations; eq++) {
+    const int *writes = deps->writes[eq];
+    if (!all && !anyDirty(deps->reads[eq], mask->dirty) && !anyDirty(writes, mask->dirty)) {
+      stats->maskedEquationsSkipped++;
+      continue;
+    }
+    deps->equations[eq](data, threadData);
+    threadData->lastEquationSolved = deps->equationIndexes[eq];
+    stats->maskedEquationsEvaluated++;
+    for (k = 1; k <= writes[0] && !all; k++) {
+      if (writes[k] < 0) {
+        all = 1;
+      } else {
+        mask->dirty[writes[k]] = 1;
+      }
+    }
+  }
+
+  if (data->simulationInfo->discreteCall || data->simulationInfo->initial) {
+    mask->valid = 0;
+  } else {
+    storeSnapshot(mask, data);
+  }
+}
+
+/*! \fn maskedEval_functionODE
+ *
+ *  Same as functionODE, evaluates only the equations affected by changes.
+ */
+int maskedEval_functionODE(EVAL_MASK *mask, DATA *data, threadData_t *threadData)
+{
+  if (NULL == mask->deps) {
+    return data->callback->functionODE(data, threadData);
+  }
+  data->simulationInfo->callStatistics.functionODE++;
+  data->callback->functionLocalKnownVars(data, threadData);
+  maskedEval_evaluate(mask, data, threadData);
+  return 0;
+}
+
+/*! \fn maskedEval_functionAlgebraics
+ *
+ *  Same as functionAlgebraics, evaluates only the equations affected by changes.
+ *  Models with clocked partitions evaluate all equations.
+ */
+int maskedEval_functionAlgebraics(EVAL_MASK *mask, DATA *data, threadData_t *threadData)
+{
+  if (NULL == mask->deps || data->modelData->nBaseClocks > 0) {
+    return data->callback->functionAlgebraics(data, threadData);
+  }
+  data->simulationInfo->callStatistics.functionAlgebraics++;
+  maskedEval_evaluate(mask, data, threadData);
+  return 0;
+}
+
+/*! \fn maskedEval_functionZeroCrossingsEquations
+ *
+ *  Same as function_ZeroCrossingsEquations, evaluates only the equations
+ *  affected by changes.
+ */
+int maskedEval_functionZeroCrossingsEquations(EVAL_MASK *mask, DATA *data, threadData_t *threadData)
+{
+  if (NULL == mask->deps) {
+    return data->callback->function_ZeroCrossingsEquations(data, threadData);
+  }
+  data->simulationInfo->callStatistics.functionZeroCrossingsEquations++;
+  maskedEval_evaluate(mask, data, threadData);
+  return 0;
+}
@@ -0,0 +1,82 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-CurrentYear, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/*! \file masked_eval.h
+ *
+ * Evaluation of functionODE, functionAlgebraics and
+ * function_ZeroCrossingsEquations that only re-runs the equations affected
+ * by the realVars and time that changed since the last evaluation with the
+ * same mask. The dependencies are generated per equation, see
+ * EQUATION_DEPENDENCIES in openmodelica_func.h.
+ *
+ * A change of an integer or boolean variable, a parameter or a relation
+ * evaluates all equations. Equations with unknown dependencies always run.
+ */
+
+#ifndef _MASKED_EVAL_H_
+#define _MASKED_EVAL_H_
+
+#include "../../simulation_data.h"
+#include "../../openmodelica_func.h"
+
+#ifdef __cplusplus
+  extern "C" {
+#endif
+
+typedef struct EVAL_MASK
+{
+  const EQUATION_DEPENDENCIES *deps;
+  modelica_boolean valid;               /* the snapshot below holds the values of the last evaluation */
+  modelica_boolean *dirty;              /* nVariablesReal+1 flags, the last one for time */
+
+  modelica_real *lastRealVars;
+  modelica_real lastTime;
+  modelica_integer *lastIntegerVars;
+  modelica_boolean *lastBooleanVars;
+  modelica_real *lastRealParameter;
+  modelica_integer *lastIntegerParameter;
+  modelica_boolean *lastBooleanParameter;
+  modelica_boolean *lastRelations;
+} EVAL_MASK;
+
+void maskedEval_init(EVAL_MASK *mask, DATA *data, const EQUATION_DEPENDENCIES *deps);
+void maskedEval_free(EVAL_MASK *mask);
+void maskedEval_invalidate(EVAL_MASK *mask);
+void maskedEval_evaluate(EVAL_MASK *mask, DATA *data, threadData_t *threadData);
+
+int maskedEval_functionODE(EVAL_MASK *mask, DATA *data, threadData_t *threadData);
+int maskedEval_functionAlgebraics(EVAL_MASK *mask, DATA *data, threadData_t *threadData);
+int maskedEval_functionZeroCrossingsEquations(EVAL_MASK *mask, DATA *data, threadData_t *threadData);
+
+#ifdef __cplusplus
+  }
+#endif
+
+#endif
@@ -51,6 +51,7 @@
 #include "fmi_events.h"
 #include "stateset.h"
 #include "spatialDistribution.h"
+#include "nonlinearValuesList.h"
 #include "../../meta/meta_modelica.h"
 
 #ifdef USE_PARJAC
@@ -90,7 +91,7 @@ double homTauMin = 1e-4;
 double homTauStart = 0.2;
 int homBacktraceStrategy = 1;
 
-static double tolZC;
+static OMC_THREAD_LOCAL double tolZC; /* set by setZCtol in the thread simulating the model */
 
 /*! \fn updateDiscreteSystem
  *
@@ -579,6 +580,10 @@ void printZeroCrossings(DATA *data, int stream)
  *  This function overwrites all old value with the current.
  *  This function is called after events.
  *
+ *  All history slots are filled directly from localData[0] instead of
+ *  shifting each slot into the next one, so the copies are independent
+ *  and read the same (cache-hot) source.
+ *
  *  \param [ref] [data]
  *
  *  \author lochel
@@ -587,14 +592,18 @@ void overwriteOldSimulationData(DATA *data)
 {
   TRACE_PUSH
   long i;
+  const SIMULATION_DATA *sData = data->localData[0];
+  const MODEL_DATA *mData = data->modelData;
 
   for(i=1; i<ringBufferLength(data->simulationData); ++i)
   {
-    data->localData[i]->timeValue = data->localData[i-1]->timeValue;
-    memcpy(data->localData[i]->realVars, data->localData[i-1]->realVars, sizeof(modelica_real)*data->modelData->nVariablesReal);
-    memcpy(data->localData[i]->integerVars, data->localData[i-1]->integerVars, sizeof(modelica_integer)*data->modelData->nVariablesInteger);
-    memcpy(data->localData[i]->booleanVars, data->localData[i-1]->booleanVars, sizeof(modelica_boolean)*data->modelData->nVariablesBoolean);
-    memcpy(data->localData[i]->stringVars, data->localData[i-1]->stringVars, sizeof(modelica_string)*data->modelData->nVariablesString);
+    data->localData[i]->timeValue = sData->timeValue;
+    memcpy(data->localData[i]->realVars, sData->realVars, sizeof(modelica_real)*mData->nVariablesReal);
+    memcpy(data->localData[i]->integerVars, sData->integerVars, sizeof(modelica_integer)*mData->nVariablesInteger);
+    memcpy(data->localData[i]->booleanVars, sData->booleanVars, sizeof(modelica_boolean)*mData->nVariablesBoolean);
+#if !defined(OMC_NVAR_STRING) || OMC_NVAR_STRING>0
+    memcpy(data->localData[i]->stringVars, sData->stringVars, sizeof(modelica_string)*mData->nVariablesString);
+#endif
   }
 
   TRACE_POP
@@ -828,9 +837,72 @@ void setAllParamsToStart(DATA *data)
   TRACE_POP
 }
 
+/*! \fn initOldValuesIndex
+ *
+ *  Collects the reals storeOldValues keeps besides the states and the
+ *  discrete reals: the iteration variables of the non-linear systems, which
+ *  are their start values when a step is retried. All other reals are
+ *  computed from these again by updateDiscreteSystem.
+ *  The indices are found by calling getIterationVars on realVars filled
+ *  with their own indices.
+ *
+ *  \param [ref] [data]
+ */
+static void initOldValuesIndex(DATA *data)
+{
+  MODEL_DATA *mData = data->modelData;
+  SIMULATION_INFO *sInfo = data->simulationInfo;
+  modelica_real *realVars = data->localData[0]->realVars;
+  long first = mData->nStates, last = mData->nVariablesReal - mData->nDiscreteReal;
+  modelica_boolean *keep;
+  double *iterationVars;
+  long i, j, k;
+
+  sInfo->realVarsOldIndex = NULL;
+  sInfo->nRealVarsOldIndex = 0;
+  if (0 == mData->nNonLinearSystems || last <= first) {
+    return;
+  }
+
+  keep = (modelica_boolean*) calloc(mData->nVariablesReal, sizeof(modelica_boolean));
+  for (i = 0; i < mData->nVariablesReal; i++) {
+    realVars[i] = (modelica_real) i;
+  }
+  for (i = 0; i < mData->nNonLinearSystems; i++) {
+    NONLINEAR_SYSTEM_DATA *nonlinsys = &sInfo->nonlinearSystemData[i];
+    if (NULL == nonlinsys->getIterationVars || 0 == nonlinsys->size) {
+      continue;
+    }
+    iterationVars = (double*) malloc(nonlinsys->size*sizeof(double));
+    nonlinsys->getIterationVars(data, iterationVars);
+    for (j = 0; j < nonlinsys->size; j++) {
+      k = (long) iterationVars[j];
+      if (k >= first && k < last && iterationVars[j] == (double) k) {
+        keep[k] = 1;
+      }
+    }
+    free(iterationVars);
+  }
+  memset(realVars, 0, mData->nVariablesReal*sizeof(modelica_real));
+
+  for (k = first; k < last; k++) {
+    sInfo->nRealVarsOldIndex += keep[k];
+  }
+  sInfo->realVarsOldIndex = (long*) malloc(sInfo->nRealVarsOldIndex*sizeof(long));
+  for (k = first, j = 0; k < last; k++) {
+    if (keep[k]) {
+      sInfo->realVarsOldIndex[j++] = k;
+    }
+  }
+  free(keep);
+}
+
 /*! \fn storeOldValues
  *
- *  This function copies states and time into their old-values for event handling.
+ *  This function copies time, states, discrete variables and the iteration
+ *  variables of the non-linear systems into their old-values for event
+ *  handling and for retrying a step. The other reals are not needed, they
+ *  are computed again from these.
  *
  *  \param [ref] [data]
  *
@@ -842,9 +914,14 @@ void storeOldValues(DATA *data)
   SIMULATION_DATA *sData = data->localData[0];
   MODEL_DATA      *mData = data->modelData;
   SIMULATION_INFO *sInfo = data->simulationInfo;
+  long i, firstDiscrete = mData->nVariablesReal - mData->nDiscreteReal;
 
   sInfo->timeValueOld = sData->timeValue;
-  memcpy(sInfo->realVarsOld, sData->realVars, sizeof(modelica_real)*mData->nVariablesReal);
+  memcpy(sInfo->realVarsOld, sData->realVars, sizeof(modelica_real)*mData->nStates);
+  memcpy(sInfo->realVarsOld + firstDiscrete, sData->realVars + firstDiscrete, sizeof(modelica_real)*mData->nDiscreteReal);
+  for (i = 0; i < sInfo->nRealVarsOldIndex; i++) {
+    sInfo->realVarsOld[sInfo->realVarsOldIndex[i]] = sData->realVars[sInfo->realVarsOldIndex[i]];
+  }
   memcpy(sInfo->integerVarsOld, sData->integerVars, sizeof(modelica_integer)*mData->nVariablesInteger);
   memcpy(sInfo->booleanVarsOld, sData->booleanVars, sizeof(modelica_boolean)*mData->nVariablesBoolean);
 #if !defined(OMC_NVAR_STRING) || OMC_NVAR_STRING>0
@@ -855,7 +932,8 @@ void storeOldValues(DATA *data)
 
 /*! \fn restoreOldValues
  *
- *  This function copies old-values to current localData
+ *  This function copies the old-values stored by storeOldValues to current
+ *  localData. The other reals have to be updated afterwards.
  *
  *  \param [ref] [data]
  *
@@ -867,9 +945,14 @@ void restoreOldValues(DATA *data)
   SIMULATION_DATA *sData = data->localData[0];
   MODEL_DATA      *mData = data->modelData;
   SIMULATION_INFO *sInfo = data->simulationInfo;
+  long i, firstDiscrete = mData->nVariablesReal - mData->nDiscreteReal;
 
   sData->timeValue = sInfo->timeValueOld;
-  memcpy(sData->realVars, sInfo->realVarsOld, sizeof(modelica_real)*mData->nVariablesReal);
+  memcpy(sData->realVars, sInfo->realVarsOld, sizeof(modelica_real)*mData->nStates);
+  memcpy(sData->realVars + firstDiscrete, sInfo->realVarsOld + firstDiscrete, sizeof(modelica_real)*mData->nDiscreteReal);
+  for (i = 0; i < sInfo->nRealVarsOldIndex; i++) {
+    sData->realVars[sInfo->realVarsOldIndex[i]] = sInfo->realVarsOld[sInfo->realVarsOldIndex[i]];
+  }
   memcpy(sData->integerVars, sInfo->integerVarsOld, sizeof(modelica_integer)*mData->nVariablesInteger);
   memcpy(sData->booleanVars, sInfo->booleanVarsOld,  sizeof(modelica_boolean)*mData->nVariablesBoolean);
 #if !defined(OMC_NVAR_STRING) || OMC_NVAR_STRING>0
@@ -996,6 +1079,8 @@ void initializeDataStruc(DATA *data, threadData_t *threadData)
   SIMULATION_DATA tmpSimData = {0};
   size_t i = 0;
 
+  data->modelData->sharedVarInfo = 0;
+
   /* RingBuffer */
   data->simulationData = 0;
   data->simulationData = allocRingBuffer(SIZERINGBUFFER, sizeof(SIMULATION_DATA));
@@ -1086,6 +1171,7 @@ void initializeDataStruc(DATA *data, threadData_t *threadData)
     data->simulationInfo->zeroCrossingIndex[i] = (long)i;
   data->simulationInfo->states_left = (modelica_real*) malloc(data->modelData->nStates * sizeof(modelica_real));
   data->simulationInfo->states_right = (modelica_real*) malloc(data->modelData->nStates * sizeof(modelica_real));
+  data->simulationInfo->tmpEventList = allocIndexSet(data->modelData->nZeroCrossings);
 
   /* buffer for old values */
   data->simulationInfo->realVarsOld = (modelica_real*) calloc(data->modelData->nVariablesReal, sizeof(modelica_real));
@@ -1144,6 +1230,10 @@ void initializeDataStruc(DATA *data, threadData_t *threadData)
     data->simulationInfo->nonlinearSystemData = (NONLINEAR_SYSTEM_DATA*) omc_alloc_interface.malloc_uncollectable(data->modelData->nNonLinearSystems*sizeof(NONLINEAR_SYSTEM_DATA));
     data->callback->initialNonLinearSystem(data->modelData->nNonLinearSystems, data->simulationInfo->nonlinearSystemData);
   }
+  initOldValuesIndex(data);
+#else
+  data->simulationInfo->realVarsOldIndex = NULL;
+  data->simulationInfo->nRealVarsOldIndex = 0;
 #endif
 
 #if !defined(OMC_NO_STATESELECTION)
@@ -1192,9 +1282,15 @@ void initializeDataStruc(DATA *data, threadData_t *threadData)
   data->simulationInfo->callStatistics.functionZeroCrossingsEquations = 0;
   data->simulationInfo->callStatistics.functionZeroCrossings = 0;
   data->simulationInfo->callStatistics.functionAlgebraics = 0;
+  data->simulationInfo->callStatistics.maskedEquationsEvaluated = 0;
+  data->simulationInfo->callStatistics.maskedEquationsSkipped = 0;
 
   data->simulationInfo->lambda = 1.0;
 
+  /* flags changed during the initialization of this instance */
+  data->simulationInfo->nlsNoScaling = omc_flag[FLAG_NO_SCALING];
+  data->simulationInfo->homotopyOnFirstTry = omc_flag[FLAG_HOMOTOPY_ON_FIRST_TRY];
+
   /* initial build calls terminal, initial */
   data->simulationInfo->terminal = 0;
   data->simulationInfo->initial = 0;
@@ -1239,6 +1335,123 @@ void initializeDataStruc(DATA *data, threadData_t *threadData)
   TRACE_POP
 }
 
+/*! \fn resetDataStruc
+ *
+ *  Resets the run dependent parts of the DATA structure, so that the model
+ *  can be initialized and simulated again without re-reading the model
+ *  description or re-allocating the buffers from initializeDataStruc.
+ *  Start attributes and parameters are not touched; they are copied into
+ *  the simulation data by initializeModel. Clocks, spatial distributions
+ *  and the pivoting of the state sets are reset to their state after
+ *  initializeDataStruc, so that the initialization sets them up again.
+ *
+ *  \param [ref] [data]
+ */
+void resetDataStruc(DATA *data, threadData_t *threadData)
+{
+  TRACE_PUSH
+  size_t i = 0;
+  MODEL_DATA *mData = data->modelData;
+  SIMULATION_INFO *sInfo = data->simulationInfo;
+
+  for(i=0; i<SIZERINGBUFFER; i++)
+  {
+    data->localData[i]->timeValue = sInfo->startTime;
+  }
+
+  sInfo->nextSampleEvent = sInfo->startTime;
+  memset(sInfo->nextSampleTimes, 0, mData->nSamples*sizeof(double));
+  memset(sInfo->samples, 0, mData->nSamples*sizeof(modelica_boolean));
+  if (sInfo->intvlTimers) {
+    listClear(sInfo->intvlTimers);
+  }
+  /* function_initSynchronous sets up the clocks again with new sub-clocks */
+  for(i=0; i<mData->nBaseClocks; i++)
+  {
+    free(sInfo->baseClocks[i].subClocks);
+  }
+  if (mData->nBaseClocks > 0) {
+    memset(sInfo->baseClocks, 0, mData->nBaseClocks*sizeof(BASECLOCK_DATA));
+  }
+
+  freeSpatialDistribution(sInfo->spatialDistributionData, mData->nSpatialDistributions);
+  free(sInfo->spatialDistributionData);
+  sInfo->spatialDistributionData = allocSpatialDistribution(mData->nSpatialDistributions);
+
+#if !defined(OMC_NO_STATESELECTION)
+  initializeStateSetPivoting(data);
+#endif
+
+  memset(sInfo->zeroCrossings, 0, mData->nZeroCrossings*sizeof(modelica_real));
+  memset(sInfo->zeroCrossingsPre, 0, mData->nZeroCrossings*sizeof(modelica_real));
+  memset(sInfo->zeroCrossingsBackup, 0, mData->nZeroCrossings*sizeof(modelica_real));
+  memset(sInfo->relations, 0, mData->nRelations*sizeof(modelica_boolean));
+  memset(sInfo->relationsPre, 0, mData->nRelations*sizeof(modelica_boolean));
+  memset(sInfo->storedRelations, 0, mData->nRelations*sizeof(modelica_boolean));
+
+#if !defined(OMC_MINIMAL_LOGGING)
+  memset(sInfo->chatteringInfo.lastSteps, 0, sInfo->chatteringInfo.numEventLimit*sizeof(int));
+  memset(sInfo->chatteringInfo.lastTimes, 0, sInfo->chatteringInfo.numEventLimit*sizeof(double));
+  sInfo->chatteringInfo.currentIndex = 0;
+  sInfo->chatteringInfo.lastStepsNumStateEvents = 0;
+  sInfo->chatteringInfo.messageEmitted = 0;
+#endif
+
+  memset(&sInfo->callStatistics, 0, sizeof(sInfo->callStatistics));
+
+  sInfo->lambda = 1.0;
+  sInfo->terminal = 0;
+  sInfo->initial = 0;
+  sInfo->sampleActivated = 0;
+  sInfo->needToIterate = 0;
+  sInfo->solveContinuous = 0;
+  sInfo->noThrowDivZero = 0;
+  sInfo->noThrowAsserts = 0;
+  sInfo->needToReThrow = 0;
+  sInfo->discreteCall = 0;
+  sInfo->simulationSuccess = 0;
+  sInfo->solverSteps = 0;
+
+#if !defined(OMC_NDELAY_EXPRESSIONS) || OMC_NDELAY_EXPRESSIONS>0
+  for(i=0; i<mData->nDelayExpressions; i++)
+  {
+    dequeueNFirstRingDatas(sInfo->delayStructure[i], ringBufferLength(sInfo->delayStructure[i]));
+  }
+#endif
+
+#if !defined(OMC_NUM_NONLINEAR_SYSTEMS) || OMC_NUM_NONLINEAR_SYSTEMS>0
+  for(i=0; i<mData->nNonLinearSystems; i++)
+  {
+    NONLINEAR_SYSTEM_DATA *nonlinsys = &sInfo->nonlinearSystemData[i];
+    if (nonlinsys->oldValueList) {
+      cleanValueList(nonlinsys->oldValueList);
+    }
+    nonlinsys->lastTimeSolved = 0.0;
+    nonlinsys->numberOfCall = 0;
+    nonlinsys->numberOfFEval = 0;
+    nonlinsys->numberOfFailures = 0;
+    nonlinsys->numberOfJEval = 0;
+    nonlinsys->numberOfIterations = 0;
+    nonlinsys->totalTime = 0.0;
+    nonlinsys->jacobianTime = 0.0;
+  }
+#endif
+
+#if !defined(OMC_NUM_LINEAR_SYSTEMS) || OMC_NUM_LINEAR_SYSTEMS>0
+  for(i=0; i<mData->nLinearSystems; i++)
+  {
+    LINEAR_SYSTEM_DATA *linsys = &sInfo->linearSystemData[i];
+    linsys->numberOfCall = 0;
+    linsys->numberOfFailures = 0;
+    linsys->numberOfJEval = 0;
+    linsys->totalTime = 0.0;
+    linsys->jacobianTime = 0.0;
+  }
+#endif
+
+  TRACE_POP
+}
+
 /*! \fn deInitializeDataStruc
  *
  *  function de-initialize DATA structure
@@ -1250,7 +1463,7 @@ void deInitializeDataStruc(DATA *data)
 {
   TRACE_PUSH
   size_t i = 0;
-  int needToFree = !data->callback->read_input_fmu;
+  int needToFree = !data->callback->read_input_fmu && !data->modelData->sharedVarInfo;
 
   /* prepare RingBuffer */
   for(i=0; i<SIZERINGBUFFER; i++)
@@ -1310,9 +1523,11 @@ void deInitializeDataStruc(DATA *data)
   free(data->simulationInfo->zeroCrossingIndex);
   free(data->simulationInfo->states_left);
   free(data->simulationInfo->states_right);
+  freeIndexSet(data->simulationInfo->tmpEventList);
 
   /* free buffer for old state variables */
   free(data->simulationInfo->realVarsOld);
+  free(data->simulationInfo->realVarsOldIndex);
   free(data->simulationInfo->integerVarsOld);
   free(data->simulationInfo->booleanVarsOld);
   omc_alloc_interface.free_uncollectable(data->simulationInfo->stringVarsOld);
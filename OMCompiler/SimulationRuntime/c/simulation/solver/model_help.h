@@ -66,6 +66,8 @@ extern int homBacktraceStrategy;
 
 void initializeDataStruc(DATA *data, threadData_t *threadData);
 
+void resetDataStruc(DATA *data, threadData_t *threadData);
+
 void deInitializeDataStruc(DATA *data);
 
 void updateDiscreteSystem(DATA *data, threadData_t *threadData);
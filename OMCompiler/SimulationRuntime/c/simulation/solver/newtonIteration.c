@@ -47,6 +47,7 @@ extern "C" {
 
 #include "nonlinearSystem.h"
 #include "newtonIteration.h"
+#include "nonlinearWorkspace.h"
 
 #include "external_input.h"
 
@@ -77,6 +78,23 @@ extern int dgesv_(int *n, int *nrhs, doublereal *a, int *lda, int *ipiv, doubler
 extern void dgetrf_(int *m, int *n, doublereal *fjac, int *lda, int* iwork, int *info);
 extern void dgetrs_(char *trans, int *n, int *nrhs, doublereal *a, int *lda, int *ipiv, doublereal *b, int *ldb, int *info);
 
+/**
+ * @brief Workspace needed by allocateNewtonData.
+ *
+ * @param size          Size of non-linear system.
+ * @param nRelations    Number of relations of the model.
+ * @return size_t       Size in bytes.
+ */
+size_t newtonWorkspaceSize(int size, long nRelations)
+{
+  return nlsWorkspaceBytes(1, sizeof(DATA_NEWTON))
+       + 9*nlsWorkspaceBytes(size, sizeof(double))
+       + 2*nlsWorkspaceBytes(size+1, sizeof(double))
+       + nlsWorkspaceBytes(size*(size+1), sizeof(double))
+       + nlsWorkspaceBytes(size, sizeof(int))
+       + nlsWorkspaceBytes(nRelations, sizeof(modelica_boolean));
+}
+
 /**
  * @brief Allocate NLS Newton data.
  *
@@ -86,31 +104,33 @@ extern void dgetrs_(char *trans, int *n, int *nrhs, doublereal *a, int *lda, int
  */
 DATA_NEWTON* allocateNewtonData(int size, NLS_USERDATA* userData)
 {
-  DATA_NEWTON* newtonData = (DATA_NEWTON*) malloc(sizeof(DATA_NEWTON));
+  NLS_WORKSPACE* workspace = getNlsWorkspace(userData);
+  DATA_NEWTON* newtonData = (DATA_NEWTON*) nlsWorkspaceCalloc(workspace, 1, sizeof(DATA_NEWTON));
   assertStreamPrint(NULL, NULL != newtonData, "allocationNewtonData() failed. Out of memory.");
 
-  newtonData->resScaling = (double*) malloc(size*sizeof(double));
-  newtonData->fvecScaled = (double*) malloc(size*sizeof(double));
+  newtonData->resScaling = (double*) nlsWorkspaceCalloc(workspace, size, sizeof(double));
+  newtonData->fvecScaled = (double*) nlsWorkspaceCalloc(workspace, size, sizeof(double));
 
   newtonData->n = size;
-  newtonData->x = (double*) malloc((size+1)*sizeof(double));
-  newtonData->fvec = (double*) calloc(size,sizeof(double));
+  newtonData->x = (double*) nlsWorkspaceCalloc(workspace, (size+1), sizeof(double));
+  newtonData->fvec = (double*) nlsWorkspaceCalloc(workspace, size, sizeof(double));
   newtonData->xtol = 1e-6;
   newtonData->ftol = 1e-6;
   newtonData->maxfev = size*100;
   newtonData->epsfcn = DBL_EPSILON;
-  newtonData->fjac = (double*) malloc((size*(size+1))*sizeof(double));
+  newtonData->fjac = (double*) nlsWorkspaceCalloc(workspace, (size*(size+1)), sizeof(double));
 
-  newtonData->rwork = (double*) malloc((size)*sizeof(double));
-  newtonData->iwork = (int*) malloc(size*sizeof(int));
+  newtonData->rwork = (double*) nlsWorkspaceCalloc(workspace, (size), sizeof(double));
+  newtonData->iwork = (int*) nlsWorkspaceCalloc(workspace, size, sizeof(int));
 
   /* damped newton */
-  newtonData->x_new = (double*) malloc((size+1)*sizeof(double));
-  newtonData->x_increment = (double*) malloc(size*sizeof(double));
-  newtonData->f_old = (double*) calloc(size,sizeof(double));
-  newtonData->fvec_minimum = (double*) calloc(size,sizeof(double));
-  newtonData->delta_f = (double*) calloc(size,sizeof(double));
-  newtonData->delta_x_vec = (double*) calloc(size,sizeof(double));
+  newtonData->x_new = (double*) nlsWorkspaceCalloc(workspace, (size+1), sizeof(double));
+  newtonData->x_increment = (double*) nlsWorkspaceCalloc(workspace, size, sizeof(double));
+  newtonData->f_old = (double*) nlsWorkspaceCalloc(workspace, size, sizeof(double));
+  newtonData->fvec_minimum = (double*) nlsWorkspaceCalloc(workspace, size, sizeof(double));
+  newtonData->delta_f = (double*) nlsWorkspaceCalloc(workspace, size, sizeof(double));
+  newtonData->delta_x_vec = (double*) nlsWorkspaceCalloc(workspace, size, sizeof(double));
+  newtonData->relationsPreBackup = (modelica_boolean*) nlsWorkspaceCalloc(workspace, userData->data->modelData->nRelations, sizeof(modelica_boolean));
 
   newtonData->factorization = 0;
   newtonData->calculate_jacobian = 1;
@@ -129,24 +149,27 @@ DATA_NEWTON* allocateNewtonData(int size, NLS_USERDATA* userData)
  */
 void freeNewtonData(DATA_NEWTON* newtonData)
 {
-  free(newtonData->resScaling);
-  free(newtonData->fvecScaled);
-  free(newtonData->x);
-  free(newtonData->fvec);
-  free(newtonData->fjac);
-  free(newtonData->rwork);
-  free(newtonData->iwork);
+  NLS_WORKSPACE* workspace = getNlsWorkspace(newtonData->userData);
+
+  nlsWorkspaceRelease(workspace, newtonData->resScaling);
+  nlsWorkspaceRelease(workspace, newtonData->fvecScaled);
+  nlsWorkspaceRelease(workspace, newtonData->x);
+  nlsWorkspaceRelease(workspace, newtonData->fvec);
+  nlsWorkspaceRelease(workspace, newtonData->fjac);
+  nlsWorkspaceRelease(workspace, newtonData->rwork);
+  nlsWorkspaceRelease(workspace, newtonData->iwork);
 
   /* damped newton */
-  free(newtonData->x_new);
-  free(newtonData->x_increment);
-  free(newtonData->f_old);
-  free(newtonData->fvec_minimum);
-  free(newtonData->delta_f);
-  free(newtonData->delta_x_vec);
+  nlsWorkspaceRelease(workspace, newtonData->x_new);
+  nlsWorkspaceRelease(workspace, newtonData->x_increment);
+  nlsWorkspaceRelease(workspace, newtonData->f_old);
+  nlsWorkspaceRelease(workspace, newtonData->fvec_minimum);
+  nlsWorkspaceRelease(workspace, newtonData->delta_f);
+  nlsWorkspaceRelease(workspace, newtonData->delta_x_vec);
+  nlsWorkspaceRelease(workspace, newtonData->relationsPreBackup);
 
   freeNlsUserData(newtonData->userData);
-  free(newtonData);
+  nlsWorkspaceRelease(workspace, newtonData);
 }
 
 /**
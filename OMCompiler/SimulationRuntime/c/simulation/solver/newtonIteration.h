@@ -77,6 +77,7 @@ typedef struct DATA_NEWTON
   double* fvec_minimum;
   double* delta_f;
   double* delta_x_vec;
+  modelica_boolean* relationsPreBackup;
 
   rtclock_t timeClock;
 
@@ -91,6 +92,7 @@ typedef struct DATA_NEWTON
 typedef int (genericResidualFunc)(int n, double* x, double* fvec, void* userData, int fj);
 
 
+size_t newtonWorkspaceSize(int size, long nRelations);
 DATA_NEWTON* allocateNewtonData(int size, NLS_USERDATA* userData);
 void freeNewtonData(DATA_NEWTON* newtonData);
 int _omc_newton(genericResidualFunc f, DATA_NEWTON* solverData, void* userData);
@@ -55,7 +55,9 @@
 
 #include "nonlinearSystem.h"
 #include "nonlinearSolverHomotopy.h"
+#include "nonlinearSolverHomotopySparse.h"
 #include "nonlinearSolverHybrd.h"
+#include "nonlinearWorkspace.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -135,12 +137,14 @@ typedef struct DATA_HOMOTOPY
   double* hvec;
   double* hJac;
   double* hJac2;
-  double* hJacInit;
   double* ones;
 
   /* linear system */
   int* indRow;
   int* indCol;
+  double* rowsMax;    /* row maxima in scaleMatrixRows */
+
+  modelica_boolean* relationsPreBackup;
 
   int (*f)         (struct DATA_HOMOTOPY*, double*, double*);
   int (*f_con)     (struct DATA_HOMOTOPY*, double*, double*);
@@ -155,8 +159,43 @@ typedef struct DATA_HOMOTOPY
 
   DATA_HYBRD* dataHybrid;
 
+  DATA_HOMOTOPY_SPARSE* sparseData; /* sparse variant for big initial systems, replaces all arrays above */
+
 } DATA_HOMOTOPY;
 
+/**
+ * @brief Workspace needed by allocateHomotopyData.
+ *
+ * @param nlsData       Non-linear system data.
+ * @param size          Size of non-linear system.
+ * @param nRelations    Number of relations of the model.
+ * @return size_t       Size in bytes.
+ */
+size_t homotopyWorkspaceSize(NONLINEAR_SYSTEM_DATA* nlsData, size_t size, long nRelations)
+{
+  size_t bytes;
+
+  if (homotopySparseAvailable(nlsData, size)) {
+    return nlsWorkspaceBytes(1, sizeof(DATA_HOMOTOPY)) + homotopySparseWorkspaceSize(nlsData, size);
+  }
+
+  bytes = nlsWorkspaceBytes(1, sizeof(DATA_HOMOTOPY))
+               + 12*nlsWorkspaceBytes(size, sizeof(double))
+               + 12*nlsWorkspaceBytes(size+1, sizeof(double))
+               + nlsWorkspaceBytes(size+homBacktraceStrategy, sizeof(double))
+               + 3*nlsWorkspaceBytes(size*(size+1), sizeof(double))
+               + nlsWorkspaceBytes((size+1)*(size+2), sizeof(double))
+               + nlsWorkspaceBytes(size+homBacktraceStrategy-1, sizeof(int))
+               + nlsWorkspaceBytes(size+homBacktraceStrategy, sizeof(int))
+               + nlsWorkspaceBytes(nRelations, sizeof(modelica_boolean))
+               + hybrdWorkspaceSize(size, nRelations);
+
+  if (ACTIVE_STREAM(LOG_NLS_JAC_TEST)) {
+    bytes += nlsWorkspaceBytes(size*(size+1), sizeof(double));
+  }
+  return bytes;
+}
+
 /**
  * @brief Allocate memory for non-linear homotopy solver.
  *
@@ -166,7 +205,8 @@ typedef struct DATA_HOMOTOPY
  */
 DATA_HOMOTOPY* allocateHomotopyData(size_t size, NLS_USERDATA* userData)
 {
-  DATA_HOMOTOPY* homotopyData = (DATA_HOMOTOPY*) malloc(sizeof(DATA_HOMOTOPY));
+  NLS_WORKSPACE* workspace = getNlsWorkspace(userData);
+  DATA_HOMOTOPY* homotopyData = (DATA_HOMOTOPY*) nlsWorkspaceCalloc(workspace, 1, sizeof(DATA_HOMOTOPY));
   assertStreamPrint(NULL, 0 != homotopyData, "allocationHomotopyData() failed!");
 
   homotopyData->initialized = 0;
@@ -181,50 +221,58 @@ DATA_HOMOTOPY* allocateHomotopyData(size_t size, NLS_USERDATA* userData)
   homotopyData->numberOfIterations = 0;
   homotopyData->numberOfFunctionEvaluations = 0;
 
-  homotopyData->resScaling = (double*) calloc(size,sizeof(double));
-  homotopyData->fvecScaled = (double*) calloc(size,sizeof(double));
-  homotopyData->hvecScaled = (double*) calloc(size,sizeof(double));
-  homotopyData->dxScaled = (double*) calloc(size,sizeof(double));
+  homotopyData->userData = userData;
+
+  /* big sparse initial systems don't need any of the dense arrays */
+  if (homotopySparseAvailable(userData->nlsData, size)) {
+    homotopyData->sparseData = allocateHomotopySparseData(size, userData);
+    return homotopyData;
+  }
+
+  homotopyData->resScaling = (double*) nlsWorkspaceCalloc(workspace, size, sizeof(double));
+  homotopyData->fvecScaled = (double*) nlsWorkspaceCalloc(workspace, size, sizeof(double));
+  homotopyData->hvecScaled = (double*) nlsWorkspaceCalloc(workspace, size, sizeof(double));
+  homotopyData->dxScaled = (double*) nlsWorkspaceCalloc(workspace, size, sizeof(double));
 
-  homotopyData->xScaling = (double*) calloc((size+1),sizeof(double));
+  homotopyData->xScaling = (double*) nlsWorkspaceCalloc(workspace, (size+1), sizeof(double));
 
-  homotopyData->f1 = (double*) calloc(size,sizeof(double));
-  homotopyData->f2 = (double*) calloc(size,sizeof(double));
-  homotopyData->gradFx = (double*) calloc(size,sizeof(double));
+  homotopyData->f1 = (double*) nlsWorkspaceCalloc(workspace, size, sizeof(double));
+  homotopyData->f2 = (double*) nlsWorkspaceCalloc(workspace, size, sizeof(double));
+  homotopyData->gradFx = (double*) nlsWorkspaceCalloc(workspace, size, sizeof(double));
 
   /* damped newton */
-  homotopyData->x = (double*) calloc((size+1),sizeof(double));
-  homotopyData->x0 = (double*) calloc((size+1),sizeof(double));
-  homotopyData->xStart = (double*) calloc(size,sizeof(double));
-  homotopyData->x1 = (double*) calloc((size+1),sizeof(double));
-  homotopyData->finit = (double*) calloc(size,sizeof(double));
-  homotopyData->fx0 = (double*) calloc(size,sizeof(double));
-  homotopyData->fJac = (double*) calloc((size*(size+1)),sizeof(double));
-  homotopyData->fJacx0 = (double*) calloc((size*(size+1)),sizeof(double));
+  homotopyData->x = (double*) nlsWorkspaceCalloc(workspace, (size+1), sizeof(double));
+  homotopyData->x0 = (double*) nlsWorkspaceCalloc(workspace, (size+1), sizeof(double));
+  homotopyData->xStart = (double*) nlsWorkspaceCalloc(workspace, size, sizeof(double));
+  homotopyData->x1 = (double*) nlsWorkspaceCalloc(workspace, (size+1), sizeof(double));
+  homotopyData->finit = (double*) nlsWorkspaceCalloc(workspace, size, sizeof(double));
+  homotopyData->fx0 = (double*) nlsWorkspaceCalloc(workspace, size, sizeof(double));
+  homotopyData->fJac = (double*) nlsWorkspaceCalloc(workspace, (size*(size+1)), sizeof(double));
+  homotopyData->fJacx0 = (double*) nlsWorkspaceCalloc(workspace, (size*(size+1)), sizeof(double));
 
   /* debug arrays */
-  homotopyData->debug_dx = (double*) calloc(size,sizeof(double));
-  homotopyData->debug_fJac = (double*) calloc((size*(size+1)),sizeof(double));
+  homotopyData->debug_dx = (double*) nlsWorkspaceCalloc(workspace, size, sizeof(double));
+  homotopyData->debug_fJac = ACTIVE_STREAM(LOG_NLS_JAC_TEST) ? (double*) nlsWorkspaceCalloc(workspace, (size*(size+1)), sizeof(double)) : NULL;
 
    /* homotopy */
-  homotopyData->y0 = (double*) calloc((size+1),sizeof(double));
-  homotopyData->y1 = (double*) calloc((size+1),sizeof(double));
-  homotopyData->y2 = (double*) calloc((size+1),sizeof(double));
-  homotopyData->yt = (double*) calloc((size+1),sizeof(double));
-  homotopyData->dy0 = (double*) calloc((size+1),sizeof(double));
-  homotopyData->dy1 = (double*) calloc((size+homBacktraceStrategy),sizeof(double));
-  homotopyData->dy2 = (double*) calloc((size+1),sizeof(double));
-  homotopyData->hvec = (double*) calloc(size,sizeof(double));
-  homotopyData->hJac  = (double*) calloc(size*(size+1),sizeof(double));
-  homotopyData->hJac2  = (double*) calloc((size+1)*(size+2),sizeof(double));
-  homotopyData->hJacInit  = (double*) calloc(size*(size+1),sizeof(double));
-  homotopyData->ones  = (double*) calloc(size+1,sizeof(double));
+  homotopyData->y0 = (double*) nlsWorkspaceCalloc(workspace, (size+1), sizeof(double));
+  homotopyData->y1 = (double*) nlsWorkspaceCalloc(workspace, (size+1), sizeof(double));
+  homotopyData->y2 = (double*) nlsWorkspaceCalloc(workspace, (size+1), sizeof(double));
+  homotopyData->yt = (double*) nlsWorkspaceCalloc(workspace, (size+1), sizeof(double));
+  homotopyData->dy0 = (double*) nlsWorkspaceCalloc(workspace, (size+1), sizeof(double));
+  homotopyData->dy1 = (double*) nlsWorkspaceCalloc(workspace, (size+homBacktraceStrategy), sizeof(double));
+  homotopyData->dy2 = (double*) nlsWorkspaceCalloc(workspace, (size+1), sizeof(double));
+  homotopyData->hvec = (double*) nlsWorkspaceCalloc(workspace, size, sizeof(double));
+  homotopyData->hJac  = (double*) nlsWorkspaceCalloc(workspace, size*(size+1), sizeof(double));
+  homotopyData->hJac2  = (double*) nlsWorkspaceCalloc(workspace, (size+1)*(size+2), sizeof(double));
+  homotopyData->ones  = (double*) nlsWorkspaceCalloc(workspace, size+1, sizeof(double));
 
   /* linear system */
-  homotopyData->indRow =(int*) calloc(size+homBacktraceStrategy-1,sizeof(int));
-  homotopyData->indCol =(int*) calloc(size+homBacktraceStrategy,sizeof(int));
+  homotopyData->indRow =(int*) nlsWorkspaceCalloc(workspace, size+homBacktraceStrategy-1, sizeof(int));
+  homotopyData->indCol =(int*) nlsWorkspaceCalloc(workspace, size+homBacktraceStrategy, sizeof(int));
+  homotopyData->rowsMax = (double*) nlsWorkspaceCalloc(workspace, size+1, sizeof(double));
 
-  homotopyData->userData = userData;
+  homotopyData->relationsPreBackup = (modelica_boolean*) nlsWorkspaceCalloc(workspace, userData->data->modelData->nRelations, sizeof(modelica_boolean));
 
   homotopyData->dataHybrid = allocateHybrdData(size, userData);
 
@@ -239,49 +287,58 @@ DATA_HOMOTOPY* allocateHomotopyData(size_t size, NLS_USERDATA* userData)
  */
 void freeHomotopyData(DATA_HOMOTOPY* homotopyData)
 {
-  free(homotopyData->resScaling);
-  free(homotopyData->fvecScaled);
-  free(homotopyData->hvecScaled);
-  free(homotopyData->x);
-  free(homotopyData->debug_dx);
-  free(homotopyData->finit);
-  free(homotopyData->f1);
-  free(homotopyData->f2);
-  free(homotopyData->gradFx);
-  free(homotopyData->fJac);
-  free(homotopyData->fJacx0);
-  free(homotopyData->debug_fJac);
+  NLS_WORKSPACE* workspace = getNlsWorkspace(homotopyData->userData);
+
+  if (homotopyData->sparseData) {
+    freeHomotopySparseData(homotopyData->sparseData);
+    nlsWorkspaceRelease(workspace, homotopyData);
+    return;
+  }
+
+  nlsWorkspaceRelease(workspace, homotopyData->resScaling);
+  nlsWorkspaceRelease(workspace, homotopyData->fvecScaled);
+  nlsWorkspaceRelease(workspace, homotopyData->hvecScaled);
+  nlsWorkspaceRelease(workspace, homotopyData->x);
+  nlsWorkspaceRelease(workspace, homotopyData->debug_dx);
+  nlsWorkspaceRelease(workspace, homotopyData->finit);
+  nlsWorkspaceRelease(workspace, homotopyData->f1);
+  nlsWorkspaceRelease(workspace, homotopyData->f2);
+  nlsWorkspaceRelease(workspace, homotopyData->gradFx);
+  nlsWorkspaceRelease(workspace, homotopyData->fJac);
+  nlsWorkspaceRelease(workspace, homotopyData->fJacx0);
+  nlsWorkspaceRelease(workspace, homotopyData->debug_fJac);
 
   /* damped newton */
-  free(homotopyData->x0);
-  free(homotopyData->xStart);
-  free(homotopyData->x1);
-  free(homotopyData->dxScaled);
+  nlsWorkspaceRelease(workspace, homotopyData->x0);
+  nlsWorkspaceRelease(workspace, homotopyData->xStart);
+  nlsWorkspaceRelease(workspace, homotopyData->x1);
+  nlsWorkspaceRelease(workspace, homotopyData->dxScaled);
 
   /* homotopy */
-  free(homotopyData->fx0);
-  free(homotopyData->hvec);
-  free(homotopyData->hJac);
-  free(homotopyData->hJac2);
-  free(homotopyData->hJacInit);
-  free(homotopyData->y0);
-  free(homotopyData->y1);
-  free(homotopyData->y2);
-  free(homotopyData->yt);
-  free(homotopyData->dy0);
-  free(homotopyData->dy1);
-  free(homotopyData->dy2);
-  free(homotopyData->xScaling);
-  free(homotopyData->ones);
+  nlsWorkspaceRelease(workspace, homotopyData->fx0);
+  nlsWorkspaceRelease(workspace, homotopyData->hvec);
+  nlsWorkspaceRelease(workspace, homotopyData->hJac);
+  nlsWorkspaceRelease(workspace, homotopyData->hJac2);
+  nlsWorkspaceRelease(workspace, homotopyData->y0);
+  nlsWorkspaceRelease(workspace, homotopyData->y1);
+  nlsWorkspaceRelease(workspace, homotopyData->y2);
+  nlsWorkspaceRelease(workspace, homotopyData->yt);
+  nlsWorkspaceRelease(workspace, homotopyData->dy0);
+  nlsWorkspaceRelease(workspace, homotopyData->dy1);
+  nlsWorkspaceRelease(workspace, homotopyData->dy2);
+  nlsWorkspaceRelease(workspace, homotopyData->xScaling);
+  nlsWorkspaceRelease(workspace, homotopyData->ones);
 
   /* linear system */
-  free(homotopyData->indRow);
-  free(homotopyData->indCol);
+  nlsWorkspaceRelease(workspace, homotopyData->indRow);
+  nlsWorkspaceRelease(workspace, homotopyData->indCol);
+  nlsWorkspaceRelease(workspace, homotopyData->rowsMax);
+  nlsWorkspaceRelease(workspace, homotopyData->relationsPreBackup);
 
   /* Don't free userData here, it's done in freeHybrdData */
   freeHybrdData(homotopyData->dataHybrid);
 
-  free(homotopyData);
+  nlsWorkspaceRelease(workspace, homotopyData);
   return;
 }
 
@@ -763,12 +820,11 @@ void matDiffBB(int n, double* A, double* B, double* C)
   }
 }
 
-/* Matrix has dimension [n x m] */
-void scaleMatrixRows(int n, int m, double *A)
+/* Matrix has dimension [n x m], rowsMax has n elements */
+void scaleMatrixRows(int n, int m, double *A, double *rowsMax)
 {
   const double delta = 0; /* This might be changed to sqrt(DBL_EPSILON) */
   int i, j;
-  double* rowsMax = (double*) calloc(n,sizeof(double));
 
   for (i=0;i<n;i++)
     rowsMax[i] = 0;
@@ -793,8 +849,6 @@ void scaleMatrixRows(int n, int m, double *A)
     for (i=0;i<n;i++)
       A[i+j*(m-1)] /= rowsMax[i];
   }
-
-  free(rowsMax);
 }
 
 /* Build the newton matrix for the corrector step with orthogonal backtrace strategy */
@@ -1686,7 +1740,7 @@ static int newtonAlgorithm(DATA_HOMOTOPY* solverData, double* x)
     /* calculate scaling factor of residuals */
     matVecMultAbsBB(solverData->n, solverData->fJac, solverData->ones, solverData->resScaling);
     debugVectorDouble(LOG_NLS_JAC, "residuum scaling:", solverData->resScaling, solverData->n);
-    scaleMatrixRows(solverData->n, solverData->m, solverData->fJac);
+    scaleMatrixRows(solverData->n, solverData->m, solverData->fJac, solverData->rowsMax);
     vecCopy(n, solverData->fJac + n*n, solverData->dy0);
   }
   return 0;
@@ -1824,7 +1878,7 @@ static int homotopyAlgorithm(DATA_HOMOTOPY* solverData, double *x)
 #endif
       solverData->hJac_dh(solverData, solverData->y0, solverData->hJac);
       debugMatrixDouble(LOG_NLS_JAC,"Jacobian hJac:",solverData->hJac, solverData->n, solverData->n+1);
-      scaleMatrixRows(solverData->n, solverData->m, solverData->hJac);
+      scaleMatrixRows(solverData->n, solverData->m, solverData->hJac, solverData->rowsMax);
       debugMatrixDouble(LOG_NLS_JAC,"Jacobian hJac after scaling:",solverData->hJac, solverData->n, solverData->n+1);
       assert = 0;
       pos = -1; /* stable solution algorithm for solving a generalized over-determined linear system */
@@ -1992,7 +2046,7 @@ static int homotopyAlgorithm(DATA_HOMOTOPY* solverData, double *x)
         /* copy vector h to column "pos" of the jacobian */
         debugVectorDouble(LOG_NLS_HOMOTOPY, "copy vector hvec to column 'pos' of the jacobian:", solverData->hvec, solverData->n);
         vecCopy(solverData->n, solverData->hvec, solverData->hJac + pos*solverData->n);
-        scaleMatrixRows(solverData->n, solverData->m, solverData->hJac);
+        scaleMatrixRows(solverData->n, solverData->m, solverData->hJac, solverData->rowsMax);
         if (solveSystemWithTotalPivotSearch(data, solverData->n, solverData->dy1, solverData->hJac, solverData->indRow, solverData->indCol, &pos, &rank, solverData->casualTearingSet) == -1)
         {
           debugString(LOG_NLS_HOMOTOPY, "step NOT accepted, because solveSystemWithTotalPivotSearch failed!");
@@ -2003,7 +2057,7 @@ static int homotopyAlgorithm(DATA_HOMOTOPY* solverData, double *x)
       }
       else // go back in orthogonal direction to tangent vector
       {
-        scaleMatrixRows(solverData->n+1, solverData->m+1, solverData->hJac2);
+        scaleMatrixRows(solverData->n+1, solverData->m+1, solverData->hJac2, solverData->rowsMax);
         pos = solverData->n+1;
         if (solveSystemWithTotalPivotSearch(data, solverData->n+1, solverData->dy1, solverData->hJac2, solverData->indRow, solverData->indCol, &pos, &rank, solverData->casualTearingSet) == -1)
         {
@@ -2157,6 +2211,10 @@ NLS_SOLVER_STATUS solveHomotopy(DATA *data, threadData_t *threadData, NONLINEAR_
   DATA_HOMOTOPY* homotopyData = (DATA_HOMOTOPY*)(nlsData->solverData);
   DATA_HYBRD* solverDataHybrid;
 
+  if (homotopyData->sparseData) {
+    return solveHomotopySparse(data, threadData, nlsData, homotopyData->sparseData);
+  }
+
   /*
    * Get non-linear equation system
    */
@@ -2180,8 +2238,7 @@ NLS_SOLVER_STATUS solveHomotopy(DATA *data, threadData_t *threadData, NONLINEAR_
   int constraintViolated;
   homotopyData->initHomotopy = nlsData->initHomotopy;
 
-  modelica_boolean* relationsPreBackup;
-  relationsPreBackup = (modelica_boolean*) malloc(data->modelData->nRelations*sizeof(modelica_boolean));
+  modelica_boolean* relationsPreBackup = homotopyData->relationsPreBackup;
 
   homotopyData->f = wrapper_fvec;
   homotopyData->f_con = wrapper_fvec_constraints;
@@ -2276,7 +2333,7 @@ NLS_SOLVER_STATUS solveHomotopy(DATA *data, threadData_t *threadData, NONLINEAR_
       /* calculate scaling factor of residuals */
       matVecMultAbsBB(homotopyData->n, homotopyData->fJac, homotopyData->ones, homotopyData->resScaling);
       debugVectorDouble(LOG_NLS_JAC, "residuum scaling:", homotopyData->resScaling, homotopyData->n);
-      scaleMatrixRows(homotopyData->n, homotopyData->m, homotopyData->fJac);
+      scaleMatrixRows(homotopyData->n, homotopyData->m, homotopyData->fJac, homotopyData->rowsMax);
 
       pos = homotopyData->n;
       assert = (solveSystemWithTotalPivotSearch(data, homotopyData->n, homotopyData->dy0, homotopyData->fJac, homotopyData->indRow, homotopyData->indCol, &pos, &rank, homotopyData->casualTearingSet) == -1);
@@ -2386,7 +2443,7 @@ NLS_SOLVER_STATUS solveHomotopy(DATA *data, threadData_t *threadData, NONLINEAR_
 
           /* calculate scaling factor of residuals */
           matVecMultAbsBB(homotopyData->n, homotopyData->fJac, homotopyData->ones, homotopyData->resScaling);
-          scaleMatrixRows(homotopyData->n, homotopyData->m, homotopyData->fJac);
+          scaleMatrixRows(homotopyData->n, homotopyData->m, homotopyData->fJac, homotopyData->rowsMax);
 
           pos = homotopyData->n;
           solveSystemWithTotalPivotSearch(data, homotopyData->n, homotopyData->dy0, homotopyData->fJac,   homotopyData->indRow, homotopyData->indCol, &pos, &rank, homotopyData->casualTearingSet);
@@ -2500,7 +2557,7 @@ NLS_SOLVER_STATUS solveHomotopy(DATA *data, threadData_t *threadData, NONLINEAR_
       /* calculate scaling factor of residuals */
       matVecMultAbsBB(homotopyData->n, homotopyData->fJac, homotopyData->ones, homotopyData->resScaling);
       debugVectorDouble(LOG_NLS_JAC, "residuum scaling:", homotopyData->resScaling, homotopyData->n);
-      scaleMatrixRows(homotopyData->n, homotopyData->m, homotopyData->fJac);
+      scaleMatrixRows(homotopyData->n, homotopyData->m, homotopyData->fJac, homotopyData->rowsMax);
 
       pos = homotopyData->n;
       assert = (solveSystemWithTotalPivotSearch(data, homotopyData->n, homotopyData->dy0, homotopyData->fJac,   homotopyData->indRow, homotopyData->indCol, &pos, &rank, homotopyData->casualTearingSet) == -1);
@@ -2523,8 +2580,6 @@ NLS_SOLVER_STATUS solveHomotopy(DATA *data, threadData_t *threadData, NONLINEAR_
   {
     debugString(LOG_NLS_V,"Homotopy solver did not converge!");
   }
-  free(relationsPreBackup);
-
   /* write statistics */
   nlsData->numberOfFEval = homotopyData->numberOfFunctionEvaluations;
   nlsData->numberOfIterations = homotopyData->numberOfIterations;
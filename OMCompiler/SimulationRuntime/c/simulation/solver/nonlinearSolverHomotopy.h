@@ -44,6 +44,7 @@ extern "C" {
 
 typedef struct DATA_HOMOTOPY DATA_HOMOTOPY;
 
+size_t homotopyWorkspaceSize(NONLINEAR_SYSTEM_DATA* nlsData, size_t size, long nRelations);
 DATA_HOMOTOPY* allocateHomotopyData(size_t size, NLS_USERDATA* userData);
 void freeHomotopyData(DATA_HOMOTOPY* homotopyData);
 NLS_SOLVER_STATUS solveHomotopy(DATA *data, threadData_t *threadData, NONLINEAR_SYSTEM_DATA* nlsData);
@@ -0,0 +1,900 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-CurrentYear, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/*! \file nonlinearSolverHomotopySparse.c
+ *
+ * The homotopy H(x,lambda) of an initial system has n equations in the n+1
+ * unknowns y = (x,lambda). Its Jacobian has the sparsity pattern of the
+ * non-linear system, lambda is the last column. Every linear system solved
+ * here is the bordered system
+ *
+ *   [ dH/dy * diag(xScaling) ] dy = rhs
+ *   [          c^T           ]
+ *
+ * The border c is the last tangent for the tangent prediction and for the
+ * pseudo-arclength corrector. It is the unit vector of lambda for the last
+ * step and for Newton at fixed lambda. The border row is part of the pattern
+ * in all cases, so KLU analyzes the pattern once and refactorizes along the
+ * whole path.
+ */
+
+#include "omc_config.h"
+
+#include "nonlinearSolverHomotopySparse.h"
+#include "../../util/omc_error.h"
+
+#if !defined(OMC_MINIMAL_RUNTIME) && defined(WITH_SUITESPARSE)
+
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+#include <klu.h>
+
+#include "../options.h"
+#include "../../meta/meta_modelica.h"
+#include "model_help.h"
+#include "nonlinearSystem.h"
+#include "nonlinearWorkspace.h"
+
+/* corrector iterations the step size control aims for */
+#define HOM_SPARSE_OPT_ITERATIONS 4
+/* step halvings of the damped Newton iteration with fixed lambda */
+#define HOM_SPARSE_MAX_DAMPING 10
+
+struct DATA_HOMOTOPY_SPARSE
+{
+  int n;                /* number of equations, lambda is unknown n */
+  int N;                /* size of bordered system: n+1 */
+  int nnz;              /* non-zeros of bordered system */
+
+  /* bordered matrix in CSC format, the border row is the last element of each column */
+  int* Ap;
+  int* Ai;
+  double* Ax;
+  int* patternPos;      /* position in Ax of each element of the NLS pattern, -1 for rows outside of the system */
+
+  klu_symbolic* symbolic;
+  klu_numeric* numeric;
+  klu_common common;
+
+  double* xScaling;     /* nominal values of x, 1 for lambda */
+  double* weights;      /* weights of the norm along the path: 1/n for x, 1 for lambda */
+  double* y;            /* last point on the path */
+  double* yPred;        /* predictor step, start value of the corrector */
+  double* yNew;         /* corrector iterate */
+  double* tangent;      /* scaled tangent at y, norm 1 */
+  double* border;       /* border row c */
+  double* rhs;          /* right hand side and solution of bordered system */
+  double* xSave;        /* work arrays of colored finite differences */
+  double* delta;
+  double* hvec;         /* H(yNew) */
+  double* h2;           /* H at perturbed point */
+  double* resScaling;   /* absolute row sums of scaled Jacobian */
+
+  long maxNumberOfIterations;
+  long numberOfIterations;
+  long numberOfFunctionEvaluations;
+  long numberOfFactorizations;
+  long numberOfRefactorizations;
+
+  NLS_USERDATA* userData;
+};
+
+/**
+ * @brief Check if the sparse homotopy solver can be used.
+ *
+ * It is used for systems with lambda as additional unknown that use KLU as
+ * linear solver, have a sparsity pattern and are bigger than -nlssMinSize.
+ *
+ * @param nlsData             Non-linear system data.
+ * @param size                Size of system without lambda.
+ * @return modelica_boolean   True if the sparse variant should be used.
+ */
+modelica_boolean homotopySparseAvailable(NONLINEAR_SYSTEM_DATA* nlsData, size_t size)
+{
+  return nlsData->isPatternAvailable
+         && nlsData->homotopySupport
+         && nlsData->strictTearingFunctionCall == NULL
+         && nlsData->nlsLinearSolver == NLS_LS_KLU
+         && (size_t)nlsData->size == size + 1
+         && size > (size_t)nonlinearSparseSolverMinSize;
+}
+
+/**
+ * @brief Workspace needed by allocateHomotopySparseData.
+ *
+ * @param nlsData     Non-linear system data.
+ * @param size        Size of system without lambda.
+ * @return size_t     Size in bytes.
+ */
+size_t homotopySparseWorkspaceSize(NONLINEAR_SYSTEM_DATA* nlsData, size_t size)
+{
+  size_t N = size + 1;
+  size_t nnzPattern = nlsData->sparsePattern->numberOfNonZeros;
+
+  return nlsWorkspaceBytes(1, sizeof(DATA_HOMOTOPY_SPARSE))
+         + nlsWorkspaceBytes(N+1, sizeof(int))
+         + nlsWorkspaceBytes(nnzPattern+N, sizeof(int))
+         + nlsWorkspaceBytes(nnzPattern, sizeof(int))
+         + nlsWorkspaceBytes(nnzPattern+N, sizeof(double))
+         + 10*nlsWorkspaceBytes(N, sizeof(double))
+         + 3*nlsWorkspaceBytes(size, sizeof(double));
+}
+
+/**
+ * @brief Allocate memory for sparse homotopy solver and analyze the pattern.
+ *
+ * @param size                    Size of system without lambda.
+ * @param userData                Pointer to set NLS user data.
+ * @return DATA_HOMOTOPY_SPARSE*  Pointer to allocated data.
+ */
+DATA_HOMOTOPY_SPARSE* allocateHomotopySparseData(size_t size, NLS_USERDATA* userData)
+{
+  NONLINEAR_SYSTEM_DATA* nlsData = userData->nlsData;
+  SPARSE_PATTERN* pattern = nlsData->sparsePattern;
+  NLS_WORKSPACE* workspace = getNlsWorkspace(userData);
+  DATA_HOMOTOPY_SPARSE* sparseData;
+  int i, j, k, nth;
+
+  sparseData = (DATA_HOMOTOPY_SPARSE*) nlsWorkspaceCalloc(workspace, 1, sizeof(DATA_HOMOTOPY_SPARSE));
+  sparseData->n = size;
+  sparseData->N = size + 1;
+  sparseData->maxNumberOfIterations = size*100;
+  sparseData->userData = userData;
+
+  sparseData->Ap = (int*) nlsWorkspaceCalloc(workspace, sparseData->N+1, sizeof(int));
+  sparseData->Ai = (int*) nlsWorkspaceCalloc(workspace, pattern->numberOfNonZeros+sparseData->N, sizeof(int));
+  sparseData->patternPos = (int*) nlsWorkspaceCalloc(workspace, pattern->numberOfNonZeros, sizeof(int));
+
+  /* copy the pattern without rows outside of the system and append the border row */
+  k = 0;
+  for (j = 0; j < sparseData->N; j++) {
+    sparseData->Ap[j] = k;
+    for (nth = pattern->leadindex[j]; nth < pattern->leadindex[j+1]; nth++) {
+      i = pattern->index[nth];
+      if (i < sparseData->n) {
+        sparseData->patternPos[nth] = k;
+        sparseData->Ai[k++] = i;
+      } else {
+        sparseData->patternPos[nth] = -1;
+      }
+    }
+    sparseData->Ai[k++] = sparseData->n;
+  }
+  sparseData->Ap[sparseData->N] = k;
+  sparseData->nnz = k;
+  sparseData->Ax = (double*) nlsWorkspaceCalloc(workspace, sparseData->nnz, sizeof(double));
+
+  sparseData->xScaling = (double*) nlsWorkspaceCalloc(workspace, sparseData->N, sizeof(double));
+  sparseData->weights = (double*) nlsWorkspaceCalloc(workspace, sparseData->N, sizeof(double));
+  sparseData->y = (double*) nlsWorkspaceCalloc(workspace, sparseData->N, sizeof(double));
+  sparseData->yPred = (double*) nlsWorkspaceCalloc(workspace, sparseData->N, sizeof(double));
+  sparseData->yNew = (double*) nlsWorkspaceCalloc(workspace, sparseData->N, sizeof(double));
+  sparseData->tangent = (double*) nlsWorkspaceCalloc(workspace, sparseData->N, sizeof(double));
+  sparseData->border = (double*) nlsWorkspaceCalloc(workspace, sparseData->N, sizeof(double));
+  sparseData->rhs = (double*) nlsWorkspaceCalloc(workspace, sparseData->N, sizeof(double));
+  sparseData->xSave = (double*) nlsWorkspaceCalloc(workspace, sparseData->N, sizeof(double));
+  sparseData->delta = (double*) nlsWorkspaceCalloc(workspace, sparseData->N, sizeof(double));
+  sparseData->hvec = (double*) nlsWorkspaceCalloc(workspace, sparseData->n, sizeof(double));
+  sparseData->h2 = (double*) nlsWorkspaceCalloc(workspace, sparseData->n, sizeof(double));
+  sparseData->resScaling = (double*) nlsWorkspaceCalloc(workspace, sparseData->n, sizeof(double));
+
+  for (j = 0; j < sparseData->n; j++) {
+    sparseData->weights[j] = 1.0/sparseData->n;
+  }
+  sparseData->weights[sparseData->n] = 1.0;
+
+  klu_defaults(&sparseData->common);
+  sparseData->symbolic = klu_analyze(sparseData->N, sparseData->Ap, sparseData->Ai, &sparseData->common);
+  if (!sparseData->symbolic) {
+    warningStreamPrint(LOG_NLS, 0, "Sparse homotopy solver: KLU could not analyze the pattern of non-linear system %ld (status %d).",
+                       nlsData->equationIndex, sparseData->common.status);
+  }
+
+  infoStreamPrint(LOG_NLS, 0, "Using sparse homotopy solver for non-linear system %ld of size %d with %d non-zeros.",
+                  nlsData->equationIndex, (int)size, sparseData->nnz - sparseData->N);
+
+  return sparseData;
+}
+
+/**
+ * @brief Free sparse homotopy data.
+ *
+ * @param sparseData  Pointer to sparse homotopy data.
+ */
+void freeHomotopySparseData(DATA_HOMOTOPY_SPARSE* sparseData)
+{
+  NLS_WORKSPACE* workspace = getNlsWorkspace(sparseData->userData);
+
+  if (sparseData->numeric) {
+    klu_free_numeric(&sparseData->numeric, &sparseData->common);
+  }
+  if (sparseData->symbolic) {
+    klu_free_symbolic(&sparseData->symbolic, &sparseData->common);
+  }
+
+  nlsWorkspaceRelease(workspace, sparseData->resScaling);
+  nlsWorkspaceRelease(workspace, sparseData->h2);
+  nlsWorkspaceRelease(workspace, sparseData->hvec);
+  nlsWorkspaceRelease(workspace, sparseData->delta);
+  nlsWorkspaceRelease(workspace, sparseData->xSave);
+  nlsWorkspaceRelease(workspace, sparseData->rhs);
+  nlsWorkspaceRelease(workspace, sparseData->border);
+  nlsWorkspaceRelease(workspace, sparseData->tangent);
+  nlsWorkspaceRelease(workspace, sparseData->yNew);
+  nlsWorkspaceRelease(workspace, sparseData->yPred);
+  nlsWorkspaceRelease(workspace, sparseData->y);
+  nlsWorkspaceRelease(workspace, sparseData->weights);
+  nlsWorkspaceRelease(workspace, sparseData->xScaling);
+  nlsWorkspaceRelease(workspace, sparseData->Ax);
+  nlsWorkspaceRelease(workspace, sparseData->patternPos);
+  nlsWorkspaceRelease(workspace, sparseData->Ai);
+  nlsWorkspaceRelease(workspace, sparseData->Ap);
+  nlsWorkspaceRelease(workspace, sparseData);
+}
+
+/**
+ * @brief Weighted norm along the path.
+ *
+ * Root mean square of the scaled x and absolute value of lambda, so the step
+ * size tau means the same for small and big systems.
+ */
+static double homSparseNorm(DATA_HOMOTOPY_SPARSE* sparseData, const double* v)
+{
+  int j;
+  double sum = 0.0;
+
+  for (j = 0; j < sparseData->N; j++) {
+    sum += sparseData->weights[j]*v[j]*v[j];
+  }
+  return sqrt(sum);
+}
+
+/**
+ * @brief Euclidean norm of the residuals in hvec.
+ */
+static double homSparseResidualNorm(DATA_HOMOTOPY_SPARSE* sparseData)
+{
+  int i;
+  double sum = 0.0;
+
+  for (i = 0; i < sparseData->n; i++) {
+    sum += sparseData->hvec[i]*sparseData->hvec[i];
+  }
+  return sqrt(sum);
+}
+
+/**
+ * @brief Evaluate homotopy function h = H(y).
+ *
+ * @return modelica_boolean   False if the evaluation threw or is not finite.
+ */
+static modelica_boolean homSparseResiduals(DATA_HOMOTOPY_SPARSE* sparseData, double* y, double* h)
+{
+  NONLINEAR_SYSTEM_DATA* nlsData = sparseData->userData->nlsData;
+  threadData_t* threadData = sparseData->userData->threadData;
+  RESIDUAL_USERDATA resUserData = {.data=sparseData->userData->data, .threadData=threadData, .solverData=NULL};
+  int iflag = 0;
+  int i;
+  modelica_boolean success = FALSE;
+
+  sparseData->numberOfFunctionEvaluations++;
+#ifndef OMC_EMCC
+  MMC_TRY_INTERNAL(simulationJumpBuffer)
+#endif
+  nlsData->residualFunc(&resUserData, y, h, &iflag);
+  success = TRUE;
+#ifndef OMC_EMCC
+  MMC_CATCH_INTERNAL(simulationJumpBuffer)
+#endif
+
+  for (i = 0; success && i < sparseData->n; i++) {
+    success = isfinite(h[i]);
+  }
+  return success;
+}
+
+/**
+ * @brief Evaluate the Jacobian of H at y into the bordered matrix.
+ *
+ * Uses the analytic Jacobian if there is one and colored finite differences
+ * otherwise. Columns are scaled with xScaling. Also updates resScaling.
+ *
+ * @param y       Point, H(y) must be the last evaluation of the system.
+ * @param h       H(y).
+ * @return modelica_boolean   False if an evaluation failed.
+ */
+static modelica_boolean homSparseJacobian(DATA_HOMOTOPY_SPARSE* sparseData, double* y, double* h)
+{
+  const double delta_h = sqrt(DBL_EPSILON*2e1);
+  NLS_USERDATA* userData = sparseData->userData;
+  NONLINEAR_SYSTEM_DATA* nlsData = userData->nlsData;
+  SPARSE_PATTERN* pattern = nlsData->sparsePattern;
+  ANALYTIC_JACOBIAN* jacobian = userData->analyticJacobian;
+  threadData_t* threadData = userData->threadData;
+  int N = sparseData->N;
+  int color, i, j, k, nth;
+  modelica_boolean success = TRUE;
+
+  rt_ext_tp_tick(&nlsData->jacobianTimeClock);
+
+  if (nlsData->jacobianIndex != -1 && jacobian != NULL) {
+    success = FALSE;
+#ifndef OMC_EMCC
+    MMC_TRY_INTERNAL(simulationJumpBuffer)
+#endif
+    if (jacobian->constantEqns != NULL) {
+      jacobian->constantEqns(userData->data, threadData, jacobian, NULL);
+    }
+    for (color = 0; color < pattern->maxColors; color++) {
+      for (j = 0; j < N; j++) {
+        if (pattern->colorCols[j]-1 == color) {
+          jacobian->seedVars[j] = 1.0;
+        }
+      }
+      nlsData->analyticalJacobianColumn(userData->data, threadData, jacobian, NULL);
+      for (j = 0; j < N; j++) {
+        if (pattern->colorCols[j]-1 == color) {
+          for (nth = pattern->leadindex[j]; nth < pattern->leadindex[j+1]; nth++) {
+            if (sparseData->patternPos[nth] >= 0) {
+              sparseData->Ax[sparseData->patternPos[nth]] = jacobian->resultVars[pattern->index[nth]]*sparseData->xScaling[j];
+            }
+          }
+          jacobian->seedVars[j] = 0.0;
+        }
+      }
+    }
+    success = TRUE;
+#ifndef OMC_EMCC
+    MMC_CATCH_INTERNAL(simulationJumpBuffer)
+#endif
+    if (!success) {
+      memset(jacobian->seedVars, 0, N*sizeof(double));
+    }
+  } else {
+    for (color = 0; success && color < pattern->maxColors; color++) {
+      for (j = 0; j < N; j++) {
+        if (pattern->colorCols[j]-1 == color) {
+          sparseData->xSave[j] = y[j];
+          sparseData->delta[j] = delta_h*(fabs(y[j]) + 1.0);
+          if (y[j] + sparseData->delta[j] >= nlsData->max[j]) {
+            sparseData->delta[j] *= -1;
+          }
+          y[j] += sparseData->delta[j];
+          sparseData->delta[j] = 1.0/sparseData->delta[j]*sparseData->xScaling[j];
+        }
+      }
+      success = homSparseResiduals(sparseData, y, sparseData->h2);
+      for (j = 0; j < N; j++) {
+        if (pattern->colorCols[j]-1 == color) {
+          for (nth = pattern->leadindex[j]; success && nth < pattern->leadindex[j+1]; nth++) {
+            if (sparseData->patternPos[nth] >= 0) {
+              i = pattern->index[nth];
+              sparseData->Ax[sparseData->patternPos[nth]] = (sparseData->h2[i] - h[i])*sparseData->delta[j];
+            }
+          }
+          y[j] = sparseData->xSave[j];
+        }
+      }
+    }
+  }
+
+  /* residual scaling, without the border row */
+  memset(sparseData->resScaling, 0, sparseData->n*sizeof(double));
+  for (j = 0; j < N; j++) {
+    for (k = sparseData->Ap[j]; k < sparseData->Ap[j+1]-1; k++) {
+      sparseData->resScaling[sparseData->Ai[k]] += fabs(sparseData->Ax[k]);
+    }
+  }
+
+  nlsData->jacobianTime += rt_ext_tp_tock(&(nlsData->jacobianTimeClock));
+  nlsData->numberOfJEval++;
+
+  return success;
+}
+
+/**
+ * @brief Set border row and factorize the bordered matrix.
+ *
+ * The pattern is the same along the whole path, so the pivots of the last
+ * factorization are reused unless the refactorization fails or becomes
+ * inaccurate.
+ */
+static modelica_boolean homSparseFactorize(DATA_HOMOTOPY_SPARSE* sparseData)
+{
+  int j;
+
+  if (!sparseData->symbolic) {
+    return FALSE;
+  }
+
+  for (j = 0; j < sparseData->N; j++) {
+    sparseData->Ax[sparseData->Ap[j+1]-1] = sparseData->border[j];
+  }
+
+  if (sparseData->numeric) {
+    if (klu_refactor(sparseData->Ap, sparseData->Ai, sparseData->Ax, sparseData->symbolic, sparseData->numeric, &sparseData->common)
+        && klu_rgrowth(sparseData->Ap, sparseData->Ai, sparseData->Ax, sparseData->symbolic, sparseData->numeric, &sparseData->common)
+        && sparseData->common.rgrowth >= 1e-3) {
+      sparseData->numberOfRefactorizations++;
+      return TRUE;
+    }
+    klu_free_numeric(&sparseData->numeric, &sparseData->common);
+  }
+
+  sparseData->numeric = klu_factor(sparseData->Ap, sparseData->Ai, sparseData->Ax, sparseData->symbolic, &sparseData->common);
+  sparseData->numberOfFactorizations++;
+  if (!sparseData->numeric || sparseData->common.status != KLU_OK) {
+    debugInt(LOG_NLS_HOMOTOPY, "KLU factorization failed with status ", sparseData->common.status);
+    return FALSE;
+  }
+  return TRUE;
+}
+
+/**
+ * @brief Set border to the unit vector of lambda.
+ */
+static void homSparseFixLambda(DATA_HOMOTOPY_SPARSE* sparseData)
+{
+  memset(sparseData->border, 0, sparseData->N*sizeof(double));
+  sparseData->border[sparseData->n] = 1.0;
+}
+
+/**
+ * @brief Damped Newton iteration with fixed lambda, starting at yPred.
+ *
+ * Used outside of the homotopy path, i.e. for the lambda0-system and for
+ * event iterations. Each step is halved until the norm of the residuals
+ * decreases, so a start value far from the solution does not make the
+ * iteration diverge. The solution is returned in yNew.
+ *
+ * @return int    Number of Newton steps or -1 if it did not converge.
+ */
+static int homSparseDampedNewton(DATA_HOMOTOPY_SPARSE* sparseData, double tol, long maxIter)
+{
+  int n = sparseData->n;
+  int iter, i, j, k;
+  double error_h, error_hNew = 0.0, step, dyNorm;
+
+  homSparseFixLambda(sparseData);
+  memcpy(sparseData->yNew, sparseData->yPred, sparseData->N*sizeof(double));
+  if (!homSparseResiduals(sparseData, sparseData->yNew, sparseData->hvec)) {
+    debugString(LOG_NLS_HOMOTOPY, "damped Newton: function value could not be calculated at the start value");
+    return -1;
+  }
+  error_h = homSparseResidualNorm(sparseData);
+
+  for (iter = 0; ; iter++) {
+    debugDouble(LOG_NLS_HOMOTOPY, "damped Newton: error_h =", error_h);
+    if (error_h < tol) {
+      return iter;
+    }
+    if (iter >= maxIter) {
+      debugString(LOG_NLS_HOMOTOPY, "damped Newton: maximum number of Newton steps reached");
+      return -1;
+    }
+
+    if (!homSparseJacobian(sparseData, sparseData->yNew, sparseData->hvec) || !homSparseFactorize(sparseData)) {
+      debugString(LOG_NLS_HOMOTOPY, "damped Newton: Jacobian could not be calculated or is singular");
+      return -1;
+    }
+    for (i = 0; i < n; i++) {
+      sparseData->rhs[i] = -sparseData->hvec[i];
+    }
+    sparseData->rhs[n] = 0.0;
+    if (!klu_solve(sparseData->symbolic, sparseData->numeric, sparseData->N, 1, sparseData->rhs, &sparseData->common)) {
+      return -1;
+    }
+    dyNorm = homSparseNorm(sparseData, sparseData->rhs);
+    if (!isfinite(dyNorm)) {
+      return -1;
+    }
+
+    /* accepted point is the base of the line search */
+    memcpy(sparseData->yPred, sparseData->yNew, sparseData->N*sizeof(double));
+    for (k = 0, step = 1.0; ; k++, step *= 0.5) {
+      for (j = 0; j < sparseData->N; j++) {
+        sparseData->yNew[j] = sparseData->yPred[j] + step*sparseData->rhs[j]*sparseData->xScaling[j];
+      }
+      if (homSparseResiduals(sparseData, sparseData->yNew, sparseData->hvec)) {
+        error_hNew = homSparseResidualNorm(sparseData);
+        if (isfinite(error_hNew) && error_hNew < (1.0 - 1e-4*step)*error_h) {
+          break;
+        }
+      }
+      if (k == HOM_SPARSE_MAX_DAMPING) {
+        debugDouble(LOG_NLS_HOMOTOPY, "damped Newton: no decrease of the residuals, |dy| =", dyNorm);
+        return -1;
+      }
+    }
+    if (k > 0) {
+      debugDouble(LOG_NLS_HOMOTOPY, "damped Newton: step damped with factor", step);
+    }
+    error_h = error_hNew;
+    sparseData->numberOfIterations++;
+    if (step*dyNorm < newtonXTol) {
+      return iter + 1;
+    }
+  }
+}
+
+/**
+ * @brief Tangent of the path at y.
+ *
+ * Solves the bordered system with the border set to the weighted last
+ * tangent, so the new tangent points in the same direction.
+ * The Jacobian at y has to be evaluated before.
+ */
+static modelica_boolean homSparseTangent(DATA_HOMOTOPY_SPARSE* sparseData)
+{
+  int j;
+  double norm;
+
+  if (!homSparseFactorize(sparseData)) {
+    return FALSE;
+  }
+  memset(sparseData->rhs, 0, sparseData->N*sizeof(double));
+  sparseData->rhs[sparseData->n] = 1.0;
+  if (!klu_solve(sparseData->symbolic, sparseData->numeric, sparseData->N, 1, sparseData->rhs, &sparseData->common)) {
+    return FALSE;
+  }
+
+  norm = homSparseNorm(sparseData, sparseData->rhs);
+  if (!isfinite(norm) || norm <= 0.0) {
+    return FALSE;
+  }
+  for (j = 0; j < sparseData->N; j++) {
+    sparseData->tangent[j] = sparseData->rhs[j]/norm;
+  }
+  return TRUE;
+}
+
+/**
+ * @brief Newton corrector on the bordered system.
+ *
+ * Solves H(y) = 0 and c^T (y-yPred)/xScaling = 0 starting at yPred, with the
+ * border c. Stops if the Newton steps do not contract.
+ *
+ * @param tol       Tolerance for the residuals of H.
+ * @param maxIter   Maximum number of Newton steps.
+ * @return int      Number of Newton steps, -1 if the corrector failed.
+ *                  The result is in yNew and hvec.
+ */
+static int homSparseCorrector(DATA_HOMOTOPY_SPARSE* sparseData, double tol, long maxIter)
+{
+  int n = sparseData->n;
+  int iter, i, j;
+  double error_h, error_h_scaled;
+  double dyNorm, dyNormOld = 0.0;
+
+  memcpy(sparseData->yNew, sparseData->yPred, sparseData->N*sizeof(double));
+  if (!homSparseResiduals(sparseData, sparseData->yNew, sparseData->hvec)) {
+    debugString(LOG_NLS_HOMOTOPY, "corrector: function value could not be calculated at the predictor step");
+    return -1;
+  }
+
+  for (iter = 0; ; iter++) {
+    error_h = 0.0;
+    error_h_scaled = 0.0;
+    for (i = 0; i < n; i++) {
+      error_h += sparseData->hvec[i]*sparseData->hvec[i];
+      if (sparseData->resScaling[i] > 0.0) {
+        error_h_scaled += (sparseData->hvec[i]/sparseData->resScaling[i])*(sparseData->hvec[i]/sparseData->resScaling[i]);
+      }
+    }
+    error_h = sqrt(error_h);
+    error_h_scaled = sqrt(error_h_scaled);
+    debugDouble(LOG_NLS_HOMOTOPY, "corrector: error_h =", error_h);
+
+    if (error_h < tol || (iter > 0 && error_h_scaled < tol)) {
+      return iter;
+    }
+    if (iter >= maxIter) {
+      debugString(LOG_NLS_HOMOTOPY, "corrector: maximum number of Newton steps reached");
+      return -1;
+    }
+
+    if (!homSparseJacobian(sparseData, sparseData->yNew, sparseData->hvec) || !homSparseFactorize(sparseData)) {
+      debugString(LOG_NLS_HOMOTOPY, "corrector: Jacobian could not be calculated or is singular");
+      return -1;
+    }
+    for (i = 0; i < n; i++) {
+      sparseData->rhs[i] = -sparseData->hvec[i];
+    }
+    sparseData->rhs[n] = 0.0;
+    for (j = 0; j < sparseData->N; j++) {
+      sparseData->rhs[n] -= sparseData->border[j]*(sparseData->yNew[j] - sparseData->yPred[j])/sparseData->xScaling[j];
+    }
+    if (!klu_solve(sparseData->symbolic, sparseData->numeric, sparseData->N, 1, sparseData->rhs, &sparseData->common)) {
+      return -1;
+    }
+
+    dyNorm = homSparseNorm(sparseData, sparseData->rhs);
+    if (!isfinite(dyNorm) || (iter > 0 && dyNorm >= dyNormOld && dyNorm > newtonXTol)) {
+      debugDouble(LOG_NLS_HOMOTOPY, "corrector: Newton step does not contract, |dy| =", dyNorm);
+      return -1;
+    }
+    dyNormOld = dyNorm;
+
+    for (j = 0; j < sparseData->N; j++) {
+      sparseData->yNew[j] += sparseData->rhs[j]*sparseData->xScaling[j];
+    }
+    sparseData->numberOfIterations++;
+    if (!homSparseResiduals(sparseData, sparseData->yNew, sparseData->hvec)) {
+      debugString(LOG_NLS_HOMOTOPY, "corrector: function value could not be calculated");
+      return -1;
+    }
+    if (dyNorm < newtonXTol) {
+      return iter + 1;
+    }
+  }
+}
+
+/**
+ * @brief Follow the homotopy path from lambda = 0 in y to lambda = 1.
+ *
+ * Pseudo-arclength predictor-corrector method. The step size tau is adapted
+ * from the number of corrector iterations: it grows if the corrector needs
+ * less than HOM_SPARSE_OPT_ITERATIONS steps and shrinks if it needs more.
+ * A failed corrector reduces tau by -homTauDecFac.
+ *
+ * @param startDirection  Direction of lambda at the start, 1 or -1.
+ * @param numSteps        Number of accepted steps.
+ * @return int            0 on success, -1 otherwise.
+ */
+static int homSparsePath(DATA_HOMOTOPY_SPARSE* sparseData, double startDirection, int* numSteps)
+{
+  int n = sparseData->n;
+  int N = sparseData->N;
+  int j, iter;
+  int tries = 0;
+  long maxLambdaSteps = homMaxLambdaSteps ? homMaxLambdaSteps : sparseData->maxNumberOfIterations;
+  double tau = homTauStart, preTau, factor;
+  modelica_boolean lastStep;
+
+  *numSteps = 0;
+
+  if (!homSparseResiduals(sparseData, sparseData->y, sparseData->hvec)) {
+    warningStreamPrint(LOG_ASSERT, 0, "Sparse homotopy algorithm did not converge.\nThe homotopy function could not be evaluated at the start point.\nYou can use -lv=LOG_INIT_HOMOTOPY,LOG_NLS_HOMOTOPY to get more information.");
+    return -1;
+  }
+
+  /* the first tangent points in start direction of lambda */
+  memset(sparseData->border, 0, N*sizeof(double));
+  sparseData->border[n] = startDirection;
+
+  while (sparseData->y[n] < 1.0)
+  {
+    infoStreamPrint(LOG_INIT_HOMOTOPY, 0, "homotopy parameter lambda = %g", sparseData->y[n]);
+
+    if (tries >= homMaxTries) {
+      warningStreamPrint(LOG_ASSERT, 0, "Sparse homotopy algorithm did not converge.\nThe maximum number of tries for one lambda is reached (%d).\nYou can change the number of tries with:\n\t-homMaxTries=<value>\nor the minimum step size with:\n\t-homTauMin=<value>\nYou can use -lv=LOG_INIT_HOMOTOPY,LOG_NLS_HOMOTOPY to get more information.", tries);
+      return -1;
+    }
+    if (sparseData->y[n] < -1.0) {
+      warningStreamPrint(LOG_ASSERT, 0, "Sparse homotopy algorithm did not converge.\nlambda is smaller than -1: lambda=%g\nYou can use -lv=LOG_INIT_HOMOTOPY,LOG_NLS_HOMOTOPY to get more information.", sparseData->y[n]);
+      return -1;
+    }
+    if (*numSteps >= maxLambdaSteps) {
+      warningStreamPrint(LOG_ASSERT, 0, "Sparse homotopy algorithm did not converge.\nThe maximum number of lambda steps is reached (%ld).\nYou can change the maximum number of lambda steps with:\n\t-homMaxLambdaSteps=<value>\nYou can use -lv=LOG_INIT_HOMOTOPY,LOG_NLS_HOMOTOPY to get more information.", maxLambdaSteps);
+      return -1;
+    }
+
+    /* tangent at a new point on the path */
+    if (tries == 0) {
+      if (!homSparseJacobian(sparseData, sparseData->y, sparseData->hvec) || !homSparseTangent(sparseData)) {
+        warningStreamPrint(LOG_ASSERT, 0, "Sparse homotopy algorithm did not converge.\nThe bordered system for the tangent is singular at lambda=%g.\nYou can use -lv=LOG_INIT_HOMOTOPY,LOG_NLS_HOMOTOPY to get more information.", sparseData->y[n]);
+        return -1;
+      }
+      debugDouble(LOG_NLS_HOMOTOPY, "tangent: dlambda =", sparseData->tangent[n]);
+    }
+
+    /* predictor, shortened to end exactly at lambda = 1 */
+    lastStep = sparseData->tangent[n] > 0.0 && sparseData->y[n] + tau*sparseData->tangent[n] >= 1.0;
+    if (lastStep) {
+      tau = (1.0 - sparseData->y[n])/sparseData->tangent[n];
+    }
+    for (j = 0; j < N; j++) {
+      sparseData->yPred[j] = sparseData->y[j] + tau*sparseData->tangent[j]*sparseData->xScaling[j];
+    }
+    debugDouble(LOG_NLS_HOMOTOPY, "predictor step: tau =", tau);
+
+    /* corrector orthogonal to the tangent, or at fixed lambda = 1 in the last step */
+    if (lastStep) {
+      sparseData->yPred[n] = 1.0;
+      homSparseFixLambda(sparseData);
+      iter = homSparseCorrector(sparseData, newtonFTol, homMaxNewtonSteps);
+    } else {
+      for (j = 0; j < N; j++) {
+        sparseData->border[j] = sparseData->weights[j]*sparseData->tangent[j];
+      }
+      iter = homSparseCorrector(sparseData, homHEps, homMaxNewtonSteps);
+    }
+
+    if (iter < 0) {
+      preTau = tau;
+      tau = fmax(homTauMin, tau/homTauDecreasingFactor);
+      debugDouble(LOG_NLS_HOMOTOPY, "corrector failed, decreasing step size tau to", tau);
+      tries = (tau == preTau) ? homMaxTries : tries + 1;
+      /* the border of the next tangent is the weighted current tangent */
+      for (j = 0; j < N; j++) {
+        sparseData->border[j] = sparseData->weights[j]*sparseData->tangent[j];
+      }
+      continue;
+    }
+
+    /* step accepted */
+    memcpy(sparseData->y, sparseData->yNew, N*sizeof(double));
+    if (lastStep) {
+      sparseData->y[n] = 1.0;
+    }
+    for (j = 0; j < N; j++) {
+      sparseData->border[j] = sparseData->weights[j]*sparseData->tangent[j];
+    }
+    tries = 0;
+    (*numSteps)++;
+
+    /* step size from the number of corrector iterations */
+    factor = (double)HOM_SPARSE_OPT_ITERATIONS/(iter > 0 ? iter : 1);
+    factor = fmin(homTauIncreasingFactor, fmax(1.0/homTauDecreasingFactor, factor));
+    tau = fmin(homTauMax, fmax(homTauMin, tau*factor));
+    debugInt(LOG_NLS_HOMOTOPY, "step accepted, corrector iterations:", iter);
+    debugDouble(LOG_NLS_HOMOTOPY, "new step size tau =", tau);
+  }
+
+  /* the corrector may end slightly behind lambda = 1, solve at lambda = 1 */
+  if (sparseData->y[n] != 1.0) {
+    memcpy(sparseData->yPred, sparseData->y, N*sizeof(double));
+    sparseData->yPred[n] = 1.0;
+    homSparseFixLambda(sparseData);
+    if (homSparseCorrector(sparseData, newtonFTol, homMaxNewtonSteps) < 0) {
+      warningStreamPrint(LOG_ASSERT, 0, "Sparse homotopy algorithm did not converge.\nNo solution at lambda = 1 near the end of the path.\nYou can use -lv=LOG_INIT_HOMOTOPY,LOG_NLS_HOMOTOPY to get more information.");
+      return -1;
+    }
+    memcpy(sparseData->y, sparseData->yNew, N*sizeof(double));
+    sparseData->y[n] = 1.0;
+  }
+  infoStreamPrint(LOG_INIT_HOMOTOPY, 0, "homotopy parameter lambda = %g", sparseData->y[n]);
+
+  return 0;
+}
+
+/**
+ * @brief Solve non-linear system with the sparse homotopy solver.
+ *
+ * With nlsData->initHomotopy the path from lambda = 0 to lambda = 1 is
+ * followed, first in start direction and then in opposite direction.
+ * Otherwise the system is solved with Newton at fixed lambda.
+ *
+ * @param data                Pointer to data struct.
+ * @param threadData          Pointer to thread data.
+ * @param nlsData             Non-linear system data.
+ * @param sparseData          Sparse homotopy data.
+ * @return NLS_SOLVER_STATUS  Return NLS_SOLVED on success and NLS_FAILED otherwise.
+ */
+NLS_SOLVER_STATUS solveHomotopySparse(DATA *data, threadData_t *threadData, NONLINEAR_SYSTEM_DATA* nlsData, DATA_HOMOTOPY_SPARSE* sparseData)
+{
+  NLS_SOLVER_STATUS success = NLS_FAILED;
+  int n = sparseData->n;
+  int i, run, numSteps = 0;
+  double startDirection;
+  double* xStart = data->simulationInfo->discreteCall ? nlsData->nlsx : nlsData->nlsxExtrapolation;
+  long numberOfFunctionEvaluationsOld = sparseData->numberOfFunctionEvaluations;
+
+  debugString(LOG_NLS_V, "------------------------------------------------------");
+  if (nlsData->initHomotopy)
+    debugString(LOG_NLS_V, "SOLVING HOMOTOPY INITIALIZATION PROBLEM WITH THE SPARSE HOMOTOPY SOLVER");
+  else
+    debugString(LOG_NLS_V, "SOLVING NON-LINEAR SYSTEM WITH NEWTON OF THE SPARSE HOMOTOPY SOLVER");
+  debugInt(LOG_NLS_V, "EQUATION NUMBER:", (int)nlsData->equationIndex);
+  debugDouble(LOG_NLS_V, "TIME:", data->localData[0]->timeValue);
+
+  /* use actual working point for scaling */
+  for (i = 0; i < n; i++) {
+    sparseData->xScaling[i] = fmax(nlsData->nominal[i], fabs(xStart[i]));
+  }
+  sparseData->xScaling[n] = 1.0;
+  /* no residual scaling before the first Jacobian */
+  memset(sparseData->resScaling, 0, n*sizeof(double));
+
+  if (nlsData->initHomotopy) {
+    for (run = 0; run < 2 && success != NLS_SOLVED; run++) {
+      startDirection = omc_flag[FLAG_HOMOTOPY_NEG_START_DIR] ? -1.0 : 1.0;
+      if (run == 1) {
+        startDirection = -startDirection;
+        infoStreamPrint(LOG_ASSERT, 0, "The homotopy algorithm is started again with opposing start direction.");
+      }
+      debugDouble(LOG_INIT_HOMOTOPY, "startDirection = ", startDirection);
+      memcpy(sparseData->y, xStart, n*sizeof(double));
+      sparseData->y[n] = 0.0;
+      if (homSparsePath(sparseData, startDirection, &numSteps) == 0) {
+        success = NLS_SOLVED;
+        data->simulationInfo->homotopySteps += numSteps;
+        debugInt(LOG_INIT_HOMOTOPY, "Total number of lambda steps for this homotopy loop:", numSteps);
+      }
+    }
+  } else {
+    /* lambda is fixed: 1 for the actual system, 0 for the lambda0-system */
+    memcpy(sparseData->yPred, xStart, n*sizeof(double));
+    sparseData->yPred[n] = nlsData->homotopySupport ? 1.0 : 0.0;
+    if (homSparseDampedNewton(sparseData, newtonFTol, sparseData->maxNumberOfIterations) >= 0) {
+      memcpy(sparseData->y, sparseData->yNew, sparseData->N*sizeof(double));
+      success = NLS_SOLVED;
+    }
+  }
+
+  if (success == NLS_SOLVED) {
+    memcpy(nlsData->nlsx, sparseData->y, n*sizeof(double));
+    debugString(LOG_NLS_V, "SYSTEM SOLVED");
+  } else {
+    debugString(LOG_NLS_V, "Sparse homotopy solver did not converge!");
+  }
+  debugInt(LOG_NLS_V, "number of function calls: ", (int)(sparseData->numberOfFunctionEvaluations - numberOfFunctionEvaluationsOld));
+  debugInt(LOG_NLS_V, "KLU factorizations:       ", (int)sparseData->numberOfFactorizations);
+  debugInt(LOG_NLS_V, "KLU refactorizations:     ", (int)sparseData->numberOfRefactorizations);
+  debugString(LOG_NLS_V, "------------------------------------------------------");
+
+  /* write statistics */
+  nlsData->numberOfFEval = sparseData->numberOfFunctionEvaluations;
+  nlsData->numberOfIterations = sparseData->numberOfIterations;
+
+  return success;
+}
+
+#else /* !OMC_MINIMAL_RUNTIME && WITH_SUITESPARSE */
+
+modelica_boolean homotopySparseAvailable(NONLINEAR_SYSTEM_DATA* nlsData, size_t size)
+{
+  return 0;
+}
+
+size_t homotopySparseWorkspaceSize(NONLINEAR_SYSTEM_DATA* nlsData, size_t size)
+{
+  return 0;
+}
+
+DATA_HOMOTOPY_SPARSE* allocateHomotopySparseData(size_t size, NLS_USERDATA* userData)
+{
+  throwStreamPrint(NULL, "No sparse homotopy solver available, compiled without SuiteSparse.");
+  return NULL;
+}
+
+void freeHomotopySparseData(DATA_HOMOTOPY_SPARSE* sparseData)
+{
+}
+
+NLS_SOLVER_STATUS solveHomotopySparse(DATA *data, threadData_t *threadData, NONLINEAR_SYSTEM_DATA* nlsData, DATA_HOMOTOPY_SPARSE* sparseData)
+{
+  throwStreamPrint(threadData, "No sparse homotopy solver available, compiled without SuiteSparse.");
+  return NLS_FAILED;
+}
+
+#endif /* !OMC_MINIMAL_RUNTIME && WITH_SUITESPARSE */
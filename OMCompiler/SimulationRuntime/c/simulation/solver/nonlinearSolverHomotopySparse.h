@@ -0,0 +1,61 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-CurrentYear, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+
+/*! \file nonlinearSolverHomotopySparse.h
+ *
+ * Sparse variant of the homotopy solver for large initial systems with
+ * homotopy (adaptive local and global approach). The path is followed with a
+ * pseudo-arclength predictor-corrector method; all linear systems are
+ * bordered systems factorized with KLU.
+ */
+
+#ifndef _NONLINEARSOLVERHOMOTOPYSPARSE_H_
+#define _NONLINEARSOLVERHOMOTOPYSPARSE_H_
+
+#include "../../simulation_data.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct DATA_HOMOTOPY_SPARSE DATA_HOMOTOPY_SPARSE;
+
+modelica_boolean homotopySparseAvailable(NONLINEAR_SYSTEM_DATA* nlsData, size_t size);
+size_t homotopySparseWorkspaceSize(NONLINEAR_SYSTEM_DATA* nlsData, size_t size);
+DATA_HOMOTOPY_SPARSE* allocateHomotopySparseData(size_t size, NLS_USERDATA* userData);
+void freeHomotopySparseData(DATA_HOMOTOPY_SPARSE* sparseData);
+NLS_SOLVER_STATUS solveHomotopySparse(DATA *data, threadData_t *threadData, NONLINEAR_SYSTEM_DATA* nlsData, DATA_HOMOTOPY_SPARSE* sparseData);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _NONLINEARSOLVERHOMOTOPYSPARSE_H_ */
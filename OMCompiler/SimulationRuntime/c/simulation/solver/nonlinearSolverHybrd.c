@@ -48,11 +48,29 @@ extern "C" {
 
 #include "nonlinearSystem.h"
 #include "nonlinearSolverHybrd.h"
+#include "nonlinearWorkspace.h"
 
 extern double enorm_(integer *n, double *x);
 
 static void wrapper_fvec_hybrj(const integer *n_p, const double* x, double* f, double* fjac, const integer* ldjac, const integer* iflag, void* userData);
 
+/**
+ * @brief Workspace needed by allocateHybrdData.
+ *
+ * @param size        Size of non-linear system.
+ * @param nRelations  Number of relations of the model.
+ * @return size_t     Size in bytes.
+ */
+size_t hybrdWorkspaceSize(size_t size, long nRelations)
+{
+  return nlsWorkspaceBytes(1, sizeof(DATA_HYBRD))
+       + 12*nlsWorkspaceBytes(size, sizeof(double))
+       + 3*nlsWorkspaceBytes(size+1, sizeof(double))
+       + 2*nlsWorkspaceBytes(size*(size+1), sizeof(double))
+       + nlsWorkspaceBytes((size*(size+1))/2, sizeof(double))
+       + nlsWorkspaceBytes(nRelations, sizeof(modelica_boolean));
+}
+
 /**
  * @brief Allocate memory for non-linear hybrid solver.
  *
@@ -61,44 +79,46 @@ static void wrapper_fvec_hybrj(const integer *n_p, const double* x, double* f, d
  */
 DATA_HYBRD* allocateHybrdData(size_t size, NLS_USERDATA* userData)
 {
-  DATA_HYBRD* hybrdData = (DATA_HYBRD*) malloc(sizeof(DATA_HYBRD));
+  NLS_WORKSPACE* workspace = getNlsWorkspace(userData);
+  DATA_HYBRD* hybrdData = (DATA_HYBRD*) nlsWorkspaceCalloc(workspace, 1, sizeof(DATA_HYBRD));
   assertStreamPrint(NULL, hybrdData != NULL, "allocationHybrdData() failed!");
 
   hybrdData->initialized = 0;
-  hybrdData->resScaling = (double*) malloc(size*sizeof(double));
-  hybrdData->fvecScaled = (double*) malloc(size*sizeof(double));
+  hybrdData->resScaling = (double*) nlsWorkspaceCalloc(workspace, size, sizeof(double));
+  hybrdData->fvecScaled = (double*) nlsWorkspaceCalloc(workspace, size, sizeof(double));
   hybrdData->useXScaling = 1;
-  hybrdData->xScalefactors = (double*) malloc(size*sizeof(double));
+  hybrdData->xScalefactors = (double*) nlsWorkspaceCalloc(workspace, size, sizeof(double));
 
   hybrdData->n = size;
-  hybrdData->x = (double*) malloc((size+1)*sizeof(double));
-  hybrdData->xSave = (double*) malloc((size+1)*sizeof(double));
-  hybrdData->xScaled = (double*) malloc((size+1)*sizeof(double));
-  hybrdData->fvec = (double*) calloc(size, sizeof(double));
-  hybrdData->fvecSave = (double*) calloc(size, sizeof(double));
+  hybrdData->x = (double*) nlsWorkspaceCalloc(workspace, (size+1), sizeof(double));
+  hybrdData->xSave = (double*) nlsWorkspaceCalloc(workspace, (size+1), sizeof(double));
+  hybrdData->xScaled = (double*) nlsWorkspaceCalloc(workspace, (size+1), sizeof(double));
+  hybrdData->fvec = (double*) nlsWorkspaceCalloc(workspace, size, sizeof(double));
+  hybrdData->fvecSave = (double*) nlsWorkspaceCalloc(workspace, size, sizeof(double));
   hybrdData->xtol = 1e-12;
   hybrdData->maxfev = size*10000;
   hybrdData->ml = size - 1;
   hybrdData->mu = size - 1;
   hybrdData->epsfcn = 1e-12;
-  hybrdData->diag = (double*) malloc(size*sizeof(double));
-  hybrdData->diagres = (double*) malloc(size*sizeof(double));
+  hybrdData->diag = (double*) nlsWorkspaceCalloc(workspace, size, sizeof(double));
+  hybrdData->diagres = (double*) nlsWorkspaceCalloc(workspace, size, sizeof(double));
   hybrdData->mode = 1;
   hybrdData->factor = 100.0;
   hybrdData->nprint = -1;
   hybrdData->info = 0;
   hybrdData->nfev = 0;
   hybrdData->njev = 0;
-  hybrdData->fjac = (double*) calloc((size*(size+1)), sizeof(double));
-  hybrdData->fjacobian = (double*) calloc((size*(size+1)), sizeof(double));
+  hybrdData->fjac = (double*) nlsWorkspaceCalloc(workspace, (size*(size+1)), sizeof(double));
+  hybrdData->fjacobian = (double*) nlsWorkspaceCalloc(workspace, (size*(size+1)), sizeof(double));
   hybrdData->ldfjac = size;
-  hybrdData->r__ = (double*) malloc(((size*(size+1))/2)*sizeof(double));
+  hybrdData->r__ = (double*) nlsWorkspaceCalloc(workspace, ((size*(size+1))/2), sizeof(double));
   hybrdData->lr = (size*(size + 1)) / 2;
-  hybrdData->qtf = (double*) malloc(size*sizeof(double));
-  hybrdData->wa1 = (double*) malloc(size*sizeof(double));
-  hybrdData->wa2 = (double*) malloc(size*sizeof(double));
-  hybrdData->wa3 = (double*) malloc(size*sizeof(double));
-  hybrdData->wa4 = (double*) malloc(size*sizeof(double));
+  hybrdData->qtf = (double*) nlsWorkspaceCalloc(workspace, size, sizeof(double));
+  hybrdData->wa1 = (double*) nlsWorkspaceCalloc(workspace, size, sizeof(double));
+  hybrdData->wa2 = (double*) nlsWorkspaceCalloc(workspace, size, sizeof(double));
+  hybrdData->wa3 = (double*) nlsWorkspaceCalloc(workspace, size, sizeof(double));
+  hybrdData->wa4 = (double*) nlsWorkspaceCalloc(workspace, size, sizeof(double));
+  hybrdData->relationsPreBackup = (modelica_boolean*) nlsWorkspaceCalloc(workspace, userData->data->modelData->nRelations, sizeof(modelica_boolean));
 
   hybrdData->numberOfIterations = 0;
   hybrdData->numberOfFunctionEvaluations = 0;
@@ -115,28 +135,31 @@ DATA_HYBRD* allocateHybrdData(size_t size, NLS_USERDATA* userData)
  */
 void freeHybrdData(DATA_HYBRD* hybrdData)
 {
-  free(hybrdData->resScaling);
-  free(hybrdData->fvecScaled);
-  free(hybrdData->xScalefactors);
-  free(hybrdData->x);
-  free(hybrdData->xSave);
-  free(hybrdData->xScaled);
-  free(hybrdData->fvec);
-  free(hybrdData->fvecSave);
-  free(hybrdData->diag);
-  free(hybrdData->diagres);
-  free(hybrdData->fjac);
-  free(hybrdData->fjacobian);
-  free(hybrdData->r__);
-  free(hybrdData->qtf);
-  free(hybrdData->wa1);
-  free(hybrdData->wa2);
-  free(hybrdData->wa3);
-  free(hybrdData->wa4);
+  NLS_WORKSPACE* workspace = getNlsWorkspace(hybrdData->userData);
+
+  nlsWorkspaceRelease(workspace, hybrdData->resScaling);
+  nlsWorkspaceRelease(workspace, hybrdData->fvecScaled);
+  nlsWorkspaceRelease(workspace, hybrdData->xScalefactors);
+  nlsWorkspaceRelease(workspace, hybrdData->x);
+  nlsWorkspaceRelease(workspace, hybrdData->xSave);
+  nlsWorkspaceRelease(workspace, hybrdData->xScaled);
+  nlsWorkspaceRelease(workspace, hybrdData->fvec);
+  nlsWorkspaceRelease(workspace, hybrdData->fvecSave);
+  nlsWorkspaceRelease(workspace, hybrdData->diag);
+  nlsWorkspaceRelease(workspace, hybrdData->diagres);
+  nlsWorkspaceRelease(workspace, hybrdData->fjac);
+  nlsWorkspaceRelease(workspace, hybrdData->fjacobian);
+  nlsWorkspaceRelease(workspace, hybrdData->r__);
+  nlsWorkspaceRelease(workspace, hybrdData->qtf);
+  nlsWorkspaceRelease(workspace, hybrdData->wa1);
+  nlsWorkspaceRelease(workspace, hybrdData->wa2);
+  nlsWorkspaceRelease(workspace, hybrdData->wa3);
+  nlsWorkspaceRelease(workspace, hybrdData->wa4);
+  nlsWorkspaceRelease(workspace, hybrdData->relationsPreBackup);
 
   freeNlsUserData(hybrdData->userData);
 
-  free(hybrdData);
+  nlsWorkspaceRelease(workspace, hybrdData);
   return;
 }
 
@@ -450,9 +473,7 @@ NLS_SOLVER_STATUS solveHybrd(DATA *data, threadData_t *threadData, NONLINEAR_SYS
   int assertRetries = 0;
   int assertMessage = 0;
 
-  modelica_boolean* relationsPreBackup;
-
-  relationsPreBackup = (modelica_boolean*) malloc(data->modelData->nRelations*sizeof(modelica_boolean));
+  modelica_boolean* relationsPreBackup = hybrdData->relationsPreBackup;
 
   hybrdData->numberOfFunctionEvaluations = 0;
 
@@ -1077,8 +1098,6 @@ NLS_SOLVER_STATUS solveHybrd(DATA *data, threadData_t *threadData, NONLINEAR_SYS
   /* iteration in hybrid are equal to the nfev numbers */
   nlsData->numberOfIterations += nfunc_evals;
 
-  free(relationsPreBackup);
-
   return success;
 }
 
@@ -79,6 +79,7 @@ typedef struct DATA_HYBRD
   double* wa2;
   double* wa3;
   double* wa4;
+  modelica_boolean* relationsPreBackup;
 
   unsigned int numberOfIterations; /* over the whole simulation time */
   unsigned int numberOfFunctionEvaluations; /* over the whole simulation time */
@@ -94,6 +95,7 @@ void hybrj_( void(*) (const integer*, const double*, double*, double *, const in
   double *r, integer *lr, double *qtf, double *wa1, double *wa2,
   double *wa3, double *wa4, void* user_data);
 
+size_t hybrdWorkspaceSize(size_t size, long nRelations);
 DATA_HYBRD* allocateHybrdData(size_t size, NLS_USERDATA* userData);
 void freeHybrdData(DATA_HYBRD* hybrdData);
 NLS_SOLVER_STATUS solveHybrd(DATA *data, threadData_t *threadData, NONLINEAR_SYSTEM_DATA* nlsData);
@@ -203,7 +203,7 @@ NLS_SOLVER_STATUS solveNewton(DATA *data, threadData_t *threadData, NONLINEAR_SY
   int retries = 0;
   int retries2 = 0;
   int nonContinuousCase = 0;
-  modelica_boolean *relationsPreBackup = NULL;
+  modelica_boolean *relationsPreBackup = solverData->relationsPreBackup;
   int casualTearingSet = systemData->strictTearingFunctionCall != NULL;
 
   /*
@@ -212,8 +212,6 @@ NLS_SOLVER_STATUS solveNewton(DATA *data, threadData_t *threadData, NONLINEAR_SY
    */
   eqSystemNumber = systemData->equationIndex;
 
-  relationsPreBackup = (modelica_boolean*) malloc(data->modelData->nRelations*sizeof(modelica_boolean));
-
   solverData->nfev = 0;
 
   /* try to calculate jacobian only once at the beginning of the iteration */
@@ -381,8 +379,6 @@ NLS_SOLVER_STATUS solveNewton(DATA *data, threadData_t *threadData, NONLINEAR_SY
   if(ACTIVE_STREAM(LOG_NLS_V))
     messageClose(LOG_NLS_V);
 
-  free(relationsPreBackup);
-
   /* write statistics */
   systemData->numberOfFEval = solverData->numberOfFunctionEvaluations;
   systemData->numberOfIterations = solverData->numberOfIterations;
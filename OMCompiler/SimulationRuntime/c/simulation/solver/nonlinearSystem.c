@@ -34,12 +34,14 @@
 #include <math.h>
 #include <string.h>
 
+#include "../jacobian_cache.h"
 #include "../jacobian_util.h"
 #include "../../util/simulation_options.h"
 #include "../../util/omc_error.h"
 #include "../../util/omc_file.h"
 #include "nonlinearSystem.h"
 #include "nonlinearValuesList.h"
+#include "nonlinearWorkspace.h"
 #if !defined(OMC_MINIMAL_RUNTIME)
 #include "kinsolSolver.h"
 #include "nonlinearSolverHybrd.h"
@@ -353,7 +355,7 @@ int print_csvLineIterStats(void* voidCsvData, int size, int num,
  * @return NLS_USERDATA*    Newly allocated struct with NLS user data.
  */
 NLS_USERDATA* initNlsUserData(DATA* data, threadData_t* threadData, int sysNumber, NONLINEAR_SYSTEM_DATA* nlsData, ANALYTIC_JACOBIAN* analyticJacobian) {
-  NLS_USERDATA* userData = (NLS_USERDATA*) malloc(sizeof(NLS_USERDATA));
+  NLS_USERDATA* userData = (NLS_USERDATA*) nlsWorkspaceCalloc(nlsData ? nlsData->workspace : NULL, 1, sizeof(NLS_USERDATA));
   assertStreamPrint(threadData, userData != NULL, "setNlsUserData failed: userData is NULL");
 
   userData->data = data;
@@ -374,7 +376,68 @@ NLS_USERDATA* initNlsUserData(DATA* data, threadData_t* threadData, int sysNumbe
  * @param userData  Pointer to NLS user data.
  */
 void freeNlsUserData(NLS_USERDATA* userData) {
-  free(userData);
+  nlsWorkspaceRelease(getNlsWorkspace(userData), userData);
+}
+
+/**
+ * @brief Workspace of the non-linear system of NLS user data.
+ *
+ * @param userData          Pointer to NLS user data.
+ * @return NLS_WORKSPACE*   Workspace to take solver memory from, NULL if
+ *                          the solver memory has to come from the heap.
+ */
+NLS_WORKSPACE* getNlsWorkspace(NLS_USERDATA* userData) {
+  return (userData && userData->nlsData) ? userData->nlsData->workspace : NULL;
+}
+
+/**
+ * @brief Size of the workspace of a non-linear system.
+ *
+ * Adds up the work arrays of the system and of the solvers
+ * initializeNonlinearSystemData allocates for nonlinsys->nlsMethod.
+ *
+ * @param data        Runtime data struct.
+ * @param nonlinsys   Pointer to non-linear system.
+ * @return size_t     Size in bytes.
+ */
+static size_t nonlinearSystemWorkspaceSize(DATA *data, NONLINEAR_SYSTEM_DATA *nonlinsys)
+{
+  size_t size = nonlinsys->size;
+  modelica_boolean lambda = nonlinsys->homotopySupport && (data->callback->useHomotopy == 2 || data->callback->useHomotopy == 3);
+  size_t n = lambda ? size-1 : size;
+  long nRelations = data->modelData->nRelations;
+  size_t bytes;
+
+  /* nlsx, nlsxExtrapolation, nlsxOld, resValues and the solutions for extrapolation */
+  bytes = 4*nlsWorkspaceBytes(size, sizeof(double)) + valueListWorkspaceSize(VALUES_LIST_CAPACITY, size);
+  /* user data of up to two solvers and the struct holding them */
+  bytes += 2*nlsWorkspaceBytes(1, sizeof(NLS_USERDATA));
+  bytes += nlsWorkspaceBytes(1, sizeof(struct dataSolver) > sizeof(struct dataMixedSolver) ? sizeof(struct dataSolver) : sizeof(struct dataMixedSolver));
+
+  switch(nonlinsys->nlsMethod)
+  {
+#if !defined(OMC_MINIMAL_RUNTIME)
+  case NLS_HYBRID:
+    bytes += hybrdWorkspaceSize(n, nRelations) + (lambda ? homotopyWorkspaceSize(nonlinsys, n, nRelations) : 0);
+    break;
+  case NLS_KINSOL:
+    bytes += lambda ? homotopyWorkspaceSize(nonlinsys, n, nRelations) : nlsKinsolWorkspaceSize(size);
+    break;
+  case NLS_NEWTON:
+    bytes += newtonWorkspaceSize(n, nRelations) + (lambda ? homotopyWorkspaceSize(nonlinsys, n, nRelations) : 0);
+    break;
+  case NLS_MIXED:
+    bytes += homotopyWorkspaceSize(nonlinsys, n, nRelations) + hybrdWorkspaceSize(n, nRelations);
+    break;
+#endif
+  case NLS_HOMOTOPY:
+    bytes += homotopyWorkspaceSize(nonlinsys, n, nRelations);
+    break;
+  default:
+    break;
+  }
+
+  return bytes;
 }
 
 /**
@@ -397,10 +460,12 @@ void initializeNonlinearSystemData(DATA *data, threadData_t *threadData, NONLINE
   struct dataSolver *solverData;
   struct dataMixedSolver *mixedSolverData;
   ANALYTIC_JACOBIAN* jacobian;
+  char patternName[32];
 
   size = nonlinsys->size;
   nonlinsys->numberOfFEval = 0;
   nonlinsys->numberOfIterations = 0;
+  nonlinsys->workspace = NULL;
 
   /* check if residual function pointer are valid */
   assertStreamPrint(threadData, ((0 != nonlinsys->residualFunc)) || ((nonlinsys->strictTearingFunctionCall != NULL) ? (0 != nonlinsys->strictTearingFunctionCall) : 0), "residual function pointer is invalid" );
@@ -419,25 +484,23 @@ void initializeNonlinearSystemData(DATA *data, threadData_t *threadData, NONLINE
     jacobian = NULL;
   }
 
-  /* allocate system data */
-  nonlinsys->nlsx = (double*) malloc(size*sizeof(double));
-  nonlinsys->nlsxExtrapolation = (double*) malloc(size*sizeof(double));
-  nonlinsys->nlsxOld = (double*) malloc(size*sizeof(double));
-  nonlinsys->resValues = (double*) malloc(size*sizeof(double));
-
-  /* allocate value list*/
-  nonlinsys->oldValueList = allocValueList(1, nonlinsys->size);
-
   nonlinsys->lastTimeSolved = 0.0;
 
   /* Allocate nomianl, min and max */
   nonlinsys->nominal = (double*) malloc(size*sizeof(double));
   nonlinsys->min = (double*) malloc(size*sizeof(double));
   nonlinsys->max = (double*) malloc(size*sizeof(double));
-  /* Init sparsitiy pattern */
-  nonlinsys->initializeStaticNLSData(data, threadData, nonlinsys, 1 /* true */, 1 /* true */);
+  /* Init sparsitiy pattern, patterns in the pattern cache passed the sanity check before */
+  snprintf(patternName, sizeof(patternName), "NLS%ld", (long)nonlinsys->equationIndex);
+  nonlinsys->sparsePattern = lookupSparsePatternCache(data, patternName, size, size);
+  if (nonlinsys->sparsePattern) {
+    nonlinsys->isPatternAvailable = TRUE;
+    nonlinsys->initializeStaticNLSData(data, threadData, nonlinsys, 0 /* false */, 1 /* true */);
+  } else {
+    nonlinsys->initializeStaticNLSData(data, threadData, nonlinsys, 1 /* true */, 1 /* true */);
+  }
 
-  if(nonlinsys->isPatternAvailable) {
+  if(nonlinsys->isPatternAvailable && !nonlinsys->sparsePattern->isCached) {
     /* only test for singularity if sparsity pattern is supposed to be there */
     modelica_boolean useSparsityPattern = sparsitySanityCheck(nonlinsys->sparsePattern, nonlinsys->size, LOG_NLS);
     if (!useSparsityPattern) {
@@ -451,7 +514,9 @@ void initializeNonlinearSystemData(DATA *data, threadData_t *threadData, NONLINE
       free(nonlinsys->sparsePattern);
       nonlinsys->sparsePattern = NULL;
       nonlinsys->isPatternAvailable = FALSE;
-      omc_flag[FLAG_NO_SCALING] = TRUE;
+      data->simulationInfo->nlsNoScaling = TRUE;
+    } else {
+      storeSparsePatternCache(data, patternName, size, size, nonlinsys->sparsePattern);
     }
   }
 
@@ -512,6 +577,18 @@ void initializeNonlinearSystemData(DATA *data, threadData_t *threadData, NONLINE
   }
 #endif
 
+  /* the solver is known now, all further memory of the system comes from its workspace */
+  nonlinsys->workspace = nlsWorkspaceAllocate(nonlinearSystemWorkspaceSize(data, nonlinsys));
+
+  /* allocate system data */
+  nonlinsys->nlsx = (double*) nlsWorkspaceCalloc(nonlinsys->workspace, size, sizeof(double));
+  nonlinsys->nlsxExtrapolation = (double*) nlsWorkspaceCalloc(nonlinsys->workspace, size, sizeof(double));
+  nonlinsys->nlsxOld = (double*) nlsWorkspaceCalloc(nonlinsys->workspace, size, sizeof(double));
+  nonlinsys->resValues = (double*) nlsWorkspaceCalloc(nonlinsys->workspace, size, sizeof(double));
+
+  /* allocate value list*/
+  nonlinsys->oldValueList = allocValueList(VALUES_LIST_CAPACITY, nonlinsys->size, nonlinsys->workspace);
+
   /* Set NLS user data */
   NLS_USERDATA* nlsUserData = initNlsUserData(data, threadData, sysNum, nonlinsys, jacobian);
 
@@ -520,7 +597,7 @@ void initializeNonlinearSystemData(DATA *data, threadData_t *threadData, NONLINE
   {
 #if !defined(OMC_MINIMAL_RUNTIME)
   case NLS_HYBRID:
-    solverData = (struct dataSolver*) malloc(sizeof(struct dataSolver));
+    solverData = (struct dataSolver*) nlsWorkspaceCalloc(nonlinsys->workspace, 1, sizeof(struct dataSolver));
     if (nonlinsys->homotopySupport && (data->callback->useHomotopy == 2 || data->callback->useHomotopy == 3)) {
       solverData->ordinaryData = allocateHybrdData(size-1, nlsUserData);
       nlsUserData = initNlsUserData(data, threadData, sysNum, nonlinsys, jacobian); /* Seperate userData for homotopy solver */
@@ -531,7 +608,7 @@ void initializeNonlinearSystemData(DATA *data, threadData_t *threadData, NONLINE
     nonlinsys->solverData = (void*) solverData;
     break;
   case NLS_KINSOL:
-    solverData = (struct dataSolver*) malloc(sizeof(struct dataSolver));
+    solverData = (struct dataSolver*) nlsWorkspaceCalloc(nonlinsys->workspace, 1, sizeof(struct dataSolver));
     if (nonlinsys->homotopySupport && (data->callback->useHomotopy == 2 || data->callback->useHomotopy == 3)) {
       solverData->initHomotopyData = (void*) allocateHomotopyData(size-1, nlsUserData);
     } else {
@@ -541,7 +618,7 @@ void initializeNonlinearSystemData(DATA *data, threadData_t *threadData, NONLINE
     nonlinsys->solverData = (void*) solverData;
     break;
   case NLS_NEWTON:
-    solverData = (struct dataSolver*) malloc(sizeof(struct dataSolver));
+    solverData = (struct dataSolver*) nlsWorkspaceCalloc(nonlinsys->workspace, 1, sizeof(struct dataSolver));
     if (nonlinsys->homotopySupport && (data->callback->useHomotopy == 2 || data->callback->useHomotopy == 3)) {
       solverData->ordinaryData = (void*) allocateNewtonData(size-1, nlsUserData);
       nlsUserData = initNlsUserData(data, threadData, sysNum, nonlinsys, jacobian); /* Seperate userData for homotopy solver */
@@ -552,7 +629,7 @@ void initializeNonlinearSystemData(DATA *data, threadData_t *threadData, NONLINE
     nonlinsys->solverData = (void*) solverData;
     break;
   case NLS_MIXED:
-    mixedSolverData = (struct dataMixedSolver*) malloc(sizeof(struct dataMixedSolver));
+    mixedSolverData = (struct dataMixedSolver*) nlsWorkspaceCalloc(nonlinsys->workspace, 1, sizeof(struct dataMixedSolver));
     if (nonlinsys->homotopySupport && (data->callback->useHomotopy == 2 || data->callback->useHomotopy == 3)) {
       mixedSolverData->newtonHomotopyData = (void*) allocateHomotopyData(size-1, nlsUserData);
       nlsUserData = initNlsUserData(data, threadData, sysNum, nonlinsys, jacobian); /* Seperate userData for hybrid solver */
@@ -683,14 +760,9 @@ void freeNonlinearSyst(DATA* data, threadData_t* threadData, NONLINEAR_SYSTEM_DA
   struct csvStats* stats;
   NLS_USERDATA* userData;
 
-  free(nonlinsys->nlsx);
-  free(nonlinsys->nlsxExtrapolation);
-  free(nonlinsys->nlsxOld);
-  free(nonlinsys->resValues);
   free(nonlinsys->nominal);
   free(nonlinsys->min);
   free(nonlinsys->max);
-  freeValueList(nonlinsys->oldValueList, 1);
   freeNonlinearPattern(nonlinsys->nonlinearPattern);
 
   /* Free CSV data */
@@ -718,7 +790,7 @@ void freeNonlinearSyst(DATA* data, threadData_t* threadData, NONLINEAR_SYSTEM_DA
     if (nonlinsys->homotopySupport && (data->callback->useHomotopy == 2 || data->callback->useHomotopy == 3)) {
       freeHomotopyData(((struct dataSolver*) nonlinsys->solverData)->initHomotopyData);
     }
-    free(nonlinsys->solverData);
+    nlsWorkspaceRelease(nonlinsys->workspace, nonlinsys->solverData);
     break;
   case NLS_KINSOL:
     if (nonlinsys->homotopySupport && (data->callback->useHomotopy == 2 || data->callback->useHomotopy == 3)) {
@@ -726,14 +798,14 @@ void freeNonlinearSyst(DATA* data, threadData_t* threadData, NONLINEAR_SYSTEM_DA
     } else {
       nlsKinsolFree(((struct dataSolver*) nonlinsys->solverData)->ordinaryData);
     }
-    free(nonlinsys->solverData);
+    nlsWorkspaceRelease(nonlinsys->workspace, nonlinsys->solverData);
     break;
   case NLS_NEWTON:
     freeNewtonData(((struct dataSolver*) nonlinsys->solverData)->ordinaryData);
     if (nonlinsys->homotopySupport && (data->callback->useHomotopy == 2 || data->callback->useHomotopy == 3)) {
       freeHomotopyData(((struct dataSolver*) nonlinsys->solverData)->initHomotopyData);
     }
-    free(nonlinsys->solverData);
+    nlsWorkspaceRelease(nonlinsys->workspace, nonlinsys->solverData);
     break;
 #endif
   case NLS_HOMOTOPY:
@@ -743,13 +815,21 @@ void freeNonlinearSyst(DATA* data, threadData_t* threadData, NONLINEAR_SYSTEM_DA
   case NLS_MIXED:
     freeHomotopyData(((struct dataMixedSolver*) nonlinsys->solverData)->newtonHomotopyData);
     freeHybrdData(((struct dataMixedSolver*) nonlinsys->solverData)->hybridData);
-    free(nonlinsys->solverData);
+    nlsWorkspaceRelease(nonlinsys->workspace, nonlinsys->solverData);
     break;
 #endif
   default:
     throwStreamPrint(threadData, "freeNonlinearSyst: Unrecognized non-linear solver method");
   }
 
+  freeValueList(nonlinsys->oldValueList, nonlinsys->workspace);
+  nlsWorkspaceRelease(nonlinsys->workspace, nonlinsys->nlsx);
+  nlsWorkspaceRelease(nonlinsys->workspace, nonlinsys->nlsxExtrapolation);
+  nlsWorkspaceRelease(nonlinsys->workspace, nonlinsys->nlsxOld);
+  nlsWorkspaceRelease(nonlinsys->workspace, nonlinsys->resValues);
+  nlsWorkspaceFree(nonlinsys->workspace);
+  nonlinsys->workspace = NULL;
+
   return;
 }
 
@@ -795,6 +875,13 @@ void printNonLinearSystemSolvingStatistics(NONLINEAR_SYSTEM_DATA* nonlinsys, enu
   infoStreamPrint(stream, 0, " time of jacobian evaluations   : %f", nonlinsys->jacobianTime);
   infoStreamPrint(stream, 0, " average time per call          : %f", nonlinsys->totalTime/nonlinsys->numberOfCall);
   infoStreamPrint(stream, 0, " total time                     : %f", nonlinsys->totalTime);
+  if (nonlinsys->workspace) {
+    infoStreamPrint(stream, 0, " workspace [bytes]              : %lu", (unsigned long)nonlinsys->workspace->size);
+    infoStreamPrint(stream, 0, " peak workspace [bytes]         : %lu", (unsigned long)nonlinsys->workspace->peak);
+    if (nonlinsys->workspace->heapFallbacks) {
+      infoStreamPrint(stream, 0, " heap allocations               : %lu", nonlinsys->workspace->heapFallbacks);
+    }
+  }
   messageClose(stream);
 }
 
@@ -872,9 +959,9 @@ void printNonLinearFinishInfo(int logName, DATA* data, NONLINEAR_SYSTEM_DATA *no
 int getInitialGuess(NONLINEAR_SYSTEM_DATA *nonlinsys, double time)
 {
   /* value extrapolation */
-  printValuesListTimes(nonlinsys->oldValueList->valueList);
+  printValuesListTimes(nonlinsys->oldValueList);
   /* if list is empty use current start values */
-  if (listLen(nonlinsys->oldValueList->valueList)==0)
+  if (nonlinsys->oldValueList->length == 0)
   {
     /* use old value if no values are stored in the list */
     memcpy(nonlinsys->nlsx, nonlinsys->nlsxOld, nonlinsys->size*(sizeof(double)));
@@ -882,7 +969,7 @@ int getInitialGuess(NONLINEAR_SYSTEM_DATA *nonlinsys, double time)
   else
   {
     /* get extrapolated values */
-    getValues(nonlinsys->oldValueList->valueList, time, nonlinsys->nlsxExtrapolation, nonlinsys->nlsxOld);
+    getValues(nonlinsys->oldValueList, time, nonlinsys->nlsxExtrapolation, nonlinsys->nlsxOld);
     memcpy(nonlinsys->nlsx, nonlinsys->nlsxOld, nonlinsys->size*(sizeof(double)));
   }
 
@@ -900,34 +987,22 @@ int getInitialGuess(NONLINEAR_SYSTEM_DATA *nonlinsys, double time)
  */
 int updateInitialGuessDB(NONLINEAR_SYSTEM_DATA *nonlinsys, double time, EVAL_CONTEXT context)
 {
-  /* Variables */
-  VALUE* tmpNode;
-
   /* write solution to oldValue list for extrapolation */
   if (nonlinsys->solved == NLS_SOLVED)
   {
     /* do not use solution of jacobian for next extrapolation */
     if (context == CONTEXT_ODE || context == CONTEXT_ALGEBRAIC || context == CONTEXT_EVENTS)
     {
-      tmpNode = createValueElement(nonlinsys->size, time, nonlinsys->nlsx);
-      addListElement(nonlinsys->oldValueList->valueList,
-                     tmpNode);
-      freeValue(tmpNode);
+      addListElement(nonlinsys->oldValueList, time, nonlinsys->nlsx);
     }
   }
   else if (nonlinsys->solved == NLS_SOLVED_LESS_ACCURACY)
   {
-    if (listLen((nonlinsys->oldValueList)->valueList)>0)
-    {
-      cleanValueList(nonlinsys->oldValueList->valueList, NULL);
-    }
+    cleanValueList(nonlinsys->oldValueList);
     /* do not use solution of jacobian for next extrapolation */
     if (context == CONTEXT_ODE || context == CONTEXT_ALGEBRAIC || context == CONTEXT_EVENTS)
     {
-      tmpNode = createValueElement(nonlinsys->size, time, nonlinsys->nlsx);
-      addListElement(nonlinsys->oldValueList->valueList,
-                     tmpNode);
-      freeValue(tmpNode);
+      addListElement(nonlinsys->oldValueList, time, nonlinsys->nlsx);
     }
   }
   return 0;
@@ -1254,11 +1329,11 @@ int solve_nonlinear_system(DATA *data, threadData_t *threadData, int sysNumber)
 
   /* If homotopy is deactivated in this place or flag homotopyOnFirstTry is not set,
      solve the system with the selected solver */
-  if (homotopyDeactivated || !omc_flag[FLAG_HOMOTOPY_ON_FIRST_TRY]) {
+  if (homotopyDeactivated || !data->simulationInfo->homotopyOnFirstTry) {
     if (solveWithHomotopySolver && kinsol) {
       infoStreamPrint(LOG_INIT_HOMOTOPY, 0, "Automatically set -homotopyOnFirstTry, because trying without homotopy first is not supported for the local global approach in combination with KINSOL.");
     } else {
-      if (!homotopyDeactivated && !omc_flag[FLAG_HOMOTOPY_ON_FIRST_TRY])
+      if (!homotopyDeactivated && !data->simulationInfo->homotopyOnFirstTry)
         infoStreamPrint(LOG_INIT_HOMOTOPY, 0, "Try to solve nonlinear initial system %d without homotopy first.", sysNumber);
 
       /* SOLVE! */
@@ -1272,7 +1347,7 @@ int solve_nonlinear_system(DATA *data, threadData_t *threadData, int sysNumber)
   /* If the adaptive local/global homotopy approach is activated and trying without homotopy failed or is not wanted,
      use the HOMOTOPY SOLVER */
   if (solveWithHomotopySolver && nonlinsys->solved != NLS_SOLVED) {
-    if (!omc_flag[FLAG_HOMOTOPY_ON_FIRST_TRY] && !kinsol)
+    if (!data->simulationInfo->homotopyOnFirstTry && !kinsol)
       warningStreamPrint(LOG_ASSERT, 0, "Failed to solve the initial system %d without homotopy method.", sysNumber);
     data->simulationInfo->lambda = 0.0;
     if (data->callback->useHomotopy == 3) {
@@ -1304,7 +1379,7 @@ int solve_nonlinear_system(DATA *data, threadData_t *threadData, int sysNumber)
   /* If equidistant local homotopy is activated and trying without homotopy failed or is not wanted,
      use EQUIDISTANT LOCAL HOMOTOPY */
   if (equidistantHomotopy && nonlinsys->solved != NLS_SOLVED) {
-    if (!omc_flag[FLAG_HOMOTOPY_ON_FIRST_TRY])
+    if (!data->simulationInfo->homotopyOnFirstTry)
       warningStreamPrint(LOG_ASSERT, 0, "Failed to solve the initial system %d without homotopy method. The local homotopy method with equidistant step size is used now.", sysNumber);
     else
       infoStreamPrint(LOG_INIT_HOMOTOPY, 0, "Local homotopy with equidistant step size started for nonlinear system %d.", sysNumber);
@@ -1502,7 +1577,7 @@ void cleanUpOldValueListAfterEvent(DATA *data, double time)
   NONLINEAR_SYSTEM_DATA* nonlinsys = data->simulationInfo->nonlinearSystemData;
 
   for(i=0; i<data->modelData->nNonLinearSystems; ++i) {
-    cleanValueListbyTime(nonlinsys[i].oldValueList->valueList, time);
+    cleanValueListbyTime(nonlinsys[i].oldValueList, time);
   }
 }
 
@@ -86,6 +86,7 @@ void initializeNonlinearSystemData(DATA *data, threadData_t *threadData, NONLINE
 
 NLS_USERDATA* initNlsUserData(DATA* data, threadData_t* threadData, int sysNumber, NONLINEAR_SYSTEM_DATA* nlsData, ANALYTIC_JACOBIAN* analyticJacobian);
 void freeNlsUserData(NLS_USERDATA* userData);
+NLS_WORKSPACE* getNlsWorkspace(NLS_USERDATA* userData);
 
 extern void debugMatrixPermutedDouble(int logName, char* matrixName, double* matrix, int n, int m, int* indRow, int* indCol);
 extern void debugMatrixDouble(int logName, char* matrixName, double* matrix, int n, int m);
@@ -35,239 +35,159 @@
  *              a non-linear solver in OpenModelica in order to
  *              guess next value by extrapolation or interpolation.
  *              Assuming time passes forward.
+ *              The list is a ring of preallocated elements, adding
+ *              to a full list overwrites the oldest element.
  *
  */
 
 #include "epsilon.h"
 #include "nonlinearValuesList.h"
 
-#include "../../util/list.h"
 #include "../../util/omc_error.h"
 
+#include <math.h>
 #include <stdlib.h>
 #include <string.h>
 
-#define UNUSED(x) (void)(x)
-
 /* Forward extrapolate function definition */
 double extrapolateValues(const double, const double, const double, const double, const double);
-void* valueListAlloc(const void* data);
-void valueListFree(void* data);
-void valueListCopy(void* dest, const void* src);
+
+/* k-th element of the list, counted from the latest added */
+#define VALUE_AT(list, k) (&(list)->elements[((list)->first + (k)) % (list)->capacity])
+
+/**
+ * @brief Workspace needed by allocValueList.
+ *
+ * @param capacity    Number of elements.
+ * @param valueSize   Length of array double* values
+ * @return size_t     Size in bytes.
+ */
+size_t valueListWorkspaceSize(unsigned int capacity, unsigned int valueSize)
+{
+  return nlsWorkspaceBytes(1, sizeof(VALUES_LIST))
+       + nlsWorkspaceBytes(capacity, sizeof(VALUE))
+       + nlsWorkspaceBytes((size_t)capacity*valueSize, sizeof(double));
+}
 
 /**
- * @brief Allocate value lists.
+ * @brief Allocate value list.
  *
- * @param numberOfList    Number of lists to allocate.
+ * @param capacity        Number of elements kept in the list.
  * @param valueSize       Length of array double* values
- * @return VALUES_LIST*   Array of value lists.
+ * @param workspace       Workspace to take the memory from, can be NULL.
+ * @return VALUES_LIST*   Value list.
  */
-VALUES_LIST* allocValueList(unsigned int numberOfList, unsigned int valueSize)
+VALUES_LIST* allocValueList(unsigned int capacity, unsigned int valueSize, NLS_WORKSPACE* workspace)
 {
   unsigned int i = 0;
-  VALUES_LIST* valueList = (VALUES_LIST*) malloc(numberOfList*sizeof(VALUES_LIST));
-
-  for(i=0; i<numberOfList; i++) {
-    valueList[i].valueList = allocList(valueListAlloc, valueListFree, valueListCopy);
+  double* values;
+  VALUES_LIST* valueList = (VALUES_LIST*) nlsWorkspaceCalloc(workspace, 1, sizeof(VALUES_LIST));
+
+  valueList->capacity = capacity;
+  valueList->length = 0;
+  valueList->first = 0;
+  valueList->elements = (VALUE*) nlsWorkspaceCalloc(workspace, capacity, sizeof(VALUE));
+  values = (double*) nlsWorkspaceCalloc(workspace, (size_t)capacity*valueSize, sizeof(double));
+
+  for(i=0; i<capacity; i++) {
+    valueList->elements[i].size = valueSize;
+    valueList->elements[i].values = values + (size_t)i*valueSize;
   }
 
   return valueList;
 }
 
 /**
- * @brief Free array of value lists.
+ * @brief Free value list.
  *
- * @param valueList       Array of value lists.
- * @param numberOfList    Length of array valueList.
+ * @param valueList       Value list.
+ * @param workspace       Workspace used in allocValueList.
  */
-void freeValueList(VALUES_LIST* valueList, unsigned int numberOfList)
+void freeValueList(VALUES_LIST* valueList, NLS_WORKSPACE* workspace)
 {
-  unsigned int i = 0;
-
-  for(i=0; i<numberOfList; i++) {
-    freeList(valueList[i].valueList);
-  }
-  free(valueList);
+  nlsWorkspaceRelease(workspace, valueList->elements[0].values);
+  nlsWorkspaceRelease(workspace, valueList->elements);
+  nlsWorkspaceRelease(workspace, valueList);
 }
 
 /**
- * @brief Removes all nodes after startNode from valueList.
- *        If startNode = NULL then clear the whole list.
+ * @brief Removes all elements from valueList.
  *
  * @param valueList    Pointer to value list
- * @param startNode    Pointer to list node, following nodes will be deleted
  */
-void cleanValueList(LIST* valueList, LIST_NODE *startNode)
+void cleanValueList(VALUES_LIST* valueList)
 {
-  int len;
-  if(startNode)
-  {
-    listClearAfterNode(valueList, startNode);
-  }
-  else listClear(valueList);
+  valueList->length = 0;
 }
 
 /**
- * @brief Removes all nodes except the one just before or at time.
+ * @brief Removes all elements except the one just before or at time.
  *
  * @param valueList    Pointer to value list
  * @param time         time
  */
-void cleanValueListbyTime(LIST *valueList, double time)
+void cleanValueListbyTime(VALUES_LIST* valueList, double time)
 {
-  LIST_NODE *next, *it;
+  unsigned int k;
   VALUE* elem;
 
   printValuesListTimes(valueList);
-  // need to get first node at each iteration since head is removed
-  for(it = listFirstNode(valueList); it; it = listFirstNode(valueList))
+  for(k = 0; k < valueList->length; k++)
   {
-    assert(it != NULL);
-    elem = (VALUE*)listNodeData(it);
+    elem = VALUE_AT(valueList, k);
     if (elem->time <= time)
     {
-      cleanValueList(valueList, it);
-      infoStreamPrint(LOG_NLS_EXTRAPOLATE, 0, "New list length %d: ", listLen(valueList));
+      valueList->first = (valueList->first + k) % valueList->capacity;
+      valueList->length = 1;
+      infoStreamPrint(LOG_NLS_EXTRAPOLATE, 0, "New list length %d: ", valueList->length);
       printValuesListTimes(valueList);
       infoStreamPrint(LOG_NLS_EXTRAPOLATE, 0, "Done!");
-      break;
+      return;
     }
     /* debug output */
     infoStreamPrint(LOG_NLS_EXTRAPOLATE, 0, "cleanValueListbyTime %g check element: ", time);
     printValueElement(elem);
-
-    listRemoveFront(valueList);
   }
+  valueList->length = 0;
 }
 
 /**
- * @brief Create new value element for value list.
+ * @brief Adds copy of new values to list.
  *
- * @param size      Length of values array.
- * @param time      Time
- * @param values    Array of values
- */
-VALUE* createValueElement(unsigned int size, double time, double* values)
-{
-  VALUE* elem = calloc(1, sizeof(VALUE));
-  elem->values = calloc(size, sizeof(double));
-  elem->time = time;
-  elem->size = size;
-
-  memcpy(elem->values, values, size*sizeof(double));
-
-  /* debug output */
-  infoStreamPrint(LOG_NLS_EXTRAPOLATE, 0, "Create Element");
-
-  return elem;
-}
-
-/**
- * @brief Free value element allocated with createValueElement
+ * If the latest added element has the same time it gets replaced,
+ * otherwise the values are added in front of it.
  *
- * @param elem    Value element to free.
+ * @param valueList   List
+ * @param time        Time of values.
+ * @param values      Values to add, valueSize elements.
  */
-void freeValue(VALUE* elem)
+void addListElement(VALUES_LIST* valueList, double time, const double* values)
 {
-  free(elem->values);
-  free(elem);
-}
-
-/**
- * @brief Adds copy of new element to list.
- *
- * @param valuesList    List
- * @param newElem       New element to add to list.
- */
-void addListElement(LIST* valuesList, VALUE* newElem)
-{
-  LIST_NODE *node, *next;
   VALUE* elem;
-  int replace = 0, i = 0;
 
   /* debug output */
-  infoStreamPrint(LOG_NLS_EXTRAPOLATE, 1, "Adding element in a list of size %d", listLen(valuesList));
-  printValueElement(newElem);
-
-  /*  if it's empty, just push it in */
-  if (listLen(valuesList) == 0)
-  {
-    infoStreamPrint(LOG_NLS_EXTRAPOLATE, 0, "List is empty add new element.");
-    listPushFront(valuesList, (void*) newElem);
-
-    messageClose(LOG_NLS_EXTRAPOLATE);
-    return;
-  }
-
-  /*  if the element at begin is earlier than current
-   *  push the element just in front and if the end element
-   *  is later than current push it just back.*/
-  node = listFirstNode(valuesList);
-  if ( fabs( ((VALUE*)listNodeData(node))->time - newElem->time ) > MINIMAL_STEP_SIZE )
-  {
-    infoStreamPrint(LOG_NLS_EXTRAPOLATE, 0, "First Value list element is:");
-    printValueElement(((VALUE*)listNodeData(node)));
-    infoStreamPrint(LOG_NLS_EXTRAPOLATE, 0, "so new element is added before.");
-    listPushFront(valuesList, (void*) newElem);
-
-    messageClose(LOG_NLS_EXTRAPOLATE);
-    return;
-  }
-
-  infoStreamPrint(LOG_NLS_EXTRAPOLATE, 0, "Search position of new element");
-  /* search correct position */
-  next = node;
-  do
-  {
-    /*  if next node is empty */
-    if (!next)
-    {
-      infoStreamPrint(LOG_NLS_EXTRAPOLATE, 0, "Search finished last element reached");
-      break;
-    }
-
-    elem = ((VALUE*)listNodeData(next));
-
-    /* debug output */
-    infoStreamPrint(LOG_NLS_EXTRAPOLATE, 0, "Next node of list is element:");
-    printValueElement(elem);
-
+  infoStreamPrint(LOG_NLS_EXTRAPOLATE, 1, "Adding element at time %g in a list of size %d", time, valueList->length);
 
-    if (fabs(elem->time - newElem->time)<=MINIMAL_STEP_SIZE)
-    {
-      replace = 1;
-      break;
-    }
-    else if (elem->time < newElem->time)
-    {
-      break;
-    }
-    node = next;
-    next = listNextNode(node);
-    i++; /* count insert or replace place */
-  }while(1);
-
-  /* add element before currect node */
-  if (!replace){
-    infoStreamPrint(LOG_NLS_EXTRAPOLATE, 0, "Insert element before last output element.");
-    listInsert(valuesList, node, (void*) newElem);
-  }
-  else
+  if (valueList->length > 0 && fabs(VALUE_AT(valueList, 0)->time - time) <= MINIMAL_STEP_SIZE)
   {
     infoStreamPrint(LOG_NLS_EXTRAPOLATE, 0, "replace element.");
-    updateNodeData(valuesList, next, (void*) newElem);
   }
-  /*  clean list if too full */
-  if (i < 3 && listLen(valuesList)>10)
+  else
   {
-    while(i < 4)
+    /* a full list drops its oldest element */
+    valueList->first = (valueList->first + valueList->capacity - 1) % valueList->capacity;
+    if (valueList->length < valueList->capacity)
     {
-      next = listNextNode(next);
-      i++;
+      valueList->length++;
     }
-    cleanValueList(valuesList, next);
+    infoStreamPrint(LOG_NLS_EXTRAPOLATE, 0, "new element is added before.");
   }
 
+  elem = VALUE_AT(valueList, 0);
+  elem->time = time;
+  memcpy(elem->values, values, elem->size*sizeof(double));
+  printValueElement(elem);
+
   messageClose(LOG_NLS_EXTRAPOLATE);
   return;
 }
@@ -275,28 +195,26 @@ void addListElement(LIST* valuesList, VALUE* newElem)
 /**
  * @brief Gets extrapolated values for time from value list.
  *
- * @param valuesList            Pointer to value list
+ * @param valueList             Pointer to value list
  * @param time                  time
  * @param extrapolatedValues    values extrapolated (overwritten)
  * @param oldOutput             old values just before time
  */
-void getValues(LIST* valuesList, double time, double* extrapolatedValues, double* oldOutput)
+void getValues(VALUES_LIST* valueList, double time, double* extrapolatedValues, double* oldOutput)
 {
-  LIST_NODE *it;
-  LIST_NODE *old = NULL;
-  LIST_NODE *old2 = NULL;
-  VALUE *oldValues, *old2Values, *elem;
+  unsigned int k;
+  VALUE *oldValues = NULL, *old2Values = NULL, *elem;
 
-  infoStreamPrint(LOG_NLS_EXTRAPOLATE, 1, "Get values for time %g in a list of size %d", time, listLen(valuesList));
+  infoStreamPrint(LOG_NLS_EXTRAPOLATE, 1, "Get values for time %g in a list of size %d", time, valueList->length);
 
   /* find corresponding values */
-  for(it = listFirstNode(valuesList); it; it = listNextNode(it))
+  for(k = 0; k < valueList->length; k++)
   {
-    elem = (VALUE*)listNodeData(it);
+    elem = VALUE_AT(valueList, k);
     infoStreamPrint(LOG_NLS_EXTRAPOLATE, 0, "Searching current element:");
     printValueElement(elem);
 
-    old = it;
+    oldValues = elem;
     if(fabs(elem->time - time) <= MINIMAL_STEP_SIZE)
     {
       infoStreamPrint(LOG_NLS_EXTRAPOLATE, 0, "take element with the same time.");
@@ -304,24 +222,26 @@ void getValues(LIST* valuesList, double time, double* extrapolatedValues, double
     }
     else if(elem->time < time)
     {
-      old2 = listNextNode(old);
+      if (k + 1 < valueList->length)
+      {
+        old2Values = VALUE_AT(valueList, k + 1);
+      }
       infoStreamPrint(LOG_NLS_EXTRAPOLATE, 0, "found element to use for extrapolation.");
       break;
     }
   }
 
-  /* if the list is empty old never gets set */
-  assertStreamPrint(NULL, NULL != old, "getValues failed, no elements!");
+  /* if the list is empty oldValues never gets set */
+  assertStreamPrint(NULL, NULL != oldValues, "getValues failed, no elements!");
 
-  if(it == NULL)
+  if(k == valueList->length)
   {
     infoStreamPrint(LOG_NLS_EXTRAPOLATE, 0, "reached end of list.");
   }
 
   /*  get next values */
-  if (old2 == NULL)
+  if (old2Values == NULL)
   {
-    oldValues = (VALUE*) listNodeData(old);
     memcpy(extrapolatedValues, oldValues->values, oldValues->size*sizeof(double));
     memcpy(oldOutput, oldValues->values, oldValues->size*sizeof(double));
     infoStreamPrint(LOG_NLS_EXTRAPOLATE, 0, "take just old values.");
@@ -329,8 +249,6 @@ void getValues(LIST* valuesList, double time, double* extrapolatedValues, double
   else
   {
     int i;
-    oldValues = (VALUE*) listNodeData(old);
-    old2Values = (VALUE*) listNodeData(old2);
     infoStreamPrint(LOG_NLS_EXTRAPOLATE, 0, "Use following elements for calculation:");
     printValueElement(oldValues);
     printValueElement(old2Values);
@@ -359,29 +277,21 @@ void printValueElement(VALUE* elem)
 }
 
 /**
- * @brief Print function for printValuesListTimes
+ * @brief Print value times of value list.
  *
- * @param data      Data of node of type VALUE*
- * @param stream    Stream to output to.
- * @param unused    Unused
+ * @param valueList    Value list.
  */
-static void printElemTimes(void* data, int stream, void* unused) {
-  UNUSED(unused);
-  VALUE* elem = (VALUE*) data;
+void printValuesListTimes(VALUES_LIST* valueList) {
+  unsigned int k;
 
-  unsigned int i;
-  for(i=0; i<elem->size; i++) {
-    infoStreamPrint(stream, 0, "Element %d at time %g", i, elem->time);
+  if (!ACTIVE_STREAM(LOG_NLS_EXTRAPOLATE)) {
+    return;
   }
-}
-
-/**
- * @brief Print value times of value list.
- *
- * @param list    Value list.
- */
-void printValuesListTimes(LIST* list) {
-  printList(list, LOG_NLS_EXTRAPOLATE, printElemTimes);
+  infoStreamPrint(LOG_NLS_EXTRAPOLATE, 1, "List of size %d", valueList->length);
+  for(k = 0; k < valueList->length; k++) {
+    infoStreamPrint(LOG_NLS_EXTRAPOLATE, 0, "Element %d at time %g", k, VALUE_AT(valueList, k)->time);
+  }
+  messageClose(LOG_NLS_EXTRAPOLATE);
 }
 
 /*! \fn extraPolateValues
@@ -408,44 +318,3 @@ double extrapolateValues(const double time, const double old1, const double time
 
   return retValue;
 }
-
-/**
- * @brief Allocate memory for valueList elements.
- *
- * @param data      value list element, containing size of array values
- *                  Has to be of type VALUE*;
- * @return void*    Allocated memory for LIST_NODE data.
- */
-void* valueListAlloc(const void* data) {
-  const VALUE* valueElem = (VALUE*) data;
-  VALUE* newElem = malloc(sizeof(VALUE));
-  assertStreamPrint(NULL, newElem != NULL, "valueListAlloc: Out of memory");
-  newElem->values = malloc(valueElem->size*sizeof(double));
-  assertStreamPrint(NULL, newElem->values != NULL, "valueListAlloc: Out of memory");
-  return (void*) newElem;
-}
-
-/**
- * @brief Free memory allocated with valueListAlloc.
- *
- * @param data      Void pointer, representing index for new list element.
- */
-void valueListFree(void* data) {
-  VALUE* valueElem = (VALUE*) data;
-  free(valueElem->values);
-  free(valueElem);
-}
-
-/**
- * @brief Copy data of valueList elements.
- *
- * @param dest    Void pointer of destination data, representing VALUE.
- * @param src     Void pointer of source data, representing VALUE.
- */
-void valueListCopy(void* dest, const void* src) {
-  VALUE* destValue = (VALUE*) dest;
-  VALUE* srcValue = (VALUE*) src;
-  destValue->size = srcValue->size;
-  destValue->time = srcValue->time;
-  memcpy(destValue->values, srcValue->values, srcValue->size*sizeof(double));
-}
@@ -37,11 +37,10 @@
 #ifndef _OMC_VALUE_LIST_H
 #define _OMC_VALUE_LIST_H
 
-#include "../../util/list.h"
+#include "nonlinearWorkspace.h"
 
-typedef struct VALUES_LIST {
-  LIST* valueList;
-} VALUES_LIST;
+/* number of solutions kept for extrapolation */
+#define VALUES_LIST_CAPACITY 10
 
 typedef struct VALUE {
   double time;            /* Time value */
@@ -49,19 +48,24 @@ typedef struct VALUE {
   double *values;         /* Array with values */
 } VALUE;
 
-VALUES_LIST* allocValueList(unsigned int numberOfList, unsigned int valueSize);
-void freeValueList(VALUES_LIST* valueList, unsigned int numberOfLists);
+typedef struct VALUES_LIST {
+  unsigned int capacity;  /* Number of preallocated elements */
+  unsigned int length;    /* Number of elements in use */
+  unsigned int first;     /* Position of the latest added element */
+  VALUE *elements;        /* Ring of elements, the latest added first */
+} VALUES_LIST;
+
+size_t valueListWorkspaceSize(unsigned int capacity, unsigned int valueSize);
+VALUES_LIST* allocValueList(unsigned int capacity, unsigned int valueSize, NLS_WORKSPACE* workspace);
+void freeValueList(VALUES_LIST* valueList, NLS_WORKSPACE* workspace);
 
-VALUE* createValueElement(unsigned int size, double time, double* values);
-void freeValue(VALUE* elem);
-void cleanValueList(LIST* valueList, LIST_NODE *startNode);
-void cleanValueListbyTime(LIST *valueList, double time);
-void removeListNodes(LIST* list, LIST_NODE *node);
+void cleanValueList(VALUES_LIST* valueList);
+void cleanValueListbyTime(VALUES_LIST* valueList, double time);
 
-void addListElement(LIST* valueList, VALUE* elem);
-void getValues(LIST* valueList, double time, double* values, double* oldOutput);
+void addListElement(VALUES_LIST* valueList, double time, const double* values);
+void getValues(VALUES_LIST* valueList, double time, double* values, double* oldOutput);
 
 void printValueElement(VALUE* elem);
-void printValuesListTimes(LIST* list);
+void printValuesListTimes(VALUES_LIST* valueList);
 
 #endif
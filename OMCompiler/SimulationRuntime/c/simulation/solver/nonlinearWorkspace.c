@@ -0,0 +1,154 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-CurrentYear, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+
+/*! \file nonlinearWorkspace.c
+ *
+ * Memory is taken from the buffer in stack order. Releasing a block also
+ * releases all blocks taken after it, which is how the solvers return
+ * scratch memory at the end of a solve. Requests that do not fit into the
+ * buffer, and all requests without a workspace, are served by calloc and
+ * released with free.
+ */
+
+#include "nonlinearWorkspace.h"
+
+#include "../../util/omc_error.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* alignment of every block, enough for double and modelica_integer */
+#define NLS_WORKSPACE_ALIGNMENT 16
+
+/**
+ * @brief Bytes a block of count elements takes in the workspace.
+ *
+ * Sums of this function give the size for nlsWorkspaceAllocate.
+ *
+ * @param count       Number of elements.
+ * @param elemSize    Size of one element.
+ * @return size_t     Size of the block including alignment padding.
+ */
+size_t nlsWorkspaceBytes(size_t count, size_t elemSize)
+{
+  return (count*elemSize + NLS_WORKSPACE_ALIGNMENT - 1) & ~((size_t)NLS_WORKSPACE_ALIGNMENT - 1);
+}
+
+/**
+ * @brief Allocate workspace with a buffer of size bytes.
+ *
+ * @param size              Size of buffer in bytes, see nlsWorkspaceBytes.
+ * @return NLS_WORKSPACE*   Allocated workspace.
+ */
+NLS_WORKSPACE* nlsWorkspaceAllocate(size_t size)
+{
+  NLS_WORKSPACE* workspace = (NLS_WORKSPACE*) calloc(1, sizeof(NLS_WORKSPACE));
+  assertStreamPrint(NULL, NULL != workspace, "nlsWorkspaceAllocate: Out of memory");
+
+  workspace->buffer = (char*) calloc(size > 0 ? size : 1, 1);
+  assertStreamPrint(NULL, NULL != workspace->buffer, "nlsWorkspaceAllocate: Out of memory");
+  workspace->size = size;
+
+  return workspace;
+}
+
+/**
+ * @brief Free workspace and its buffer.
+ *
+ * Blocks served by calloc have to be released before.
+ *
+ * @param workspace   Workspace, can be NULL.
+ */
+void nlsWorkspaceFree(NLS_WORKSPACE *workspace)
+{
+  if (workspace) {
+    free(workspace->buffer);
+    free(workspace);
+  }
+}
+
+/**
+ * @brief Take zero initialized memory for count elements from workspace.
+ *
+ * @param workspace   Workspace, if NULL the memory is allocated with calloc.
+ * @param count       Number of elements.
+ * @param elemSize    Size of one element.
+ * @return void*      Pointer to memory, release with nlsWorkspaceRelease.
+ */
+void* nlsWorkspaceCalloc(NLS_WORKSPACE *workspace, size_t count, size_t elemSize)
+{
+  void* ptr;
+  size_t bytes = nlsWorkspaceBytes(count, elemSize);
+
+  if (workspace && workspace->used + bytes <= workspace->size) {
+    ptr = workspace->buffer + workspace->used;
+    workspace->used += bytes;
+    if (workspace->used > workspace->peak) {
+      workspace->peak = workspace->used;
+    }
+    memset(ptr, 0, bytes);
+    return ptr;
+  }
+
+  if (workspace) {
+    workspace->heapFallbacks++;
+    infoStreamPrint(LOG_NLS_V, 0, "NLS workspace of %lu bytes is full, allocating %lu bytes from the heap.",
+                    (unsigned long)workspace->size, (unsigned long)bytes);
+  }
+  ptr = calloc(count > 0 ? count : 1, elemSize);
+  assertStreamPrint(NULL, NULL != ptr, "nlsWorkspaceCalloc: Out of memory");
+  return ptr;
+}
+
+/**
+ * @brief Release memory taken with nlsWorkspaceCalloc.
+ *
+ * Memory from the buffer is released together with all blocks taken after it.
+ *
+ * @param workspace   Workspace the memory was taken from, can be NULL.
+ * @param ptr         Pointer to memory, can be NULL.
+ */
+void nlsWorkspaceRelease(NLS_WORKSPACE *workspace, void *ptr)
+{
+  size_t offset;
+
+  if (!ptr) {
+    return;
+  }
+  if (workspace && (char*)ptr >= workspace->buffer && (char*)ptr < workspace->buffer + workspace->size) {
+    offset = (char*)ptr - workspace->buffer;
+    if (offset < workspace->used) {
+      workspace->used = offset;
+    }
+    return;
+  }
+  free(ptr);
+}
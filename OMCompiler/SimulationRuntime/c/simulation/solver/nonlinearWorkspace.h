@@ -0,0 +1,69 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-CurrentYear, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+
+/*! \file nonlinearWorkspace.h
+ *
+ * Arena for the work arrays of one non-linear system and its solvers.
+ * The arena is sized from the size and the solver of the system when the
+ * system is initialized, so solving the system does not allocate.
+ */
+
+#ifndef _NONLINEARWORKSPACE_H_
+#define _NONLINEARWORKSPACE_H_
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct NLS_WORKSPACE
+{
+  char *buffer;                 /* memory for all work arrays */
+  size_t size;                  /* size of buffer in bytes */
+  size_t used;                  /* bytes currently handed out */
+  size_t peak;                  /* maximum of used */
+  unsigned long heapFallbacks;  /* requests that did not fit into buffer */
+} NLS_WORKSPACE;
+
+size_t nlsWorkspaceBytes(size_t count, size_t elemSize);
+
+NLS_WORKSPACE* nlsWorkspaceAllocate(size_t size);
+void nlsWorkspaceFree(NLS_WORKSPACE *workspace);
+
+void* nlsWorkspaceCalloc(NLS_WORKSPACE *workspace, size_t count, size_t elemSize);
+void nlsWorkspaceRelease(NLS_WORKSPACE *workspace, void *ptr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -221,7 +221,7 @@ int initializeSolverData(DATA* data, threadData_t *threadData, SOLVER_INFO* solv
   solverInfo->solverRootFinding = 0;
   solverInfo->solverNoEquidistantGrid = 0;
   solverInfo->lastdesiredStep = solverInfo->currentTime + solverInfo->currentStepSize;
-  solverInfo->eventLst = allocList(eventListAlloc, eventListFree, eventListCopy);
+  solverInfo->eventLst = allocIndexSet(data->modelData->nZeroCrossings);
   solverInfo->didEventStep = 0;
   solverInfo->stateEvents = 0;
   solverInfo->sampleEvents = 0;
@@ -390,7 +390,7 @@ int freeSolverData(DATA* data, SOLVER_INFO* solverInfo)
   int retValue = 0;
   int i;
 
-  freeList(solverInfo->eventLst);
+  freeIndexSet(solverInfo->eventLst);
   /* deintialize solver related workspace */
   switch (solverInfo->solverMethod)
   {
@@ -523,7 +523,7 @@ int initializeModel(DATA* data, threadData_t *threadData, const char* init_initM
   }
 
   /* adrpo: write the parameter data in the file once again after bound parameters and initialization! */
-  sim_result.writeParameterData(&sim_result,data,threadData);
+  data->simResult->writeParameterData(data->simResult, data, threadData);
   infoStreamPrint(LOG_SOLVER, 0, "Wrote parameters to the file after initialization (for output formats that support this)");
 
   /* Initialization complete */
@@ -562,7 +562,7 @@ int finishSimulation(DATA* data, threadData_t *threadData, SOLVER_INFO* solverIn
 
     /* prevent emit if noeventemit flag is used */
     if (!(omc_flag[FLAG_NOEVENTEMIT])) {
-      sim_result.emit(&sim_result, data, threadData);
+      data->simResult->emit(data->simResult, data, threadData);
     }
 
     data->simulationInfo->terminal = 0;
@@ -671,6 +671,13 @@ int finishSimulation(DATA* data, threadData_t *threadData, SOLVER_INFO* solverIn
     infoStreamPrint(LOG_STATS_V, 0, "%12gs [%5.1f%%]", rt_accumulated(SIM_TIMER_ZC), rt_accumulated(SIM_TIMER_ZC)/total100);
     messageClose(LOG_STATS_V);
 
+    if (data->simulationInfo->callStatistics.maskedEquationsEvaluated || data->simulationInfo->callStatistics.maskedEquationsSkipped) {
+      infoStreamPrint(LOG_STATS_V, 1, "masked evaluation (Jacobian columns, event location)");
+      infoStreamPrint(LOG_STATS_V, 0, "%5ld equations evaluated", data->simulationInfo->callStatistics.maskedEquationsEvaluated);
+      infoStreamPrint(LOG_STATS_V, 0, "%5ld equations skipped", data->simulationInfo->callStatistics.maskedEquationsSkipped);
+      messageClose(LOG_STATS_V);
+    }
+
     messageClose(LOG_STATS_V);
 
     infoStreamPrint(LOG_STATS_V, 1, "linear systems");
@@ -811,7 +818,7 @@ int solver_main(DATA* data, threadData_t *threadData, const char* init_initMetho
        data->modelData->nVariablesString == 0 ) {
       /* prevent emit if noeventemit flag is used */
       if (!(omc_flag[FLAG_NOEVENTEMIT])) {
-        sim_result.emit(&sim_result, data, threadData);
+        data->simResult->emit(data->simResult, data, threadData);
       }
 
       infoStreamPrint(LOG_SOLVER, 0, "The model has no time changing variables, no integration will be performed.");
@@ -821,7 +828,7 @@ int solver_main(DATA* data, threadData_t *threadData, const char* init_initMetho
       retVal = finishSimulation(data, threadData, &solverInfo, outputVariablesAtEnd);
     } else if(S_QSS == solverInfo.solverMethod) {
       /* starts the simulation main loop - special solvers */
-      sim_result.emit(&sim_result,data,threadData);
+      data->simResult->emit(data->simResult, data, threadData);
 
       /* overwrite the whole ring-buffer with initialized values */
       overwriteOldSimulationData(data);
@@ -838,7 +845,7 @@ int solver_main(DATA* data, threadData_t *threadData, const char* init_initMetho
       if(omc_flag[FLAG_SOLVER_STEPS])
         data->simulationInfo->solverSteps = 0;
       if(solverInfo.solverMethod != S_OPTIMIZATION) {
-        sim_result.emit(&sim_result,data,threadData);
+        data->simResult->emit(data->simResult, data, threadData);
       }
 
       /* overwrite the whole ring-buffer with initialized values */
@@ -1029,7 +1036,7 @@ static int rungekutta_step_ssc(DATA* data, threadData_t *threadData, SOLVER_INFO
     if(t  < targetTime){
        memcpy(x0, sData->realVars, nx*sizeof(double));
        memcpy(k[0], k[4], nx*sizeof(double));
-       sim_result.emit(&sim_result, data, threadData);
+       data->simResult->emit(data->simResult, data, threadData);
     }
   }
 
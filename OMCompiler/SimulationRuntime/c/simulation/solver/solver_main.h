@@ -70,7 +70,7 @@ typedef struct SOLVER_INFO
   double lastdesiredStep;
 
   /* events */
-  LIST* eventLst;         /* List with long indices from data->simulationInfo->zeroCrossingIndex */
+  INDEX_SET* eventLst;    /* Set of zero-crossing indices with an event */
   int didEventStep;       /* Boolean stating if during the last step an event was encountered,
                            * Used to reinitialize ODE/DAE solver after event iteration */
 
@@ -195,7 +195,7 @@ modelica_boolean handleBaseClock(DATA* data, threadData_t *threadData, long idx,
     frstSubClockIsBaseClock = 1 /* true */;
 #if !defined(OMC_MINIMAL_RUNTIME)
     // Save result before clock tick, then evaluate equations
-    sim_result.emit(&sim_result, data, threadData);
+    data->simResult->emit(data->simResult, data, threadData);
 #endif /* #if !defined(OMC_MINIMAL_RUNTIME) */
     subClock->stats.count++;
     subClock->stats.previousInterval = baseClock->stats.previousInterval;
@@ -294,7 +294,7 @@ fire_timer_t handleTimers(DATA* data, threadData_t *threadData, SOLVER_INFO* sol
         break;
       case SYNC_SUB_CLOCK:
         // Save result before clock tick, then evaluate equations
-        sim_result.emit(&sim_result, data, threadData);
+        data->simResult->emit(data->simResult, data, threadData);
         subClock = &data->simulationInfo->baseClocks[base_idx].subClocks[sub_idx];
         subClock->stats.count++;
         subClock->stats.previousInterval = solverInfo->currentTime - subClock->stats.lastActivationTime;
@@ -38,6 +38,7 @@
 
 #include "openmodelica.h"
 #include "util/doubleEndedList.h"
+#include "util/index_set.h"
 #include "util/list.h"
 #include "util/omc_error.h"
 #include "util/rational.h"
@@ -66,6 +67,7 @@
 struct DATA;
 typedef struct DATA DATA;
 typedef struct VALUES_LIST VALUES_LIST;
+typedef struct NLS_WORKSPACE NLS_WORKSPACE;
 
 /* Model info structures */
 typedef struct VAR_INFO
@@ -118,6 +120,8 @@ typedef struct CALL_STATISTICS
   long functionZeroCrossings;
   long functionEvalDAE;
   long functionAlgebraics;
+  long maskedEquationsEvaluated;       /* equations run by masked evaluation, see masked_eval.h */
+  long maskedEquationsSkipped;         /* equations skipped by masked evaluation */
 } CALL_STATISTICS;
 
 typedef enum
@@ -150,6 +154,7 @@ typedef struct SPARSE_PATTERN
                                    * Length of array is rows */
   unsigned int numberOfNonZeros;  /* Number of non-zero elements in matrix */
   unsigned int maxColors;         /* Number of colors */
+  modelica_boolean isCached;      /* Arrays are owned by the pattern cache and read-only, see simulation/jacobian_cache.h */
 } SPARSE_PATTERN;
 
 /* NONLINEAR_PATTERN
@@ -345,6 +350,7 @@ typedef struct NONLINEAR_SYSTEM_DATA
   NONLINEAR_SOLVER nlsMethod;          /* nonlinear solver */
   void *solverData;
   NLS_LS nlsLinearSolver;              /* nls linear solver */
+  NLS_WORKSPACE *workspace;            /* memory for the work arrays of the system and its solvers */
 
   modelica_real *nlsx;                 /* x */
   modelica_real *nlsxOld;              /* previous x */
@@ -559,6 +565,7 @@ typedef struct MODEL_DATA
 
   int linearizationDumpLanguage;        /* default is 0-modelica, options: 1-matlab, 2-julia, 3-pythong */
   modelica_boolean create_linearmodel;  /* true if model gets linearized */
+  modelica_boolean sharedVarInfo;       /* true if the variable infos belong to another instance, see simulation_instances.c */
 
   long nSamples;                       /* number of different sample-calls */
   SAMPLE_INFO* samplesInfo;            /* array containing each sample-call */
@@ -705,6 +712,8 @@ typedef struct SIMULATION_INFO
   NONLINEAR_SOLVER nlsMethod;          /* nonlinear solver */
   NEWTON_STRATEGY newtonStrategy;      /* newton damping strategy solver */
   int nlsCsvInfomation;                /* = 1 csv files with detailed nonlinear solver process are generated */
+  modelica_boolean nlsNoScaling;       /* = 1 no scaling in the non-linear solvers (-noScaling or irregular sparsity pattern) */
+  modelica_boolean homotopyOnFirstTry; /* = 1 initial systems are solved with homotopy right away (-homotopyOnFirstTry or set by the initialization) */
   NLS_LS nlsLinearSolver;              /* nls linear solver */
 
   EVAL_CONTEXT currentContext;         /* Simulation context */
@@ -750,10 +759,13 @@ typedef struct SIMULATION_INFO
   long* zeroCrossingIndex;             /* := {0, 1, 2, ..., data->modelData->nZeroCrossings-1}; pointer for a list events at event instants */
   modelica_real* states_left;          /* work array for findRoot in event.c */
   modelica_real* states_right;         /* work array for findRoot in event.c */
+  INDEX_SET* tmpEventList;             /* work set for findRoot in event.c */
 
   /* old vars for event handling */
   modelica_real timeValueOld;
-  modelica_real* realVarsOld;
+  modelica_real* realVarsOld;          /* only states, discrete reals and realVarsOldIndex are stored */
+  long* realVarsOldIndex;              /* iteration variables of the non-linear systems */
+  long nRealVarsOldIndex;
   modelica_integer* integerVarsOld;
   modelica_boolean* booleanVarsOld;
   modelica_string* stringVarsOld;
@@ -838,6 +850,7 @@ typedef struct DATA
 #if !defined(OMC_MINIMAL_RUNTIME)
   void *embeddedServerState;           /* Variable sent around controlling the state of the embedded server */
   real_time_sync_t real_time_sync;
+  struct simulation_result *simResult; /* result file of this instance; &sim_result for the model started from the command line */
 #endif
 } DATA;
 
@@ -0,0 +1,181 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-CurrentYear, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/*! \file index_set.c
+ *
+ * Description: This file is part of the simulation runtime.
+ * It contains a set of indices with a fixed capacity.
+ */
+
+#include "index_set.h"
+#include "omc_error.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define INDEX_SET_WORDS(capacity) (((capacity) + 63) / 64)
+
+/**
+ * @brief Allocates an empty set for the indices 0, ..., capacity-1.
+ *
+ * @param capacity    Number of possible members.
+ * @return INDEX_SET* New empty set.
+ */
+INDEX_SET *allocIndexSet(unsigned int capacity)
+{
+  INDEX_SET *set = (INDEX_SET*)malloc(sizeof(INDEX_SET));
+  assertStreamPrint(NULL, 0 != set, "out of memory");
+
+  set->capacity = capacity;
+  set->size = 0;
+  /* allocate at least one element, so that empty sets are no special case */
+  set->members = (long*)malloc((capacity > 0 ? capacity : 1) * sizeof(long));
+  set->bits = (uint64_t*)calloc(INDEX_SET_WORDS(capacity) > 0 ? INDEX_SET_WORDS(capacity) : 1, sizeof(uint64_t));
+  assertStreamPrint(NULL, 0 != set->members && 0 != set->bits, "out of memory");
+
+  return set;
+}
+
+/**
+ * @brief Frees set and everything inside it.
+ *
+ * @param set     Pointer to set, may be NULL.
+ */
+void freeIndexSet(INDEX_SET *set)
+{
+  if(set)
+  {
+    free(set->members);
+    free(set->bits);
+    free(set);
+  }
+}
+
+/**
+ * @brief Removes all members.
+ *
+ * Only the bits of the current members are reset, unless that would touch
+ * more memory than resetting the whole bitset.
+ *
+ * @param set     Pointer to set.
+ */
+void indexSetClear(INDEX_SET *set)
+{
+  unsigned int i;
+
+  if(set->size > INDEX_SET_WORDS(set->capacity))
+  {
+    memset(set->bits, 0, INDEX_SET_WORDS(set->capacity) * sizeof(uint64_t));
+  }
+  else
+  {
+    for(i = 0; i < set->size; i++)
+      set->bits[set->members[i] / 64] = 0;
+  }
+  set->size = 0;
+}
+
+/**
+ * @brief Adds index to set.
+ *
+ * @param set     Pointer to set.
+ * @param index   Index in [0, capacity).
+ * @return int    1 if index was added, 0 if it already was a member.
+ */
+int indexSetAdd(INDEX_SET *set, long index)
+{
+  uint64_t bit = (uint64_t)1 << (index % 64);
+
+  assertStreamPrint(NULL, index >= 0 && (unsigned long)index < set->capacity, "indexSetAdd: index %ld out of range [0, %u)", index, set->capacity);
+  if(set->bits[index / 64] & bit)
+    return 0;
+
+  set->bits[index / 64] |= bit;
+  set->members[set->size++] = index;
+  return 1;
+}
+
+/**
+ * @brief Adds the indices 64*word+k for all bits k set in bits.
+ *
+ * Indices that already are members are skipped, the new members are
+ * appended in increasing order.
+ *
+ * @param set     Pointer to set.
+ * @param word    Block of 64 indices.
+ * @param bits    Bit k stands for index 64*word+k.
+ */
+void indexSetAddWord(INDEX_SET *set, unsigned int word, uint64_t bits)
+{
+  long base = 64 * (long)word;
+
+  bits &= ~set->bits[word];
+  set->bits[word] |= bits;
+  while(bits)
+  {
+#if defined(__GNUC__)
+    int k = __builtin_ctzll(bits);
+#else
+    int k = 0;
+    while(!((bits >> k) & 1))
+      k++;
+#endif
+    set->members[set->size++] = base + k;
+    bits &= bits - 1;
+  }
+}
+
+/**
+ * @brief Checks whether index is a member of set.
+ *
+ * @param set     Pointer to set.
+ * @param index   Index in [0, capacity).
+ * @return int    1 if index is a member, 0 otherwise.
+ */
+int indexSetContains(const INDEX_SET *set, long index)
+{
+  return (set->bits[index / 64] >> (index % 64)) & 1;
+}
+
+/**
+ * @brief Exchanges the content of two sets with the same capacity.
+ *
+ * @param a       Pointer to first set.
+ * @param b       Pointer to second set.
+ */
+void indexSetSwap(INDEX_SET *a, INDEX_SET *b)
+{
+  INDEX_SET tmp;
+
+  assertStreamPrint(NULL, a->capacity == b->capacity, "indexSetSwap: sets have different capacities");
+  tmp = *a;
+  *a = *b;
+  *b = tmp;
+}
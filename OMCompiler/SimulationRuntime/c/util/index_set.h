@@ -0,0 +1,69 @@
+/*
+ * This file is part of OpenModelica.
+ *
+ * Copyright (c) 1998-CurrentYear, Open Source Modelica Consortium (OSMC),
+ * c/o Linköpings universitet, Department of Computer and Information Science,
+ * SE-58183 Linköping, Sweden.
+ *
+ * All rights reserved.
+ *
+ * THIS PROGRAM IS PROVIDED UNDER THE TERMS OF THE BSD NEW LICENSE OR THE
+ * GPL VERSION 3 LICENSE OR THE OSMC PUBLIC LICENSE (OSMC-PL) VERSION 1.2.
+ * ANY USE, REPRODUCTION OR DISTRIBUTION OF THIS PROGRAM CONSTITUTES
+ * RECIPIENT'S ACCEPTANCE OF THE OSMC PUBLIC LICENSE OR THE GPL VERSION 3,
+ * ACCORDING TO RECIPIENTS CHOICE.
+ *
+ * The OpenModelica software and the OSMC (Open Source Modelica Consortium)
+ * Public License (OSMC-PL) are obtained from OSMC, either from the above
+ * address, from the URLs: http://www.openmodelica.org or
+ * http://www.ida.liu.se/projects/OpenModelica, and in the OpenModelica
+ * distribution. GNU version 3 is obtained from:
+ * http://www.gnu.org/copyleft/gpl.html. The New BSD License is obtained from:
+ * http://www.opensource.org/licenses/BSD-3-Clause.
+ *
+ * This program is distributed WITHOUT ANY WARRANTY; without even the implied
+ * warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, EXCEPT AS
+ * EXPRESSLY SET FORTH IN THE BY RECIPIENT SELECTED SUBSIDIARY LICENSE
+ * CONDITIONS OF OSMC-PL.
+ *
+ */
+
+/*! \file index_set.h
+ *
+ * Description: This file is a C header file for the simulation runtime.
+ * It contains a set of indices with a fixed capacity. All memory is
+ * allocated when the set is created, adding, clearing and iterating
+ * over the set never allocate.
+ */
+
+#ifndef _INDEX_SET_H_
+#define _INDEX_SET_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  typedef struct INDEX_SET
+  {
+    unsigned int capacity;    /* Members are in [0, capacity) */
+    unsigned int size;        /* Number of members */
+    long *members;            /* Members in the order they were added, size elements are valid */
+    uint64_t *bits;           /* Bit i is set if i is a member */
+  } INDEX_SET;
+
+  INDEX_SET *allocIndexSet(unsigned int capacity);
+  void freeIndexSet(INDEX_SET *set);
+
+  void indexSetClear(INDEX_SET *set);
+  int indexSetAdd(INDEX_SET *set, long index);
+  void indexSetAddWord(INDEX_SET *set, unsigned int word, uint64_t bits);
+  int indexSetContains(const INDEX_SET *set, long index);
+  void indexSetSwap(INDEX_SET *a, INDEX_SET *b);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
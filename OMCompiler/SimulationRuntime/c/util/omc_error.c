@@ -172,9 +172,9 @@ const char *LOG_TYPE_DESC[LOG_TYPE_MAX] = {
 
 int useStream[SIM_LOG_MAX];         /* 1 if LOG is enabled, otherwise 0 */
 int backupUseStream[SIM_LOG_MAX];   /* Backup of useStream */
-int level[SIM_LOG_MAX];
-int lastType[SIM_LOG_MAX];
-int lastStream = LOG_UNKNOWN;
+OMC_THREAD_LOCAL int level[SIM_LOG_MAX];    /* indentation, per thread */
+OMC_THREAD_LOCAL int lastType[SIM_LOG_MAX]; /* per thread */
+OMC_THREAD_LOCAL int lastStream = LOG_UNKNOWN; /* per thread */
 int showAllWarnings = 0;
 int streamsActive = 1;              /* 1 if info streams from useStream are active, 0 if deactivated */
 
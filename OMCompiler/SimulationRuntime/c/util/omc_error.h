@@ -157,9 +157,9 @@ extern const char *LOG_STREAM_DETAILED_DESC[SIM_LOG_MAX];
 extern const char *LOG_TYPE_DESC[LOG_TYPE_MAX];
 
 extern int useStream[SIM_LOG_MAX];
-extern int level[SIM_LOG_MAX];
-extern int lastType[SIM_LOG_MAX];
-extern int lastStream;
+extern OMC_THREAD_LOCAL int level[SIM_LOG_MAX];
+extern OMC_THREAD_LOCAL int lastType[SIM_LOG_MAX];
+extern OMC_THREAD_LOCAL int lastStream;
 extern int showAllWarnings;
 extern char logBuffer[2048];
 
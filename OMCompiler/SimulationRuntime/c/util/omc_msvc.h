@@ -78,6 +78,9 @@ static union MSVC_FLOAT_HACK __NAN = {{0x00, 0x00, 0xC0, 0x7F}};
 /* get rid of inline for MSVC */
 #define OMC_INLINE
 
+/* thread local storage */
+#define OMC_THREAD_LOCAL __declspec(thread)
+
 #ifndef WIN32
 #define WIN32
 #endif
@@ -121,6 +124,9 @@ unsigned int alarm (unsigned int seconds);
 /* define inline for non-MSVC */
 #define OMC_INLINE inline
 
+/* thread local storage */
+#define OMC_THREAD_LOCAL __thread
+
 #endif /* end msvc */
 
 #if defined(__MINGW32__)
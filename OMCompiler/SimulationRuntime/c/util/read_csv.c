@@ -36,6 +36,8 @@
 #include "libcsv.h"
 #include "omc_file.h"
 #include "omc_numbers.h"
+#include "omc_mmap.h"
+#include <pthread.h>
 
 struct cell_row_count
 {
@@ -197,51 +199,7 @@ static void add_row(int c, void *t)
   }
 }
 
-double* read_csv_dataset_var(const char *filename, const char *var, int dimsize)
-{
-  const int buf_size = 4096;
-  char buf[4096];
-  char **res;
-  struct csv_parser p;
-  struct csv_body body = {0};
-  FILE *fin = omc_fopen(filename, "r");
-  size_t offset = 0;
-  unsigned char delim = CSV_COMMA;
-  if (!fin) {
-    return NULL;
-  }
-
-  /* determine delim */
-  omc_fread(buf, 1, 5, fin, 0);
-  if (0 == strcmp(buf, "\"sep="))
-  {
-    omc_fread(&delim, 1, 1, fin, 0);
-    offset = 8;
-  }
-  fseek(fin, offset, SEEK_SET);
-
-  csv_init(&p, CSV_STRICT | CSV_REPALL_NL | CSV_STRICT_FINI | CSV_APPEND_NULL | CSV_EMPTY_IS_NULL, delim);
-  csv_set_realloc_func(&p, realloc);
-  csv_set_free_func(&p, free);
-  do {
-    size_t len = omc_fread(buf, 1, buf_size, fin, 1);
-    if (len != buf_size && !feof(fin)) {
-      csv_free(&p);
-      fclose(fin);
-      return NULL;
-    }
-    csv_parse(&p,buf,len,add_cell,add_row,&body);
-  } while (!body.error && !feof(fin));
-  csv_fini(&p,add_cell,add_row,&body);
-  csv_free(&p);
-  fclose(fin);
-  if (body.error) {
-    return NULL;
-  }
-  return body.res;
-}
-
-struct csv_data* read_csv(const char *filename)
+static struct csv_data* read_csv_libcsv(const char *filename)
 {
   const int buf_size = 4096;
   char buf[4096];
@@ -308,6 +266,628 @@ struct csv_data* read_csv(const char *filename)
   return res;
 }
 
+/* Fast path for the csv-files written by the runtime and most tools:
+ * the file is mapped into memory, the line offsets are found with memchr
+ * in one pass and only the requested columns are converted. Files with
+ * quoted cells after the header fall back to libcsv.
+ */
+
+#define CSV_FAST_CELLS_PER_THREAD (1<<20)
+#define CSV_FAST_MAX_THREADS 8
+
+struct csv_fast_block
+{
+  const char *data;
+  const size_t *lines;
+  size_t size;
+  int firstRow;
+  int lastRow;
+  int numsteps;
+  int numcols;
+  int lastCol;
+  const int *outIndex;
+  double *res;
+  unsigned char delim;
+  int errorRow;
+};
+
+static const double csv_pow10[] = {
+  1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static int csv_is_space(char c)
+{
+  return c == ' ' || c == '\t' || c == '\r';
+}
+
+/* Converts a cell with om_strtod; the cell is not null-terminated in the mapped file */
+static int csv_parse_double_slow(const char *p, const char *end, double *out)
+{
+  char buf[64];
+  char *str = buf;
+  char *endptr = NULL;
+  size_t len = end - p;
+  int ok;
+  if (len >= sizeof(buf)) {
+    str = (char*) malloc(len+1);
+  }
+  memcpy(str, p, len);
+  str[len] = '\0';
+  *out = om_strtod(str, &endptr);
+  ok = endptr != str && *endptr == '\0';
+  if (!ok) {
+    fprintf(stderr,"Found non-double data in csv result-file: %s\n", str);
+  }
+  if (str != buf) {
+    free(str);
+  }
+  return ok;
+}
+
+/* Converts a cell to double. Decimal numbers with at most 15 significant digits
+ * and small exponents are exact as product or quotient of two exact doubles,
+ * everything else (long mantissas, nan, inf, hex) is passed to om_strtod.
+ */
+static int csv_parse_double(const char *p, const char *end, double *out)
+{
+  const char *start;
+  unsigned long long mantissa = 0;
+  int digits = 0, exponent = 0, expSign = 1, expValue = 0, negative = 0;
+
+  while (p < end && csv_is_space(*p)) p++;
+  while (end > p && csv_is_space(end[-1])) end--;
+  if (p == end) {
+    *out = 0.0; /* CSV_EMPTY_IS_NULL */
+    return 1;
+  }
+  start = p;
+  if (*p == '-' || *p == '+') {
+    negative = *p == '-';
+    p++;
+  }
+  while (p < end && *p >= '0' && *p <= '9') {
+    mantissa = mantissa*10 + (*p - '0');
+    if (mantissa) digits++;
+    p++;
+  }
+  if (p < end && *p == '.') {
+    p++;
+    while (p < end && *p >= '0' && *p <= '9') {
+      mantissa = mantissa*10 + (*p - '0');
+      if (mantissa) digits++;
+      exponent--;
+      p++;
+    }
+  }
+  if (p == start + negative || (p == start + negative + 1 && start[negative] == '.')) {
+    return csv_parse_double_slow(start, end, out);
+  }
+  if (p < end && (*p == 'e' || *p == 'E')) {
+    p++;
+    if (p < end && (*p == '-' || *p == '+')) {
+      expSign = *p == '-' ? -1 : 1;
+      p++;
+    }
+    if (p == end) {
+      return csv_parse_double_slow(start, end, out);
+    }
+    while (p < end && *p >= '0' && *p <= '9' && expValue < 10000) {
+      expValue = expValue*10 + (*p - '0');
+      p++;
+    }
+    exponent += expSign*expValue;
+  }
+  if (p != end || digits > 15 || exponent < -22 || exponent > 22) {
+    return csv_parse_double_slow(start, end, out);
+  }
+  *out = exponent < 0 ? (double) mantissa / csv_pow10[-exponent] : (double) mantissa * csv_pow10[exponent];
+  if (negative) {
+    *out = -*out;
+  }
+  return 1;
+}
+
+static int csv_parse_row(struct csv_fast_block *block, int row)
+{
+  const char *p = block->data + block->lines[row];
+  const char *lineEnd = block->data + (row+1 < block->numsteps ? block->lines[row+1] : block->size);
+  const char *end = (const char*) memchr(p, '\n', lineEnd - p);
+  int col;
+  if (end == NULL) {
+    end = lineEnd;
+  }
+  for (col = 0; col <= block->lastCol; col++) {
+    const char *cellEnd = (const char*) memchr(p, block->delim, end - p);
+    if (cellEnd == NULL) {
+      cellEnd = end;
+    }
+    if (block->outIndex[col] >= 0 && !csv_parse_double(p, cellEnd, block->res + (size_t)block->outIndex[col]*block->numsteps + row)) {
+      return 0;
+    }
+    if (cellEnd == end) {
+      return col == block->lastCol;
+    }
+    p = cellEnd + 1;
+  }
+  return 1;
+}
+
+static void* csv_parse_block(void *arg)
+{
+  struct csv_fast_block *block = (struct csv_fast_block*) arg;
+  int row;
+  for (row = block->firstRow; row < block->lastRow; row++) {
+    if (!csv_parse_row(block, row)) {
+      block->errorRow = row;
+      break;
+    }
+  }
+  return NULL;
+}
+
+/* Finds the end of the header line, newlines within quoted names are skipped */
+static size_t csv_header_end(const char *data, size_t offset, size_t size)
+{
+  int quoted = 0;
+  for (; offset < size; offset++) {
+    if (data[offset] == '"') {
+      quoted = !quoted;
+    } else if (data[offset] == '\n' && !quoted) {
+      return offset+1;
+    }
+  }
+  return size;
+}
+
+static char** csv_parse_header(const char *data, size_t size, unsigned char delim, int *numvars)
+{
+  struct csv_parser p;
+  struct csv_head head = {0};
+  csv_init(&p, CSV_STRICT | CSV_REPALL_NL | CSV_STRICT_FINI | CSV_APPEND_NULL | CSV_EMPTY_IS_NULL, delim);
+  csv_set_realloc_func(&p, realloc);
+  csv_set_free_func(&p, free);
+  csv_parse(&p, data, size, add_variable, found_first_row, &head);
+  csv_fini(&p, add_variable, found_first_row, &head);
+  csv_free(&p);
+  *numvars = head.size;
+  return head.variables;
+}
+
+/* The mapped file and its header */
+struct csv_fast_file
+{
+  omc_mmap_read map;
+  unsigned char delim;
+  size_t headerStart;
+  size_t bodyStart;
+  char **header;
+  int numheader;
+};
+
+static void csv_fast_close(struct csv_fast_file *file)
+{
+  int j;
+  if (file->header) {
+    for (j = 0; j < file->numheader; j++) {
+      free(file->header[j]);
+    }
+    free(file->header);
+    file->header = NULL;
+  }
+  omc_mmap_close_read(file->map);
+}
+
+/* Maps the file and finds the delimiter and the end of the header. Returns 0 on success */
+static int csv_fast_open(const char *filename, struct csv_fast_file *file)
+{
+  omc_stat_t st;
+  FILE *fin;
+
+  memset(file, 0, sizeof(struct csv_fast_file));
+  file->delim = CSV_COMMA;
+  if (omc_stat(filename, &st) != 0 || st.st_size == 0 || !(fin = omc_fopen(filename, "rb"))) {
+    return 1;
+  }
+  fclose(fin);
+  file->map = omc_mmap_open_read(filename);
+
+  /* determine delim */
+  if (file->map.size > 5 && 0 == strncmp(file->map.data, "\"sep=", 5)) {
+    const char *nl = (const char*) memchr(file->map.data, '\n', file->map.size);
+    file->delim = file->map.data[5];
+    file->headerStart = nl ? (size_t)(nl - file->map.data) + 1 : file->map.size;
+  }
+  file->bodyStart = csv_header_end(file->map.data, file->headerStart, file->map.size);
+  return 0;
+}
+
+/* Parses the header of an opened file. Returns 0 on success */
+static int csv_fast_header(struct csv_fast_file *file)
+{
+  file->header = csv_parse_header(file->map.data + file->headerStart, file->bodyStart - file->headerStart, file->delim, &file->numheader);
+  return file->header == NULL || file->numheader == 0;
+}
+
+/* Appends the offsets of the non-empty lines from *pos to lines, at most maxLines
+ * of them (0 for all), and moves *pos behind them. Returns the new number of lines */
+static size_t csv_find_lines(const char *data, size_t size, size_t *pos, size_t **lines, size_t *capacity, size_t nlines, size_t maxLines)
+{
+  size_t first = nlines;
+  while (*pos < size && (maxLines == 0 || nlines - first < maxLines)) {
+    const char *nl = (const char*) memchr(data + *pos, '\n', size - *pos);
+    size_t next = nl ? (size_t)(nl - data) + 1 : size;
+    size_t k;
+    for (k = *pos; k < next && (csv_is_space(data[k]) || data[k] == '\n'); k++);
+    if (k < next) {
+      if (nlines == *capacity) {
+        *capacity = *capacity ? 2*(*capacity) : 1024;
+        *lines = (size_t*) realloc(*lines, (*capacity)*sizeof(size_t));
+      }
+      (*lines)[nlines++] = *pos;
+    }
+    *pos = next;
+  }
+  return nlines;
+}
+
+/* Maps the columns of the header to the columns of the result: all of them if
+ * vars is NULL, else the ones named in vars in the order of the file.
+ * Returns the number of result columns */
+static int csv_map_columns(char **header, int numheader, int nvars, const char **vars, int *outIndex, int *lastCol)
+{
+  int i, j, numout = 0;
+  *lastCol = -1;
+  for (j = 0; j < numheader; j++) {
+    outIndex[j] = -1;
+    if (vars == NULL) {
+      outIndex[j] = numout++;
+    } else {
+      for (i = 0; i < nvars; i++) {
+        if (0 == strcmp(header[j], vars[i])) {
+          outIndex[j] = numout++;
+          break;
+        }
+      }
+    }
+    if (outIndex[j] >= 0) {
+      *lastCol = j;
+    }
+  }
+  if (vars == NULL) {
+    *lastCol = numheader-1;
+  }
+  return numout;
+}
+
+/* Parses the rows of block over nthreads threads and sets block->errorRow */
+static void csv_parse_rows(struct csv_fast_block *block, int nthreads)
+{
+  int i;
+  block->errorRow = -1;
+  if (nthreads == 1) {
+    block->firstRow = 0;
+    block->lastRow = block->numsteps;
+    csv_parse_block(block);
+  } else if (nthreads > 1) {
+    struct csv_fast_block *blocks = (struct csv_fast_block*) malloc(nthreads*sizeof(struct csv_fast_block));
+    pthread_t *threads = (pthread_t*) malloc(nthreads*sizeof(pthread_t));
+    for (i = 0; i < nthreads; i++) {
+      blocks[i] = *block;
+      blocks[i].firstRow = (int) (((size_t)i*block->numsteps) / nthreads);
+      blocks[i].lastRow = (int) (((size_t)(i+1)*block->numsteps) / nthreads);
+      if (pthread_create(&threads[i], NULL, csv_parse_block, &blocks[i])) {
+        csv_parse_block(&blocks[i]);
+        blocks[i].firstRow = -1;
+      }
+    }
+    for (i = 0; i < nthreads; i++) {
+      if (blocks[i].firstRow >= 0) {
+        pthread_join(threads[i], NULL);
+      }
+      if (blocks[i].errorRow >= 0 && (block->errorRow < 0 || blocks[i].errorRow < block->errorRow)) {
+        block->errorRow = blocks[i].errorRow;
+      }
+    }
+    free(blocks);
+    free(threads);
+  }
+}
+
+/* Returns NULL and sets *fallback if the file needs the libcsv parser */
+static struct csv_data* read_csv_fast(const char *filename, int nvars, const char **vars, int nthreads, int *fallback)
+{
+  struct csv_fast_file file;
+  struct csv_data *res = NULL;
+  struct csv_fast_block block = {0};
+  int *outIndex = NULL;
+  size_t *lines = NULL;
+  size_t pos, nlines = 0, capacity = 0;
+  int numout, j;
+
+  *fallback = 0;
+  if (csv_fast_open(filename, &file)) {
+    return NULL;
+  }
+  if (memchr(file.map.data + file.bodyStart, '"', file.map.size - file.bodyStart)) {
+    *fallback = 1;
+    goto done;
+  }
+  if (csv_fast_header(&file)) {
+    goto done;
+  }
+
+  /* line offsets of all non-empty rows */
+  pos = file.bodyStart;
+  nlines = csv_find_lines(file.map.data, file.map.size, &pos, &lines, &capacity, 0, 0);
+
+  /* map the requested columns */
+  outIndex = (int*) malloc(file.numheader*sizeof(int));
+  numout = csv_map_columns(file.header, file.numheader, nvars, vars, outIndex, &block.lastCol);
+
+  res = (struct csv_data*) malloc(sizeof(struct csv_data));
+  res->numvars = numout;
+  res->numsteps = (int) nlines;
+  res->variables = (char**) malloc((numout > 0 ? numout : 1)*sizeof(char*));
+  res->data = (double*) malloc(((size_t)numout*nlines > 0 ? (size_t)numout*nlines : 1)*sizeof(double));
+  for (j = 0; j < file.numheader; j++) {
+    if (outIndex[j] >= 0) {
+      res->variables[outIndex[j]] = file.header[j];
+    } else {
+      free(file.header[j]);
+    }
+  }
+  free(file.header);
+  file.header = NULL;
+
+  block.data = file.map.data;
+  block.size = file.map.size;
+  block.lines = lines;
+  block.numsteps = (int) nlines;
+  block.numcols = file.numheader;
+  block.outIndex = outIndex;
+  block.res = res->data;
+  block.delim = file.delim;
+
+  if (nthreads <= 0) {
+    nthreads = 1 + (int) (((size_t)file.numheader*nlines) / CSV_FAST_CELLS_PER_THREAD);
+  }
+  if (nthreads > CSV_FAST_MAX_THREADS) {
+    nthreads = CSV_FAST_MAX_THREADS;
+  }
+  if (nthreads > (int) nlines) {
+    nthreads = nlines > 0 ? (int) nlines : 1;
+  }
+  if (numout == 0) {
+    nthreads = 0;
+  }
+  csv_parse_rows(&block, nthreads);
+
+  if (block.errorRow >= 0) {
+    fprintf(stderr,"Did not find time points for all variables for row: %d\n", block.errorRow+1);
+    omc_free_csv_reader(res);
+    res = NULL;
+  }
+
+done:
+  csv_fast_close(&file);
+  free(outIndex);
+  free(lines);
+  return res;
+}
+
+/* Keeps the requested columns of a complete csv_data, used with the libcsv fallback */
+static struct csv_data* csv_select_columns(struct csv_data *all, int nvars, const char **vars)
+{
+  struct csv_data *res;
+  int i, j, numout = 0;
+  if (all == NULL || vars == NULL) {
+    return all;
+  }
+  res = (struct csv_data*) malloc(sizeof(struct csv_data));
+  res->numsteps = all->numsteps;
+  res->variables = (char**) malloc((all->numvars > 0 ? all->numvars : 1)*sizeof(char*));
+  res->data = (double*) malloc(((size_t)all->numvars*all->numsteps > 0 ? (size_t)all->numvars*all->numsteps : 1)*sizeof(double));
+  for (j = 0; j < all->numvars; j++) {
+    for (i = 0; i < nvars; i++) {
+      if (0 == strcmp(all->variables[j], vars[i])) {
+        res->variables[numout] = strdup(all->variables[j]);
+        memcpy(res->data + (size_t)numout*all->numsteps, all->data + (size_t)j*all->numsteps, all->numsteps*sizeof(double));
+        numout++;
+        break;
+      }
+    }
+  }
+  res->numvars = numout;
+  omc_free_csv_reader(all);
+  return res;
+}
+
+struct csv_data* read_csv_columns(const char *filename, int nvars, const char **vars, int nthreads)
+{
+  int fallback;
+  struct csv_data *res = read_csv_fast(filename, nvars, vars, nthreads, &fallback);
+  if (fallback) {
+    res = csv_select_columns(read_csv_libcsv(filename), nvars, vars);
+  }
+  return res;
+}
+
+/* Reads the columns of a file in blocks of rows with the parser of
+ * read_csv_columns, so that files larger than the memory can be walked
+ * through. The file is mapped; only the offsets of the lines of the current
+ * block are kept. Files with quoted cells after the header are read at once
+ * with read_csv_columns. */
+struct csv_column_reader
+{
+  struct csv_fast_file file;
+  struct csv_data *all;     /* quoted cells: the requested columns of all rows */
+  size_t pos;               /* first byte of the next row */
+  int row;                  /* rows read so far */
+  int nvars;
+  int *column;              /* column in buf (or all) of each requested variable, -1 if missing */
+  int *outIndex;            /* column in buf of each column of the file */
+  int numout;
+  int lastCol;
+  size_t *lines;
+  size_t capacity;
+  double *buf;
+  size_t bufRows;
+};
+
+struct csv_column_reader* read_csv_columns_open(const char *filename, int nvars, const char **vars)
+{
+  struct csv_column_reader *reader = (struct csv_column_reader*) calloc(1, sizeof(struct csv_column_reader));
+  int i, j;
+
+  if (csv_fast_open(filename, &reader->file)) {
+    free(reader);
+    return NULL;
+  }
+  if (csv_fast_header(&reader->file)) {
+    read_csv_columns_close(reader);
+    return NULL;
+  }
+  reader->pos = reader->file.bodyStart;
+  reader->nvars = nvars;
+  reader->column = (int*) malloc((nvars > 0 ? nvars : 1)*sizeof(int));
+  if (nvars > 0 && memchr(reader->file.map.data + reader->file.bodyStart, '"', reader->file.map.size - reader->file.bodyStart)) {
+    reader->all = read_csv_columns(filename, nvars, vars, 0);
+    if (reader->all == NULL) {
+      read_csv_columns_close(reader);
+      return NULL;
+    }
+    for (i = 0; i < nvars; i++) {
+      reader->column[i] = -1;
+      for (j = 0; j < reader->all->numvars; j++) {
+        if (0 == strcmp(reader->all->variables[j], vars[i])) {
+          reader->column[i] = j;
+          break;
+        }
+      }
+    }
+    return reader;
+  }
+  reader->outIndex = (int*) malloc(reader->file.numheader*sizeof(int));
+  reader->numout = csv_map_columns(reader->file.header, reader->file.numheader, nvars, vars, reader->outIndex, &reader->lastCol);
+  for (i = 0; i < nvars; i++) {
+    reader->column[i] = -1;
+    for (j = 0; j < reader->file.numheader; j++) {
+      if (reader->outIndex[j] >= 0 && 0 == strcmp(reader->file.header[j], vars[i])) {
+        reader->column[i] = reader->outIndex[j];
+        break;
+      }
+    }
+  }
+  return reader;
+}
+
+char** read_csv_columns_names(struct csv_column_reader *reader, int *numvars)
+{
+  *numvars = reader->file.numheader;
+  return reader->file.header;
+}
+
+int read_csv_columns_found(struct csv_column_reader *reader, int i)
+{
+  return reader->column[i] >= 0;
+}
+
+int read_csv_columns_next(struct csv_column_reader *reader, double *cols, size_t stride, int maxRows)
+{
+  struct csv_fast_block block = {0};
+  size_t nlines;
+  int i;
+
+  if (maxRows <= 0) {
+    return 0;
+  }
+  if (reader->all) {
+    int n = reader->all->numsteps - reader->row;
+    if (n > maxRows) {
+      n = maxRows;
+    }
+    for (i = 0; i < reader->nvars; i++) {
+      double *col = cols + (size_t)i*stride;
+      if (reader->column[i] >= 0) {
+        memcpy(col, reader->all->data + (size_t)reader->column[i]*reader->all->numsteps + reader->row, n*sizeof(double));
+      } else {
+        memset(col, 0, n*sizeof(double));
+      }
+    }
+    reader->row += n;
+    return n;
+  }
+
+  nlines = csv_find_lines(reader->file.map.data, reader->file.map.size, &reader->pos, &reader->lines, &reader->capacity, 0, maxRows);
+  if (nlines == 0) {
+    return 0;
+  }
+  if (nlines > reader->bufRows) {
+    reader->bufRows = nlines;
+    reader->buf = (double*) realloc(reader->buf, ((size_t)reader->numout*nlines > 0 ? (size_t)reader->numout*nlines : 1)*sizeof(double));
+  }
+  block.data = reader->file.map.data;
+  block.size = reader->pos;
+  block.lines = reader->lines;
+  block.numsteps = (int) nlines;
+  block.numcols = reader->file.numheader;
+  block.lastCol = reader->lastCol;
+  block.outIndex = reader->outIndex;
+  block.res = reader->buf;
+  block.delim = reader->file.delim;
+  csv_parse_rows(&block, reader->numout > 0 ? 1 : 0);
+  if (block.errorRow >= 0) {
+    fprintf(stderr,"Did not find time points for all variables for row: %d\n", reader->row + block.errorRow + 1);
+    return -1;
+  }
+  for (i = 0; i < reader->nvars; i++) {
+    double *col = cols + (size_t)i*stride;
+    if (reader->column[i] >= 0) {
+      memcpy(col, reader->buf + (size_t)reader->column[i]*nlines, nlines*sizeof(double));
+    } else {
+      memset(col, 0, nlines*sizeof(double));
+    }
+  }
+  reader->row += (int) nlines;
+  return (int) nlines;
+}
+
+void read_csv_columns_close(struct csv_column_reader *reader)
+{
+  csv_fast_close(&reader->file);
+  if (reader->all) {
+    omc_free_csv_reader(reader->all);
+  }
+  free(reader->column);
+  free(reader->outIndex);
+  free(reader->lines);
+  free(reader->buf);
+  free(reader);
+}
+
+struct csv_data* read_csv(const char *filename)
+{
+  return read_csv_columns(filename, 0, NULL, 0);
+}
+
+double* read_csv_dataset_var(const char *filename, const char *var, int dimsize)
+{
+  double *res;
+  struct csv_data *csv = read_csv_columns(filename, 1, &var, 0);
+  if (csv == NULL) {
+    return NULL;
+  }
+  if (csv->numvars != 1 || (dimsize > 0 && csv->numsteps != dimsize)) {
+    omc_free_csv_reader(csv);
+    return NULL;
+  }
+  res = csv->data;
+  csv->data = NULL;
+  omc_free_csv_reader(csv);
+  return res;
+}
+
 double* read_csv_dataset(struct csv_data *data, const char *var)
 {
   int i,found=-1;
@@ -323,6 +903,228 @@ double* read_csv_dataset(struct csv_data *data, const char *var)
   return data->data + i*data->numsteps;
 }
 
+/* A mapped CSV file with its header and the offsets of all rows, so that
+ * columns can be read on demand without scanning the file again. The names
+ * are kept sorted, so names which are not in the file are found without
+ * touching the rows. Each call of read_csv_load reads its columns into one
+ * new block; columns read before are neither copied nor moved. */
+struct csv_reader_name
+{
+  const char *name;
+  int index;
+};
+
+struct csv_reader
+{
+  struct csv_fast_file file;
+  struct csv_data *all;             /* quoted cells: all columns read with libcsv */
+  char **names;                     /* file.header or all->variables */
+  int numnames;
+  struct csv_reader_name *sorted;
+  size_t *lines;
+  int numsteps;
+  double **columns;                 /* values of each column, NULL if not read yet */
+  double **blocks;
+  int nblocks;
+};
+
+static int csv_reader_name_cmp(const void *a, const void *b)
+{
+  const struct csv_reader_name *na = (const struct csv_reader_name*) a;
+  const struct csv_reader_name *nb = (const struct csv_reader_name*) b;
+  int c = strcmp(na->name, nb->name);
+  return c ? c : na->index - nb->index;
+}
+
+/* Index of the first column named var, -1 if there is none */
+static int csv_reader_find(struct csv_reader *reader, const char *var)
+{
+  int lo = 0, hi = reader->numnames;
+  while (lo < hi) {
+    int mid = lo + (hi - lo)/2;
+    if (strcmp(reader->sorted[mid].name, var) < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return (lo < reader->numnames && 0 == strcmp(reader->sorted[lo].name, var)) ? reader->sorted[lo].index : -1;
+}
+
+struct csv_reader* read_csv_open(const char *filename)
+{
+  struct csv_reader *reader = (struct csv_reader*) calloc(1, sizeof(struct csv_reader));
+  size_t pos, capacity = 0;
+  int j;
+
+  if (csv_fast_open(filename, &reader->file)) {
+    free(reader);
+    return NULL;
+  }
+  if (csv_fast_header(&reader->file)) {
+    read_csv_close(reader);
+    return NULL;
+  }
+  if (memchr(reader->file.map.data + reader->file.bodyStart, '"', reader->file.map.size - reader->file.bodyStart)) {
+    reader->all = read_csv_libcsv(filename);
+    if (reader->all == NULL) {
+      read_csv_close(reader);
+      return NULL;
+    }
+    reader->names = reader->all->variables;
+    reader->numnames = reader->all->numvars;
+    reader->numsteps = reader->all->numsteps;
+  } else {
+    reader->names = reader->file.header;
+    reader->numnames = reader->file.numheader;
+    pos = reader->file.bodyStart;
+    reader->numsteps = (int) csv_find_lines(reader->file.map.data, reader->file.map.size, &pos, &reader->lines, &capacity, 0, 0);
+  }
+
+  reader->sorted = (struct csv_reader_name*) malloc((reader->numnames > 0 ? reader->numnames : 1)*sizeof(struct csv_reader_name));
+  reader->columns = (double**) calloc(reader->numnames > 0 ? reader->numnames : 1, sizeof(double*));
+  for (j = 0; j < reader->numnames; j++) {
+    reader->sorted[j].name = reader->names[j];
+    reader->sorted[j].index = j;
+    if (reader->all) {
+      reader->columns[j] = reader->all->data + (size_t)j*reader->numsteps;
+    }
+  }
+  qsort(reader->sorted, reader->numnames, sizeof(struct csv_reader_name), csv_reader_name_cmp);
+  return reader;
+}
+
+void read_csv_close(struct csv_reader *reader)
+{
+  int i;
+  csv_fast_close(&reader->file);
+  if (reader->all) {
+    omc_free_csv_reader(reader->all);
+  }
+  for (i = 0; i < reader->nblocks; i++) {
+    free(reader->blocks[i]);
+  }
+  free(reader->blocks);
+  free(reader->columns);
+  free(reader->sorted);
+  free(reader->lines);
+  free(reader);
+}
+
+int read_csv_numsteps(struct csv_reader *reader)
+{
+  return reader->numsteps;
+}
+
+char** read_csv_names(struct csv_reader *reader, int *numvars)
+{
+  *numvars = reader->numnames;
+  return reader->names;
+}
+
+int read_csv_load(struct csv_reader *reader, int nvars, const char **vars)
+{
+  struct csv_fast_block block = {0};
+  int *outIndex;
+  int i, j, numout = 0, nthreads;
+  double *res;
+
+  if (reader->all || reader->numnames == 0) {
+    return 0;
+  }
+  outIndex = (int*) malloc(reader->numnames*sizeof(int));
+  for (j = 0; j < reader->numnames; j++) {
+    outIndex[j] = -1;
+  }
+  block.lastCol = -1;
+  for (i = 0; i < (vars ? nvars : reader->numnames); i++) {
+    j = vars ? csv_reader_find(reader, vars[i]) : i;
+    if (j >= 0 && reader->columns[j] == NULL && outIndex[j] < 0) {
+      outIndex[j] = numout++;
+      if (j > block.lastCol) {
+        block.lastCol = j;
+      }
+    }
+  }
+  if (numout == 0) {
+    free(outIndex);
+    return 0;
+  }
+
+  res = (double*) malloc(((size_t)numout*reader->numsteps > 0 ? (size_t)numout*reader->numsteps : 1)*sizeof(double));
+  block.data = reader->file.map.data;
+  block.size = reader->file.map.size;
+  block.lines = reader->lines;
+  block.numsteps = reader->numsteps;
+  block.numcols = reader->numnames;
+  block.outIndex = outIndex;
+  block.res = res;
+  block.delim = reader->file.delim;
+  nthreads = 1 + (int) (((size_t)(block.lastCol+1)*reader->numsteps) / CSV_FAST_CELLS_PER_THREAD);
+  if (nthreads > CSV_FAST_MAX_THREADS) {
+    nthreads = CSV_FAST_MAX_THREADS;
+  }
+  if (nthreads > reader->numsteps) {
+    nthreads = reader->numsteps > 0 ? reader->numsteps : 1;
+  }
+  csv_parse_rows(&block, nthreads);
+  if (block.errorRow >= 0) {
+    fprintf(stderr,"Did not find time points for all variables for row: %d\n", block.errorRow+1);
+    free(outIndex);
+    free(res);
+    return -1;
+  }
+
+  for (j = 0; j < reader->numnames; j++) {
+    if (outIndex[j] >= 0) {
+      reader->columns[j] = res + (size_t)outIndex[j]*reader->numsteps;
+    }
+  }
+  reader->blocks = (double**) realloc(reader->blocks, (reader->nblocks+1)*sizeof(double*));
+  reader->blocks[reader->nblocks++] = res;
+  free(outIndex);
+  return 0;
+}
+
+double* read_csv_column(struct csv_reader *reader, const char *var)
+{
+  int j = csv_reader_find(reader, var);
+  if (j < 0) {
+    return NULL;
+  }
+  if (reader->columns[j] == NULL && read_csv_load(reader, 1, &var)) {
+    return NULL;
+  }
+  return reader->columns[j];
+}
+
+char** read_csv_column_names(const char *filename, int *numvars)
+{
+  struct csv_fast_file file;
+  char **names;
+  if (csv_fast_open(filename, &file)) {
+    return NULL;
+  }
+  if (csv_fast_header(&file)) {
+    csv_fast_close(&file);
+    return NULL;
+  }
+  names = file.header;
+  *numvars = file.numheader;
+  file.header = NULL;
+  csv_fast_close(&file);
+  return names;
+}
+
+void omc_free_csv_column_names(char **names, int numvars)
+{
+  int i;
+  for (i = 0; i < numvars; i++) {
+    free(names[i]);
+  }
+  free(names);
+}
+
 void omc_free_csv_reader(struct csv_data *data)
 {
   int i;
@@ -47,9 +47,46 @@ int read_csv_dataset_size(const char* filename);
 char** read_csv_variables(FILE *fin, int *length, unsigned char delim);
 
 struct csv_data* read_csv(const char *filename);
+/* Reads only the columns named in vars (all columns if vars is NULL) in the order of the file.
+ * The parse is split into blocks of rows over nthreads threads, nthreads <= 0 picks the
+ * number of threads from the size of the file. */
+struct csv_data* read_csv_columns(const char *filename, int nvars, const char **vars, int nthreads);
 double* read_csv_dataset(struct csv_data *data, const char *var);
+/* The names of all columns of the file, without reading the rows; NULL if the file cannot be read */
+char** read_csv_column_names(const char *filename, int *numvars);
+void omc_free_csv_column_names(char **names, int numvars);
+/* Reads a single column, returns NULL if var is missing or the column has not dimsize rows (dimsize > 0) */
+double* read_csv_dataset_var(const char *filename, const char *var, int dimsize);
 void omc_free_csv_reader(struct csv_data *data);
 
+/* Reads the columns named in vars in blocks of rows, with the same parser as read_csv_columns,
+ * so that files larger than the memory can be walked through. */
+struct csv_column_reader;
+struct csv_column_reader* read_csv_columns_open(const char *filename, int nvars, const char **vars);
+/* The names of all columns of the file */
+char** read_csv_columns_names(struct csv_column_reader *reader, int *numvars);
+/* Returns 0 if vars[i] of read_csv_columns_open is not a column of the file; its values read as 0 */
+int read_csv_columns_found(struct csv_column_reader *reader, int i);
+/* Reads up to maxRows rows; row k of vars[i] goes to cols[i*stride+k].
+ * Returns the number of rows read, 0 at the end of the file and -1 on error */
+int read_csv_columns_next(struct csv_column_reader *reader, double *cols, size_t stride, int maxRows);
+void read_csv_columns_close(struct csv_column_reader *reader);
+
+/* Keeps a file open with its header and the offsets of its rows, so that the columns
+ * can be read on demand without parsing the file again. */
+struct csv_reader;
+struct csv_reader* read_csv_open(const char *filename);
+void read_csv_close(struct csv_reader *reader);
+int read_csv_numsteps(struct csv_reader *reader);
+/* The names of all columns of the file, owned by the reader */
+char** read_csv_names(struct csv_reader *reader, int *numvars);
+/* Reads the columns named in vars (all columns if vars is NULL) that are not read yet, in one
+ * pass over the rows. Names which are not columns of the file are skipped. Returns -1 on error */
+int read_csv_load(struct csv_reader *reader, int nvars, const char **vars);
+/* The values of column var, read on demand; NULL if var is not a column of the file.
+ * The pointer stays valid until read_csv_close */
+double* read_csv_column(struct csv_reader *reader, const char *var);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
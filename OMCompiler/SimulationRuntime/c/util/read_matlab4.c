@@ -621,6 +621,35 @@ double* omc_matlab4_read_vals(ModelicaMatReader *reader, int varIndex)
   return reader->vars[ix];
 }
 
+int omc_matlab4_read_rows(ModelicaMatReader *reader, uint32_t firstRow, uint32_t nrows, double *rows)
+{
+  size_t i, n;
+  if (firstRow > reader->nrows || nrows > reader->nrows - firstRow) {
+    return 1;
+  }
+  n = (size_t)nrows*reader->nvar;
+  if (n == 0) {
+    return 0;
+  }
+  if (reader->doublePrecision==1) {
+    omc_fseek(reader->file, reader->var_offset + sizeof(double)*firstRow*reader->nvar, SEEK_SET);
+    if (n != omc_fread(rows, sizeof(double), n, reader->file, 0)) {
+      return 1;
+    }
+  } else {
+    /* Convert in place from the back, the floats occupy the first half of the buffer */
+    float *buffer = (float*) rows;
+    omc_fseek(reader->file, reader->var_offset + sizeof(float)*firstRow*reader->nvar, SEEK_SET);
+    if (n != omc_fread(buffer, sizeof(float), n, reader->file, 0)) {
+      return 1;
+    }
+    for (i=n; i>0; i--) {
+      rows[i-1] = buffer[i-1];
+    }
+  }
+  return 0;
+}
+
 void matrix_transpose(double *m, int w, int h)
 {
   int start;
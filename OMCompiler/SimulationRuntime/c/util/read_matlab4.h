@@ -78,6 +78,11 @@ ModelicaMatVariable_t *omc_matlab4_find_var(ModelicaMatReader *reader, const cha
  */
 double* omc_matlab4_read_vals(ModelicaMatReader *reader, int varIndex);
 
+/* Reads the rows firstRow..firstRow+nrows-1 of data_2 into rows, nvar values per row
+ * as they are stored in the file (aliases with negative index are not negated).
+ * Used to walk through files that do not fit into memory. Returns 0 on success */
+int omc_matlab4_read_rows(ModelicaMatReader *reader, uint32_t firstRow, uint32_t nrows, double *rows);
+
 /* Returns 0 on success */
 int omc_matlab4_val(double *res, ModelicaMatReader *reader, ModelicaMatVariable_t *var, double time);
 
@@ -39,27 +39,44 @@
 #include "omc_error.h"
 #define NSEC_PER_SEC 1000000000L
 
+/* The timers are thread local, so that several model instances can be
+ * simulated concurrently in one process (see simulation_instances.h).
+ * The address of a thread local array is no constant initializer, so the
+ * arrays allocated by rt_init are kept separately and the macros below pick
+ * either them or the statically allocated ones. */
+
 /* If min_time is set, subtract this amount from measured times to avoid
  * including the time of measuring in reported statistics */
-static double min_time = 0;
-static uint32_t default_rt_clock_ncall[NUM_RT_CLOCKS] = { 0 };
-static uint32_t default_rt_clock_ncall_min[NUM_RT_CLOCKS] = { 0 };
-static uint32_t default_rt_clock_ncall_max[NUM_RT_CLOCKS] = { 0 };
-static uint32_t default_rt_clock_ncall_total[NUM_RT_CLOCKS] = { 0 };
-static uint32_t *rt_clock_ncall = default_rt_clock_ncall;
-static uint32_t *rt_clock_ncall_min = default_rt_clock_ncall_min;
-static uint32_t *rt_clock_ncall_max = default_rt_clock_ncall_max;
-static uint32_t *rt_clock_ncall_total = default_rt_clock_ncall_total;
-
-static rtclock_t default_total_tp[NUM_RT_CLOCKS];
-static rtclock_t default_max_tp[NUM_RT_CLOCKS];
-static rtclock_t default_acc_tp[NUM_RT_CLOCKS];
-static rtclock_t default_tick_tp[NUM_RT_CLOCKS];
-
-static rtclock_t *total_tp = default_total_tp;
-static rtclock_t *max_tp = default_max_tp;
-static rtclock_t *acc_tp = default_acc_tp;
-static rtclock_t *tick_tp = default_tick_tp;
+static OMC_THREAD_LOCAL double min_time = 0;
+static OMC_THREAD_LOCAL uint32_t default_rt_clock_ncall[NUM_RT_CLOCKS] = { 0 };
+static OMC_THREAD_LOCAL uint32_t default_rt_clock_ncall_min[NUM_RT_CLOCKS] = { 0 };
+static OMC_THREAD_LOCAL uint32_t default_rt_clock_ncall_max[NUM_RT_CLOCKS] = { 0 };
+static OMC_THREAD_LOCAL uint32_t default_rt_clock_ncall_total[NUM_RT_CLOCKS] = { 0 };
+static OMC_THREAD_LOCAL uint32_t *alloc_rt_clock_ncall = NULL;
+static OMC_THREAD_LOCAL uint32_t *alloc_rt_clock_ncall_min = NULL;
+static OMC_THREAD_LOCAL uint32_t *alloc_rt_clock_ncall_max = NULL;
+static OMC_THREAD_LOCAL uint32_t *alloc_rt_clock_ncall_total = NULL;
+
+static OMC_THREAD_LOCAL rtclock_t default_total_tp[NUM_RT_CLOCKS];
+static OMC_THREAD_LOCAL rtclock_t default_max_tp[NUM_RT_CLOCKS];
+static OMC_THREAD_LOCAL rtclock_t default_acc_tp[NUM_RT_CLOCKS];
+static OMC_THREAD_LOCAL rtclock_t default_tick_tp[NUM_RT_CLOCKS];
+static OMC_THREAD_LOCAL rtclock_t *alloc_total_tp = NULL;
+static OMC_THREAD_LOCAL rtclock_t *alloc_max_tp = NULL;
+static OMC_THREAD_LOCAL rtclock_t *alloc_acc_tp = NULL;
+static OMC_THREAD_LOCAL rtclock_t *alloc_tick_tp = NULL;
+
+#define rt_clock_ncall (alloc_rt_clock_ncall ? alloc_rt_clock_ncall : default_rt_clock_ncall)
+#define rt_clock_ncall_min (alloc_rt_clock_ncall_min ? alloc_rt_clock_ncall_min : default_rt_clock_ncall_min)
+#define rt_clock_ncall_max (alloc_rt_clock_ncall_max ? alloc_rt_clock_ncall_max : default_rt_clock_ncall_max)
+#define rt_clock_ncall_total (alloc_rt_clock_ncall_total ? alloc_rt_clock_ncall_total : default_rt_clock_ncall_total)
+#define total_tp (alloc_total_tp ? alloc_total_tp : default_total_tp)
+#define max_tp (alloc_max_tp ? alloc_max_tp : default_max_tp)
+#define acc_tp (alloc_acc_tp ? alloc_acc_tp : default_acc_tp)
+#define rt_tick_tp (alloc_tick_tp ? alloc_tick_tp : default_tick_tp) /* tick_tp is a parameter name below */
+
+/* number of timers requested by rt_init */
+static int rt_num_timers = NUM_RT_CLOCKS;
 
 static int rtclock_compare(rtclock_t, rtclock_t);
 
@@ -189,11 +206,11 @@ void rt_tick(int ix) {
       init = 1;
       QueryPerformanceFrequency(&performance_frequency);
     }
-    QueryPerformanceCounter(&tick_tp[ix]);
+    QueryPerformanceCounter(&rt_tick_tp[ix]);
   } else {
     LARGE_INTEGER time;
     time.QuadPart = RDTSC();
-    tick_tp[ix] = time;
+    rt_tick_tp[ix] = time;
   }
   rt_clock_ncall[ix]++;
 }
@@ -204,13 +221,13 @@ double rt_tock(int ix) {
     LARGE_INTEGER tock_tp;
     double d1, d2;
     QueryPerformanceCounter(&tock_tp);
-    d1 = (double) (tock_tp.QuadPart - tick_tp[ix].QuadPart);
+    d1 = (double) (tock_tp.QuadPart - rt_tick_tp[ix].QuadPart);
     d2 = (double) performance_frequency.QuadPart;
     d = d1 / d2;
   } else {
     LARGE_INTEGER tock_tp;
     tock_tp.QuadPart = RDTSC();
-    d = (double) (tock_tp.QuadPart - tick_tp[ix].QuadPart);
+    d = (double) (tock_tp.QuadPart - rt_tick_tp[ix].QuadPart);
   }
   if (d < min_time) {
     min_time = d;
@@ -237,11 +254,11 @@ void rt_accumulate(int ix) {
   if(selectedClock == OMC_CLOCK_REALTIME) {
     LARGE_INTEGER tock_tp;
     QueryPerformanceCounter(&tock_tp);
-    acc_tp[ix].QuadPart += tock_tp.QuadPart - tick_tp[ix].QuadPart;
+    acc_tp[ix].QuadPart += tock_tp.QuadPart - rt_tick_tp[ix].QuadPart;
   } else {
     LARGE_INTEGER tock_tp;
     tock_tp.QuadPart = RDTSC();
-    acc_tp[ix].QuadPart += tock_tp.QuadPart - tick_tp[ix].QuadPart;
+    acc_tp[ix].QuadPart += tock_tp.QuadPart - rt_tick_tp[ix].QuadPart;
   }
 }
 
@@ -331,7 +348,7 @@ int rt_set_clock(enum omc_rt_clock_t newClock) {
 }
 
 void rt_tick(int ix) {
-  tick_tp[ix] = mach_absolute_time();
+  rt_tick_tp[ix] = mach_absolute_time();
   rt_clock_ncall[ix]++;
 }
 
@@ -341,7 +358,7 @@ double rt_tock(int ix) {
   static mach_timebase_info_data_t info = {0,0};
   if(info.denom == 0)
   mach_timebase_info(&info);
-  uint64_t elapsednano = (tock_tp-tick_tp[ix]) * (info.numer / info.denom);
+  uint64_t elapsednano = (tock_tp-rt_tick_tp[ix]) * (info.numer / info.denom);
   double d = elapsednano * 1e-9;
   if (d < min_time) {
     min_time = d;
@@ -369,7 +386,7 @@ void rt_clear_total(int ix)
 
 void rt_accumulate(int ix) {
   uint64_t tock_tp = mach_absolute_time();
-  acc_tp[ix] += tock_tp - tick_tp[ix];
+  acc_tp[ix] += tock_tp - rt_tick_tp[ix];
 }
 
 double rtclock_value(uint64_t tp) {
@@ -469,9 +486,9 @@ static inline unsigned long long RDTSC(void)
 
 void rt_tick(int ix) {
   if(omc_clock == OMC_CPU_CYCLES) {
-    tick_tp[ix].cycles = RDTSC();
+    rt_tick_tp[ix].cycles = RDTSC();
   } else {
-    clock_gettime(omc_clock, &tick_tp[ix].time);
+    clock_gettime(omc_clock, &rt_tick_tp[ix].time);
   }
   rt_clock_ncall[ix]++;
 }
@@ -480,11 +497,11 @@ double rt_tock(int ix) {
   double d;
   if(omc_clock == OMC_CPU_CYCLES) {
     unsigned long long timer = RDTSC();
-    d = (double) (timer - tick_tp[ix].cycles);
+    d = (double) (timer - rt_tick_tp[ix].cycles);
   } else {
     struct timespec tock_tp = {0,0};
     clock_gettime(omc_clock, &tock_tp);
-    d = (tock_tp.tv_sec - tick_tp[ix].time.tv_sec) + (tock_tp.tv_nsec - tick_tp[ix].time.tv_nsec)*1e-9;
+    d = (tock_tp.tv_sec - rt_tick_tp[ix].time.tv_sec) + (tock_tp.tv_nsec - rt_tick_tp[ix].time.tv_nsec)*1e-9;
     if (d < min_time) {
       min_time = d;
     }
@@ -577,12 +594,12 @@ static inline int timeSpecCmp(struct timespec  t1, struct timespec t2)
 void rt_accumulate(int ix) {
   if(omc_clock == OMC_CPU_CYCLES) {
     long long cycles = RDTSC();
-    acc_tp[ix].cycles += cycles -tick_tp[ix].cycles;
+    acc_tp[ix].cycles += cycles -rt_tick_tp[ix].cycles;
   } else {
     struct timespec tock_tp = {0,0};
     clock_gettime(omc_clock, &tock_tp);
-    acc_tp[ix].time.tv_sec += tock_tp.tv_sec -tick_tp[ix].time.tv_sec;
-    acc_tp[ix].time.tv_nsec += tock_tp.tv_nsec-tick_tp[ix].time.tv_nsec;
+    acc_tp[ix].time.tv_sec += tock_tp.tv_sec -rt_tick_tp[ix].time.tv_sec;
+    acc_tp[ix].time.tv_nsec += tock_tp.tv_nsec-rt_tick_tp[ix].time.tv_nsec;
     if(acc_tp[ix].time.tv_nsec >= 1e9) {
       acc_tp[ix].time.tv_sec++;
       acc_tp[ix].time.tv_nsec -= 1e9;
@@ -674,30 +691,63 @@ int64_t rt_ext_tp_sync_nanosec(rtclock_t* tick_tp, uint64_t nsec)
 
 #endif
 
-static OMC_INLINE void alloc_and_copy(void **ptr, size_t n, size_t sz)
+/* The arrays are allocated with malloc: the garbage collector does not scan
+ * thread local storage. They live as long as the thread. */
+static OMC_INLINE void* alloc_and_copy(const void *old, size_t n, size_t sz)
 {
-  void *newmemory = omc_alloc_interface.malloc(n*sz);
+  void *newmemory = malloc(n*sz);
   assert(newmemory != 0);
-  memcpy(newmemory,*ptr,NUM_RT_CLOCKS*sz);
-  *ptr = newmemory;
+  memset(newmemory,0,n*sz);
+  memcpy(newmemory,old,NUM_RT_CLOCKS*sz);
+  return newmemory;
 }
 
-void rt_init(int numTimers) {
+static void rt_alloc(int numTimers) {
   if (numTimers < NUM_RT_CLOCKS) {
     return; /* We already have more than we need statically allocated */
   }
-  alloc_and_copy((void**)&acc_tp,numTimers,sizeof(rtclock_t));
-  alloc_and_copy((void**)&max_tp,numTimers,sizeof(rtclock_t));
-  alloc_and_copy((void**)&total_tp,numTimers,sizeof(rtclock_t));
-  alloc_and_copy((void**)&tick_tp,numTimers,sizeof(rtclock_t));
-  alloc_and_copy((void**)&rt_clock_ncall,numTimers,sizeof(uint32_t));
-  alloc_and_copy((void**)&rt_clock_ncall_total,numTimers,sizeof(uint32_t));
-  alloc_and_copy((void**)&rt_clock_ncall_min,numTimers,sizeof(uint32_t));
-  alloc_and_copy((void**)&rt_clock_ncall_max,numTimers,sizeof(uint32_t));
-  /* This memset-command is not working properly, especially on windows.
-   * It's writing into the rt_clock_ncall_total-array and thus the values are wrong.
-   * However, the profiling-functionality seems to work without it. */
-  //memset(rt_clock_ncall_min + NUM_RT_CLOCKS*sizeof(uint32_t), 0xFF, (numTimers-NUM_RT_CLOCKS) * sizeof(uint32_t));
+  alloc_acc_tp = (rtclock_t*) alloc_and_copy(acc_tp,numTimers,sizeof(rtclock_t));
+  alloc_max_tp = (rtclock_t*) alloc_and_copy(max_tp,numTimers,sizeof(rtclock_t));
+  alloc_total_tp = (rtclock_t*) alloc_and_copy(total_tp,numTimers,sizeof(rtclock_t));
+  alloc_tick_tp = (rtclock_t*) alloc_and_copy(rt_tick_tp,numTimers,sizeof(rtclock_t));
+  alloc_rt_clock_ncall = (uint32_t*) alloc_and_copy(rt_clock_ncall,numTimers,sizeof(uint32_t));
+  alloc_rt_clock_ncall_total = (uint32_t*) alloc_and_copy(rt_clock_ncall_total,numTimers,sizeof(uint32_t));
+  alloc_rt_clock_ncall_min = (uint32_t*) alloc_and_copy(rt_clock_ncall_min,numTimers,sizeof(uint32_t));
+  alloc_rt_clock_ncall_max = (uint32_t*) alloc_and_copy(rt_clock_ncall_max,numTimers,sizeof(uint32_t));
+}
+
+void rt_init(int numTimers) {
+  rt_num_timers = numTimers;
+  rt_alloc(numTimers);
+}
+
+/* Gives a new thread as many timers as the last call of rt_init. Has to be
+ * called by every thread that simulates a model instance before the first
+ * rt_tick, otherwise the profiling timers index out of bounds. */
+void rt_init_thread(void) {
+  if (NULL == alloc_acc_tp) {
+    rt_alloc(rt_num_timers);
+  }
+}
+
+/* Frees the timers of rt_init_thread; called by the thread before it exits */
+void rt_free_thread(void) {
+  free(alloc_acc_tp);
+  free(alloc_max_tp);
+  free(alloc_total_tp);
+  free(alloc_tick_tp);
+  free(alloc_rt_clock_ncall);
+  free(alloc_rt_clock_ncall_total);
+  free(alloc_rt_clock_ncall_min);
+  free(alloc_rt_clock_ncall_max);
+  alloc_acc_tp = NULL;
+  alloc_max_tp = NULL;
+  alloc_total_tp = NULL;
+  alloc_tick_tp = NULL;
+  alloc_rt_clock_ncall = NULL;
+  alloc_rt_clock_ncall_total = NULL;
+  alloc_rt_clock_ncall_min = NULL;
+  alloc_rt_clock_ncall_max = NULL;
 }
 
 void rt_measure_overhead(int ix)
@@ -111,6 +111,8 @@ typedef union rtclock_t {
 int rt_set_clock(enum omc_rt_clock_t clockType); /* non-zero on failure */
 enum omc_rt_clock_t rt_get_clock(); /* non-zero on failure */
 void rt_init(int numTimer);
+void rt_init_thread(void);
+void rt_free_thread(void);
 
 void rt_tick(int ix);
 /* tick() ... tock() -> returns the number of seconds since the tick */
@@ -40,6 +40,7 @@ const char *FLAG_NAME[FLAG_MAX+1] = {
   /* FLAG_CSV_OSTEP */                    "csvOstep",
   /* FLAG_CVODE_ITER */                   "cvodeNonlinearSolverIteration",
   /* FLAG_CVODE_LMM */                    "cvodeLinearMultistepMethod",
+  /* FLAG_CVODE_LS */                     "cvodeLS",
   /* FLAG_DATA_RECONCILE_Cx */            "cx",
   /* FLAG_DAE_MODE */                     "daeMode",
   /* FLAG_DELTA_X_LINEARIZE */            "deltaXLinearize",
@@ -72,6 +73,8 @@ const char *FLAG_NAME[FLAG_MAX+1] = {
   /* FLAG_IDA_MAXCONVFAILS */             "idaMaxConvFails",
   /* FLAG_IDA_NONLINCONVCOEF */           "idaNonLinConvCoef",
   /* FLAG_IDA_LS */                       "idaLS",
+  /* FLAG_IDA_PREC */                     "idaPrec",
+  /* FLAG_IDA_PREC_LAG */                 "idaPrecLag",
   /* FLAG_IDA_SCALING */                  "idaScaling",
   /* FLAG_IDAS */                         "idaSensitivity",
   /* FLAG_IGNORE_HIDERESULT */            "ignoreHideResult",
@@ -123,6 +126,8 @@ const char *FLAG_NAME[FLAG_MAX+1] = {
   /* FLAG_NOEQUIDISTANT_OUT_FREQ*/        "noEquidistantOutputFrequency",
   /* FLAG_NOEQUIDISTANT_OUT_TIME*/        "noEquidistantOutputTime",
   /* FLAG_NOEVENTEMIT */                  "noEventEmit",
+  /* FLAG_NO_MASKED_EVAL */               "noMaskedEval",
+  /* FLAG_NO_PATTERN_CACHE */             "noPatternCache",
   /* FLAG_NO_RESTART */                   "noRestart",
   /* FLAG_NO_ROOTFINDING */               "noRootFinding",
   /* FLAG_NO_SCALING */                   "noScaling",
@@ -130,6 +135,7 @@ const char *FLAG_NAME[FLAG_MAX+1] = {
   /* FLAG_OPTDEBUGEJAC */                 "optDebugJac",
   /* FLAG_OPTIMIZER_NP */                 "optimizerNP",
   /* FLAG_OPTIMIZER_TGRID */              "optimizerTimeGrid",
+  /* FLAG_OPTIMIZER_THREADS */            "optimizerThreads",
   /* FLAG_OUTPUT */                       "output",
   /* FLAG_OUTPUT_PATH */                  "outputPath",
   /* FLAG_OVERRIDE */                     "override",
@@ -138,6 +144,9 @@ const char *FLAG_NAME[FLAG_MAX+1] = {
   /* FLAG_R */                            "r",
   /* FLAG_DATA_RECONCILE  */              "reconcile",
   /* FLAG_DATA_RECONCILE_BOUNDARY */      "reconcileBoundaryConditions",
+  /* FLAG_DATA_RECONCILE_BATCH */         "reconcileBatch",
+  /* FLAG_DATA_RECONCILE_REUSE_TOL */     "reconcileReuseTol",
+  /* FLAG_DATA_RECONCILE_SPARSE */        "reconcileSparse",
   /* FLAG_DATA_RECONCILE_STATE */         "reconcileState",
   /* FLAG_SR */                           "gbm",
   /* FLAG_SR_CTRL */                      "gbctrl",
@@ -156,6 +165,10 @@ const char *FLAG_NAME[FLAG_MAX+1] = {
   /* FLAG_SOLVER_STEPS */                 "steps",
   /* FLAG_STEADY_STATE */                 "steadyState",
   /* FLAG_STEADY_STATE_TOL */             "steadyStateTol",
+  /* FLAG_SWEEP */                        "sweep",
+  /* FLAG_SWEEP_ENSEMBLE */               "sweepEnsemble",
+  /* FLAG_SWEEP_OUTPUT */                 "sweepOutput",
+  /* FLAG_SWEEP_THREADS */                "sweepThreads",
   /* FLAG_DATA_RECONCILE_Sx */            "sx",
   /* FLAG_UP_HESSIAN */                   "keepHessian",
   /* FLAG_W */                            "w",
@@ -174,6 +187,7 @@ const char *FLAG_DESC[FLAG_MAX+1] = {
   /* FLAG_CSV_OSTEP */                    "value specifies csv-files for debug values for optimizer step",
   /* FLAG_CVODE_ITER */                   "nonlinear solver iteration for CVODE solver",
   /* FLAG_CVODE_LMM */                    "linear multistep method for CVODE solver",
+  /* FLAG_CVODE_LS */                     "select the linear solver used by cvode",
   /* FLAG_DATA_RECONCILE_Cx */            "value specifies a csv-file with inputs as correlation coefficient matrix Cx for DataReconciliation",
   /* FLAG_DAE_MODE */                     "flag to let the integrator use daeResiduals",
   /* FLAG_DELTA_X_LINEARIZE */            "value specifies the delta x value for numerical differentiation used by linearization. The default value is 1e-5.",
@@ -206,6 +220,8 @@ const char *FLAG_DESC[FLAG_MAX+1] = {
   /* FLAG_IDA_MAXCONVFAILS */             "value specifies the maximum number of nonlinear solver convergence failures at one step. The default value is 10.",
   /* FLAG_IDA_NONLINCONVCOEF */           "value specifies the safety factor in the nonlinear convergence test. The default value is 0.33.",
   /* FLAG_IDA_LS */                       "select the linear solver used by ida",
+  /* FLAG_IDA_PREC */                     "select the preconditioner for the iterative linear solvers of ida",
+  /* FLAG_IDA_PREC_LAG */                 "value specifies how many preconditioner setups reuse one Jacobian evaluation",
   /* FLAG_IDA_SCALING */                  "enable scaling of the IDA solver",
   /* FLAG_IDAS */                         "flag to add sensitivity information to the result files",
   /* FLAG_IGNORE_HIDERESULT */            "ignore HideResult=true annotation",
@@ -257,6 +273,8 @@ const char *FLAG_DESC[FLAG_MAX+1] = {
   /* FLAG_NOEQUIDISTANT_OUT_FREQ*/        "value controls the output frequency in noEquidistantTimeGrid mode",
   /* FLAG_NOEQUIDISTANT_OUT_TIME*/        "value controls the output time point in noEquidistantOutputTime mode",
   /* FLAG_NOEVENTEMIT */                  "do not emit event points to the result file",
+  /* FLAG_NO_MASKED_EVAL */               "disables the re-evaluation of only the changed equations in Jacobians, event location and FMUs",
+  /* FLAG_NO_PATTERN_CACHE */             "disables the cache of sparsity patterns and colorings",
   /* FLAG_NO_RESTART */                   "disables the restart of the integration method after an event is performed, used by the methods: dassl, ida",
   /* FLAG_NO_ROOTFINDING */               "disables the internal root finding procedure of methods: dassl and ida.",
   /* FLAG_NO_SCALING */                   "disables scaling for the variables and the residuals in the algebraic nonlinear solver KINSOL.",
@@ -264,6 +282,7 @@ const char *FLAG_DESC[FLAG_MAX+1] = {
   /* FLAG_OPTDEBUGEJAC */                 "value specifies the number of iter from the dyn. optimization, which will be debug, creating *csv and *py file",
   /* FLAG_OPTIMIZER_NP */                 "value specifies the number of points in a subinterval",
   /* FLAG_OPTIMIZER_TGRID */              "value specifies external file with time points.",
+  /* FLAG_OPTIMIZER_THREADS */            "[int (default 1)] value specifies the number of threads evaluating the collocation points",
   /* FLAG_OUTPUT */                       "output the variables a, b and c at the end of the simulation to the standard output",
   /* FLAG_OUTPUT_PATH */                  "value specifies a path for writing the output files i.e., model_res.mat, model_prof.intdata, model_prof.realdata etc.",
   /* FLAG_OVERRIDE */                     "override the variables or the simulation settings in the XML setup file",
@@ -272,6 +291,9 @@ const char *FLAG_DESC[FLAG_MAX+1] = {
   /* FLAG_R */                            "value specifies a new result file than the default Model_res.mat",
   /* FLAG_DATA_RECONCILE */               "Run the Data Reconciliation numerical computation algorithm for constrained equations",
   /* FLAG_DATA_RECONCILE_BOUNDARY */      "Run the Data Reconciliation numerical computation algorithm for boundary condition equations",
+  /* FLAG_DATA_RECONCILE_BATCH */         "value specifies a csv-file with time-stamped measurements which are reconciled row by row (batch mode of -reconcile)",
+  /* FLAG_DATA_RECONCILE_REUSE_TOL */     "value specifies the relative change of the operating point up to which the factorization is reused in batch mode (default 1e-3)",
+  /* FLAG_DATA_RECONCILE_SPARSE */        "Run the Data Reconciliation with the sparse formulation of the constraint system",
   /* FLAG_DATA_RECONCILE_STATE */         "Run the State Estimation numerical computation algorithm for constrained equations",
   /* FLAG_SR */                           "Value specifies the chosen solver of solver gbode (single-rate, slow states integrator)",
   /* FLAG_SR_CTRL */                      "Step size control of solver gbode (single-rate, slow states integrator)",
@@ -290,6 +312,10 @@ const char *FLAG_DESC[FLAG_MAX+1] = {
   /* FLAG_SOLVER_STEPS */                 "dumps the number of integration steps into the result file",
   /* FLAG_STEADY_STATE */                 "aborts if steady state is reached",
   /* FLAG_STEADY_STATE_TOL */             "[double (default 1e-3)] This relative tolerance is used to detect steady state.",
+  /* FLAG_SWEEP */                        "value specifies a csv-file with parameter sets; the model is simulated once per row in a single process",
+  /* FLAG_SWEEP_ENSEMBLE */               "value specifies the number of runs of a parameter sweep integrated in lockstep as one ensemble",
+  /* FLAG_SWEEP_OUTPUT */                 "[separate (default), combined] value specifies how the results of a parameter sweep are stored",
+  /* FLAG_SWEEP_THREADS */                "value specifies the number of model instances simulating the runs of a parameter sweep concurrently",
   /* FLAG_DATA_RECONCILE_Sx */            "value specifies a csv-file with inputs as covariance matrix Sx for DataReconciliation",
   /* FLAG_UP_HESSIAN */                   "value specifies the number of steps, which keep hessian matrix constant",
   /* FLAG_W */                            "shows all warnings even if a related log-stream is inactive",
@@ -325,6 +351,8 @@ const char *FLAG_DETAILED_DESC[FLAG_MAX+1] = {
   "                Use together with flag -cvodeNonlinearSolverIteration=CV_ITER_NEWTON or don't set cvodeNonlinearSolverIteration.\n"
   "  * CV_ADAMS  - Adams-Moulton linear multistep method for nonstiff problems.\n"
   "                Use together with flag -cvodeNonlinearSolverIteration=CV_ITER_FIXED_POINT or don't set cvodeNonlinearSolverIteration.",
+  /* FLAG_CVODE_LS */
+  "  Value specifies the linear solver of the cvode integration method. Valid values:\n",
   /* FLAG_DATA_RECONCILE_Cx */
   "  Value specifies an csv-file with inputs as correlation coefficient matrix Cx for DataReconciliation",
   /* FLAG_DAE_MODE */
@@ -401,6 +429,10 @@ const char *FLAG_DETAILED_DESC[FLAG_MAX+1] = {
   "  Value specifies the safety factor in the nonlinear convergence test. The default value is 0.33.",
   /* FLAG_IDA_LS */
   "  Value specifies the linear solver of the ida integration method. Valid values:\n",
+  /* FLAG_IDA_PREC */
+  "  Value specifies the preconditioner used by the iterative linear solvers (spgmr, spbcg, sptfqmr) of the ida integration method. Valid values:\n",
+  /* FLAG_IDA_PREC_LAG */
+  "  Value specifies how many preconditioner setups of the ida iterative linear solvers may reuse the last evaluated Jacobian before it is evaluated again. The lagged Jacobian is only re-shifted and re-factorized. The default value is 0, i.e. every setup evaluates a new Jacobian.",
   /* FLAG_IDA_SCALING */
   "  Enable scaling of the IDA solver.",
   /* FLAG_IDAS */
@@ -535,6 +567,15 @@ const char *FLAG_DETAILED_DESC[FLAG_MAX+1] = {
   "  mode and outputs every time>=k*timeValue, where k is an integer",
   /* FLAG_NOEVENTEMIT */
   "  Do not emit event points to the result file.",
+  /* FLAG_NO_MASKED_EVAL */
+  "  Finite difference Jacobian columns of the linearization, the bisection steps\n"
+  "  of the event location and FMU updates after setting states or inputs only\n"
+  "  re-evaluate the equations that depend on changed variables. This flag\n"
+  "  disables it and evaluates all equations every time.",
+  /* FLAG_NO_PATTERN_CACHE */
+  "  Sparsity patterns and colorings of the Jacobians and non-linear systems are\n"
+  "  stored in <outputPath>/<prefix>_patterns.cache and read from there by later\n"
+  "  runs of the same build of the model. This flag disables the cache.",
   /* FLAG_NO_RESTART */
   "  Disables the restart of the integration method after an event is performed, used by the methods: dassl, ida",
   /* FLAG_NO_ROOTFINDING */
@@ -553,6 +594,11 @@ const char *FLAG_DETAILED_DESC[FLAG_MAX+1] = {
   "  Currently supports numbers 1 and 3.",
   /* FLAG_OPTIMIZER_TGRID */
   "  Value specifies external file with time points.",
+  /* FLAG_OPTIMIZER_THREADS */
+  "  Value specifies the number of threads used by the dynamic optimizer to evaluate\n"
+  "  the model residuals and Jacobians at the collocation points. The time grid is\n"
+  "  split into contiguous partitions, each evaluated on its own copy of the model data.\n"
+  "  Requires omc configured with \"--enable-parjac\" and a compiler supporting OpenMP.",
   /* FLAG_OUTPUT */
   "  Output the variables a, b and c at the end of the simulation to the standard\n"
   "  output: time = value, a = value, b = value, c = value",
@@ -577,6 +623,19 @@ const char *FLAG_DETAILED_DESC[FLAG_MAX+1] = {
   "  Run the Data Reconciliation numerical computation algorithm for constrained equations",
   /* FLAG_DATA_RECONCILE_BOUNDARY */
   "  Run the Data Reconciliation numerical computation algorithm for boundary condition equations",
+  /* FLAG_DATA_RECONCILE_BATCH */
+  "  Value specifies a csv-file with time-stamped measurements for the batch mode of the Data Reconciliation.\n"
+  "  The first row holds the names of the variables of interest, an optional column time holds the time stamps.\n"
+  "  Each row is reconciled with the sparse formulation (see -reconcileSparse), the half-width confidence intervals are read from -sx.\n"
+  "  The results are streamed to <modelName>_BatchReconciliation.csv.",
+  /* FLAG_DATA_RECONCILE_REUSE_TOL */
+  "  Value specifies the relative change of the variables of interest up to which the Jacobian F and the factorization of F*Sx*F^T are reused for the next measurement row or convergence iteration in batch mode (-reconcileBatch).\n"
+  "  The change of each variable is scaled with its absolute value plus its standard deviation. A value of 0 refactorizes for each row.\n"
+  "  Default: 1e-3.",
+  /* FLAG_DATA_RECONCILE_SPARSE */
+  "  Run the Data Reconciliation with the sparse formulation of the constraint system.\n"
+  "  The Jacobian F is evaluated with the coloring of its sparsity pattern. F, the covariance matrix Sx and F*Sx*F^T are stored in compressed column format and factorized with KLU.\n"
+  "  Only the diagonal of the reconciled covariance matrix is computed, <modelName>_Reconciled_Sx.csv is not written. Requires OpenModelica compiled with SuiteSparse.",
   /* FLAG_DATA_RECONCILE_STATE */
   "  Run the State Estimation numerical computation algorithm for constrained equations",
   /* FLAG_SR */
@@ -623,6 +682,30 @@ const char *FLAG_DETAILED_DESC[FLAG_MAX+1] = {
   "  Aborts the simulation if steady state is reached.",
   /* FLAG_STEADY_STATE_TOL */
   "  This relative tolerance is used to detect steady state: max(|d(x_i)/dt|/nominal(x_i)) < steadyStateTol",
+  /* FLAG_SWEEP */
+  "  Value specifies a csv-file with one parameter set per row. The header row names the\n"
+  "  parameters, start values or simulation settings (startTime, stopTime, stepSize, tolerance)\n"
+  "  to override. The model is initialized and simulated once per row within the same process,\n"
+  "  reusing the already read model description and allocated runtime data.\n"
+  "  See also -sweepOutput.",
+  /* FLAG_SWEEP_ENSEMBLE */
+  "  Value specifies the number of runs of a parameter sweep (-sweep) that are simulated\n"
+  "  together as one ensemble, default 1. The states of all runs of an ensemble are stored\n"
+  "  run by run next to each other and the stages of the integration method are computed\n"
+  "  for all runs in one pass. The model equations are still evaluated run by run, so the\n"
+  "  gain is limited to the integration method and is small for large models.\n"
+  "  Runs with an event or a rejected step leave the ensemble\n"
+  "  for that step. Only possible with the fixed step solvers euler, heun and rungekutta\n"
+  "  or gbode with an explicit method, and with -sweepOutput=separate.",
+  /* FLAG_SWEEP_OUTPUT */
+  "  Value specifies how the results of a parameter sweep (-sweep) are stored.\n\n"
+  "    * separate (default) - one result file per run: <prefix>_res_<run>.<format>\n"
+  "    * combined           - a single csv-file <prefix>_sweep.csv with an additional leading column run",
+  /* FLAG_SWEEP_THREADS */
+  "  Value specifies the number of threads for a parameter sweep (-sweep), default 1.\n"
+  "  Every thread simulates its own instance of the model and takes the next row of\n"
+  "  the sweep table when it is done. The results do not depend on the number of threads.\n"
+  "  Only possible with -sweepOutput=separate and for models without external objects.",
   /* FLAG_DATA_RECONCILE_Sx */
   "  Value specifies an csv-file with inputs as covariance matrix Sx for DataReconciliation",
   /* FLAG_UP_HESSIAN */
@@ -645,6 +728,7 @@ const flag_repeat_policy FLAG_REPEAT_POLICIES[FLAG_MAX] = {
   /* FLAG_CSV_OSTEP */                    FLAG_REPEAT_POLICY_FORBID,
   /* FLAG_CVODE_ITER */                   FLAG_REPEAT_POLICY_FORBID,
   /* FLAG_CVODE_LMM */                    FLAG_REPEAT_POLICY_FORBID,
+  /* FLAG_CVODE_LS */                     FLAG_REPEAT_POLICY_FORBID,
   /* FLAG_DATA_RECONCILE_Cx */            FLAG_REPEAT_POLICY_FORBID,
   /* FLAG_DAE_MODE */                     FLAG_REPEAT_POLICY_FORBID,
   /* FLAG_DELTA_X_LINEARIZE */            FLAG_REPEAT_POLICY_FORBID,
@@ -677,6 +761,8 @@ const flag_repeat_policy FLAG_REPEAT_POLICIES[FLAG_MAX] = {
   /* FLAG_IDA_MAXCONVFAILS */             FLAG_REPEAT_POLICY_FORBID,
   /* FLAG_IDA_NONLINCONVCOEF */           FLAG_REPEAT_POLICY_FORBID,
   /* FLAG_IDA_LS */                       FLAG_REPEAT_POLICY_FORBID,
+  /* FLAG_IDA_PREC */                     FLAG_REPEAT_POLICY_FORBID,
+  /* FLAG_IDA_PREC_LAG */                 FLAG_REPEAT_POLICY_FORBID,
   /* FLAG_IDA_SCALING */                  FLAG_REPEAT_POLICY_FORBID,
   /* FLAG_IDAS */                         FLAG_REPEAT_POLICY_FORBID,
   /* FLAG_IGNORE_HIDERESULT */            FLAG_REPEAT_POLICY_FORBID,
@@ -728,6 +814,8 @@ const flag_repeat_policy FLAG_REPEAT_POLICIES[FLAG_MAX] = {
   /* FLAG_NOEQUIDISTANT_OUT_FREQ*/        FLAG_REPEAT_POLICY_FORBID,
   /* FLAG_NOEQUIDISTANT_OUT_TIME*/        FLAG_REPEAT_POLICY_FORBID,
   /* FLAG_NOEVENTEMIT */                  FLAG_REPEAT_POLICY_FORBID,
+  /* FLAG_NO_MASKED_EVAL */               FLAG_REPEAT_POLICY_FORBID,
+  /* FLAG_NO_PATTERN_CACHE */             FLAG_REPEAT_POLICY_FORBID,
   /* FLAG_NO_RESTART */                   FLAG_REPEAT_POLICY_FORBID,
   /* FLAG_NO_ROOTFINDING */               FLAG_REPEAT_POLICY_FORBID,
   /* FLAG_NO_SCALING */                   FLAG_REPEAT_POLICY_FORBID,
@@ -735,6 +823,7 @@ const flag_repeat_policy FLAG_REPEAT_POLICIES[FLAG_MAX] = {
   /* FLAG_OPTDEBUGEJAC */                 FLAG_REPEAT_POLICY_FORBID,
   /* FLAG_OPTIMIZER_NP */                 FLAG_REPEAT_POLICY_FORBID,
   /* FLAG_OPTIMIZER_TGRID */              FLAG_REPEAT_POLICY_FORBID,
+  /* FLAG_OPTIMIZER_THREADS */            FLAG_REPEAT_POLICY_FORBID,
   /* FLAG_OUTPUT */                       FLAG_REPEAT_POLICY_FORBID,
   /* FLAG_OUTPUT_PATH */                  FLAG_REPEAT_POLICY_FORBID,
   /* FLAG_OVERRIDE */                     FLAG_REPEAT_POLICY_COMBINE,
@@ -743,6 +832,9 @@ const flag_repeat_policy FLAG_REPEAT_POLICIES[FLAG_MAX] = {
   /* FLAG_R */                            FLAG_REPEAT_POLICY_FORBID,
   /* FLAG_DATA_RECONCILE  */              FLAG_REPEAT_POLICY_FORBID,
   /* FLAG_DATA_RECONCILE_BOUNDARY */      FLAG_REPEAT_POLICY_FORBID,
+  /* FLAG_DATA_RECONCILE_BATCH */         FLAG_REPEAT_POLICY_FORBID,
+  /* FLAG_DATA_RECONCILE_REUSE_TOL */     FLAG_REPEAT_POLICY_FORBID,
+  /* FLAG_DATA_RECONCILE_SPARSE */        FLAG_REPEAT_POLICY_FORBID,
   /* FLAG_DATA_RECONCILE_STATE  */        FLAG_REPEAT_POLICY_FORBID,
   /* FLAG_SR */                           FLAG_REPEAT_POLICY_FORBID,
   /* FLAG_SR_CTRL */                      FLAG_REPEAT_POLICY_FORBID,
@@ -761,6 +853,10 @@ const flag_repeat_policy FLAG_REPEAT_POLICIES[FLAG_MAX] = {
   /* FLAG_SOLVER_STEPS */                 FLAG_REPEAT_POLICY_FORBID,
   /* FLAG_STEADY_STATE */                 FLAG_REPEAT_POLICY_FORBID,
   /* FLAG_STEADY_STATE_TOL */             FLAG_REPEAT_POLICY_FORBID,
+  /* FLAG_SWEEP */                        FLAG_REPEAT_POLICY_FORBID,
+  /* FLAG_SWEEP_ENSEMBLE */               FLAG_REPEAT_POLICY_FORBID,
+  /* FLAG_SWEEP_OUTPUT */                 FLAG_REPEAT_POLICY_FORBID,
+  /* FLAG_SWEEP_THREADS */                FLAG_REPEAT_POLICY_FORBID,
   /* FLAG_DATA_RECONCILE_Sx */            FLAG_REPEAT_POLICY_FORBID,
   /* FLAG_UP_HESSIAN */                   FLAG_REPEAT_POLICY_FORBID,
   /* FLAG_W */                            FLAG_REPEAT_POLICY_FORBID,
@@ -778,6 +874,7 @@ const int FLAG_TYPE[FLAG_MAX] = {
   /* FLAG_CSV_OSTEP */                    FLAG_TYPE_OPTION,
   /* FLAG_CVODE_ITER */                   FLAG_TYPE_OPTION,
   /* FLAG_CVODE_LMM */                    FLAG_TYPE_OPTION,
+  /* FLAG_CVODE_LS */                     FLAG_TYPE_OPTION,
   /* FLAG_DATA_RECONCILE_Cx */            FLAG_TYPE_OPTION,
   /* FLAG_DAE_SOLVING */                  FLAG_TYPE_FLAG,
   /* FLAG_DELTA_X_LINEARIZE */            FLAG_TYPE_OPTION,
@@ -810,6 +907,8 @@ const int FLAG_TYPE[FLAG_MAX] = {
   /* FLAG_IDA_MAXCONVFAILS */             FLAG_TYPE_OPTION,
   /* FLAG_IDA_NONLINCONVCOEF */           FLAG_TYPE_OPTION,
   /* FLAG_IDA_LS */                       FLAG_TYPE_OPTION,
+  /* FLAG_IDA_PREC */                     FLAG_TYPE_OPTION,
+  /* FLAG_IDA_PREC_LAG */                 FLAG_TYPE_OPTION,
   /* FLAG_IDA_SCALING */                  FLAG_TYPE_FLAG,
   /* FLAG_IDAS */                         FLAG_TYPE_FLAG,
   /* FLAG_IGNORE_HIDERESULT */            FLAG_TYPE_FLAG,
@@ -860,6 +959,8 @@ const int FLAG_TYPE[FLAG_MAX] = {
   /* FLAG_NOEQUIDISTANT_GRID*/            FLAG_TYPE_FLAG,
   /* FLAG_NOEQUIDISTANT_OUT_FREQ*/        FLAG_TYPE_OPTION,
   /* FLAG_NOEQUIDISTANT_OUT_TIME*/        FLAG_TYPE_OPTION,
+  /* FLAG_NO_MASKED_EVAL */               FLAG_TYPE_FLAG,
+  /* FLAG_NO_PATTERN_CACHE */             FLAG_TYPE_FLAG,
   /* FLAG_NO_RESTART */                   FLAG_TYPE_FLAG,
   /* FLAG_NO_ROOTFINDING */               FLAG_TYPE_FLAG,
   /* FLAG_NO_SCALING */                   FLAG_TYPE_FLAG,
@@ -868,6 +969,7 @@ const int FLAG_TYPE[FLAG_MAX] = {
   /* FLAG_OPTDEBUGEJAC */                 FLAG_TYPE_OPTION,
   /* FLAG_OPTIZER_NP */                   FLAG_TYPE_OPTION,
   /* FLAG_OPTIZER_TGRID */                FLAG_TYPE_OPTION,
+  /* FLAG_OPTIMIZER_THREADS */            FLAG_TYPE_OPTION,
   /* FLAG_OUTPUT */                       FLAG_TYPE_OPTION,
   /* FLAG_OUTPUT_PATH */                  FLAG_TYPE_OPTION,
   /* FLAG_OVERRIDE */                     FLAG_TYPE_OPTION,
@@ -876,6 +978,9 @@ const int FLAG_TYPE[FLAG_MAX] = {
   /* FLAG_R */                            FLAG_TYPE_OPTION,
   /* FLAG_DATA_RECONCILE */               FLAG_TYPE_FLAG,
   /* FLAG_DATA_RECONCILE_BOUNDARY */      FLAG_TYPE_FLAG,
+  /* FLAG_DATA_RECONCILE_BATCH */         FLAG_TYPE_OPTION,
+  /* FLAG_DATA_RECONCILE_REUSE_TOL */     FLAG_TYPE_OPTION,
+  /* FLAG_DATA_RECONCILE_SPARSE */        FLAG_TYPE_FLAG,
   /* FLAG_DATA_RECONCILE_STATE */         FLAG_TYPE_FLAG,
   /* FLAG_SR */                           FLAG_TYPE_OPTION,
   /* FLAG_SR_CTRL */                      FLAG_TYPE_OPTION,
@@ -894,6 +999,10 @@ const int FLAG_TYPE[FLAG_MAX] = {
   /* FLAG_SOLVER_STEPS */                 FLAG_TYPE_FLAG,
   /* FLAG_STEADY_STATE */                 FLAG_TYPE_FLAG,
   /* FLAG_STEADY_STATE_TOL */             FLAG_TYPE_OPTION,
+  /* FLAG_SWEEP */                        FLAG_TYPE_OPTION,
+  /* FLAG_SWEEP_ENSEMBLE */               FLAG_TYPE_OPTION,
+  /* FLAG_SWEEP_OUTPUT */                 FLAG_TYPE_OPTION,
+  /* FLAG_SWEEP_THREADS */                FLAG_TYPE_OPTION,
   /* FLAG_DATA_RECONCILE_Sx */            FLAG_TYPE_OPTION,
   /* FLAG_UP_HESSIAN */                   FLAG_TYPE_OPTION,
   /* FLAG_W */                            FLAG_TYPE_FLAG,
@@ -1247,6 +1356,36 @@ const char *IDA_LS_METHOD_DESC[IDA_LS_MAX] = {
   "ida TFQMR. Iterative method"
 };
 
+const char *IDA_PREC_METHOD[IDA_PREC_MAX] = {
+  "unknown",
+
+  "none",
+  "blockJacobi",
+  "ilu0"
+};
+
+const char *IDA_PREC_METHOD_DESC[IDA_PREC_MAX] = {
+  "unknown",
+
+  "no preconditioning (default)",
+  "block-Jacobi over the strongly connected blocks of the Jacobian sparsity pattern",
+  "incomplete LU factorization without fill-in on the Jacobian sparsity pattern"
+};
+
+const char *CVODE_LS_METHOD[CVODE_LS_MAX] = {
+  "unknown",
+
+  "dense",
+  "klu"
+};
+
+const char *CVODE_LS_METHOD_DESC[CVODE_LS_MAX] = {
+  "unknown",
+
+  "cvode internal dense method. (default)",
+  "cvode use sparse direct solver KLU with colored Jacobian."
+};
+
 const char *NLS_LS_METHOD[NLS_LS_MAX] = {
   "unknown",
 
@@ -57,6 +57,7 @@ enum _FLAG
   FLAG_CSV_OSTEP,
   FLAG_CVODE_ITER,
   FLAG_CVODE_LMM,
+  FLAG_CVODE_LS,
   FLAG_DATA_RECONCILE_Cx,
   FLAG_DAE_MODE,
   FLAG_DELTA_X_LINEARIZE,
@@ -89,6 +90,8 @@ enum _FLAG
   FLAG_IDA_MAXCONVFAILS,
   FLAG_IDA_NONLINCONVCOEF,
   FLAG_IDA_LS,
+  FLAG_IDA_PREC,
+  FLAG_IDA_PREC_LAG,
   FLAG_IDA_SCALING,
   FLAG_IDAS,
   FLAG_IGNORE_HIDERESULT,
@@ -140,6 +143,8 @@ enum _FLAG
   FLAG_NOEQUIDISTANT_OUT_FREQ,
   FLAG_NOEQUIDISTANT_OUT_TIME,
   FLAG_NOEVENTEMIT,
+  FLAG_NO_MASKED_EVAL,
+  FLAG_NO_PATTERN_CACHE,
   FLAG_NO_RESTART,
   FLAG_NO_ROOTFINDING,
   FLAG_NO_SCALING,
@@ -147,6 +152,7 @@ enum _FLAG
   FLAG_OPTDEBUGEJAC,
   FLAG_OPTIMIZER_NP,
   FLAG_OPTIMIZER_TGRID,
+  FLAG_OPTIMIZER_THREADS,
   FLAG_OUTPUT,
   FLAG_OUTPUT_PATH,
   FLAG_OVERRIDE,
@@ -155,6 +161,9 @@ enum _FLAG
   FLAG_R,
   FLAG_DATA_RECONCILE,
   FLAG_DATA_RECONCILE_BOUNDARY,
+  FLAG_DATA_RECONCILE_BATCH,
+  FLAG_DATA_RECONCILE_REUSE_TOL,
+  FLAG_DATA_RECONCILE_SPARSE,
   FLAG_DATA_RECONCILE_STATE,
   FLAG_SR,
   FLAG_SR_CTRL,
@@ -173,6 +182,10 @@ enum _FLAG
   FLAG_SOLVER_STEPS,
   FLAG_STEADY_STATE,
   FLAG_STEADY_STATE_TOL,
+  FLAG_SWEEP,
+  FLAG_SWEEP_ENSEMBLE,
+  FLAG_SWEEP_OUTPUT,
+  FLAG_SWEEP_THREADS,
   FLAG_DATA_RECONCILE_Sx,
   FLAG_UP_HESSIAN,
   FLAG_W,
@@ -456,6 +469,38 @@ enum IDA_LS
 extern const char *IDA_LS_METHOD[IDA_LS_MAX];
 extern const char *IDA_LS_METHOD_DESC[IDA_LS_MAX];
 
+enum IDA_PREC
+{
+  IDA_PREC_UNKNOWN = 0,     /* Unknown preconditioner */
+
+  IDA_PREC_NONE,            /* No preconditioning (default) */
+  IDA_PREC_BLOCK_JACOBI,    /* Block-Jacobi over the strongly connected blocks of the Jacobian sparsity pattern */
+  IDA_PREC_ILU0,            /* Incomplete LU factorization without fill-in on the Jacobian sparsity pattern */
+
+  IDA_PREC_MAX              /* Maximum number of preconditioners available. Not a preconditioner itself! */
+};
+
+extern const char *IDA_PREC_METHOD[IDA_PREC_MAX];
+extern const char *IDA_PREC_METHOD_DESC[IDA_PREC_MAX];
+
+/**
+ * @brief Linear system solver method
+ *
+ * Specify method to solve linear systems inside CVODE.
+ */
+enum CVODE_LS
+{
+  CVODE_LS_UNKNOWN = 0, /* Unknown method */
+
+  CVODE_LS_DENSE,     /* Default dense linear solver method */
+  CVODE_LS_KLU,       /* KLU as linear solver method */
+
+  CVODE_LS_MAX        /* Maximum number of methods available. Not a method itself! */
+};
+
+extern const char *CVODE_LS_METHOD[CVODE_LS_MAX];
+extern const char *CVODE_LS_METHOD_DESC[CVODE_LS_MAX];
+
 /**
  * @brief Type of non-linear solver method
  *
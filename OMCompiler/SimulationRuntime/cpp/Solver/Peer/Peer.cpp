@@ -3,50 +3,50 @@
 
 #include <Core/Math/Functions.h>
 #include <Core/Math/ILapack.h>
+#include <Core/Math/Constants.h>
 #include <Solver/Peer/Peer.h>
+#include <Solver/Peer/PeerStageExecutor.h>
 
-#if defined(USE_MPI) || defined(USE_OPENMP)
-
-#ifdef MPIPEER
-#include "mpi.h"
-#else
-#include "omp.h"
-#endif
+#if defined(USE_THREAD)
 
 Peer::Peer(IMixedSystem* system, ISolverSettings* settings)
     : SolverDefaultImplementation(system, settings),
       _peersettings(dynamic_cast<ISolverSettings*>(_settings)),
-      _h(1e-4),
-      _continuous_system(),
-      _time_system(),
-      _hOut(0.0),
-      _reuseJacobi(5000)
-/*      _cvodeMem(NULL),
-      _z(NULL),
-      _zInit(NULL),
-      _zWrite(NULL),
       _dimSys(0),
-      _cv_rt(0),
-      _outStps(0),
-      _locStps(0),
-      _idid(0),
+      _rstages(5),
+      _reuseJacobi(20),
+      _numThreads(1),
+      _jacobianAge(-1),
+      _numSteps(0),
+      _numRejected(0),
+      _numJacobians(0),
+      _numFactorizations(0),
+      _P(NULL),
+      _info(NULL),
+      _G(NULL),
+      _E(NULL),
+      _Theta(NULL),
+      _c(NULL),
+      _F(NULL),
+      _y(NULL),
+      _Y1(NULL),
+      _Y2(NULL),
+      _Y3(NULL),
+      _Ynew(NULL),
+      _T(NULL),
+      _J(NULL),
+      _fJac(NULL),
+      _work(NULL),
+      _err(NULL),
+      _h(1e-4),
+      _hOld(1e-4),
+      _hFactor(0.0),
       _hOut(0.0),
       _tOut(0.0),
-      _tZero(0.0),
-      _zeroSign(NULL),
-      _absTol(NULL),
-      _cvode_initialized(false),
-      _tLastEvent(0.0),
-      _event_n(0),
-      _properties(NULL),
-      _continuous_system(NULL),
-      _event_system(NULL),
-      _mixed_system(NULL),
-      _time_system(NULL),
-    _delta(NULL),
-    _ysave(NULL) */
+      _continuous_system(),
+      _time_system(),
+      _executor(NULL)
 {
-  //_data = ((void*) this);
 }
 
 Peer::~Peer()
@@ -67,21 +67,33 @@ Peer::~Peer()
     delete [] _Y2;
   if (_Y3)
     delete [] _Y3;
+  if (_Ynew)
+    delete [] _Ynew;
   if (_T)
     delete [] _T;
+  if (_J)
+    delete [] _J;
+  if (_fJac)
+    delete [] _fJac;
+  if (_work)
+    delete [] _work;
+  if (_err)
+    delete [] _err;
   if (_P)
     delete [] _P;
+  if (_info)
+    delete [] _info;
   if (_y)
     delete [] _y;
+  if (_executor)
+    delete _executor;
 
-#ifndef MPIPEER
-  for(int i = 1; i < 5; i++)
+  for(int i = 1; i < _numThreads; i++)
   {
     delete _continuous_system[i];
     _continuous_system[i] = NULL;
     _time_system[i] = NULL;
-    }
-#endif
+  }
 }
 
 void Peer::initialize()
@@ -89,34 +101,20 @@ void Peer::initialize()
     IContinuous *continuous_system = dynamic_cast<IContinuous*>(_system);
     ITime *time_system =  dynamic_cast<ITime*>(_system);
     IGlobalSettings* global_settings = dynamic_cast<ISolverSettings*>(_peersettings)->getGlobalSettings();
-    _numThreads=_peersettings->getGlobalSettings()->getSolverThreads();
+    // one worker per stage at most, every worker needs its own copy of the system
+    _numThreads = std::min(std::max(global_settings->getSolverThreads(), 1), 5);
     _hOut = global_settings->gethOutput();
-#ifdef MPIPEER
-    MPI_Comm_size(MPI_COMM_WORLD, &_size);
-    if(_size>=5) {
-        _size=5;
-    } else {
-        throw ModelicaSimulationError(SOLVER,"Peer::MPI initialization error");
-    }
-    MPI_Comm_rank(MPI_COMM_WORLD, &_rank);
 
-    for(int i = 0; i < 5; i++)
-    {
-        _continuous_system[i] = continuous_system;
-        _time_system[i] = time_system;
-    }
-#else
     _time_system[0] = time_system;
     _continuous_system[0] = continuous_system;
 
-    for(int i = 1; i < 5; i++)
+    for(int i = 1; i < _numThreads; i++)
     {
         IMixedSystem* clonedSystem = _system->clone();
         _continuous_system[i] = dynamic_cast<IContinuous*>(clonedSystem);
         _time_system[i] = dynamic_cast<ITime*>(clonedSystem);
         dynamic_cast<ISystemInitialization*>(clonedSystem)->initialize();
     }
-#endif //MPIPEER
     SolverDefaultImplementation::initialize();
     _dimSys = _continuous_system[0]->getDimContinuousStates();
     _rstages = 5;
@@ -128,6 +126,7 @@ void Peer::initialize()
     _G[3]=0.5656454515405926;
     _G[4]=0.6831;
 
+    // Differentiation matrix of the interpolation polynomial at the nodes _c
     _E=new double[25];
     _E[0]=-4.73606797749979e+00;
     _E[1]=6.85410196624968e+00;
@@ -155,33 +154,6 @@ void Peer::initialize()
     _E[23]=-6.85410196624968e+00;
     _E[24]=4.73606797749979e+00;
 
-    _Theta=new double[25];
-    _Theta[0]=0.;
-    _Theta[1]=0.;
-    _Theta[2]=1.;
-    _Theta[3]=0.;
-    _Theta[4]=0.;
-    _Theta[5]=0.045084971874737;
-    _Theta[6]=-0.163118960624632;
-    _Theta[7]=0.527864045000421;
-    _Theta[8]=0.690983005625053;
-    _Theta[9]=-0.100813061875578;
-    _Theta[10]=0.;
-    _Theta[11]=0.;
-    _Theta[12]=0.;
-    _Theta[13]=0.;
-    _Theta[14]=1.;
-    _Theta[15]=1.809016994374949;
-    _Theta[16]=-5.545084971874742;
-    _Theta[17]=9.472135954999576;
-    _Theta[18]=-12.399186938124409;
-    _Theta[19]=7.663118960624626;
-    _Theta[20]=5.854101966249686;
-    _Theta[21]=-17.562305898749063;
-    _Theta[22]=28.416407864998732;
-    _Theta[23]=-33.270509831248397;
-    _Theta[24]=17.562305898749038;
-
     _c=new double[5];
     _c[0]=-1.;
     _c[1]=-6.18033988749895e-01;
@@ -189,30 +161,26 @@ void Peer::initialize()
     _c[3]=6.18033988749895e-01;
     _c[4]=1.;
 
+    // Extrapolation matrix, depends on the step size ratio and is set in every step
+    _Theta=new double[25];
+    setTheta(1.);
+
     _h = std::max(std::min(_h, _peersettings->getUpperLimit()), _peersettings->getLowerLimit());
     _y = new double[_dimSys];
-
-#ifdef MPIPEER
-    _F=new double[_dimSys];
-    _T=new double[_dimSys*_dimSys];
-    _P=new long int[_dimSys];
-    if(_rank==0) {
-        _Y1=new double[_dimSys*_rstages];
-        _Y2=new double[_dimSys*_rstages];
-        _Y3=new double[_dimSys*_rstages];
-    } else {
-        _Y1=new double[_dimSys];
-        _Y2=new double[_dimSys];
-        _Y3=new double[_dimSys];
-    }
-#else
-    _F=new double[_dimSys*5];
-    _T=new double[_dimSys*_dimSys*5];
-    _P=new long int[_dimSys*5];
-    _Y1=new double[_dimSys*_rstages];
-    _Y2=new double[_dimSys*_rstages];
-    _Y3=new double[_dimSys*_rstages];
-#endif
+    _err = new double[_dimSys];
+    _F = new double[_dimSys*_rstages];
+    _T = new double[_dimSys*_dimSys*_rstages];
+    _P = new long int[_dimSys*_rstages];
+    _info = new long int[_rstages];
+    _Y1 = new double[_dimSys*_rstages];
+    _Y2 = new double[_dimSys*_rstages];
+    _Y3 = new double[_dimSys*_rstages];
+    _Ynew = new double[_dimSys*_rstages];
+    _J = new double[_dimSys*_dimSys];
+    _fJac = new double[_dimSys];
+    _work = new double[2*_dimSys*_numThreads];
+
+    _executor = new PeerStageExecutor(_numThreads);
 
     _continuous_system[0]->evaluateAll(IContinuous::ALL);
     _continuous_system[0]->getContinuousStates(_y);
@@ -290,295 +258,279 @@ void Peer::ros2(double * y, double& tstart, double tend, IContinuous *continuous
         for(int i=0; i<_dimSys;++ i) k1[i]+=gamma*hu*D[i];
         dgetrs_(&trans, &_dimSys, &dim, T, &_dimSys, P, k1, &_dimSys, &info);
         for(int i=0; i<_dimSys;++ i) y[i]+=hu*k1[i];
-        evalF(t,y,k2,continuousSystem, timeSystem);
+        evalF(t+hu,y,k2,continuousSystem, timeSystem);
         for(int i=0; i<_dimSys;++ i)  k2[i]+= hu*gamma*D[i]-2.*k1[i];
         dgetrs_(&trans, &_dimSys, &dim, T, &_dimSys, P, k2, &_dimSys, &info);
         for(int i=0; i<_dimSys;++ i) y[i]+=0.5*hu*(k1[i]+k2[i]);
+        t+=hu;
     }
+    delete [] T;
+    delete [] D;
+    delete [] k1;
+    delete [] k2;
+    delete [] P;
 }
 
-void Peer::solve(const SOLVERCALL action)
+void Peer::lagrangeBasis(double x, double* l)
 {
-    double twrite=_hOut;
-    if ((action & RECORDCALL) && (action & FIRST_CALL)) {
-        initialize();
-        return;
-    }
-    bool writeOutput = !(_settings->getGlobalSettings()->getOutputPointType() == OPT_NONE);
-    double t=_tCurrent;
-  // Initialization phase
-    if(writeOutput) {
-        _continuous_system[0]->evaluateAll(IContinuous::ALL);
-        SolverDefaultImplementation::writeToFile(0, t, _h);
+    for(int j=0; j<_rstages; ++j) {
+        l[j]=1.;
+        for(int m=0; m<_rstages; ++m) {
+            if(m!=j) l[j]*=(x-_c[m])/(_c[j]-_c[m]);
+        }
     }
+}
 
-#ifdef MPIPEER
-    std::copy(_y,_y+_dimSys,_Y1);
-    if (abs(_c[_rank]+1.)>1e-12)
-    {
-
-        ros2(_Y1,_tCurrent,_tCurrent+_h*(_c[_rank]+1.));
-        t=_tCurrent;
-    }
-    MPI_Barrier(MPI_COMM_WORLD);
-    if(_rank==0) {
-        MPI_Gather(MPI_IN_PLACE,_dimSys,MPI_DOUBLE,_Y1,_dimSys,MPI_DOUBLE,0,MPI_COMM_WORLD);
-    } else {
-        MPI_Gather(_Y1,_dimSys,MPI_DOUBLE,_Y1,_dimSys,MPI_DOUBLE,0,MPI_COMM_WORLD);
-    }
-    t+=_h;
-#else
-#pragma omp parallel for num_threads(_numThreads)
-    for(int _rank=0; _rank<5; ++_rank) {
-        std::copy(_y,_y+_dimSys,&_Y1[_rank*_dimSys]);
-        if (abs(_c[_rank]+1.)>1e-12)
-        {
-            ros2(&_Y1[_rank*_dimSys],_tCurrent,_tCurrent+_h*(_c[_rank]+1.), _continuous_system[_rank], _time_system[_rank]);
-            t=_tCurrent;
-        }
+void Peer::setTheta(double sigma)
+{
+    // The new stages lie at 1+c_i*sigma in the time scale of the old stages
+    for(int i=0; i<_rstages; ++i) {
+        lagrangeBasis(1.+_c[i]*sigma, &_Theta[i*_rstages]);
     }
-    t+=_h;
-    _time_system[0]->setTime(t);
-    _continuous_system[0]->setContinuousStates(&_Y1[2*_dimSys]);
-    if(writeOutput) {
-        if(t>=twrite) {
-            _continuous_system[0]->evaluateAll(IContinuous::ALL);
-            SolverDefaultImplementation::writeToFile(0, t, _h);
-            twrite+=_hOut;
-        }
+}
+
+double Peer::initialStepSize(const double& t0, const double& tEnd)
+{
+    const double rtol = _peersettings->getRTol();
+    const double atol = _peersettings->getATol();
+    double d0 = 0., d1 = 0.;
+    evalF(t0, _y, _fJac, _continuous_system[0], _time_system[0]);
+    for(int i=0; i<_dimSys; ++i) {
+        const double sc = atol + rtol*std::abs(_y[i]);
+        d0 += (_y[i]/sc)*(_y[i]/sc);
+        d1 += (_fJac[i]/sc)*(_fJac[i]/sc);
     }
-#endif
+    d0 = std::sqrt(d0/std::max(_dimSys, 1L));
+    d1 = std::sqrt(d1/std::max(_dimSys, 1L));
+    // the startup with ros2 is only of order 2, so it needs a smaller step for tight tolerances
+    double h = (d0 < 1e-5 || d1 < 1e-5) ? 1e-6 : 0.01*d0/d1*std::min(1., std::sqrt(100.*rtol));
+    h = std::max(std::min(h, _peersettings->getUpperLimit()), _peersettings->getLowerLimit());
+    // the startup needs two steps
+    return std::min(h, 0.5*(tEnd-t0));
+}
 
+double Peer::startup(const double& t0)
+{
+    _h = initialStepSize(t0, _tEnd);
+    // Stage i at t0+(c_i+1)*h, the first stage is the initial value
+    std::copy(_y, _y+_dimSys, _Y1);
+    _executor->run(_rstages-1, [&](int task, int worker) {
+        const int stage = task+1;
+        double tstart = t0;
+        std::copy(_y, _y+_dimSys, &_Y1[stage*_dimSys]);
+        ros2(&_Y1[stage*_dimSys], tstart, t0+_h*(_c[stage]+1.), _continuous_system[worker], _time_system[worker]);
+    });
+    return t0+2.*_h;
+}
 
+void Peer::evalSharedJacobian(const double& t, const double* y)
+{
+    evalF(t, y, _fJac, _continuous_system[0], _time_system[0]);
+    _executor->run(_dimSys, [&](int column, int worker) {
+        evalJacobianColumn(column, worker, t, y);
+    });
+    _numJacobians++;
+}
+
+void Peer::evalJacobianColumn(int column, int worker, double t, const double* y)
+{
+    double* z = &_work[2*worker*_dimSys];
+    double* fh = z+_dimSys;
+    const double delta = std::sqrt(UROUND)*std::max(std::abs(y[column]), 1.);
+    std::copy(y, y+_dimSys, z);
+    z[column] += delta;
+    evalF(t, z, fh, _continuous_system[worker], _time_system[worker]);
+    for(int i=0; i<_dimSys; ++i) {
+        _J[i+column*_dimSys] = (fh[i]-_fJac[i])/delta;
+    }
+}
 
-//    std::cerr << "Finished init at rank  " << _rank<<std::endl;
-// Solution phase
-    t+=_h;
+void Peer::solveStage(int stage, int worker, double t, double h, bool factorize)
+{
     char trans='N';
     long int dim=1;
-    int count=0;
-    while(std::abs(t-_tEnd)>1e-8)
-    {
-#ifdef MPIPEER
-        if(_rank==0)
-        {
-            for(int i=0; i<_rstages; ++i)
-            {
-                for(int j=0; j<_dimSys; ++j) {
-                    _Y2[i*_dimSys+j]=0.;
-                    for(int k=0; k<_rstages;++k) {
-                        _Y2[i*_dimSys+j]+=_Y1[k*_dimSys+j]*_Theta[i*_rstages+k];
-                    }
-                }
- //               Y2.vector(i)=Y1*mtl::vector::trans(Theta[i][iall]);
-            }
-            std::cout<<"_Y2 vals on rank "<<_rank<<": ";
-              for(int i=0; i<_rstages*_dimSys;++i) {
-                  if(!(i%20)) std::cout<<std::endl;
-                std::cout<<_Y2[i]<<" ";
-            }
-            std::cout<<std::endl;
-            for(int i=0; i<_rstages; i++)
-            {
-                 for(int j=0; j<_dimSys; ++j) {
-                    _Y3[i*_dimSys+j]=0.;
-                    for(int k=0; k<_rstages;++k) {
-                        _Y3[i*_dimSys+j]+=_Y2[k*_dimSys+j]*_E[i*_rstages+k];
-                    }
-                }
-//                Y3.vector(i)=Y2*mtl::vector::trans(E[i][iall]);
-            }
+    double* T = &_T[stage*_dimSys*_dimSys];
+    long int* P = &_P[stage*_dimSys];
+    double* F = &_F[stage*_dimSys];
+
+    if(factorize) {
+        // iteration matrix I - h*g_i*J of this stage
+        for(long int k=0; k<_dimSys*_dimSys; ++k) {
+            T[k] = -h*_G[stage]*_J[k];
         }
-        MPI_Barrier(MPI_COMM_WORLD);
-//        std::cerr << "Finished rank 0 calculation step at rank  " << _rank<<std::endl;
-        if(_rank==0) {
-            MPI_Scatter( _Y2,_dimSys,MPI_DOUBLE,MPI_IN_PLACE,_dimSys,MPI_DOUBLE,0,MPI_COMM_WORLD);
-            MPI_Scatter( _Y3,_dimSys,MPI_DOUBLE,MPI_IN_PLACE,_dimSys,MPI_DOUBLE,0,MPI_COMM_WORLD);
-        } else {
-            MPI_Scatter(_Y2,_dimSys,MPI_DOUBLE,_Y2,_dimSys,MPI_DOUBLE,0,MPI_COMM_WORLD);
-            MPI_Scatter(_Y3,_dimSys,MPI_DOUBLE,_Y3,_dimSys,MPI_DOUBLE,0,MPI_COMM_WORLD);
+        for(long int k=0; k<_dimSys; ++k) {
+            T[k*_dimSys+k] += 1.;
         }
+        dgetrf_(&_dimSys, &_dimSys, T, &_dimSys, P, &_info[stage]);
+        if(_info[stage] != 0)
+            return;
+    }
 
-        evalF(t+_c[_rank]*_h,_Y2,_F);
-        evalJ(t+_c[_rank]*_h,_Y2,_T);
-        if(_rank==0) {
-            std::cout<<"Jac: ";
-            for(int i(0); i<_dimSys*_dimSys;++i) {
-                if(!(i%20)) std::cout<<std::endl;
-                std::cout<<_T[i]<<" ";
+    evalF(t+_c[stage]*h, &_Y2[stage*_dimSys], F, _continuous_system[worker], _time_system[worker]);
+    for(long int k=0; k<_dimSys; ++k) {
+        F[k] = _G[stage]*(h*F[k]-_Y3[stage*_dimSys+k]);
+    }
+    dgetrs_(&trans, &_dimSys, &dim, T, &_dimSys, P, F, &_dimSys, &_info[stage]);
+    for(long int k=0; k<_dimSys; ++k) {
+        _Ynew[stage*_dimSys+k] = _Y2[stage*_dimSys+k]+F[k];
+    }
+}
+
+bool Peer::step(const double& t, const double& h, double& err)
+{
+    char trans='N';
+    long int dim=1;
+    long int info;
+    const double rtol = _peersettings->getRTol();
+    const double atol = _peersettings->getATol();
+
+    // Predictor: interpolation polynomial of the old stages at the new nodes
+    setTheta(h/_hOld);
+    for(int i=0; i<_rstages; ++i) {
+        for(long int j=0; j<_dimSys; ++j) {
+            _Y2[i*_dimSys+j]=0.;
+            for(int k=0; k<_rstages; ++k) {
+                _Y2[i*_dimSys+j]+=_Y1[k*_dimSys+j]*_Theta[i*_rstages+k];
             }
-            std::cout<<std::endl;
         }
-        for(int i=0; i<_dimSys; ++i) {
-            for(int j=0; j<_dimSys; ++j) {
-                _T[i*_dimSys+j]*=-_h*_G[_rank];
+    }
+    for(int i=0; i<_rstages; ++i) {
+        for(long int j=0; j<_dimSys; ++j) {
+            _Y3[i*_dimSys+j]=0.;
+            for(int k=0; k<_rstages; ++k) {
+                _Y3[i*_dimSys+j]+=_Y2[k*_dimSys+j]*_E[i*_rstages+k];
             }
-            _T[i*_dimSys+i]+=1.;
-        }
-
-
-//        std::cerr << "Finished iteration matrix calculation step at rank  " << _rank<<std::endl;
-        dgetrf_(&_dimSys, &_dimSys, _T, &_dimSys, _P, &info);
-        for(int i=0; i<_dimSys; ++i) {
-            _F[i]*=_h;
-            _F[i]-=_Y3[i];
-            _F[i]*=_G[_rank];
-        }
-        dgetrs_(&trans, &_dimSys, &dim, _T, &_dimSys, _P, _F, &_dimSys, &info);
-        for(int i=0; i<_dimSys; ++i) {
-            _Y1[i]=_F[i]+_Y2[i];
-        }
-        MPI_Barrier(MPI_COMM_WORLD);
-        if(_rank==0) {
-            MPI_Gather(MPI_IN_PLACE,_dimSys,MPI_DOUBLE,_Y1,_dimSys,MPI_DOUBLE,0,MPI_COMM_WORLD);
-        } else {
-            MPI_Gather(_Y1,_dimSys,MPI_DOUBLE,_Y1,_dimSys,MPI_DOUBLE,0,MPI_COMM_WORLD);
         }
+    }
 
-        if(t+_h>_tEnd) _h=_tEnd-t;
-        if(_rank==0) {
-            SolverDefaultImplementation::writeToFile(0, t, _h);
-        }
-        t+=_h;
-#else
-        for(int i=0; i<_rstages; ++i)
-        {
-            for(int j=0; j<_dimSys; ++j) {
-                _Y2[i*_dimSys+j]=0.;
-                    for(int k=0; k<_rstages;++k) {
-                        _Y2[i*_dimSys+j]+=_Y1[k*_dimSys+j]*_Theta[i*_rstages+k];
-                    }
-                }
- //               Y2.vector(i)=Y1*mtl::vector::trans(Theta[i][iall]);
-            }
-            for(int i=0; i<_rstages; i++)
-            {
-                 for(int j=0; j<_dimSys; ++j) {
-                    _Y3[i*_dimSys+j]=0.;
-                    for(int k=0; k<_rstages;++k) {
-                        _Y3[i*_dimSys+j]+=_Y2[k*_dimSys+j]*_E[i*_rstages+k];
-                    }
-                }
-//                Y3.vector(i)=Y2*mtl::vector::trans(E[i][iall]);
-            }
-
-#pragma omp parallel for num_threads(_numThreads)
-        for(int _rank=0; _rank<5; ++_rank) {
-            long int info;
-            evalF(t+_c[_rank]*_h,&_Y2[_rank*_dimSys],&_F[_rank*_dimSys],_continuous_system[_rank], _time_system[_rank]);
-            if(!(count%_reuseJacobi)) {
-               evalJ(t+_c[_rank]*_h,&_Y2[_rank*_dimSys],&_T[_rank*_dimSys*_dimSys], _continuous_system[_rank], _time_system[_rank]);
-                for(int i=0; i<_dimSys; ++i) {
-                    for(int j=0; j<_dimSys; ++j) {
-                        _T[_rank*_dimSys*_dimSys+i*_dimSys+j]*=-_h*_G[_rank];
-                    }
-                    _T[_rank*_dimSys*_dimSys+i*_dimSys+i]+=1.;
-                }
-
-                dgetrf_(&_dimSys, &_dimSys, &_T[_rank*_dimSys*_dimSys], &_dimSys, &_P[_rank*_dimSys], &info);
-            }
-
-
-    //        std::cerr << "Finished iteration matrix calculation step at rank  " << _rank<<std::endl;
-
-            for(int i=0; i<_dimSys; ++i) {
-                _F[_rank*_dimSys+i]*=_h;
-                _F[_rank*_dimSys+i]-=_Y3[_rank*_dimSys+i];
-                _F[_rank*_dimSys+i]*=_G[_rank];
-            }
-            dgetrs_(&trans, &_dimSys, &dim, &_T[_rank*_dimSys*_dimSys], &_dimSys, &_P[_rank*_dimSys], &_F[_rank*_dimSys], &_dimSys, &info);
-            for(int i=0; i<_dimSys; ++i) {
-                _Y1[_rank*_dimSys+i]=_F[_rank*_dimSys+i]+_Y2[_rank*_dimSys+i];
-            }
+    if(_jacobianAge < 0 || _jacobianAge >= _reuseJacobi) {
+        evalSharedJacobian(t, &_Y2[2*_dimSys]);
+        _jacobianAge = 0;
+        _hFactor = 0.;
+    }
+    const bool factorize = (h != _hFactor);
+
+    _executor->run(_rstages, [&](int stage, int worker) {
+        solveStage(stage, worker, t, h, factorize);
+    });
+    if(factorize) {
+        _numFactorizations += _rstages;
+        _hFactor = h;
+    }
+    for(int i=0; i<_rstages; ++i) {
+        if(_info[i] != 0) {
+            _hFactor = 0.;
+            return false;
         }
+    }
 
-        count++;
-        if(t+_h>_tEnd) _h=_tEnd-t;
-        _time_system[0]->setTime(t);
-        _continuous_system[0]->setContinuousStates(&_Y1[2*_dimSys]);
+    // Error estimate: difference of predictor and solution of the last stage,
+    // filtered with the iteration matrix to avoid overestimation for stiff components
+    for(long int k=0; k<_dimSys; ++k) {
+        _err[k] = _Ynew[(_rstages-1)*_dimSys+k]-_Y2[(_rstages-1)*_dimSys+k];
+    }
+    dgetrs_(&trans, &_dimSys, &dim, &_T[(_rstages-1)*_dimSys*_dimSys], &_dimSys, &_P[(_rstages-1)*_dimSys], _err, &_dimSys, &info);
+    err = 0.;
+    for(long int k=0; k<_dimSys; ++k) {
+        const double sc = atol+rtol*std::max(std::abs(_Y1[(_rstages-1)*_dimSys+k]), std::abs(_Ynew[(_rstages-1)*_dimSys+k]));
+        err += (_err[k]/sc)*(_err[k]/sc);
+    }
+    err = std::sqrt(err/std::max(_dimSys, 1L));
+    return true;
+}
 
-        if(writeOutput) {
-            if(t>=twrite) {
-                _continuous_system[0]->evaluateAll(IContinuous::ALL);
-                SolverDefaultImplementation::writeToFile(0, t, _h);
-                twrite+=_hOut;
-            }
-        }
-        t+=_h;
-#endif
+void Peer::solve(const SOLVERCALL action)
+{
+    if ((action & RECORDCALL) && (action & FIRST_CALL)) {
+        initialize();
+        return;
+    }
+    bool writeOutput = !(_settings->getGlobalSettings()->getOutputPointType() == OPT_NONE);
+    const double hMin = _peersettings->getLowerLimit();
+    const double hMax = _peersettings->getUpperLimit();
 
+    // Initialization phase, the states may have been changed by an event
+    _continuous_system[0]->getContinuousStates(_y);
+    _tOut = _tCurrent;
+    if(writeOutput) {
+        _continuous_system[0]->evaluateAll(IContinuous::ALL);
+        SolverDefaultImplementation::writeToFile(0, _tCurrent, _h);
     }
-#ifdef MPIPEER
-    MPI_Barrier(MPI_COMM_WORLD);
-    if(_rank==0)
+    _tOut += _hOut;
+
+    double t = startup(_tCurrent);
+    if(writeOutput)
+        writePeerOutput(_tCurrent+_h, _h, t);
+    _hOld = _h;
+    _hFactor = 0.;
+    _jacobianAge = -1;
+
+    // Solution phase, t is the time of the last stage
+    double h = _h;
+    while(t < _tEnd && std::abs(_tEnd-t) > 1e-8)
     {
-        for(int i=0; i<_dimSys; i++) _y[i]=_Y1[(_rstages-1)*_dimSys+i];
+        h = std::min(h, hMax);
+        if(t+h > _tEnd)
+            h = _tEnd-t;
+
+        double err = 0.;
+        if(!step(t, h, err) || !(err <= 1.)) {
+            // singular iteration matrix or error too large: smaller step with a new Jacobian
+            _numRejected++;
+            _jacobianAge = -1;
+            h *= (err > 1. && isfinite(err)) ? std::max(0.2, 0.9*std::pow(err, -0.2)) : 0.25;
+            if(h < hMin)
+                throw ModelicaSimulationError(SOLVER, "Peer: step size below the lower limit at time " + to_string(t));
+            continue;
+        }
+
+        std::swap(_Y1, _Ynew);
+        if(writeOutput)
+            writePeerOutput(t, h, t+h);
+        t += h;
+        _hOld = h;
+        _h = h;
+        _numSteps++;
+        _jacobianAge++;
+
+        // keep the step size for small changes so that the factorizations can be reused
+        const double fac = (err > 0.) ? std::min(2., std::max(0.2, 0.9*std::pow(err, -0.2))) : 2.;
+        if(fac < 1. || fac > 1.2)
+            h *= fac;
     }
-    MPI_Bcast(_y, _dimSys, MPI_DOUBLE, 0, MPI_COMM_WORLD);
-#else
-    for(int i=0; i<_dimSys; i++) _y[i]=_Y1[(_rstages-1)*_dimSys+i];
-#endif
+
+    std::copy(&_Y1[(_rstages-1)*_dimSys], &_Y1[_rstages*_dimSys], _y);
     _tCurrent=_tEnd;
     _time_system[0]->setTime(_tCurrent);
-    _continuous_system[0]->setContinuousStates(&_Y1[4*_dimSys]);
-    if(writeOutput) {
-        _continuous_system[0]->evaluateAll(IContinuous::ALL);
-        SolverDefaultImplementation::writeToFile(0, t, _h);
+    _continuous_system[0]->setContinuousStates(_y);
+    _continuous_system[0]->evaluateAll(IContinuous::ALL);
+    if(writeOutput && _tOut-_hOut < _tEnd-1e-8) {
+        SolverDefaultImplementation::writeToFile(0, _tCurrent, _h);
     }
     _solverStatus = ISolver::DONE;
 }
 
-
-
-void Peer::writePeerOutput(const double &time, const double &h, const int &stp)
+void Peer::writePeerOutput(const double& center, const double& h, const double& tTo)
 {
-  /*
-  if (stp > 0)
-  {
-    if (_cvodesettings->getDenseOutput())
+    double l[5];
+    if(_hOut <= 0.)
+        return;
+    while(_tOut <= tTo+1e-10*h && _tOut <= _tEnd+1e-8)
     {
-      _bWritten = false;
-      double *oldValues = NULL;
-
-      //We have to find all output-points within the last solver step
-      while (_tLastWrite + dynamic_cast<ISolverSettings*>(_cvodesettings)->getGlobalSettings()->gethOutput() <= time)
-      {
-        if (!_bWritten)
-        {
-          //Rescue the calculated derivatives
-          oldValues = new double[_continuous_system->getDimRHS()];
-          _continuous_system->getRHS(oldValues);
+        // dense output with the interpolation polynomial of the stages at center+c_i*h
+        lagrangeBasis((_tOut-center)/h, l);
+        for(long int k=0; k<_dimSys; ++k) {
+            _y[k]=0.;
+            for(int j=0; j<_rstages; ++j) {
+                _y[k]+=l[j]*_Y1[j*_dimSys+k];
+            }
         }
-        _bWritten = true;
-        _tLastWrite = _tLastWrite + dynamic_cast<ISolverSettings*>(_cvodesettings)->getGlobalSettings()->gethOutput();
-        //Get the state vars at the output-point (interpolated)
-        _idid = CVodeGetDky(_cvodeMem, _tLastWrite, 0, _CV_yWrite);
-        _time_system->setTime(_tLastWrite);
-        _continuous_system->setContinuousStates(NV_DATA_S(_CV_yWrite));
-        _continuous_system->evaluateAll(IContinuous::CONTINUOUS);
-        SolverDefaultImplementation::writeToFile(stp, _tLastWrite, h);
-      }      //end if time -_tLastWritten
-      if (_bWritten)
-      {
-        _time_system->setTime(time);
-        _continuous_system->setContinuousStates(_z);
-        _continuous_system->setStateDerivatives(oldValues);
-        delete[] oldValues;
-        //_continuous_system->evaluateAll(IContinuous::CONTINUOUS);
-      }
-      else if (time == _tEnd && _tLastWrite != time)
-      {
-        _idid = CVodeGetDky(_cvodeMem, time, 0, _CV_y);
-        _time_system->setTime(time);
-        _continuous_system->setContinuousStates(NV_DATA_S(_CV_y));
-        _continuous_system->evaluateAll(IContinuous::CONTINUOUS);
-        SolverDefaultImplementation::writeToFile(stp, _tEnd, h);
-      }
+        _time_system[0]->setTime(_tOut);
+        _continuous_system[0]->setContinuousStates(_y);
+        _continuous_system[0]->evaluateAll(IContinuous::ALL);
+        SolverDefaultImplementation::writeToFile(0, _tOut, h);
+        _tOut += _hOut;
     }
-    else
-      SolverDefaultImplementation::writeToFile(stp, time, h);
-  }
-  */
 }
 
 bool Peer::stateSelection()
@@ -596,8 +548,15 @@ void Peer::setTimeOut(unsigned int time_out)
   }
 
 
-void Peer::setcycletime(double cycletime){}
-void Peer::writeSimulationInfo(){}
+void Peer::writeSimulationInfo()
+{
+    LOGGER_WRITE("Peer: number of threads = " + to_string(_numThreads), LC_SOLVER, LL_INFO);
+    LOGGER_WRITE("Peer: accepted steps = " + to_string(_numSteps), LC_SOLVER, LL_INFO);
+    LOGGER_WRITE("Peer: rejected steps = " + to_string(_numRejected), LC_SOLVER, LL_INFO);
+    LOGGER_WRITE("Peer: Jacobian evaluations = " + to_string(_numJacobians), LC_SOLVER, LL_INFO);
+    LOGGER_WRITE("Peer: stage factorizations = " + to_string(_numFactorizations), LC_SOLVER, LL_INFO);
+}
+
 int Peer::reportErrorMessage(std::ostream& messageStream) {
     return 0;
 }
@@ -5,17 +5,28 @@
 
 #include <Core/Solver/SolverDefaultImplementation.h>
 #include <Core/Utils/extension/measure_time.hpp>
+#include <Core/Utils/extension/logger.hpp>
 
 
 /*****************************************************************************/
 // Peer
-// BDF-Verfahren für steife und nicht-steife ODEs
+// Linear-implizites Peer-Verfahren mit 5 Stufen für steife ODEs
 // Dokumentation siehe offizielle Peer Doku
+//
+// All stages of a step are independent of each other and are solved in
+// parallel by a PeerStageExecutor, every worker uses its own copy of the
+// system. The step size is controlled with the difference between the
+// extrapolated predictor and the new solution of the last stage. One
+// Jacobian is shared by all stages and reused over several steps, each
+// stage keeps the factorization of its iteration matrix as long as the
+// step size does not change.
 
 /*****************************************************************************
 Copyright (c) 2014, IWR TU Dresden, All rights reserved
 *****************************************************************************/
-#if defined(USE_MPI) || defined(USE_OPENMP)
+#if defined(USE_THREAD)
+class PeerStageExecutor;
+
 class Peer
   : public ISolver,  public SolverDefaultImplementation
 {
@@ -70,19 +81,30 @@ public:
 
     virtual void stop();
 private:
-
-
-
-
-
-  // Nulltellenfunktion
-  void writePeerOutput(const double &time,const double &h,const int &stp);
   void evalJ(const double& t, const double* z, double* T, IContinuous *continuousSystem, ITime *timeSystem, double fac=1);
   void evalF(const double& t, const double* z, double* f, IContinuous *continuousSystem, ITime *timeSystem);
   void evalD(const double& t, const double* y, double* T, IContinuous *continuousSystem, ITime *timeSystem);
-  void setcycletime(double cycletime);
   void ros2(double * y, double& tstart, double tend, IContinuous *continuousSystem, ITime *timeSystem);
 
+  /// Startup: computes the first stage values with ros2, returns the time of the last stage
+  double startup(const double& t0);
+  /// Initial step size from the size of the states and derivatives
+  double initialStepSize(const double& t0, const double& tEnd);
+  /// Shared Jacobian at the central predictor stage, columns are computed in parallel
+  void evalSharedJacobian(const double& t, const double* y);
+  /// One step from the stages in _Y1 (last stage at time t) with step size h, new stages go to _Ynew
+  bool step(const double& t, const double& h, double& err);
+  /// Stage task: correction of the predictor of one stage on the system of the given worker
+  void solveStage(int stage, int worker, double t, double h, bool factorize);
+  /// Jacobian task: column j on the system of the given worker
+  void evalJacobianColumn(int column, int worker, double t, const double* y);
+  /// Extrapolation matrix from the old stages to the new stages for the step size ratio sigma
+  void setTheta(double sigma);
+  /// Lagrange basis of the stage nodes at x
+  void lagrangeBasis(double x, double* l);
+  /// Writes all output points up to tTo using the interpolation polynomial of the stages in _Y1
+  void writePeerOutput(const double& center, const double& h, const double& tTo);
+
   ISolverSettings
     *_peersettings;              ///< Input      - Solver settings
 
@@ -92,13 +114,17 @@ private:
 
     int
         _rstages,
-        _rank,
-        _size,
-        _reuseJacobi,
-        _numThreads;
+        _reuseJacobi,             ///< Maximum number of steps a Jacobian is reused
+        _numThreads,
+        _jacobianAge,             ///< Steps since the last Jacobian evaluation, -1 if there is none
+        _numSteps,
+        _numRejected,
+        _numJacobians,
+        _numFactorizations;
 
     long int
-        *_P;
+        *_P,
+        *_info;
 
     double
         *_G,
@@ -107,41 +133,24 @@ private:
         *_c,
         *_F,
         *_y,
-        *_Y1,
-        *_Y2,
-        *_Y3,
-        *_T,
+        *_Y1,                     ///< Stage values of the last accepted step
+        *_Y2,                     ///< Predictor, extrapolated from _Y1
+        *_Y3,                     ///< Derivative of the predictor
+        *_Ynew,                   ///< Stage values of the current step
+        *_T,                      ///< LU factorization of the iteration matrix of each stage
+        *_J,                      ///< Jacobian shared by all stages
+        *_fJac,                   ///< Right hand side at the point of the Jacobian
+        *_work,                   ///< Per worker scratch vectors for the Jacobian columns
+        *_err,
         _h,
-        _hOut;
-
-
+        _hOld,                    ///< Step size of the last accepted step
+        _hFactor,                 ///< Step size the stage factorizations belong to
+        _hOut,
+        _tOut;                    ///< Next output time
 
-  // Variables for Coloured Jacobians
-//  int  _sizeof_sparsePattern_colorCols;
-//  int* _sparsePattern_colorCols;
-//
-//  int  _sizeof_sparsePattern_leadindex;
-//  int* _sparsePattern_leadindex;
-//
-//
-//  int  _sizeof_sparsePattern_index;
-//  int* _sparsePattern_index;
-//
-//
-//  int  _sparsePattern_maxColors;
-//
-//  bool _cvode_initialized;
-
-
-//   ISystemProperties* _properties;
    IContinuous* _continuous_system[5];
-//   IEvent* _event_system;
-//   IMixedSystem* _mixed_system;
    ITime* _time_system[5];
-
-//   std::vector<MeasureTimeData> measureTimeFunctionsArray;
-//   MeasureTimeValues *measuredFunctionStartValues, *measuredFunctionEndValues;
-
+   PeerStageExecutor* _executor;
 };
 #else
 class Peer : public ISolver, public SolverDefaultImplementation
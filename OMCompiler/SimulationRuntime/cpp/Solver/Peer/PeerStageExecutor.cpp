@@ -0,0 +1,138 @@
+#include <Core/ModelicaDefine.h>
+#include <Core/Modelica.h>
+
+#include <Solver/Peer/PeerStageExecutor.h>
+
+#if defined(USE_THREAD)
+
+PeerStageExecutor::PeerStageExecutor(int numWorkers)
+    : _numWorkers(std::max(numWorkers, 1)),
+      _queues(),
+      _threads(),
+      _task(NULL),
+      _generation(0),
+      _activeWorkers(0),
+      _stop(false),
+      _error()
+{
+    for(int i = 0; i < _numWorkers; ++i)
+        _queues.push_back(new TaskQueue());
+    for(int i = 1; i < _numWorkers; ++i)
+        _threads.push_back(new thread(bind(&PeerStageExecutor::workerLoop, this, i)));
+}
+
+PeerStageExecutor::~PeerStageExecutor()
+{
+    {
+        unique_lock<mutex> lock(_lock);
+        _stop = true;
+    }
+    _start.notify_all();
+    for(size_t i = 0; i < _threads.size(); ++i)
+    {
+        _threads[i]->join();
+        delete _threads[i];
+    }
+    for(size_t i = 0; i < _queues.size(); ++i)
+        delete _queues[i];
+}
+
+void PeerStageExecutor::run(int numTasks, const function<void(int, int)>& task)
+{
+    if(numTasks <= 0)
+        return;
+
+    // Deal the tasks round robin, idle workers steal from the others
+    for(int i = 0; i < numTasks; ++i)
+        _queues[i % _numWorkers]->tasks.push_back(i);
+
+    {
+        unique_lock<mutex> lock(_lock);
+        _task = &task;
+        _activeWorkers = _numWorkers;
+        _error.clear();
+        ++_generation;
+    }
+    _start.notify_all();
+
+    work(0);
+
+    // Wait until every worker has left the task, it lives on the caller's stack
+    unique_lock<mutex> lock(_lock);
+    while(_activeWorkers > 0)
+        _done.wait(lock);
+    _task = NULL;
+
+    if(!_error.empty())
+        throw ModelicaSimulationError(SOLVER, _error);
+}
+
+void PeerStageExecutor::workerLoop(int worker)
+{
+    unsigned int generation = 0;
+    while(true)
+    {
+        {
+            unique_lock<mutex> lock(_lock);
+            while(!_stop && _generation == generation)
+                _start.wait(lock);
+            if(_stop)
+                return;
+            generation = _generation;
+        }
+        work(worker);
+    }
+}
+
+void PeerStageExecutor::work(int worker)
+{
+    int task;
+    while(popTask(worker, task))
+    {
+        try
+        {
+            (*_task)(task, worker);
+        }
+        catch(std::exception& ex)
+        {
+            unique_lock<mutex> lock(_lock);
+            if(_error.empty())
+                _error = ex.what();
+        }
+    }
+
+    unique_lock<mutex> lock(_lock);
+    if(--_activeWorkers == 0)
+        _done.notify_all();
+}
+
+bool PeerStageExecutor::popTask(int worker, int& task)
+{
+    // Own tasks are taken from the back ...
+    {
+        TaskQueue* queue = _queues[worker];
+        unique_lock<mutex> lock(queue->lock);
+        if(!queue->tasks.empty())
+        {
+            task = queue->tasks.back();
+            queue->tasks.pop_back();
+            return true;
+        }
+    }
+    // ... tasks of other workers from the front. Tasks are only added before
+    // a run starts, so once all queues are empty the run is finished.
+    for(int i = 1; i < _numWorkers; ++i)
+    {
+        TaskQueue* queue = _queues[(worker + i) % _numWorkers];
+        unique_lock<mutex> lock(queue->lock);
+        if(!queue->tasks.empty())
+        {
+            task = queue->tasks.front();
+            queue->tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+#endif //USE_THREAD
@@ -0,0 +1,51 @@
+#pragma once
+
+/*****************************************************************************/
+// PeerStageExecutor
+// Thread pool with work stealing that runs the independent tasks of one
+// Peer step (stages, Jacobian columns). Every worker owns one copy of the
+// system, the task gets the index of the worker it runs on so it can use
+// the right copy. The calling thread is worker 0.
+
+#if defined(USE_THREAD)
+
+class PeerStageExecutor
+{
+public:
+  PeerStageExecutor(int numWorkers);
+  ~PeerStageExecutor();
+
+  int getNumWorkers() const
+  {
+    return _numWorkers;
+  }
+
+  /// Runs task(i, worker) for i = 0..numTasks-1 and returns when all tasks are done
+  void run(int numTasks, const function<void(int, int)>& task);
+
+private:
+  struct TaskQueue
+  {
+    mutex lock;
+    deque<int> tasks;
+  };
+
+  void workerLoop(int worker);
+  void work(int worker);
+  bool popTask(int worker, int& task);
+
+  int _numWorkers;
+  vector<TaskQueue*> _queues;    ///< One queue per worker, the owner pops from the back, thieves take from the front
+  vector<thread*> _threads;
+
+  mutex _lock;
+  condition_variable _start;
+  condition_variable _done;
+  const function<void(int, int)>* _task;
+  unsigned int _generation;      ///< Incremented for every run, wakes the workers
+  int _activeWorkers;            ///< Number of workers still busy with the current run
+  bool _stop;
+  string _error;                 ///< Message of the first failing task
+};
+
+#endif //USE_THREAD
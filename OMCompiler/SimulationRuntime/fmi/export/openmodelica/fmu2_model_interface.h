@@ -32,6 +32,7 @@
 #define __FMU2_MODEL_INTERFACE_H__
 
 #include "../simulation_data.h"
+#include "../simulation/solver/masked_eval.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -73,6 +74,27 @@ typedef enum {
   model_state_fatal                   = 1<<11  /* ME and CS */
 } ModelState;
 
+/* Snapshot of the FMU state, see fmi2GetFMUstate.
+ * All numeric values are stored in one contiguous block directly behind this
+ * struct, the strings in a separate uncollectable array. */
+typedef struct INTERNAL_FMU_STATE {
+  struct INTERNAL_FMU_STATE *next;      /* next snapshot in the free list of the pool */
+  unsigned long parameterGeneration;    /* generation of the parameters stored in data, 0 if unknown */
+  char *data;                           /* contiguous block of FMU_STATE_POOL.dataSize bytes */
+  modelica_string *strings;             /* FMU_STATE_POOL.nStrings strings */
+} INTERNAL_FMU_STATE;
+
+/* Pool of pre-sized snapshots; released snapshots are reused by the next
+ * fmi2GetFMUstate. Parameters are only copied if they changed since the
+ * snapshot was taken, which is tracked by a generation counter. */
+typedef struct {
+  INTERNAL_FMU_STATE *freeList;
+  unsigned long parameterGeneration;    /* generation of the current parameter values */
+  unsigned long nextGeneration;
+  size_t dataSize;
+  size_t nStrings;
+} FMU_STATE_POOL;
+
 typedef struct {
   fmi2String instanceName;
   fmi2Type type;
@@ -98,22 +120,32 @@ typedef struct {
   int _has_jacobian_intialization;
   ANALYTIC_JACOBIAN* fmiDerJac;
   ANALYTIC_JACOBIAN* fmiDerJacInitialization;
+  int _jacobian_constants_valid;                  /* constantEqns of fmiDerJac evaluated for the current values */
+  int _jacobian_initialization_constants_valid;   /* constantEqns of fmiDerJacInitialization evaluated for the current values */
+  fmi2ValueReference* jacobianRowRefs;            /* value references of rows and columns of fmiDerJac, see omc_fmi2GetJacobianSparsity */
+  fmi2ValueReference* jacobianColRefs;
+  EVAL_MASK odeMask;                              /* re-evaluate only the equations affected by fmi2SetXXX, see updateIfNeeded */
+  EVAL_MASK algebraicMask;
 
   fmi2Real* states;
   fmi2Real* states_der;
   fmi2Real* event_indicators;
   fmi2Real* event_indicators_prev;
   fmi2Real* input_real_derivative;
+
+  FMU_STATE_POOL statePool;
 } ModelInstance;
 
-typedef struct {
-  RINGBUFFER* simulationData;
-  modelica_real* realParameter;
-  modelica_integer* integerParameter;
-  modelica_boolean* booleanParameter;
-  modelica_string* stringParameter;
-} INTERNAL_FMU_STATE;
 
+/* OpenModelica specific extensions of the FMI 2.0 interface */
+FMI2_Export fmi2Status omc_fmi2GetDirectionalDerivatives(fmi2Component c,
+    const fmi2ValueReference vUnknown_ref[], size_t nUnknown,
+    const fmi2ValueReference vKnown_ref[], size_t nKnown,
+    size_t nSeeds, const fmi2Real dvKnown[], fmi2Real dvUnknown[]);
+FMI2_Export fmi2Status omc_fmi2GetJacobianSparsity(fmi2Component c, size_t *nRows, size_t *nCols, size_t *nnz,
+    const unsigned int **colPtr, const unsigned int **rowIdx,
+    const fmi2ValueReference **rowRefs, const fmi2ValueReference **colRefs);
+FMI2_Export fmi2Status omc_fmi2GetJacobianCSC(fmi2Component c, fmi2Real values[], size_t nnz);
 
 /* reset alignment policy to the one set before reading this file */
 #if defined _MSC_VER || defined __GNUC__
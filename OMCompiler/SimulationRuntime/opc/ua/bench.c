@@ -0,0 +1,174 @@
+/*
+ * Loopback benchmark for the embedded OPC UA server.
+ *
+ * A synthetic model with N real variables (100000 by default) is stepped
+ * without the server, then with the server and a client on the same host
+ * monitoring 0, 10 and 1000 of the variables. The time per step shows how
+ * much the server slows down the solver.
+ *
+ *   ./bench [N] [steps]
+ */
+
+#define _XOPEN_SOURCE 600
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "open62541.h"
+#include "omc_opc_ua.h"
+
+#define BENCH_PORT 4842
+
+static volatile int clientReady;
+static volatile int clientStop;
+static volatile int nUpdates;
+
+typedef struct {
+  int nMonitored;
+  int nVars;
+} bench_client;
+
+static double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + 1e-9*ts.tv_nsec;
+}
+
+static void syncUpdate(DATA *data, double scaling)
+{
+}
+
+static void valueChanged(UA_UInt32 handle, UA_DataValue *value, void *context) {
+  nUpdates++;
+}
+
+static int writeRun(UA_Client *client, UA_Boolean val)
+{
+  UA_Variant v;
+  UA_Variant_setScalar(&v, &val, &UA_TYPES[UA_TYPES_BOOLEAN]);
+  return UA_STATUSCODE_GOOD == UA_Client_writeValueAttribute(client, UA_NODEID_NUMERIC(0, OMC_OPC_NODEID_RUN), &v);
+}
+
+static void* clientWork(void *arg)
+{
+  bench_client *bc = (bench_client*) arg;
+  UA_Client *client = UA_Client_new(UA_ClientConfig_standard);
+  UA_SubscriptionSettings subSettings = UA_SubscriptionSettings_standard;
+  UA_UInt32 subId = 0, monId;
+  char url[64];
+  int i;
+
+  snprintf(url, sizeof(url), "opc.tcp://localhost:%d", BENCH_PORT);
+  if (UA_STATUSCODE_GOOD != UA_Client_connect(client, url)) {
+    fprintf(stderr, "Failed to connect to %s\n", url);
+    exit(1);
+  }
+  if (!writeRun(client, UA_TRUE)) {
+    fprintf(stderr, "Writing to NODEID_RUN failed\n");
+    exit(1);
+  }
+  if (bc->nMonitored) {
+    subSettings.requestedPublishingInterval = 5;
+    UA_Client_Subscriptions_new(client, subSettings, &subId);
+    for (i = 0; i < bc->nMonitored; i++) {
+      /* spread the monitored items over the whole model */
+      UA_NodeId nodeId = UA_NODEID_NUMERIC(1, VARKIND_REAL*MAX_VARS_KIND + (int)((long)i*bc->nVars/bc->nMonitored));
+      UA_Client_Subscriptions_addMonitoredItem(client, subId, nodeId, UA_ATTRIBUTEID_VALUE, &valueChanged, NULL, &monId);
+    }
+  }
+  clientReady = 1;
+  while (!clientStop) {
+    if (subId) {
+      UA_Client_Subscriptions_manuallySendPublishRequest(client);
+    }
+    usleep(1000);
+  }
+  writeRun(client, UA_FALSE);
+  if (subId) {
+    UA_Client_Subscriptions_remove(client, subId);
+  }
+  UA_Client_disconnect(client);
+  UA_Client_delete(client);
+  return NULL;
+}
+
+/* Stand-in for the right-hand side: touches every variable once */
+static void solverStep(DATA *data, double t)
+{
+  double *x = data->localData[0]->realVars;
+  int i, n = data->modelData->nVariablesReal;
+  for (i = 0; i < n; i++) {
+    x[i] = 0.999*x[i] + t;
+  }
+  data->localData[0]->timeValue = t;
+}
+
+static double runSteps(DATA *data, void *server, int steps)
+{
+  int i, terminate = 0;
+  double start = now();
+  for (i = 0; i < steps; i++) {
+    solverStep(data, i*1e-3);
+    if (server) {
+      omc_embedded_server_update(server, i*1e-3, &terminate);
+    }
+  }
+  return (now() - start) / steps;
+}
+
+int main(int argc, char **argv)
+{
+  int n = argc > 1 ? atoi(argv[1]) : 100000;
+  int steps = argc > 2 ? atoi(argv[2]) : 2000;
+  int monitored[] = {0, 10, 1000};
+  MODEL_DATA modelData = {0};
+  SIMULATION_INFO simulationInfo = {0};
+  SIMULATION_DATA simulationData = {0};
+  SIMULATION_DATA *localData[1] = {&simulationData};
+  DATA data = {0};
+  char name[32];
+  double baseline, perStep;
+  void *server;
+  int i, k;
+
+  modelData.nVariablesReal = n;
+  modelData.realVarsData = calloc(n, sizeof(STATIC_REAL_DATA));
+  for (i = 0; i < n; i++) {
+    snprintf(name, sizeof(name), "x[%d]", i+1);
+    modelData.realVarsData[i].info.name = strdup(name);
+    modelData.realVarsData[i].info.comment = "";
+    modelData.realVarsData[i].info.inputIndex = -1;
+  }
+  simulationData.realVars = calloc(n, sizeof(modelica_real));
+  data.modelData = &modelData;
+  data.simulationInfo = &simulationInfo;
+  data.localData = localData;
+
+  baseline = runSteps(&data, NULL, steps);
+  printf("variables  monitored  time per step [us]  slowdown\n");
+  printf("%d  -  %.2f  1.00\n", n, 1e6*baseline);
+
+  server = omc_embedded_server_init(&data, 0, 1e-3, argv[0], syncUpdate, BENCH_PORT);
+  for (k = 0; k < sizeof(monitored)/sizeof(int); k++) {
+    bench_client bc = {monitored[k], n};
+    pthread_t thread;
+    clientReady = 0;
+    clientStop = 0;
+    nUpdates = 0;
+    pthread_create(&thread, NULL, clientWork, &bc);
+    /* the client connects, subscribes and sets run=true */
+    while (!clientReady) {
+      usleep(1000);
+    }
+    perStep = runSteps(&data, server, steps);
+    clientStop = 1;
+    pthread_join(thread, NULL);
+    printf("%d  %d  %.2f  %.2f  (%d notifications)\n", n, monitored[k], 1e6*perStep, perStep/baseline, nUpdates);
+  }
+  omc_embedded_server_deinit(server);
+  return 0;
+}
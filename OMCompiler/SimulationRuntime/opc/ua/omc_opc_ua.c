@@ -33,11 +33,29 @@
 #include "omc_opc_ua.h"
 #include "open62541.h"
 #include <pthread.h>
+#include <time.h>
+#include <unistd.h>
 
 #define BAD_RESULT() fprintf(stderr, "%s:%d: Bad OPC result\n", __FILE__, __LINE__);
 
+/* A variable is published as long as it was read within the last OMC_OPC_DEMAND_LEASE_MS */
+#define OMC_OPC_DEMAND_LEASE_MS 5000
+/* Maximum time a read waits for the first value of a variable that was not published yet */
+#define OMC_OPC_PUBLISH_WAIT_MS 100
+
 static volatile int count=0;
 
+/* Variables of one kind requested by the clients (reads and sampled monitored items).
+ * requested and lastRead are written by the server thread, index and active by the solver.
+ */
+typedef struct {
+  int n;
+  int *index;
+  UA_Boolean *active;
+  UA_Boolean *requested;
+  UA_UInt32 *lastRead;
+} omc_opc_ua_demand;
+
 typedef struct {
   DATA *data;
   UA_Logger logger;
@@ -48,20 +66,29 @@ typedef struct {
   UA_Boolean step;
   UA_Boolean terminate;
   UA_Boolean oldUseStopTime;
+  UA_Boolean waiting;
   pthread_mutex_t mutex_pause;
   pthread_cond_t cond_pause;
-  double time[2];
   pthread_t thread;
   UA_MethodAttributes runAttr;
   double *inputVarsBackup;
   int gotNewInput;
   pthread_mutex_t write_values;
-  pthread_mutex_t mutex_values;
-  int latestValues;
-  UA_Double *realVals[2];
+  /* published values, a seqlock snapshot: odd while the solver copies */
+  unsigned int seq;
+  double time;
+  UA_Double *realVals;
   int *realValsInputIndex;
-  UA_Boolean *boolVals[2];
+  UA_Boolean *boolVals;
   int *boolValsInputIndex;
+  omc_opc_ua_demand demand[2];
+  /* newly requested variables: real k is k, boolean k is nVariablesReal+k */
+  pthread_mutex_t mutex_demand;
+  int *demandQueue;
+  int demandQueueSize;
+  unsigned int demandHead;
+  unsigned int demandTail;
+  UA_UInt32 lastExpire;
   int reinitStateFlag;
   int *stateWasUpdatedFlag;
   double *updatedStates;
@@ -91,12 +118,17 @@ static void waitForStep(volatile omc_opc_ua_state *state)
 {
   int run;
   state->step = 0;
-  pthread_mutex_lock(&state->mutex_pause);
-  run = state->run;
-  while (!(state->run || state->step)) {
-    pthread_cond_wait(&state->cond_pause, &state->mutex_pause);
+  run = __atomic_load_n(&state->run, __ATOMIC_ACQUIRE);
+  if (!run) {
+    pthread_mutex_lock(&state->mutex_pause);
+    run = state->run;
+    state->waiting = 1;
+    while (!(state->run || state->step)) {
+      pthread_cond_wait(&state->cond_pause, &state->mutex_pause);
+    }
+    state->waiting = 0;
+    pthread_mutex_unlock(&state->mutex_pause);
   }
-  pthread_mutex_unlock(&state->mutex_pause);
   if (!run || state->data->real_time_sync.scaling != state->real_time_sync_scaling) {
     /* We were not running or the scaling factor changed. Reset the real-time synchronization! */
     state->omc_real_time_sync_update(state->data, state->real_time_sync_scaling);
@@ -104,6 +136,182 @@ static void waitForStep(volatile omc_opc_ua_state *state)
   }
 }
 
+static UA_UInt32 nowMs(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (UA_UInt32) (ts.tv_sec*1000 + ts.tv_nsec/1000000);
+}
+
+/* Server thread: renew the lease of a variable, queue it for the solver if
+ * it is not requested yet. Returns true if the solver already publishes it.
+ */
+static int requestValue(omc_opc_ua_state *state, var_kind_t varKind, int index)
+{
+  omc_opc_ua_demand *demand = &state->demand[varKind-1];
+  __atomic_store_n(&demand->lastRead[index], nowMs(), __ATOMIC_SEQ_CST);
+  if (!__atomic_load_n(&demand->requested[index], __ATOMIC_SEQ_CST) && !__atomic_exchange_n(&demand->requested[index], 1, __ATOMIC_SEQ_CST)) {
+    pthread_mutex_lock(&state->mutex_demand);
+    state->demandQueue[state->demandTail % state->demandQueueSize] = varKind == VARKIND_REAL ? index : state->data->modelData->nVariablesReal + index;
+    __atomic_store_n(&state->demandTail, state->demandTail+1, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&state->mutex_demand);
+  }
+  return __atomic_load_n(&demand->active[index], __ATOMIC_ACQUIRE);
+}
+
+static void beginPublish(omc_opc_ua_state *state)
+{
+  __atomic_store_n(&state->seq, state->seq+1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static void endPublish(omc_opc_ua_state *state)
+{
+  __atomic_store_n(&state->seq, state->seq+1, __ATOMIC_RELEASE);
+}
+
+/* Server thread: the first value of a variable that is not published yet.
+ * A paused solver cannot continue while we hold mutex_pause, so the value is
+ * taken from the model data. A running solver publishes it with the next step.
+ * Returns false if the solver did not publish it within the wait.
+ */
+static int waitForPublished(omc_opc_ua_state *state, var_kind_t varKind, int index)
+{
+  omc_opc_ua_demand *demand = &state->demand[varKind-1];
+  int i;
+  pthread_mutex_lock(&state->mutex_pause);
+  if (state->waiting) {
+    beginPublish(state);
+    if (varKind == VARKIND_REAL) {
+      __atomic_store(&state->realVals[index], &(state->data->localData[0])->realVars[index], __ATOMIC_RELAXED);
+    } else {
+      __atomic_store_n(&state->boolVals[index], (state->data->localData[0])->booleanVars[index], __ATOMIC_RELAXED);
+    }
+    endPublish(state);
+    pthread_mutex_unlock(&state->mutex_pause);
+    return 1;
+  }
+  pthread_mutex_unlock(&state->mutex_pause);
+  for (i = 0; i < 10*OMC_OPC_PUBLISH_WAIT_MS && !__atomic_load_n(&demand->active[index], __ATOMIC_ACQUIRE); i++) {
+    usleep(100);
+  }
+  return __atomic_load_n(&demand->active[index], __ATOMIC_ACQUIRE);
+}
+
+static UA_Double readPublishedReal(omc_opc_ua_state *state, int index)
+{
+  unsigned int seq;
+  UA_Double val;
+  do {
+    while ((seq = __atomic_load_n(&state->seq, __ATOMIC_ACQUIRE)) & 1) {
+      /* the solver is copying the active variables */
+    }
+    __atomic_load(index < 0 ? &state->time : &state->realVals[index], &val, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  } while (seq != __atomic_load_n(&state->seq, __ATOMIC_RELAXED));
+  return val;
+}
+
+static UA_Boolean readPublishedBoolean(omc_opc_ua_state *state, int index)
+{
+  unsigned int seq;
+  UA_Boolean val;
+  do {
+    while ((seq = __atomic_load_n(&state->seq, __ATOMIC_ACQUIRE)) & 1) {
+      /* the solver is copying the active variables */
+    }
+    val = __atomic_load_n(&state->boolVals[index], __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  } while (seq != __atomic_load_n(&state->seq, __ATOMIC_RELAXED));
+  return val;
+}
+
+/* Solver: drop the variables nobody read within the lease */
+static void expireDemand(omc_opc_ua_state *state)
+{
+  UA_UInt32 now;
+  int kind, i, k;
+
+  if (state->demand[0].n == 0 && state->demand[1].n == 0) {
+    return;
+  }
+  now = nowMs();
+  if (now - state->lastExpire < OMC_OPC_DEMAND_LEASE_MS/2) {
+    return;
+  }
+  state->lastExpire = now;
+  for (kind = 0; kind < 2; kind++) {
+    omc_opc_ua_demand *demand = &state->demand[kind];
+    for (i = 0; i < demand->n; ) {
+      k = demand->index[i];
+      if (now - __atomic_load_n(&demand->lastRead[k], __ATOMIC_SEQ_CST) > OMC_OPC_DEMAND_LEASE_MS) {
+        /* a concurrent read either sees requested=0 and queues it again, or renewed the lease */
+        __atomic_store_n(&demand->requested[k], 0, __ATOMIC_SEQ_CST);
+        if (now - __atomic_load_n(&demand->lastRead[k], __ATOMIC_SEQ_CST) > OMC_OPC_DEMAND_LEASE_MS) {
+          __atomic_store_n(&demand->active[k], 0, __ATOMIC_RELEASE);
+          demand->index[i] = demand->index[--demand->n];
+          continue;
+        }
+        __atomic_store_n(&demand->requested[k], 1, __ATOMIC_SEQ_CST);
+      }
+      i++;
+    }
+  }
+}
+
+/* Solver: append the newly requested variables to the active ones */
+static void drainDemand(omc_opc_ua_state *state)
+{
+  const int nReal = state->data->modelData->nVariablesReal;
+  unsigned int tail = __atomic_load_n(&state->demandTail, __ATOMIC_ACQUIRE);
+  omc_opc_ua_demand *demand;
+  int k;
+
+  for (; state->demandHead != tail; state->demandHead++) {
+    k = state->demandQueue[state->demandHead % state->demandQueueSize];
+    demand = &state->demand[k < nReal ? 0 : 1];
+    k = k < nReal ? k : k - nReal;
+    if (!demand->active[k]) {
+      demand->index[demand->n++] = k;
+    }
+  }
+}
+
+/* Solver: copy the time and the active variables into the snapshot */
+static void publishValues(omc_opc_ua_state *state, double t)
+{
+  DATA *data = state->data;
+  omc_opc_ua_demand *demand;
+  int first[2], i, k;
+
+  expireDemand(state);
+  first[0] = state->demand[0].n;
+  first[1] = state->demand[1].n;
+  drainDemand(state);
+
+  beginPublish(state);
+  __atomic_store(&state->time, &t, __ATOMIC_RELAXED);
+  demand = &state->demand[VARKIND_REAL-1];
+  for (i = 0; i < demand->n; i++) {
+    k = demand->index[i];
+    __atomic_store(&state->realVals[k], &(data->localData[0])->realVars[k], __ATOMIC_RELAXED);
+  }
+  demand = &state->demand[VARKIND_BOOL-1];
+  for (i = 0; i < demand->n; i++) {
+    k = demand->index[i];
+    __atomic_store_n(&state->boolVals[k], (data->localData[0])->booleanVars[k], __ATOMIC_RELAXED);
+  }
+  endPublish(state);
+
+  /* readers waiting for a new variable may use the snapshot from now on */
+  for (k = 0; k < 2; k++) {
+    demand = &state->demand[k];
+    for (i = first[k]; i < demand->n; i++) {
+      __atomic_store_n(&demand->active[demand->index[i]], 1, __ATOMIC_RELEASE);
+    }
+  }
+}
+
 void omc_wait_for_step(void *state_vp)
 {
   waitForStep((omc_opc_ua_state*) state_vp);
@@ -129,15 +337,17 @@ readBoolean(void *handle, const UA_NodeId nodeid, UA_Boolean sourceTimeStamp, co
   } else if (nodeid.identifier.numeric == OMC_OPC_NODEID_ENABLE_STOP_TIME) {
     val = state->data->simulationInfo->useStopTime;
   } else if (nodeid.identifier.numeric == OMC_OPC_NODEID_TERMINATE) {
-    val = state->terminate;
+    val = __atomic_load_n(&state->terminate, __ATOMIC_ACQUIRE);
   } else if (nodeid.identifier.numeric >= VARKIND_BOOL*MAX_VARS_KIND && nodeid.identifier.numeric < (1+VARKIND_BOOL)*MAX_VARS_KIND) {
     int index1 = nodeid.identifier.numeric-VARKIND_BOOL*MAX_VARS_KIND;
     int index = index1 >= ALIAS_START_ID ? modelData->booleanAlias[index1-ALIAS_START_ID].nameID : index1;
     int negate = index1 >= ALIAS_START_ID ? modelData->booleanAlias[index1-ALIAS_START_ID].negate : 0;
-    int latestValues = state->latestValues;
-    pthread_mutex_lock(&state->mutex_values);
-    val = state->boolVals[latestValues][index];
-    pthread_mutex_unlock(&state->mutex_values);
+    if (!requestValue(state, VARKIND_BOOL, index) && !waitForPublished(state, VARKIND_BOOL, index)) {
+      /* the slot still holds the value from before the variable was requested */
+      dataValue->hasValue = UA_FALSE;
+      return UA_STATUSCODE_BADWAITINGFORINITIALDATA;
+    }
+    val = readPublishedBoolean(state, index);
     val = negate ? !val : val;
   } else {
     dataValue->hasValue = UA_FALSE;
@@ -170,7 +380,7 @@ writeBoolean(void *handle, const UA_NodeId nodeid, const UA_Variant *data, const
       pthread_cond_signal(&state->cond_pause);
     } else if (nodeid.identifier.numeric==OMC_OPC_NODEID_RUN) {
       pthread_mutex_lock(&state->mutex_pause);
-      state->run = newVal;
+      __atomic_store_n(&state->run, newVal, __ATOMIC_RELEASE);
       pthread_mutex_unlock(&state->mutex_pause);
       pthread_cond_signal(&state->cond_pause);
     } else if (nodeid.identifier.numeric==OMC_OPC_NODEID_ENABLE_STOP_TIME) {
@@ -192,7 +402,7 @@ writeBoolean(void *handle, const UA_NodeId nodeid, const UA_Variant *data, const
       else if (state->terminate)  /* Falling edge of this flag occurred in the same step, restore prev. val of useStopTime */
         state->data->simulationInfo->useStopTime = state->oldUseStopTime;
 
-      state->terminate = newVal;
+      __atomic_store_n(&state->terminate, newVal, __ATOMIC_RELEASE);
 
       pthread_mutex_unlock(&state->mutex_pause);
     } else if (nodeid.identifier.numeric >= VARKIND_BOOL*MAX_VARS_KIND && nodeid.identifier.numeric < (1+VARKIND_BOOL)*MAX_VARS_KIND) {
@@ -202,9 +412,10 @@ writeBoolean(void *handle, const UA_NodeId nodeid, const UA_Variant *data, const
       int inputIndex = state->boolValsInputIndex[index];
       newVal = negate ? !newVal : newVal;
       if (inputIndex != -1) {
-        if (state->data->simulationInfo->inputVars[inputIndex] != newVal) {
-          state->gotNewInput = 1;
+        /* applied by the solver at the next step, together with all other writes */
+        if (state->inputVarsBackup[inputIndex] != newVal) {
           state->inputVarsBackup[inputIndex] = newVal;
+          __atomic_store_n(&state->gotNewInput, 1, __ATOMIC_RELEASE);
         }
       } else {
         pthread_mutex_unlock(&state->write_values);
@@ -235,18 +446,19 @@ readReal(void *handle, const UA_NodeId nodeid, UA_Boolean sourceTimeStamp, const
 
 
   if (nodeid.identifier.numeric==OMC_OPC_NODEID_TIME) {
-    pthread_mutex_lock(&state->mutex_values);
-    val = state->time[state->latestValues];
-    pthread_mutex_unlock(&state->mutex_values);
+    val = readPublishedReal(state, -1);
   } else if (nodeid.identifier.numeric==OMC_OPC_NODEID_REAL_TIME_SCALING_FACTOR) {
     val = state->real_time_sync_scaling;
   } else if (nodeid.identifier.numeric >= VARKIND_REAL*MAX_VARS_KIND && nodeid.identifier.numeric < (1+VARKIND_REAL)*MAX_VARS_KIND) {
     int index1 = nodeid.identifier.numeric-VARKIND_REAL*MAX_VARS_KIND;
     int index = index1 >= ALIAS_START_ID ? modelData->realAlias[index1-ALIAS_START_ID].nameID : index1;
     int negate = index1 >= ALIAS_START_ID ? modelData->realAlias[index1-ALIAS_START_ID].negate : 0;
-    pthread_mutex_lock(&state->mutex_values);
-    val = state->realVals[state->latestValues][index];
-    pthread_mutex_unlock(&state->mutex_values);
+    if (!requestValue(state, VARKIND_REAL, index) && !waitForPublished(state, VARKIND_REAL, index)) {
+      /* the slot still holds the value from before the variable was requested */
+      dataValue->hasValue = UA_FALSE;
+      return UA_STATUSCODE_BADWAITINGFORINITIALDATA;
+    }
+    val = readPublishedReal(state, index);
     val = negate ? -val : val;
   } else {
     BAD_RESULT()
@@ -289,14 +501,15 @@ writeReal(void *handle, const UA_NodeId nodeid, const UA_Variant *data, const UA
     int inputIndex = state->realValsInputIndex[index];
     newVal = negate ? -newVal : newVal;
     if (inputIndex != -1) {
-      if (state->data->simulationInfo->inputVars[inputIndex] != newVal) {
-        state->gotNewInput = 1;
+      /* applied by the solver at the next step, together with all other writes */
+      if (state->inputVarsBackup[inputIndex] != newVal) {
         state->inputVarsBackup[inputIndex] = newVal;
+        __atomic_store_n(&state->gotNewInput, 1, __ATOMIC_RELEASE);
       }
     } else if (index < state->data->modelData->nStates) {
-      state->reinitStateFlag = 1;
       state->stateWasUpdatedFlag[index] = 1;
       state->updatedStates[index] = newVal;
+      __atomic_store_n(&state->reinitStateFlag, 1, __ATOMIC_RELEASE);
     } else {
       BAD_RESULT()
       pthread_mutex_unlock(&state->write_values);
@@ -331,7 +544,7 @@ static inline omc_opc_ua_state* addVars(omc_opc_ua_state *state, var_kind_t varK
     case VARKIND_REAL:
     {
       STATIC_REAL_DATA *realVarsData = modelData->realVarsData;
-      state->realVals[state->latestValues][*varIndex] = ((double*)vars)[i];
+      state->realVals[*varIndex] = ((double*)vars)[i];
       inputIndex = realVarsData[i].info.inputIndex;
       state->realValsInputIndex[*varIndex] = inputIndex;
       nameStr = (char*) realVarsData[i].info.name;
@@ -343,7 +556,7 @@ static inline omc_opc_ua_state* addVars(omc_opc_ua_state *state, var_kind_t varK
     case VARKIND_BOOL:
     {
       STATIC_BOOLEAN_DATA *booleanVarsData = modelData->booleanVarsData;
-      state->boolVals[state->latestValues][*varIndex] = ((signed char*)vars)[i];
+      state->boolVals[*varIndex] = ((signed char*)vars)[i];
       inputIndex = booleanVarsData[i].info.inputIndex;
       state->boolValsInputIndex[*varIndex] = inputIndex;
       nameStr = (char*) booleanVarsData[i].info.name;
@@ -512,18 +725,17 @@ void* omc_embedded_server_init(DATA *data, double t, double step, const char *ar
   state->real_time_sync_scaling = data->real_time_sync.scaling;
 
   state->server_running = 1;
-  state->time[0] = t;
-  state->time[1] = t;
+  state->time = t;
+  state->seq = 0;
   state->omc_real_time_sync_update = omc_real_time_sync_update;
 
   pthread_cond_init(&state->cond_pause, NULL);
   pthread_mutex_init(&state->mutex_pause, NULL);
   pthread_mutex_init(&state->write_values, NULL);
-  pthread_mutex_init(&state->mutex_values, NULL);
-
-  state->latestValues = 0;
+  pthread_mutex_init(&state->mutex_demand, NULL);
 
   state->run = 0;
+  state->waiting = 0;
   state->step = 0;
   state->terminate = 0;
   state->oldUseStopTime = data->simulationInfo->useStopTime;
@@ -629,13 +841,27 @@ void* omc_embedded_server_init(DATA *data, double t, double step, const char *ar
   state->gotNewInput = 0;
   state->inputVarsBackup = malloc(modelData->nInputVars * sizeof(double));
   memcpy(state->inputVarsBackup, data->simulationInfo->inputVars, modelData->nInputVars * sizeof(double));
-  state->realVals[0] = malloc(modelData->nVariablesReal * sizeof(UA_Double));
-  state->realVals[1] = malloc(modelData->nVariablesReal * sizeof(UA_Double));
+  state->realVals = malloc(modelData->nVariablesReal * sizeof(UA_Double));
   state->realValsInputIndex = malloc(modelData->nVariablesReal * sizeof(int));
-  state->boolVals[0] = malloc(modelData->nVariablesBoolean * sizeof(UA_Boolean));
-  state->boolVals[1] = malloc(modelData->nVariablesBoolean * sizeof(UA_Boolean));
+  state->boolVals = malloc(modelData->nVariablesBoolean * sizeof(UA_Boolean));
   state->boolValsInputIndex = malloc(modelData->nVariablesBoolean * sizeof(int));
 
+  for (vk=VARKIND_REAL; vk<=VARKIND_BOOL; vk++) {
+    omc_opc_ua_demand *demand = &state->demand[vk-1];
+    int n = vk == VARKIND_REAL ? modelData->nVariablesReal : modelData->nVariablesBoolean;
+    demand->n = 0;
+    demand->index = malloc(n * sizeof(int));
+    demand->active = calloc(n, sizeof(UA_Boolean));
+    demand->requested = calloc(n, sizeof(UA_Boolean));
+    demand->lastRead = calloc(n, sizeof(UA_UInt32));
+  }
+  /* every variable is queued at most once until the solver drops it */
+  state->demandQueueSize = modelData->nVariablesReal + modelData->nVariablesBoolean + 1;
+  state->demandQueue = malloc(state->demandQueueSize * sizeof(int));
+  state->demandHead = 0;
+  state->demandTail = 0;
+  state->lastExpire = nowMs();
+
   state->reinitStateFlag = 0;
   state->stateWasUpdatedFlag = (int*) calloc(sizeof(int), modelData->nStates);
   state->updatedStates = (double*) malloc(sizeof(double)*modelData->nStates);
@@ -657,6 +883,7 @@ void omc_embedded_server_deinit(void *state_vp)
 {
   omc_opc_ua_state *state = (omc_opc_ua_state*) state_vp;
   void *res;
+  int vk;
 
   state->server_running = 0;
   if (pthread_join(state->thread, &res)) {
@@ -669,69 +896,65 @@ void omc_embedded_server_deinit(void *state_vp)
   state->nl.deleteMembers(&state->nl);
   pthread_mutex_destroy(&state->mutex_pause);
   pthread_mutex_destroy(&state->write_values);
-  pthread_mutex_destroy(&state->mutex_values);
+  pthread_mutex_destroy(&state->mutex_demand);
   pthread_cond_destroy(&state->cond_pause);
   free(state->inputVarsBackup);
-  free(state->realVals[0]);
-  free(state->realVals[1]);
+  free(state->realVals);
   free(state->realValsInputIndex);
-  free(state->boolVals[0]);
-  free(state->boolVals[1]);
+  free(state->boolVals);
   free(state->boolValsInputIndex);
+  for (vk=0; vk<2; vk++) {
+    free(state->demand[vk].index);
+    free(state->demand[vk].active);
+    free(state->demand[vk].requested);
+    free(state->demand[vk].lastRead);
+  }
+  free(state->demandQueue);
+  free(state->stateWasUpdatedFlag);
+  free(state->updatedStates);
   free(state);
 }
 
 int omc_embedded_server_update(void *state_vp, double t, int *terminate)
 {
   omc_opc_ua_state *state = (omc_opc_ua_state*) state_vp;
-  int i, realIndex=0, boolIndex=0, res=0;
+  int i, res=0;
   DATA *data = state->data;
   MODEL_DATA *modelData = data->modelData;
-  int latestValues;
-
-  latestValues = state->latestValues ? 0 : 1;
-
-  state->time[latestValues] = t;
-  for (i = 0; i < modelData->nVariablesReal; i++, realIndex++) {
-    state->realVals[latestValues][realIndex] = (data->localData[0])->realVars[i];
-  }
-  for (i = 0; i < modelData->nVariablesBoolean; i++, boolIndex++) {
-    state->boolVals[latestValues][boolIndex] = (data->localData[0])->booleanVars[i];
-  }
-
-  pthread_mutex_lock(&state->mutex_values);
-  state->latestValues = latestValues;
-  pthread_mutex_unlock(&state->mutex_values);
 
+  publishValues(state, t);
 
   waitForStep(state);
 
+  /* writes from the clients since the last step are applied at once,
+   * the caller handles them as one event */
+  if (__atomic_load_n(&state->gotNewInput, __ATOMIC_ACQUIRE) || __atomic_load_n(&state->reinitStateFlag, __ATOMIC_ACQUIRE)) {
+    pthread_mutex_lock(&state->write_values);
 
-  pthread_mutex_lock(&state->write_values);
-
-  if (state->gotNewInput) {
-    res = 1; /* Trigger an event in the solver, restarting it */
-    memcpy(data->simulationInfo->inputVars, state->inputVarsBackup, modelData->nInputVars * sizeof(double));
+    if (state->gotNewInput) {
+      res = 1; /* Trigger an event in the solver, restarting it */
+      memcpy(data->simulationInfo->inputVars, state->inputVarsBackup, modelData->nInputVars * sizeof(double));
 
-    state->gotNewInput = 0;
-  }
+      state->gotNewInput = 0;
+    }
 
-  if (state->reinitStateFlag) {
-    res = 1; /* Trigger an event in the solver, restarting it */
-    for (i = 0; i < modelData->nStates; i++) {
-      if (state->stateWasUpdatedFlag[i]) {
-        state->stateWasUpdatedFlag[i] = 0;
-        (data->localData[0])->realVars[i] = state->updatedStates[i];
+    if (state->reinitStateFlag) {
+      res = 1; /* Trigger an event in the solver, restarting it */
+      for (i = 0; i < modelData->nStates; i++) {
+        if (state->stateWasUpdatedFlag[i]) {
+          state->stateWasUpdatedFlag[i] = 0;
+          (data->localData[0])->realVars[i] = state->updatedStates[i];
+        }
       }
+
+      state->reinitStateFlag = 0;
     }
 
-    state->reinitStateFlag = 0;
+    pthread_mutex_unlock(&state->write_values);
   }
 
-  if (state->terminate)
+  if (__atomic_load_n(&state->terminate, __ATOMIC_ACQUIRE))
     *terminate = 1;
 
-  pthread_mutex_unlock(&state->write_values);
-
   return res;
 }
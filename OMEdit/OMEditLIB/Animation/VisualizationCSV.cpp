@@ -35,14 +35,14 @@
 
 VisualizationCSV::VisualizationCSV(const std::string& modelFile, const std::string& path)
   : VisualizationAbstract(modelFile, path, VisType::CSV),
-    mpCSVData(nullptr)
+    mpCSVReader(nullptr)
 {
 }
 
 VisualizationCSV::~VisualizationCSV()
 {
-  if (mpCSVData) {
-    omc_free_csv_reader(mpCSVData);
+  if (mpCSVReader) {
+    read_csv_close(mpCSVReader);
   }
 }
 
@@ -50,10 +50,10 @@ void VisualizationCSV::initData()
 {
   VisualizationAbstract::initData();
   readCSV(mpOMVisualBase->getModelFile(), mpOMVisualBase->getPath());
-  double *time = read_csv_dataset(mpCSVData, "time");
-  if (time) {
+  double *time = mpCSVReader ? read_csv_column(mpCSVReader, "time") : nullptr;
+  if (time && read_csv_numsteps(mpCSVReader) > 0) {
     mpTimeManager->setStartTime(time[0]);
-    mpTimeManager->setEndTime(time[mpCSVData->numsteps - 1]);
+    mpTimeManager->setEndTime(time[read_csv_numsteps(mpCSVReader) - 1]);
   }
 }
 
@@ -76,10 +76,10 @@ void VisualizationCSV::readCSV(const std::string& modelFile, const std::string&
     MessagesWidget::instance()->addGUIMessage(MessageItem(MessageItem::Modelica, QString(QObject::tr("Could not find CSV file %1."))
                                                           .arg(resFileName.c_str()), Helper::scriptingKind, Helper::errorLevel));
   } else {
-    // Read mat file.
-    mpCSVData = read_csv(resFileName.c_str());
+    // Read only the header of the CSV file, the columns of the visualizers are read on demand in omcGetVarValue.
+    mpCSVReader = read_csv_open(resFileName.c_str());
     // Check return value.
-    if (!mpCSVData) {
+    if (!mpCSVReader) {
       MessagesWidget::instance()->addGUIMessage(MessageItem(MessageItem::Modelica, QString(QObject::tr("Could not read CSV file %1."))
                                                             .arg(resFileName.c_str()), Helper::scriptingKind, Helper::errorLevel));
     }
@@ -110,10 +110,14 @@ void VisualizationCSV::updateVisualizerAttributeCSV(VisualizerAttribute& attr, c
 
 double VisualizationCSV::omcGetVarValue(const char* varName, const double time)
 {
-  double *timeDataSet = read_csv_dataset(mpCSVData, "time");
-  for (int i = 0 ; i < mpCSVData->numsteps ; i++) {
+  double *timeDataSet = mpCSVReader ? read_csv_column(mpCSVReader, "time") : nullptr;
+  if (!timeDataSet) {
+    return 0.0;
+  }
+  const int numsteps = read_csv_numsteps(mpCSVReader);
+  for (int i = 0 ; i < numsteps ; i++) {
     if (timeDataSet[i] == time) {
-      double *varDataSet = read_csv_dataset(mpCSVData, varName);
+      double *varDataSet = read_csv_column(mpCSVReader, varName);
       if (varDataSet) {
         return varDataSet[i];
       } else {
@@ -121,8 +125,8 @@ double VisualizationCSV::omcGetVarValue(const char* varName, const double time)
                                                               QString(QObject::tr("Did not get variable from result file. Variable name is %1."))
                                                               .arg(varName), Helper::scriptingKind, Helper::errorLevel));
       }
-    } else if ((time > timeDataSet[i]) && (i + 1 < mpCSVData->numsteps) && (time < timeDataSet[i + 1])) { // interpolate
-      double *varDataSet = read_csv_dataset(mpCSVData, varName);
+    } else if ((time > timeDataSet[i]) && (i + 1 < numsteps) && (time < timeDataSet[i + 1])) { // interpolate
+      double *varDataSet = read_csv_column(mpCSVReader, varName);
       if (varDataSet) {
         return (varDataSet[i] + varDataSet[i + 1]) / 2;
       } else {
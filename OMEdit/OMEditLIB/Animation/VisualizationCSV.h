@@ -54,7 +54,7 @@ public:
   void updateVisualizerAttributeCSV(VisualizerAttribute& attr, const double time);
   double omcGetVarValue(const char* varName, const double time);
 private:
-  csv_data *mpCSVData;
+  csv_reader *mpCSVReader;
 };
 
 #endif // VISUALIZATIONCSV_H
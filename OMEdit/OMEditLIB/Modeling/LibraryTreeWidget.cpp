@@ -2361,6 +2361,8 @@ void LibraryTreeModel::createLibraryTreeItems(LibraryTreeItem *pLibraryTreeItem)
     if (!libs.isEmpty()) {
       libs.removeFirst();
     }
+    // fetch the class information of all the nested classes at once instead of once per LibraryTreeItem.
+    pOMCProxy->prefetchClassInformation(libs);
     LibraryTreeItem *pParentLibraryTreeItem = 0;
     foreach (QString lib, libs) {
       /* $Code is a special OpenModelica keyword. No API command will work if we use it. */
@@ -2376,6 +2378,7 @@ void LibraryTreeModel::createLibraryTreeItems(LibraryTreeItem *pLibraryTreeItem)
         createLibraryTreeItemImpl(name, pParentLibraryTreeItem, pParentLibraryTreeItem->isSaved(), false, false, -1, pParentLibraryTreeItem->isAccessAnnotationsEnabled());
       }
     }
+    pOMCProxy->clearClassInformationCache();
   } else if (pLibraryTreeItem->getLibraryType() == LibraryTreeItem::OMS) {
     // we only call oms_getElements on the model
     if (pLibraryTreeItem->isTopLevel()) {
@@ -55,6 +55,8 @@ void omc_Main_setWindowsPaths(threadData_t *threadData, void* _inOMHome);
 }
 
 #include <QMessageBox>
+#include <QJsonArray>
+#include <QJsonDocument>
 #include <QStringBuilder>
 
 /*!
@@ -586,22 +588,31 @@ QString OMCProxy::getErrorString(bool warningsAsErrors)
 bool OMCProxy::printMessagesStringInternal()
 {
   MainWindow::instance()->printStandardOutAndErrorFilesMessages();
-  // read errors
-  int errorsSize = getMessagesStringInternal();
-  bool returnValue = errorsSize > 0 ? true : false;
-
-  /* Loop in reverse order since getMessagesStringInternal returns error messages in reverse order. */
-  for (int i = errorsSize; i > 0 ; i--) {
-    setCurrentError(i);
-    const int errorId = getErrorId();
+  // getMessagesJSON() is quite slow, check if there are any messages first.
+  auto res = mpOMCInterface->countMessages();
+  if (!(res.numMessages || res.numErrors || res.numWarnings)) {
+    return false;
+  }
+  // read all errors with one call instead of querying each field of each error.
+  const QJsonArray errors = QJsonDocument::fromJson(mpOMCInterface->getMessagesJSON(true).toUtf8()).array();
+  /* Loop in reverse order since getMessagesJSON returns error messages in reverse order. */
+  for (int i = errors.size() - 1; i >= 0 ; i--) {
+    const QJsonObject error = errors.at(i).toObject();
+    const int errorId = error.value("id").toInt();
     if (errorId == 371 || errorId == 372 || errorId == 373) {
       mLoadModelError = true;
     }
-    MessageItem messageItem(MessageItem::Modelica, getErrorFileName(), getErrorReadOnly(), getErrorLineStart(), getErrorColumnStart(), getErrorLineEnd(),
-                            getErrorColumnEnd(), getErrorMessage(), getErrorKind(), getErrorLevel());
+    QString fileName = error.value("filename").toString();
+    if (fileName.compare("<interactive>") == 0) {
+      fileName = "";
+    }
+    MessageItem messageItem(MessageItem::Modelica, fileName, error.value("readonly").toBool(), error.value("lineStart").toInt(),
+                            error.value("columnStart").toInt(), error.value("lineEnd").toInt(), error.value("columnEnd").toInt(),
+                            error.value("message").toString(), ".OpenModelica.Scripting.ErrorKind." + error.value("kind").toString(),
+                            ".OpenModelica.Scripting.ErrorLevel." + error.value("level").toString());
     MessagesWidget::instance()->addGUIMessage(messageItem);
   }
-  return returnValue;
+  return !errors.isEmpty();
 }
 
 /*!
@@ -835,7 +846,15 @@ QStringList OMCProxy::searchClassNames(QString searchText, bool findInText)
   */
 OMCInterface::getClassInformation_res OMCProxy::getClassInformation(QString className)
 {
-  OMCInterface::getClassInformation_res classInformation = mpOMCInterface->getClassInformation(className);
+  OMCInterface::getClassInformation_res classInformation;
+  // use the prefetched information if available. It is used only once since the class might change afterwards.
+  auto it = mClassInformationCache.find(className);
+  if (it != mClassInformationCache.end()) {
+    classInformation = it.value();
+    mClassInformationCache.erase(it);
+  } else {
+    classInformation = mpOMCInterface->getClassInformation(className);
+  }
   QString comment = classInformation.comment.replace("\\\"", "\"");
   comment = makeDocumentationUriToFileName(comment);
   // since tooltips can't handle file:// scheme so we have to remove it in order to display images and make links work.
@@ -848,6 +867,51 @@ OMCInterface::getClassInformation_res OMCProxy::getClassInformation(QString clas
   return classInformation;
 }
 
+/*!
+ * \brief OMCProxy::prefetchClassInformation
+ * Fetches the information of many classes with the getClassInformationJSON API and caches it.
+ * The following getClassInformation calls for these classes are then answered from the cache
+ * instead of calling omc once per class.
+ * \param classNames
+ */
+void OMCProxy::prefetchClassInformation(const QStringList &classNames)
+{
+  // fetch in chunks to keep the size of the commands and results reasonable.
+  const int chunkSize = 1000;
+  for (int i = 0 ; i < classNames.size() ; i += chunkSize) {
+    const QJsonObject classes = QJsonDocument::fromJson(mpOMCInterface->getClassInformationJSON(classNames.mid(i, chunkSize), false).toUtf8()).object();
+    for (auto it = classes.constBegin() ; it != classes.constEnd() ; ++it) {
+      const QJsonObject info = it.value().toObject();
+      OMCInterface::getClassInformation_res classInformation;
+      classInformation.restriction = info.value("restriction").toString();
+      classInformation.comment = info.value("comment").toString();
+      classInformation.partialPrefix = info.value("partialPrefix").toBool();
+      classInformation.finalPrefix = info.value("finalPrefix").toBool();
+      classInformation.encapsulatedPrefix = info.value("encapsulatedPrefix").toBool();
+      classInformation.fileName = info.value("fileName").toString();
+      classInformation.fileReadOnly = info.value("fileReadOnly").toBool();
+      classInformation.lineNumberStart = info.value("lineNumberStart").toInt();
+      classInformation.columnNumberStart = info.value("columnNumberStart").toInt();
+      classInformation.lineNumberEnd = info.value("lineNumberEnd").toInt();
+      classInformation.columnNumberEnd = info.value("columnNumberEnd").toInt();
+      foreach (const QJsonValue &dimension, info.value("dimensions").toArray()) {
+        classInformation.dimensions.append(dimension.toString());
+      }
+      classInformation.isProtectedClass = info.value("isProtectedClass").toBool();
+      classInformation.isDocumentationClass = info.value("isDocumentationClass").toBool();
+      classInformation.version = info.value("version").toString();
+      classInformation.preferredView = info.value("preferredView").toString();
+      classInformation.state = info.value("state").toBool();
+      classInformation.access = info.value("access").toString();
+      classInformation.versionDate = info.value("versionDate").toString();
+      classInformation.versionBuild = info.value("versionBuild").toString();
+      classInformation.dateModified = info.value("dateModified").toString();
+      classInformation.revisionId = info.value("revisionId").toString();
+      mClassInformationCache.insert(it.key(), classInformation);
+    }
+  }
+}
+
 /*!
   Checks whether the class is a package or not.
   \param className - is the name of the class which is checked.
@@ -84,6 +84,7 @@ private:
   QStringList mLibrariesBrowserAdditionCommandsList;
   QStringList mLibrariesBrowserDeletionCommandsList;
   bool mLoadModelError;
+  QHash<QString, OMCInterface::getClassInformation_res> mClassInformationCache;
 public:
   OMCProxy(threadData_t *threadData, QWidget *pParent = 0);
   ~OMCProxy();
@@ -121,6 +122,8 @@ public:
                             bool sort = false, bool builtin = false, bool showProtected = true, bool includeConstants = false);
   QStringList searchClassNames(QString searchText, bool findInText = false);
   OMCInterface::getClassInformation_res getClassInformation(QString className);
+  void prefetchClassInformation(const QStringList &classNames);
+  void clearClassInformationCache() {mClassInformationCache.clear();}
   bool isPackage(QString className);
   bool isBuiltinType(QString typeName);
   QString getBuiltinType(QString typeName);
@@ -1504,7 +1504,7 @@ VariablesWidget::VariablesWidget(QWidget *pParent)
   mpVariablesTreeView->setColumnHidden(2, true); // hide Unit column
   mpLastActiveSubWindow = 0;
   mModelicaMatReader.file = 0;
-  mpCSVData = 0;
+  mpCSVReader = 0;
   // create the layout
   QGridLayout *pMainLayout = new QGridLayout;
   pMainLayout->setContentsMargins(0, 0, 0, 0);
@@ -1885,12 +1885,13 @@ double VariablesWidget::readVariableValue(QString variable, double time)
       found = true;
     } else {
     }
-  } else if (mpCSVData) {
-    double *timeDataSet = read_csv_dataset(mpCSVData, "time");
+  } else if (mpCSVReader) {
+    // the column of the variable is read on demand
+    double *timeDataSet = read_csv_column(mpCSVReader, "time");
     if (timeDataSet) {
-      for (int i = 0 ; i < mpCSVData->numsteps ; i++) {
+      for (int i = 0 ; i < read_csv_numsteps(mpCSVReader) ; i++) {
         if (QString::number(timeDataSet[i]).compare(QString::number(time)) == 0) {
-          double *varDataSet = read_csv_dataset(mpCSVData, variable.toUtf8().constData());
+          double *varDataSet = read_csv_column(mpCSVReader, variable.toUtf8().constData());
           if (varDataSet) {
             value = varDataSet[i];
             found = true;
@@ -2472,9 +2473,9 @@ void VariablesWidget::closeResultFile()
     omc_free_matlab4_reader(&mModelicaMatReader);
     mModelicaMatReader.file = 0;
   }
-  if (mpCSVData) {
-    omc_free_csv_reader(mpCSVData);
-    mpCSVData = 0;
+  if (mpCSVReader) {
+    read_csv_close(mpCSVReader);
+    mpCSVReader = 0;
   }
   if (mPlotFileReader.isOpen()) {
     mPlotFileReader.close();
@@ -2503,16 +2504,17 @@ void VariablesWidget::openResultFile(double &startTime, double &stopTime)
         errorString = msg[0];
       }
     } else if (mpVariablesTreeModel->getActiveVariablesTreeItem()->getFileName().endsWith(".csv")) {
-      mpCSVData = read_csv(fileName.toUtf8().constData());
-      if (mpCSVData) {
+      // read only the header and the time here, the other columns are read on demand in readVariableValue
+      mpCSVReader = read_csv_open(fileName.toUtf8().constData());
+      if (mpCSVReader) {
         //Read in timevector
-        double *timeVals = read_csv_dataset(mpCSVData, "time");
-        if (timeVals == NULL) {
+        double *timeVals = read_csv_column(mpCSVReader, "time");
+        if (timeVals == NULL || read_csv_numsteps(mpCSVReader) == 0) {
           errorOpeningFile = true;
           errorString = "Error reading time from CSV file.";
         } else {
           startTime = timeVals[0];
-          stopTime = timeVals[mpCSVData->numsteps-1];
+          stopTime = timeVals[read_csv_numsteps(mpCSVReader)-1];
         }
       } else {
         errorOpeningFile = true;
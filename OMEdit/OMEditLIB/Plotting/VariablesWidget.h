@@ -259,7 +259,7 @@ private:
   QHash<QString, QList<QString>> mSelectedInteractiveVariables;
   QMdiSubWindow *mpLastActiveSubWindow;
   ModelicaMatReader mModelicaMatReader;
-  csv_data *mpCSVData;
+  csv_reader *mpCSVReader;
   QFile mPlotFileReader;
   void selectInteractivePlotWindow(VariablesTreeItem *pVariablesTreeItem);
   void openResultFile(double &startTime, double &stopTime);
@@ -38,12 +38,22 @@
 #include "qwt_painter.h"
 #endif
 #include "qwt_symbol.h"
+#if QWT_VERSION >= 0x060000
+#include "qwt_clipper.h"
+#endif
 
 using namespace OMPlot;
 
+/* Number of samples covered by a level 0 bucket of the level of detail pyramid. */
+#define LOD_BASE 8
+/* Number of buckets of a level combined into one bucket of the next level. */
+#define LOD_FACTOR 4
+/* Curves with less samples are drawn and picked without the pyramid. */
+#define LOD_MIN_SAMPLES 4096
+
 PlotCurve::PlotCurve(const QString &fileName, const QString &absoluteFilePath, const QString &xVariableName, const QString &xUnit, const QString &xDisplayUnit,
                      const QString &yVariableName, const QString &yUnit, const QString &yDisplayUnit, Plot *pParent)
-  : mCustomColor(false)
+  : mCustomColor(false), mLodSize(0), mMonotoneX(true)
 {
   mpParentPlot = pParent;
   mXVariable = xVariableName;
@@ -160,6 +170,7 @@ void PlotCurve::setCurveStyle(int style)
 void PlotCurve::setXAxisVector(QVector<double> vector)
 {
   mXAxisVector = vector;
+  invalidateLevelOfDetail();
 }
 
 void PlotCurve::addXAxisValue(double value)
@@ -170,6 +181,7 @@ void PlotCurve::addXAxisValue(double value)
 void PlotCurve::updateXAxisValue(int index, double value)
 {
   mXAxisVector.replace(index, value);
+  invalidateLevelOfDetail(index);
 }
 
 const double* PlotCurve::getXAxisVector() const
@@ -185,6 +197,7 @@ QPair<QVector<double>*, QVector<double>*> PlotCurve::getAxisVectors()
 void PlotCurve::setYAxisVector(QVector<double> vector)
 {
   mYAxisVector = vector;
+  invalidateLevelOfDetail();
 }
 
 void PlotCurve::addYAxisValue(double value)
@@ -195,6 +208,7 @@ void PlotCurve::addYAxisValue(double value)
 void PlotCurve::updateYAxisValue(int index, double value)
 {
   mYAxisVector.replace(index, value);
+  invalidateLevelOfDetail(index);
 }
 
 const double* PlotCurve::getYAxisVector() const
@@ -273,6 +287,150 @@ void PlotCurve::setData(const double* xData, const double* yData, int size)
 #else
   setRawData(xData, yData, size);
 #endif
+  invalidateLevelOfDetail();
+}
+
+/*!
+ * \brief PlotCurve::invalidateLevelOfDetail
+ * Marks the level of detail pyramid as outdated starting from sample from.
+ * Samples appended to the curve data are picked up automatically.
+ * \param from
+ */
+void PlotCurve::invalidateLevelOfDetail(int from)
+{
+  mLodSize = qMax(0, qMin(mLodSize, from));
+}
+
+/*!
+ * \brief PlotCurve::updateLevelOfDetail
+ * Updates the min/max level of detail pyramid for the samples added or changed since the last update.
+ * Only the buckets from the first changed sample onwards are recomputed.
+ * The pyramid is only built for curves with a monotone x axis.
+ */
+void PlotCurve::updateLevelOfDetail() const
+{
+  const int numSamples = (int)dataSize();
+  if (numSamples < mLodSize) {
+    mLodSize = 0;
+  }
+  if (numSamples == mLodSize) {
+    return;
+  }
+  const QwtSeriesData<QPointF> *series = data();
+  int start = mLodSize;
+  if (start == 0) {
+    mMonotoneX = true;
+    mLodLevels.clear();
+  }
+  // check the new samples for a monotone x axis
+  for (int i = qMax(start, 1); mMonotoneX && i < numSamples; i++) {
+    if (series->sample(i).x() < series->sample(i - 1).x()) {
+      mMonotoneX = false;
+    }
+  }
+  mLodSize = numSamples;
+  if (!mMonotoneX || numSamples < LOD_MIN_SAMPLES) {
+    mLodLevels.clear();
+    return;
+  }
+  if (mLodLevels.isEmpty()) {
+    start = 0;
+  }
+  // level 0 from the samples
+  int firstBucket = start / LOD_BASE;
+  if (mLodLevels.isEmpty()) {
+    mLodLevels.append(QVector<LodBucket>());
+  }
+  QVector<LodBucket> &level0 = mLodLevels[0];
+  level0.resize((numSamples + LOD_BASE - 1) / LOD_BASE);
+  for (int b = firstBucket; b < level0.size(); b++) {
+    LodBucket &bucket = level0[b];
+    const int end = qMin(numSamples, (b + 1) * LOD_BASE);
+    bucket.mMinIndex = bucket.mMaxIndex = b * LOD_BASE;
+    bucket.mMin = bucket.mMax = series->sample(b * LOD_BASE).y();
+    for (int i = b * LOD_BASE + 1; i < end; i++) {
+      const double y = series->sample(i).y();
+      if (y < bucket.mMin) {
+        bucket.mMin = y;
+        bucket.mMinIndex = i;
+      }
+      if (y > bucket.mMax) {
+        bucket.mMax = y;
+        bucket.mMaxIndex = i;
+      }
+    }
+  }
+  // higher levels from the level below
+  for (int l = 1; mLodLevels[l - 1].size() > 1; l++) {
+    firstBucket /= LOD_FACTOR;
+    if (mLodLevels.size() <= l) {
+      mLodLevels.append(QVector<LodBucket>());
+    }
+    const QVector<LodBucket> &lower = mLodLevels[l - 1];
+    QVector<LodBucket> &level = mLodLevels[l];
+    level.resize((lower.size() + LOD_FACTOR - 1) / LOD_FACTOR);
+    for (int b = firstBucket; b < level.size(); b++) {
+      LodBucket &bucket = level[b];
+      const int end = qMin(lower.size(), (b + 1) * LOD_FACTOR);
+      bucket = lower[b * LOD_FACTOR];
+      for (int c = b * LOD_FACTOR + 1; c < end; c++) {
+        if (lower[c].mMin < bucket.mMin) {
+          bucket.mMin = lower[c].mMin;
+          bucket.mMinIndex = lower[c].mMinIndex;
+        }
+        if (lower[c].mMax > bucket.mMax) {
+          bucket.mMax = lower[c].mMax;
+          bucket.mMaxIndex = lower[c].mMaxIndex;
+        }
+      }
+    }
+  }
+}
+
+/*!
+ * \brief PlotCurve::lowerBoundIndex
+ * Binary search for the first sample in [from, to] with an x value not less than x.
+ * Requires a monotone x axis.
+ * \param x
+ * \param from
+ * \param to
+ * \return the index, to + 1 if all samples are less than x.
+ */
+int PlotCurve::lowerBoundIndex(double x, int from, int to) const
+{
+  const QwtSeriesData<QPointF> *series = data();
+  int lo = from, hi = to + 1;
+  while (lo < hi) {
+    const int mid = lo + (hi - lo) / 2;
+    if (series->sample(mid).x() < x) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+/*!
+ * \brief PlotCurve::visibleRange
+ * Restricts [from, to] to the samples inside the visible x interval plus one sample on each side.
+ * \param xMap
+ * \param from
+ * \param to
+ * \return false if the x axis is not monotone and the range is unchanged.
+ */
+bool PlotCurve::visibleRange(const QwtScaleMap &xMap, int &from, int &to) const
+{
+  if (!mMonotoneX || to - from < LOD_MIN_SAMPLES) {
+    return false;
+  }
+  const double x1 = qMin(xMap.s1(), xMap.s2());
+  const double x2 = qMax(xMap.s1(), xMap.s2());
+  const int first = lowerBoundIndex(x1, from, to) - 1;
+  const int last = lowerBoundIndex(x2, from, to);
+  from = qMax(from, first);
+  to = qMin(to, last);
+  return true;
 }
 
 #if QWT_VERSION < 0x060000
@@ -293,6 +451,9 @@ void PlotCurve::updateLegend(QwtLegend *legend) const
  * \brief QwtPlotCurve::closestPoint
  * Reimplentation of QwtPlotCurve::closestPoint()
  * Just doesn't fail if first time f < dmin instead we use the first f value to initialize dmin.
+ * For curves with a monotone x axis the search starts at the sample found by binary search and walks outwards
+ * until the horizontal distance alone exceeds the best distance. Buckets of the level of detail pyramid that
+ * can not contain a closer sample are skipped.
  * \param pos
  * \param dist
  * \return
@@ -311,6 +472,87 @@ int PlotCurve::closestPoint(const QPoint &pos, double *dist) const
   int index = -1;
   double dmin = 1.0e10;
 
+  updateLevelOfDetail();
+  if (mMonotoneX && !mLodLevels.isEmpty()) {
+    const int last = (int)numSamples - 1;
+    const int start = qMin(lowerBoundIndex(xMap.invTransform(pos.x()), 0, last), last);
+    // squared pixel distance of sample i
+    auto distance = [&](int i) {
+      const QPointF sample = series->sample(i);
+      return qwtSqr(xMap.transform(sample.x()) - pos.x()) + qwtSqr(yMap.transform(sample.y()) - pos.y());
+    };
+    // lower bound of the squared pixel distance of all samples in the bucket, nearest x given
+    auto bucketDistance = [&](const LodBucket &bucket, double x) {
+      const double y1 = yMap.transform(bucket.mMin);
+      const double y2 = yMap.transform(bucket.mMax);
+      double dy = 0.0;
+      if (pos.y() < qMin(y1, y2)) {
+        dy = qMin(y1, y2) - pos.y();
+      } else if (pos.y() > qMax(y1, y2)) {
+        dy = pos.y() - qMax(y1, y2);
+      }
+      return qwtSqr(xMap.transform(x) - pos.x()) + qwtSqr(dy);
+    };
+    index = start;
+    dmin = distance(start);
+    // walk to the right
+    for (int i = start + 1; i <= last;) {
+      if (qwtSqr(xMap.transform(series->sample(i).x()) - pos.x()) >= dmin) {
+        break;
+      }
+      int skip = 0;
+      if (i % LOD_BASE == 0) {
+        int size = LOD_BASE;
+        for (int l = 0; l < mLodLevels.size() && i % size == 0 && i + size - 1 <= last; l++, size *= LOD_FACTOR) {
+          if (bucketDistance(mLodLevels.at(l).at(i / size), series->sample(i).x()) < dmin) {
+            break;
+          }
+          skip = size;
+        }
+      }
+      if (skip > 0) {
+        i += skip;
+      } else {
+        const double f = distance(i);
+        if (f < dmin) {
+          index = i;
+          dmin = f;
+        }
+        i++;
+      }
+    }
+    // walk to the left
+    for (int i = start - 1; i >= 0;) {
+      if (qwtSqr(xMap.transform(series->sample(i).x()) - pos.x()) >= dmin) {
+        break;
+      }
+      int skip = 0;
+      if ((i + 1) % LOD_BASE == 0) {
+        int size = LOD_BASE;
+        for (int l = 0; l < mLodLevels.size() && (i + 1) % size == 0; l++, size *= LOD_FACTOR) {
+          if (bucketDistance(mLodLevels.at(l).at((i + 1) / size - 1), series->sample(i).x()) < dmin) {
+            break;
+          }
+          skip = size;
+        }
+      }
+      if (skip > 0) {
+        i -= skip;
+      } else {
+        const double f = distance(i);
+        if (f < dmin) {
+          index = i;
+          dmin = f;
+        }
+        i--;
+      }
+    }
+    if (dist) {
+      *dist = qSqrt(dmin);
+    }
+    return index;
+  }
+
   for (uint i = 0; i < numSamples; i++) {
     const QPointF sample = series->sample( i );
 
@@ -330,6 +572,89 @@ int PlotCurve::closestPoint(const QPoint &pos, double *dist) const
   return index;
 }
 
+#if QWT_VERSION >= 0x060000
+/*!
+ * \brief PlotCurve::drawSeries
+ * Reimplementation of QwtPlotCurve::drawSeries()
+ * Only draws the samples inside the visible x interval if the x axis is monotone.
+ * \param painter
+ * \param xMap
+ * \param yMap
+ * \param canvasRect
+ * \param from
+ * \param to
+ */
+void PlotCurve::drawSeries(QPainter *painter, const QwtScaleMap &xMap, const QwtScaleMap &yMap, const QRectF &canvasRect, int from, int to) const
+{
+  if (to < 0) {
+    to = (int)dataSize() - 1;
+  }
+  updateLevelOfDetail();
+  visibleRange(xMap, from, to);
+  QwtPlotCurve::drawSeries(painter, xMap, yMap, canvasRect, from, to);
+}
+
+/*!
+ * \brief PlotCurve::drawLines
+ * Reimplementation of QwtPlotCurve::drawLines()
+ * If there are many samples per pixel the curve is drawn from the min/max buckets of the level of detail pyramid.
+ * The buckets are at most half a pixel wide, so the drawn polyline looks the same as the full one.
+ * \param painter
+ * \param xMap
+ * \param yMap
+ * \param canvasRect
+ * \param from
+ * \param to
+ */
+void PlotCurve::drawLines(QPainter *painter, const QwtScaleMap &xMap, const QwtScaleMap &yMap, const QRectF &canvasRect, int from, int to) const
+{
+  const double samplesPerPixel = (to - from + 1) / qMax(1.0, canvasRect.width());
+  if (!mMonotoneX || mLodLevels.isEmpty() || testCurveAttribute(QwtPlotCurve::Fitted) || brush().style() != Qt::NoBrush
+      || samplesPerPixel < 2 * LOD_BASE) {
+    QwtPlotCurve::drawLines(painter, xMap, yMap, canvasRect, from, to);
+    return;
+  }
+  // the coarsest level with at least two buckets per pixel
+  int level = 0, size = LOD_BASE;
+  while (level + 1 < mLodLevels.size() && 2 * size * LOD_FACTOR <= samplesPerPixel) {
+    level++;
+    size *= LOD_FACTOR;
+  }
+  const QVector<LodBucket> &buckets = mLodLevels.at(level);
+  const QwtSeriesData<QPointF> *series = data();
+  QPolygonF polyline;
+  polyline.reserve(4 * qCeil(canvasRect.width()) + 2 * size + 2);
+  auto addSample = [&](int i) {
+    const QPointF sample = series->sample(i);
+    polyline.append(QPointF(xMap.transform(sample.x()), yMap.transform(sample.y())));
+  };
+  // samples before the first complete bucket
+  int b = (from + size - 1) / size;
+  int i = from;
+  for (; i < qMin(b * size, to + 1); i++) {
+    addSample(i);
+  }
+  // complete buckets, min and max in sample order
+  for (; b < buckets.size() && (b + 1) * size - 1 <= to; b++) {
+    const LodBucket &bucket = buckets[b];
+    addSample(qMin(bucket.mMinIndex, bucket.mMaxIndex));
+    if (bucket.mMinIndex != bucket.mMaxIndex) {
+      addSample(qMax(bucket.mMinIndex, bucket.mMaxIndex));
+    }
+    i = (b + 1) * size;
+  }
+  // remaining samples
+  for (; i <= to; i++) {
+    addSample(i);
+  }
+  if (testPaintAttribute(QwtPlotCurve::ClipPolygons)) {
+    const qreal pw = qMax(qreal(1.0), painter->pen().widthF());
+    polyline = QwtClipper::clipPolygonF(canvasRect.adjusted(-pw, -pw, pw, pw), polyline, false);
+  }
+  QwtPainter::drawPolyline(painter, polyline);
+}
+#endif
+
 /*!
  * \brief PlotCurve::boundingRect
  * Reimplentation of QwtPlotCurve::boundingRect() to add a margin.
@@ -60,6 +60,22 @@ private:
   Plot *mpParentPlot;
   QwtPlotDirectPainter *mpPlotDirectPainter;
   QwtPlotMarker *mpPointMarker;
+  /* Level of detail pyramid. Each bucket holds the min and max sample of a range of samples.
+   * Level 0 buckets cover LOD_BASE samples, each further level combines LOD_FACTOR buckets of the level below.
+   */
+  struct LodBucket {
+    double mMin;
+    double mMax;
+    int mMinIndex;
+    int mMaxIndex;
+  };
+  mutable QVector<QVector<LodBucket> > mLodLevels;
+  mutable int mLodSize;
+  mutable bool mMonotoneX;
+
+  void updateLevelOfDetail() const;
+  int lowerBoundIndex(double x, int from, int to) const;
+  bool visibleRange(const QwtScaleMap &xMap, int &from, int &to) const;
 public:
   PlotCurve(const QString &fileName, const QString &absoluteFilePath, const QString &xVariableName, const QString &xUnit, const QString &xDisplayUnit,
             const QString &yVariableName, const QString &yUnit, const QString &yDisplayUnit, Plot *pParent);
@@ -91,12 +107,12 @@ public:
   void updateXAxisValue(int index, double value);
   const double* getXAxisVector() const;
   QPair<QVector<double>*, QVector<double>*> getAxisVectors();
-  void clearXAxisVector() {mXAxisVector.clear();}
+  void clearXAxisVector() {mXAxisVector.clear(); invalidateLevelOfDetail();}
   void setYAxisVector(QVector<double> vector);
   void addYAxisValue(double value);
   void updateYAxisValue(int index, double value);
   const double* getYAxisVector() const;
-  void clearYAxisVector() {mYAxisVector.clear();}
+  void clearYAxisVector() {mYAxisVector.clear(); invalidateLevelOfDetail();}
   int getSize();
   void setFileName(QString fileName);
   QString getFileName() const;
@@ -111,6 +127,7 @@ public:
   bool hasCustomColor();
   void toggleVisibility(bool visibility);
   void setData(const double* xData, const double* yData, int size);
+  void invalidateLevelOfDetail(int from = 0);
   QwtPlotDirectPainter* getPlotDirectPainter() {return mpPlotDirectPainter;}
   QwtPlotMarker* getPointMarker() const {return mpPointMarker;}
 #if QWT_VERSION < 0x060000
@@ -121,6 +138,11 @@ public:
   // QwtPlotItem interface
 public:
   virtual QRectF boundingRect() const override;
+#if QWT_VERSION >= 0x060000
+  virtual void drawSeries(QPainter *painter, const QwtScaleMap &xMap, const QwtScaleMap &yMap, const QRectF &canvasRect, int from, int to) const override;
+protected:
+  virtual void drawLines(QPainter *painter, const QwtScaleMap &xMap, const QwtScaleMap &yMap, const QRectF &canvasRect, int from, int to) const override;
+#endif
 };
 }
 
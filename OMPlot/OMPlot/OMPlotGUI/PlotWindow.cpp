@@ -33,6 +33,7 @@
 
 #include <iostream>
 #include <memory>
+#include <vector>
 
 #include <QtSvg/QSvgGenerator>
 #include "PlotWindow.h"
@@ -48,6 +49,61 @@
 
 using namespace OMPlot;
 
+/*!
+ * \brief readCSVColumns
+ * Reads only the given columns of the csv file. An empty list reads all the columns.
+ * \param fileName
+ * \param columns
+ * \return the csv data or NULL if the file can't be read.
+ */
+static struct csv_data* readCSVColumns(const QString &fileName, const QStringList &columns)
+{
+  if (columns.isEmpty()) {
+    return read_csv(fileName.toStdString().c_str());
+  }
+  QList<QByteArray> names;
+  std::vector<const char*> vars;
+  foreach (QString column, columns) {
+    names.append(column.toUtf8());
+  }
+  for (int i = 0; i < names.size(); i++) {
+    vars.push_back(names.at(i).constData());
+  }
+  return read_csv_columns(fileName.toStdString().c_str(), vars.size(), vars.data(), 0);
+}
+
+/*!
+ * \brief arrayElementColumns
+ * Returns the time column and the columns of the elements of the given array variables, e.g., x[1], x[2] for x and der(x[1]) for der(x).
+ * \param fileName
+ * \param variables
+ * \return
+ */
+static QStringList arrayElementColumns(const QString &fileName, const QStringList &variables)
+{
+  QStringList columns, prefixes;
+  columns << "time";
+  foreach (QString variable, variables) {
+    if (QRegExp("der\\(\\D(\\w)*\\)").exactMatch(variable)) {
+      variable.chop(1);
+    }
+    prefixes << variable + "[";
+  }
+  int numVars = 0;
+  char **header = read_csv_column_names(fileName.toStdString().c_str(), &numVars);
+  for (int i = 0; i < numVars; i++) {
+    QString name = QString::fromUtf8(header[i]);
+    foreach (QString prefix, prefixes) {
+      if (name.startsWith(prefix)) {
+        columns << name;
+        break;
+      }
+    }
+  }
+  omc_free_csv_column_names(header, numVars);
+  return columns;
+}
+
 PlotWindow::PlotWindow(QStringList arguments, QWidget *parent, bool isInteractiveSimulation)
   : QMainWindow(parent), mIsInteractiveSimulation(isInteractiveSimulation)
 {
@@ -238,7 +294,7 @@ void PlotWindow::getStartStopTime(double &start, double &stop){
   {
     /* open the file */
     struct csv_data *csvReader;
-    csvReader = read_csv(mFile.fileName().toStdString().c_str());
+    csvReader = readCSVColumns(mFile.fileName(), QStringList() << "time");
     if (csvReader == NULL) {
       throw NoVariableException("Variable doesnt exist: time");
     }
@@ -457,7 +513,11 @@ void PlotWindow::plot(PlotCurve *pPlotCurve)
     /* open the file */
     QStringList variablesPlotted;
     struct csv_data *csvReader;
-    csvReader = read_csv(mFile.fileName().toStdString().c_str());
+    if (getPlotType() == PlotWindow::PLOTALL) {
+      csvReader = readCSVColumns(mFile.fileName(), QStringList());
+    } else {
+      csvReader = readCSVColumns(mFile.fileName(), QStringList() << "time" << "lambda" << mVariablesList);
+    }
     if (csvReader == NULL)
       throw PlotException(tr("Failed to open simulation result file %1").arg(mFile.fileName()));
 
@@ -701,7 +761,7 @@ void PlotWindow::plotParametric(PlotCurve *pPlotCurve)
       /* open the file */
       QStringList variablesPlotted;
       struct csv_data *csvReader;
-      csvReader = read_csv(mFile.fileName().toStdString().c_str());
+      csvReader = readCSVColumns(mFile.fileName(), QStringList() << xVariable << yVariable);
       if (csvReader == NULL)
         throw PlotException(tr("Failed to open simulation result file %1").arg(mFile.fileName()));
 
@@ -994,7 +1054,7 @@ void PlotWindow::plotArray(double time, PlotCurve *pPlotCurve)
   {
     /* open the file */
     struct csv_data *csvReader;
-    csvReader = read_csv(mFile.fileName().toStdString().c_str());
+    csvReader = readCSVColumns(mFile.fileName(), arrayElementColumns(mFile.fileName(), mVariablesList));
     if (csvReader == NULL)
       throw PlotException(tr("Failed to open simulation result file %1").arg(mFile.fileName()));
     //Read in timevector
@@ -1211,7 +1271,7 @@ void PlotWindow::plotArrayParametric(double time, PlotCurve *pPlotCurve)
     {
       /* open the file */
       struct csv_data *csvReader;
-      csvReader = read_csv(mFile.fileName().toStdString().c_str());
+      csvReader = readCSVColumns(mFile.fileName(), arrayElementColumns(mFile.fileName(), QStringList() << xVariable << yVariable));
       if (csvReader == NULL)
         throw PlotException(tr("Failed to open simulation result file %1").arg(mFile.fileName()));
       //Read in timevector
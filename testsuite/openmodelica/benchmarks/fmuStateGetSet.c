@@ -0,0 +1,156 @@
+/*
+ * Benchmark of the FMU state functions of an OpenModelica co-simulation FMU.
+ *
+ *   fmuStateGetSet <extracted fmu directory> <model identifier> <iterations>
+ *
+ * Emulates a master doing rollback-based step rejection: every macro step
+ * takes a snapshot, performs the step, rolls back and repeats the step.
+ */
+
+#include <dlfcn.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "fmi2Functions.h"
+
+static void logger(fmi2ComponentEnvironment env, fmi2String instanceName, fmi2Status status, fmi2String category, fmi2String message, ...)
+{
+  va_list args;
+  if (status == fmi2OK) return;
+  va_start(args, message);
+  vfprintf(stderr, message, args);
+  fprintf(stderr, "\n");
+  va_end(args);
+}
+
+static double now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + 1e-9*ts.tv_nsec;
+}
+
+static char* readGUID(const char *dir)
+{
+  static char guid[256];
+  char path[4096], buffer[65536], *start, *end;
+  size_t n;
+  FILE *file;
+
+  snprintf(path, sizeof(path), "%s/modelDescription.xml", dir);
+  file = fopen(path, "r");
+  if (!file) return NULL;
+  n = fread(buffer, 1, sizeof(buffer)-1, file);
+  fclose(file);
+  buffer[n] = '\0';
+  start = strstr(buffer, "guid=\"");
+  if (!start) return NULL;
+  start += 6;
+  end = strchr(start, '"');
+  if (!end || end-start >= (long) sizeof(guid)) return NULL;
+  memcpy(guid, start, end-start);
+  guid[end-start] = '\0';
+  return guid;
+}
+
+#define LOAD(name) name##TYPE *name = (name##TYPE*) dlsym(handle, #name); if (!name) { fprintf(stderr, "missing %s\n", #name); return 1; }
+
+int main(int argc, char **argv)
+{
+  char path[4096], resources[4096];
+  void *handle;
+  fmi2CallbackFunctions callbacks = {logger, calloc, free, NULL, NULL};
+  fmi2Component c;
+  fmi2FMUstate state = NULL;
+  fmi2Byte *buffer;
+  size_t size;
+  const char *guid;
+  double t = 0.0, h = 1e-3, t0, tGet = 0.0, tSet = 0.0, tFree = 0.0, tSerialize = 0.0, tDeSerialize = 0.0;
+  int i, iterations;
+
+  if (argc != 4) {
+    fprintf(stderr, "usage: %s <fmu directory> <model identifier> <iterations>\n", argv[0]);
+    return 1;
+  }
+  iterations = atoi(argv[3]);
+  snprintf(path, sizeof(path), "%s/binaries/linux64/%s.so", argv[1], argv[2]);
+  snprintf(resources, sizeof(resources), "file://%s/resources", argv[1]);
+  guid = readGUID(argv[1]);
+  handle = dlopen(path, RTLD_NOW|RTLD_LOCAL);
+  if (!handle || !guid) {
+    fprintf(stderr, "could not load %s\n", path);
+    return 1;
+  }
+
+  LOAD(fmi2Instantiate)
+  LOAD(fmi2SetupExperiment)
+  LOAD(fmi2EnterInitializationMode)
+  LOAD(fmi2ExitInitializationMode)
+  LOAD(fmi2DoStep)
+  LOAD(fmi2GetFMUstate)
+  LOAD(fmi2SetFMUstate)
+  LOAD(fmi2FreeFMUstate)
+  LOAD(fmi2SerializedFMUstateSize)
+  LOAD(fmi2SerializeFMUstate)
+  LOAD(fmi2DeSerializeFMUstate)
+  LOAD(fmi2Terminate)
+  LOAD(fmi2FreeInstance)
+
+  c = fmi2Instantiate("bench", fmi2CoSimulation, guid, resources, &callbacks, fmi2False, fmi2False);
+  if (!c) return 1;
+  fmi2SetupExperiment(c, fmi2False, 0.0, 0.0, fmi2False, 0.0);
+  fmi2EnterInitializationMode(c);
+  fmi2ExitInitializationMode(c);
+
+  for (i = 0; i < iterations; i++) {
+    t0 = now();
+    if (fmi2GetFMUstate(c, &state) != fmi2OK) return 1;
+    tGet += now() - t0;
+
+    fmi2DoStep(c, t, h, fmi2False);
+
+    /* reject the step */
+    t0 = now();
+    if (fmi2SetFMUstate(c, state) != fmi2OK) return 1;
+    tSet += now() - t0;
+
+    fmi2DoStep(c, t, h/2, fmi2False);
+    t += h/2;
+
+    t0 = now();
+    fmi2FreeFMUstate(c, &state);
+    tFree += now() - t0;
+  }
+
+  fmi2GetFMUstate(c, &state);
+  fmi2SerializedFMUstateSize(c, state, &size);
+  buffer = (fmi2Byte*) malloc(size);
+  for (i = 0; i < iterations; i++) {
+    fmi2FMUstate copy = NULL;
+    t0 = now();
+    fmi2SerializeFMUstate(c, state, buffer, size);
+    tSerialize += now() - t0;
+    t0 = now();
+    fmi2DeSerializeFMUstate(c, buffer, size, &copy);
+    tDeSerialize += now() - t0;
+    fmi2FreeFMUstate(c, &copy);
+  }
+  fmi2FreeFMUstate(c, &state);
+  free(buffer);
+
+  printf("iterations:        %d\n", iterations);
+  printf("serialized size:   %lu bytes\n", (unsigned long) size);
+  printf("fmi2GetFMUstate:   %.3f us\n", 1e6*tGet/iterations);
+  printf("fmi2SetFMUstate:   %.3f us\n", 1e6*tSet/iterations);
+  printf("fmi2FreeFMUstate:  %.3f us\n", 1e6*tFree/iterations);
+  printf("serialize:         %.3f us\n", 1e6*tSerialize/iterations);
+  printf("deserialize:       %.3f us\n", 1e6*tDeSerialize/iterations);
+
+  fmi2Terminate(c);
+  fmi2FreeInstance(c);
+  dlclose(handle);
+  return 0;
+}
@@ -0,0 +1,158 @@
+/*
+ * Checks fmi2GetFMUstate/fmi2SetFMUstate and the serialization of the FMU
+ * state of an OpenModelica co-simulation FMU.
+ *
+ *   fmuStateSerialize <extracted fmu directory> <model identifier>
+ *
+ * A rolled back step and a step from a deserialized state must give the
+ * same result as the original step. Truncated or damaged serialized states
+ * must be rejected with fmi2Error.
+ */
+
+#include <dlfcn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fmi2Functions.h"
+
+static void logger(fmi2ComponentEnvironment env, fmi2String instanceName, fmi2Status status, fmi2String category, fmi2String message, ...)
+{
+  /* the expected errors are checked through the return values */
+}
+
+static char* readGUID(const char *dir)
+{
+  static char guid[256];
+  char path[4096], buffer[65536], *start, *end;
+  size_t n;
+  FILE *file;
+
+  snprintf(path, sizeof(path), "%s/modelDescription.xml", dir);
+  file = fopen(path, "r");
+  if (!file) return NULL;
+  n = fread(buffer, 1, sizeof(buffer)-1, file);
+  fclose(file);
+  buffer[n] = '\0';
+  start = strstr(buffer, "guid=\"");
+  if (!start) return NULL;
+  start += 6;
+  end = strchr(start, '"');
+  if (!end || end-start >= (long) sizeof(guid)) return NULL;
+  memcpy(guid, start, end-start);
+  guid[end-start] = '\0';
+  return guid;
+}
+
+/* Offset of the terminating NUL of the first non-empty string in a serialized state, 0 if there is none */
+static size_t firstStringEnd(const fmi2Byte *buffer, size_t size)
+{
+  size_t dataSize, nStrings, strLen, i, offset = 2*sizeof(size_t);
+
+  memcpy(&dataSize, buffer, sizeof(size_t));
+  memcpy(&nStrings, buffer + sizeof(size_t), sizeof(size_t));
+  offset += dataSize;
+  for (i = 0; i < nStrings && offset + sizeof(size_t) <= size; i++) {
+    memcpy(&strLen, buffer + offset, sizeof(size_t));
+    offset += sizeof(size_t);
+    if (strLen > 0)
+      return offset + strLen - 1;
+  }
+  return 0;
+}
+
+#define LOAD(name) name##TYPE *name = (name##TYPE*) dlsym(handle, #name); if (!name) { fprintf(stderr, "missing %s\n", #name); return 1; }
+#define CHECK(msg, cond) printf("%s: %s\n", msg, (cond) ? "ok" : "failed")
+
+int main(int argc, char **argv)
+{
+  char path[4096], resources[4096];
+  void *handle;
+  fmi2CallbackFunctions callbacks = {logger, calloc, free, NULL, NULL};
+  fmi2Component c;
+  fmi2FMUstate state = NULL, copy = NULL;
+  fmi2ValueReference vr = 0;
+  fmi2Byte *buffer, *damaged;
+  fmi2Real x, xStep, h = 0.1;
+  size_t size, strEnd;
+  const char *guid;
+
+  if (argc != 3) {
+    fprintf(stderr, "usage: %s <fmu directory> <model identifier>\n", argv[0]);
+    return 1;
+  }
+  snprintf(path, sizeof(path), "%s/binaries/linux64/%s.so", argv[1], argv[2]);
+  snprintf(resources, sizeof(resources), "file://%s/resources", argv[1]);
+  guid = readGUID(argv[1]);
+  handle = dlopen(path, RTLD_NOW|RTLD_LOCAL);
+  if (!handle || !guid) {
+    fprintf(stderr, "could not load %s\n", path);
+    return 1;
+  }
+
+  LOAD(fmi2Instantiate)
+  LOAD(fmi2SetupExperiment)
+  LOAD(fmi2EnterInitializationMode)
+  LOAD(fmi2ExitInitializationMode)
+  LOAD(fmi2DoStep)
+  LOAD(fmi2GetReal)
+  LOAD(fmi2GetFMUstate)
+  LOAD(fmi2SetFMUstate)
+  LOAD(fmi2FreeFMUstate)
+  LOAD(fmi2SerializedFMUstateSize)
+  LOAD(fmi2SerializeFMUstate)
+  LOAD(fmi2DeSerializeFMUstate)
+  LOAD(fmi2Terminate)
+  LOAD(fmi2FreeInstance)
+
+  c = fmi2Instantiate("test", fmi2CoSimulation, guid, resources, &callbacks, fmi2False, fmi2False);
+  if (!c) return 1;
+  fmi2SetupExperiment(c, fmi2False, 0.0, 0.0, fmi2False, 0.0);
+  fmi2EnterInitializationMode(c);
+  fmi2ExitInitializationMode(c);
+
+  /* reference step */
+  CHECK("fmi2GetFMUstate", fmi2GetFMUstate(c, &state) == fmi2OK);
+  fmi2DoStep(c, 0.0, h, fmi2True);
+  fmi2GetReal(c, &vr, 1, &xStep);
+
+  /* rejected step, repeated from the snapshot */
+  CHECK("fmi2SetFMUstate", fmi2SetFMUstate(c, state) == fmi2OK);
+  fmi2DoStep(c, 0.0, h, fmi2True);
+  fmi2GetReal(c, &vr, 1, &x);
+  CHECK("repeated step", x == xStep);
+
+  /* step from a deserialized copy of the snapshot */
+  fmi2SerializedFMUstateSize(c, state, &size);
+  buffer = (fmi2Byte*) malloc(size);
+  damaged = (fmi2Byte*) malloc(size);
+  CHECK("fmi2SerializeFMUstate", fmi2SerializeFMUstate(c, state, buffer, size) == fmi2OK);
+  CHECK("fmi2DeSerializeFMUstate", fmi2DeSerializeFMUstate(c, buffer, size, &copy) == fmi2OK);
+  fmi2SetFMUstate(c, copy);
+  fmi2FreeFMUstate(c, &copy);
+  fmi2DoStep(c, 0.0, h, fmi2True);
+  fmi2GetReal(c, &vr, 1, &x);
+  CHECK("step from deserialized state", x == xStep);
+
+  /* damaged states */
+  CHECK("too small state rejected", fmi2DeSerializeFMUstate(c, buffer, sizeof(size_t), &copy) == fmi2Error);
+  CHECK("truncated state rejected", fmi2DeSerializeFMUstate(c, buffer, size-1, &copy) == fmi2Error);
+  memcpy(damaged, buffer, size);
+  damaged[0] ^= 1;
+  CHECK("state of other FMU rejected", fmi2DeSerializeFMUstate(c, damaged, size, &copy) == fmi2Error);
+  strEnd = firstStringEnd(buffer, size);
+  CHECK("state contains a string", strEnd > 0 && buffer[strEnd] == '\0');
+  memcpy(damaged, buffer, size);
+  damaged[strEnd] = 'x';
+  CHECK("unterminated string rejected", fmi2DeSerializeFMUstate(c, damaged, size, &copy) == fmi2Error);
+  CHECK("valid state still accepted", fmi2DeSerializeFMUstate(c, buffer, size, &copy) == fmi2OK);
+  fmi2FreeFMUstate(c, &copy);
+
+  fmi2FreeFMUstate(c, &state);
+  free(buffer);
+  free(damaged);
+  fmi2Terminate(c);
+  fmi2FreeInstance(c);
+  dlclose(handle);
+  return 0;
+}
@@ -0,0 +1,177 @@
+/*
+ * Checks the Jacobian functions of an OpenModelica model exchange FMU.
+ *
+ *   fmuJacobianCSC <extracted fmu directory> <model identifier> <number of states>
+ *
+ * The Jacobian [A B; C D] is evaluated with omc_fmi2GetJacobianCSC, with
+ * omc_fmi2GetDirectionalDerivatives for all unit seeds at once and with one
+ * fmi2GetDirectionalDerivative call per column. The results must be equal.
+ * The sparsity pattern and the blocks A, B, C and D are printed in the
+ * format of the linearized model.
+ */
+
+#include <dlfcn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fmi2Functions.h"
+
+typedef fmi2Status omc_fmi2GetDirectionalDerivativesTYPE(fmi2Component c,
+    const fmi2ValueReference vUnknown_ref[], size_t nUnknown,
+    const fmi2ValueReference vKnown_ref[], size_t nKnown,
+    size_t nSeeds, const fmi2Real dvKnown[], fmi2Real dvUnknown[]);
+typedef fmi2Status omc_fmi2GetJacobianSparsityTYPE(fmi2Component c, size_t *nRows, size_t *nCols, size_t *nnz,
+    const unsigned int **colPtr, const unsigned int **rowIdx,
+    const fmi2ValueReference **rowRefs, const fmi2ValueReference **colRefs);
+typedef fmi2Status omc_fmi2GetJacobianCSCTYPE(fmi2Component c, fmi2Real values[], size_t nnz);
+
+static void logger(fmi2ComponentEnvironment env, fmi2String instanceName, fmi2Status status, fmi2String category, fmi2String message, ...)
+{
+}
+
+static char* readGUID(const char *dir)
+{
+  static char guid[256];
+  char path[4096], buffer[65536], *start, *end;
+  size_t n;
+  FILE *file;
+
+  snprintf(path, sizeof(path), "%s/modelDescription.xml", dir);
+  file = fopen(path, "r");
+  if (!file) return NULL;
+  n = fread(buffer, 1, sizeof(buffer)-1, file);
+  fclose(file);
+  buffer[n] = '\0';
+  start = strstr(buffer, "guid=\"");
+  if (!start) return NULL;
+  start += 6;
+  end = strchr(start, '"');
+  if (!end || end-start >= (long) sizeof(guid)) return NULL;
+  memcpy(guid, start, end-start);
+  guid[end-start] = '\0';
+  return guid;
+}
+
+/* Print block rows [r0, r1) x columns [c0, c1) of the column major matrix J with nRows rows */
+static void printBlock(const char *name, const double *J, size_t nRows, size_t r0, size_t r1, size_t c0, size_t c1)
+{
+  size_t i, j;
+  printf("%s = [", name);
+  for (i = r0; i < r1; i++) {
+    for (j = c0; j < c1; j++) {
+      printf("%.16g%s", J[j*nRows + i] + 0.0, j+1 < c1 ? ", " : "");
+    }
+    printf("%s", i+1 < r1 ? "; " : "");
+  }
+  printf("]\n");
+}
+
+#define LOAD(name) name##TYPE *name = (name##TYPE*) dlsym(handle, #name); if (!name) { fprintf(stderr, "missing %s\n", #name); return 1; }
+#define CHECK(msg, cond) printf("%s: %s\n", msg, (cond) ? "ok" : "failed")
+
+int main(int argc, char **argv)
+{
+  char path[4096], resources[4096];
+  void *handle;
+  fmi2CallbackFunctions callbacks = {logger, calloc, free, NULL, NULL};
+  fmi2Component c;
+  fmi2EventInfo eventInfo;
+  const char *guid;
+  size_t nRows, nCols, nnz, nStates, i, j, nz;
+  const unsigned int *colPtr, *rowIdx;
+  const fmi2ValueReference *rowRefs, *colRefs;
+  double *values, *csc, *batched, *single, *seeds;
+  int equalBatched = 1, equalSingle = 1;
+
+  if (argc != 4) {
+    fprintf(stderr, "usage: %s <fmu directory> <model identifier> <number of states>\n", argv[0]);
+    return 1;
+  }
+  nStates = atoi(argv[3]);
+  snprintf(path, sizeof(path), "%s/binaries/linux64/%s.so", argv[1], argv[2]);
+  snprintf(resources, sizeof(resources), "file://%s/resources", argv[1]);
+  guid = readGUID(argv[1]);
+  handle = dlopen(path, RTLD_NOW|RTLD_LOCAL);
+  if (!handle || !guid) {
+    fprintf(stderr, "could not load %s\n", path);
+    return 1;
+  }
+
+  LOAD(fmi2Instantiate)
+  LOAD(fmi2SetupExperiment)
+  LOAD(fmi2EnterInitializationMode)
+  LOAD(fmi2ExitInitializationMode)
+  LOAD(fmi2NewDiscreteStates)
+  LOAD(fmi2EnterContinuousTimeMode)
+  LOAD(fmi2GetDirectionalDerivative)
+  LOAD(omc_fmi2GetDirectionalDerivatives)
+  LOAD(omc_fmi2GetJacobianSparsity)
+  LOAD(omc_fmi2GetJacobianCSC)
+  LOAD(fmi2Terminate)
+  LOAD(fmi2FreeInstance)
+
+  c = fmi2Instantiate("test", fmi2ModelExchange, guid, resources, &callbacks, fmi2False, fmi2False);
+  if (!c) return 1;
+  fmi2SetupExperiment(c, fmi2False, 0.0, 0.0, fmi2False, 0.0);
+  fmi2EnterInitializationMode(c);
+  fmi2ExitInitializationMode(c);
+  do {
+    fmi2NewDiscreteStates(c, &eventInfo);
+  } while (eventInfo.newDiscreteStatesNeeded);
+  fmi2EnterContinuousTimeMode(c);
+
+  CHECK("omc_fmi2GetJacobianSparsity", omc_fmi2GetJacobianSparsity(c, &nRows, &nCols, &nnz, &colPtr, &rowIdx, &rowRefs, &colRefs) == fmi2OK);
+  printf("rows: %lu, columns: %lu, non-zeros: %lu\n", (unsigned long) nRows, (unsigned long) nCols, (unsigned long) nnz);
+  for (j = 0; j < nCols; j++) {
+    printf("column %lu:", (unsigned long) j+1);
+    /* print the rows of each column in ascending order */
+    for (i = 0; i < nRows; i++) {
+      for (nz = colPtr[j]; nz < colPtr[j+1]; nz++) {
+        if (rowIdx[nz] == i) printf(" %lu", (unsigned long) i+1);
+      }
+    }
+    printf("\n");
+  }
+
+  values = (double*) malloc(nnz*sizeof(double));
+  csc = (double*) calloc(nRows*nCols, sizeof(double));
+  batched = (double*) calloc(nRows*nCols, sizeof(double));
+  single = (double*) calloc(nRows*nCols, sizeof(double));
+  seeds = (double*) calloc(nCols*nCols, sizeof(double));
+
+  CHECK("omc_fmi2GetJacobianCSC", omc_fmi2GetJacobianCSC(c, values, nnz) == fmi2OK);
+  for (j = 0; j < nCols; j++) {
+    for (nz = colPtr[j]; nz < colPtr[j+1]; nz++) {
+      csc[j*nRows + rowIdx[nz]] = values[nz];
+    }
+    seeds[j*nCols + j] = 1.0;
+  }
+
+  CHECK("omc_fmi2GetDirectionalDerivatives", omc_fmi2GetDirectionalDerivatives(c, rowRefs, nRows, colRefs, nCols, nCols, seeds, batched) == fmi2OK);
+  for (j = 0; j < nCols; j++) {
+    if (fmi2GetDirectionalDerivative(c, rowRefs, nRows, colRefs, nCols, seeds + j*nCols, single + j*nRows) != fmi2OK)
+      equalSingle = 0;
+  }
+  for (i = 0; i < nRows*nCols; i++) {
+    equalBatched = equalBatched && batched[i] == csc[i];
+    equalSingle = equalSingle && single[i] == csc[i];
+  }
+  CHECK("batched directional derivatives equal CSC values", equalBatched);
+  CHECK("fmi2GetDirectionalDerivative equals CSC values", equalSingle);
+
+  printBlock("A", csc, nRows, 0, nStates, 0, nStates);
+  printBlock("B", csc, nRows, 0, nStates, nStates, nCols);
+  printBlock("C", csc, nRows, nStates, nRows, 0, nStates);
+  printBlock("D", csc, nRows, nStates, nRows, nStates, nCols);
+
+  free(values);
+  free(csc);
+  free(batched);
+  free(single);
+  free(seeds);
+  fmi2Terminate(c);
+  fmi2FreeInstance(c);
+  dlclose(handle);
+  return 0;
+}